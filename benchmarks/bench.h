@@ -0,0 +1,53 @@
+#ifndef __BENCH__H__
+#define __BENCH__H__
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+namespace bench
+{
+	/**
+	 * @brief Best of repeats runs of fn, in milliseconds. The best run is the one least disturbed by the rest
+	 * of the machine.
+	 */
+	template <typename F>
+	double measure(uint32_t repeats, F&& fn)
+	{
+		double best = 1e30;
+		for (uint32_t i = 0; i < repeats; i++)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			fn();
+			const auto stop = std::chrono::steady_clock::now();
+			const double ms = std::chrono::duration<double, std::milli>(stop - start).count();
+			best = ms < best ? ms : best;
+		}
+		return best;
+	}
+
+	/**
+	 * @brief Print a result line: name, time and the rate of items per second.
+	 */
+	inline void report(const char* name, double ms, uint64_t items)
+	{
+		std::printf("%-48s %10.3f ms %12.2f M/s\n", name, ms, ms > 0.0 ? items / (ms * 1000.0) : 0.0);
+	}
+
+	/**
+	 * @brief Keep the compiler from dropping the computation of value.
+	 */
+	template <typename T>
+	inline void keep(const T& value)
+	{
+#if defined(__GNUC__)
+		asm volatile("" : : "g"(&value) : "memory");
+#else
+		static volatile const void* sink;
+		sink = &value;
+#endif
+	}
+
+} // namespace bench
+
+#endif //!__BENCH__H__
@@ -0,0 +1,153 @@
+// BVH build and refit time, and frustum / box / ray query throughput, over 10K, 100K and 1M random boxes at the
+// same density. The frustum queries are compared with testing every box
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <core/jobs.h>
+#include <core/math/frustum.h>
+#include <core/scene/bvh.h>
+
+#include "bench.h"
+
+namespace
+{
+	constexpr uint32_t Repeats = 3;
+	constexpr uint32_t FrustumQueries = 64;
+	constexpr uint32_t BoxQueries = 20000;
+	constexpr uint32_t Rays = 100000;
+
+	struct Scene
+	{
+		std::vector<rv::AABB> boxes;
+		// Half the side of the cube the boxes are spread over, grows with the count to keep the density
+		float extent;
+	};
+
+	Scene makeScene(uint32_t count)
+	{
+		Scene scene;
+		scene.extent = 500.0f * std::cbrt(count / 1e6f);
+		std::mt19937 rng(42);
+		std::uniform_real_distribution<float> position(-scene.extent, scene.extent);
+		std::uniform_real_distribution<float> size(0.1f, 2.0f);
+		scene.boxes.resize(count);
+		for (rv::AABB& box : scene.boxes)
+		{
+			const glm::vec3 center(position(rng), position(rng), position(rng));
+			const glm::vec3 halfSize(size(rng));
+			box = rv::AABB{center - halfSize, center + halfSize};
+		}
+		return scene;
+	}
+
+	std::vector<rv::Frustum> makeFrusta(const Scene& scene)
+	{
+		const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, scene.extent);
+		std::vector<rv::Frustum> frusta;
+		for (uint32_t i = 0; i < FrustumQueries; i++)
+		{
+			const glm::vec3 target(std::sin(i * 0.1f), 0.2f, std::cos(i * 0.1f));
+			frusta.push_back(rv::Frustum::FromMatrix(
+				projection * glm::lookAt(glm::vec3(0.0f), target, glm::vec3(0.0f, 1.0f, 0.0f))));
+		}
+		return frusta;
+	}
+
+	void benchCount(uint32_t count, gefx::JobSystem& jobs)
+	{
+		char name[64];
+		const Scene scene = makeScene(count);
+		std::printf("\n%u primitives\n", count);
+
+		gefx::Bvh bvh;
+		double ms = bench::measure(Repeats, [&]() { bvh.Build(scene.boxes); });
+		bench::report("build, one thread", ms, count);
+		ms = bench::measure(Repeats, [&]() { bvh.Build(scene.boxes, &jobs); });
+		bench::report("build, job system", ms, count);
+		ms = bench::measure(Repeats, [&]() { bvh.Refit(scene.boxes, &jobs); });
+		bench::report("refit, job system", ms, count);
+
+		const std::vector<rv::Frustum> frusta = makeFrusta(scene);
+		std::vector<uint32_t> visible;
+		ms = bench::measure(Repeats, [&]() {
+			for (const rv::Frustum& frustum : frusta)
+			{
+				visible.clear();
+				bvh.QueryFrustum(frustum, visible);
+			}
+			bench::keep(visible);
+		});
+		// Rated in primitives culled, comparable with testing them all
+		std::snprintf(name, sizeof(name), "frustum queries (%zu visible)", visible.size());
+		bench::report(name, ms, uint64_t(count) * FrustumQueries);
+
+		ms = bench::measure(Repeats, [&]() {
+			for (const rv::Frustum& frustum : frusta)
+			{
+				visible.clear();
+				for (uint32_t i = 0; i < count; i++)
+				{
+					const rv::AABB& box = scene.boxes[i];
+					if (frustum.TestBounds((box.min + box.max) * 0.5f, (box.max - box.min) * 0.5f))
+					{
+						visible.push_back(i);
+					}
+				}
+			}
+			bench::keep(visible);
+		});
+		bench::report("frustum, every box tested", ms, uint64_t(count) * FrustumQueries);
+
+		std::mt19937 rng(7);
+		std::uniform_real_distribution<float> position(-scene.extent, scene.extent);
+		std::vector<rv::AABB> regions(BoxQueries);
+		for (rv::AABB& region : regions)
+		{
+			const glm::vec3 center(position(rng), position(rng), position(rng));
+			region = rv::AABB{center - 5.0f, center + 5.0f};
+		}
+		std::vector<uint32_t> overlapping;
+		ms = bench::measure(Repeats, [&]() {
+			for (const rv::AABB& region : regions)
+			{
+				overlapping.clear();
+				bvh.QueryAABB(region, overlapping);
+			}
+			bench::keep(overlapping);
+		});
+		bench::report("box queries", ms, BoxQueries);
+
+		std::vector<glm::vec3> origins(Rays), directions(Rays);
+		for (uint32_t i = 0; i < Rays; i++)
+		{
+			origins[i] = glm::vec3(position(rng), position(rng), position(rng));
+			directions[i] = glm::normalize(glm::vec3(position(rng), position(rng), position(rng)));
+		}
+		uint32_t hits = 0;
+		ms = bench::measure(Repeats, [&]() {
+			hits = 0;
+			gefx::RayHit hit;
+			for (uint32_t i = 0; i < Rays; i++)
+			{
+				hits += bvh.Raycast(origins[i], directions[i], 1e30f, hit) ? 1 : 0;
+			}
+			bench::keep(hits);
+		});
+		std::snprintf(name, sizeof(name), "rays (%.0f%% hit)", 100.0 * hits / Rays);
+		bench::report(name, ms, Rays);
+	}
+} // namespace
+
+int main()
+{
+	gefx::JobSystem jobs;
+	for (const uint32_t count : {10000u, 100000u, 1000000u})
+	{
+		benchCount(count, jobs);
+	}
+	return 0;
+}
@@ -0,0 +1,205 @@
+// Queue throughput with one and several producers/consumers, and the round trip latency of handing an item to
+// another thread and getting the answer back, against a mutex and condition variable queue
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <core/concurrency/blockingqueue.h>
+#include <core/concurrency/mpmcqueue.h>
+#include <core/concurrency/spscqueue.h>
+
+#include "bench.h"
+
+namespace
+{
+	constexpr uint32_t Items = 1u << 20;
+	constexpr uint32_t RoundTrips = 100000;
+	constexpr uint32_t Repeats = 5;
+	constexpr size_t Capacity = 1024;
+
+	// What the blocking queues replaced: a deque behind a mutex, with a condition variable for each direction
+	class LockedQueue
+	{
+	  public:
+		explicit LockedQueue(size_t capacity) : _capacity(capacity){};
+
+		bool Push(uint32_t value)
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_notFull.wait(lock, [&]() { return _closed || _items.size() < _capacity; });
+			if (_closed) return false;
+			_items.push_back(value);
+			lock.unlock();
+			_notEmpty.notify_one();
+			return true;
+		};
+
+		bool Pop(uint32_t& outValue)
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_notEmpty.wait(lock, [&]() { return _closed || !_items.empty(); });
+			if (_items.empty()) return false;
+			outValue = _items.front();
+			_items.pop_front();
+			lock.unlock();
+			_notFull.notify_one();
+			return true;
+		};
+
+		void Close()
+		{
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_closed = true;
+			}
+			_notEmpty.notify_all();
+			_notFull.notify_all();
+		};
+
+	  private:
+		std::mutex _mutex;
+		std::condition_variable _notEmpty;
+		std::condition_variable _notFull;
+		std::deque<uint32_t> _items;
+		size_t _capacity;
+		bool _closed = false;
+	};
+
+	template <typename Queue>
+	void benchThroughput(const char* name, uint32_t producers, uint32_t consumers)
+	{
+		const double ms = bench::measure(Repeats, [&]() {
+			Queue queue(Capacity);
+			std::atomic<uint64_t> total{0};
+			std::vector<std::thread> threads;
+			for (uint32_t c = 0; c < consumers; c++)
+			{
+				threads.emplace_back([&]() {
+					uint64_t sum = 0;
+					uint32_t value;
+					while (queue.Pop(value))
+					{
+						sum += value;
+					}
+					total.fetch_add(sum, std::memory_order_relaxed);
+				});
+			}
+			std::vector<std::thread> pushers;
+			for (uint32_t p = 0; p < producers; p++)
+			{
+				pushers.emplace_back([&]() {
+					for (uint32_t i = 0; i < Items / producers; i++)
+					{
+						queue.Push(i);
+					}
+				});
+			}
+			for (std::thread& pusher : pushers)
+			{
+				pusher.join();
+			}
+			queue.Close();
+			for (std::thread& thread : threads)
+			{
+				thread.join();
+			}
+			bench::keep(total);
+		});
+		bench::report(name, ms, Items);
+	}
+
+	// Lock-free queues without the blocking adaptor, spinning instead of sleeping
+	template <typename Queue>
+	void benchSpinThroughput(const char* name, uint32_t producers, uint32_t consumers)
+	{
+		const double ms = bench::measure(Repeats, [&]() {
+			Queue queue(Capacity);
+			std::atomic<uint32_t> popped{0};
+			std::vector<std::thread> threads;
+			for (uint32_t c = 0; c < consumers; c++)
+			{
+				threads.emplace_back([&]() {
+					uint32_t value;
+					while (popped.load(std::memory_order_relaxed) < Items)
+					{
+						if (queue.TryPop(value))
+						{
+							popped.fetch_add(1, std::memory_order_relaxed);
+						}
+						else
+						{
+							std::this_thread::yield();
+						}
+					}
+				});
+			}
+			for (uint32_t p = 0; p < producers; p++)
+			{
+				threads.emplace_back([&]() {
+					for (uint32_t i = 0; i < Items / producers; i++)
+					{
+						while (!queue.TryPush(i))
+						{
+							std::this_thread::yield();
+						}
+					}
+				});
+			}
+			for (std::thread& thread : threads)
+			{
+				thread.join();
+			}
+		});
+		bench::report(name, ms, Items);
+	}
+
+	template <typename Queue>
+	void benchRoundTrip(const char* name)
+	{
+		const double ms = bench::measure(Repeats, [&]() {
+			Queue requests(Capacity);
+			Queue replies(Capacity);
+			std::thread echo([&]() {
+				uint32_t value;
+				while (requests.Pop(value))
+				{
+					replies.Push(value + 1);
+				}
+			});
+			uint32_t value = 0;
+			for (uint32_t i = 0; i < RoundTrips; i++)
+			{
+				requests.Push(value);
+				replies.Pop(value);
+			}
+			requests.Close();
+			echo.join();
+			bench::keep(value);
+		});
+		std::printf("%-48s %10.3f ms %12.0f ns per round trip\n", name, ms, ms * 1e6 / RoundTrips);
+	}
+} // namespace
+
+int main()
+{
+	using SPSC = rv::BlockingQueue<rv::SPSCQueue<uint32_t>>;
+	using MPMC = rv::BlockingQueue<rv::MPMCQueue<uint32_t>>;
+
+	std::printf("%u items, queues of %zu\n", Items, Capacity);
+	benchThroughput<SPSC>("BlockingQueue<SPSCQueue> 1:1", 1, 1);
+	benchThroughput<MPMC>("BlockingQueue<MPMCQueue> 1:1", 1, 1);
+	benchThroughput<LockedQueue>("mutex + condition_variable 1:1", 1, 1);
+	benchThroughput<MPMC>("BlockingQueue<MPMCQueue> 4:4", 4, 4);
+	benchThroughput<LockedQueue>("mutex + condition_variable 4:4", 4, 4);
+	benchSpinThroughput<rv::SPSCQueue<uint32_t>>("SPSCQueue spinning 1:1", 1, 1);
+	benchSpinThroughput<rv::MPMCQueue<uint32_t>>("MPMCQueue spinning 4:4", 4, 4);
+
+	benchRoundTrip<SPSC>("BlockingQueue<SPSCQueue> round trip");
+	benchRoundTrip<LockedQueue>("mutex + condition_variable round trip");
+	return 0;
+}
@@ -0,0 +1,132 @@
+// Lookup-heavy container workloads: resolving a frame's worth of resource names, and the small per-draw
+// lists that usually stay under a handful of elements
+
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <core/containers/flathashmap.h>
+#include <core/containers/smallvector.h>
+#include <core/stringid.h>
+
+#include "bench.h"
+
+namespace
+{
+	constexpr uint32_t ResourceCount = 4096;
+	constexpr uint32_t LookupsPerFrame = 1u << 20;
+	constexpr uint32_t Repeats = 10;
+
+	// Resources named like the engine names them, looked up in a random order each frame
+	struct Workload
+	{
+		std::vector<std::string> names;
+		std::vector<rv::StringId> ids;
+		std::vector<uint32_t> order;
+	};
+
+	Workload makeWorkload()
+	{
+		Workload workload;
+		std::mt19937 rng(7);
+		for (uint32_t i = 0; i < ResourceCount; i++)
+		{
+			workload.names.push_back("textures/props/crate_" + std::to_string(i) + "_albedo.png");
+			workload.ids.push_back(rv::StringId(rv::crc32_view(workload.names.back())));
+		}
+		workload.order.resize(LookupsPerFrame);
+		for (uint32_t& index : workload.order)
+		{
+			index = rng() % ResourceCount;
+		}
+		return workload;
+	}
+
+	template <typename Map, typename Keys>
+	void benchLookups(const char* name, const Map& map, const Keys& keys, const Workload& workload)
+	{
+		const double ms = bench::measure(Repeats, [&]() {
+			uint64_t sum = 0;
+			for (const uint32_t index : workload.order)
+			{
+				sum += map.find(keys[index])->second;
+			}
+			bench::keep(sum);
+		});
+		bench::report(name, ms, LookupsPerFrame);
+	}
+
+	template <typename Map, typename Keys>
+	void benchMisses(const char* name, const Map& map, const Keys& keys)
+	{
+		const double ms = bench::measure(Repeats, [&]() {
+			uint64_t found = 0;
+			for (uint32_t i = 0; i < LookupsPerFrame; i++)
+			{
+				found += map.find(keys[i % keys.size()]) != map.end() ? 1 : 0;
+			}
+			bench::keep(found);
+		});
+		bench::report(name, ms, LookupsPerFrame);
+	}
+
+	template <typename Vector>
+	void benchSmallLists(const char* name)
+	{
+		constexpr uint32_t Lists = 1u << 18;
+		const double ms = bench::measure(Repeats, [&]() {
+			uint64_t sum = 0;
+			for (uint32_t i = 0; i < Lists; i++)
+			{
+				Vector list;
+				for (uint32_t j = 0; j < 1 + (i & 3); j++)
+				{
+					list.push_back(i + j);
+				}
+				for (const uint32_t value : list)
+				{
+					sum += value;
+				}
+			}
+			bench::keep(sum);
+		});
+		bench::report(name, ms, Lists);
+	}
+} // namespace
+
+int main()
+{
+	const Workload workload = makeWorkload();
+
+	rv::FlatHashMap<rv::StringId, uint32_t> flatIds;
+	std::unordered_map<rv::StringId, uint32_t> stdIds;
+	rv::FlatHashMap<std::string, uint32_t> flatNames;
+	std::unordered_map<std::string, uint32_t> stdNames;
+	for (uint32_t i = 0; i < ResourceCount; i++)
+	{
+		flatIds[workload.ids[i]] = i;
+		stdIds[workload.ids[i]] = i;
+		flatNames[workload.names[i]] = i;
+		stdNames[workload.names[i]] = i;
+	}
+
+	std::printf("%u resources, %u lookups per frame\n", ResourceCount, LookupsPerFrame);
+	benchLookups("FlatHashMap<StringId> hit", flatIds, workload.ids, workload);
+	benchLookups("std::unordered_map<StringId> hit", stdIds, workload.ids, workload);
+	benchLookups("FlatHashMap<std::string> hit", flatNames, workload.names, workload);
+	benchLookups("std::unordered_map<std::string> hit", stdNames, workload.names, workload);
+
+	std::vector<rv::StringId> missing;
+	for (uint32_t i = 0; i < ResourceCount; i++)
+	{
+		missing.push_back(rv::StringId(rv::crc32_view("missing/" + std::to_string(i))));
+	}
+	benchMisses("FlatHashMap<StringId> miss", flatIds, missing);
+	benchMisses("std::unordered_map<StringId> miss", stdIds, missing);
+
+	benchSmallLists<rv::SmallVector<uint32_t, 4>>("SmallVector<4> build and walk");
+	benchSmallLists<std::vector<uint32_t>>("std::vector build and walk");
+	return 0;
+}
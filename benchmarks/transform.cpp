@@ -0,0 +1,100 @@
+// A 100x100 grid of objects per frame: model matrices, model-view-projection and world bounds through the batch
+// kernels, against building each one with glm. Built for the default SSE path and with AVX2 and FMA
+
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <core/math/transform.h>
+
+#include "bench.h"
+
+namespace
+{
+	constexpr size_t GridSide = 100;
+	constexpr size_t Objects = GridSide * GridSide;
+	constexpr uint32_t Frames = 100;
+	constexpr uint32_t Repeats = 5;
+
+	glm::vec3 gridPosition(size_t index) { return glm::vec3(float(index % GridSide), float(index / GridSide), 0.0f); }
+	float gridAngle(size_t index) { return 0.3f * float(index); }
+} // namespace
+
+int main()
+{
+	const glm::mat4 viewProjection =
+		glm::perspective(1.0f, 1.3f, 0.1f, 500.0f) *
+		glm::lookAt(glm::vec3(50.0f, 50.0f, 120.0f), glm::vec3(50.0f, 50.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	const rv::AABB box{{-0.5f, -0.5f, -0.5f}, {0.5f, 0.5f, 0.5f}};
+
+	rv::TransformSoA transforms;
+	transforms.Resize(Objects);
+	for (size_t i = 0; i < Objects; i++)
+	{
+		transforms.Set(i, gridPosition(i), glm::angleAxis(gridAngle(i), glm::vec3(0.0f, 0.0f, 1.0f)), glm::vec3(0.5f));
+	}
+	std::vector<glm::mat4> models(Objects);
+	std::vector<glm::mat4> mvps(Objects);
+	rv::BoundsSoA bounds;
+	bounds.Resize(Objects);
+
+	std::printf("%zux%zu grid, %u frames\n", GridSide, GridSide, Frames);
+
+	double ms = bench::measure(Repeats, [&]() {
+		for (uint32_t frame = 0; frame < Frames; frame++)
+		{
+			rv::composeTRS(transforms, 0, Objects, models.data());
+			rv::multiplyMatrices(viewProjection, models.data(), Objects, mvps.data());
+		}
+		bench::keep(mvps);
+	});
+	bench::report("composeTRS + multiplyMatrices", ms, uint64_t(Objects) * Frames);
+
+	ms = bench::measure(Repeats, [&]() {
+		for (uint32_t frame = 0; frame < Frames; frame++)
+		{
+			for (size_t i = 0; i < Objects; i++)
+			{
+				glm::mat4 model = glm::translate(glm::mat4(1.0f), gridPosition(i));
+				model = glm::rotate(model, gridAngle(i), glm::vec3(0.0f, 0.0f, 1.0f));
+				model = glm::scale(model, glm::vec3(0.5f));
+				models[i] = model;
+				mvps[i] = viewProjection * model;
+			}
+		}
+		bench::keep(mvps);
+	});
+	bench::report("glm translate/rotate/scale + multiply", ms, uint64_t(Objects) * Frames);
+
+	ms = bench::measure(Repeats, [&]() {
+		for (uint32_t frame = 0; frame < Frames; frame++)
+		{
+			rv::computeWorldBounds(transforms, box, 0, Objects, bounds);
+		}
+		bench::keep(bounds);
+	});
+	bench::report("computeWorldBounds", ms, uint64_t(Objects) * Frames);
+
+	std::vector<rv::AABB> corners(Objects);
+	ms = bench::measure(Repeats, [&]() {
+		for (uint32_t frame = 0; frame < Frames; frame++)
+		{
+			for (size_t i = 0; i < Objects; i++)
+			{
+				glm::vec3 min(1e30f), max(-1e30f);
+				for (int corner = 0; corner < 8; corner++)
+				{
+					const glm::vec4 point((corner & 1) ? box.max.x : box.min.x, (corner & 2) ? box.max.y : box.min.y,
+										  (corner & 4) ? box.max.z : box.min.z, 1.0f);
+					const glm::vec3 moved = glm::vec3(models[i] * point);
+					min = glm::min(min, moved);
+					max = glm::max(max, moved);
+				}
+				corners[i] = rv::AABB{min, max};
+			}
+		}
+		bench::keep(corners);
+	});
+	bench::report("glm 8 corner bounds", ms, uint64_t(Objects) * Frames);
+	return 0;
+}
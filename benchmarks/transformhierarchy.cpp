@@ -0,0 +1,96 @@
+// Transform hierarchy Update cost against the number of changed nodes, for 10K, 100K and 1M node trees, on one
+// thread and on the job system. A full recompute (every root changed) is the baseline for each size
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include <core/jobs.h>
+#include <core/scene/transformhierarchy.h>
+
+#include "bench.h"
+
+namespace
+{
+	constexpr uint32_t Repeats = 5;
+	constexpr uint32_t Fanout = 4;
+
+	// Breadth first tree with Fanout children per node, 16 roots
+	std::vector<gefx::TransformNode> makeTree(gefx::TransformHierarchy& hierarchy, uint32_t count)
+	{
+		std::vector<gefx::TransformNode> nodes;
+		nodes.reserve(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const gefx::TransformNode parent = i < 16 ? gefx::TransformNode{} : nodes[(i - 16) / Fanout];
+			nodes.push_back(hierarchy.Create(parent, glm::vec3(float(i % 7), 1.0f, 0.5f)));
+		}
+		hierarchy.Update();
+		return nodes;
+	}
+
+	void benchCount(uint32_t count, gefx::JobSystem& jobs)
+	{
+		std::printf("\n%u nodes\n", count);
+		gefx::TransformHierarchy hierarchy;
+		const std::vector<gefx::TransformNode> nodes = makeTree(hierarchy, count);
+
+		// Changed nodes are spread over the whole tree, so their subtrees come along too
+		std::mt19937 rng(7);
+		std::vector<gefx::TransformNode> changed;
+		char name[96];
+		for (const double fraction : {0.0001, 0.001, 0.01, 0.1, 1.0})
+		{
+			const uint32_t changedCount = std::max<uint32_t>(1, static_cast<uint32_t>(count * fraction));
+			changed.clear();
+			for (uint32_t i = 0; i < changedCount; i++)
+			{
+				changed.push_back(nodes[changedCount == count ? i : rng() % count]);
+			}
+
+			float angle = 0.0f;
+			auto run = [&](gefx::JobSystem* pool) {
+				return bench::measure(Repeats, [&]() {
+					angle += 0.01f;
+					const glm::quat rotation(glm::vec3(0.0f, angle, 0.0f));
+					for (const gefx::TransformNode node : changed)
+					{
+						hierarchy.SetRotation(node, rotation);
+					}
+					hierarchy.Update(pool);
+					bench::keep(hierarchy.GetWorldMatrices()[0]);
+				});
+			};
+
+			double ms = run(nullptr);
+			const uint32_t updated = hierarchy.GetStats().updatedNodes;
+			std::snprintf(name, sizeof(name), "%u changed (%u updated), one thread", changedCount, updated);
+			bench::report(name, ms, updated);
+			ms = run(&jobs);
+			std::snprintf(name, sizeof(name), "%u changed (%u updated), job system", changedCount, updated);
+			bench::report(name, ms, updated);
+		}
+
+		// Every root changed recomputes the whole tree
+		double ms = bench::measure(Repeats, [&]() {
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				hierarchy.SetPosition(nodes[i], glm::vec3(float(i), 0.0f, 0.0f));
+			}
+			hierarchy.Update(&jobs);
+		});
+		bench::report("full recompute, job system", ms, count);
+	}
+} // namespace
+
+int main()
+{
+	gefx::JobSystem jobs;
+	std::printf("%u workers\n", jobs.GetWorkerCount());
+	for (const uint32_t count : {10000u, 100000u, 1000000u})
+	{
+		benchCount(count, jobs);
+	}
+	return 0;
+}
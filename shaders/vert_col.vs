@@ -2,11 +2,13 @@
 
 layout(location = 0) in vec3 vertex;
 
-layout(location = 0) uniform mat4 viewProj;
-layout(location = 1) uniform mat4 model;
-layout(location = 2) uniform float time;
+// mvp is viewProj * model, premultiplied on the CPU in batch
+layout(PUSH_CONSTANT) uniform DrawConstants {
+    mat4 mvp;
+    float time;
+    float perlin;
+};
 
 void main(){
-    mat4 mvp = viewProj * model;
     gl_Position = mvp * vec4(vertex, 1.0f);
 }
\ No newline at end of file
@@ -11,9 +11,11 @@
 // - Mesh Descriptor API
 
 // StdLib Includes
+#include <algorithm>
 #include <vector>
 #include <string>
 #include <fstream>
+#include <memory>
 
 // Third Party Includes
 #define STB_IMAGE_IMPLEMENTATION
@@ -26,6 +28,10 @@
 
 // Application Specific Includes
 #include <app/app.h>
+#include <app/components.h>
+#include <core/math/frustum.h>
+#include <core/math/transform.h>
+#include <core/pack.h>
 #include <rendering/utils.h>
 
 // Using directives
@@ -33,44 +39,73 @@ using std::string;
 template <typename T>
 using vector = std::vector<T>;
 
+// Mirrors the DrawConstants push constant block of shaders/vert_col.*
+struct GridDrawConstants
+{
+	glm::mat4 mvp;
+	float time;
+	float perlin;
+};
+
 void GrefixsEndine::Setup()
 {
-	// Setup Graphics APIs
+	// Shader Compilation, first so Shutdown always has it to finalize
+	ShaderUtils::Init();
+
+	// Setup Graphics APIs. On failure Setup stops where it is, Run then skips straight to Shutdown
 	glfwSetErrorCallback(OnGlfwErrorCallback);
 	if (!glfwInit())
 	{
+		shouldQuit = true;
 		return;
 	}
 
+	// Vulkan draws to a surface of the window instead of a GL context. GpuResources creates every GL object
+	// with direct state access, which needs a 4.5 core context at least, drivers hand out the newest version
+	// compatible with it
+	const bool vulkan = _backend == gefx::DeviceBackend::Vulkan;
+	if (vulkan)
+	{
+		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+	}
+	else
+	{
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	}
+
 	_window = glfwCreateWindow(1920, 1080, GetName(), nullptr, nullptr);
 	if (!_window)
 	{
-		glfwTerminate();
+		shouldQuit = true;
 		return;
 	}
 
-	glfwMakeContextCurrent(_window);
-	glfwSwapInterval(1);
-	gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
+	if (!vulkan)
+	{
+		glfwMakeContextCurrent(_window);
+		glfwSwapInterval(1);
+		if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+		{
+			GEFX_LOG_ERROR("Failed to load the OpenGL functions");
+			shouldQuit = true;
+			return;
+		}
+	}
 
 	glfwSetInputMode(_window, GLFW_STICKY_KEYS, GLFW_TRUE);
 
 	// Operating System Window Settings
 	glfwSetWindowSizeLimits(_window, 640, 480, GLFW_DONT_CARE, GLFW_DONT_CARE);
-	glfwSetWindowSizeCallback(_window, OnGlfwWindowResizeCallback);
 	glfwMaximizeWindow(_window);
 
-	// Initial viewport parameters
-	glClearColor(0.0f, 0.0f, 0.4f, 1.0f);
-
-	glGenVertexArrays(1, &_exampleVAO);
-
-	glBindVertexArray(_exampleVAO);
-
-	GLuint vertexBufId;
-	glGenBuffers(1, &vertexBufId);
-
-	glBindBuffer(GL_ARRAY_BUFFER, vertexBufId);
+	if (!CreateDevice())
+	{
+		GEFX_LOG_ERROR("Graphics device initialization failed");
+		shouldQuit = true;
+		return;
+	}
 
 	float triangle[] = {
 		-0.5f, -0.5f, 0.0f, // v0
@@ -81,26 +116,100 @@ void GrefixsEndine::Setup()
 		+0.5f, +0.5f, 0.0f, // v5
 	};
 
-	glBufferData(GL_ARRAY_BUFFER, sizeof(triangle), triangle, GL_STATIC_DRAW);
+	// Uploaded in the background, the grid shows up once it is in
+	_exampleVBO = _device->CreateBuffer(gefx::BufferDesc{sizeof(triangle), gefx::BufferUsage::Vertex});
+	if (!_device->UploadBuffer(_exampleVBO, 0, triangle, sizeof(triangle), _exampleUpload))
+	{
+		GEFX_LOG_ERROR("Example vertex upload failed");
+	}
 
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, false, sizeof(float) * 3, 0);
+	// Packed data at the root, built with grefixsPack grefixs.gpak ../../shaders. Loose files in the shader
+	// directory win over it (longer prefix), so edits show up without packing again
+	if (std::shared_ptr<gefx::PackArchive> pack = gefx::PackArchive::Open("grefixs.gpak"))
+	{
+		GEFX_LOG_INFO("Mounted grefixs.gpak, {} files", pack->GetFileCount());
+		_vfs.Mount("", std::make_unique<gefx::PackMount>(std::move(pack), &_jobs));
+	}
+	_vfs.Mount("shaders", std::make_unique<gefx::DirectoryMount>("../../shaders"));
 
-	glBindVertexArray(0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	gefx::FileView vertData, fragData;
+	vector<unsigned int> vertSpirv, fragSpirv;
+	if (ShaderUtils::TryLoadShaderFile(_vfs, "shaders/vert_col.vs", vertData) &&
+		ShaderUtils::TryLoadShaderFile(_vfs, "shaders/vert_col.fs", fragData))
+	{
+		// _exampleShader = CompileShaderProgramTxt(vertData.AsString(), fragData.AsString());
+		ShaderUtils::GLSLtoSPV(vk::ShaderStageFlagBits::eVertex, vertData.AsString(), vertSpirv, _backend);
+		ShaderUtils::GLSLtoSPV(vk::ShaderStageFlagBits::eFragment, fragData.AsString(), fragSpirv, _backend);
+
+		gefx::PipelineDesc pipeline;
+		pipeline.vertexSpirv = vertSpirv;
+		pipeline.fragmentSpirv = fragSpirv;
+		pipeline.attributes[0] = gefx::VertexAttribute{0, gefx::Format::RGB32Float, 0};
+		pipeline.attributeCount = 1;
+		pipeline.vertexStride = sizeof(float) * 3;
+		pipeline.pushConstantBytes = sizeof(GridDrawConstants);
+		pipeline.colorFormat = _device->GetBackBufferFormat();
+		_examplePipeline = _device->CreatePipeline(pipeline);
+	}
 
-	// Shader Compilation
-	ShaderUtils::Init();
+	CreateGrid();
+	if (!RegisterSystems())
+	{
+		shouldQuit = true;
+		return;
+	}
 
-	string vertData, fragData;
-	vector<unsigned int> vertSpirv, fragSpirv;
-	if (ShaderUtils::TryLoadShaderFile("../../shaders/vert_col.vs", vertData) &&
-		ShaderUtils::TryLoadShaderFile("../../shaders/vert_col.fs", fragData))
+	_snapshots.resize(GetSnapshotCount());
+	// The render thread takes the context over, a context is current on one thread at a time
+	if (renderThread && !vulkan)
 	{
-		// _exampleShader = CompileShaderProgramTxt(vertData, fragData);
-		ShaderUtils::GLSLtoSPV(vk::ShaderStageFlagBits::eVertex, vertData.c_str(), vertSpirv);
-		ShaderUtils::GLSLtoSPV(vk::ShaderStageFlagBits::eFragment, fragData.c_str(), fragSpirv);
-		_exampleShader = ShaderUtils::CompileShaderProgramSpirV(vertSpirv, fragSpirv);
+		glfwMakeContextCurrent(nullptr);
+	}
+}
+
+bool GrefixsEndine::CreateDevice()
+{
+	if (_backend != gefx::DeviceBackend::Vulkan)
+	{
+		_device = &_glDevice;
+		return _glDevice.Initialize();
+	}
+
+	_device = &_vulkanDevice;
+	gefx::VulkanDeviceConfig config;
+	config.jobs = &_jobs;
+#ifndef NDEBUG
+	config.validation = true;
+#endif
+	uint32_t extensionCount = 0;
+	const char** extensions = glfwGetRequiredInstanceExtensions(&extensionCount);
+	config.instanceExtensions.assign(extensions, extensions + extensionCount);
+	config.createSurface = [this](VkInstance instance, PFN_vkGetInstanceProcAddr) {
+		VkSurfaceKHR surface = VK_NULL_HANDLE;
+		glfwCreateWindowSurface(instance, _window, nullptr, &surface);
+		return surface;
+	};
+	glfwGetFramebufferSize(_window, &_framebufferWidth, &_framebufferHeight);
+	config.backBufferWidth = static_cast<uint32_t>(_framebufferWidth);
+	config.backBufferHeight = static_cast<uint32_t>(_framebufferHeight);
+	// Next to the log, the next run precompiles what this one created
+	config.pipelineCachePath = "grefixs.pipelines";
+	return _vulkanDevice.Initialize(config);
+}
+
+void GrefixsEndine::CreateGrid()
+{
+	constexpr int gridMin = -50;
+	constexpr int gridMax = 50;
+	_gridRoot = _hierarchy.Create();
+	for (int x = gridMin; x < gridMax; x++)
+	{
+		for (int y = gridMin; y < gridMax; y++)
+		{
+			const gefx::TransformNode node = _hierarchy.Create(_gridRoot, glm::vec3(x, y, 0.0f),
+															   glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(0.5f));
+			_world.Create(GridCell{glm::vec2(x, y)}, GridNoise{}, GridNode{node});
+		}
 	}
 }
 
@@ -112,8 +221,27 @@ void GrefixsEndine::Shutdown()
 {
 	ShaderUtils::Finalize();
 
+	// GL objects must go before the context does, Vulkan ones before the window's surface. The render thread
+	// is gone by now and gave the context back. No device when Setup failed before creating one
+	if (_device)
+	{
+		if (renderThread && _backend != gefx::DeviceBackend::Vulkan)
+		{
+			glfwMakeContextCurrent(_window);
+		}
+		_renderGraph.Shutdown(*_device);
+		if (_backend == gefx::DeviceBackend::Vulkan)
+		{
+			_vulkanDevice.Shutdown();
+		}
+		else
+		{
+			_glDevice.Shutdown();
+		}
+	}
+
 	// Graphics API shutdown
-	glfwDestroyWindow(_window);
+	if (_window) glfwDestroyWindow(_window);
 	glfwTerminate();
 }
 
@@ -124,48 +252,192 @@ void GrefixsEndine::Update(double deltaTime)
 	// Poll first so ImGUI has the events.
 	// This performs some callbacks as well
 	glfwPollEvents();
-
-	// GL Rendering
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-	DrawAppScreen(deltaTime);
-
-	glfwSwapBuffers(_window);
+	glfwGetFramebufferSize(_window, &_framebufferWidth, &_framebufferHeight);
+
+	_time += (float)deltaTime;
+	RenderSnapshot& snapshot = _snapshots[GetUpdateSnapshot()];
+	snapshot.framebufferWidth = _framebufferWidth;
+	snapshot.framebufferHeight = _framebufferHeight;
+	snapshot.time = _time;
+	_scheduler.Run(_jobs, deltaTime);
 }
 
-void GrefixsEndine::DrawAppScreen(double deltaTime)
+void GrefixsEndine::Render(uint32_t snapshotIndex)
 {
-	static float accTime = 0.0f;
-	accTime += (float)deltaTime;
+	const RenderSnapshot& snapshot = _snapshots[snapshotIndex];
+	if (_backend == gefx::DeviceBackend::Vulkan)
+	{
+		_vulkanDevice.Resize(static_cast<uint32_t>(snapshot.framebufferWidth),
+							 static_cast<uint32_t>(snapshot.framebufferHeight));
+	}
+	_exampleReady = _exampleReady || _device->IsUploadComplete(_exampleUpload);
 
-	const siv::PerlinNoise::seed_type seed = 123456u;
+	// The grid pass clears the back buffer and splits its draws over several command lists, which the graph
+	// records in parallel
+	_renderGraph.Reset();
+	if (snapshot.framebufferWidth > 0 && snapshot.framebufferHeight > 0)
+	{
+		// Null handle, straight to the back buffer
+		gefx::TextureDesc backBuffer;
+		backBuffer.width = static_cast<uint32_t>(snapshot.framebufferWidth);
+		backBuffer.height = static_cast<uint32_t>(snapshot.framebufferHeight);
+		backBuffer.format = _device->GetBackBufferFormat();
+		backBuffer.usage = gefx::TextureUsage::RenderTarget;
+		const gefx::RenderGraphTexture back =
+			_renderGraph.ImportTexture("BackBuffer", gefx::TextureHandle(), backBuffer, gefx::TextureState::Undefined,
+									   gefx::TextureState::Present);
+
+		_renderGraph.AddPass(
+			"Grid",
+			[&](gefx::RenderGraphBuilder& builder) {
+				builder.WriteColor(back, true, glm::vec4(0.0f, 0.0f, 0.4f, 1.0f));
+				builder.SetCommandLists(GridCommandLists);
+			},
+			[this, &snapshot](const gefx::RenderPassContext& pass, gefx::CommandList& commands, uint32_t list) {
+				const uint32_t drawCount = static_cast<uint32_t>(snapshot.drawMatrices.size());
+				const uint32_t drawsPerList = (drawCount + pass.listCount - 1) / pass.listCount;
+				const uint32_t first = std::min(list * drawsPerList, drawCount);
+				const uint32_t last = std::min(first + drawsPerList, drawCount);
+				if (!_examplePipeline || !_exampleReady || first >= last) return;
+
+				// Nothing carries over from the previous list, bind again
+				commands.BindPipeline(_examplePipeline);
+				commands.BindVertexBuffer(_exampleVBO);
+				for (uint32_t i = first; i < last; i++)
+				{
+					commands.PushConstants(
+						GridDrawConstants{snapshot.drawMatrices[i], snapshot.time, snapshot.drawNoise[i]});
+					commands.Draw(6);
+				}
+			});
+	}
 
-	const siv::PerlinNoise perlin{seed};
+	std::string error;
+	if (!_renderGraph.Compile(error))
+	{
+		GEFX_LOG_ERROR("Render graph: {}", error);
+		_renderGraph.Reset();
+		_renderGraph.Compile(error);
+	}
+	_renderGraph.Execute(*_device, &_jobs);
+
+	// Vulkan presents in EndFrame
+	if (_backend != gefx::DeviceBackend::Vulkan)
+	{
+		glfwSwapBuffers(_window);
+	}
 
-	glm::mat4 view = glm::lookAt(glm::vec3{0.0f, 0.0f, 5.0f}, glm::vec3{}, glm::vec3{0.0f, 1.0f, 0.0f});
-	glm::mat4 proj = glm::perspective(60.0f, 4 / 3.0f, 0.01f, 1000.0f);
-	glm::mat4 viewProj = proj * view;
+	_device->EndFrame();
+}
 
-	for (int x = -50; x < 50; x++)
+void GrefixsEndine::RenderThreadStart()
+{
+	if (_backend != gefx::DeviceBackend::Vulkan)
 	{
-		for (int y = -50; y < 50; y++)
-		{
-			const float perlinVal = (float)perlin.octave2D(x + cos(accTime), y + sin(accTime), 2);
+		glfwMakeContextCurrent(_window);
+	}
+	// The main thread runs jobs with index 0 in the meantime, recording needs per-thread data of its own
+	if (!_jobs.AttachThread())
+	{
+		GEFX_LOG_ERROR("No job system thread slot left for the render thread");
+	}
+}
 
-			glUseProgram(_exampleShader);
-			glUniform1f(2, accTime);
-			glUniform1f(3, perlinVal);
+void GrefixsEndine::RenderThreadStop()
+{
+	if (gefx::JobSystem::GetThreadIndex() != 0) _jobs.DetachThread();
+	if (_backend != gefx::DeviceBackend::Vulkan)
+	{
+		glfwMakeContextCurrent(nullptr);
+	}
+}
 
-			glm::mat4 model = glm::mat4(1.0f);
-			model = glm::translate(model, {x, y, 0.0f});
-			model = glm::rotate(model, perlinVal, glm::vec3{0.0f, 0.0f, 1.0f});
-			model = glm::scale(model, glm::vec3(0.5));
+bool GrefixsEndine::RegisterSystems()
+{
+	const siv::PerlinNoise::seed_type seed = 123456u;
 
-			glUniformMatrix4fv(0, 1, false, &viewProj[0][0]);
-			glUniformMatrix4fv(1, 1, false, &model[0][0]);
+	const siv::PerlinNoise perlin{seed};
 
-			glBindVertexArray(_exampleVAO);
-			glDrawArrays(GL_TRIANGLES, 0, 6);
-		}
+	// Noise system, only the rotation around Z changes per frame. Hierarchy setters are safe in parallel
+	gefx::Query& noiseQuery = _world.GetQuery<const GridCell, GridNoise, const GridNode>();
+	_scheduler.AddSystem(
+		"GridNoise", gefx::SystemAccess{}.Include(noiseQuery).WriteResource<gefx::TransformHierarchy>(),
+		[this, &noiseQuery, perlin](const gefx::SystemContext& context) {
+			const glm::vec2 noiseOffset{cos(_time), sin(_time)};
+			noiseQuery.ParallelEach<const GridCell, GridNoise, const GridNode>(
+				context.jobs, [&](const GridCell& cell, GridNoise& noise, const GridNode& gridNode) {
+					noise.value =
+						(float)perlin.octave2D(cell.coord.x + noiseOffset.x, cell.coord.y + noiseOffset.y, 2);
+					_hierarchy.SetRotation(gridNode.node,
+										   glm::quat(cosf(noise.value * 0.5f), 0.0f, 0.0f, sinf(noise.value * 0.5f)));
+				});
+		});
+
+	// Transform system, only the subtrees changed since last frame are recomputed
+	_scheduler.AddSystem("TransformHierarchy", gefx::SystemAccess{}.WriteResource<gefx::TransformHierarchy>(),
+						 [this](const gefx::SystemContext& context) { _hierarchy.Update(&context.jobs); });
+
+	// Culling system, gathers the grid's world matrices and keeps the cells touching the view frustum
+	gefx::Query& cullQuery = _world.GetQuery<const GridNoise, const GridNode>();
+	_scheduler.AddSystem(
+		"GridCulling",
+		gefx::SystemAccess{}
+			.Include(cullQuery)
+			.ReadResource<gefx::TransformHierarchy>()
+			.WriteResource<gefx::FrustumCuller>(),
+		[this, &cullQuery](const gefx::SystemContext& context) {
+			glm::mat4 view = glm::lookAt(glm::vec3{0.0f, 0.0f, 5.0f}, glm::vec3{}, glm::vec3{0.0f, 1.0f, 0.0f});
+			glm::mat4 proj = glm::perspective(60.0f, 4 / 3.0f, 0.01f, 1000.0f);
+			_viewProj = proj * view;
+
+			_instanceMatrices.clear();
+			_instanceNoise.clear();
+			cullQuery.ForEachChunk([&](const gefx::ChunkView& chunk) {
+				const uint32_t count = chunk.Count();
+				const GridNoise* noise = chunk.Column<const GridNoise>();
+				const GridNode* nodes = chunk.Column<const GridNode>();
+				for (uint32_t i = 0; i < count; i++)
+				{
+					_instanceMatrices.push_back(_hierarchy.GetWorld(nodes[i].node));
+					_instanceNoise.push_back(noise[i].value);
+				}
+			});
+
+			// Cells are unit quads centered on their origin
+			const size_t instanceCount = _instanceMatrices.size();
+			_instanceSpheres.Resize(instanceCount);
+			rv::computeWorldSpheres(_instanceMatrices.data(), 0, instanceCount, glm::vec3(0.0f), 0.70710678f,
+									_instanceSpheres);
+			_culler.Cull(context.jobs, rv::Frustum::FromMatrix(_viewProj), _instanceSpheres);
+
+			const gefx::CullingStats& stats = _culler.GetStats();
+			GEFX_LOG_TRACE("Grid culling: {} drawn, {} culled in {:.3f}ms", stats.visible, stats.culled,
+						   stats.milliseconds);
+		});
+
+	// Snapshot system, one batched matrix multiply for the visible cells into the snapshot the frame renders
+	// from. The render thread may be drawing the previous frame's snapshot meanwhile
+	_scheduler.AddSystem(
+		"GridSnapshot", gefx::SystemAccess{}.ReadResource<gefx::FrustumCuller>().WriteResource<RenderSnapshot>(),
+		[this](const gefx::SystemContext&) {
+			RenderSnapshot& snapshot = _snapshots[GetUpdateSnapshot()];
+			const rv::Span<const uint32_t> visible = _culler.GetVisible();
+			snapshot.drawMatrices.resize(visible.size());
+			snapshot.drawNoise.resize(visible.size());
+			for (size_t i = 0; i < visible.size(); i++)
+			{
+				snapshot.drawMatrices[i] = _instanceMatrices[visible[i]];
+				snapshot.drawNoise[i] = _instanceNoise[visible[i]];
+			}
+			rv::multiplyMatrices(_viewProj, snapshot.drawMatrices.data(), snapshot.drawMatrices.size(),
+								 snapshot.drawMatrices.data());
+		});
+
+	std::string error;
+	if (!_scheduler.Build(error))
+	{
+		GEFX_LOG_ERROR("System graph: {}", error);
+		return false;
 	}
+	return true;
 }
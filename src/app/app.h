@@ -1,18 +1,41 @@
 #ifndef __APP__H__
 #define __APP__H__
 
+// Vulkan first so GLFW declares its surface functions
+#include <vulkan/vulkan_core.h>
+
 #define GLFW_INCLUDE_NONE
 #include <GLFW/glfw3.h>
 #include <glad/glad.h>
 
 #include <glm/glm.hpp>
 
+#include <core/ecs/scheduler.h>
+#include <core/ecs/world.h>
 #include <core/iapp.h>
+#include <core/jobs.h>
+#include <core/log.h>
+#include <core/scene/transformhierarchy.h>
+#include <core/vfs.h>
+#include <rendering/culling.h>
+#include <rendering/device/commandlist.h>
+#include <rendering/device/gldevice.h>
+#include <rendering/device/vkdevice.h>
+#include <rendering/rendergraph.h>
 
 class GrefixsEndine : public gefx::IApp
 {
   public:
-	GrefixsEndine() : gefx::IApp("Grefixs"){};
+	/**
+	 * @brief withRenderThread renders on a thread of its own, up to framesAhead frames behind the simulation.
+	 */
+	explicit GrefixsEndine(gefx::DeviceBackend backend = gefx::DeviceBackend::OpenGL, bool withRenderThread = false,
+						   uint32_t maxFramesAhead = 1)
+		: gefx::IApp("Grefixs"), _backend(backend)
+	{
+		renderThread = withRenderThread;
+		framesAhead = maxFramesAhead;
+	};
 	~GrefixsEndine() override = default;
 	GrefixsEndine(GrefixsEndine&&) = delete;
 	GrefixsEndine(const GrefixsEndine&) = delete;
@@ -24,23 +47,64 @@ class GrefixsEndine : public gefx::IApp
 	void Shutdown() override;
 	void Sleep() override;
 	void Update(double deltaTime) override;
+	void Render(uint32_t snapshotIndex) override;
+	void RenderThreadStart() override;
+	void RenderThreadStop() override;
 
   private:
 	static void OnGlfwErrorCallback(int error, const char* description)
 	{
-		fprintf(stderr, "Glfw Error %d: %s\n", error, description);
+		GEFX_LOG_ERROR("Glfw Error {}: {}", error, description);
 	}
 
-	static void OnGlfwWindowResizeCallback(GLFWwindow* window, int width, int height)
+	// What rendering a frame needs of its simulation, one per frame in flight
+	struct RenderSnapshot
 	{
-		glViewport(0, 0, width, height);
-	}
+		int framebufferWidth{0};
+		int framebufferHeight{0};
+		float time{0.0f};
+		// Model view projection and noise of the visible cells
+		std::vector<glm::mat4> drawMatrices;
+		std::vector<float> drawNoise;
+	};
 
-	void DrawAppScreen(double deltaTime);
+	bool CreateDevice();
+	void CreateGrid();
+	bool RegisterSystems();
 	GLFWwindow* _window{nullptr};
+	gefx::VirtualFileSystem _vfs;
+	gefx::DeviceBackend _backend;
+	gefx::GLDevice _glDevice;
+	gefx::VulkanDevice _vulkanDevice;
+	// The one of the two the app renders with
+	gefx::IDevice* _device{nullptr};
+	int _framebufferWidth{0};
+	int _framebufferHeight{0};
+
+	gefx::BufferHandle _exampleVBO;
+	gefx::UploadTicket _exampleUpload;
+	bool _exampleReady{false};
+	gefx::PipelineHandle _examplePipeline;
+
+	gefx::JobSystem _jobs;
+	gefx::World _world;
+	gefx::SystemScheduler _scheduler;
+	gefx::TransformHierarchy _hierarchy;
+	gefx::TransformNode _gridRoot;
+	float _time{0.0f};
+
+	// Written by the culling system, consumed by the snapshot system
+	gefx::FrustumCuller _culler;
+	glm::mat4 _viewProj{1.0f};
+	std::vector<glm::mat4> _instanceMatrices;
+	std::vector<float> _instanceNoise;
+	rv::SphereSoA _instanceSpheres;
+	std::vector<RenderSnapshot> _snapshots;
 
-	GLuint _exampleVAO;
-	GLuint _exampleShader;
+	// Built from a snapshot every frame on the thread rendering, with the grid's pass split over several
+	// command lists recorded in parallel
+	static constexpr uint32_t GridCommandLists = 4;
+	gefx::RenderGraph _renderGraph;
 };
 
 #endif //!__APP__H__
\ No newline at end of file
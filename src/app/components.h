@@ -0,0 +1,26 @@
+#ifndef __APP_COMPONENTS__H__
+#define __APP_COMPONENTS__H__
+
+#include <glm/glm.hpp>
+
+#include <core/scene/transformhierarchy.h>
+
+// Components of the example noise grid
+
+struct GridCell
+{
+	glm::vec2 coord;
+};
+
+struct GridNoise
+{
+	float value{0.0f};
+};
+
+// Cell transforms live in the app's TransformHierarchy, under the grid root node
+struct GridNode
+{
+	gefx::TransformNode node;
+};
+
+#endif //!__APP_COMPONENTS__H__
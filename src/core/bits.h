@@ -0,0 +1,95 @@
+#ifndef __BITS__H__
+#define __BITS__H__
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace rv
+{
+	// Destructive interference size, used to pad data written by different threads
+	static constexpr size_t CacheLineSize = 64;
+
+	/**
+	 * @brief Index of the lowest set bit. Undefined for zero.
+	 */
+	inline uint32_t countTrailingZeros(uint32_t value)
+	{
+#if defined(_MSC_VER)
+		unsigned long idx;
+		_BitScanForward(&idx, value);
+		return static_cast<uint32_t>(idx);
+#else
+		return static_cast<uint32_t>(__builtin_ctz(value));
+#endif
+	}
+
+	/**
+	 * @brief Index of the lowest set bit. Undefined for zero.
+	 */
+	inline uint32_t countTrailingZeros(uint64_t value)
+	{
+#if defined(_MSC_VER)
+		unsigned long idx;
+		_BitScanForward64(&idx, value);
+		return static_cast<uint32_t>(idx);
+#else
+		return static_cast<uint32_t>(__builtin_ctzll(value));
+#endif
+	}
+
+	/**
+	 * @brief Number of zero bits above the highest set bit. Undefined for zero.
+	 */
+	inline uint32_t countLeadingZeros(uint64_t value)
+	{
+#if defined(_MSC_VER)
+		unsigned long idx;
+		_BitScanReverse64(&idx, value);
+		return 63 - static_cast<uint32_t>(idx);
+#else
+		return static_cast<uint32_t>(__builtin_clzll(value));
+#endif
+	}
+
+	inline uint32_t popCount(uint64_t value)
+	{
+#if defined(_MSC_VER)
+		return static_cast<uint32_t>(__popcnt64(value));
+#else
+		return static_cast<uint32_t>(__builtin_popcountll(value));
+#endif
+	}
+
+	/**
+	 * @brief Smallest power of two greater or equal to value (1 for zero).
+	 */
+	constexpr uint64_t nextPowerOfTwo(uint64_t value)
+	{
+		if (value <= 1) return 1;
+		value--;
+		value |= value >> 1;
+		value |= value >> 2;
+		value |= value >> 4;
+		value |= value >> 8;
+		value |= value >> 16;
+		value |= value >> 32;
+		return value + 1;
+	}
+
+	constexpr bool isPowerOfTwo(uint64_t value) { return value && !(value & (value - 1)); }
+
+	/**
+	 * @brief Round value up to a multiple of alignment, which must be a power of two.
+	 */
+	constexpr uint64_t alignUp(uint64_t value, uint64_t alignment) { return (value + alignment - 1) & ~(alignment - 1); }
+
+	static_assert(nextPowerOfTwo(17) == 32, "nextPowerOfTwo unit test failed!");
+	static_assert(alignUp(65, 64) == 128, "alignUp unit test failed!");
+
+} // namespace rv
+
+#endif //!__BITS__H__
@@ -0,0 +1,117 @@
+#ifndef __BLOCKINGQUEUE__H__
+#define __BLOCKINGQUEUE__H__
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+#include <core/concurrency/futex.h>
+
+namespace rv
+{
+	/**
+	 * @brief Blocking wait/notify adaptor over a bounded lock-free queue (SPSCQueue or MPMCQueue). The fast paths
+	 * stay lock-free, threads only sleep on a futex when the queue is empty (Pop) or full (Push), and wake
+	 * syscalls are skipped while nobody sleeps. Close() releases every blocked thread for shutdown.
+	 */
+	template <typename Queue>
+	class BlockingQueue
+	{
+	  public:
+		explicit BlockingQueue(size_t capacity) : _queue(capacity){};
+
+		BlockingQueue(BlockingQueue&&) = delete;
+		BlockingQueue(const BlockingQueue&) = delete;
+		BlockingQueue& operator=(BlockingQueue&&) = delete;
+		BlockingQueue& operator=(const BlockingQueue&) = delete;
+
+		template <typename U>
+		bool TryPush(U&& value)
+		{
+			if (!_queue.TryPush(std::forward<U>(value))) return false;
+			_notEmpty.NotifyOne();
+			return true;
+		};
+
+		template <typename T>
+		bool TryPop(T& outValue)
+		{
+			if (!_queue.TryPop(outValue)) return false;
+			_notFull.NotifyOne();
+			return true;
+		};
+
+		/**
+		 * @brief Push, sleeping while the queue is full. Returns true whenever value was enqueued, even if Close
+		 * raced it (Pop still drains it), and false if the queue was closed before it could be.
+		 * The underlying queues only move from value on success, so retrying with it is safe.
+		 */
+		template <typename U>
+		bool Push(U&& value)
+		{
+			while (!_closed.load(std::memory_order_acquire))
+			{
+				if (TryPush(std::forward<U>(value))) return true;
+
+				const uint32_t ticket = _notFull.PrepareWait();
+				if (TryPush(std::forward<U>(value)))
+				{
+					_notFull.CancelWait();
+					return true;
+				}
+				if (_closed.load(std::memory_order_acquire))
+				{
+					_notFull.CancelWait();
+					return false;
+				}
+				_notFull.Wait(ticket);
+			}
+			return false;
+		};
+
+		/**
+		 * @brief Pop, sleeping while the queue is empty. Returns false once the queue is closed and drained.
+		 */
+		template <typename T>
+		bool Pop(T& outValue)
+		{
+			while (true)
+			{
+				if (TryPop(outValue)) return true;
+
+				const uint32_t ticket = _notEmpty.PrepareWait();
+				if (TryPop(outValue))
+				{
+					_notEmpty.CancelWait();
+					return true;
+				}
+				if (_closed.load(std::memory_order_acquire))
+				{
+					_notEmpty.CancelWait();
+					return TryPop(outValue);
+				}
+				_notEmpty.Wait(ticket);
+			}
+		};
+
+		void Close()
+		{
+			_closed.store(true, std::memory_order_release);
+			_notEmpty.NotifyAll();
+			_notFull.NotifyAll();
+		};
+
+		bool IsClosed() const { return _closed.load(std::memory_order_acquire); };
+		size_t SizeApprox() const { return _queue.SizeApprox(); };
+		size_t Capacity() const { return _queue.Capacity(); };
+
+	  private:
+		Queue _queue;
+		EventCount _notEmpty;
+		EventCount _notFull;
+		std::atomic<bool> _closed{false};
+	};
+
+} // namespace rv
+
+#endif //!__BLOCKINGQUEUE__H__
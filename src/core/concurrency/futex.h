@@ -0,0 +1,118 @@
+#ifndef __FUTEX__H__
+#define __FUTEX__H__
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#pragma comment(lib, "Synchronization.lib")
+#elif defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace rv
+{
+	static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex words must be plain 32-bit integers");
+
+	/**
+	 * @brief Sleep while word still holds expected. May return spuriously, callers re-check their condition.
+	 */
+	inline void futexWait(std::atomic<uint32_t>& word, uint32_t expected)
+	{
+#if defined(_WIN32)
+		WaitOnAddress(&word, &expected, sizeof(expected), INFINITE);
+#elif defined(__linux__)
+		syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+		while (word.load(std::memory_order_acquire) == expected)
+		{
+			std::this_thread::yield();
+		}
+#endif
+	}
+
+	inline void futexWakeOne(std::atomic<uint32_t>& word)
+	{
+#if defined(_WIN32)
+		WakeByAddressSingle(&word);
+#elif defined(__linux__)
+		syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#else
+		(void)word;
+#endif
+	}
+
+	inline void futexWakeAll(std::atomic<uint32_t>& word)
+	{
+#if defined(_WIN32)
+		WakeByAddressAll(&word);
+#elif defined(__linux__)
+		syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_PRIVATE, INT32_MAX, nullptr, nullptr, 0);
+#else
+		(void)word;
+#endif
+	}
+
+	/**
+	 * @brief Futex backed event count. Lets a thread block on an arbitrary lock-free condition without lost
+	 * wakeups: take a ticket with PrepareWait, re-check the condition, then Wait (or CancelWait). Notifiers
+	 * only issue the wake syscall when someone is actually waiting.
+	 */
+	class EventCount
+	{
+	  public:
+		EventCount() = default;
+		EventCount(EventCount&&) = delete;
+		EventCount(const EventCount&) = delete;
+		EventCount& operator=(EventCount&&) = delete;
+		EventCount& operator=(const EventCount&) = delete;
+
+		uint32_t PrepareWait()
+		{
+			_waiters.fetch_add(1, std::memory_order_seq_cst);
+			return _epoch.load(std::memory_order_seq_cst);
+		};
+
+		void CancelWait() { _waiters.fetch_sub(1, std::memory_order_seq_cst); };
+
+		void Wait(uint32_t ticket)
+		{
+			while (_epoch.load(std::memory_order_acquire) == ticket)
+			{
+				futexWait(_epoch, ticket);
+			}
+			_waiters.fetch_sub(1, std::memory_order_seq_cst);
+		};
+
+		// The fence pairs with the seq_cst increment in PrepareWait: either the waiter's re-check sees the state
+		// published before this call, or this call sees the waiter and bumps the epoch it sleeps on
+		void NotifyOne()
+		{
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (_waiters.load(std::memory_order_relaxed) == 0) return;
+			_epoch.fetch_add(1, std::memory_order_seq_cst);
+			futexWakeOne(_epoch);
+		};
+
+		void NotifyAll()
+		{
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (_waiters.load(std::memory_order_relaxed) == 0) return;
+			_epoch.fetch_add(1, std::memory_order_seq_cst);
+			futexWakeAll(_epoch);
+		};
+
+	  private:
+		std::atomic<uint32_t> _epoch{0};
+		std::atomic<uint32_t> _waiters{0};
+	};
+
+} // namespace rv
+
+#endif //!__FUTEX__H__
@@ -0,0 +1,142 @@
+#ifndef __MPMCQUEUE__H__
+#define __MPMCQUEUE__H__
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+#include <core/bits.h>
+
+namespace rv
+{
+	/**
+	 * @brief Bounded multi producer / multi consumer queue (Dmitry Vyukov's design). Every cell carries a sequence
+	 * number telling whether it is ready to be written or read for the current lap, so producers and consumers
+	 * only contend on their own position counter with a single CAS.
+	 */
+	template <typename T>
+	class MPMCQueue
+	{
+	  public:
+		explicit MPMCQueue(size_t capacity)
+			: _mask(static_cast<size_t>(nextPowerOfTwo(capacity < 2 ? 2 : capacity)) - 1),
+			  _cells(static_cast<Cell*>(::operator new(sizeof(Cell) * (_mask + 1), std::align_val_t(alignof(Cell)))))
+		{
+			for (size_t i = 0; i <= _mask; i++)
+			{
+				new (&_cells[i].sequence) std::atomic<size_t>(i);
+			}
+		}
+
+		~MPMCQueue()
+		{
+			const size_t tail = _enqueuePos.value.load(std::memory_order_acquire);
+			for (size_t pos = _dequeuePos.value.load(std::memory_order_acquire); pos != tail; pos++)
+			{
+				_cells[pos & _mask].Value().~T();
+			}
+			::operator delete(_cells, std::align_val_t(alignof(Cell)));
+		}
+
+		MPMCQueue(MPMCQueue&&) = delete;
+		MPMCQueue(const MPMCQueue&) = delete;
+		MPMCQueue& operator=(MPMCQueue&&) = delete;
+		MPMCQueue& operator=(const MPMCQueue&) = delete;
+
+		size_t Capacity() const { return _mask + 1; };
+
+		/**
+		 * @brief value is only moved from when the push succeeds.
+		 */
+		template <typename U>
+		bool TryPush(U&& value)
+		{
+			size_t pos = _enqueuePos.value.load(std::memory_order_relaxed);
+			Cell* cell;
+			while (true)
+			{
+				cell = &_cells[pos & _mask];
+				const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+				const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+				if (diff == 0)
+				{
+					if (_enqueuePos.value.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+				}
+				else if (diff < 0)
+				{
+					// Cell still holds last lap's value, the queue is full
+					return false;
+				}
+				else
+				{
+					pos = _enqueuePos.value.load(std::memory_order_relaxed);
+				}
+			}
+
+			new (cell->storage) T(std::forward<U>(value));
+			cell->sequence.store(pos + 1, std::memory_order_release);
+			return true;
+		};
+
+		bool TryPop(T& outValue)
+		{
+			size_t pos = _dequeuePos.value.load(std::memory_order_relaxed);
+			Cell* cell;
+			while (true)
+			{
+				cell = &_cells[pos & _mask];
+				const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+				const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+				if (diff == 0)
+				{
+					if (_dequeuePos.value.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+				}
+				else if (diff < 0)
+				{
+					// Cell not written yet for this lap, the queue is empty
+					return false;
+				}
+				else
+				{
+					pos = _dequeuePos.value.load(std::memory_order_relaxed);
+				}
+			}
+
+			T& value = cell->Value();
+			outValue = std::move(value);
+			value.~T();
+			cell->sequence.store(pos + _mask + 1, std::memory_order_release);
+			return true;
+		};
+
+		size_t SizeApprox() const
+		{
+			const size_t tail = _enqueuePos.value.load(std::memory_order_acquire);
+			const size_t head = _dequeuePos.value.load(std::memory_order_acquire);
+			return tail > head ? tail - head : 0;
+		};
+
+	  private:
+		struct Cell
+		{
+			std::atomic<size_t> sequence;
+			alignas(T) unsigned char storage[sizeof(T)];
+
+			T& Value() { return *std::launder(reinterpret_cast<T*>(storage)); };
+		};
+
+		struct alignas(CacheLineSize) PaddedPos
+		{
+			std::atomic<size_t> value{0};
+		};
+
+		PaddedPos _enqueuePos;
+		PaddedPos _dequeuePos;
+		alignas(CacheLineSize) const size_t _mask;
+		Cell* const _cells;
+	};
+
+} // namespace rv
+
+#endif //!__MPMCQUEUE__H__
@@ -0,0 +1,112 @@
+#ifndef __SPSCQUEUE__H__
+#define __SPSCQUEUE__H__
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+#include <core/bits.h>
+
+namespace rv
+{
+	/**
+	 * @brief Bounded single producer / single consumer ring buffer. Each side owns its index on a separate cache
+	 * line and keeps a cached copy of the other side's index, so the shared lines are only read when the
+	 * cached view says the ring is full (producer) or empty (consumer).
+	 */
+	template <typename T>
+	class SPSCQueue
+	{
+	  public:
+		explicit SPSCQueue(size_t capacity)
+			: _mask(static_cast<size_t>(nextPowerOfTwo(capacity < 2 ? 2 : capacity)) - 1),
+			  _slots(static_cast<T*>(::operator new(sizeof(T) * (_mask + 1), std::align_val_t(alignof(T)))))
+		{
+		}
+
+		~SPSCQueue()
+		{
+			const size_t tail = _producer.tail.load(std::memory_order_acquire);
+			for (size_t head = _consumer.head.load(std::memory_order_acquire); head != tail; head++)
+			{
+				_slots[head & _mask].~T();
+			}
+			::operator delete(_slots, std::align_val_t(alignof(T)));
+		}
+
+		SPSCQueue(SPSCQueue&&) = delete;
+		SPSCQueue(const SPSCQueue&) = delete;
+		SPSCQueue& operator=(SPSCQueue&&) = delete;
+		SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+		size_t Capacity() const { return _mask + 1; };
+
+		/**
+		 * @brief Producer side. value is only moved from when the push succeeds.
+		 */
+		template <typename U>
+		bool TryPush(U&& value)
+		{
+			const size_t tail = _producer.tail.load(std::memory_order_relaxed);
+			if (tail - _producer.cachedHead > _mask)
+			{
+				_producer.cachedHead = _consumer.head.load(std::memory_order_acquire);
+				if (tail - _producer.cachedHead > _mask) return false;
+			}
+
+			new (&_slots[tail & _mask]) T(std::forward<U>(value));
+			_producer.tail.store(tail + 1, std::memory_order_release);
+			return true;
+		};
+
+		/**
+		 * @brief Consumer side.
+		 */
+		bool TryPop(T& outValue)
+		{
+			const size_t head = _consumer.head.load(std::memory_order_relaxed);
+			if (head == _consumer.cachedTail)
+			{
+				_consumer.cachedTail = _producer.tail.load(std::memory_order_acquire);
+				if (head == _consumer.cachedTail) return false;
+			}
+
+			T& slot = _slots[head & _mask];
+			outValue = std::move(slot);
+			slot.~T();
+			_consumer.head.store(head + 1, std::memory_order_release);
+			return true;
+		};
+
+		/**
+		 * @brief Approximate number of queued elements, exact only when called from an idle side.
+		 */
+		size_t SizeApprox() const
+		{
+			return _producer.tail.load(std::memory_order_acquire) - _consumer.head.load(std::memory_order_acquire);
+		};
+
+	  private:
+		struct alignas(CacheLineSize) ProducerSide
+		{
+			std::atomic<size_t> tail{0};
+			size_t cachedHead{0};
+		};
+
+		struct alignas(CacheLineSize) ConsumerSide
+		{
+			std::atomic<size_t> head{0};
+			size_t cachedTail{0};
+		};
+
+		ProducerSide _producer;
+		ConsumerSide _consumer;
+		const size_t _mask;
+		T* const _slots;
+	};
+
+} // namespace rv
+
+#endif //!__SPSCQUEUE__H__
@@ -0,0 +1,173 @@
+#ifndef __FIXEDVECTOR__H__
+#define __FIXEDVECTOR__H__
+
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace rv
+{
+	/**
+	 * @brief Vector with a hard capacity of N elements stored inline, never touches the heap.
+	 * Overflowing the capacity is a programming error and asserts.
+	 */
+	template <typename T, size_t N>
+	class FixedVector
+	{
+	  public:
+		using value_type = T;
+		using iterator = T*;
+		using const_iterator = const T*;
+
+		FixedVector() = default;
+
+		FixedVector(std::initializer_list<T> init)
+		{
+			for (const T& value : init)
+			{
+				push_back(value);
+			}
+		};
+
+		FixedVector(const FixedVector& other)
+		{
+			for (const T& value : other)
+			{
+				push_back(value);
+			}
+		};
+
+		FixedVector(FixedVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+		{
+			for (T& value : other)
+			{
+				push_back(std::move(value));
+			}
+			other.clear();
+		};
+
+		FixedVector& operator=(const FixedVector& other)
+		{
+			if (this != &other)
+			{
+				clear();
+				for (const T& value : other)
+				{
+					push_back(value);
+				}
+			}
+			return *this;
+		};
+
+		FixedVector& operator=(FixedVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+		{
+			if (this != &other)
+			{
+				clear();
+				for (T& value : other)
+				{
+					push_back(std::move(value));
+				}
+				other.clear();
+			}
+			return *this;
+		};
+
+		~FixedVector() { clear(); };
+
+		T* data() { return reinterpret_cast<T*>(_storage); };
+		const T* data() const { return reinterpret_cast<const T*>(_storage); };
+		size_t size() const { return _size; };
+		static constexpr size_t capacity() { return N; };
+		bool empty() const { return _size == 0; };
+		bool full() const { return _size == N; };
+
+		iterator begin() { return data(); };
+		iterator end() { return data() + _size; };
+		const_iterator begin() const { return data(); };
+		const_iterator end() const { return data() + _size; };
+
+		T& operator[](size_t idx)
+		{
+			assert(idx < _size);
+			return data()[idx];
+		};
+
+		const T& operator[](size_t idx) const
+		{
+			assert(idx < _size);
+			return data()[idx];
+		};
+
+		T& front() { return (*this)[0]; };
+		T& back() { return (*this)[_size - 1]; };
+		const T& front() const { return (*this)[0]; };
+		const T& back() const { return (*this)[_size - 1]; };
+
+		template <typename... Args>
+		T& emplace_back(Args&&... args)
+		{
+			assert(_size < N && "FixedVector capacity exceeded");
+			return *new (data() + _size++) T(std::forward<Args>(args)...);
+		};
+
+		void push_back(const T& value) { emplace_back(value); };
+		void push_back(T&& value) { emplace_back(std::move(value)); };
+
+		void pop_back()
+		{
+			assert(_size > 0);
+			data()[--_size].~T();
+		};
+
+		void resize(size_t size)
+		{
+			assert(size <= N && "FixedVector capacity exceeded");
+			while (_size < size)
+			{
+				new (data() + _size++) T();
+			}
+			while (_size > size)
+			{
+				pop_back();
+			}
+		};
+
+		void clear()
+		{
+			while (_size > 0)
+			{
+				pop_back();
+			}
+		};
+
+		iterator erase(const_iterator pos)
+		{
+			T* it = const_cast<T*>(pos);
+			assert(it >= begin() && it < end());
+			for (T* next = it + 1; next != end(); ++next)
+			{
+				*(next - 1) = std::move(*next);
+			}
+			pop_back();
+			return it;
+		};
+
+		void erase_unordered(size_t idx)
+		{
+			assert(idx < _size);
+			if (idx != _size - 1) data()[idx] = std::move(data()[_size - 1]);
+			pop_back();
+		};
+
+	  private:
+		alignas(T) unsigned char _storage[sizeof(T) * N];
+		size_t _size{0};
+	};
+
+} // namespace rv
+
+#endif //!__FIXEDVECTOR__H__
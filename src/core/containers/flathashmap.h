@@ -0,0 +1,562 @@
+#ifndef __FLATHASHMAP__H__
+#define __FLATHASHMAP__H__
+
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RV_FLATHASH_SSE2 1
+#include <emmintrin.h>
+#else
+#define RV_FLATHASH_SSE2 0
+#endif
+
+#include <core/bits.h>
+#include <core/containers/hash.h>
+
+namespace rv
+{
+	namespace detail
+	{
+		// Control byte states, full slots store the low 7 bits of the hash (0..127)
+		static constexpr int8_t CtrlEmpty = -128;
+		static constexpr int8_t CtrlDeleted = -2;
+		static constexpr uint32_t GroupWidth = 16;
+
+		/**
+		 * @brief 16 control bytes probed at once, one bit per slot in the returned masks.
+		 */
+		struct ProbeGroup
+		{
+			explicit ProbeGroup(const int8_t* ctrl)
+			{
+#if RV_FLATHASH_SSE2
+				_ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+#else
+				memcpy(_ctrl, ctrl, GroupWidth);
+#endif
+			};
+
+			uint32_t Match(int8_t h2) const
+			{
+#if RV_FLATHASH_SSE2
+				return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_ctrl, _mm_set1_epi8(h2))));
+#else
+				uint32_t mask = 0;
+				for (uint32_t i = 0; i < GroupWidth; i++)
+				{
+					mask |= uint32_t(_ctrl[i] == h2) << i;
+				}
+				return mask;
+#endif
+			};
+
+			uint32_t MatchEmpty() const { return Match(CtrlEmpty); };
+
+			// Empty or deleted slots both have the sign bit set
+			uint32_t MatchFree() const
+			{
+#if RV_FLATHASH_SSE2
+				return static_cast<uint32_t>(_mm_movemask_epi8(_ctrl));
+#else
+				uint32_t mask = 0;
+				for (uint32_t i = 0; i < GroupWidth; i++)
+				{
+					mask |= uint32_t(_ctrl[i] < 0) << i;
+				}
+				return mask;
+#endif
+			};
+
+#if RV_FLATHASH_SSE2
+			__m128i _ctrl;
+#else
+			int8_t _ctrl[GroupWidth];
+#endif
+		};
+
+		/**
+		 * @brief Open addressing table with SIMD probed control bytes (SwissTable layout). Slots are stored
+		 * contiguously next to a control byte array, lookups touch one control group before any slot memory.
+		 */
+		template <typename Key, typename Slot, typename KeyOf, typename HashFn, typename KeyEq>
+		class FlatHashTable
+		{
+		  public:
+			template <bool IsConst>
+			class Iterator
+			{
+			  public:
+				using iterator_category = std::forward_iterator_tag;
+				using value_type = Slot;
+				using difference_type = std::ptrdiff_t;
+				using pointer = std::conditional_t<IsConst, const Slot*, Slot*>;
+				using reference = std::conditional_t<IsConst, const Slot&, Slot&>;
+
+				Iterator() = default;
+				Iterator(const FlatHashTable* table, size_t idx) : _table(table), _idx(idx) { SkipFree(); };
+
+				// Allow iterator -> const_iterator
+				template <bool OtherConst, typename = std::enable_if_t<IsConst && !OtherConst>>
+				Iterator(const Iterator<OtherConst>& other) : _table(other._table), _idx(other._idx){};
+
+				reference operator*() const { return const_cast<reference>(_table->_slots[_idx]); };
+				pointer operator->() const { return &**this; };
+
+				Iterator& operator++()
+				{
+					_idx++;
+					SkipFree();
+					return *this;
+				};
+
+				Iterator operator++(int)
+				{
+					Iterator prev = *this;
+					++*this;
+					return prev;
+				};
+
+				bool operator==(const Iterator& other) const { return _idx == other._idx; };
+				bool operator!=(const Iterator& other) const { return _idx != other._idx; };
+
+			  private:
+				void SkipFree()
+				{
+					while (_idx < _table->_capacity && _table->_ctrl[_idx] < 0)
+					{
+						_idx++;
+					}
+				};
+
+				const FlatHashTable* _table{nullptr};
+				size_t _idx{0};
+
+				friend class FlatHashTable;
+				template <bool>
+				friend class Iterator;
+			};
+
+			using iterator = Iterator<false>;
+			using const_iterator = Iterator<true>;
+
+			FlatHashTable() = default;
+
+			FlatHashTable(const FlatHashTable& other)
+			{
+				reserve(other._size);
+				for (const Slot& slot : other)
+				{
+					InsertUnique(slot);
+				}
+			};
+
+			FlatHashTable(FlatHashTable&& other) noexcept { Swap(other); };
+
+			FlatHashTable& operator=(const FlatHashTable& other)
+			{
+				if (this != &other)
+				{
+					FlatHashTable copy(other);
+					Swap(copy);
+				}
+				return *this;
+			};
+
+			FlatHashTable& operator=(FlatHashTable&& other) noexcept
+			{
+				if (this != &other)
+				{
+					FlatHashTable moved(std::move(other));
+					Swap(moved);
+				}
+				return *this;
+			};
+
+			~FlatHashTable()
+			{
+				DestroySlots();
+				Deallocate();
+			};
+
+			iterator begin() { return iterator(this, 0); };
+			iterator end() { return iterator(this, _capacity); };
+			const_iterator begin() const { return const_iterator(this, 0); };
+			const_iterator end() const { return const_iterator(this, _capacity); };
+
+			size_t size() const { return _size; };
+			bool empty() const { return _size == 0; };
+			size_t capacity() const { return _capacity; };
+
+			void clear()
+			{
+				DestroySlots();
+				if (_capacity) ResetCtrl();
+				_size = 0;
+				_growthLeft = MaxLoad(_capacity);
+			};
+
+			void reserve(size_t count)
+			{
+				size_t capacity = static_cast<size_t>(nextPowerOfTwo(count + count / 7 + 1));
+				if (capacity < GroupWidth) capacity = GroupWidth;
+				if (capacity > _capacity) Rehash(capacity);
+			};
+
+			template <typename K>
+			iterator find(const K& key)
+			{
+				const size_t idx = FindIndex(key);
+				return idx == NotFound ? end() : iterator(this, idx);
+			};
+
+			template <typename K>
+			const_iterator find(const K& key) const
+			{
+				const size_t idx = FindIndex(key);
+				return idx == NotFound ? end() : const_iterator(this, idx);
+			};
+
+			template <typename K>
+			bool contains(const K& key) const { return FindIndex(key) != NotFound; };
+
+			template <typename K>
+			size_t count(const K& key) const { return contains(key) ? 1 : 0; };
+
+			template <typename K>
+			size_t erase(const K& key)
+			{
+				const size_t idx = FindIndex(key);
+				if (idx == NotFound) return 0;
+				EraseAt(idx);
+				return 1;
+			};
+
+			iterator erase(const_iterator it)
+			{
+				EraseAt(it._idx);
+				return iterator(this, it._idx + 1);
+			};
+
+		  protected:
+			static constexpr size_t NotFound = size_t(-1);
+
+			static size_t MaxLoad(size_t capacity) { return capacity - capacity / 8; };
+
+			template <typename K>
+			size_t FindIndex(const K& key) const
+			{
+				if (_size == 0) return NotFound;
+
+				const uint64_t hash = _hasher(key);
+				const int8_t h2 = static_cast<int8_t>(hash & 0x7F);
+				const size_t mask = _capacity - 1;
+				size_t pos = static_cast<size_t>(hash >> 7) & mask;
+				for (size_t step = 1;; step++)
+				{
+					const ProbeGroup group(_ctrl + pos);
+					for (uint32_t match = group.Match(h2); match; match &= match - 1)
+					{
+						const size_t idx = (pos + countTrailingZeros(match)) & mask;
+						if (_keyEq(KeyOf()(_slots[idx]), key)) return idx;
+					}
+					if (group.MatchEmpty()) return NotFound;
+					pos = (pos + step * GroupWidth) & mask;
+				}
+			};
+
+			/**
+			 * @brief Find key or claim a slot for it. The slot is left unconstructed when inserted is true.
+			 */
+			template <typename K>
+			size_t FindOrPrepareInsert(const K& key, bool& inserted)
+			{
+				if (_capacity == 0) Rehash(GroupWidth);
+
+				const uint64_t hash = _hasher(key);
+				const int8_t h2 = static_cast<int8_t>(hash & 0x7F);
+				size_t mask = _capacity - 1;
+				size_t pos = static_cast<size_t>(hash >> 7) & mask;
+				size_t firstFree = NotFound;
+				for (size_t step = 1;; step++)
+				{
+					const ProbeGroup group(_ctrl + pos);
+					for (uint32_t match = group.Match(h2); match; match &= match - 1)
+					{
+						const size_t idx = (pos + countTrailingZeros(match)) & mask;
+						if (_keyEq(KeyOf()(_slots[idx]), key))
+						{
+							inserted = false;
+							return idx;
+						}
+					}
+					const uint32_t freeMask = group.MatchFree();
+					if (firstFree == NotFound && freeMask) firstFree = (pos + countTrailingZeros(freeMask)) & mask;
+					if (group.MatchEmpty()) break;
+					pos = (pos + step * GroupWidth) & mask;
+				}
+
+				// Reusing a tombstone doesn't consume growth. Out of growth with plenty of tombstones around, rehash
+				// in place to drop them instead of doubling
+				if (_ctrl[firstFree] == CtrlEmpty && _growthLeft == 0)
+				{
+					const bool dropTombstones = _capacity > GroupWidth && _size * 32 <= _capacity * 25;
+					Rehash(dropTombstones ? _capacity : _capacity * 2);
+					firstFree = FindFreeSlot(hash);
+				}
+
+				if (_ctrl[firstFree] == CtrlEmpty) _growthLeft--;
+				SetCtrl(firstFree, h2);
+				_size++;
+				inserted = true;
+				return firstFree;
+			};
+
+			template <typename S>
+			void InsertUnique(S&& slot)
+			{
+				bool inserted;
+				const size_t idx = FindOrPrepareInsert(KeyOf()(slot), inserted);
+				if (inserted) new (&_slots[idx]) Slot(std::forward<S>(slot));
+			};
+
+			void EraseAt(size_t idx)
+			{
+				_slots[idx].~Slot();
+				_size--;
+
+				// A slot can go straight back to empty if no probe sequence ever walked past it, which is the case
+				// when the group starting at it still had an empty slot
+				const ProbeGroup after(_ctrl + idx);
+				const ProbeGroup before(_ctrl + ((idx - GroupWidth) & (_capacity - 1)));
+				const uint32_t emptyAfter = after.MatchEmpty();
+				const uint32_t emptyBefore = before.MatchEmpty();
+				const bool wasNeverFull = emptyBefore && emptyAfter &&
+							  (countTrailingZeros(emptyAfter) + LeadingZeros16(emptyBefore)) < GroupWidth;
+				if (wasNeverFull)
+				{
+					SetCtrl(idx, CtrlEmpty);
+					_growthLeft++;
+				}
+				else
+				{
+					SetCtrl(idx, CtrlDeleted);
+				}
+			};
+
+			HashFn _hasher;
+			KeyEq _keyEq;
+			int8_t* _ctrl{nullptr};
+			Slot* _slots{nullptr};
+			size_t _capacity{0};
+			size_t _size{0};
+			size_t _growthLeft{0};
+
+		  private:
+			static uint32_t LeadingZeros16(uint32_t mask)
+			{
+				uint32_t count = 0;
+				for (uint32_t bit = 1u << (GroupWidth - 1); bit && !(mask & bit); bit >>= 1)
+				{
+					count++;
+				}
+				return count;
+			};
+
+			size_t FindFreeSlot(uint64_t hash) const
+			{
+				const size_t mask = _capacity - 1;
+				size_t pos = static_cast<size_t>(hash >> 7) & mask;
+				for (size_t step = 1;; step++)
+				{
+					const uint32_t freeMask = ProbeGroup(_ctrl + pos).MatchFree();
+					if (freeMask) return (pos + countTrailingZeros(freeMask)) & mask;
+					pos = (pos + step * GroupWidth) & mask;
+				}
+			};
+
+			// Control bytes past the end mirror the first group so unaligned group loads never wrap
+			void SetCtrl(size_t idx, int8_t value)
+			{
+				_ctrl[idx] = value;
+				if (idx < GroupWidth) _ctrl[_capacity + idx] = value;
+			};
+
+			void ResetCtrl() { memset(_ctrl, static_cast<uint8_t>(CtrlEmpty), _capacity + GroupWidth); };
+
+			void Rehash(size_t newCapacity)
+			{
+				int8_t* oldCtrl = _ctrl;
+				Slot* oldSlots = _slots;
+				const size_t oldCapacity = _capacity;
+
+				_capacity = newCapacity;
+				_slots = static_cast<Slot*>(::operator new(sizeof(Slot) * newCapacity, std::align_val_t(alignof(Slot))));
+				_ctrl = static_cast<int8_t*>(::operator new(newCapacity + GroupWidth));
+				ResetCtrl();
+				_growthLeft = MaxLoad(newCapacity) - _size;
+
+				for (size_t i = 0; i < oldCapacity; i++)
+				{
+					if (oldCtrl[i] < 0) continue;
+					const uint64_t hash = _hasher(KeyOf()(oldSlots[i]));
+					const size_t idx = FindFreeSlot(hash);
+					SetCtrl(idx, static_cast<int8_t>(hash & 0x7F));
+					new (&_slots[idx]) Slot(std::move(oldSlots[i]));
+					oldSlots[i].~Slot();
+				}
+
+				if (oldCapacity)
+				{
+					::operator delete(oldSlots, std::align_val_t(alignof(Slot)));
+					::operator delete(oldCtrl);
+				}
+			};
+
+			void DestroySlots()
+			{
+				if (std::is_trivially_destructible_v<Slot>) return;
+				for (size_t i = 0; i < _capacity; i++)
+				{
+					if (_ctrl[i] >= 0) _slots[i].~Slot();
+				}
+			};
+
+			void Deallocate()
+			{
+				if (!_capacity) return;
+				::operator delete(_slots, std::align_val_t(alignof(Slot)));
+				::operator delete(_ctrl);
+				_slots = nullptr;
+				_ctrl = nullptr;
+				_capacity = 0;
+			};
+
+			void Swap(FlatHashTable& other) noexcept
+			{
+				std::swap(_ctrl, other._ctrl);
+				std::swap(_slots, other._slots);
+				std::swap(_capacity, other._capacity);
+				std::swap(_size, other._size);
+				std::swap(_growthLeft, other._growthLeft);
+			};
+		};
+
+		struct PairKeyOf
+		{
+			template <typename P>
+			const auto& operator()(const P& pair) const
+			{
+				return pair.first;
+			}
+		};
+
+		struct IdentityKeyOf
+		{
+			template <typename K>
+			const K& operator()(const K& key) const
+			{
+				return key;
+			}
+		};
+	} // namespace detail
+
+	/**
+	 * @brief Open addressing hash map storing its pairs inline in one flat array. Pointers and iterators are
+	 * invalidated by any insertion that grows the table.
+	 */
+	template <typename Key, typename Value, typename HashFn = Hash<Key>, typename KeyEq = std::equal_to<>>
+	class FlatHashMap : public detail::FlatHashTable<Key, std::pair<Key, Value>, detail::PairKeyOf, HashFn, KeyEq>
+	{
+		using Base = detail::FlatHashTable<Key, std::pair<Key, Value>, detail::PairKeyOf, HashFn, KeyEq>;
+
+	  public:
+		using key_type = Key;
+		using mapped_type = Value;
+		using value_type = std::pair<Key, Value>;
+		using iterator = typename Base::iterator;
+		using const_iterator = typename Base::const_iterator;
+
+		template <typename K, typename... Args>
+		std::pair<iterator, bool> try_emplace(K&& key, Args&&... args)
+		{
+			bool inserted;
+			const size_t idx = this->FindOrPrepareInsert(key, inserted);
+			if (inserted)
+			{
+				new (&this->_slots[idx]) value_type(std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)),
+								    std::forward_as_tuple(std::forward<Args>(args)...));
+			}
+			return {iterator(this, idx), inserted};
+		};
+
+		std::pair<iterator, bool> insert(const value_type& value) { return try_emplace(value.first, value.second); };
+		std::pair<iterator, bool> insert(value_type&& value)
+		{
+			return try_emplace(std::move(value.first), std::move(value.second));
+		};
+
+		template <typename K, typename V>
+		std::pair<iterator, bool> insert_or_assign(K&& key, V&& value)
+		{
+			auto result = try_emplace(std::forward<K>(key), std::forward<V>(value));
+			if (!result.second) result.first->second = std::forward<V>(value);
+			return result;
+		};
+
+		template <typename K>
+		Value& operator[](K&& key)
+		{
+			return try_emplace(std::forward<K>(key)).first->second;
+		};
+
+		template <typename K>
+		Value& at(const K& key)
+		{
+			auto it = this->find(key);
+			assert(it != this->end() && "FlatHashMap::at key not found");
+			return it->second;
+		};
+
+		template <typename K>
+		const Value& at(const K& key) const
+		{
+			auto it = this->find(key);
+			assert(it != this->end() && "FlatHashMap::at key not found");
+			return it->second;
+		};
+	};
+
+	/**
+	 * @brief Open addressing hash set, see FlatHashMap.
+	 */
+	template <typename Key, typename HashFn = Hash<Key>, typename KeyEq = std::equal_to<>>
+	class FlatHashSet : public detail::FlatHashTable<Key, Key, detail::IdentityKeyOf, HashFn, KeyEq>
+	{
+		using Base = detail::FlatHashTable<Key, Key, detail::IdentityKeyOf, HashFn, KeyEq>;
+
+	  public:
+		using key_type = Key;
+		using value_type = Key;
+		using iterator = typename Base::iterator;
+		using const_iterator = typename Base::const_iterator;
+
+		template <typename K>
+		std::pair<iterator, bool> insert(K&& key)
+		{
+			bool inserted;
+			const size_t idx = this->FindOrPrepareInsert(key, inserted);
+			if (inserted) new (&this->_slots[idx]) Key(std::forward<K>(key));
+			return {iterator(this, idx), inserted};
+		};
+	};
+
+} // namespace rv
+
+#endif //!__FLATHASHMAP__H__
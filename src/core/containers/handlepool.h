@@ -0,0 +1,229 @@
+#ifndef __HANDLEPOOL__H__
+#define __HANDLEPOOL__H__
+
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include <core/containers/hash.h>
+
+namespace rv
+{
+	/**
+	 * @brief Typed 32-bit generational handle: 20 bits of slot index and 12 bits of generation. Generation 0 is
+	 * never handed out, so a zero handle is always null. The Tag only exists to keep handle types apart.
+	 */
+	template <typename Tag>
+	class Handle
+	{
+	  public:
+		static constexpr uint32_t IndexBits = 20;
+		static constexpr uint32_t GenerationBits = 32 - IndexBits;
+		static constexpr uint32_t IndexMask = (1u << IndexBits) - 1;
+		static constexpr uint32_t GenerationMask = (1u << GenerationBits) - 1;
+		static constexpr uint32_t MaxCount = IndexMask + 1;
+
+		constexpr Handle() = default;
+		constexpr Handle(uint32_t index, uint32_t generation)
+			: _value((generation & GenerationMask) << IndexBits | (index & IndexMask)){};
+
+		static constexpr Handle FromRaw(uint32_t value)
+		{
+			Handle handle;
+			handle._value = value;
+			return handle;
+		};
+
+		constexpr uint32_t GetIndex() const { return _value & IndexMask; };
+		constexpr uint32_t GetGeneration() const { return _value >> IndexBits; };
+		constexpr uint32_t GetRaw() const { return _value; };
+		constexpr bool IsNull() const { return _value == 0; };
+		constexpr explicit operator bool() const { return _value != 0; };
+
+		constexpr bool operator==(const Handle& other) const { return _value == other._value; };
+		constexpr bool operator!=(const Handle& other) const { return _value != other._value; };
+
+	  private:
+		uint32_t _value{0};
+	};
+
+	/**
+	 * @brief Dense object pool addressed by generational handles. Objects live packed in a contiguous array
+	 * (destroy swaps the last one into the hole), so iterating is a linear walk. A sparse slot array maps
+	 * handle indices to dense positions and keeps a free list of recycled slots; bumping the slot generation
+	 * on destroy makes every outstanding copy of the old handle resolve to nullptr.
+	 */
+	template <typename Tag, typename T = Tag>
+	class HandlePool
+	{
+	  public:
+		using HandleType = Handle<Tag>;
+		using iterator = typename std::vector<T>::iterator;
+		using const_iterator = typename std::vector<T>::const_iterator;
+
+		HandlePool() = default;
+
+		template <typename... Args>
+		HandleType Create(Args&&... args)
+		{
+			uint32_t index;
+			if (_freeHead != InvalidIndex)
+			{
+				index = _freeHead;
+				_freeHead = _slots[index].dense;
+			}
+			else
+			{
+				assert(_slots.size() < HandleType::MaxCount && "handle pool exhausted");
+				index = static_cast<uint32_t>(_slots.size());
+				_slots.push_back(Slot{InvalidIndex, 1});
+			}
+
+			Slot& slot = _slots[index];
+			slot.dense = static_cast<uint32_t>(_dense.size());
+			const HandleType handle(index, slot.generation);
+			_dense.emplace_back(std::forward<Args>(args)...);
+			_denseHandles.push_back(handle);
+			return handle;
+		};
+
+		bool IsValid(HandleType handle) const { return Resolve(handle) != InvalidIndex; };
+
+		T* Get(HandleType handle)
+		{
+			const uint32_t dense = Resolve(handle);
+			return dense != InvalidIndex ? &_dense[dense] : nullptr;
+		};
+
+		const T* Get(HandleType handle) const
+		{
+			const uint32_t dense = Resolve(handle);
+			return dense != InvalidIndex ? &_dense[dense] : nullptr;
+		};
+
+		/**
+		 * @brief Remove the object, moving it into outValue. Returns false for null or stale handles.
+		 */
+		bool Release(HandleType handle, T& outValue)
+		{
+			const uint32_t dense = Resolve(handle);
+			if (dense == InvalidIndex) return false;
+			outValue = std::move(_dense[dense]);
+			Erase(handle.GetIndex(), dense);
+			return true;
+		};
+
+		bool Destroy(HandleType handle)
+		{
+			const uint32_t dense = Resolve(handle);
+			if (dense == InvalidIndex) return false;
+			Erase(handle.GetIndex(), dense);
+			return true;
+		};
+
+		/**
+		 * @brief Destroy every object. Outstanding handles become stale.
+		 */
+		void Clear()
+		{
+			for (const HandleType handle : _denseHandles)
+			{
+				Slot& slot = _slots[handle.GetIndex()];
+				slot.generation = NextGeneration(slot.generation);
+				slot.dense = _freeHead;
+				_freeHead = handle.GetIndex();
+			}
+			_dense.clear();
+			_denseHandles.clear();
+		};
+
+		size_t size() const { return _dense.size(); };
+		bool empty() const { return _dense.empty(); };
+		void reserve(size_t count)
+		{
+			_dense.reserve(count);
+			_denseHandles.reserve(count);
+			_slots.reserve(count);
+		};
+
+		// Dense iteration, order changes whenever an object is destroyed
+		iterator begin() { return _dense.begin(); };
+		iterator end() { return _dense.end(); };
+		const_iterator begin() const { return _dense.begin(); };
+		const_iterator end() const { return _dense.end(); };
+
+		T* data() { return _dense.data(); };
+		const T* data() const { return _dense.data(); };
+
+		// Handle of the object at the same dense position
+		const HandleType* handles() const { return _denseHandles.data(); };
+
+	  private:
+		static constexpr uint32_t InvalidIndex = ~0u;
+
+		struct Slot
+		{
+			// Dense position while alive, next free slot while on the free list
+			uint32_t dense;
+			uint32_t generation;
+		};
+
+		static uint32_t NextGeneration(uint32_t generation)
+		{
+			// Skip 0 on wrap-around so the null handle never becomes valid
+			const uint32_t next = (generation + 1) & HandleType::GenerationMask;
+			return next == 0 ? 1 : next;
+		};
+
+		uint32_t Resolve(HandleType handle) const
+		{
+			const uint32_t index = handle.GetIndex();
+			if (handle.IsNull() || index >= _slots.size()) return InvalidIndex;
+			const Slot& slot = _slots[index];
+			return slot.generation == handle.GetGeneration() ? slot.dense : InvalidIndex;
+		};
+
+		void Erase(uint32_t index, uint32_t dense)
+		{
+			const uint32_t last = static_cast<uint32_t>(_dense.size()) - 1;
+			if (dense != last)
+			{
+				_dense[dense] = std::move(_dense[last]);
+				_denseHandles[dense] = _denseHandles[last];
+				_slots[_denseHandles[dense].GetIndex()].dense = dense;
+			}
+			_dense.pop_back();
+			_denseHandles.pop_back();
+
+			Slot& slot = _slots[index];
+			slot.generation = NextGeneration(slot.generation);
+			slot.dense = _freeHead;
+			_freeHead = index;
+		};
+
+		std::vector<T> _dense;
+		std::vector<HandleType> _denseHandles;
+		std::vector<Slot> _slots;
+		uint32_t _freeHead{InvalidIndex};
+	};
+
+	template <typename Tag>
+	struct Hash<Handle<Tag>>
+	{
+		uint64_t operator()(Handle<Tag> handle) const { return Hash<uint32_t>{}(handle.GetRaw()); }
+	};
+
+} // namespace rv
+
+namespace std
+{
+	template <typename Tag>
+	struct hash<rv::Handle<Tag>>
+	{
+		size_t operator()(const rv::Handle<Tag>& handle) const { return std::hash<uint32_t>{}(handle.GetRaw()); };
+	};
+} // namespace std
+
+#endif //!__HANDLEPOOL__H__
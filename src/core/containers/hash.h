@@ -0,0 +1,67 @@
+#ifndef __HASH__H__
+#define __HASH__H__
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include <core/stringid.h>
+#include <core/utils.h>
+
+namespace rv
+{
+	/**
+	 * @brief 64-bit finalizer (murmur3 fmix64), spreads low entropy keys over every bit.
+	 */
+	constexpr uint64_t mixHash(uint64_t value)
+	{
+		value ^= value >> 33;
+		value *= 0xff51afd7ed558ccdull;
+		value ^= value >> 33;
+		value *= 0xc4ceb9fe1a85ec53ull;
+		value ^= value >> 33;
+		return value;
+	}
+
+	/**
+	 * @brief Default hasher of the rv containers. Strings go through crc32_view (the same hash StringId and
+	 * the pack index use), integral keys through mixHash.
+	 */
+	template <typename T, typename = void>
+	struct Hash;
+
+	template <typename T>
+	struct Hash<T, std::enable_if_t<std::is_integral_v<T> || std::is_enum_v<T>>>
+	{
+		constexpr uint64_t operator()(T value) const { return mixHash(static_cast<uint64_t>(value)); }
+	};
+
+	template <typename T>
+	struct Hash<T*>
+	{
+		uint64_t operator()(const T* ptr) const { return mixHash(reinterpret_cast<uintptr_t>(ptr)); }
+	};
+
+	template <>
+	struct Hash<StringId>
+	{
+		constexpr uint64_t operator()(StringId id) const { return mixHash(id.GetHash()); }
+	};
+
+	template <>
+	struct Hash<std::string_view>
+	{
+		constexpr uint64_t operator()(std::string_view str) const { return mixHash(crc32_view(str)); }
+	};
+
+	// Takes views so maps keyed by std::string can be queried with literals and views without allocating
+	template <>
+	struct Hash<std::string>
+	{
+		constexpr uint64_t operator()(std::string_view str) const { return mixHash(crc32_view(str)); }
+	};
+
+} // namespace rv
+
+#endif //!__HASH__H__
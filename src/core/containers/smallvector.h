@@ -0,0 +1,245 @@
+#ifndef __SMALLVECTOR__H__
+#define __SMALLVECTOR__H__
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace rv
+{
+	/**
+	 * @brief Vector keeping up to N elements in inline storage, spilling to the heap only past that.
+	 * Growth follows std::vector semantics (pointers are invalidated when capacity changes).
+	 */
+	template <typename T, size_t N>
+	class SmallVector
+	{
+		static_assert(N > 0, "SmallVector needs inline capacity, use std::vector otherwise");
+
+	  public:
+		using value_type = T;
+		using iterator = T*;
+		using const_iterator = const T*;
+
+		SmallVector() = default;
+
+		SmallVector(std::initializer_list<T> init)
+		{
+			reserve(init.size());
+			for (const T& value : init)
+			{
+				new (_data + _size++) T(value);
+			}
+		};
+
+		SmallVector(const SmallVector& other)
+		{
+			reserve(other._size);
+			for (const T& value : other)
+			{
+				new (_data + _size++) T(value);
+			}
+		};
+
+		SmallVector(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) { MoveFrom(other); };
+
+		SmallVector& operator=(const SmallVector& other)
+		{
+			if (this != &other)
+			{
+				clear();
+				reserve(other._size);
+				for (const T& value : other)
+				{
+					new (_data + _size++) T(value);
+				}
+			}
+			return *this;
+		};
+
+		SmallVector& operator=(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+		{
+			if (this != &other)
+			{
+				clear();
+				ReleaseHeap();
+				MoveFrom(other);
+			}
+			return *this;
+		};
+
+		~SmallVector()
+		{
+			clear();
+			ReleaseHeap();
+		};
+
+		T* data() { return _data; };
+		const T* data() const { return _data; };
+		size_t size() const { return _size; };
+		size_t capacity() const { return _capacity; };
+		bool empty() const { return _size == 0; };
+		bool is_inline() const { return _data == InlineData(); };
+
+		iterator begin() { return _data; };
+		iterator end() { return _data + _size; };
+		const_iterator begin() const { return _data; };
+		const_iterator end() const { return _data + _size; };
+
+		T& operator[](size_t idx)
+		{
+			assert(idx < _size);
+			return _data[idx];
+		};
+
+		const T& operator[](size_t idx) const
+		{
+			assert(idx < _size);
+			return _data[idx];
+		};
+
+		T& front() { return (*this)[0]; };
+		T& back() { return (*this)[_size - 1]; };
+		const T& front() const { return (*this)[0]; };
+		const T& back() const { return (*this)[_size - 1]; };
+
+		void reserve(size_t capacity)
+		{
+			if (capacity > _capacity) Grow(capacity);
+		};
+
+		template <typename... Args>
+		T& emplace_back(Args&&... args)
+		{
+			if (_size < _capacity) return *new (_data + _size++) T(std::forward<Args>(args)...);
+
+			// args may point into the current buffer (v.push_back(v[0])), build the new element before the
+			// others move out of it
+			const size_t capacity = _capacity * 2;
+			T* heap = Allocate(capacity);
+			new (heap + _size) T(std::forward<Args>(args)...);
+			Relocate(heap, capacity);
+			return _data[_size++];
+		};
+
+		void push_back(const T& value) { emplace_back(value); };
+		void push_back(T&& value) { emplace_back(std::move(value)); };
+
+		void pop_back()
+		{
+			assert(_size > 0);
+			_data[--_size].~T();
+		};
+
+		void resize(size_t size)
+		{
+			reserve(size);
+			while (_size < size)
+			{
+				new (_data + _size++) T();
+			}
+			while (_size > size)
+			{
+				pop_back();
+			}
+		};
+
+		void clear()
+		{
+			while (_size > 0)
+			{
+				pop_back();
+			}
+		};
+
+		iterator erase(const_iterator pos)
+		{
+			T* it = const_cast<T*>(pos);
+			assert(it >= _data && it < _data + _size);
+			for (T* next = it + 1; next != end(); ++next)
+			{
+				*(next - 1) = std::move(*next);
+			}
+			pop_back();
+			return it;
+		};
+
+		/**
+		 * @brief O(1) erase that moves the last element into the hole, order is not preserved.
+		 */
+		void erase_unordered(size_t idx)
+		{
+			assert(idx < _size);
+			if (idx != _size - 1) _data[idx] = std::move(_data[_size - 1]);
+			pop_back();
+		};
+
+	  private:
+		T* InlineData() { return reinterpret_cast<T*>(_inline); };
+		const T* InlineData() const { return reinterpret_cast<const T*>(_inline); };
+
+		static T* Allocate(size_t capacity)
+		{
+			return static_cast<T*>(::operator new(sizeof(T) * capacity, std::align_val_t(alignof(T))));
+		};
+
+		void Grow(size_t capacity) { Relocate(Allocate(capacity), capacity); };
+
+		// Move the elements into heap, a new buffer of capacity elements, and release the current one
+		void Relocate(T* heap, size_t capacity)
+		{
+			for (size_t i = 0; i < _size; i++)
+			{
+				new (heap + i) T(std::move(_data[i]));
+				_data[i].~T();
+			}
+			ReleaseHeap();
+			_data = heap;
+			_capacity = capacity;
+		};
+
+		void ReleaseHeap()
+		{
+			if (is_inline()) return;
+			::operator delete(_data, std::align_val_t(alignof(T)));
+			_data = InlineData();
+			_capacity = N;
+		};
+
+		// Expects this to be empty and inline
+		void MoveFrom(SmallVector& other)
+		{
+			if (other.is_inline())
+			{
+				for (size_t i = 0; i < other._size; i++)
+				{
+					new (_data + i) T(std::move(other._data[i]));
+				}
+				_size = other._size;
+				other.clear();
+			}
+			else
+			{
+				// Steal the heap buffer
+				_data = other._data;
+				_size = other._size;
+				_capacity = other._capacity;
+				other._data = other.InlineData();
+				other._size = 0;
+				other._capacity = N;
+			}
+		};
+
+		T* _data{InlineData()};
+		size_t _size{0};
+		size_t _capacity{N};
+		alignas(T) unsigned char _inline[sizeof(T) * N];
+	};
+
+} // namespace rv
+
+#endif //!__SMALLVECTOR__H__
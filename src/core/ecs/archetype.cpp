@@ -0,0 +1,116 @@
+// StdLib Includes
+#include <cassert>
+#include <new>
+
+// Application Specific Includes
+#include <core/bits.h>
+#include <core/ecs/archetype.h>
+
+namespace gefx
+{
+	namespace
+	{
+		constexpr std::align_val_t ChunkAlign{rv::CacheLineSize};
+	}
+
+	Archetype::Archetype(ComponentMask mask) : _mask(mask)
+	{
+		const ComponentRegistry& registry = ComponentRegistry::Get();
+
+		uint32_t rowBytes = sizeof(Entity);
+		for (ComponentId id = 0; id < MaxComponentTypes; id++)
+		{
+			if (!Has(id)) continue;
+			_components.push_back(id);
+			_sizes[id] = registry.GetInfo(id).size;
+			rowBytes += _sizes[id];
+		}
+
+		// Columns start aligned, shrink the estimate until the padding fits too
+		const auto layout = [&](uint32_t capacity) {
+			uint64_t offset = uint64_t(sizeof(Entity)) * capacity;
+			for (const ComponentId id : _components)
+			{
+				offset = rv::alignUp(offset, registry.GetInfo(id).align);
+				_offsets[id] = static_cast<uint32_t>(offset);
+				offset += uint64_t(_sizes[id]) * capacity;
+			}
+			return offset;
+		};
+
+		_capacity = ChunkSize / rowBytes;
+		while (_capacity > 0 && layout(_capacity) > ChunkSize)
+		{
+			_capacity--;
+		}
+		assert(_capacity > 0 && "component set doesn't fit in a chunk");
+	}
+
+	Archetype::~Archetype()
+	{
+		const ComponentRegistry& registry = ComponentRegistry::Get();
+		for (const Chunk& chunk : _chunks)
+		{
+			for (const ComponentId id : _components)
+			{
+				const ComponentInfo& info = registry.GetInfo(id);
+				std::byte* column = chunk.data + _offsets[id];
+				for (uint32_t row = 0; row < chunk.count; row++)
+				{
+					info.destroy(column + size_t(row) * info.size);
+				}
+			}
+			::operator delete(chunk.data, ChunkAlign);
+		}
+	}
+
+	Archetype::Location Archetype::AllocateRow(Entity entity)
+	{
+		if (_chunks.empty() || _chunks.back().count == _capacity)
+		{
+			_chunks.push_back(Chunk{static_cast<std::byte*>(::operator new(ChunkSize, ChunkAlign)), 0});
+		}
+
+		Chunk& chunk = _chunks.back();
+		const Location location{static_cast<uint32_t>(_chunks.size() - 1), chunk.count++};
+		GetEntities(location.chunk)[location.row] = entity;
+		_entityCount++;
+		return location;
+	}
+
+	Entity Archetype::RemoveRow(Location location)
+	{
+		const ComponentRegistry& registry = ComponentRegistry::Get();
+		const Location last{static_cast<uint32_t>(_chunks.size() - 1), _chunks.back().count - 1};
+		const bool isLast = location.chunk == last.chunk && location.row == last.row;
+
+		for (const ComponentId id : _components)
+		{
+			const ComponentInfo& info = registry.GetInfo(id);
+			void* hole = GetComponent(location, id);
+			info.destroy(hole);
+			if (!isLast)
+			{
+				void* tail = GetComponent(last, id);
+				info.moveConstruct(hole, tail);
+				info.destroy(tail);
+			}
+		}
+
+		Entity moved;
+		if (!isLast)
+		{
+			moved = GetEntities(last.chunk)[last.row];
+			GetEntities(location.chunk)[location.row] = moved;
+		}
+
+		_entityCount--;
+		if (--_chunks.back().count == 0)
+		{
+			::operator delete(_chunks.back().data, ChunkAlign);
+			_chunks.pop_back();
+		}
+		return moved;
+	}
+
+} // namespace gefx
@@ -0,0 +1,94 @@
+#ifndef __ARCHETYPE__H__
+#define __ARCHETYPE__H__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <core/ecs/entity.h>
+
+namespace gefx
+{
+	static constexpr uint32_t ChunkSize = 16 * 1024;
+
+	/**
+	 * @brief Storage of every entity owning exactly one set of component types. Entities are packed in 16KiB
+	 * chunks laid out as structure of arrays: the entity column followed by one column per component, so a
+	 * system touching two components streams through two contiguous arrays. All chunks but the last are full.
+	 */
+	class Archetype
+	{
+	  public:
+		struct Location
+		{
+			uint32_t chunk;
+			uint32_t row;
+		};
+
+		explicit Archetype(ComponentMask mask);
+		~Archetype();
+
+		Archetype(Archetype&&) = delete;
+		Archetype(const Archetype&) = delete;
+		Archetype& operator=(Archetype&&) = delete;
+		Archetype& operator=(const Archetype&) = delete;
+
+		ComponentMask GetMask() const { return _mask; };
+		bool Has(ComponentId id) const { return (_mask >> id) & 1; };
+		const std::vector<ComponentId>& GetComponents() const { return _components; };
+
+		uint32_t GetChunkCapacity() const { return _capacity; };
+		uint32_t GetChunkCount() const { return static_cast<uint32_t>(_chunks.size()); };
+		uint32_t GetChunkEntityCount(uint32_t chunk) const { return _chunks[chunk].count; };
+		size_t GetEntityCount() const { return _entityCount; };
+
+		Entity* GetEntities(uint32_t chunk) const { return reinterpret_cast<Entity*>(_chunks[chunk].data); };
+
+		void* GetColumn(uint32_t chunk, ComponentId id) const
+		{
+			return _chunks[chunk].data + _offsets[id];
+		};
+
+		void* GetComponent(Location location, ComponentId id) const
+		{
+			return _chunks[location.chunk].data + _offsets[id] + size_t(location.row) * _sizes[id];
+		};
+
+		/**
+		 * @brief Append a row for entity, its components are left unconstructed.
+		 */
+		Location AllocateRow(Entity entity);
+
+		/**
+		 * @brief Destroy the components at location and fill the hole with the archetype's last row.
+		 *
+		 * @return The entity moved into location, or a null entity if location was the last row.
+		 */
+		Entity RemoveRow(Location location);
+
+	  private:
+		struct Chunk
+		{
+			std::byte* data;
+			uint32_t count;
+		};
+
+		ComponentMask _mask;
+		std::vector<ComponentId> _components;
+		uint32_t _offsets[MaxComponentTypes]{};
+		uint32_t _sizes[MaxComponentTypes]{};
+		uint32_t _capacity{0};
+
+		std::vector<Chunk> _chunks;
+		size_t _entityCount{0};
+
+		// Archetype reached by adding / removing one component, filled lazily by the World
+		Archetype* _addEdges[MaxComponentTypes]{};
+		Archetype* _removeEdges[MaxComponentTypes]{};
+
+		friend class World;
+	};
+
+} // namespace gefx
+
+#endif //!__ARCHETYPE__H__
@@ -0,0 +1,171 @@
+// StdLib Includes
+#include <cassert>
+#include <new>
+
+// Application Specific Includes
+#include <core/ecs/commandbuffer.h>
+#include <core/ecs/world.h>
+
+namespace gefx
+{
+	namespace
+	{
+		constexpr size_t BlockSize = 64 * 1024;
+		constexpr size_t CommandAlign = 16;
+		constexpr std::align_val_t BlockAlign{rv::CacheLineSize};
+	} // namespace
+
+	CommandBuffer::~CommandBuffer()
+	{
+		Clear();
+		for (const Block& block : _blocks)
+		{
+			::operator delete(block.data, BlockAlign);
+		}
+	}
+
+	std::byte* CommandBuffer::Record(Op op, Entity entity, uint32_t count, const ComponentId* ids,
+									 const uint32_t* sizes, const uint32_t* aligns)
+	{
+		assert(count <= MaxComponentTypes);
+
+		// Worst case size, payload padding depends on where the command lands
+		size_t maxBytes = sizeof(Header) + sizeof(Component) * count;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			maxBytes += sizes[i] + aligns[i] - 1;
+		}
+
+		while (_currentBlock < _blocks.size() &&
+			   _blocks[_currentBlock].capacity - _blocks[_currentBlock].used < maxBytes)
+		{
+			_currentBlock++;
+		}
+		if (_currentBlock == _blocks.size())
+		{
+			const size_t capacity = rv::alignUp(maxBytes > BlockSize ? maxBytes : BlockSize, CommandAlign);
+			_blocks.push_back(Block{static_cast<std::byte*>(::operator new(capacity, BlockAlign)), 0, capacity});
+		}
+
+		Block& block = _blocks[_currentBlock];
+		std::byte* command = block.data + block.used;
+		const uintptr_t base = reinterpret_cast<uintptr_t>(command);
+
+		Component* components = GetComponents(command);
+		uint64_t offset = sizeof(Header) + sizeof(Component) * count;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			components[i].id = ids[i];
+			if (sizes[i] == 0)
+			{
+				components[i].offset = 0;
+				continue;
+			}
+			offset = rv::alignUp(base + offset, aligns[i]) - base;
+			components[i].offset = static_cast<uint32_t>(offset);
+			offset += sizes[i];
+		}
+
+		Header* header = new (command) Header;
+		header->op = op;
+		header->componentCount = static_cast<uint8_t>(count);
+		header->entity = entity;
+		header->size = static_cast<uint32_t>(rv::alignUp(offset, CommandAlign));
+
+		block.used += header->size;
+		_commandCount++;
+		return command;
+	}
+
+	template <typename F>
+	void CommandBuffer::ForEachCommand(F&& fn)
+	{
+		for (size_t i = 0; i <= _currentBlock && i < _blocks.size(); i++)
+		{
+			const Block& block = _blocks[i];
+			for (size_t position = 0; position < block.used;)
+			{
+				std::byte* command = block.data + position;
+				const Header& header = *reinterpret_cast<const Header*>(command);
+				position += header.size;
+				fn(command, header);
+			}
+		}
+	}
+
+	void CommandBuffer::Playback(World& world)
+	{
+		const ComponentRegistry& registry = ComponentRegistry::Get();
+
+		ForEachCommand([&](std::byte* command, const Header& header) {
+			const Component* components = GetComponents(command);
+			switch (header.op)
+			{
+			case Op::Create:
+			{
+				ComponentMask mask = 0;
+				for (uint32_t i = 0; i < header.componentCount; i++)
+				{
+					mask |= ComponentMask{1} << components[i].id;
+				}
+				const Entity entity = world.CreateUninitialized(mask);
+				for (uint32_t i = 0; i < header.componentCount; i++)
+				{
+					const ComponentInfo& info = registry.GetInfo(components[i].id);
+					void* payload = command + components[i].offset;
+					info.moveConstruct(world.GetComponentRaw(entity, components[i].id), payload);
+					info.destroy(payload);
+				}
+				break;
+			}
+			case Op::Destroy:
+				world.Destroy(header.entity);
+				break;
+			case Op::Add:
+			{
+				const ComponentInfo& info = registry.GetInfo(components[0].id);
+				void* payload = command + components[0].offset;
+				if (world.IsAlive(header.entity))
+				{
+					info.moveConstruct(world.AddUninitialized(header.entity, components[0].id), payload);
+				}
+				info.destroy(payload);
+				break;
+			}
+			case Op::Remove:
+				if (world.IsAlive(header.entity)) world.RemoveComponent(header.entity, components[0].id);
+				break;
+			}
+		});
+
+		Reset();
+	}
+
+	void CommandBuffer::Clear()
+	{
+		const ComponentRegistry& registry = ComponentRegistry::Get();
+
+		ForEachCommand([&](std::byte* command, const Header& header) {
+			if (header.op != Op::Create && header.op != Op::Add) return;
+			const Component* components = GetComponents(command);
+			for (uint32_t i = 0; i < header.componentCount; i++)
+			{
+				registry.GetInfo(components[i].id).destroy(command + components[i].offset);
+			}
+		});
+
+		Reset();
+	}
+
+	void CommandBuffer::Reset()
+	{
+		// Keep the blocks around, the next frame most likely records about as much
+		for (Block& block : _blocks)
+		{
+			block.used = 0;
+		}
+		_currentBlock = 0;
+		_commandCount = 0;
+	}
+
+} // namespace gefx
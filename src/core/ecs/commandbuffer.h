@@ -0,0 +1,134 @@
+#ifndef __COMMANDBUFFER__H__
+#define __COMMANDBUFFER__H__
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <core/bits.h>
+#include <core/ecs/entity.h>
+
+namespace gefx
+{
+	class World;
+
+	/**
+	 * @brief Records structural changes (create, destroy, add, remove) so systems can request them while
+	 * iterating, then applies them in recording order with Playback. Component values are moved into an
+	 * append-only arena of stable blocks, so recording allocates only when a block fills up.
+	 * A command buffer is not thread safe, use one per job / thread.
+	 */
+	class CommandBuffer
+	{
+	  public:
+		CommandBuffer() = default;
+		~CommandBuffer();
+
+		CommandBuffer(CommandBuffer&&) = delete;
+		CommandBuffer(const CommandBuffer&) = delete;
+		CommandBuffer& operator=(CommandBuffer&&) = delete;
+		CommandBuffer& operator=(const CommandBuffer&) = delete;
+
+		template <typename... Ts>
+		void Create(Ts&&... components)
+		{
+			const ComponentId ids[] = {componentId<Ts>()..., 0};
+			const uint32_t sizes[] = {static_cast<uint32_t>(sizeof(std::decay_t<Ts>))..., 0};
+			const uint32_t aligns[] = {static_cast<uint32_t>(alignof(std::decay_t<Ts>))..., 1};
+			std::byte* command = Record(Op::Create, Entity{}, sizeof...(Ts), ids, sizes, aligns);
+			const Component* records = GetComponents(command);
+			size_t i = 0;
+			((new (command + records[i++].offset) std::decay_t<Ts>(std::forward<Ts>(components))), ...);
+		};
+
+		void Destroy(Entity entity) { Record(Op::Destroy, entity, 0, nullptr, nullptr, nullptr); };
+
+		template <typename T>
+		void Add(Entity entity, T&& value)
+		{
+			using Type = std::decay_t<T>;
+			const ComponentId id = componentId<Type>();
+			const uint32_t size = sizeof(Type);
+			const uint32_t align = alignof(Type);
+			std::byte* command = Record(Op::Add, entity, 1, &id, &size, &align);
+			new (command + GetComponents(command)[0].offset) Type(std::forward<T>(value));
+		};
+
+		template <typename T>
+		void Remove(Entity entity)
+		{
+			const ComponentId id = componentId<T>();
+			const uint32_t size = 0;
+			const uint32_t align = 1;
+			Record(Op::Remove, entity, 1, &id, &size, &align);
+		};
+
+		bool Empty() const { return _commandCount == 0; };
+		size_t GetCommandCount() const { return _commandCount; };
+
+		/**
+		 * @brief Apply every recorded command to world in order and reset the buffer. Commands targeting
+		 * entities that died in the meantime are dropped.
+		 */
+		void Playback(World& world);
+
+		/**
+		 * @brief Drop every recorded command without applying it.
+		 */
+		void Clear();
+
+	  private:
+		enum class Op : uint8_t
+		{
+			Create,
+			Destroy,
+			Add,
+			Remove
+		};
+
+		struct alignas(16) Header
+		{
+			Op op;
+			uint8_t componentCount;
+			Entity entity;
+			// Bytes up to the next command
+			uint32_t size;
+		};
+
+		struct Component
+		{
+			ComponentId id;
+			// Payload offset from the command start, 0 if the command carries no value
+			uint32_t offset;
+		};
+
+		struct Block
+		{
+			std::byte* data;
+			size_t used;
+			size_t capacity;
+		};
+
+		static Component* GetComponents(std::byte* command)
+		{
+			return reinterpret_cast<Component*>(command + sizeof(Header));
+		};
+
+		std::byte* Record(Op op, Entity entity, uint32_t count, const ComponentId* ids, const uint32_t* sizes,
+						  const uint32_t* aligns);
+
+		template <typename F>
+		void ForEachCommand(F&& fn);
+
+		void Reset();
+
+		std::vector<Block> _blocks;
+		size_t _currentBlock{0};
+		size_t _commandCount{0};
+	};
+
+} // namespace gefx
+
+#endif //!__COMMANDBUFFER__H__
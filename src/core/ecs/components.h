@@ -0,0 +1,33 @@
+#ifndef __COMPONENTS__H__
+#define __COMPONENTS__H__
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace gefx
+{
+	// Common transform components, systems compose them into LocalToWorld once per frame
+
+	struct Translation
+	{
+		glm::vec3 value{0.0f};
+	};
+
+	struct Rotation
+	{
+		glm::quat value{1.0f, 0.0f, 0.0f, 0.0f};
+	};
+
+	struct Scale
+	{
+		glm::vec3 value{1.0f};
+	};
+
+	struct LocalToWorld
+	{
+		glm::mat4 value{1.0f};
+	};
+
+} // namespace gefx
+
+#endif //!__COMPONENTS__H__
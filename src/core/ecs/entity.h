@@ -0,0 +1,118 @@
+#ifndef __ENTITY__H__
+#define __ENTITY__H__
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <core/containers/handlepool.h>
+
+namespace gefx
+{
+	struct EntityTag;
+	using Entity = rv::Handle<EntityTag>;
+
+	using ComponentId = uint32_t;
+	// Archetype signatures are plain bitmasks, one bit per registered component type
+	using ComponentMask = uint64_t;
+	static constexpr uint32_t MaxComponentTypes = 64;
+
+	/**
+	 * @brief Type erased lifetime operations of a component type, used when rows move between chunks.
+	 */
+	struct ComponentInfo
+	{
+		const char* name;
+		uint32_t size;
+		uint32_t align;
+		void (*moveConstruct)(void* dst, void* src);
+		void (*destroy)(void* ptr);
+	};
+
+	class ComponentRegistry
+	{
+	  public:
+		static ComponentRegistry& Get()
+		{
+			static ComponentRegistry registry;
+			return registry;
+		};
+
+		ComponentRegistry(ComponentRegistry&&) = delete;
+		ComponentRegistry(const ComponentRegistry&) = delete;
+		ComponentRegistry& operator=(ComponentRegistry&&) = delete;
+		ComponentRegistry& operator=(const ComponentRegistry&) = delete;
+
+		ComponentId Register(const ComponentInfo& info)
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			assert(_count < MaxComponentTypes && "too many component types");
+			_infos[_count] = info;
+			return _count++;
+		};
+
+		// Entries are written once before their id is published, so lookups need no lock
+		const ComponentInfo& GetInfo(ComponentId id) const { return _infos[id]; };
+
+	  private:
+		ComponentRegistry() = default;
+
+		std::mutex _mutex;
+		ComponentInfo _infos[MaxComponentTypes]{};
+		ComponentId _count{0};
+	};
+
+	namespace detail
+	{
+		template <typename T>
+		ComponentId RegisterComponent()
+		{
+			static_assert(std::is_move_constructible_v<T>, "components must be move constructible");
+			static_assert(alignof(T) <= 64, "components can't be aligned past a cache line");
+
+			ComponentInfo info;
+#if defined(__GNUC__) || defined(__clang__)
+			info.name = __PRETTY_FUNCTION__;
+#else
+			info.name = __FUNCSIG__;
+#endif
+			info.size = static_cast<uint32_t>(sizeof(T));
+			info.align = static_cast<uint32_t>(alignof(T));
+			info.moveConstruct = [](void* dst, void* src) { new (dst) T(std::move(*static_cast<T*>(src))); };
+			info.destroy = [](void* ptr) { static_cast<T*>(ptr)->~T(); };
+			return ComponentRegistry::Get().Register(info);
+		}
+	} // namespace detail
+
+	/**
+	 * @brief Stable id of a component type, assigned on first use. const and references map to the same id.
+	 */
+	template <typename T>
+	ComponentId componentId()
+	{
+		using Type = std::remove_cv_t<std::remove_reference_t<T>>;
+		if constexpr (!std::is_same_v<T, Type>)
+		{
+			return componentId<Type>();
+		}
+		else
+		{
+			static const ComponentId id = detail::RegisterComponent<Type>();
+			return id;
+		}
+	}
+
+	template <typename... Ts>
+	ComponentMask componentMask()
+	{
+		return (ComponentMask{0} | ... | (ComponentMask{1} << componentId<Ts>()));
+	}
+
+} // namespace gefx
+
+#endif //!__ENTITY__H__
@@ -0,0 +1,312 @@
+// StdLib Includes
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+// Third Party Includes
+#include <fmt/format.h>
+
+// Application Specific Includes
+#include <core/ecs/scheduler.h>
+#include <core/ecs/world.h>
+#include <core/log.h>
+
+namespace gefx
+{
+	SystemAccess& SystemAccess::Include(const Query& query)
+	{
+		read |= query.GetReadMask();
+		write |= query.GetWriteMask();
+		return *this;
+	}
+
+	SystemScheduler::SystemId SystemScheduler::AddSystem(const char* name, const SystemAccess& access, SystemFn fn,
+														 bool mainThread)
+	{
+		System system;
+		system.name = name;
+		system.access = access;
+		system.fn = std::move(fn);
+		system.mainThread = mainThread;
+		_systems.push_back(std::move(system));
+		_dirty = true;
+		return static_cast<SystemId>(_systems.size() - 1);
+	}
+
+	void SystemScheduler::AddDependency(SystemId before, SystemId after)
+	{
+		assert(before < _systems.size() && after < _systems.size() && before != after);
+		if (before >= _systems.size() || after >= _systems.size() || before == after)
+		{
+			// Kept for Build to report, no graph builds with it
+			_invalidDependencies.push_back(fmt::format("{} -> {}", before, after));
+		}
+		else
+		{
+			_systems[after].explicitAfter.push_back(before);
+		}
+		_dirty = true;
+	}
+
+	bool SystemScheduler::Build(std::string& outError)
+	{
+		_valid = false;
+		_dirty = false;
+		if (!_invalidDependencies.empty())
+		{
+			outError = "dependencies on unknown systems:";
+			for (const std::string& dependency : _invalidDependencies)
+			{
+				outError += fmt::format(" '{}'", dependency);
+			}
+			return false;
+		}
+
+		const size_t count = _systems.size();
+		for (System& system : _systems)
+		{
+			system.successors.clear();
+			system.predecessors.clear();
+		}
+		_conflicts.clear();
+		_order.clear();
+
+		std::vector<uint8_t> edges(count * count, 0);
+		const auto addEdge = [&](SystemId from, SystemId to) {
+			if (edges[from * count + to]) return;
+			edges[from * count + to] = 1;
+			_systems[from].successors.push_back(to);
+			_systems[to].predecessors.push_back(from);
+		};
+
+		// Conflicting systems keep their registration order, so results never depend on thread timing
+		for (SystemId i = 0; i < count; i++)
+		{
+			const SystemAccess& a = _systems[i].access;
+			for (SystemId j = i + 1; j < count; j++)
+			{
+				const SystemAccess& b = _systems[j].access;
+				if (!a.ConflictsWith(b)) continue;
+
+				const ComponentMask components = (a.write & (b.read | b.write)) | (b.write & a.read);
+				const ResourceMask resources =
+					(a.writeResources & (b.readResources | b.writeResources)) | (b.writeResources & a.readResources);
+				_conflicts.push_back(Conflict{i, j, components, resources});
+				addEdge(i, j);
+			}
+		}
+		for (SystemId i = 0; i < count; i++)
+		{
+			for (const SystemId before : _systems[i].explicitAfter)
+			{
+				addEdge(before, i);
+			}
+		}
+
+		// Kahn's algorithm, the earliest registered ready system goes first
+		std::vector<uint32_t> inDegree(count);
+		std::priority_queue<SystemId, std::vector<SystemId>, std::greater<SystemId>> ready;
+		for (SystemId i = 0; i < count; i++)
+		{
+			inDegree[i] = static_cast<uint32_t>(_systems[i].predecessors.size());
+			if (inDegree[i] == 0) ready.push(i);
+		}
+		while (!ready.empty())
+		{
+			const SystemId system = ready.top();
+			ready.pop();
+			_order.push_back(system);
+			for (const SystemId successor : _systems[system].successors)
+			{
+				if (--inDegree[successor] == 0) ready.push(successor);
+			}
+		}
+
+		if (_order.size() != count)
+		{
+			outError = "dependency cycle between systems:";
+			for (SystemId i = 0; i < count; i++)
+			{
+				if (inDegree[i] > 0) outError += fmt::format(" '{}'", _systems[i].name);
+			}
+			return false;
+		}
+
+		_pending = std::make_unique<std::atomic<uint32_t>[]>(count);
+		_valid = true;
+		return true;
+	}
+
+	bool SystemScheduler::BuildOrAssert()
+	{
+		if (!_dirty) return _valid;
+
+		std::string error;
+		if (!Build(error))
+		{
+			// Reported once, frames are skipped until systems or dependencies change
+			GEFX_LOG_ERROR("SystemScheduler: {}", error);
+			assert(false && "invalid system graph");
+		}
+		return _valid;
+	}
+
+	void SystemScheduler::Run(JobSystem& jobs, double deltaTime)
+	{
+		if (!BuildOrAssert() || _systems.empty()) return;
+
+		_jobs = &jobs;
+		_deltaTime = deltaTime;
+		_frameStart = clock::now();
+		_remaining = static_cast<uint32_t>(_systems.size());
+		for (SystemId i = 0; i < _systems.size(); i++)
+		{
+			_pending[i].store(static_cast<uint32_t>(_systems[i].predecessors.size()), std::memory_order_relaxed);
+		}
+
+		for (const SystemId system : _order)
+		{
+			if (_systems[system].predecessors.empty()) Dispatch(system);
+		}
+
+		while (true)
+		{
+			// Checking after taking the ticket catches whatever happened in between, like JobSystem::Wait
+			const uint32_t ticket = _wake.PrepareWait();
+			SystemId mainThreadSystem = ~0u;
+			bool done;
+			{
+				std::lock_guard<std::mutex> lock(_mainThreadMutex);
+				done = _remaining == 0;
+				if (!done && !_mainThreadReady.empty())
+				{
+					auto first = std::min_element(_mainThreadReady.begin(), _mainThreadReady.end());
+					mainThreadSystem = *first;
+					_mainThreadReady.erase(first);
+				}
+			}
+
+			if (done)
+			{
+				_wake.CancelWait();
+				break;
+			}
+			if (mainThreadSystem != ~0u)
+			{
+				_wake.CancelWait();
+				Execute(mainThreadSystem);
+				continue;
+			}
+			if (jobs.TryRunOne())
+			{
+				_wake.CancelWait();
+				continue;
+			}
+			// Nothing to run here, the workers have the rest
+			_wake.Wait(ticket);
+		}
+
+		ComputeStats(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - _frameStart).count());
+	}
+
+	void SystemScheduler::RunSerial(JobSystem& jobs, double deltaTime)
+	{
+		if (!BuildOrAssert()) return;
+
+		const SystemContext context{jobs, deltaTime};
+		_frameStart = clock::now();
+		for (const SystemId id : _order)
+		{
+			System& system = _systems[id];
+			system.startNs = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - _frameStart).count();
+			system.fn(context);
+			system.endNs = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - _frameStart).count();
+		}
+
+		ComputeStats(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - _frameStart).count());
+	}
+
+	void SystemScheduler::Dispatch(SystemId system)
+	{
+		if (_systems[system].mainThread)
+		{
+			std::lock_guard<std::mutex> lock(_mainThreadMutex);
+			_mainThreadReady.push_back(system);
+			_wake.NotifyOne();
+		}
+		else
+		{
+			_jobs->Schedule([this, system]() { Execute(system); });
+		}
+	}
+
+	void SystemScheduler::Execute(SystemId id)
+	{
+		System& system = _systems[id];
+		system.startNs = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - _frameStart).count();
+		system.fn(SystemContext{*_jobs, _deltaTime});
+		system.endNs = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - _frameStart).count();
+
+		for (const SystemId successor : system.successors)
+		{
+			if (_pending[successor].fetch_sub(1, std::memory_order_acq_rel) == 1) Dispatch(successor);
+		}
+		// Successors are dispatched first, Run can't see zero while work is still being handed out
+		std::lock_guard<std::mutex> lock(_mainThreadMutex);
+		if (--_remaining == 0) _wake.NotifyOne();
+	}
+
+	double SystemScheduler::GetSystemMs(SystemId system) const
+	{
+		return (_systems[system].endNs - _systems[system].startNs) / 1e6;
+	}
+
+	void SystemScheduler::ComputeStats(int64_t frameNs)
+	{
+		// Longest chain of measured durations through the graph, walked in topological order
+		const size_t count = _systems.size();
+		std::vector<int64_t> finish(count, 0);
+		std::vector<SystemId> parent(count, ~0u);
+		int64_t work = 0;
+		SystemId last = ~0u;
+		for (const SystemId id : _order)
+		{
+			const System& system = _systems[id];
+			int64_t start = 0;
+			for (const SystemId predecessor : system.predecessors)
+			{
+				if (finish[predecessor] > start)
+				{
+					start = finish[predecessor];
+					parent[id] = predecessor;
+				}
+			}
+			const int64_t duration = system.endNs - system.startNs;
+			finish[id] = start + duration;
+			work += duration;
+			if (last == ~0u || finish[id] > finish[last]) last = id;
+		}
+
+		_stats.frameMs = frameNs / 1e6;
+		_stats.workMs = work / 1e6;
+		_stats.criticalPathMs = last == ~0u ? 0.0 : finish[last] / 1e6;
+		_stats.criticalPath.clear();
+		for (SystemId id = last; id != ~0u; id = parent[id])
+		{
+			_stats.criticalPath.push_back(id);
+		}
+		std::reverse(_stats.criticalPath.begin(), _stats.criticalPath.end());
+	}
+
+	std::string SystemScheduler::FormatCriticalPath() const
+	{
+		std::string path;
+		for (const SystemId id : _stats.criticalPath)
+		{
+			if (!path.empty()) path += " -> ";
+			path += fmt::format("{} ({:.3f}ms)", _systems[id].name, GetSystemMs(id));
+		}
+		return path;
+	}
+
+} // namespace gefx
@@ -0,0 +1,243 @@
+#ifndef __SCHEDULER__H__
+#define __SCHEDULER__H__
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <core/concurrency/futex.h>
+#include <core/ecs/entity.h>
+#include <core/jobs.h>
+
+namespace gefx
+{
+	class Query;
+
+	using ResourceId = uint32_t;
+	// Non component state shared between systems (GL context, input, ...), one bit per resource type
+	using ResourceMask = uint64_t;
+	static constexpr uint32_t MaxResourceTypes = 64;
+
+	namespace detail
+	{
+		inline ResourceId NextResourceId()
+		{
+			static std::atomic<ResourceId> next{0};
+			const ResourceId id = next.fetch_add(1, std::memory_order_relaxed);
+			assert(id < MaxResourceTypes && "too many resource types");
+			return id;
+		}
+	} // namespace detail
+
+	/**
+	 * @brief Stable id of a resource type, any type can be used as a tag.
+	 */
+	template <typename T>
+	ResourceId resourceId()
+	{
+		static const ResourceId id = detail::NextResourceId();
+		return id;
+	}
+
+	template <typename... Ts>
+	ResourceMask resourceMask()
+	{
+		return (ResourceMask{0} | ... | (ResourceMask{1} << resourceId<Ts>()));
+	}
+
+	/**
+	 * @brief Data a system touches. Two systems conflict when one writes something the other reads or writes.
+	 */
+	struct SystemAccess
+	{
+		ComponentMask read{0};
+		ComponentMask write{0};
+		ResourceMask readResources{0};
+		ResourceMask writeResources{0};
+
+		template <typename... Ts>
+		SystemAccess& Read()
+		{
+			read |= componentMask<Ts...>();
+			return *this;
+		};
+
+		template <typename... Ts>
+		SystemAccess& Write()
+		{
+			write |= componentMask<Ts...>();
+			return *this;
+		};
+
+		template <typename... Ts>
+		SystemAccess& ReadResource()
+		{
+			readResources |= resourceMask<Ts...>();
+			return *this;
+		};
+
+		template <typename... Ts>
+		SystemAccess& WriteResource()
+		{
+			writeResources |= resourceMask<Ts...>();
+			return *this;
+		};
+
+		/**
+		 * @brief Merge the read / write sets of a query the system iterates.
+		 */
+		SystemAccess& Include(const Query& query);
+
+		bool ConflictsWith(const SystemAccess& other) const
+		{
+			return (write & (other.read | other.write)) || (other.write & read) ||
+				   (writeResources & (other.readResources | other.writeResources)) ||
+				   (other.writeResources & readResources);
+		};
+	};
+
+	struct SystemContext
+	{
+		JobSystem& jobs;
+		double deltaTime;
+	};
+
+	/**
+	 * @brief Runs the per-frame systems as a dependency graph on the job system.
+	 *
+	 * Systems conflicting on their access sets run in registration order, everything else is free to overlap;
+	 * explicit ordering constraints come on top of that. The graph is rebuilt only when systems are added and
+	 * its serial (topological) order is deterministic: among ready systems the earliest registered goes first.
+	 * Systems flagged mainThread always run on the thread calling Run (GL calls, window events, ...).
+	 * Each frame is timed per system, GetFrameStats reports the critical path through the graph.
+	 */
+	class SystemScheduler
+	{
+	  public:
+		using SystemId = uint32_t;
+		using SystemFn = std::function<void(const SystemContext&)>;
+
+		struct Conflict
+		{
+			SystemId first;
+			SystemId second;
+			ComponentMask components;
+			ResourceMask resources;
+		};
+
+		struct FrameStats
+		{
+			double frameMs{0.0};
+			// Busy time summed over every system
+			double workMs{0.0};
+			double criticalPathMs{0.0};
+			std::vector<SystemId> criticalPath;
+		};
+
+		SystemScheduler() = default;
+		~SystemScheduler() = default;
+
+		SystemScheduler(SystemScheduler&&) = delete;
+		SystemScheduler(const SystemScheduler&) = delete;
+		SystemScheduler& operator=(SystemScheduler&&) = delete;
+		SystemScheduler& operator=(const SystemScheduler&) = delete;
+
+		SystemId AddSystem(const char* name, const SystemAccess& access, SystemFn fn, bool mainThread = false);
+
+		/**
+		 * @brief Force before to run ahead of after, regardless of their access sets.
+		 */
+		void AddDependency(SystemId before, SystemId after);
+
+		/**
+		 * @brief Build the graph now instead of at the next Run.
+		 *
+		 * @return false if explicit dependencies form a cycle or name systems that don't exist, outError names
+		 * the systems involved. Run and RunSerial do nothing until a later Build succeeds.
+		 */
+		bool Build(std::string& outError);
+
+		/**
+		 * @brief Run every system once and return when all of them are done. The calling thread runs the
+		 * main thread systems and helps with the others meanwhile.
+		 */
+		void Run(JobSystem& jobs, double deltaTime);
+
+		/**
+		 * @brief Run every system on the calling thread in the deterministic serial order, useful to rule out
+		 * missing access declarations while debugging.
+		 */
+		void RunSerial(JobSystem& jobs, double deltaTime);
+
+		size_t GetSystemCount() const { return _systems.size(); };
+		const char* GetName(SystemId system) const { return _systems[system].name.c_str(); };
+		double GetSystemMs(SystemId system) const;
+
+		const std::vector<SystemId>& GetExecutionOrder() const { return _order; };
+		const std::vector<SystemId>& GetSuccessors(SystemId system) const { return _systems[system].successors; };
+		const std::vector<Conflict>& GetConflicts() const { return _conflicts; };
+		const FrameStats& GetFrameStats() const { return _stats; };
+
+		/**
+		 * @brief Human readable critical path of the last frame, "name (ms) -> name (ms) ...".
+		 */
+		std::string FormatCriticalPath() const;
+
+	  private:
+		using clock = std::chrono::steady_clock;
+
+		struct System
+		{
+			std::string name;
+			SystemAccess access;
+			SystemFn fn;
+			bool mainThread;
+			std::vector<SystemId> explicitAfter;
+
+			std::vector<SystemId> successors;
+			std::vector<SystemId> predecessors;
+
+			// Last frame, relative to its start
+			int64_t startNs{0};
+			int64_t endNs{0};
+		};
+
+		/**
+		 * @brief Build if systems changed since the last Build. Returns whether the graph can run.
+		 */
+		bool BuildOrAssert();
+		void Dispatch(SystemId system);
+		void Execute(SystemId system);
+		void ComputeStats(int64_t frameNs);
+
+		std::vector<System> _systems;
+		std::vector<SystemId> _order;
+		std::vector<Conflict> _conflicts;
+		std::vector<std::string> _invalidDependencies;
+		bool _dirty{true};
+		bool _valid{false};
+
+		// Per frame state
+		JobSystem* _jobs{nullptr};
+		double _deltaTime{0.0};
+		clock::time_point _frameStart;
+		std::unique_ptr<std::atomic<uint32_t>[]> _pending;
+		// Run sleeps on _wake until a main thread system is ready or every system is done. Both are changed and
+		// notified under the mutex, so Run can't return while the last system is still notifying
+		std::mutex _mainThreadMutex;
+		uint32_t _remaining{0};
+		std::vector<SystemId> _mainThreadReady;
+		rv::EventCount _wake;
+
+		FrameStats _stats;
+	};
+
+} // namespace gefx
+
+#endif //!__SCHEDULER__H__
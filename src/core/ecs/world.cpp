@@ -0,0 +1,170 @@
+// Application Specific Includes
+#include <core/ecs/world.h>
+
+namespace gefx
+{
+	void Query::Update()
+	{
+		const std::vector<std::unique_ptr<Archetype>>& archetypes = _world._archetypes;
+		const ComponentMask include = GetIncludeMask();
+		for (; _seenArchetypes < archetypes.size(); _seenArchetypes++)
+		{
+			Archetype* archetype = archetypes[_seenArchetypes].get();
+			const ComponentMask mask = archetype->GetMask();
+			if ((mask & include) == include && (mask & _exclude) == 0) _archetypes.push_back(archetype);
+		}
+	}
+
+	World::World()
+	{
+		// Entities without components still need a home
+		GetOrCreateArchetype(0);
+	}
+
+	World::~World()
+	{
+		// Queries reference archetypes, archetypes destroy the components they still hold
+		_queries.clear();
+		_archetypes.clear();
+	}
+
+	bool World::IsAlive(Entity entity) const
+	{
+		const uint32_t index = entity.GetIndex();
+		return !entity.IsNull() && index < _records.size() && _records[index].archetype &&
+			   _records[index].generation == entity.GetGeneration();
+	}
+
+	Entity World::CreateUninitialized(ComponentMask mask)
+	{
+		AssertNotIterating();
+
+		uint32_t index;
+		if (_freeHead != ~0u)
+		{
+			index = _freeHead;
+			_freeHead = _records[index].nextFree;
+		}
+		else
+		{
+			assert(_records.size() < Entity::MaxCount && "entity limit reached");
+			index = static_cast<uint32_t>(_records.size());
+			_records.emplace_back();
+		}
+
+		EntityRecord& record = _records[index];
+		const Entity entity(index, record.generation);
+		record.archetype = GetOrCreateArchetype(mask);
+		record.location = record.archetype->AllocateRow(entity);
+		_aliveCount++;
+		return entity;
+	}
+
+	void World::Destroy(Entity entity)
+	{
+		AssertNotIterating();
+		if (!IsAlive(entity)) return;
+
+		EntityRecord& record = _records[entity.GetIndex()];
+		const Entity moved = record.archetype->RemoveRow(record.location);
+		if (!moved.IsNull()) _records[moved.GetIndex()].location = record.location;
+
+		// Skip generation 0 on wrap-around, it would make null handles look alive
+		const uint32_t next = (record.generation + 1) & ((1u << Entity::GenerationBits) - 1);
+		record.generation = next == 0 ? 1 : next;
+		record.archetype = nullptr;
+		record.nextFree = _freeHead;
+		_freeHead = entity.GetIndex();
+		_aliveCount--;
+	}
+
+	void* World::GetComponentRaw(Entity entity, ComponentId id)
+	{
+		assert(IsAlive(entity));
+		const EntityRecord& record = _records[entity.GetIndex()];
+		return record.archetype->Has(id) ? record.archetype->GetComponent(record.location, id) : nullptr;
+	}
+
+	void* World::AddUninitialized(Entity entity, ComponentId id)
+	{
+		AssertNotIterating();
+		assert(IsAlive(entity));
+
+		EntityRecord& record = _records[entity.GetIndex()];
+		Archetype* source = record.archetype;
+		if (source->Has(id))
+		{
+			// Overwrite in place
+			void* component = source->GetComponent(record.location, id);
+			ComponentRegistry::Get().GetInfo(id).destroy(component);
+			return component;
+		}
+
+		Archetype*& edge = source->_addEdges[id];
+		if (!edge) edge = GetOrCreateArchetype(source->GetMask() | (ComponentMask{1} << id));
+		MoveEntity(entity, edge);
+		return record.archetype->GetComponent(record.location, id);
+	}
+
+	void World::RemoveComponent(Entity entity, ComponentId id)
+	{
+		AssertNotIterating();
+		assert(IsAlive(entity));
+
+		Archetype* source = _records[entity.GetIndex()].archetype;
+		if (!source->Has(id)) return;
+
+		Archetype*& edge = source->_removeEdges[id];
+		if (!edge) edge = GetOrCreateArchetype(source->GetMask() & ~(ComponentMask{1} << id));
+		MoveEntity(entity, edge);
+	}
+
+	void World::MoveEntity(Entity entity, Archetype* target)
+	{
+		EntityRecord& record = _records[entity.GetIndex()];
+		Archetype* source = record.archetype;
+		const Archetype::Location from = record.location;
+		const Archetype::Location to = target->AllocateRow(entity);
+
+		// Shared components move over, the rest is destroyed with the old row
+		const ComponentRegistry& registry = ComponentRegistry::Get();
+		for (const ComponentId id : source->GetComponents())
+		{
+			if (target->Has(id))
+			{
+				registry.GetInfo(id).moveConstruct(target->GetComponent(to, id), source->GetComponent(from, id));
+			}
+		}
+
+		const Entity moved = source->RemoveRow(from);
+		if (!moved.IsNull()) _records[moved.GetIndex()].location = from;
+
+		record.archetype = target;
+		record.location = to;
+	}
+
+	Archetype* World::GetOrCreateArchetype(ComponentMask mask)
+	{
+		auto it = _archetypeByMask.find(mask);
+		if (it != _archetypeByMask.end()) return it->second;
+
+		_archetypes.push_back(std::make_unique<Archetype>(mask));
+		Archetype* archetype = _archetypes.back().get();
+		_archetypeByMask.insert_or_assign(mask, archetype);
+		return archetype;
+	}
+
+	Query& World::GetQuery(ComponentMask read, ComponentMask write, ComponentMask exclude)
+	{
+		for (const std::unique_ptr<Query>& query : _queries)
+		{
+			if (query->GetReadMask() == read && query->GetWriteMask() == write && query->GetExcludeMask() == exclude)
+			{
+				return *query;
+			}
+		}
+		_queries.push_back(std::make_unique<Query>(*this, read, write, exclude));
+		return *_queries.back();
+	}
+
+} // namespace gefx
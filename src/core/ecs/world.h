@@ -0,0 +1,307 @@
+#ifndef __WORLD__H__
+#define __WORLD__H__
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <core/bits.h>
+#include <core/containers/flathashmap.h>
+#include <core/ecs/archetype.h>
+#include <core/ecs/entity.h>
+#include <core/jobs.h>
+
+namespace gefx
+{
+	class World;
+
+	/**
+	 * @brief One chunk seen by a system: a row count plus the component columns, indexed by row.
+	 */
+	class ChunkView
+	{
+	  public:
+		ChunkView(const Archetype* archetype, uint32_t chunk) : _archetype(archetype), _chunk(chunk){};
+
+		uint32_t Count() const { return _archetype->GetChunkEntityCount(_chunk); };
+		const Entity* Entities() const { return _archetype->GetEntities(_chunk); };
+
+		template <typename T>
+		bool Has() const
+		{
+			return _archetype->Has(componentId<T>());
+		};
+
+		/**
+		 * @brief Column of component T, Count() elements long. Use a const T for read only access.
+		 */
+		template <typename T>
+		T* Column() const
+		{
+			assert(Has<T>() && "component not present in this chunk");
+			return static_cast<T*>(_archetype->GetColumn(_chunk, componentId<T>()));
+		};
+
+	  private:
+		const Archetype* _archetype;
+		uint32_t _chunk;
+	};
+
+	/**
+	 * @brief Cached set of archetypes owning every included component and none of the excluded ones. Archetypes
+	 * are never destroyed, so the cache only has to pick up the ones created since its last use.
+	 * Component constness in GetQuery<Ts...> is recorded as read vs write access.
+	 */
+	class Query
+	{
+	  public:
+		Query(World& world, ComponentMask read, ComponentMask write, ComponentMask exclude)
+			: _world(world), _read(read), _write(write), _exclude(exclude){};
+
+		Query(Query&&) = delete;
+		Query(const Query&) = delete;
+		Query& operator=(Query&&) = delete;
+		Query& operator=(const Query&) = delete;
+
+		ComponentMask GetIncludeMask() const { return _read | _write; };
+		ComponentMask GetReadMask() const { return _read; };
+		ComponentMask GetWriteMask() const { return _write; };
+		ComponentMask GetExcludeMask() const { return _exclude; };
+
+		size_t Count();
+
+		template <typename F>
+		void ForEachChunk(F&& fn);
+
+		/**
+		 * @brief Run fn(ChunkView) for every chunk on the job system, one chunk per job batch.
+		 */
+		template <typename F>
+		void ParallelForEachChunk(JobSystem& jobs, F&& fn);
+
+		/**
+		 * @brief fn(Ts&...) for every entity, walking the columns linearly.
+		 */
+		template <typename... Ts, typename F>
+		void Each(F&& fn)
+		{
+			ForEachChunk([&fn](const ChunkView& chunk) { EachInChunk<Ts...>(chunk, fn); });
+		};
+
+		template <typename... Ts, typename F>
+		void ParallelEach(JobSystem& jobs, F&& fn)
+		{
+			ParallelForEachChunk(jobs, [&fn](const ChunkView& chunk) { EachInChunk<Ts...>(chunk, fn); });
+		};
+
+	  private:
+		template <typename... Ts, typename F>
+		static void EachInChunk(const ChunkView& chunk, F& fn)
+		{
+			const std::tuple<Ts*...> columns{chunk.Column<Ts>()...};
+			const uint32_t count = chunk.Count();
+			for (uint32_t row = 0; row < count; row++)
+			{
+				fn(std::get<Ts*>(columns)[row]...);
+			}
+		};
+
+		void Update();
+
+		World& _world;
+		ComponentMask _read;
+		ComponentMask _write;
+		ComponentMask _exclude;
+		std::vector<Archetype*> _archetypes;
+		size_t _seenArchetypes{0};
+
+		struct ChunkRef
+		{
+			Archetype* archetype;
+			uint32_t chunk;
+		};
+		std::vector<ChunkRef> _chunkRefs;
+	};
+
+	/**
+	 * @brief Entity storage. Entities are generational handles, each entity lives in the archetype matching
+	 * its exact component set and moves to another archetype when a component is added or removed.
+	 * Structural changes (create, destroy, add, remove) must not happen while iterating a query; record them
+	 * in a CommandBuffer instead and play it back afterwards.
+	 */
+	class World
+	{
+	  public:
+		World();
+		~World();
+
+		World(World&&) = delete;
+		World(const World&) = delete;
+		World& operator=(World&&) = delete;
+		World& operator=(const World&) = delete;
+
+		template <typename... Ts>
+		Entity Create(Ts&&... components)
+		{
+			const ComponentMask mask = componentMask<Ts...>();
+			assert(rv::popCount(mask) == sizeof...(Ts) && "duplicated component type");
+			const Entity entity = CreateUninitialized(mask);
+			(new (GetComponentRaw(entity, componentId<Ts>())) std::decay_t<Ts>(std::forward<Ts>(components)), ...);
+			return entity;
+		};
+
+		void Destroy(Entity entity);
+		bool IsAlive(Entity entity) const;
+		size_t GetEntityCount() const { return _aliveCount; };
+
+		template <typename T>
+		bool Has(Entity entity) const
+		{
+			assert(IsAlive(entity));
+			return _records[entity.GetIndex()].archetype->Has(componentId<T>());
+		};
+
+		/**
+		 * @brief Component of a live entity, nullptr if it doesn't have one.
+		 */
+		template <typename T>
+		T* Get(Entity entity)
+		{
+			assert(IsAlive(entity));
+			const ComponentId id = componentId<T>();
+			const EntityRecord& record = _records[entity.GetIndex()];
+			return record.archetype->Has(id) ? static_cast<T*>(record.archetype->GetComponent(record.location, id))
+											 : nullptr;
+		};
+
+		/**
+		 * @brief Add (or overwrite) a component, moving the entity to its new archetype.
+		 */
+		template <typename T>
+		std::decay_t<T>& Add(Entity entity, T&& value)
+		{
+			using Type = std::decay_t<T>;
+			return *new (AddUninitialized(entity, componentId<Type>())) Type(std::forward<T>(value));
+		};
+
+		template <typename T>
+		void Remove(Entity entity)
+		{
+			RemoveComponent(entity, componentId<T>());
+		};
+
+		/**
+		 * @brief Cached query over entities owning Ts and no component in exclude. const Ts are read only.
+		 */
+		template <typename... Ts>
+		Query& GetQuery(ComponentMask exclude = 0)
+		{
+			const ComponentMask read = (ComponentMask{0} | ... | (std::is_const_v<Ts> ? componentMask<Ts>() : 0));
+			const ComponentMask write = (ComponentMask{0} | ... | (std::is_const_v<Ts> ? 0 : componentMask<Ts>()));
+			return GetQuery(read, write, exclude);
+		};
+
+		Query& GetQuery(ComponentMask read, ComponentMask write, ComponentMask exclude);
+
+		template <typename... Ts, typename F>
+		void Each(F&& fn)
+		{
+			GetQuery<Ts...>().template Each<Ts...>(std::forward<F>(fn));
+		};
+
+		// Raw, type erased access used by command buffers
+		Entity CreateUninitialized(ComponentMask mask);
+		void* GetComponentRaw(Entity entity, ComponentId id);
+		void* AddUninitialized(Entity entity, ComponentId id);
+		void RemoveComponent(Entity entity, ComponentId id);
+
+		const std::vector<std::unique_ptr<Archetype>>& GetArchetypes() const { return _archetypes; };
+
+	  private:
+		struct EntityRecord
+		{
+			Archetype* archetype{nullptr};
+			Archetype::Location location{0, 0};
+			// Generation of the current occupant, or of the next one while on the free list
+			uint32_t generation{1};
+			uint32_t nextFree{0};
+		};
+
+		Archetype* GetOrCreateArchetype(ComponentMask mask);
+		void MoveEntity(Entity entity, Archetype* target);
+		void AssertNotIterating() const
+		{
+			assert(_iterating.load(std::memory_order_relaxed) == 0 && "structural change while iterating");
+		};
+
+		std::vector<EntityRecord> _records;
+		uint32_t _freeHead{~0u};
+		size_t _aliveCount{0};
+
+		std::vector<std::unique_ptr<Archetype>> _archetypes;
+		rv::FlatHashMap<ComponentMask, Archetype*> _archetypeByMask;
+		std::vector<std::unique_ptr<Query>> _queries;
+		std::atomic<uint32_t> _iterating{0};
+
+		friend class Query;
+	};
+
+	inline size_t Query::Count()
+	{
+		Update();
+		size_t count = 0;
+		for (const Archetype* archetype : _archetypes)
+		{
+			count += archetype->GetEntityCount();
+		}
+		return count;
+	}
+
+	template <typename F>
+	void Query::ForEachChunk(F&& fn)
+	{
+		Update();
+		_world._iterating.fetch_add(1, std::memory_order_relaxed);
+		for (const Archetype* archetype : _archetypes)
+		{
+			const uint32_t chunkCount = archetype->GetChunkCount();
+			for (uint32_t chunk = 0; chunk < chunkCount; chunk++)
+			{
+				fn(ChunkView(archetype, chunk));
+			}
+		}
+		_world._iterating.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	template <typename F>
+	void Query::ParallelForEachChunk(JobSystem& jobs, F&& fn)
+	{
+		Update();
+		_chunkRefs.clear();
+		for (Archetype* archetype : _archetypes)
+		{
+			const uint32_t chunkCount = archetype->GetChunkCount();
+			for (uint32_t chunk = 0; chunk < chunkCount; chunk++)
+			{
+				_chunkRefs.push_back(ChunkRef{archetype, chunk});
+			}
+		}
+
+		_world._iterating.fetch_add(1, std::memory_order_relaxed);
+		jobs.ParallelFor(static_cast<uint32_t>(_chunkRefs.size()), 1, [this, &fn](uint32_t begin, uint32_t end) {
+			for (uint32_t i = begin; i < end; i++)
+			{
+				fn(ChunkView(_chunkRefs[i].archetype, _chunkRefs[i].chunk));
+			}
+		});
+		_world._iterating.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+} // namespace gefx
+
+#endif //!__WORLD__H__
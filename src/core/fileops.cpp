@@ -0,0 +1,266 @@
+// StdLib Includes
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <memory>
+
+// Platform Includes
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+// Application Specific Includes
+#include <core/fileops.h>
+#include <core/jobs.h>
+
+namespace rv
+{
+	// Bytes moved per kernel call, also the progress reporting granularity
+	static constexpr uint64_t CopyChunkSize = 8ull << 20;
+	// User space buffer of the last resort read/write loop
+	static constexpr size_t FallbackBufferSize = 1ull << 20;
+
+#if defined(_WIN32)
+	struct CopyProgressContext
+	{
+		const CopyProgressCallback* progress;
+	};
+
+	static DWORD CALLBACK OnCopyProgress(LARGE_INTEGER totalSize, LARGE_INTEGER transferred, LARGE_INTEGER, LARGE_INTEGER,
+					     DWORD, DWORD, HANDLE, HANDLE, LPVOID data)
+	{
+		const CopyProgressContext* ctx = static_cast<const CopyProgressContext*>(data);
+		(*ctx->progress)(static_cast<uint64_t>(transferred.QuadPart), static_cast<uint64_t>(totalSize.QuadPart));
+		return PROGRESS_CONTINUE;
+	}
+
+	bool copyFile(const std::string& srcPath, const std::string& destPath, const CopyProgressCallback& progress)
+	{
+		CopyProgressContext ctx{&progress};
+		return CopyFileExA(srcPath.c_str(), destPath.c_str(), progress ? OnCopyProgress : nullptr, &ctx, nullptr,
+				   0) != 0;
+	}
+
+	bool moveFile(const std::string& srcPath, const std::string& destPath)
+	{
+		return MoveFileExA(srcPath.c_str(), destPath.c_str(), MOVEFILE_COPY_ALLOWED | MOVEFILE_REPLACE_EXISTING) != 0;
+	}
+#else
+	// Closes the descriptor when leaving scope
+	struct ScopedFd
+	{
+		int fd;
+		explicit ScopedFd(int fd) : fd(fd){};
+		~ScopedFd()
+		{
+			if (fd >= 0) close(fd);
+		};
+	};
+
+	enum class CopyStatus
+	{
+		Done,
+		Unsupported,
+		Failed
+	};
+
+#if defined(__linux__)
+	static CopyStatus tryReflink(int srcFd, int destFd)
+	{
+#if defined(FICLONE)
+		if (ioctl(destFd, FICLONE, srcFd) == 0) return CopyStatus::Done;
+#endif
+		return CopyStatus::Unsupported;
+	}
+
+	static ssize_t copyRange(int srcFd, int destFd, size_t len)
+	{
+#if defined(SYS_copy_file_range)
+		return syscall(SYS_copy_file_range, srcFd, nullptr, destFd, nullptr, len, 0u);
+#else
+		errno = ENOSYS;
+		return -1;
+#endif
+	}
+
+	static bool isUnsupportedError(int error)
+	{
+		return error == ENOSYS || error == EXDEV || error == EINVAL || error == EOPNOTSUPP || error == EBADF;
+	}
+
+	static CopyStatus tryCopyFileRange(int srcFd, int destFd, uint64_t size, uint64_t& copied,
+					   const CopyProgressCallback& progress)
+	{
+		while (copied < size)
+		{
+			const size_t len = static_cast<size_t>(std::min(CopyChunkSize, size - copied));
+			const ssize_t result = copyRange(srcFd, destFd, len);
+			if (result < 0)
+			{
+				if (errno == EINTR) continue;
+				// Only fall back when nothing was written yet, otherwise offsets are already advanced
+				return copied == 0 && isUnsupportedError(errno) ? CopyStatus::Unsupported : CopyStatus::Failed;
+			}
+			if (result == 0) break;
+			copied += static_cast<uint64_t>(result);
+			if (progress) progress(copied, size);
+		}
+		return copied == size ? CopyStatus::Done : CopyStatus::Failed;
+	}
+
+	static CopyStatus trySendFile(int srcFd, int destFd, uint64_t size, uint64_t& copied,
+				      const CopyProgressCallback& progress)
+	{
+		while (copied < size)
+		{
+			const size_t len = static_cast<size_t>(std::min(CopyChunkSize, size - copied));
+			const ssize_t result = sendfile(destFd, srcFd, nullptr, len);
+			if (result < 0)
+			{
+				if (errno == EINTR) continue;
+				return copied == 0 && isUnsupportedError(errno) ? CopyStatus::Unsupported : CopyStatus::Failed;
+			}
+			if (result == 0) break;
+			copied += static_cast<uint64_t>(result);
+			if (progress) progress(copied, size);
+		}
+		return copied == size ? CopyStatus::Done : CopyStatus::Failed;
+	}
+#endif
+
+	static CopyStatus copyChunked(int srcFd, int destFd, uint64_t size, uint64_t& copied,
+				      const CopyProgressCallback& progress)
+	{
+		std::unique_ptr<char[]> buffer(new char[FallbackBufferSize]);
+		while (true)
+		{
+			const ssize_t readBytes = read(srcFd, buffer.get(), FallbackBufferSize);
+			if (readBytes < 0)
+			{
+				if (errno == EINTR) continue;
+				return CopyStatus::Failed;
+			}
+			if (readBytes == 0) break;
+
+			ssize_t written = 0;
+			while (written < readBytes)
+			{
+				const ssize_t result = write(destFd, buffer.get() + written, static_cast<size_t>(readBytes - written));
+				if (result < 0)
+				{
+					if (errno == EINTR) continue;
+					return CopyStatus::Failed;
+				}
+				written += result;
+			}
+
+			copied += static_cast<uint64_t>(readBytes);
+			if (progress) progress(copied, size);
+		}
+		return CopyStatus::Done;
+	}
+
+	bool copyFile(const std::string& srcPath, const std::string& destPath, const CopyProgressCallback& progress)
+	{
+		ScopedFd src(open(srcPath.c_str(), O_RDONLY | O_CLOEXEC));
+		if (src.fd < 0) return false;
+
+		struct stat st;
+		if (fstat(src.fd, &st) != 0 || !S_ISREG(st.st_mode)) return false;
+
+		// Copying a file onto itself (or a hard link of it) would truncate the source before reading it
+		struct stat destSt;
+		if (stat(destPath.c_str(), &destSt) == 0 && destSt.st_dev == st.st_dev && destSt.st_ino == st.st_ino)
+		{
+			return false;
+		}
+
+		ScopedFd dest(open(destPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, st.st_mode & 0777));
+		if (dest.fd < 0) return false;
+
+		const uint64_t size = static_cast<uint64_t>(st.st_size);
+		uint64_t copied = 0;
+		CopyStatus status = CopyStatus::Unsupported;
+
+#if defined(__linux__)
+		status = tryReflink(src.fd, dest.fd);
+		if (status == CopyStatus::Done)
+		{
+			if (progress) progress(size, size);
+			return true;
+		}
+
+		status = tryCopyFileRange(src.fd, dest.fd, size, copied, progress);
+		if (status == CopyStatus::Unsupported) status = trySendFile(src.fd, dest.fd, size, copied, progress);
+#endif
+		if (status == CopyStatus::Unsupported) status = copyChunked(src.fd, dest.fd, size, copied, progress);
+
+		if (status == CopyStatus::Done && size == 0 && progress) progress(0, 0);
+		return status == CopyStatus::Done;
+	}
+
+	bool moveFile(const std::string& srcPath, const std::string& destPath)
+	{
+		if (rename(srcPath.c_str(), destPath.c_str()) == 0) return true;
+		if (errno != EXDEV) return false;
+
+		// Different file systems, copy and delete the source
+		if (!copyFile(srcPath, destPath)) return false;
+		return unlink(srcPath.c_str()) == 0;
+	}
+#endif
+
+	uint32_t copyFiles(gefx::JobSystem& jobs, const std::vector<CopyRequest>& requests, BatchCopyProgress* progress)
+	{
+		std::atomic<uint32_t> failures{0};
+
+		if (progress)
+		{
+			uint64_t total = 0;
+			for (const CopyRequest& request : requests)
+			{
+				struct stat st;
+				if (stat(request.srcPath.c_str(), &st) == 0) total += static_cast<uint64_t>(st.st_size);
+			}
+			progress->bytesTotal.fetch_add(total, std::memory_order_relaxed);
+		}
+
+		jobs.ParallelFor(static_cast<uint32_t>(requests.size()), 1, [&](uint32_t begin, uint32_t end) {
+			for (uint32_t i = begin; i < end; i++)
+			{
+				uint64_t reported = 0;
+				CopyProgressCallback callback;
+				if (progress)
+				{
+					callback = [progress, &reported](uint64_t done, uint64_t) {
+						progress->bytesDone.fetch_add(done - reported, std::memory_order_relaxed);
+						reported = done;
+					};
+				}
+
+				const bool success = copyFile(requests[i].srcPath, requests[i].destPath, callback);
+				if (!success) failures.fetch_add(1, std::memory_order_relaxed);
+				if (progress)
+				{
+					(success ? progress->filesDone : progress->filesFailed).fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+		});
+
+		return failures.load();
+	}
+
+} // namespace rv
@@ -0,0 +1,73 @@
+#ifndef __FILEOPS__H__
+#define __FILEOPS__H__
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace gefx
+{
+	class JobSystem;
+}
+
+namespace rv
+{
+	/**
+	 * @brief Called as a copy advances, bytesTotal is the source file size.
+	 */
+	using CopyProgressCallback = std::function<void(uint64_t bytesDone, uint64_t bytesTotal)>;
+
+	/**
+	 * @brief Copy a file without routing its bytes through user space when the platform allows it.
+	 * Tries, in order: reflink (FICLONE), copy_file_range, sendfile and finally a chunked read/write loop.
+	 * On Windows CopyFileEx is used. The destination is created or truncated, copying a file onto itself fails.
+	 *
+	 * @param srcPath Source file path.
+	 * @param destPath Destination file path.
+	 * @param progress Optional progress callback.
+	 * @return bool Whether the whole file was copied.
+	 */
+	bool copyFile(const std::string& srcPath, const std::string& destPath, const CopyProgressCallback& progress = {});
+
+	/**
+	 * @brief Move a file, renaming when possible and falling back to copy + delete across devices.
+	 *
+	 * @param srcPath Source file path.
+	 * @param destPath Destination file path.
+	 * @return bool Whether the file was moved.
+	 */
+	bool moveFile(const std::string& srcPath, const std::string& destPath);
+
+	struct CopyRequest
+	{
+		std::string srcPath;
+		std::string destPath;
+	};
+
+	/**
+	 * @brief Aggregated progress of a batch copy, safe to poll from any thread while the batch runs.
+	 */
+	struct BatchCopyProgress
+	{
+		std::atomic<uint64_t> bytesDone{0};
+		std::atomic<uint64_t> bytesTotal{0};
+		std::atomic<uint32_t> filesDone{0};
+		std::atomic<uint32_t> filesFailed{0};
+	};
+
+	/**
+	 * @brief Copy a list of files in parallel on the job system. Blocks until every copy is done.
+	 *
+	 * @param jobs Job system running the copies.
+	 * @param requests Files to copy.
+	 * @param progress Optional progress, updated as each copy advances.
+	 * @return uint32_t Number of failed copies.
+	 */
+	uint32_t copyFiles(gefx::JobSystem& jobs, const std::vector<CopyRequest>& requests,
+			   BatchCopyProgress* progress = nullptr);
+
+} // namespace rv
+
+#endif //!__FILEOPS__H__
@@ -1,18 +1,35 @@
 #ifndef __IAPP__H__
 #define __IAPP__H__
 
+#include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include <core/concurrency/futex.h>
 
 namespace gefx
 {
+	/**
+	 * @brief Application loop. Update simulates a frame and leaves what rendering needs in a render snapshot,
+	 * Render submits a snapshot.
+	 *
+	 * Without a render thread both run one after the other on the main thread. With renderThread set before
+	 * Run starts, a render thread calls Render for frame N while the main thread polls input and simulates
+	 * frame N + 1 and on. The main thread runs at most framesAhead frames ahead of the last one rendered,
+	 * which bounds the latency between input and the frame showing it. Snapshots go round robin, one for
+	 * each frame in flight plus the one being written: two, double buffered, for the default of one frame
+	 * ahead.
+	 */
 	class IApp
 	{
 		using highResClock = std::chrono::high_resolution_clock;
 
 	  public:
 		constexpr explicit IApp(const char* name)
-			: name(name), sleeping(false), deltaTime(0.016), shouldSleep(false), shouldWakeUp(true),
-			  shouldQuit(false){};
+			: shouldSleep(false), shouldWakeUp(true), shouldQuit(false), renderThread(false), framesAhead(1),
+			  name(name), sleeping(false), deltaTime(0.016), _simulatedFrames(0), _renderedFrames(0),
+			  _renderWake(0), _stopRendering(false){};
 		virtual ~IApp() = default;
 
 		void Run();
@@ -25,25 +42,71 @@ namespace gefx
 		IApp& operator=(const IApp&) = delete;
 
 	  protected:
+		/**
+		 * @brief Sets shouldQuit when it fails. Run then goes straight to Shutdown, which must cope with
+		 * whatever part of Setup didn't happen.
+		 */
 		virtual void Setup() = 0;
 		virtual void Awake() = 0;
 		virtual void Update(double deltaTime) = 0;
+		virtual void Render(uint32_t snapshot) = 0;
 		virtual void Sleep() = 0;
 		virtual void Shutdown() = 0;
 
+		/**
+		 * @brief Called on the render thread before its first and after its last Render, to take and give
+		 * back the graphics context.
+		 */
+		virtual void RenderThreadStart(){};
+		virtual void RenderThreadStop(){};
+
+		uint32_t GetSnapshotCount() const { return framesAhead + 1; };
+
+		/**
+		 * @brief Snapshot the frame being simulated writes, Render gets it once the frame is done.
+		 */
+		uint32_t GetUpdateSnapshot() const
+		{
+			return _simulatedFrames.load(std::memory_order_relaxed) % GetSnapshotCount();
+		};
+
 		bool shouldSleep;
 		bool shouldWakeUp;
 		bool shouldQuit;
+		// Read once Setup returns
+		bool renderThread;
+		uint32_t framesAhead;
 
 	  private:
+		void RenderLoop();
+
 		const char* name;
 		bool sleeping;
 		double deltaTime;
+
+		// Frames published by the main thread and frames the render thread is done with
+		std::atomic<uint32_t> _simulatedFrames;
+		std::atomic<uint32_t> _renderedFrames;
+		// Bumped whenever the render thread has something new to look at, a frame or the stop
+		std::atomic<uint32_t> _renderWake;
+		std::atomic<bool> _stopRendering;
 	};
 
 	inline void IApp::Run()
 	{
 		Setup();
+		if (shouldQuit)
+		{
+			Shutdown();
+			return;
+		}
+
+		std::thread renderer;
+		if (renderThread)
+		{
+			renderer = std::thread(&IApp::RenderLoop, this);
+		}
+
 		while (!shouldQuit)
 		{
 			if (sleeping)
@@ -68,14 +131,69 @@ namespace gefx
 			}
 
 			highResClock::time_point start = highResClock::now();
+			const uint32_t frame = _simulatedFrames.load(std::memory_order_relaxed);
+			if (renderThread)
+			{
+				// Wait for the render thread to catch up, which also frees this frame's snapshot
+				uint32_t rendered = _renderedFrames.load(std::memory_order_acquire);
+				while (frame - rendered > framesAhead)
+				{
+					rv::futexWait(_renderedFrames, rendered);
+					rendered = _renderedFrames.load(std::memory_order_acquire);
+				}
+			}
+
 			Update(deltaTime);
+			if (renderThread)
+			{
+				_simulatedFrames.store(frame + 1, std::memory_order_release);
+				_renderWake.fetch_add(1, std::memory_order_release);
+				rv::futexWakeOne(_renderWake);
+			}
+			else
+			{
+				Render(frame % GetSnapshotCount());
+				_simulatedFrames.store(frame + 1, std::memory_order_relaxed);
+				_renderedFrames.store(frame + 1, std::memory_order_relaxed);
+			}
 			highResClock::time_point stop = highResClock::now();
 
 			using ms = std::chrono::duration<double>;
 			deltaTime = std::chrono::duration_cast<ms>(stop - start).count();
 		}
+
+		if (renderer.joinable())
+		{
+			// The frames already simulated are still rendered
+			_stopRendering.store(true, std::memory_order_release);
+			_renderWake.fetch_add(1, std::memory_order_release);
+			rv::futexWakeOne(_renderWake);
+			renderer.join();
+		}
 		Shutdown();
 	}
+
+	inline void IApp::RenderLoop()
+	{
+		RenderThreadStart();
+		for (;;)
+		{
+			// Read before looking, so whatever comes after changes it and the wait returns
+			const uint32_t wake = _renderWake.load(std::memory_order_acquire);
+			const uint32_t rendered = _renderedFrames.load(std::memory_order_relaxed);
+			if (rendered == _simulatedFrames.load(std::memory_order_acquire))
+			{
+				if (_stopRendering.load(std::memory_order_acquire)) break;
+				rv::futexWait(_renderWake, wake);
+				continue;
+			}
+
+			Render(rendered % GetSnapshotCount());
+			_renderedFrames.store(rendered + 1, std::memory_order_release);
+			rv::futexWakeOne(_renderedFrames);
+		}
+		RenderThreadStop();
+	}
 } // namespace gefx
 
-#endif //!__IAPP__H__
\ No newline at end of file
+#endif //!__IAPP__H__
@@ -0,0 +1,134 @@
+// StdLib Includes
+#include <cassert>
+
+// Application Specific Includes
+#include <core/jobs.h>
+
+namespace gefx
+{
+	namespace
+	{
+		thread_local uint32_t threadIndex = 0;
+	} // namespace
+
+	JobSystem::JobSystem(uint32_t workerCount, uint32_t queueCapacity) : _queue(queueCapacity)
+	{
+		if (workerCount == 0)
+		{
+			const uint32_t hwThreads = std::thread::hardware_concurrency();
+			workerCount = hwThreads > 1 ? hwThreads - 1 : 1;
+		}
+
+		_workers.reserve(workerCount);
+		for (uint32_t i = 0; i < workerCount; i++)
+		{
+			_workers.emplace_back(&JobSystem::WorkerLoop, this, i + 1);
+		}
+	}
+
+	JobSystem::~JobSystem()
+	{
+		_queue.Close();
+		for (std::thread& worker : _workers)
+		{
+			worker.join();
+		}
+	}
+
+	void JobSystem::Schedule(Job job, JobCounter* counter)
+	{
+		if (counter) counter->_pending.fetch_add(1, std::memory_order_relaxed);
+
+		QueuedJob queued{std::move(job), counter};
+		// Queue full, drain some work ourselves instead of sleeping
+		while (!_queue.TryPush(std::move(queued)))
+		{
+			if (!TryRunOne()) std::this_thread::yield();
+		}
+		// A thread sleeping in Wait may have to run it, its own wait could depend on it
+		_activity.NotifyOne();
+	}
+
+	bool JobSystem::TryRunOne()
+	{
+		QueuedJob queued;
+		if (!_queue.TryPop(queued)) return false;
+
+		Run(queued);
+		return true;
+	}
+
+	void JobSystem::Wait(const JobCounter& counter)
+	{
+		while (!counter.IsDone())
+		{
+			if (TryRunOne()) continue;
+
+			// Nothing to help with, sleep until a job is scheduled or a counter reaches zero. Checking again
+			// after taking the ticket catches whatever happened in between
+			const uint32_t ticket = _activity.PrepareWait();
+			QueuedJob queued;
+			if (counter.IsDone())
+			{
+				_activity.CancelWait();
+				break;
+			}
+			if (_queue.TryPop(queued))
+			{
+				_activity.CancelWait();
+				Run(queued);
+				continue;
+			}
+			_activity.Wait(ticket);
+		}
+	}
+
+	void JobSystem::Run(QueuedJob& queued)
+	{
+		queued.job();
+		queued.job = nullptr;
+		if (queued.counter && queued.counter->_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			_activity.NotifyAll();
+		}
+	}
+
+	uint32_t JobSystem::GetThreadIndex()
+	{
+		return threadIndex;
+	}
+
+	bool JobSystem::AttachThread()
+	{
+		assert(threadIndex == 0 && "thread already has an index");
+		for (uint32_t slot = 0; slot < MaxAttachedThreads; slot++)
+		{
+			const uint32_t bit = 1u << slot;
+			if ((_attached.fetch_or(bit, std::memory_order_relaxed) & bit) == 0)
+			{
+				threadIndex = GetWorkerCount() + 1 + slot;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void JobSystem::DetachThread()
+	{
+		const uint32_t first = GetWorkerCount() + 1;
+		assert(threadIndex >= first && threadIndex < GetThreadCount() && "thread not attached");
+		_attached.fetch_and(~(1u << (threadIndex - first)), std::memory_order_relaxed);
+		threadIndex = 0;
+	}
+
+	void JobSystem::WorkerLoop(uint32_t index)
+	{
+		threadIndex = index;
+		QueuedJob queued;
+		while (_queue.Pop(queued))
+		{
+			Run(queued);
+		}
+	}
+
+} // namespace gefx
@@ -0,0 +1,145 @@
+#ifndef __JOBS__H__
+#define __JOBS__H__
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include <core/concurrency/blockingqueue.h>
+#include <core/concurrency/futex.h>
+#include <core/concurrency/mpmcqueue.h>
+
+namespace gefx
+{
+	/**
+	 * @brief Completion counter shared by a group of jobs. Incremented on schedule, decremented when a job ends.
+	 */
+	class JobCounter
+	{
+	  public:
+		JobCounter() = default;
+		JobCounter(JobCounter&&) = delete;
+		JobCounter(const JobCounter&) = delete;
+		JobCounter& operator=(JobCounter&&) = delete;
+		JobCounter& operator=(const JobCounter&) = delete;
+
+		bool IsDone() const { return _pending.load(std::memory_order_acquire) == 0; };
+		uint32_t GetPending() const { return _pending.load(std::memory_order_acquire); };
+
+	  private:
+		std::atomic<uint32_t> _pending{0};
+
+		friend class JobSystem;
+	};
+
+	/**
+	 * @brief Fixed pool of worker threads consuming a shared lock-free job queue. Idle workers sleep on a futex.
+	 * Threads waiting on a counter (or scheduling into a full queue) help executing queued jobs instead of
+	 * blocking, so nested waits from inside jobs don't deadlock.
+	 */
+	class JobSystem
+	{
+	  public:
+		using Job = std::function<void()>;
+
+		/**
+		 * @brief Spawn the worker threads.
+		 *
+		 * @param workerCount Number of workers, 0 picks hardware_concurrency - 1 (at least one).
+		 * @param queueCapacity Bounded job queue size.
+		 */
+		explicit JobSystem(uint32_t workerCount = 0, uint32_t queueCapacity = 4096);
+		~JobSystem();
+
+		JobSystem(JobSystem&&) = delete;
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(JobSystem&&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+
+		static constexpr uint32_t MaxAttachedThreads = 2;
+
+		uint32_t GetWorkerCount() const { return static_cast<uint32_t>(_workers.size()); };
+
+		/**
+		 * @brief Per-thread data slots to size for: index 0, the workers and the attached threads.
+		 */
+		uint32_t GetThreadCount() const { return GetWorkerCount() + 1 + MaxAttachedThreads; };
+
+		/**
+		 * @brief Index of the calling thread for per-thread data: 1 + worker index on the pool's workers, the
+		 * slots after them on attached threads, 0 on any other thread. Values stay below GetThreadCount().
+		 */
+		static uint32_t GetThreadIndex();
+
+		/**
+		 * @brief Give the calling thread an index of its own until DetachThread. Every thread left at 0
+		 * shares its per-thread data, so a second thread using it while the main thread helps with jobs (the
+		 * render thread) must attach. False when the MaxAttachedThreads slots are taken.
+		 */
+		bool AttachThread();
+		void DetachThread();
+
+		void Schedule(Job job, JobCounter* counter = nullptr);
+
+		/**
+		 * @brief Block until the counter reaches zero, executing queued jobs meanwhile and sleeping when there
+		 * are none.
+		 */
+		void Wait(const JobCounter& counter);
+
+		/**
+		 * @brief Pop and run one queued job if there is any. Lets a thread with its own work to poll for
+		 * (main thread only tasks, ...) help the workers instead of blocking in Wait.
+		 */
+		bool TryRunOne();
+
+		/**
+		 * @brief Split [0, count) in batches of batchSize and run fn(begin, end) on each of them in parallel.
+		 * The calling thread takes part in the work and the call returns once every batch is done.
+		 */
+		template <typename F>
+		void ParallelFor(uint32_t count, uint32_t batchSize, const F& fn)
+		{
+			if (count == 0) return;
+			if (batchSize == 0) batchSize = 1;
+			if (count <= batchSize || _workers.empty())
+			{
+				fn(0u, count);
+				return;
+			}
+
+			JobCounter counter;
+			for (uint32_t begin = batchSize; begin < count; begin += batchSize)
+			{
+				const uint32_t end = begin + batchSize < count ? begin + batchSize : count;
+				Schedule([&fn, begin, end]() { fn(begin, end); }, &counter);
+			}
+			// First batch runs inline
+			fn(0u, batchSize);
+			Wait(counter);
+		};
+
+	  private:
+		struct QueuedJob
+		{
+			Job job;
+			JobCounter* counter{nullptr};
+		};
+
+		void WorkerLoop(uint32_t index);
+		// Run a popped job and count it done
+		void Run(QueuedJob& queued);
+
+		rv::BlockingQueue<rv::MPMCQueue<QueuedJob>> _queue;
+		// Wakes Wait: notified when a job is scheduled and when a counter reaches zero
+		rv::EventCount _activity;
+		std::vector<std::thread> _workers;
+		// Bit per attached thread slot
+		std::atomic<uint32_t> _attached{0};
+	};
+
+} // namespace gefx
+
+#endif //!__JOBS__H__
@@ -0,0 +1,467 @@
+// StdLib Includes
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <exception>
+
+// Platform Includes
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// Application Specific Includes
+#include <core/bits.h>
+#include <core/log.h>
+
+namespace gefx
+{
+	namespace
+	{
+		// Records are 16 byte aligned, so a header always fits before the end of the ring
+		constexpr uint32_t RecordAlign = 16;
+		constexpr uint8_t PaddingRecord = 0xFF;
+
+		struct RecordHeader
+		{
+			uint32_t size;
+			uint8_t level;
+			uint8_t reserved[3];
+			uint64_t timestamp;
+		};
+		static_assert(sizeof(RecordHeader) == RecordAlign, "record header must match the record alignment");
+
+		const char* LevelName(uint8_t level)
+		{
+			static const char* const names[] = {"TRACE", "DEBUG", "INFO ", "WARN ", "ERROR", "FATAL"};
+			return level < sizeof(names) / sizeof(names[0]) ? names[level] : "?????";
+		}
+
+		uint64_t NowNs()
+		{
+			using namespace std::chrono;
+			return static_cast<uint64_t>(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count());
+		}
+
+		void WriteDescriptor(int descriptor, const char* data, size_t size)
+		{
+			while (size > 0)
+			{
+#if defined(_WIN32)
+				const int written = _write(descriptor, data, static_cast<unsigned int>(size));
+#else
+				const ssize_t written = write(descriptor, data, size);
+#endif
+				if (written < 0)
+				{
+					if (errno == EINTR) continue;
+					return;
+				}
+				data += written;
+				size -= static_cast<size_t>(written);
+			}
+		}
+
+		// Same prefix as WriteBatch ("[{:12.6f}] [T{:02}] [{}] "), formatted by hand for signal handlers
+		size_t FormatPrefix(char* out, uint64_t timestamp, uint32_t thread, uint8_t level)
+		{
+			char digits[24];
+			size_t count = 0;
+			uint64_t micros = (timestamp + 500) / 1000;
+			for (int i = 0; i < 6; i++, micros /= 10)
+			{
+				digits[count++] = static_cast<char>('0' + micros % 10);
+			}
+			digits[count++] = '.';
+			do
+			{
+				digits[count++] = static_cast<char>('0' + micros % 10);
+				micros /= 10;
+			} while (micros > 0);
+
+			size_t size = 0;
+			out[size++] = '[';
+			for (size_t pad = count; pad < 12; pad++) out[size++] = ' ';
+			while (count > 0) out[size++] = digits[--count];
+
+			std::memcpy(out + size, "] [T", 4);
+			size += 4;
+			do
+			{
+				digits[count++] = static_cast<char>('0' + thread % 10);
+				thread /= 10;
+			} while (thread > 0);
+			if (count < 2) out[size++] = '0';
+			while (count > 0) out[size++] = digits[--count];
+
+			std::memcpy(out + size, "] [", 3);
+			size += 3;
+			std::memcpy(out + size, LevelName(level), 5);
+			size += 5;
+			std::memcpy(out + size, "] ", 2);
+			return size + 2;
+		}
+
+		void OnCrashSignal(int signal)
+		{
+			Logger::Get().FlushFromSignal();
+			std::signal(signal, SIG_DFL);
+			std::raise(signal);
+		}
+
+		void OnTerminate()
+		{
+			Logger::Get().FlushFromCrash();
+			std::abort();
+		}
+	} // namespace
+
+	/**
+	 * @brief SPSC byte ring owned by one producing thread. head is only written by the producer, tail only by
+	 * the writer, and each side sits on its own cache line.
+	 */
+	struct Logger::ThreadBuffer
+	{
+		ThreadBuffer(uint32_t capacity, uint32_t index)
+			: data(new char[capacity]), capacity(capacity), mask(capacity - 1), threadIndex(index){};
+
+		std::unique_ptr<char[]> data;
+		const uint32_t capacity;
+		const uint32_t mask;
+		const uint32_t threadIndex;
+
+		alignas(rv::CacheLineSize) std::atomic<uint64_t> head{0};
+		uint64_t cachedTail{0};
+
+		alignas(rv::CacheLineSize) std::atomic<uint64_t> tail{0};
+		// Set when the owning thread exits, the writer frees the ring once it is drained
+		std::atomic<bool> retired{false};
+	};
+
+	struct Logger::BatchEntry
+	{
+		uint64_t timestamp;
+		uint32_t textOffset;
+		uint32_t textSize;
+		uint32_t threadIndex;
+		uint8_t level;
+	};
+
+	namespace
+	{
+		struct ThreadBufferRef
+		{
+			std::atomic<bool>* retired{nullptr};
+			void* buffer{nullptr};
+
+			~ThreadBufferRef()
+			{
+				if (retired) retired->store(true, std::memory_order_release);
+			}
+		};
+
+		thread_local ThreadBufferRef t_threadBuffer;
+	} // namespace
+
+	Logger::Logger() : _startTime(NowNs()) {}
+
+	Logger::~Logger() { Stop(); }
+
+	void Logger::Start(const LoggerConfig& config)
+	{
+		if (_running.load(std::memory_order_acquire)) return;
+
+		_threadBufferSize = static_cast<uint32_t>(rv::nextPowerOfTwo(std::max(config.threadBufferSize, 4096u)));
+		_console = config.console;
+		if (config.filePath) _file = std::fopen(config.filePath, "w");
+#if defined(_WIN32)
+		_fileDescriptor = _file ? _fileno(_file) : -1;
+#else
+		_fileDescriptor = _file ? fileno(_file) : -1;
+#endif
+
+		if (config.installCrashHandlers)
+		{
+			for (const int signal : {SIGSEGV, SIGABRT, SIGFPE, SIGILL})
+			{
+				std::signal(signal, OnCrashSignal);
+			}
+			std::set_terminate(OnTerminate);
+		}
+
+		_running.store(true, std::memory_order_release);
+		_writer = std::thread(&Logger::WriterLoop, this);
+	}
+
+	void Logger::Stop()
+	{
+		if (!_running.exchange(false, std::memory_order_acq_rel)) return;
+
+		_wake.NotifyAll();
+		_writer.join();
+		Flush();
+
+		if (_file)
+		{
+			_fileDescriptor = -1;
+			std::fclose(_file);
+			_file = nullptr;
+		}
+	}
+
+	void Logger::Flush()
+	{
+		std::lock_guard<std::mutex> drainLock(_drainMutex);
+		DrainAll(true);
+	}
+
+	void Logger::FlushFromCrash()
+	{
+		// The crashing thread may already hold one of these, so never block on them. Without the drain lock the
+		// batch buffers are someone else's, draining into them anyway would corrupt the output being written
+		if (!_drainMutex.try_lock()) return;
+		DrainAll(false);
+		_drainMutex.unlock();
+	}
+
+	void Logger::FlushFromSignal()
+	{
+		if (!_drainMutex.try_lock()) return;
+		if (!_buffersMutex.try_lock())
+		{
+			_drainMutex.unlock();
+			return;
+		}
+
+		// Batches are flushed as they are written, so the sinks hold nothing that would come out after this
+		auto emit = [this](const char* data, size_t size) {
+			if (_console) WriteDescriptor(1, data, size);
+			if (_fileDescriptor >= 0) WriteDescriptor(_fileDescriptor, data, size);
+		};
+
+		for (const std::unique_ptr<ThreadBuffer>& buffer : _buffers)
+		{
+			const char* data = buffer->data.get();
+			uint64_t tail = buffer->tail.load(std::memory_order_relaxed);
+			const uint64_t head = buffer->head.load(std::memory_order_acquire);
+			while (tail != head)
+			{
+				const uint32_t offset = static_cast<uint32_t>(tail) & buffer->mask;
+				RecordHeader header;
+				std::memcpy(&header, data + offset, sizeof(header));
+				if (header.level == PaddingRecord)
+				{
+					tail += buffer->capacity - offset;
+					continue;
+				}
+
+				char prefix[64];
+				emit(prefix, FormatPrefix(prefix, header.timestamp, buffer->threadIndex, header.level));
+				emit(data + offset + sizeof(header), header.size);
+				emit("\n", 1);
+				tail += rv::alignUp(sizeof(header) + header.size, RecordAlign);
+			}
+			buffer->tail.store(tail, std::memory_order_release);
+		}
+
+		_buffersMutex.unlock();
+		_drainMutex.unlock();
+	}
+
+	Logger::ThreadBuffer& Logger::GetThreadBuffer()
+	{
+		if (t_threadBuffer.buffer) return *static_cast<ThreadBuffer*>(t_threadBuffer.buffer);
+
+		const uint32_t index = _nextThreadIndex.fetch_add(1, std::memory_order_relaxed);
+		std::unique_ptr<ThreadBuffer> buffer = std::make_unique<ThreadBuffer>(_threadBufferSize, index);
+		ThreadBuffer* raw = buffer.get();
+		{
+			std::lock_guard<std::mutex> lock(_buffersMutex);
+			_buffers.push_back(std::move(buffer));
+		}
+		t_threadBuffer.buffer = raw;
+		t_threadBuffer.retired = &raw->retired;
+		return *raw;
+	}
+
+	void Logger::Submit(LogLevel level, std::string_view message)
+	{
+		while (!message.empty() && message.back() == '\n')
+		{
+			message.remove_suffix(1);
+		}
+
+		if (!_running.load(std::memory_order_acquire))
+		{
+			const ThreadBuffer* local = static_cast<ThreadBuffer*>(t_threadBuffer.buffer);
+			const uint32_t thread = local ? local->threadIndex : 0;
+			std::lock_guard<std::mutex> drainLock(_drainMutex);
+			WriteDirect(level, thread, message);
+			return;
+		}
+
+		ThreadBuffer& buffer = GetThreadBuffer();
+
+		// Oversized messages get truncated so a single record never takes more than a quarter of the ring
+		const uint32_t maxPayload = buffer.capacity / 4 - sizeof(RecordHeader);
+		const uint32_t size = static_cast<uint32_t>(std::min<size_t>(message.size(), maxPayload));
+		const uint32_t recordSize = static_cast<uint32_t>(rv::alignUp(sizeof(RecordHeader) + size, RecordAlign));
+
+		const uint64_t head = buffer.head.load(std::memory_order_relaxed);
+		const uint32_t offset = static_cast<uint32_t>(head) & buffer.mask;
+		const uint32_t contiguous = buffer.capacity - offset;
+		const uint32_t padding = recordSize > contiguous ? contiguous : 0;
+		const uint64_t needed = padding + recordSize;
+
+		while (head + needed - buffer.cachedTail > buffer.capacity)
+		{
+			buffer.cachedTail = buffer.tail.load(std::memory_order_acquire);
+			if (head + needed - buffer.cachedTail <= buffer.capacity) break;
+
+			// Ring full, kick the writer and back off until it drains
+			_wake.NotifyOne();
+			std::this_thread::yield();
+		}
+
+		char* data = buffer.data.get();
+		uint32_t writeOffset = offset;
+		if (padding)
+		{
+			RecordHeader pad{};
+			pad.level = PaddingRecord;
+			std::memcpy(data + writeOffset, &pad, sizeof(pad));
+			writeOffset = 0;
+		}
+
+		RecordHeader header{};
+		header.size = size;
+		header.level = static_cast<uint8_t>(level);
+		header.timestamp = NowNs() - _startTime;
+		std::memcpy(data + writeOffset, &header, sizeof(header));
+		std::memcpy(data + writeOffset + sizeof(header), message.data(), size);
+
+		buffer.head.store(head + needed, std::memory_order_release);
+		_wake.NotifyOne();
+
+		if (level == LogLevel::Fatal) Flush();
+	}
+
+	void Logger::WriterLoop()
+	{
+		while (true)
+		{
+			const uint32_t ticket = _wake.PrepareWait();
+			size_t drained;
+			{
+				std::lock_guard<std::mutex> drainLock(_drainMutex);
+				drained = DrainAll(true);
+			}
+			if (drained > 0 || !_running.load(std::memory_order_acquire))
+			{
+				_wake.CancelWait();
+				if (drained == 0) break;
+				continue;
+			}
+			_wake.Wait(ticket);
+		}
+	}
+
+	size_t Logger::DrainAll(bool lockBuffers)
+	{
+		std::unique_lock<std::mutex> buffersLock(_buffersMutex, std::defer_lock);
+		if (lockBuffers)
+			buffersLock.lock();
+		else if (!buffersLock.try_lock())
+			return 0;
+
+		_batch.clear();
+		_batchText.clear();
+
+		for (size_t i = 0; i < _buffers.size();)
+		{
+			ThreadBuffer& buffer = *_buffers[i];
+			// Read before draining: once retired is seen every record of that thread is visible too
+			const bool retired = buffer.retired.load(std::memory_order_acquire);
+
+			const char* data = buffer.data.get();
+			uint64_t tail = buffer.tail.load(std::memory_order_relaxed);
+			const uint64_t head = buffer.head.load(std::memory_order_acquire);
+			while (tail != head)
+			{
+				const uint32_t offset = static_cast<uint32_t>(tail) & buffer.mask;
+				RecordHeader header;
+				std::memcpy(&header, data + offset, sizeof(header));
+				if (header.level == PaddingRecord)
+				{
+					tail += buffer.capacity - offset;
+					continue;
+				}
+
+				BatchEntry entry;
+				entry.timestamp = header.timestamp;
+				entry.textOffset = static_cast<uint32_t>(_batchText.size());
+				entry.textSize = header.size;
+				entry.threadIndex = buffer.threadIndex;
+				entry.level = header.level;
+				_batch.push_back(entry);
+				_batchText.insert(_batchText.end(), data + offset + sizeof(header), data + offset + sizeof(header) + header.size);
+
+				tail += rv::alignUp(sizeof(header) + header.size, RecordAlign);
+			}
+			buffer.tail.store(tail, std::memory_order_release);
+
+			if (retired)
+			{
+				_buffers[i] = std::move(_buffers.back());
+				_buffers.pop_back();
+				continue;
+			}
+			i++;
+		}
+		buffersLock.unlock();
+
+		const size_t count = _batch.size();
+		if (count > 0) WriteBatch();
+		return count;
+	}
+
+	void Logger::WriteBatch()
+	{
+		// Rings are drained one after the other, restore the global order
+		std::stable_sort(_batch.begin(), _batch.end(),
+						 [](const BatchEntry& a, const BatchEntry& b) { return a.timestamp < b.timestamp; });
+
+		_output.clear();
+		for (const BatchEntry& entry : _batch)
+		{
+			fmt::format_to(_output, FMT_STRING("[{:12.6f}] [T{:02}] [{}] "), entry.timestamp * 1e-9, entry.threadIndex,
+						   LevelName(entry.level));
+			_output.append(_batchText.data() + entry.textOffset, _batchText.data() + entry.textOffset + entry.textSize);
+			_output.push_back('\n');
+		}
+
+		if (_console)
+		{
+			std::fwrite(_output.data(), 1, _output.size(), stdout);
+			std::fflush(stdout);
+		}
+		if (_file)
+		{
+			std::fwrite(_output.data(), 1, _output.size(), _file);
+			std::fflush(_file);
+		}
+	}
+
+	void Logger::WriteDirect(LogLevel level, uint32_t thread, std::string_view message)
+	{
+		_batch.clear();
+		_batchText.assign(message.begin(), message.end());
+		_batch.push_back(BatchEntry{NowNs() - _startTime, 0, static_cast<uint32_t>(message.size()), thread,
+									static_cast<uint8_t>(level)});
+		WriteBatch();
+	}
+
+} // namespace gefx
@@ -0,0 +1,171 @@
+#ifndef __LOG__H__
+#define __LOG__H__
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <core/concurrency/futex.h>
+
+// Messages below this level are removed at compile time (0 Trace, 1 Debug, 2 Info, 3 Warning, 4 Error, 5 Fatal)
+#ifndef GEFX_LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define GEFX_LOG_MIN_LEVEL 2
+#else
+#define GEFX_LOG_MIN_LEVEL 0
+#endif
+#endif
+
+// The format string is validated against the arguments at compile time through FMT_STRING
+#define GEFX_LOG(level, format, ...)                                                                          \
+	do                                                                                                         \
+	{                                                                                                          \
+		if constexpr (level >= static_cast<::gefx::LogLevel>(GEFX_LOG_MIN_LEVEL))                              \
+		{                                                                                                      \
+			::gefx::Logger::Get().Write(level, FMT_STRING(format), ##__VA_ARGS__);                             \
+		}                                                                                                      \
+	} while (false)
+
+#define GEFX_LOG_TRACE(format, ...) GEFX_LOG(::gefx::LogLevel::Trace, format, ##__VA_ARGS__)
+#define GEFX_LOG_DEBUG(format, ...) GEFX_LOG(::gefx::LogLevel::Debug, format, ##__VA_ARGS__)
+#define GEFX_LOG_INFO(format, ...) GEFX_LOG(::gefx::LogLevel::Info, format, ##__VA_ARGS__)
+#define GEFX_LOG_WARNING(format, ...) GEFX_LOG(::gefx::LogLevel::Warning, format, ##__VA_ARGS__)
+#define GEFX_LOG_ERROR(format, ...) GEFX_LOG(::gefx::LogLevel::Error, format, ##__VA_ARGS__)
+#define GEFX_LOG_FATAL(format, ...) GEFX_LOG(::gefx::LogLevel::Fatal, format, ##__VA_ARGS__)
+
+namespace gefx
+{
+	enum class LogLevel : uint8_t
+	{
+		Trace,
+		Debug,
+		Info,
+		Warning,
+		Error,
+		Fatal
+	};
+
+	struct LoggerConfig
+	{
+		// Optional log file, truncated on Start
+		const char* filePath{nullptr};
+		bool console{true};
+		// Per thread staging ring size in bytes (rounded up to a power of two)
+		uint32_t threadBufferSize{64 * 1024};
+		// Flush staged messages on SIGSEGV/SIGABRT/SIGFPE/SIGILL and std::terminate
+		bool installCrashHandlers{true};
+	};
+
+	/**
+	 * @brief Asynchronous logger. Every producing thread formats into its own lock-free SPSC byte ring and
+	 * returns, a background writer drains all rings, orders the messages by timestamp and writes them to the
+	 * sinks in batches with one flush per batch. Fatal messages and crashes flush synchronously.
+	 * Before Start (and after Stop) messages are written directly instead.
+	 */
+	class Logger
+	{
+	  public:
+		static Logger& Get()
+		{
+			static Logger logger;
+			return logger;
+		};
+
+		Logger(Logger&&) = delete;
+		Logger(const Logger&) = delete;
+		Logger& operator=(Logger&&) = delete;
+		Logger& operator=(const Logger&) = delete;
+
+		void Start(const LoggerConfig& config = {});
+
+		/**
+		 * @brief Write out everything staged and join the writer thread.
+		 */
+		void Stop();
+
+		/**
+		 * @brief Block until every message staged before the call is written to the sinks.
+		 */
+		void Flush();
+
+		void SetLevel(LogLevel level) { _level.store(static_cast<uint8_t>(level), std::memory_order_relaxed); };
+		bool IsEnabled(LogLevel level) const
+		{
+			return static_cast<uint8_t>(level) >= _level.load(std::memory_order_relaxed);
+		};
+
+		template <typename S, typename... Args>
+		void Write(LogLevel level, const S& format, const Args&... args)
+		{
+			if (!IsEnabled(level)) return;
+
+			fmt::memory_buffer message;
+			fmt::format_to(message, format, args...);
+			Submit(level, std::string_view(message.data(), message.size()));
+		};
+
+		/**
+		 * @brief Stage an already formatted message. A trailing newline is added by the logger.
+		 */
+		void Submit(LogLevel level, std::string_view message);
+
+		/**
+		 * @brief Best effort flush used from the terminate handler. Gives up instead of waiting when another thread is
+		 * draining or registering a buffer, whatever that thread was writing is lost with the crash.
+		 */
+		void FlushFromCrash();
+
+		/**
+		 * @brief Crash flush for signal handlers. Staged records are written ring by ring with write(2), their
+		 * text as it was formatted by the producer, nothing is formatted with fmt or allocated. Gives up under
+		 * the same conditions as FlushFromCrash.
+		 */
+		void FlushFromSignal();
+
+	  private:
+		Logger();
+		~Logger();
+
+		struct ThreadBuffer;
+		struct BatchEntry;
+
+		ThreadBuffer& GetThreadBuffer();
+		void WriterLoop();
+		size_t DrainAll(bool lockBuffers);
+		void WriteBatch();
+		void WriteDirect(LogLevel level, uint32_t thread, std::string_view message);
+
+		std::atomic<bool> _running{false};
+		std::atomic<uint8_t> _level{0};
+		uint32_t _threadBufferSize{64 * 1024};
+		uint64_t _startTime{0};
+
+		std::mutex _buffersMutex;
+		std::vector<std::unique_ptr<ThreadBuffer>> _buffers;
+		std::atomic<uint32_t> _nextThreadIndex{0};
+
+		// Held while draining and writing so batches reach the sinks whole and in order
+		std::mutex _drainMutex;
+		std::vector<BatchEntry> _batch;
+		std::vector<char> _batchText;
+		fmt::memory_buffer _output;
+
+		std::FILE* _file{nullptr};
+		// Descriptor of _file for FlushFromSignal, -1 without a file
+		int _fileDescriptor{-1};
+		bool _console{true};
+
+		rv::EventCount _wake;
+		std::thread _writer;
+	};
+
+} // namespace gefx
+
+#endif //!__LOG__H__
@@ -0,0 +1,178 @@
+// StdLib Includes
+#include <cstring>
+#include <memory>
+
+// Application Specific Includes
+#include <core/lz.h>
+
+namespace rv
+{
+	static constexpr size_t MinMatch = 4;
+	static constexpr size_t MaxOffset = 0xFFFF;
+	static constexpr uint32_t HashBits = 14;
+
+	static inline uint32_t read32(const uint8_t* ptr)
+	{
+		uint32_t value;
+		memcpy(&value, ptr, sizeof(value));
+		return value;
+	}
+
+	static inline uint32_t hashSequence(uint32_t sequence) { return (sequence * 2654435761u) >> (32 - HashBits); }
+
+	// Write the 255-run extension of a length that didn't fit its token nibble
+	static inline bool writeLength(uint8_t*& op, const uint8_t* oend, size_t length)
+	{
+		while (length >= 255)
+		{
+			if (op >= oend) return false;
+			*op++ = 255;
+			length -= 255;
+		}
+		if (op >= oend) return false;
+		*op++ = static_cast<uint8_t>(length);
+		return true;
+	}
+
+	static inline bool writeSequence(uint8_t*& op, const uint8_t* oend, const uint8_t* literals, size_t litLength,
+					 size_t offset, size_t matchLength)
+	{
+		if (op >= oend) return false;
+		uint8_t* token = op++;
+		*token = 0;
+
+		if (litLength >= 15)
+		{
+			*token = 15 << 4;
+			if (!writeLength(op, oend, litLength - 15)) return false;
+		}
+		else
+		{
+			*token = static_cast<uint8_t>(litLength << 4);
+		}
+
+		if (static_cast<size_t>(oend - op) < litLength) return false;
+		memcpy(op, literals, litLength);
+		op += litLength;
+
+		// Last sequence only carries literals
+		if (matchLength == 0) return true;
+
+		if (oend - op < 2) return false;
+		*op++ = static_cast<uint8_t>(offset & 0xFF);
+		*op++ = static_cast<uint8_t>(offset >> 8);
+
+		const size_t matchCode = matchLength - MinMatch;
+		if (matchCode >= 15)
+		{
+			*token |= 15;
+			if (!writeLength(op, oend, matchCode - 15)) return false;
+		}
+		else
+		{
+			*token |= static_cast<uint8_t>(matchCode);
+		}
+		return true;
+	}
+
+	size_t lzCompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity)
+	{
+		std::unique_ptr<uint32_t[]> table(new uint32_t[1u << HashBits]());
+
+		uint8_t* op = dst;
+		const uint8_t* oend = dst + dstCapacity;
+		size_t anchor = 0;
+		size_t ip = 0;
+
+		while (ip + MinMatch <= srcSize)
+		{
+			const uint32_t sequence = read32(src + ip);
+			const uint32_t hash = hashSequence(sequence);
+			const size_t ref = table[hash];
+			table[hash] = static_cast<uint32_t>(ip);
+
+			if (ref < ip && ip - ref <= MaxOffset && read32(src + ref) == sequence)
+			{
+				size_t length = MinMatch;
+				while (ip + length < srcSize && src[ref + length] == src[ip + length])
+				{
+					length++;
+				}
+
+				if (!writeSequence(op, oend, src + anchor, ip - anchor, ip - ref, length)) return 0;
+				ip += length;
+				anchor = ip;
+			}
+			else
+			{
+				ip++;
+			}
+		}
+
+		if (!writeSequence(op, oend, src + anchor, srcSize - anchor, 0, 0)) return 0;
+		return static_cast<size_t>(op - dst);
+	}
+
+	// Read the 255-run extension of a length nibble
+	static inline bool readLength(const uint8_t*& ip, const uint8_t* iend, size_t& length)
+	{
+		uint8_t byte;
+		do
+		{
+			if (ip >= iend) return false;
+			byte = *ip++;
+			length += byte;
+		} while (byte == 255);
+		return true;
+	}
+
+	bool lzDecompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize)
+	{
+		const uint8_t* ip = src;
+		const uint8_t* iend = src + srcSize;
+		uint8_t* op = dst;
+		uint8_t* oend = dst + dstSize;
+
+		while (ip < iend)
+		{
+			const uint8_t token = *ip++;
+
+			size_t litLength = token >> 4;
+			if (litLength == 15 && !readLength(ip, iend, litLength)) return false;
+			if (static_cast<size_t>(iend - ip) < litLength || static_cast<size_t>(oend - op) < litLength) return false;
+			memcpy(op, ip, litLength);
+			ip += litLength;
+			op += litLength;
+
+			if (ip == iend) break;
+
+			if (iend - ip < 2) return false;
+			const size_t offset = static_cast<size_t>(ip[0]) | (static_cast<size_t>(ip[1]) << 8);
+			ip += 2;
+			if (offset == 0 || offset > static_cast<size_t>(op - dst)) return false;
+
+			size_t matchLength = token & 15;
+			if (matchLength == 15 && !readLength(ip, iend, matchLength)) return false;
+			matchLength += MinMatch;
+			if (static_cast<size_t>(oend - op) < matchLength) return false;
+
+			const uint8_t* match = op - offset;
+			if (offset >= matchLength)
+			{
+				memcpy(op, match, matchLength);
+				op += matchLength;
+			}
+			else
+			{
+				// Overlapping copy replicates the last offset bytes
+				for (size_t i = 0; i < matchLength; i++)
+				{
+					*op++ = *match++;
+				}
+			}
+		}
+
+		return op == oend;
+	}
+
+} // namespace rv
@@ -0,0 +1,40 @@
+#ifndef __LZ__H__
+#define __LZ__H__
+
+#include <cstddef>
+#include <cstdint>
+
+namespace rv
+{
+	/**
+	 * @brief Worst case compressed size for an input of srcSize bytes.
+	 */
+	constexpr size_t lzCompressBound(size_t srcSize) { return srcSize + srcSize / 255 + 16; }
+
+	/**
+	 * @brief Compress a buffer with the in-tree LZ77 byte codec (LZ4 style sequences: token, literals,
+	 * 16-bit offset, match length). Greedy single-probe matcher, tuned for decompression speed.
+	 *
+	 * @param src Input data.
+	 * @param srcSize Input size.
+	 * @param dst Output buffer.
+	 * @param dstCapacity Output buffer size, lzCompressBound(srcSize) always suffices.
+	 * @return size_t Compressed size, 0 if dst was too small.
+	 */
+	size_t lzCompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity);
+
+	/**
+	 * @brief Decompress a buffer produced by lzCompress. Every read and write is bounds checked, so corrupt
+	 * input fails instead of overrunning.
+	 *
+	 * @param src Compressed data.
+	 * @param srcSize Compressed size.
+	 * @param dst Output buffer.
+	 * @param dstSize Exact decompressed size.
+	 * @return bool Whether exactly dstSize bytes were decoded.
+	 */
+	bool lzDecompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize);
+
+} // namespace rv
+
+#endif //!__LZ__H__
@@ -0,0 +1,214 @@
+// StdLib Includes
+#include <algorithm>
+#include <cmath>
+
+// Application Specific Includes
+#include <core/bits.h>
+#include <core/math/frustum.h>
+#include <core/math/simd.h>
+
+namespace rv
+{
+	namespace
+	{
+		// Frustum planes splatted across lanes
+		template <typename V>
+		struct PlaneLanes
+		{
+			V nx[6], ny[6], nz[6], d[6];
+			// |normal| components, for box extents
+			V ax[6], ay[6], az[6];
+
+			explicit PlaneLanes(const Frustum& frustum)
+			{
+				for (int p = 0; p < 6; p++)
+				{
+					const glm::vec4& plane = frustum.planes[p];
+					nx[p] = V::Set(plane.x);
+					ny[p] = V::Set(plane.y);
+					nz[p] = V::Set(plane.z);
+					d[p] = V::Set(plane.w);
+					ax[p] = V::Set(std::fabs(plane.x));
+					ay[p] = V::Set(std::fabs(plane.y));
+					az[p] = V::Set(std::fabs(plane.z));
+				}
+			}
+		};
+
+		// Append base + i for every bit i of mask to out, returns how many were written. May write up to 8
+		// indices past the returned count, callers only compact at positions they already consumed.
+		template <typename V>
+		uint32_t Compact(unsigned mask, uint32_t base, uint32_t* out)
+		{
+			uint32_t count = 0;
+			while (mask)
+			{
+				out[count++] = base + countTrailingZeros(static_cast<uint32_t>(mask));
+				mask &= mask - 1;
+			}
+			return count;
+		}
+
+#if RV_SIMD_AVX2
+		// Lane indices of every 8 bit mask packed as nibbles, lowest set bit first
+		struct CompactTable
+		{
+			uint32_t packed[256];
+
+			constexpr CompactTable() : packed()
+			{
+				for (uint32_t mask = 0; mask < 256; mask++)
+				{
+					uint32_t slot = 0;
+					for (uint32_t bit = 0; bit < 8; bit++)
+					{
+						if (mask & (1u << bit)) packed[mask] |= bit << (4 * slot++);
+					}
+				}
+			}
+		};
+		constexpr CompactTable compactTable;
+
+		template <>
+		uint32_t Compact<Float8>(unsigned mask, uint32_t base, uint32_t* out)
+		{
+			// Unpack the nibbles into lanes and store all 8, only the first popCount of them matter
+			const __m256i shifts = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+			const __m256i lanes = _mm256_and_si256(
+				_mm256_srlv_epi32(_mm256_set1_epi32(static_cast<int>(compactTable.packed[mask])), shifts),
+				_mm256_set1_epi32(0xF));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(out),
+								_mm256_add_epi32(lanes, _mm256_set1_epi32(static_cast<int>(base))));
+			return popCount(mask);
+		}
+#endif
+
+		template <typename V>
+		size_t CullSpheresLanes(const Frustum& frustum, const SphereSoA& spheres, size_t& i, size_t end,
+								uint32_t* out)
+		{
+			const PlaneLanes<V> planes(frustum);
+			const V zero = V::Set(0.0f);
+			size_t count = 0;
+			for (; i + V::Width <= end; i += V::Width)
+			{
+				const V cx = V::Load(&spheres.centerX[i]);
+				const V cy = V::Load(&spheres.centerY[i]);
+				const V cz = V::Load(&spheres.centerZ[i]);
+				const V r = V::Load(&spheres.radius[i]);
+
+				// Smallest signed distance + radius over the 6 planes, negative means fully outside one of them
+				const auto planeDistance = [&](int p) {
+					return MulAdd(planes.nx[p], cx,
+								  MulAdd(planes.ny[p], cy, MulAdd(planes.nz[p], cz, planes.d[p] + r)));
+				};
+				V distance = planeDistance(0);
+				for (int p = 1; p < 6; p++)
+				{
+					distance = Min(distance, planeDistance(p));
+				}
+				count += Compact<V>(GreaterEqualMask(distance, zero), static_cast<uint32_t>(i), out + count);
+			}
+			return count;
+		}
+
+		template <typename V>
+		size_t CullBoundsLanes(const Frustum& frustum, const BoundsSoA& bounds, size_t& i, size_t end, uint32_t* out)
+		{
+			const PlaneLanes<V> planes(frustum);
+			const V zero = V::Set(0.0f);
+			size_t count = 0;
+			for (; i + V::Width <= end; i += V::Width)
+			{
+				const V cx = V::Load(&bounds.centerX[i]);
+				const V cy = V::Load(&bounds.centerY[i]);
+				const V cz = V::Load(&bounds.centerZ[i]);
+				const V ex = V::Load(&bounds.extentX[i]);
+				const V ey = V::Load(&bounds.extentY[i]);
+				const V ez = V::Load(&bounds.extentZ[i]);
+
+				V distance = zero;
+				for (int p = 0; p < 6; p++)
+				{
+					// Box projected radius on the plane normal
+					const V r = MulAdd(planes.ax[p], ex, MulAdd(planes.ay[p], ey, planes.az[p] * ez));
+					const V d =
+						MulAdd(planes.nx[p], cx, MulAdd(planes.ny[p], cy, MulAdd(planes.nz[p], cz, planes.d[p] + r)));
+					distance = p == 0 ? d : Min(distance, d);
+				}
+				count += Compact<V>(GreaterEqualMask(distance, zero), static_cast<uint32_t>(i), out + count);
+			}
+			return count;
+		}
+	} // namespace
+
+	Frustum Frustum::FromMatrix(const glm::mat4& viewProj)
+	{
+		// glm is column major, row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+		const auto row = [&viewProj](int i) {
+			return glm::vec4(viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i]);
+		};
+		const glm::vec4 r0 = row(0), r1 = row(1), r2 = row(2), r3 = row(3);
+
+		Frustum frustum;
+		frustum.planes[0] = r3 + r0;
+		frustum.planes[1] = r3 - r0;
+		frustum.planes[2] = r3 + r1;
+		frustum.planes[3] = r3 - r1;
+		frustum.planes[4] = r3 + r2;
+		frustum.planes[5] = r3 - r2;
+		for (glm::vec4& plane : frustum.planes)
+		{
+			plane /= glm::length(glm::vec3(plane));
+		}
+		return frustum;
+	}
+
+	void SphereSoA::Resize(size_t count)
+	{
+		for (std::vector<float>* array : {&centerX, &centerY, &centerZ, &radius})
+		{
+			array->resize(count, 0.0f);
+		}
+	}
+
+	void SphereSoA::Set(size_t index, const glm::vec3& center, float r)
+	{
+		centerX[index] = center.x;
+		centerY[index] = center.y;
+		centerZ[index] = center.z;
+		radius[index] = r;
+	}
+
+	void computeWorldSpheres(const glm::mat4* matrices, size_t begin, size_t end, const glm::vec3& localCenter,
+							 float localRadius, SphereSoA& out)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			const glm::mat4& m = matrices[i];
+			const glm::vec3 center = glm::vec3(m * glm::vec4(localCenter, 1.0f));
+			const float scale2 = std::max({glm::dot(glm::vec3(m[0]), glm::vec3(m[0])),
+										   glm::dot(glm::vec3(m[1]), glm::vec3(m[1])),
+										   glm::dot(glm::vec3(m[2]), glm::vec3(m[2]))});
+			out.Set(i, center, localRadius * std::sqrt(scale2));
+		}
+	}
+
+	size_t cullSpheres(const Frustum& frustum, const SphereSoA& spheres, size_t begin, size_t end,
+					   uint32_t* outVisible)
+	{
+		size_t i = begin;
+		size_t count = CullSpheresLanes<FloatV>(frustum, spheres, i, end, outVisible);
+		count += CullSpheresLanes<Float1>(frustum, spheres, i, end, outVisible + count);
+		return count;
+	}
+
+	size_t cullBounds(const Frustum& frustum, const BoundsSoA& bounds, size_t begin, size_t end, uint32_t* outVisible)
+	{
+		size_t i = begin;
+		size_t count = CullBoundsLanes<FloatV>(frustum, bounds, i, end, outVisible);
+		count += CullBoundsLanes<Float1>(frustum, bounds, i, end, outVisible + count);
+		return count;
+	}
+
+} // namespace rv
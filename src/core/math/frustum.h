@@ -0,0 +1,83 @@
+#ifndef __FRUSTUM__H__
+#define __FRUSTUM__H__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <core/math/transform.h>
+
+namespace rv
+{
+	/**
+	 * @brief Six inward facing planes (xyz = unit normal, w = distance) of a view projection, in the order left,
+	 * right, bottom, top, near, far. A point p is inside when dot(xyz, p) + w >= 0 for every plane.
+	 */
+	struct Frustum
+	{
+		glm::vec4 planes[6];
+
+		/**
+		 * @brief Gribb / Hartmann extraction, expects the GL clip volume (-w <= z <= w). Works in whatever space
+		 * the matrix maps from: world space for viewProj, object space for a full model-view-projection.
+		 */
+		static Frustum FromMatrix(const glm::mat4& viewProj);
+
+		bool TestSphere(const glm::vec3& center, float radius) const
+		{
+			for (const glm::vec4& plane : planes)
+			{
+				if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) return false;
+			}
+			return true;
+		};
+
+		bool TestBounds(const glm::vec3& center, const glm::vec3& extent) const
+		{
+			for (const glm::vec4& plane : planes)
+			{
+				const float radius = glm::dot(glm::abs(glm::vec3(plane)), extent);
+				if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) return false;
+			}
+			return true;
+		};
+	};
+
+	/**
+	 * @brief Bounding spheres as structure of arrays.
+	 */
+	struct SphereSoA
+	{
+		std::vector<float> centerX, centerY, centerZ, radius;
+
+		size_t Size() const { return centerX.size(); };
+		void Resize(size_t count);
+		void Set(size_t index, const glm::vec3& center, float r);
+	};
+
+	/**
+	 * @brief World spheres of one local sphere instanced by matrices [begin, end), out[begin, end) must exist.
+	 * The radius is scaled by the largest axis scale, so the result stays conservative under non uniform scale.
+	 */
+	void computeWorldSpheres(const glm::mat4* matrices, size_t begin, size_t end, const glm::vec3& localCenter,
+							 float localRadius, SphereSoA& out);
+
+	/**
+	 * @brief Indices in [begin, end) of the spheres intersecting the frustum, written compacted in ascending order.
+	 * Tests 8 spheres per iteration with AVX2 (4 with SSE). outVisible needs room for end - begin indices.
+	 *
+	 * @return Number of visible spheres.
+	 */
+	size_t cullSpheres(const Frustum& frustum, const SphereSoA& spheres, size_t begin, size_t end,
+					   uint32_t* outVisible);
+
+	/**
+	 * @brief Same as cullSpheres for center / extent boxes.
+	 */
+	size_t cullBounds(const Frustum& frustum, const BoundsSoA& bounds, size_t begin, size_t end, uint32_t* outVisible);
+
+} // namespace rv
+
+#endif //!__FRUSTUM__H__
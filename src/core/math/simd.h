@@ -0,0 +1,111 @@
+#ifndef __SIMD__H__
+#define __SIMD__H__
+
+#include <cmath>
+#include <cstddef>
+
+#if defined(__AVX2__)
+#define RV_SIMD_AVX2 1
+#include <immintrin.h>
+#else
+#define RV_SIMD_AVX2 0
+#endif
+
+#if RV_SIMD_AVX2 || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RV_SIMD_SSE 1
+#include <emmintrin.h>
+#include <xmmintrin.h>
+#else
+#define RV_SIMD_SSE 0
+#endif
+
+namespace rv
+{
+	/**
+	 * @brief Thin float vector wrappers so SoA kernels are written once and instantiated per lane width.
+	 * FloatV picks the widest one enabled at compile time (AVX2 needs -mavx2 / /arch:AVX2).
+	 */
+	struct Float1
+	{
+		static constexpr size_t Width = 1;
+		float v;
+
+		static Float1 Load(const float* ptr) { return {*ptr}; };
+		static Float1 Set(float value) { return {value}; };
+		void Store(float* ptr) const { *ptr = v; };
+
+		friend Float1 operator+(Float1 a, Float1 b) { return {a.v + b.v}; };
+		friend Float1 operator-(Float1 a, Float1 b) { return {a.v - b.v}; };
+		friend Float1 operator*(Float1 a, Float1 b) { return {a.v * b.v}; };
+		friend Float1 operator/(Float1 a, Float1 b) { return {a.v / b.v}; };
+		friend Float1 Abs(Float1 a) { return {std::fabs(a.v)}; };
+		// a * b + c
+		friend Float1 MulAdd(Float1 a, Float1 b, Float1 c) { return {a.v * b.v + c.v}; };
+		friend Float1 Min(Float1 a, Float1 b) { return {a.v < b.v ? a.v : b.v}; };
+		// Bit i set where lane i of a >= b
+		friend unsigned GreaterEqualMask(Float1 a, Float1 b) { return a.v >= b.v ? 1u : 0u; };
+	};
+
+#if RV_SIMD_SSE
+	struct Float4
+	{
+		static constexpr size_t Width = 4;
+		__m128 v;
+
+		static Float4 Load(const float* ptr) { return {_mm_loadu_ps(ptr)}; };
+		static Float4 Set(float value) { return {_mm_set1_ps(value)}; };
+		void Store(float* ptr) const { _mm_storeu_ps(ptr, v); };
+
+		friend Float4 operator+(Float4 a, Float4 b) { return {_mm_add_ps(a.v, b.v)}; };
+		friend Float4 operator-(Float4 a, Float4 b) { return {_mm_sub_ps(a.v, b.v)}; };
+		friend Float4 operator*(Float4 a, Float4 b) { return {_mm_mul_ps(a.v, b.v)}; };
+		friend Float4 operator/(Float4 a, Float4 b) { return {_mm_div_ps(a.v, b.v)}; };
+		friend Float4 Abs(Float4 a) { return {_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)}; };
+		friend Float4 MulAdd(Float4 a, Float4 b, Float4 c) { return {_mm_add_ps(_mm_mul_ps(a.v, b.v), c.v)}; };
+		friend Float4 Min(Float4 a, Float4 b) { return {_mm_min_ps(a.v, b.v)}; };
+		friend unsigned GreaterEqualMask(Float4 a, Float4 b)
+		{
+			return static_cast<unsigned>(_mm_movemask_ps(_mm_cmpge_ps(a.v, b.v)));
+		};
+	};
+#endif
+
+#if RV_SIMD_AVX2
+	struct Float8
+	{
+		static constexpr size_t Width = 8;
+		__m256 v;
+
+		static Float8 Load(const float* ptr) { return {_mm256_loadu_ps(ptr)}; };
+		static Float8 Set(float value) { return {_mm256_set1_ps(value)}; };
+		void Store(float* ptr) const { _mm256_storeu_ps(ptr, v); };
+
+		friend Float8 operator+(Float8 a, Float8 b) { return {_mm256_add_ps(a.v, b.v)}; };
+		friend Float8 operator-(Float8 a, Float8 b) { return {_mm256_sub_ps(a.v, b.v)}; };
+		friend Float8 operator*(Float8 a, Float8 b) { return {_mm256_mul_ps(a.v, b.v)}; };
+		friend Float8 operator/(Float8 a, Float8 b) { return {_mm256_div_ps(a.v, b.v)}; };
+		friend Float8 Abs(Float8 a) { return {_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v)}; };
+		friend Float8 MulAdd(Float8 a, Float8 b, Float8 c)
+		{
+#if defined(__FMA__)
+			return {_mm256_fmadd_ps(a.v, b.v, c.v)};
+#else
+			return {_mm256_add_ps(_mm256_mul_ps(a.v, b.v), c.v)};
+#endif
+		};
+		friend Float8 Min(Float8 a, Float8 b) { return {_mm256_min_ps(a.v, b.v)}; };
+		friend unsigned GreaterEqualMask(Float8 a, Float8 b)
+		{
+			return static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ)));
+		};
+	};
+	using FloatV = Float8;
+#elif RV_SIMD_SSE
+	using FloatV = Float4;
+#else
+	using FloatV = Float1;
+#endif
+
+} // namespace rv
+
+#endif //!__SIMD__H__
@@ -0,0 +1,294 @@
+// Application Specific Includes
+#include <core/math/simd.h>
+#include <core/math/transform.h>
+
+namespace rv
+{
+	namespace
+	{
+		// Matrix elements of V::Width transforms, one register per element (column major order)
+		template <typename V>
+		struct MatrixLanes
+		{
+			V m[16];
+		};
+
+		template <typename V>
+		MatrixLanes<V> ComposeLanes(const TransformSoA& t, size_t i)
+		{
+			const V x = V::Load(&t.rotX[i]);
+			const V y = V::Load(&t.rotY[i]);
+			const V z = V::Load(&t.rotZ[i]);
+			const V w = V::Load(&t.rotW[i]);
+			const V sx = V::Load(&t.scaleX[i]);
+			const V sy = V::Load(&t.scaleY[i]);
+			const V sz = V::Load(&t.scaleZ[i]);
+
+			const V two = V::Set(2.0f);
+			const V one = V::Set(1.0f);
+			const V x2 = x * two, y2 = y * two, z2 = z * two;
+			const V xx = x * x2, yy = y * y2, zz = z * z2;
+			const V xy = x * y2, xz = x * z2, yz = y * z2;
+			const V wx = w * x2, wy = w * y2, wz = w * z2;
+
+			MatrixLanes<V> out;
+			out.m[0] = (one - (yy + zz)) * sx;
+			out.m[1] = (xy + wz) * sx;
+			out.m[2] = (xz - wy) * sx;
+			out.m[3] = V::Set(0.0f);
+			out.m[4] = (xy - wz) * sy;
+			out.m[5] = (one - (xx + zz)) * sy;
+			out.m[6] = (yz + wx) * sy;
+			out.m[7] = V::Set(0.0f);
+			out.m[8] = (xz + wy) * sz;
+			out.m[9] = (yz - wx) * sz;
+			out.m[10] = (one - (xx + yy)) * sz;
+			out.m[11] = V::Set(0.0f);
+			out.m[12] = V::Load(&t.posX[i]);
+			out.m[13] = V::Load(&t.posY[i]);
+			out.m[14] = V::Load(&t.posZ[i]);
+			out.m[15] = one;
+			return out;
+		}
+
+		// SoA lanes back to array of matrices
+		void StoreMatrices(const MatrixLanes<Float1>& lanes, float* dst)
+		{
+			for (int e = 0; e < 16; e++)
+			{
+				dst[e] = lanes.m[e].v;
+			}
+		}
+
+#if RV_SIMD_SSE && !RV_SIMD_AVX2
+		void StoreMatrices(const MatrixLanes<Float4>& lanes, float* dst)
+		{
+			for (int col = 0; col < 4; col++)
+			{
+				__m128 r0 = lanes.m[col * 4 + 0].v;
+				__m128 r1 = lanes.m[col * 4 + 1].v;
+				__m128 r2 = lanes.m[col * 4 + 2].v;
+				__m128 r3 = lanes.m[col * 4 + 3].v;
+				_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+				_mm_storeu_ps(dst + 0 * 16 + col * 4, r0);
+				_mm_storeu_ps(dst + 1 * 16 + col * 4, r1);
+				_mm_storeu_ps(dst + 2 * 16 + col * 4, r2);
+				_mm_storeu_ps(dst + 3 * 16 + col * 4, r3);
+			}
+		}
+#endif
+
+#if RV_SIMD_AVX2
+		void StoreMatrices(const MatrixLanes<Float8>& lanes, float* dst)
+		{
+			for (int col = 0; col < 4; col++)
+			{
+				const __m256 x = lanes.m[col * 4 + 0].v;
+				const __m256 y = lanes.m[col * 4 + 1].v;
+				const __m256 z = lanes.m[col * 4 + 2].v;
+				const __m256 w = lanes.m[col * 4 + 3].v;
+				const __m256 t0 = _mm256_unpacklo_ps(x, y);
+				const __m256 t1 = _mm256_unpackhi_ps(x, y);
+				const __m256 t2 = _mm256_unpacklo_ps(z, w);
+				const __m256 t3 = _mm256_unpackhi_ps(z, w);
+				// Each holds one column of matrix k in the low half and of matrix k + 4 in the high half
+				const __m256 c0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+				const __m256 c1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+				const __m256 c2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+				const __m256 c3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+				const __m256 cols[4] = {c0, c1, c2, c3};
+				for (int k = 0; k < 4; k++)
+				{
+					_mm_storeu_ps(dst + k * 16 + col * 4, _mm256_castps256_ps128(cols[k]));
+					_mm_storeu_ps(dst + (k + 4) * 16 + col * 4, _mm256_extractf128_ps(cols[k], 1));
+				}
+			}
+		}
+#endif
+
+		template <typename V>
+		size_t ComposeRange(const TransformSoA& transforms, size_t i, size_t end, glm::mat4* outMatrices)
+		{
+			for (; i + V::Width <= end; i += V::Width)
+			{
+				StoreMatrices(ComposeLanes<V>(transforms, i), &outMatrices[i][0][0]);
+			}
+			return i;
+		}
+
+		template <typename V>
+		size_t TransformBoundsRange(const float* m, const BoundsSoA& in, size_t i, size_t end, BoundsSoA& out)
+		{
+			const V m00 = V::Set(m[0]), m01 = V::Set(m[1]), m02 = V::Set(m[2]);
+			const V m10 = V::Set(m[4]), m11 = V::Set(m[5]), m12 = V::Set(m[6]);
+			const V m20 = V::Set(m[8]), m21 = V::Set(m[9]), m22 = V::Set(m[10]);
+			const V a00 = Abs(m00), a01 = Abs(m01), a02 = Abs(m02);
+			const V a10 = Abs(m10), a11 = Abs(m11), a12 = Abs(m12);
+			const V a20 = Abs(m20), a21 = Abs(m21), a22 = Abs(m22);
+			const V tx = V::Set(m[12]), ty = V::Set(m[13]), tz = V::Set(m[14]);
+
+			for (; i + V::Width <= end; i += V::Width)
+			{
+				const V cx = V::Load(&in.centerX[i]), cy = V::Load(&in.centerY[i]), cz = V::Load(&in.centerZ[i]);
+				const V ex = V::Load(&in.extentX[i]), ey = V::Load(&in.extentY[i]), ez = V::Load(&in.extentZ[i]);
+
+				// mAB is column A row B
+				MulAdd(m00, cx, MulAdd(m10, cy, MulAdd(m20, cz, tx))).Store(&out.centerX[i]);
+				MulAdd(m01, cx, MulAdd(m11, cy, MulAdd(m21, cz, ty))).Store(&out.centerY[i]);
+				MulAdd(m02, cx, MulAdd(m12, cy, MulAdd(m22, cz, tz))).Store(&out.centerZ[i]);
+				MulAdd(a00, ex, MulAdd(a10, ey, a20 * ez)).Store(&out.extentX[i]);
+				MulAdd(a01, ex, MulAdd(a11, ey, a21 * ez)).Store(&out.extentY[i]);
+				MulAdd(a02, ex, MulAdd(a12, ey, a22 * ez)).Store(&out.extentZ[i]);
+			}
+			return i;
+		}
+
+		template <typename V>
+		size_t WorldBoundsRange(const TransformSoA& t, const AABB& localBox, size_t i, size_t end, BoundsSoA& out)
+		{
+			const glm::vec3 localCenter = (localBox.min + localBox.max) * 0.5f;
+			const glm::vec3 localExtent = (localBox.max - localBox.min) * 0.5f;
+			const V lcx = V::Set(localCenter.x), lcy = V::Set(localCenter.y), lcz = V::Set(localCenter.z);
+			const V lex = V::Set(localExtent.x), ley = V::Set(localExtent.y), lez = V::Set(localExtent.z);
+
+			for (; i + V::Width <= end; i += V::Width)
+			{
+				const MatrixLanes<V> lanes = ComposeLanes<V>(t, i);
+				const V* m = lanes.m;
+
+				MulAdd(m[0], lcx, MulAdd(m[4], lcy, MulAdd(m[8], lcz, m[12]))).Store(&out.centerX[i]);
+				MulAdd(m[1], lcx, MulAdd(m[5], lcy, MulAdd(m[9], lcz, m[13]))).Store(&out.centerY[i]);
+				MulAdd(m[2], lcx, MulAdd(m[6], lcy, MulAdd(m[10], lcz, m[14]))).Store(&out.centerZ[i]);
+				MulAdd(Abs(m[0]), lex, MulAdd(Abs(m[4]), ley, Abs(m[8]) * lez)).Store(&out.extentX[i]);
+				MulAdd(Abs(m[1]), lex, MulAdd(Abs(m[5]), ley, Abs(m[9]) * lez)).Store(&out.extentY[i]);
+				MulAdd(Abs(m[2]), lex, MulAdd(Abs(m[6]), ley, Abs(m[10]) * lez)).Store(&out.extentZ[i]);
+			}
+			return i;
+		}
+	} // namespace
+
+	void TransformSoA::Resize(size_t count)
+	{
+		for (std::vector<float>* array : {&posX, &posY, &posZ, &rotX, &rotY, &rotZ, &scaleX, &scaleY, &scaleZ})
+		{
+			array->resize(count, array == &scaleX || array == &scaleY || array == &scaleZ ? 1.0f : 0.0f);
+		}
+		rotW.resize(count, 1.0f);
+	}
+
+	void TransformSoA::Set(size_t index, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+	{
+		posX[index] = position.x;
+		posY[index] = position.y;
+		posZ[index] = position.z;
+		rotX[index] = rotation.x;
+		rotY[index] = rotation.y;
+		rotZ[index] = rotation.z;
+		rotW[index] = rotation.w;
+		scaleX[index] = scale.x;
+		scaleY[index] = scale.y;
+		scaleZ[index] = scale.z;
+	}
+
+	void BoundsSoA::Resize(size_t count)
+	{
+		for (std::vector<float>* array : {&centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ})
+		{
+			array->resize(count, 0.0f);
+		}
+	}
+
+	void BoundsSoA::Set(size_t index, const AABB& box)
+	{
+		const glm::vec3 center = (box.min + box.max) * 0.5f;
+		const glm::vec3 extent = (box.max - box.min) * 0.5f;
+		centerX[index] = center.x;
+		centerY[index] = center.y;
+		centerZ[index] = center.z;
+		extentX[index] = extent.x;
+		extentY[index] = extent.y;
+		extentZ[index] = extent.z;
+	}
+
+	AABB BoundsSoA::Get(size_t index) const
+	{
+		const glm::vec3 center{centerX[index], centerY[index], centerZ[index]};
+		const glm::vec3 extent{extentX[index], extentY[index], extentZ[index]};
+		return AABB{center - extent, center + extent};
+	}
+
+	void composeTRS(const TransformSoA& transforms, size_t begin, size_t end, glm::mat4* outMatrices)
+	{
+		size_t i = ComposeRange<FloatV>(transforms, begin, end, outMatrices);
+		ComposeRange<Float1>(transforms, i, end, outMatrices);
+	}
+
+	void multiplyMatrices(const glm::mat4& lhs, const glm::mat4* rhs, size_t count, glm::mat4* outMatrices)
+	{
+#if RV_SIMD_AVX2
+		// Two result columns per iteration: lhs columns duplicated in both halves, rhs elements splatted per half
+		const float* l = &lhs[0][0];
+		const Float8 l0{_mm256_broadcast_ps(reinterpret_cast<const __m128*>(l + 0))};
+		const Float8 l1{_mm256_broadcast_ps(reinterpret_cast<const __m128*>(l + 4))};
+		const Float8 l2{_mm256_broadcast_ps(reinterpret_cast<const __m128*>(l + 8))};
+		const Float8 l3{_mm256_broadcast_ps(reinterpret_cast<const __m128*>(l + 12))};
+		const auto twoColumns = [&](__m256 r) {
+			Float8 acc = l0 * Float8{_mm256_permute_ps(r, 0x00)};
+			acc = MulAdd(l1, Float8{_mm256_permute_ps(r, 0x55)}, acc);
+			acc = MulAdd(l2, Float8{_mm256_permute_ps(r, 0xAA)}, acc);
+			return MulAdd(l3, Float8{_mm256_permute_ps(r, 0xFF)}, acc);
+		};
+		for (size_t i = 0; i < count; i++)
+		{
+			const float* r = &rhs[i][0][0];
+			float* dst = &outMatrices[i][0][0];
+			// Load the whole rhs first so aliasing output is fine
+			const __m256 r01 = _mm256_loadu_ps(r);
+			const __m256 r23 = _mm256_loadu_ps(r + 8);
+			twoColumns(r01).Store(dst);
+			twoColumns(r23).Store(dst + 8);
+		}
+#elif RV_SIMD_SSE
+		const float* l = &lhs[0][0];
+		const __m128 l0 = _mm_loadu_ps(l + 0);
+		const __m128 l1 = _mm_loadu_ps(l + 4);
+		const __m128 l2 = _mm_loadu_ps(l + 8);
+		const __m128 l3 = _mm_loadu_ps(l + 12);
+		for (size_t i = 0; i < count; i++)
+		{
+			const float* r = &rhs[i][0][0];
+			float* dst = &outMatrices[i][0][0];
+			// Load the whole rhs first so aliasing output is fine
+			const __m128 rc[4] = {_mm_loadu_ps(r), _mm_loadu_ps(r + 4), _mm_loadu_ps(r + 8), _mm_loadu_ps(r + 12)};
+			for (int col = 0; col < 4; col++)
+			{
+				__m128 acc = _mm_mul_ps(l0, _mm_shuffle_ps(rc[col], rc[col], 0x00));
+				acc = _mm_add_ps(acc, _mm_mul_ps(l1, _mm_shuffle_ps(rc[col], rc[col], 0x55)));
+				acc = _mm_add_ps(acc, _mm_mul_ps(l2, _mm_shuffle_ps(rc[col], rc[col], 0xAA)));
+				acc = _mm_add_ps(acc, _mm_mul_ps(l3, _mm_shuffle_ps(rc[col], rc[col], 0xFF)));
+				_mm_storeu_ps(dst + col * 4, acc);
+			}
+		}
+#else
+		for (size_t i = 0; i < count; i++)
+		{
+			outMatrices[i] = lhs * rhs[i];
+		}
+#endif
+	}
+
+	void transformBounds(const glm::mat4& matrix, const BoundsSoA& bounds, size_t begin, size_t end, BoundsSoA& out)
+	{
+		const float* m = &matrix[0][0];
+		size_t i = TransformBoundsRange<FloatV>(m, bounds, begin, end, out);
+		TransformBoundsRange<Float1>(m, bounds, i, end, out);
+	}
+
+	void computeWorldBounds(const TransformSoA& transforms, const AABB& localBox, size_t begin, size_t end,
+							BoundsSoA& out)
+	{
+		size_t i = WorldBoundsRange<FloatV>(transforms, localBox, begin, end, out);
+		WorldBoundsRange<Float1>(transforms, localBox, i, end, out);
+	}
+
+} // namespace rv
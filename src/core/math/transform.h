@@ -0,0 +1,82 @@
+#ifndef __TRANSFORM__H__
+#define __TRANSFORM__H__
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace rv
+{
+	/**
+	 * @brief Translation / rotation / scale of many objects stored as structure of arrays, so batch kernels
+	 * load 4 or 8 objects per register without any shuffling.
+	 */
+	struct TransformSoA
+	{
+		std::vector<float> posX, posY, posZ;
+		std::vector<float> rotX, rotY, rotZ, rotW;
+		std::vector<float> scaleX, scaleY, scaleZ;
+
+		size_t Size() const { return posX.size(); };
+		void Resize(size_t count);
+		void Set(size_t index, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
+	};
+
+	struct AABB
+	{
+		glm::vec3 min;
+		glm::vec3 max;
+	};
+
+	/**
+	 * @brief Axis aligned boxes in center / half extent form, structure of arrays.
+	 */
+	struct BoundsSoA
+	{
+		std::vector<float> centerX, centerY, centerZ;
+		std::vector<float> extentX, extentY, extentZ;
+
+		size_t Size() const { return centerX.size(); };
+		void Resize(size_t count);
+		void Set(size_t index, const AABB& box);
+		AABB Get(size_t index) const;
+	};
+
+	/**
+	 * @brief Closed form T * R * S of a single transform. rotation must be a unit quaternion.
+	 */
+	inline glm::mat4 composeTRS(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+	{
+		const glm::mat3 r = glm::mat3_cast(rotation);
+		return glm::mat4(glm::vec4(r[0] * scale.x, 0.0f), glm::vec4(r[1] * scale.y, 0.0f),
+						 glm::vec4(r[2] * scale.z, 0.0f), glm::vec4(position, 1.0f));
+	}
+
+	/**
+	 * @brief Closed form T * R * S for transforms [begin, end), written to outMatrices[begin, end).
+	 * Rotations must be unit quaternions.
+	 */
+	void composeTRS(const TransformSoA& transforms, size_t begin, size_t end, glm::mat4* outMatrices);
+
+	/**
+	 * @brief outMatrices[i] = lhs * rhs[i] for i in [0, count). outMatrices may alias rhs.
+	 */
+	void multiplyMatrices(const glm::mat4& lhs, const glm::mat4* rhs, size_t count, glm::mat4* outMatrices);
+
+	/**
+	 * @brief Transform boxes [begin, end) by one affine matrix (Arvo's method), out must be sized already.
+	 */
+	void transformBounds(const glm::mat4& matrix, const BoundsSoA& bounds, size_t begin, size_t end, BoundsSoA& out);
+
+	/**
+	 * @brief World space boxes of one local box instanced by every transform in [begin, end), computed straight
+	 * from the TRS data without building matrices. out must be sized already.
+	 */
+	void computeWorldBounds(const TransformSoA& transforms, const AABB& localBox, size_t begin, size_t end,
+							BoundsSoA& out);
+
+} // namespace rv
+
+#endif //!__TRANSFORM__H__
@@ -0,0 +1,327 @@
+// StdLib Includes
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+// Application Specific Includes
+#include <core/pack.h>
+#include <core/bits.h>
+#include <core/jobs.h>
+#include <core/lz.h>
+#include <core/utils.h>
+
+namespace gefx
+{
+	std::shared_ptr<PackArchive> PackArchive::Open(const std::string& path)
+	{
+		std::shared_ptr<MappedFile> file = MappedFile::Open(path, AccessHint::Random);
+		if (!file || file->Size() < sizeof(PackHeader)) return nullptr;
+
+		const uint8_t* base = file->Data();
+		const PackHeader* header = reinterpret_cast<const PackHeader*>(base);
+		if (header->magic != PackHeader::Magic || header->version != PackHeader::Version) return nullptr;
+		if (header->blockSize == 0 || header->namesSize > file->Size()) return nullptr;
+
+		const uint64_t entriesSize = uint64_t(header->fileCount) * sizeof(PackEntry);
+		const uint64_t blocksSize = uint64_t(header->blockCount) * sizeof(PackBlock);
+		const uint64_t tablesEnd = sizeof(PackHeader) + entriesSize + blocksSize + header->namesSize;
+		if (tablesEnd > header->dataOffset || header->dataOffset > file->Size()) return nullptr;
+
+		std::shared_ptr<PackArchive> archive(new PackArchive());
+		archive->_header = header;
+		archive->_entries = reinterpret_cast<const PackEntry*>(base + sizeof(PackHeader));
+		archive->_blocks = reinterpret_cast<const PackBlock*>(base + sizeof(PackHeader) + entriesSize);
+		archive->_names = reinterpret_cast<const char*>(base + sizeof(PackHeader) + entriesSize + blocksSize);
+		archive->_data = base + header->dataOffset;
+
+		// Validate block and entry ranges once so reads don't have to. Blocks are stored in order without
+		// overlapping, and all but the last are full, so a stream offset always maps to offset / blockSize
+		const uint64_t dataSize = file->Size() - header->dataOffset;
+		uint64_t storedEnd = 0;
+		uint64_t streamSize = 0;
+		for (uint32_t i = 0; i < header->blockCount; i++)
+		{
+			const PackBlock& block = archive->_blocks[i];
+			if (block.offset < storedEnd || block.offset > dataSize || block.storedSize > dataSize - block.offset)
+			{
+				return nullptr;
+			}
+			const bool last = i + 1 == header->blockCount;
+			if (last ? (block.rawSize == 0 || block.rawSize > header->blockSize) : block.rawSize != header->blockSize)
+			{
+				return nullptr;
+			}
+			storedEnd = block.offset + block.storedSize;
+			streamSize += block.rawSize;
+		}
+		for (uint32_t i = 0; i < header->fileCount; i++)
+		{
+			const PackEntry& entry = archive->_entries[i];
+			if (entry.offset > streamSize || entry.size > streamSize - entry.offset) return nullptr;
+		}
+
+		// The index is touched on every lookup, keep it resident
+		file->Advise(0, static_cast<size_t>(header->dataOffset), AccessHint::WillNeed);
+		archive->_file = std::move(file);
+		return archive;
+	}
+
+	const PackEntry* PackArchive::Find(std::string_view path) const
+	{
+		const uint32_t hash = rv::crc32_view(path);
+		const PackEntry* end = _entries + _header->fileCount;
+		const PackEntry* it = std::lower_bound(_entries, end, hash,
+						       [](const PackEntry& entry, uint32_t value) { return entry.pathHash < value; });
+		if (it == end || it->pathHash != hash) return nullptr;
+		if (GetName(*it) != path) return nullptr;
+		return it;
+	}
+
+	std::string_view PackArchive::GetName(const PackEntry& entry) const
+	{
+		if (uint64_t(entry.nameOffset) + entry.nameSize > _header->namesSize) return std::string_view();
+		return std::string_view(_names + entry.nameOffset, entry.nameSize);
+	}
+
+	bool PackArchive::DecodeBlock(uint32_t blockIdx, uint8_t* out) const
+	{
+		const PackBlock& block = _blocks[blockIdx];
+		const uint8_t* stored = _data + block.offset;
+		if (block.storedSize == block.rawSize)
+		{
+			memcpy(out, stored, block.rawSize);
+			return true;
+		}
+		return rv::lzDecompress(stored, block.storedSize, out, block.rawSize);
+	}
+
+	FileView PackArchive::Read(const PackEntry& entry, JobSystem* jobs, AccessHint hint) const
+	{
+		if (entry.size == 0) return FileView::Empty();
+
+		const uint64_t blockSize = _header->blockSize;
+		const uint32_t firstBlock = static_cast<uint32_t>(entry.offset / blockSize);
+		const uint32_t lastBlock = static_cast<uint32_t>((entry.offset + entry.size - 1) / blockSize);
+
+		const PackBlock& first = _blocks[firstBlock];
+		if (firstBlock == lastBlock && first.storedSize == first.rawSize)
+		{
+			// Zero-copy straight from the mapping, the caller reads it the way it said it would
+			const uint8_t* data = _data + first.offset + (entry.offset - uint64_t(firstBlock) * blockSize);
+			if (hint != AccessHint::Normal)
+			{
+				_file->Advise(static_cast<size_t>(data - _file->Data()), static_cast<size_t>(entry.size), hint);
+			}
+			return FileView(_file, rv::Span<const uint8_t>(data, static_cast<size_t>(entry.size)));
+		}
+
+		_file->Advise(static_cast<size_t>(_header->dataOffset + first.offset),
+			      static_cast<size_t>(_blocks[lastBlock].offset + _blocks[lastBlock].storedSize - first.offset),
+			      AccessHint::WillNeed);
+
+		std::shared_ptr<uint8_t[]> buffer(new uint8_t[static_cast<size_t>(entry.size)]);
+		std::atomic<bool> failed{false};
+
+		auto decodeRange = [&](uint32_t begin, uint32_t end) {
+			std::unique_ptr<uint8_t[]> scratch;
+			for (uint32_t i = firstBlock + begin; i < firstBlock + end; i++)
+			{
+				const uint64_t blockStart = uint64_t(i) * blockSize;
+				const uint64_t copyStart = std::max(blockStart, entry.offset);
+				const uint64_t copyEnd = std::min(blockStart + _blocks[i].rawSize, entry.offset + entry.size);
+				uint8_t* dest = buffer.get() + (copyStart - entry.offset);
+
+				if (copyStart == blockStart && copyEnd == blockStart + _blocks[i].rawSize)
+				{
+					// Block fully inside the file, decode in place
+					if (!DecodeBlock(i, dest)) failed = true;
+					continue;
+				}
+
+				if (!scratch) scratch.reset(new uint8_t[_header->blockSize]);
+				if (!DecodeBlock(i, scratch.get()))
+				{
+					failed = true;
+					continue;
+				}
+				memcpy(dest, scratch.get() + (copyStart - blockStart), static_cast<size_t>(copyEnd - copyStart));
+			}
+		};
+
+		const uint32_t blockCount = lastBlock - firstBlock + 1;
+		if (jobs && blockCount > 1)
+		{
+			jobs->ParallelFor(blockCount, 1, decodeRange);
+		}
+		else
+		{
+			decodeRange(0, blockCount);
+		}
+
+		if (failed) return FileView();
+		rv::Span<const uint8_t> data(buffer.get(), static_cast<size_t>(entry.size));
+		return FileView(std::move(buffer), data);
+	}
+
+	bool PackMount::Stat(std::string_view relPath, FileStat& outStat)
+	{
+		const PackEntry* entry = _archive->Find(relPath);
+		if (!entry)
+		{
+			outStat = FileStat();
+			return false;
+		}
+		outStat.exists = true;
+		outStat.isDirectory = false;
+		outStat.size = entry->size;
+		outStat.modifiedTime = 0;
+		return true;
+	}
+
+	FileView PackMount::Open(std::string_view relPath, AccessHint hint)
+	{
+		const PackEntry* entry = _archive->Find(relPath);
+		if (!entry) return FileView();
+		return _archive->Read(*entry, _jobs, hint);
+	}
+
+	bool PackBuilder::AddFile(std::string_view virtualPath, const std::string& diskPath)
+	{
+		std::shared_ptr<MappedFile> file = MappedFile::Open(diskPath, AccessHint::Sequential);
+		if (!file) return false;
+		AddData(virtualPath, std::vector<uint8_t>(file->Data(), file->Data() + file->Size()));
+		return true;
+	}
+
+	void PackBuilder::AddData(std::string_view virtualPath, std::vector<uint8_t> data)
+	{
+		_files.push_back({std::string(virtualPath), std::move(data)});
+	}
+
+	bool PackBuilder::Write(const std::string& outPath, JobSystem* jobs, std::string& outError) const
+	{
+		// Build the index sorted by hash, rejecting collisions
+		std::vector<PackEntry> entries(_files.size());
+		std::string names;
+		uint64_t streamSize = 0;
+		for (size_t i = 0; i < _files.size(); i++)
+		{
+			const PendingFile& file = _files[i];
+			PackEntry& entry = entries[i];
+			entry.pathHash = rv::crc32_view(file.virtualPath);
+			entry.nameOffset = static_cast<uint32_t>(names.size());
+			entry.nameSize = static_cast<uint32_t>(file.virtualPath.size());
+			entry.reserved = 0;
+			entry.offset = streamSize;
+			entry.size = file.data.size();
+			names.append(file.virtualPath);
+			streamSize += file.data.size();
+		}
+
+		std::vector<uint32_t> order(entries.size());
+		for (uint32_t i = 0; i < order.size(); i++)
+		{
+			order[i] = i;
+		}
+		std::sort(order.begin(), order.end(),
+			  [&](uint32_t a, uint32_t b) { return entries[a].pathHash < entries[b].pathHash; });
+		for (size_t i = 1; i < order.size(); i++)
+		{
+			if (entries[order[i]].pathHash != entries[order[i - 1]].pathHash) continue;
+			outError = "path hash collision between '" + _files[order[i - 1]].virtualPath + "' and '" +
+				   _files[order[i]].virtualPath + "'";
+			return false;
+		}
+
+		// Concatenate the content stream and compress it block by block
+		std::vector<uint8_t> stream;
+		stream.reserve(static_cast<size_t>(streamSize));
+		for (const PendingFile& file : _files)
+		{
+			stream.insert(stream.end(), file.data.begin(), file.data.end());
+		}
+
+		const uint32_t blockCount = static_cast<uint32_t>((streamSize + PackBlockSize - 1) / PackBlockSize);
+		std::vector<std::vector<uint8_t>> storedBlocks(blockCount);
+		auto compressRange = [&](uint32_t begin, uint32_t end) {
+			for (uint32_t i = begin; i < end; i++)
+			{
+				const size_t rawOffset = size_t(i) * PackBlockSize;
+				const size_t rawSize = std::min<size_t>(PackBlockSize, stream.size() - rawOffset);
+				std::vector<uint8_t>& stored = storedBlocks[i];
+				stored.resize(rv::lzCompressBound(rawSize));
+				const size_t compressed = rv::lzCompress(stream.data() + rawOffset, rawSize, stored.data(), stored.size());
+				if (compressed == 0 || compressed >= rawSize)
+				{
+					stored.assign(stream.begin() + rawOffset, stream.begin() + rawOffset + rawSize);
+				}
+				else
+				{
+					stored.resize(compressed);
+				}
+			}
+		};
+
+		if (jobs)
+		{
+			jobs->ParallelFor(blockCount, 4, compressRange);
+		}
+		else
+		{
+			compressRange(0, blockCount);
+		}
+
+		std::vector<PackBlock> blocks(blockCount);
+		uint64_t dataSize = 0;
+		for (uint32_t i = 0; i < blockCount; i++)
+		{
+			blocks[i].offset = dataSize;
+			blocks[i].storedSize = static_cast<uint32_t>(storedBlocks[i].size());
+			blocks[i].rawSize = static_cast<uint32_t>(std::min<uint64_t>(PackBlockSize, streamSize - uint64_t(i) * PackBlockSize));
+			dataSize += storedBlocks[i].size();
+		}
+
+		PackHeader header = {};
+		header.magic = PackHeader::Magic;
+		header.version = PackHeader::Version;
+		header.blockSize = PackBlockSize;
+		header.fileCount = static_cast<uint32_t>(entries.size());
+		header.blockCount = blockCount;
+		header.namesSize = names.size();
+		const uint64_t tablesEnd = sizeof(PackHeader) + entries.size() * sizeof(PackEntry) +
+					   blocks.size() * sizeof(PackBlock) + names.size();
+		// Page align the data so block reads map whole pages
+		header.dataOffset = rv::alignUp(tablesEnd, 4096);
+
+		std::ofstream out(outPath.c_str(), std::ios::binary | std::ios::trunc);
+		if (!out)
+		{
+			outError = "failed to open '" + outPath + "' for writing";
+			return false;
+		}
+
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		for (uint32_t idx : order)
+		{
+			out.write(reinterpret_cast<const char*>(&entries[idx]), sizeof(PackEntry));
+		}
+		out.write(reinterpret_cast<const char*>(blocks.data()), blocks.size() * sizeof(PackBlock));
+		out.write(names.data(), names.size());
+
+		const std::vector<char> padding(static_cast<size_t>(header.dataOffset - tablesEnd), 0);
+		out.write(padding.data(), padding.size());
+		for (const std::vector<uint8_t>& stored : storedBlocks)
+		{
+			out.write(reinterpret_cast<const char*>(stored.data()), stored.size());
+		}
+
+		if (!out)
+		{
+			outError = "failed writing '" + outPath + "'";
+			return false;
+		}
+		return true;
+	}
+
+} // namespace gefx
@@ -0,0 +1,156 @@
+#ifndef __PACK__H__
+#define __PACK__H__
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <core/vfs.h>
+
+namespace gefx
+{
+	class JobSystem;
+
+	/**
+	 * Pack archive layout (little endian):
+	 *  PackHeader
+	 *  PackEntry[fileCount]   sorted by pathHash (rv::crc32_view of the virtual path)
+	 *  PackBlock[blockCount]  one per 64KiB-aligned range of the content stream
+	 *  char names[namesSize]  virtual paths, used to reject hash collisions on lookup
+	 *  block data             each block compressed independently (or stored raw if that's smaller)
+	 *
+	 * Files are concatenated into a single content stream, so small files share blocks and large files
+	 * span several of them. Any block can be decoded without touching its neighbours.
+	 */
+	struct PackHeader
+	{
+		static constexpr uint32_t Magic = 0x4B415047; // "GPAK"
+		static constexpr uint32_t Version = 1;
+
+		uint32_t magic;
+		uint32_t version;
+		uint32_t blockSize;
+		uint32_t fileCount;
+		uint32_t blockCount;
+		uint32_t reserved;
+		uint64_t namesSize;
+		uint64_t dataOffset;
+	};
+
+	struct PackEntry
+	{
+		uint32_t pathHash;
+		uint32_t nameOffset;
+		uint32_t nameSize;
+		uint32_t reserved;
+		uint64_t offset; // in the uncompressed content stream
+		uint64_t size;
+	};
+
+	struct PackBlock
+	{
+		uint64_t offset; // relative to PackHeader::dataOffset
+		uint32_t storedSize;
+		uint32_t rawSize; // storedSize == rawSize means the block is stored uncompressed
+	};
+
+	static_assert(sizeof(PackHeader) == 40, "PackHeader layout changed");
+	static_assert(sizeof(PackEntry) == 32, "PackEntry layout changed");
+	static_assert(sizeof(PackBlock) == 16, "PackBlock layout changed");
+
+	static constexpr uint32_t PackBlockSize = 64u << 10;
+
+	/**
+	 * @brief Read-only, memory mapped pack archive.
+	 */
+	class PackArchive
+	{
+	  public:
+		static std::shared_ptr<PackArchive> Open(const std::string& path);
+
+		const PackEntry* Find(std::string_view path) const;
+
+		/**
+		 * @brief Read a file's contents. Files fully inside a raw block are returned as a view over the mapping,
+		 * advised with hint, anything else is decompressed into a new buffer, one job per block when a job
+		 * system is given.
+		 */
+		FileView Read(const PackEntry& entry, JobSystem* jobs = nullptr, AccessHint hint = AccessHint::Normal) const;
+
+		uint32_t GetFileCount() const { return _header->fileCount; };
+		std::string_view GetName(const PackEntry& entry) const;
+
+		PackArchive(PackArchive&&) = delete;
+		PackArchive(const PackArchive&) = delete;
+		PackArchive& operator=(PackArchive&&) = delete;
+		PackArchive& operator=(const PackArchive&) = delete;
+
+	  private:
+		PackArchive() = default;
+
+		bool DecodeBlock(uint32_t blockIdx, uint8_t* out) const;
+
+		std::shared_ptr<MappedFile> _file;
+		const PackHeader* _header{nullptr};
+		const PackEntry* _entries{nullptr};
+		const PackBlock* _blocks{nullptr};
+		const char* _names{nullptr};
+		const uint8_t* _data{nullptr};
+	};
+
+	/**
+	 * @brief Mount point serving the files of a pack archive.
+	 */
+	class PackMount : public IMountPoint
+	{
+	  public:
+		explicit PackMount(std::shared_ptr<PackArchive> archive, JobSystem* jobs = nullptr)
+			: _archive(std::move(archive)), _jobs(jobs){};
+
+		bool Stat(std::string_view relPath, FileStat& outStat) override;
+		FileView Open(std::string_view relPath, AccessHint hint) override;
+
+	  private:
+		std::shared_ptr<PackArchive> _archive;
+		JobSystem* _jobs;
+	};
+
+	/**
+	 * @brief Collects files and writes them as a pack archive.
+	 */
+	class PackBuilder
+	{
+	  public:
+		/**
+		 * @brief Queue a file from disk under the given virtual path ('/' separated).
+		 */
+		bool AddFile(std::string_view virtualPath, const std::string& diskPath);
+		void AddData(std::string_view virtualPath, std::vector<uint8_t> data);
+
+		/**
+		 * @brief Compress and write the archive. Fails on hash collisions between distinct paths.
+		 *
+		 * @param outPath Archive path.
+		 * @param jobs Optional job system, blocks are compressed in parallel when given.
+		 * @param outError Filled with a description on failure.
+		 * @return bool Whether the archive was written.
+		 */
+		bool Write(const std::string& outPath, JobSystem* jobs, std::string& outError) const;
+
+		size_t GetFileCount() const { return _files.size(); };
+
+	  private:
+		struct PendingFile
+		{
+			std::string virtualPath;
+			std::vector<uint8_t> data;
+		};
+
+		std::vector<PendingFile> _files;
+	};
+
+} // namespace gefx
+
+#endif //!__PACK__H__
@@ -0,0 +1,841 @@
+// StdLib Includes
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+// Application Specific Includes
+#include <core/bits.h>
+#include <core/containers/smallvector.h>
+#include <core/math/simd.h>
+#include <core/scene/bvh.h>
+
+namespace gefx
+{
+	namespace
+	{
+		constexpr uint32_t BinCount = 16;
+		// Ranges binned on the job system past this size, in batches of BinBatchSize primitives
+		constexpr uint32_t ParallelBinThreshold = 1u << 16;
+		constexpr uint32_t BinBatchSize = 1u << 14;
+		// Subtrees of this many primitives or more are built as their own job
+		constexpr uint32_t ParallelTaskThreshold = 1u << 12;
+		// Cost of visiting a node relative to testing one primitive
+		constexpr float TraversalCost = 1.0f;
+		constexpr float Infinity = std::numeric_limits<float>::infinity();
+		constexpr uint32_t InvalidIndex = ~0u;
+
+		rv::AABB emptyBox()
+		{
+			return rv::AABB{glm::vec3(Infinity), glm::vec3(-Infinity)};
+		}
+
+		void grow(rv::AABB& box, const rv::AABB& other)
+		{
+			box.min = glm::min(box.min, other.min);
+			box.max = glm::max(box.max, other.max);
+		}
+
+		void grow(rv::AABB& box, const glm::vec3& point)
+		{
+			box.min = glm::min(box.min, point);
+			box.max = glm::max(box.max, point);
+		}
+
+		// Half the surface area, 0 for empty boxes
+		float halfArea(const rv::AABB& box)
+		{
+			const glm::vec3 d = box.max - box.min;
+			return d.x < 0.0f ? 0.0f : d.x * d.y + d.y * d.z + d.z * d.x;
+		}
+
+		// Primitive boxes and centroids of a range
+		struct RangeBounds
+		{
+			rv::AABB bounds{emptyBox()};
+			rv::AABB centroids{emptyBox()};
+
+			void Merge(const RangeBounds& other)
+			{
+				grow(bounds, other.bounds);
+				grow(centroids, other.centroids);
+			};
+		};
+
+		struct Bin
+		{
+			RangeBounds range;
+			uint32_t count{0};
+		};
+
+		struct Bins
+		{
+			Bin bins[BinCount];
+
+			void Merge(const Bins& other)
+			{
+				for (uint32_t b = 0; b < BinCount; b++)
+				{
+					bins[b].range.Merge(other.bins[b].range);
+					bins[b].count += other.bins[b].count;
+				}
+			};
+		};
+
+		struct Split
+		{
+			// Bins [0, bin] go left, bin == InvalidIndex when no split separates anything
+			uint32_t bin{InvalidIndex};
+			float cost{Infinity};
+			RangeBounds left, right;
+		};
+
+		// Maps centroids to bins along the longest axis of the centroid bounds
+		struct BinMapping
+		{
+			int axis{0};
+			float origin{0.0f};
+			float scale{0.0f};
+
+			explicit BinMapping(const rv::AABB& centroids)
+			{
+				const glm::vec3 extent = centroids.max - centroids.min;
+				axis = extent.x >= extent.y ? (extent.x >= extent.z ? 0 : 2) : (extent.y >= extent.z ? 1 : 2);
+				origin = centroids.min[axis];
+				scale = extent[axis] > 0.0f ? BinCount / extent[axis] : 0.0f;
+			};
+
+			uint32_t operator()(const glm::vec3& centroid) const
+			{
+				const float bin = (centroid[axis] - origin) * scale;
+				return std::min(BinCount - 1, static_cast<uint32_t>(std::max(bin, 0.0f)));
+			};
+		};
+
+		// Partitioned in place during the build, so every node reads its primitives sequentially
+		struct BuildPrimitive
+		{
+			rv::AABB box;
+			glm::vec3 centroid;
+			uint32_t index;
+		};
+	} // namespace
+
+	struct Bvh::Builder
+	{
+		struct BuildNode
+		{
+			rv::AABB bounds;
+			// InvalidIndex for leaves
+			uint32_t left{InvalidIndex};
+			uint32_t right{InvalidIndex};
+			uint32_t first{0};
+			uint32_t count{0};
+		};
+
+		std::vector<BuildPrimitive> primitives;
+		JobSystem* jobs;
+
+		// Sized for the worst case up front, so jobs only ever claim fresh slots
+		std::vector<BuildNode> nodes;
+		std::atomic<uint32_t> nodeCount{1};
+		std::atomic<uint32_t> leafCount{0};
+
+		Builder(rv::Span<const rv::AABB> boxes, JobSystem* jobs)
+			: primitives(boxes.size()), jobs(jobs), nodes(2 * boxes.size() - 1)
+		{
+			const auto setup = [this, boxes](uint32_t begin, uint32_t end) {
+				for (uint32_t i = begin; i < end; i++)
+				{
+					primitives[i] = BuildPrimitive{boxes[i], (boxes[i].min + boxes[i].max) * 0.5f, i};
+				}
+			};
+			const uint32_t count = static_cast<uint32_t>(boxes.size());
+			if (jobs && count >= ParallelBinThreshold)
+			{
+				jobs->ParallelFor(count, BinBatchSize, setup);
+			}
+			else
+			{
+				setup(0, count);
+			}
+		};
+
+		// map(begin, end) over batches of [begin, end), spread on the job system for large ranges, then merged
+		template <typename T, typename F>
+		T Reduce(uint32_t begin, uint32_t end, const F& map)
+		{
+			const uint32_t count = end - begin;
+			if (!jobs || count < ParallelBinThreshold) return map(begin, end);
+
+			const uint32_t batches = (count + BinBatchSize - 1) / BinBatchSize;
+			std::vector<T> partial(batches);
+			jobs->ParallelFor(batches, 1, [&](uint32_t first, uint32_t last) {
+				for (uint32_t batch = first; batch < last; batch++)
+				{
+					const uint32_t batchBegin = begin + batch * BinBatchSize;
+					partial[batch] = map(batchBegin, std::min(batchBegin + BinBatchSize, end));
+				}
+			});
+			for (uint32_t batch = 1; batch < batches; batch++)
+			{
+				partial[0].Merge(partial[batch]);
+			}
+			return partial[0];
+		};
+
+		RangeBounds ComputeBounds(uint32_t begin, uint32_t end)
+		{
+			return Reduce<RangeBounds>(begin, end, [this](uint32_t first, uint32_t last) {
+				RangeBounds range;
+				for (uint32_t i = first; i < last; i++)
+				{
+					grow(range.bounds, primitives[i].box);
+					grow(range.centroids, primitives[i].centroid);
+				}
+				return range;
+			});
+		};
+
+		Split FindSplit(uint32_t begin, uint32_t end, const BinMapping& mapping)
+		{
+			const Bins bins = Reduce<Bins>(begin, end, [&](uint32_t first, uint32_t last) {
+				Bins local;
+				for (uint32_t i = first; i < last; i++)
+				{
+					Bin& bin = local.bins[mapping(primitives[i].centroid)];
+					grow(bin.range.bounds, primitives[i].box);
+					grow(bin.range.centroids, primitives[i].centroid);
+					bin.count++;
+				}
+				return local;
+			});
+
+			// Sweep from both ends, the cost of a split is SA(left) * N(left) + SA(right) * N(right)
+			RangeBounds left[BinCount - 1];
+			float leftCost[BinCount - 1];
+			uint32_t leftCount[BinCount - 1];
+			RangeBounds accumulated;
+			uint32_t count = 0;
+			for (uint32_t b = 0; b < BinCount - 1; b++)
+			{
+				accumulated.Merge(bins.bins[b].range);
+				count += bins.bins[b].count;
+				left[b] = accumulated;
+				leftCount[b] = count;
+				leftCost[b] = halfArea(accumulated.bounds) * count;
+			}
+
+			Split best;
+			accumulated = RangeBounds{};
+			count = 0;
+			for (uint32_t b = BinCount - 1; b > 0; b--)
+			{
+				accumulated.Merge(bins.bins[b].range);
+				count += bins.bins[b].count;
+				if (count == 0 || leftCount[b - 1] == 0) continue;
+
+				const float cost = leftCost[b - 1] + halfArea(accumulated.bounds) * count;
+				if (cost < best.cost)
+				{
+					best.bin = b - 1;
+					best.cost = cost;
+					best.left = left[b - 1];
+					best.right = accumulated;
+				}
+			}
+			return best;
+		};
+
+		void Build(uint32_t node, uint32_t begin, uint32_t end, const RangeBounds& range)
+		{
+			const uint32_t count = end - begin;
+			BuildNode& buildNode = nodes[node];
+			buildNode.bounds = range.bounds;
+			buildNode.first = begin;
+			buildNode.count = count;
+			// A leaf is one sequential pass over its boxes, as cheap as the wide node that would replace it
+			if (count <= MaxLeafSize)
+			{
+				leafCount.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+
+			const BinMapping mapping(range.centroids);
+			const Split split = mapping.scale > 0.0f ? FindSplit(begin, end, mapping) : Split{};
+
+			uint32_t mid;
+			RangeBounds left, right;
+			if (split.bin != InvalidIndex)
+			{
+				BuildPrimitive* first = primitives.data();
+				mid = static_cast<uint32_t>(
+					std::partition(first + begin, first + end,
+								   [&](const BuildPrimitive& primitive) {
+									   return mapping(primitive.centroid) <= split.bin;
+								   }) -
+					first);
+				left = split.left;
+				right = split.right;
+			}
+			else
+			{
+				// Every centroid is the same point, any halving is as good as another
+				mid = begin + count / 2;
+				left = ComputeBounds(begin, mid);
+				right = ComputeBounds(mid, end);
+			}
+
+			const uint32_t children = nodeCount.fetch_add(2, std::memory_order_relaxed);
+			buildNode.left = children;
+			buildNode.right = children + 1;
+
+			if (jobs && count >= ParallelTaskThreshold)
+			{
+				JobCounter counter;
+				jobs->Schedule([this, children, begin, mid, &left]() { Build(children, begin, mid, left); }, &counter);
+				Build(children + 1, mid, end, right);
+				jobs->Wait(counter);
+			}
+			else
+			{
+				Build(children, begin, mid, left);
+				Build(children + 1, mid, end, right);
+			}
+		};
+
+		static void SetChild(Node& node, uint32_t slot, const rv::AABB& box, uint32_t child, uint32_t count)
+		{
+			node.minX[slot] = box.min.x;
+			node.minY[slot] = box.min.y;
+			node.minZ[slot] = box.min.z;
+			node.maxX[slot] = box.max.x;
+			node.maxY[slot] = box.max.y;
+			node.maxZ[slot] = box.max.z;
+			node.children[slot] = child;
+			node.counts[slot] = count;
+		};
+
+		/**
+		 * @brief Turn the binary subtree under node into 4 wide nodes appended to out, depth first. Children
+		 * are pulled up by repeatedly opening the largest inner child until there are four.
+		 *
+		 * @return Index of the wide node.
+		 */
+		uint32_t Collapse(uint32_t node, std::vector<Node>& out, uint32_t depth, Stats& stats, float& cost)
+		{
+			const uint32_t index = static_cast<uint32_t>(out.size());
+			out.emplace_back();
+			stats.maxDepth = std::max(stats.maxDepth, depth + 1);
+			cost += TraversalCost * halfArea(nodes[node].bounds);
+
+			uint32_t slots[4];
+			uint32_t slotCount = 0;
+			if (nodes[node].left == InvalidIndex)
+			{
+				slots[slotCount++] = node;
+			}
+			else
+			{
+				slots[slotCount++] = nodes[node].left;
+				slots[slotCount++] = nodes[node].right;
+			}
+			while (slotCount < 4)
+			{
+				uint32_t largest = slotCount;
+				float largestArea = -1.0f;
+				for (uint32_t s = 0; s < slotCount; s++)
+				{
+					const BuildNode& candidate = nodes[slots[s]];
+					if (candidate.left != InvalidIndex && halfArea(candidate.bounds) > largestArea)
+					{
+						largest = s;
+						largestArea = halfArea(candidate.bounds);
+					}
+				}
+				if (largest == slotCount) break;
+
+				const BuildNode& opened = nodes[slots[largest]];
+				slots[largest] = opened.left;
+				slots[slotCount++] = opened.right;
+			}
+
+			for (uint32_t s = 0; s < 4; s++)
+			{
+				if (s >= slotCount)
+				{
+					SetChild(out[index], s, emptyBox(), EmptyChild, 0);
+					continue;
+				}
+
+				const BuildNode& child = nodes[slots[s]];
+				if (child.left == InvalidIndex)
+				{
+					cost += halfArea(child.bounds) * child.count;
+					SetChild(out[index], s, child.bounds, LeafFlag | child.first, child.count);
+				}
+				else
+				{
+					// out may grow during the recursion, only index into it afterwards
+					const uint32_t wide = Collapse(slots[s], out, depth + 1, stats, cost);
+					SetChild(out[index], s, child.bounds, wide, 0);
+				}
+			}
+			return index;
+		};
+	};
+
+	namespace
+	{
+		// Frustum planes splatted for 4 wide node tests
+		struct FrustumLanes
+		{
+#if RV_SIMD_SSE
+			__m128 nx[6], ny[6], nz[6], d[6];
+			__m128 ax[6], ay[6], az[6];
+#endif
+			const rv::Frustum* frustum;
+
+			explicit FrustumLanes(const rv::Frustum& source) : frustum(&source)
+			{
+#if RV_SIMD_SSE
+				for (int p = 0; p < 6; p++)
+				{
+					const glm::vec4& plane = source.planes[p];
+					nx[p] = _mm_set1_ps(plane.x);
+					ny[p] = _mm_set1_ps(plane.y);
+					nz[p] = _mm_set1_ps(plane.z);
+					d[p] = _mm_set1_ps(plane.w);
+					ax[p] = _mm_set1_ps(std::fabs(plane.x));
+					ay[p] = _mm_set1_ps(std::fabs(plane.y));
+					az[p] = _mm_set1_ps(std::fabs(plane.z));
+				}
+#endif
+			};
+		};
+
+		// Children intersecting the frustum, outInside gets those entirely inside it
+		template <typename NodeT>
+		unsigned testFrustum(const NodeT& node, const FrustumLanes& lanes, unsigned& outInside)
+		{
+#if RV_SIMD_SSE
+			const __m128 half = _mm_set1_ps(0.5f);
+			const __m128 minX = _mm_load_ps(node.minX), maxX = _mm_load_ps(node.maxX);
+			const __m128 minY = _mm_load_ps(node.minY), maxY = _mm_load_ps(node.maxY);
+			const __m128 minZ = _mm_load_ps(node.minZ), maxZ = _mm_load_ps(node.maxZ);
+			const __m128 cx = _mm_mul_ps(_mm_add_ps(minX, maxX), half);
+			const __m128 cy = _mm_mul_ps(_mm_add_ps(minY, maxY), half);
+			const __m128 cz = _mm_mul_ps(_mm_add_ps(minZ, maxZ), half);
+			const __m128 ex = _mm_mul_ps(_mm_sub_ps(maxX, minX), half);
+			const __m128 ey = _mm_mul_ps(_mm_sub_ps(maxY, minY), half);
+			const __m128 ez = _mm_mul_ps(_mm_sub_ps(maxZ, minZ), half);
+
+			__m128 outside = _mm_setzero_ps();
+			__m128 inside = _mm_cmpeq_ps(cx, cx);
+			for (int p = 0; p < 6; p++)
+			{
+				const __m128 distance = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(lanes.nx[p], cx), _mm_mul_ps(lanes.ny[p], cy)),
+					_mm_add_ps(_mm_mul_ps(lanes.nz[p], cz), lanes.d[p]));
+				const __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(lanes.ax[p], ex), _mm_mul_ps(lanes.ay[p], ey)),
+												 _mm_mul_ps(lanes.az[p], ez));
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_sub_ps(distance, radius), _mm_setzero_ps()));
+			}
+			const unsigned hit = ~static_cast<unsigned>(_mm_movemask_ps(outside)) & 0xF;
+			outInside = static_cast<unsigned>(_mm_movemask_ps(inside)) & hit;
+			return hit;
+#else
+			unsigned hit = 0;
+			outInside = 0;
+			for (unsigned s = 0; s < 4; s++)
+			{
+				const glm::vec3 min(node.minX[s], node.minY[s], node.minZ[s]);
+				const glm::vec3 max(node.maxX[s], node.maxY[s], node.maxZ[s]);
+				const glm::vec3 center = (min + max) * 0.5f;
+				const glm::vec3 extent = (max - min) * 0.5f;
+				bool outside = false;
+				bool inside = true;
+				for (const glm::vec4& plane : lanes.frustum->planes)
+				{
+					const float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+					const float radius = glm::dot(glm::abs(glm::vec3(plane)), extent);
+					outside |= distance + radius < 0.0f;
+					inside &= distance - radius >= 0.0f;
+				}
+				if (!outside) hit |= 1u << s;
+				if (!outside && inside) outInside |= 1u << s;
+			}
+			return hit;
+#endif
+		}
+
+		// Children overlapping box
+		template <typename NodeT>
+		unsigned testBox(const NodeT& node, const rv::AABB& box)
+		{
+#if RV_SIMD_SSE
+			__m128 overlap = _mm_cmple_ps(_mm_load_ps(node.minX), _mm_set1_ps(box.max.x));
+			overlap = _mm_and_ps(overlap, _mm_cmple_ps(_mm_load_ps(node.minY), _mm_set1_ps(box.max.y)));
+			overlap = _mm_and_ps(overlap, _mm_cmple_ps(_mm_load_ps(node.minZ), _mm_set1_ps(box.max.z)));
+			overlap = _mm_and_ps(overlap, _mm_cmpge_ps(_mm_load_ps(node.maxX), _mm_set1_ps(box.min.x)));
+			overlap = _mm_and_ps(overlap, _mm_cmpge_ps(_mm_load_ps(node.maxY), _mm_set1_ps(box.min.y)));
+			overlap = _mm_and_ps(overlap, _mm_cmpge_ps(_mm_load_ps(node.maxZ), _mm_set1_ps(box.min.z)));
+			return static_cast<unsigned>(_mm_movemask_ps(overlap));
+#else
+			unsigned hit = 0;
+			for (unsigned s = 0; s < 4; s++)
+			{
+				if (node.minX[s] <= box.max.x && node.minY[s] <= box.max.y && node.minZ[s] <= box.max.z &&
+					node.maxX[s] >= box.min.x && node.maxY[s] >= box.min.y && node.maxZ[s] >= box.min.z)
+				{
+					hit |= 1u << s;
+				}
+			}
+			return hit;
+#endif
+		}
+
+		struct RayLanes
+		{
+			glm::vec3 origin;
+			glm::vec3 inverseDirection;
+#if RV_SIMD_SSE
+			__m128 ox, oy, oz;
+			__m128 ix, iy, iz;
+#endif
+
+			RayLanes(const glm::vec3& rayOrigin, const glm::vec3& direction)
+				: origin(rayOrigin), inverseDirection(1.0f / direction)
+			{
+#if RV_SIMD_SSE
+				ox = _mm_set1_ps(origin.x);
+				oy = _mm_set1_ps(origin.y);
+				oz = _mm_set1_ps(origin.z);
+				ix = _mm_set1_ps(inverseDirection.x);
+				iy = _mm_set1_ps(inverseDirection.y);
+				iz = _mm_set1_ps(inverseDirection.z);
+#endif
+			};
+		};
+
+		// Slab test of a single box, returns the entry distance or Infinity on a miss
+		float intersectBox(const RayLanes& ray, const rv::AABB& box, float maxDistance)
+		{
+			const glm::vec3 t0 = (box.min - ray.origin) * ray.inverseDirection;
+			const glm::vec3 t1 = (box.max - ray.origin) * ray.inverseDirection;
+			const glm::vec3 near = glm::min(t0, t1);
+			const glm::vec3 far = glm::max(t0, t1);
+			const float entry = std::max(std::max(near.x, near.y), std::max(near.z, 0.0f));
+			const float exit = std::min(std::min(far.x, far.y), std::min(far.z, maxDistance));
+			return entry <= exit ? entry : Infinity;
+		}
+
+		// Children hit closer than maxDistance, with their entry distances
+		template <typename NodeT>
+		unsigned testRay(const NodeT& node, const RayLanes& ray, float maxDistance, float outEntry[4])
+		{
+#if RV_SIMD_SSE
+			const __m128 x0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minX), ray.ox), ray.ix);
+			const __m128 x1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxX), ray.ox), ray.ix);
+			const __m128 y0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minY), ray.oy), ray.iy);
+			const __m128 y1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxY), ray.oy), ray.iy);
+			const __m128 z0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.minZ), ray.oz), ray.iz);
+			const __m128 z1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.maxZ), ray.oz), ray.iz);
+			const __m128 entry =
+				_mm_max_ps(_mm_max_ps(_mm_min_ps(x0, x1), _mm_min_ps(y0, y1)),
+						   _mm_max_ps(_mm_min_ps(z0, z1), _mm_setzero_ps()));
+			const __m128 exit =
+				_mm_min_ps(_mm_min_ps(_mm_max_ps(x0, x1), _mm_max_ps(y0, y1)),
+						   _mm_min_ps(_mm_max_ps(z0, z1), _mm_set1_ps(maxDistance)));
+			_mm_storeu_ps(outEntry, entry);
+			return static_cast<unsigned>(_mm_movemask_ps(_mm_cmple_ps(entry, exit)));
+#else
+			unsigned hit = 0;
+			for (unsigned s = 0; s < 4; s++)
+			{
+				const rv::AABB box{glm::vec3(node.minX[s], node.minY[s], node.minZ[s]),
+								   glm::vec3(node.maxX[s], node.maxY[s], node.maxZ[s])};
+				outEntry[s] = intersectBox(ray, box, maxDistance);
+				if (outEntry[s] != Infinity) hit |= 1u << s;
+			}
+			return hit;
+#endif
+		}
+	} // namespace
+
+	void Bvh::Build(rv::Span<const rv::AABB> primitives, JobSystem* jobs)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		_nodes.clear();
+		_stats = Stats{};
+		_boxes.resize(primitives.size());
+		_indices.resize(primitives.size());
+		_bounds = rv::AABB{glm::vec3(0.0f), glm::vec3(0.0f)};
+		if (primitives.empty()) return;
+
+		const uint32_t count = static_cast<uint32_t>(primitives.size());
+		Builder builder(primitives, jobs);
+		const RangeBounds root = builder.ComputeBounds(0, count);
+		builder.Build(0, 0, count, root);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			_boxes[i] = builder.primitives[i].box;
+			_indices[i] = builder.primitives[i].index;
+		}
+
+		float cost = 0.0f;
+		_nodes.reserve(builder.nodeCount.load(std::memory_order_relaxed) / 2 + 1);
+		builder.Collapse(0, _nodes, 0, _stats, cost);
+		_bounds = root.bounds;
+
+		const float rootArea = halfArea(root.bounds);
+		_stats.primitiveCount = count;
+		_stats.nodeCount = static_cast<uint32_t>(_nodes.size());
+		_stats.leafCount = builder.leafCount.load(std::memory_order_relaxed);
+		_stats.sahCost = rootArea > 0.0f ? cost / (rootArea * count) : 1.0f;
+		_stats.buildMs =
+			std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	void Bvh::Refit(rv::Span<const rv::AABB> primitives, JobSystem* jobs)
+	{
+		assert(primitives.size() == _boxes.size() && "Refit needs the primitives of the last Build");
+		const auto start = std::chrono::steady_clock::now();
+		if (_nodes.empty()) return;
+
+		// Gather into leaf order once, the node pass and every query then read the boxes sequentially
+		const auto gather = [this, primitives](uint32_t begin, uint32_t end) {
+			for (uint32_t i = begin; i < end; i++)
+			{
+				_boxes[i] = primitives[_indices[i]];
+			}
+		};
+		const uint32_t count = static_cast<uint32_t>(_boxes.size());
+		if (jobs && count >= ParallelBinThreshold)
+		{
+			jobs->ParallelFor(count, BinBatchSize, gather);
+		}
+		else
+		{
+			gather(0, count);
+		}
+
+		// Children always come after their parent, so walking backwards finishes them first
+		for (uint32_t node = static_cast<uint32_t>(_nodes.size()); node-- > 0;)
+		{
+			RefitNode(node);
+		}
+
+		_bounds = emptyBox();
+		const Node& root = _nodes[0];
+		for (uint32_t s = 0; s < 4; s++)
+		{
+			if (root.children[s] == EmptyChild) continue;
+			grow(_bounds, rv::AABB{glm::vec3(root.minX[s], root.minY[s], root.minZ[s]),
+								   glm::vec3(root.maxX[s], root.maxY[s], root.maxZ[s])});
+		}
+		_stats.refitMs =
+			std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	void Bvh::RefitNode(uint32_t index)
+	{
+		Node& node = _nodes[index];
+		for (uint32_t s = 0; s < 4; s++)
+		{
+			const uint32_t child = node.children[s];
+			if (child == EmptyChild) continue;
+
+			rv::AABB box = emptyBox();
+			if (child & LeafFlag)
+			{
+				const uint32_t first = child & ~LeafFlag;
+				for (uint32_t i = first; i < first + node.counts[s]; i++)
+				{
+					grow(box, _boxes[i]);
+				}
+			}
+			else
+			{
+				const Node& inner = _nodes[child];
+				for (uint32_t c = 0; c < 4; c++)
+				{
+					if (inner.children[c] == EmptyChild) continue;
+					grow(box, rv::AABB{glm::vec3(inner.minX[c], inner.minY[c], inner.minZ[c]),
+									   glm::vec3(inner.maxX[c], inner.maxY[c], inner.maxZ[c])});
+				}
+			}
+			Builder::SetChild(node, s, box, child, node.counts[s]);
+		}
+	}
+
+	void Bvh::AppendSubtree(uint32_t child, uint32_t count, std::vector<uint32_t>& outPrimitives) const
+	{
+		if (child & LeafFlag)
+		{
+			const uint32_t first = child & ~LeafFlag;
+			outPrimitives.insert(outPrimitives.end(), _indices.begin() + first, _indices.begin() + first + count);
+			return;
+		}
+
+		const Node& node = _nodes[child];
+		for (uint32_t s = 0; s < 4; s++)
+		{
+			if (node.children[s] != EmptyChild) AppendSubtree(node.children[s], node.counts[s], outPrimitives);
+		}
+	}
+
+	void Bvh::QueryFrustum(const rv::Frustum& frustum, std::vector<uint32_t>& outPrimitives) const
+	{
+		if (_nodes.empty()) return;
+
+		const FrustumLanes lanes(frustum);
+		rv::SmallVector<uint32_t, 64> stack;
+		stack.push_back(0);
+		while (!stack.empty())
+		{
+			const Node& node = _nodes[stack.back()];
+			stack.pop_back();
+
+			unsigned inside;
+			for (unsigned hit = testFrustum(node, lanes, inside); hit; hit &= hit - 1)
+			{
+				const uint32_t s = rv::countTrailingZeros(static_cast<uint32_t>(hit));
+				const uint32_t child = node.children[s];
+				if (child == EmptyChild) continue;
+
+				if (inside & (1u << s))
+				{
+					AppendSubtree(child, node.counts[s], outPrimitives);
+				}
+				else if (child & LeafFlag)
+				{
+					const uint32_t first = child & ~LeafFlag;
+					for (uint32_t i = first; i < first + node.counts[s]; i++)
+					{
+						const rv::AABB& box = _boxes[i];
+						if (frustum.TestBounds((box.min + box.max) * 0.5f, (box.max - box.min) * 0.5f))
+						{
+							outPrimitives.push_back(_indices[i]);
+						}
+					}
+				}
+				else
+				{
+					stack.push_back(child);
+				}
+			}
+		}
+	}
+
+	void Bvh::QueryAABB(const rv::AABB& box, std::vector<uint32_t>& outPrimitives) const
+	{
+		if (_nodes.empty()) return;
+
+		rv::SmallVector<uint32_t, 64> stack;
+		stack.push_back(0);
+		while (!stack.empty())
+		{
+			const Node& node = _nodes[stack.back()];
+			stack.pop_back();
+
+			for (unsigned hit = testBox(node, box); hit; hit &= hit - 1)
+			{
+				const uint32_t s = rv::countTrailingZeros(static_cast<uint32_t>(hit));
+				const uint32_t child = node.children[s];
+				if (child == EmptyChild) continue;
+
+				if (!(child & LeafFlag))
+				{
+					stack.push_back(child);
+					continue;
+				}
+
+				const uint32_t first = child & ~LeafFlag;
+				for (uint32_t i = first; i < first + node.counts[s]; i++)
+				{
+					const rv::AABB& primitive = _boxes[i];
+					if (glm::all(glm::lessThanEqual(primitive.min, box.max)) &&
+						glm::all(glm::greaterThanEqual(primitive.max, box.min)))
+					{
+						outPrimitives.push_back(_indices[i]);
+					}
+				}
+			}
+		}
+	}
+
+	bool Bvh::Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+					  RayHit& outHit) const
+	{
+		if (_nodes.empty()) return false;
+
+		struct Entry
+		{
+			uint32_t node;
+			float distance;
+		};
+
+		const RayLanes ray(origin, glm::normalize(direction));
+		float closest = maxDistance;
+		uint32_t closestPrimitive = InvalidIndex;
+
+		rv::SmallVector<Entry, 64> stack;
+		stack.push_back(Entry{0, 0.0f});
+		while (!stack.empty())
+		{
+			const Entry entry = stack.back();
+			stack.pop_back();
+			// Something nearer was found since this node was pushed
+			if (entry.distance > closest) continue;
+
+			const Node& node = _nodes[entry.node];
+			float distances[4];
+			unsigned hit = testRay(node, ray, closest, distances);
+
+			// Inner children go on the stack farthest first so the nearest one is visited next
+			Entry inner[4];
+			uint32_t innerCount = 0;
+			for (; hit; hit &= hit - 1)
+			{
+				const uint32_t s = rv::countTrailingZeros(static_cast<uint32_t>(hit));
+				const uint32_t child = node.children[s];
+				if (child == EmptyChild) continue;
+
+				if (!(child & LeafFlag))
+				{
+					uint32_t position = innerCount++;
+					for (; position > 0 && inner[position - 1].distance < distances[s]; position--)
+					{
+						inner[position] = inner[position - 1];
+					}
+					inner[position] = Entry{child, distances[s]};
+					continue;
+				}
+
+				const uint32_t first = child & ~LeafFlag;
+				for (uint32_t i = first; i < first + node.counts[s]; i++)
+				{
+					const float distance = intersectBox(ray, _boxes[i], closest);
+					if (distance < closest || (distance == closest && closestPrimitive == InvalidIndex))
+					{
+						closest = distance;
+						closestPrimitive = _indices[i];
+					}
+				}
+			}
+			for (uint32_t i = 0; i < innerCount; i++)
+			{
+				stack.push_back(inner[i]);
+			}
+		}
+
+		if (closestPrimitive == InvalidIndex) return false;
+		outHit = RayHit{closestPrimitive, closest};
+		return true;
+	}
+
+} // namespace gefx
@@ -0,0 +1,131 @@
+#ifndef __BVH__H__
+#define __BVH__H__
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <core/jobs.h>
+#include <core/math/frustum.h>
+#include <core/math/transform.h>
+#include <core/span.h>
+
+namespace gefx
+{
+	struct RayHit
+	{
+		uint32_t primitive;
+		float distance;
+	};
+
+	/**
+	 * @brief Bounding volume hierarchy over axis aligned primitive boxes.
+	 *
+	 * Built top down with binned SAH along the longest centroid axis, down to leaves of at most MaxLeafSize
+	 * primitives: large nodes bin their primitives in parallel and subtrees are handed to the job system once
+	 * they are independent. The binary tree is then collapsed into 4 wide nodes stored depth first, each
+	 * holding its children's boxes as structure of arrays so one node is two cache lines and all four children
+	 * are tested with a single SIMD pass during traversal.
+	 *
+	 * Primitives are identified by their index in the span given to Build. Refit keeps the topology and only
+	 * recomputes the boxes, which is enough for objects that move coherently; rebuild when the tree degrades.
+	 */
+	class Bvh
+	{
+	  public:
+		static constexpr uint32_t MaxLeafSize = 4;
+
+		struct Stats
+		{
+			uint32_t primitiveCount{0};
+			uint32_t nodeCount{0};
+			uint32_t leafCount{0};
+			uint32_t maxDepth{0};
+			// Expected traversal cost relative to testing every primitive, lower is better
+			float sahCost{0.0f};
+			double buildMs{0.0};
+			double refitMs{0.0};
+		};
+
+		Bvh() = default;
+		~Bvh() = default;
+
+		Bvh(Bvh&&) = default;
+		Bvh(const Bvh&) = delete;
+		Bvh& operator=(Bvh&&) = default;
+		Bvh& operator=(const Bvh&) = delete;
+
+		/**
+		 * @brief Build over primitives, replacing the previous tree.
+		 *
+		 * @param jobs Job system to build on, nullptr builds on the calling thread.
+		 */
+		void Build(rv::Span<const rv::AABB> primitives, JobSystem* jobs = nullptr);
+
+		/**
+		 * @brief Update every box bottom up after primitives moved. Must be the same primitives, in the same
+		 * order, as the last Build.
+		 *
+		 * @param jobs Job system to gather the primitive boxes on, nullptr refits on the calling thread.
+		 */
+		void Refit(rv::Span<const rv::AABB> primitives, JobSystem* jobs = nullptr);
+
+		/**
+		 * @brief Append the primitives whose box intersects the frustum. Subtrees fully inside are appended
+		 * without testing their primitives.
+		 */
+		void QueryFrustum(const rv::Frustum& frustum, std::vector<uint32_t>& outPrimitives) const;
+
+		/**
+		 * @brief Append the primitives whose box overlaps box.
+		 */
+		void QueryAABB(const rv::AABB& box, std::vector<uint32_t>& outPrimitives) const;
+
+		/**
+		 * @brief Nearest primitive box hit by the ray within maxDistance, nearest children are visited first.
+		 * Hits are against primitive boxes, refine them against the actual geometry if that matters.
+		 *
+		 * @return False when nothing was hit.
+		 */
+		bool Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& outHit) const;
+
+		bool Empty() const { return _nodes.empty(); };
+		size_t GetPrimitiveCount() const { return _boxes.size(); };
+		const rv::AABB& GetBounds() const { return _bounds; };
+		const Stats& GetStats() const { return _stats; };
+
+	  private:
+		static constexpr uint32_t LeafFlag = 0x80000000u;
+		static constexpr uint32_t EmptyChild = ~0u;
+
+		/**
+		 * @brief Four children as structure of arrays. An inner child stores its node index, a leaf child
+		 * LeafFlag | first primitive position with its count in counts. Unused slots hold EmptyChild and an
+		 * inverted box that no test passes.
+		 */
+		struct alignas(64) Node
+		{
+			float minX[4], minY[4], minZ[4];
+			float maxX[4], maxY[4], maxZ[4];
+			uint32_t children[4];
+			uint32_t counts[4];
+		};
+
+		struct Builder;
+
+		void RefitNode(uint32_t node);
+		void AppendSubtree(uint32_t child, uint32_t count, std::vector<uint32_t>& outPrimitives) const;
+
+		// Depth first, parents before their children, _nodes[0] is the root
+		std::vector<Node> _nodes;
+		// Primitive boxes and indices in leaf order, leaves reference ranges of them
+		std::vector<rv::AABB> _boxes;
+		std::vector<uint32_t> _indices;
+		rv::AABB _bounds{glm::vec3(0.0f), glm::vec3(0.0f)};
+		Stats _stats;
+	};
+
+} // namespace gefx
+
+#endif //!__BVH__H__
@@ -0,0 +1,306 @@
+// StdLib Includes
+#include <algorithm>
+
+// Application Specific Includes
+#include <core/scene/transformhierarchy.h>
+
+namespace gefx
+{
+	namespace
+	{
+		// Nodes per job, and the level size below which spreading it isn't worth the scheduling
+		constexpr uint32_t BatchSize = 256;
+		constexpr uint32_t ParallelThreshold = 4 * BatchSize;
+
+		template <typename T>
+		void permute(std::vector<T>& values, const std::vector<uint32_t>& order)
+		{
+			std::vector<T> permuted(order.size());
+			for (size_t i = 0; i < order.size(); i++)
+			{
+				permuted[i] = values[order[i]];
+			}
+			values.swap(permuted);
+		}
+	} // namespace
+
+	TransformNode TransformHierarchy::Create(TransformNode parent, const glm::vec3& position,
+											 const glm::quat& rotation, const glm::vec3& scale)
+	{
+		uint32_t slot;
+		if (!_freeSlots.empty())
+		{
+			slot = _freeSlots.back();
+			_freeSlots.pop_back();
+		}
+		else
+		{
+			assert(_slots.size() < TransformNode::MaxCount && "transform node limit reached");
+			slot = static_cast<uint32_t>(_slots.size());
+			_slots.emplace_back();
+		}
+
+		const uint32_t parentDense = parent.IsNull() ? InvalidIndex : GetDense(parent);
+		const uint32_t dense = static_cast<uint32_t>(_slotOf.size());
+		_slots[slot].dense = dense;
+
+		_local.Resize(dense + 1);
+		_local.Set(dense, position, rotation, scale);
+		_world.emplace_back(1.0f);
+		_parent.push_back(parentDense);
+		_depth.push_back(parentDense == InvalidIndex ? 0 : _depth[parentDense] + 1);
+		_childBegin.push_back(0);
+		_childCount.push_back(0);
+		_slotOf.push_back(slot);
+		_dirty.push_back(0);
+		_removed.push_back(0);
+		_dirtyList.resize(dense + 1);
+
+		// Appending breaks the breadth first order unless this is a root, Update sorts it out
+		_structureDirty = true;
+		_nodeCount++;
+		MarkDirty(dense);
+		return TransformNode(slot, _slots[slot].generation);
+	}
+
+	void TransformHierarchy::Destroy(TransformNode node)
+	{
+		if (!IsValid(node)) return;
+		_removed[GetDense(node)] = 1;
+		_structureDirty = true;
+		_nodeCount--;
+	}
+
+	void TransformHierarchy::SetParent(TransformNode node, TransformNode parent)
+	{
+		const uint32_t dense = GetDense(node);
+		const uint32_t parentDense = parent.IsNull() ? InvalidIndex : GetDense(parent);
+		for (uint32_t ancestor = parentDense; ancestor != InvalidIndex; ancestor = _parent[ancestor])
+		{
+			assert(ancestor != dense && "SetParent would create a cycle");
+		}
+
+		_parent[dense] = parentDense;
+		_structureDirty = true;
+		MarkDirty(dense);
+	}
+
+	void TransformHierarchy::Rebuild()
+	{
+		const uint32_t count = static_cast<uint32_t>(_slotOf.size());
+
+		// Children of every live node, kept in their current relative order
+		std::vector<uint32_t> childOffsets(count + 1, 0);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			if (!_removed[i] && _parent[i] != InvalidIndex) childOffsets[_parent[i] + 1]++;
+		}
+		for (uint32_t i = 0; i < count; i++)
+		{
+			childOffsets[i + 1] += childOffsets[i];
+		}
+		std::vector<uint32_t> children(childOffsets[count]);
+		std::vector<uint32_t> cursor(childOffsets.begin(), childOffsets.end() - 1);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			if (!_removed[i] && _parent[i] != InvalidIndex) children[cursor[_parent[i]]++] = i;
+		}
+
+		// Breadth first walk from the roots, subtrees of removed nodes are never reached
+		std::vector<uint32_t> order;
+		std::vector<uint32_t> newIndex(count, InvalidIndex);
+		order.reserve(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			if (!_removed[i] && _parent[i] == InvalidIndex)
+			{
+				newIndex[i] = static_cast<uint32_t>(order.size());
+				order.push_back(i);
+			}
+		}
+
+		std::vector<uint32_t> childBegin;
+		std::vector<uint32_t> childCount;
+		childBegin.reserve(count);
+		childCount.reserve(count);
+		for (size_t head = 0; head < order.size(); head++)
+		{
+			const uint32_t node = order[head];
+			childBegin.push_back(static_cast<uint32_t>(order.size()));
+			for (uint32_t c = childOffsets[node]; c < childOffsets[node + 1]; c++)
+			{
+				newIndex[children[c]] = static_cast<uint32_t>(order.size());
+				order.push_back(children[c]);
+			}
+			childCount.push_back(static_cast<uint32_t>(order.size()) - childBegin.back());
+		}
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			if (newIndex[i] != InvalidIndex) continue;
+			Slot& slot = _slots[_slotOf[i]];
+			const uint32_t next = (slot.generation + 1) & TransformNode::GenerationMask;
+			slot.generation = next == 0 ? 1 : next;
+			slot.dense = InvalidIndex;
+			_freeSlots.push_back(_slotOf[i]);
+		}
+
+		for (std::vector<float>* array : {&_local.posX, &_local.posY, &_local.posZ, &_local.rotX, &_local.rotY,
+										  &_local.rotZ, &_local.rotW, &_local.scaleX, &_local.scaleY, &_local.scaleZ})
+		{
+			permute(*array, order);
+		}
+		permute(_world, order);
+		permute(_slotOf, order);
+		permute(_dirty, order);
+		permute(_parent, order);
+
+		const uint32_t newCount = static_cast<uint32_t>(order.size());
+		_depth.resize(newCount);
+		uint32_t levels = 0;
+		for (uint32_t i = 0; i < newCount; i++)
+		{
+			if (_parent[i] != InvalidIndex) _parent[i] = newIndex[_parent[i]];
+			_depth[i] = _parent[i] == InvalidIndex ? 0 : _depth[_parent[i]] + 1;
+			levels = std::max(levels, _depth[i] + 1);
+			_slots[_slotOf[i]].dense = i;
+		}
+		_childBegin.swap(childBegin);
+		_childCount.swap(childCount);
+		_removed.assign(newCount, 0);
+
+		// Depths never decrease in breadth first order
+		_levelBegin.assign(levels + 1, newCount);
+		for (uint32_t i = newCount; i-- > 0;)
+		{
+			_levelBegin[_depth[i]] = i;
+		}
+
+		uint32_t dirtyCount = 0;
+		for (uint32_t k = 0; k < _dirtyCount.load(std::memory_order_relaxed); k++)
+		{
+			const uint32_t moved = newIndex[_dirtyList[k]];
+			if (moved != InvalidIndex) _dirtyList[dirtyCount++] = moved;
+		}
+		_dirtyList.resize(newCount);
+		_dirtyCount.store(dirtyCount, std::memory_order_relaxed);
+		_nodeCount = newCount;
+	}
+
+	void TransformHierarchy::UpdateRange(Range range)
+	{
+		rv::composeTRS(_local, range.begin, range.end, _world.data());
+
+		// Siblings are contiguous, so each run of them is one batched multiply by the shared parent matrix
+		for (uint32_t i = range.begin; i < range.end;)
+		{
+			const uint32_t parent = _parent[i];
+			uint32_t end = i + 1;
+			while (end < range.end && _parent[end] == parent)
+			{
+				end++;
+			}
+			if (parent != InvalidIndex) rv::multiplyMatrices(_world[parent], &_world[i], end - i, &_world[i]);
+			i = end;
+		}
+	}
+
+	void TransformHierarchy::Update(JobSystem* jobs)
+	{
+		_stats = Stats{};
+		if (_structureDirty)
+		{
+			Rebuild();
+			_structureDirty = false;
+			_stats.rebuilt = true;
+		}
+		_stats.nodeCount = static_cast<uint32_t>(_nodeCount);
+		_updatedRanges.clear();
+
+		const uint32_t levels = _levelBegin.empty() ? 0 : static_cast<uint32_t>(_levelBegin.size() - 1);
+		if (_levelRanges.size() < levels) _levelRanges.resize(levels);
+
+		const uint32_t dirtyCount = _dirtyCount.load(std::memory_order_acquire);
+		for (uint32_t k = 0; k < dirtyCount; k++)
+		{
+			const uint32_t dense = _dirtyList[k];
+			_dirty[dense] = 0;
+			_levelRanges[_depth[dense]].push_back(Range{dense, dense + 1});
+		}
+		_dirtyCount.store(0, std::memory_order_relaxed);
+
+		for (uint32_t level = 0; level < levels; level++)
+		{
+			std::vector<Range>& ranges = _levelRanges[level];
+			if (ranges.empty()) continue;
+
+			// Dirty nodes and the children of last level's ranges may overlap, merge them into disjoint ranges
+			std::sort(ranges.begin(), ranges.end(), [](const Range& a, const Range& b) { return a.begin < b.begin; });
+			size_t merged = 0;
+			for (size_t i = 1; i < ranges.size(); i++)
+			{
+				if (ranges[i].begin <= ranges[merged].end)
+				{
+					ranges[merged].end = std::max(ranges[merged].end, ranges[i].end);
+				}
+				else
+				{
+					ranges[++merged] = ranges[i];
+				}
+			}
+			ranges.resize(merged + 1);
+
+			// Long ranges are split and short ones packed, so every job gets about BatchSize nodes
+			_pieces.clear();
+			_batches.clear();
+			uint32_t nodes = 0;
+			uint32_t batchNodes = 0;
+			for (const Range& range : ranges)
+			{
+				for (uint32_t begin = range.begin; begin < range.end;)
+				{
+					const uint32_t end = std::min(begin + (BatchSize - batchNodes), range.end);
+					if (batchNodes == 0) _batches.push_back(Range{static_cast<uint32_t>(_pieces.size()), 0});
+					_pieces.push_back(Range{begin, end});
+					_batches.back().end = static_cast<uint32_t>(_pieces.size());
+					batchNodes = (batchNodes + end - begin) % BatchSize;
+					begin = end;
+				}
+				nodes += range.end - range.begin;
+			}
+
+			const auto updateBatches = [this](uint32_t begin, uint32_t end) {
+				for (uint32_t batch = begin; batch < end; batch++)
+				{
+					for (uint32_t piece = _batches[batch].begin; piece < _batches[batch].end; piece++)
+					{
+						UpdateRange(_pieces[piece]);
+					}
+				}
+			};
+			if (jobs && nodes >= ParallelThreshold)
+			{
+				jobs->ParallelFor(static_cast<uint32_t>(_batches.size()), 1, updateBatches);
+			}
+			else
+			{
+				updateBatches(0, static_cast<uint32_t>(_batches.size()));
+			}
+
+			// Children of a contiguous range are contiguous on the next level
+			for (const Range& range : ranges)
+			{
+				_updatedRanges.push_back(range);
+				const uint32_t childBegin = _childBegin[range.begin];
+				const uint32_t childEnd = _childBegin[range.end - 1] + _childCount[range.end - 1];
+				if (childBegin < childEnd) _levelRanges[level + 1].push_back(Range{childBegin, childEnd});
+			}
+
+			_stats.updatedNodes += nodes;
+			_stats.updatedRanges += static_cast<uint32_t>(ranges.size());
+			_stats.levels++;
+			ranges.clear();
+		}
+	}
+
+} // namespace gefx
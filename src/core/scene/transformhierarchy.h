@@ -0,0 +1,227 @@
+#ifndef __TRANSFORMHIERARCHY__H__
+#define __TRANSFORMHIERARCHY__H__
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <core/containers/handlepool.h>
+#include <core/jobs.h>
+#include <core/math/transform.h>
+
+namespace gefx
+{
+	struct TransformNodeTag;
+	using TransformNode = rv::Handle<TransformNodeTag>;
+
+	/**
+	 * @brief Scene graph of local TRS transforms and their world matrices.
+	 *
+	 * Nodes are stored as structure of arrays in breadth first order: every depth level is one contiguous
+	 * range, parents come before their children and the children of one node (and of consecutive nodes) are
+	 * contiguous too. Changing a local transform only flags the node; Update recomputes the flagged nodes and
+	 * their subtrees level by level, as a list of merged ranges, so its cost follows the number of changed
+	 * nodes rather than the size of the graph. Ranges of one level are independent and run on the job system.
+	 *
+	 * Local setters may be called concurrently for different nodes. Create, Destroy and SetParent are not
+	 * thread safe; they reorder the arrays lazily at the next Update.
+	 */
+	class TransformHierarchy
+	{
+	  public:
+		struct Range
+		{
+			uint32_t begin;
+			uint32_t end;
+		};
+
+		struct Stats
+		{
+			uint32_t nodeCount{0};
+			uint32_t updatedNodes{0};
+			uint32_t updatedRanges{0};
+			uint32_t levels{0};
+			bool rebuilt{false};
+		};
+
+		TransformHierarchy() = default;
+		~TransformHierarchy() = default;
+
+		TransformHierarchy(TransformHierarchy&&) = delete;
+		TransformHierarchy(const TransformHierarchy&) = delete;
+		TransformHierarchy& operator=(TransformHierarchy&&) = delete;
+		TransformHierarchy& operator=(const TransformHierarchy&) = delete;
+
+		TransformNode Create(TransformNode parent = {}, const glm::vec3& position = glm::vec3(0.0f),
+							 const glm::quat& rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
+							 const glm::vec3& scale = glm::vec3(1.0f));
+
+		/**
+		 * @brief Destroy node and its whole subtree. Descendant handles go stale at the next Update.
+		 */
+		void Destroy(TransformNode node);
+
+		/**
+		 * @brief Move node (with its subtree) under parent, a null parent makes it a root.
+		 */
+		void SetParent(TransformNode node, TransformNode parent);
+
+		bool IsValid(TransformNode node) const
+		{
+			const uint32_t slot = node.GetIndex();
+			return !node.IsNull() && slot < _slots.size() && _slots[slot].generation == node.GetGeneration() &&
+				   !_removed[_slots[slot].dense];
+		};
+
+		size_t Size() const { return _nodeCount; };
+
+		void SetLocal(TransformNode node, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+		{
+			const uint32_t dense = GetDense(node);
+			_local.Set(dense, position, rotation, scale);
+			MarkDirty(dense);
+		};
+
+		void SetPosition(TransformNode node, const glm::vec3& position)
+		{
+			const uint32_t dense = GetDense(node);
+			_local.posX[dense] = position.x;
+			_local.posY[dense] = position.y;
+			_local.posZ[dense] = position.z;
+			MarkDirty(dense);
+		};
+
+		void SetRotation(TransformNode node, const glm::quat& rotation)
+		{
+			const uint32_t dense = GetDense(node);
+			_local.rotX[dense] = rotation.x;
+			_local.rotY[dense] = rotation.y;
+			_local.rotZ[dense] = rotation.z;
+			_local.rotW[dense] = rotation.w;
+			MarkDirty(dense);
+		};
+
+		void SetScale(TransformNode node, const glm::vec3& scale)
+		{
+			const uint32_t dense = GetDense(node);
+			_local.scaleX[dense] = scale.x;
+			_local.scaleY[dense] = scale.y;
+			_local.scaleZ[dense] = scale.z;
+			MarkDirty(dense);
+		};
+
+		glm::vec3 GetPosition(TransformNode node) const
+		{
+			const uint32_t dense = GetDense(node);
+			return glm::vec3(_local.posX[dense], _local.posY[dense], _local.posZ[dense]);
+		};
+
+		glm::quat GetRotation(TransformNode node) const
+		{
+			const uint32_t dense = GetDense(node);
+			return glm::quat(_local.rotW[dense], _local.rotX[dense], _local.rotY[dense], _local.rotZ[dense]);
+		};
+
+		glm::vec3 GetScale(TransformNode node) const
+		{
+			const uint32_t dense = GetDense(node);
+			return glm::vec3(_local.scaleX[dense], _local.scaleY[dense], _local.scaleZ[dense]);
+		};
+
+		TransformNode GetParent(TransformNode node) const
+		{
+			const uint32_t parent = _parent[GetDense(node)];
+			return parent == InvalidIndex ? TransformNode{} : GetHandle(parent);
+		};
+
+		/**
+		 * @brief World matrix as of the last Update.
+		 */
+		const glm::mat4& GetWorld(TransformNode node) const { return _world[GetDense(node)]; };
+
+		/**
+		 * @brief Propagate every local change made since the last Update to the world matrices.
+		 *
+		 * @param jobs Job system to spread large levels on, nullptr updates on the calling thread.
+		 */
+		void Update(JobSystem* jobs = nullptr);
+
+		/**
+		 * @brief Dense ranges whose world matrices changed during the last Update, for consumers that mirror
+		 * them (bounds, GPU buffers, ...). Only valid until the next structural change.
+		 */
+		const std::vector<Range>& GetUpdatedRanges() const { return _updatedRanges; };
+		const Stats& GetStats() const { return _stats; };
+
+		// Dense order access, valid between structural changes
+		uint32_t GetDenseIndex(TransformNode node) const { return GetDense(node); };
+		TransformNode GetHandle(uint32_t dense) const
+		{
+			const uint32_t slot = _slotOf[dense];
+			return TransformNode(slot, _slots[slot].generation);
+		};
+		const glm::mat4* GetWorldMatrices() const { return _world.data(); };
+
+	  private:
+		static constexpr uint32_t InvalidIndex = ~0u;
+
+		struct Slot
+		{
+			uint32_t dense{InvalidIndex};
+			uint32_t generation{1};
+		};
+
+		uint32_t GetDense(TransformNode node) const
+		{
+			assert(IsValid(node) && "stale or null transform node");
+			return _slots[node.GetIndex()].dense;
+		};
+
+		void MarkDirty(uint32_t dense)
+		{
+			if (_dirty[dense]) return;
+			_dirty[dense] = 1;
+			_dirtyList[_dirtyCount.fetch_add(1, std::memory_order_relaxed)] = dense;
+		};
+
+		void Rebuild();
+		void UpdateRange(Range range);
+
+		// Dense, breadth first
+		rv::TransformSoA _local;
+		std::vector<glm::mat4> _world;
+		std::vector<uint32_t> _parent;
+		std::vector<uint32_t> _depth;
+		// First child position, leaves get the position their first child would have so it never decreases
+		std::vector<uint32_t> _childBegin;
+		std::vector<uint32_t> _childCount;
+		std::vector<uint32_t> _slotOf;
+		std::vector<uint8_t> _dirty;
+		std::vector<uint8_t> _removed;
+		std::vector<uint32_t> _levelBegin;
+		size_t _nodeCount{0};
+		bool _structureDirty{false};
+
+		std::vector<Slot> _slots;
+		std::vector<uint32_t> _freeSlots;
+
+		// Sized to the dense node count so concurrent setters only need the atomic cursor
+		std::vector<uint32_t> _dirtyList;
+		std::atomic<uint32_t> _dirtyCount{0};
+
+		// Update scratch
+		std::vector<std::vector<Range>> _levelRanges;
+		std::vector<Range> _pieces;
+		// Ranges of _pieces, one per job
+		std::vector<Range> _batches;
+		std::vector<Range> _updatedRanges;
+		Stats _stats;
+	};
+
+} // namespace gefx
+
+#endif //!__TRANSFORMHIERARCHY__H__
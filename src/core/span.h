@@ -0,0 +1,65 @@
+#ifndef __SPAN__H__
+#define __SPAN__H__
+
+#include <cstddef>
+#include <cassert>
+#include <type_traits>
+
+namespace rv
+{
+	/**
+	 * @brief Non-owning view over a contiguous sequence (stand-in for C++20 std::span).
+	 */
+	template <typename T>
+	class Span
+	{
+	  public:
+		using element_type = T;
+		using value_type = std::remove_cv_t<T>;
+		using iterator = T*;
+
+		constexpr Span() : _data(nullptr), _size(0){};
+		constexpr Span(T* data, size_t size) : _data(data), _size(size){};
+		constexpr Span(T* begin, T* end) : _data(begin), _size(static_cast<size_t>(end - begin)){};
+
+		template <size_t N>
+		constexpr Span(T (&arr)[N]) : _data(arr), _size(N){};
+
+		// Allow Span<const T> from Span<T>
+		template <typename U, typename = std::enable_if_t<std::is_convertible_v<U (*)[], T (*)[]>>>
+		constexpr Span(const Span<U>& other) : _data(other.data()), _size(other.size()){};
+
+		// Allow construction from containers exposing data() and size() (std::vector, std::string, ...)
+		template <typename Container,
+			  typename = std::enable_if_t<!std::is_same_v<std::decay_t<Container>, Span> &&
+						      std::is_convertible_v<decltype(std::declval<Container&>().data()), T*>>>
+		constexpr Span(Container& container) : _data(container.data()), _size(container.size()){};
+
+		constexpr T* data() const { return _data; };
+		constexpr size_t size() const { return _size; };
+		constexpr size_t size_bytes() const { return _size * sizeof(T); };
+		constexpr bool empty() const { return _size == 0; };
+
+		constexpr T* begin() const { return _data; };
+		constexpr T* end() const { return _data + _size; };
+
+		constexpr T& operator[](size_t idx) const
+		{
+			assert(idx < _size);
+			return _data[idx];
+		};
+
+		constexpr Span subspan(size_t offset, size_t count = size_t(-1)) const
+		{
+			assert(offset <= _size);
+			return Span(_data + offset, count == size_t(-1) || offset + count > _size ? _size - offset : count);
+		};
+
+	  private:
+		T* _data;
+		size_t _size;
+	};
+
+} // namespace rv
+
+#endif //!__SPAN__H__
@@ -0,0 +1,242 @@
+#ifndef __STRINGID__H__
+#define __STRINGID__H__
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string_view>
+
+#include <core/utils.h>
+
+// Debug builds keep the source strings around for collision detection and reverse lookup
+#if !defined(RV_STRINGID_DEBUG)
+#if defined(NDEBUG)
+#define RV_STRINGID_DEBUG 0
+#else
+#define RV_STRINGID_DEBUG 1
+#endif
+#endif
+
+// Literals are only interned when constructed at run time, telling that apart needs the compiler's builtin
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#define RV_STRINGID_INTERN_LITERALS RV_STRINGID_DEBUG
+#endif
+#endif
+#if !defined(RV_STRINGID_INTERN_LITERALS)
+#if (defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 9) || (defined(_MSC_VER) && _MSC_VER >= 1925)
+#define RV_STRINGID_INTERN_LITERALS RV_STRINGID_DEBUG
+#else
+#define RV_STRINGID_INTERN_LITERALS 0
+#endif
+#endif
+
+namespace rv
+{
+	/**
+	 * @brief Lock-free, insert-only global table mapping StringId hashes back to their source strings.
+	 * Slots are claimed with a CAS on the hash, the string pointer is published afterwards, so readers
+	 * that find a matching hash spin until the pointer becomes visible. Strings are never released.
+	 */
+	class StringTable
+	{
+	  public:
+		static constexpr uint32_t Capacity = 1u << 16;
+
+		static StringTable& Get()
+		{
+			static StringTable table;
+			return table;
+		}
+
+		/**
+		 * @brief Register a string under the given hash, asserting if a different string already owns it.
+		 *
+		 * @param hash crc32_view hash of str.
+		 * @param str String to be registered.
+		 * @return const char* Interned copy of the string, or nullptr if the table is full.
+		 */
+		const char* Intern(uint32_t hash, std::string_view str)
+		{
+			if (hash == 0) return "";
+
+			uint32_t idx = hash & (Capacity - 1);
+			for (uint32_t probe = 0; probe < Capacity; probe++, idx = (idx + 1) & (Capacity - 1))
+			{
+				Slot& slot = _slots[idx];
+				uint32_t slotHash = slot.hash.load(std::memory_order_acquire);
+				if (slotHash == 0)
+				{
+					if (slot.hash.compare_exchange_strong(slotHash, hash, std::memory_order_acq_rel))
+					{
+						char* copy = new char[str.size() + 1];
+						memcpy(copy, str.data(), str.size());
+						copy[str.size()] = '\0';
+						slot.str.store(copy, std::memory_order_release);
+						return copy;
+					}
+					// Lost the race, slotHash now holds the winner's hash
+				}
+
+				if (slotHash == hash)
+				{
+					const char* owner = WaitForString(slot);
+					assert(str == owner && "StringId hash collision detected!");
+					return owner;
+				}
+			}
+
+			assert(false && "StringTable is full");
+			return nullptr;
+		}
+
+		/**
+		 * @brief Reverse lookup of a previously interned hash.
+		 *
+		 * @param hash Hash to look for.
+		 * @return const char* Interned string, or nullptr if the hash was never registered.
+		 */
+		const char* Find(uint32_t hash) const
+		{
+			if (hash == 0) return "";
+
+			uint32_t idx = hash & (Capacity - 1);
+			for (uint32_t probe = 0; probe < Capacity; probe++, idx = (idx + 1) & (Capacity - 1))
+			{
+				const Slot& slot = _slots[idx];
+				uint32_t slotHash = slot.hash.load(std::memory_order_acquire);
+				if (slotHash == 0) return nullptr;
+				if (slotHash == hash) return WaitForString(slot);
+			}
+			return nullptr;
+		}
+
+		StringTable(StringTable&&) = delete;
+		StringTable(const StringTable&) = delete;
+		StringTable& operator=(StringTable&&) = delete;
+		StringTable& operator=(const StringTable&) = delete;
+
+	  private:
+		StringTable() = default;
+		~StringTable() = default;
+
+		struct Slot
+		{
+			std::atomic<uint32_t> hash{0};
+			std::atomic<const char*> str{nullptr};
+		};
+
+		static const char* WaitForString(const Slot& slot)
+		{
+			const char* str;
+			while ((str = slot.str.load(std::memory_order_acquire)) == nullptr)
+			{
+			}
+			return str;
+		}
+
+		Slot _slots[Capacity];
+	};
+
+	/**
+	 * @brief 32-bit hashed string identifier. Literals are hashed at compile time, runtime strings are hashed
+	 * on construction. With RV_STRINGID_DEBUG set both are interned for reverse lookup and collision checks
+	 * when constructed at run time, ids only ever built in constant expressions stay unknown. Comparisons are
+	 * plain integer compares.
+	 */
+	class StringId
+	{
+	  public:
+		using HashType = uint32_t;
+
+		constexpr StringId() : _hash(0){};
+		constexpr explicit StringId(HashType hash) : _hash(hash){};
+
+		// Up to the first NUL, so a char buffer hashes like the string it holds and not its unused tail
+		template <size_t S>
+		constexpr StringId(const char (&str)[S])
+			: _hash(Register(crc32_view(std::string_view(str, LiteralLength(str))),
+							 std::string_view(str, LiteralLength(str)))){};
+
+		explicit StringId(std::string_view str) : _hash(crc32_view(str))
+		{
+#if RV_STRINGID_DEBUG
+			StringTable::Get().Intern(_hash, str);
+#endif
+		};
+
+		constexpr HashType GetHash() const { return _hash; };
+		constexpr bool IsEmpty() const { return _hash == 0; };
+
+		/**
+		 * @brief Reverse lookup of the source string. Only available on builds with RV_STRINGID_DEBUG,
+		 * release builds (and ids only built at compile time) return "<unknown>".
+		 */
+		const char* c_str() const
+		{
+#if RV_STRINGID_DEBUG
+			const char* str = StringTable::Get().Find(_hash);
+			return str ? str : "<unknown>";
+#else
+			return "<unknown>";
+#endif
+		};
+
+		constexpr bool operator==(StringId other) const { return _hash == other._hash; };
+		constexpr bool operator!=(StringId other) const { return _hash != other._hash; };
+		constexpr bool operator<(StringId other) const { return _hash < other._hash; };
+
+		/**
+		 * @brief Intern str under hash when evaluated at run time on RV_STRINGID_DEBUG builds, returns hash.
+		 */
+		static constexpr HashType Register(HashType hash, std::string_view str)
+		{
+#if RV_STRINGID_INTERN_LITERALS
+			if (!__builtin_is_constant_evaluated()) StringTable::Get().Intern(hash, str);
+#else
+			(void)str;
+#endif
+			return hash;
+		}
+
+	  private:
+		template <size_t S>
+		static constexpr size_t LiteralLength(const char (&str)[S])
+		{
+			size_t length = 0;
+			while (length < S - 1 && str[length] != '\0')
+			{
+				length++;
+			}
+			return length;
+		}
+
+		HashType _hash;
+	};
+
+	static_assert(sizeof(StringId) == sizeof(uint32_t), "StringId must stay a plain 32-bit value");
+	static_assert(StringId("Hello world").GetHash() == crc32("Hello world"), "StringId unit test failed!");
+	static_assert(StringId("a\0b").GetHash() == crc32("a"), "StringId must stop at the first NUL");
+
+	namespace literals
+	{
+		constexpr StringId operator""_sid(const char* str, size_t len)
+		{
+			return StringId(StringId::Register(crc32_view(std::string_view(str, len)), std::string_view(str, len)));
+		}
+	} // namespace literals
+
+} // namespace rv
+
+namespace std
+{
+	template <>
+	struct hash<rv::StringId>
+	{
+		size_t operator()(rv::StringId id) const noexcept { return id.GetHash(); }
+	};
+} // namespace std
+
+#endif //!__STRINGID__H__
@@ -0,0 +1,201 @@
+#ifndef __TOKENIZER__H__
+#define __TOKENIZER__H__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string_view>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RV_TOKENIZER_SSE2 1
+#include <emmintrin.h>
+#else
+#define RV_TOKENIZER_SSE2 0
+#endif
+
+#include <core/bits.h>
+
+namespace rv
+{
+	/**
+	 * @brief Find the first occurrence of a character, scanning 16 bytes at a time when SSE2 is available.
+	 *
+	 * @param str String to be searched.
+	 * @param ch Character to look for.
+	 * @param pos Starting position.
+	 * @return size_t Position of the character or std::string_view::npos.
+	 */
+	inline size_t findChar(std::string_view str, char ch, size_t pos = 0)
+	{
+		const char* data = str.data();
+		const size_t size = str.size();
+#if RV_TOKENIZER_SSE2
+		const __m128i needle = _mm_set1_epi8(ch);
+		for (; pos + 16 <= size; pos += 16)
+		{
+			const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+			const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle)));
+			if (mask) return pos + countTrailingZeros(mask);
+		}
+#endif
+		for (; pos < size; pos++)
+		{
+			if (data[pos] == ch) return pos;
+		}
+		return std::string_view::npos;
+	}
+
+	/**
+	 * @brief Find the first occurrence of a delimiter, using findChar on its first character.
+	 *
+	 * @param str String to be searched.
+	 * @param delim Delimiter to look for (must not be empty).
+	 * @param pos Starting position.
+	 * @return size_t Position of the delimiter or std::string_view::npos.
+	 */
+	inline size_t findDelim(std::string_view str, std::string_view delim, size_t pos = 0)
+	{
+		if (delim.size() == 1) return findChar(str, delim[0], pos);
+
+		while ((pos = findChar(str, delim[0], pos)) != std::string_view::npos)
+		{
+			if (str.size() - pos < delim.size()) return std::string_view::npos;
+			if (memcmp(str.data() + pos + 1, delim.data() + 1, delim.size() - 1) == 0) return pos;
+			pos++;
+		}
+		return std::string_view::npos;
+	}
+
+	/**
+	 * @brief Lazy range of tokens over a string view, no allocations are performed and every token is a view
+	 * into the original string. Matches splitStr semantics: empty tokens between consecutive delimiters are
+	 * kept (unless skipEmpty is set) and a trailing delimiter does not produce an empty token.
+	 */
+	class TokenRange
+	{
+	  public:
+		class Iterator
+		{
+		  public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = std::string_view;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const std::string_view*;
+			using reference = const std::string_view&;
+
+			constexpr Iterator() = default;
+
+			reference operator*() const { return _token; };
+			pointer operator->() const { return &_token; };
+
+			Iterator& operator++()
+			{
+				Advance();
+				return *this;
+			};
+
+			Iterator operator++(int)
+			{
+				Iterator prev = *this;
+				Advance();
+				return prev;
+			};
+
+			bool operator==(const Iterator& other) const { return _range == other._range && _pos == other._pos; };
+			bool operator!=(const Iterator& other) const { return !(*this == other); };
+
+		  private:
+			void Advance()
+			{
+				const std::string_view str = _range->_str;
+				const std::string_view delim = _range->_delim;
+				while (_next < str.size())
+				{
+					const size_t found = findDelim(str, delim, _next);
+					const size_t end = found == std::string_view::npos ? str.size() : found;
+					_token = str.substr(_next, end - _next);
+					_pos = _next;
+					_next = found == std::string_view::npos ? str.size() : found + delim.size();
+					if (!_range->_skipEmpty || !_token.empty()) return;
+				}
+				_pos = std::string_view::npos;
+				_token = {};
+			};
+
+			const TokenRange* _range{nullptr};
+			size_t _pos{std::string_view::npos};
+			size_t _next{0};
+			std::string_view _token;
+
+			friend class TokenRange;
+		};
+
+		constexpr TokenRange(std::string_view str, std::string_view delim, bool skipEmpty = false)
+			: _str(str), _delim(delim), _skipEmpty(skipEmpty){};
+
+		Iterator begin() const
+		{
+			if (_delim.empty()) return end();
+			Iterator it;
+			it._range = this;
+			it._next = 0;
+			it.Advance();
+			return it;
+		};
+
+		Iterator end() const
+		{
+			Iterator it;
+			it._range = this;
+			return it;
+		};
+
+		/**
+		 * @brief Fill a caller provided array with up to maxTokens tokens.
+		 *
+		 * @return size_t Number of tokens written.
+		 */
+		size_t Collect(std::string_view* outTokens, size_t maxTokens) const
+		{
+			size_t count = 0;
+			for (auto it = begin(); it != end() && count < maxTokens; ++it)
+			{
+				outTokens[count++] = *it;
+			}
+			return count;
+		};
+
+		size_t Count() const
+		{
+			size_t count = 0;
+			for (auto it = begin(); it != end(); ++it)
+			{
+				count++;
+			}
+			return count;
+		};
+
+	  private:
+		std::string_view _str;
+		std::string_view _delim;
+		bool _skipEmpty;
+	};
+
+	/**
+	 * @brief Tokenize str lazily without allocating. The returned range references both views, so the
+	 * underlying strings must outlive it.
+	 */
+	inline TokenRange tokenize(std::string_view str, std::string_view delim, bool skipEmpty = false)
+	{
+		return TokenRange(str, delim, skipEmpty);
+	}
+
+	/**
+	 * @brief Position of the last path separator ('/' or '\\') or npos.
+	 */
+	inline size_t findLastSeparator(std::string_view path) { return path.find_last_of("/\\"); }
+
+} // namespace rv
+
+#endif //!__TOKENIZER__H__
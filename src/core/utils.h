@@ -2,9 +2,14 @@
 #define __UTILS__H__
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <fstream>
 #include <cstdint>
+#include <sys/stat.h>
+
+#include <core/fileops.h>
+#include <core/tokenizer.h>
 
 namespace rv
 {
@@ -39,7 +44,7 @@ namespace rv
 
 	constexpr uint16_t crc16(const uint8_t* buf, size_t len) { return crc16(0xffff, buf, len); }
 
-	constexpr uint16_t crc16(const char* buf, size_t len) { return crc16(0xffff, (const uint8_t*)buf, len); }
+	inline uint16_t crc16(const char* buf, size_t len) { return crc16(0xffff, (const uint8_t*)buf, len); }
 
 	static constexpr uint32_t compile_crc_table[256] = {
 	    // polynomial = 0x04C11DB7
@@ -111,10 +116,28 @@ namespace rv
 		return (crc32_internal<size - 2>(str));
 	}
 
+	/**
+	 * @brief Iterative version of the compile-time crc32, usable on runtime strings and string views.
+	 * Produces the same hash as crc32<S> without the template recursion depth limit on long literals.
+	 *
+	 * @param str String to be hashed.
+	 * @return uint32_t Resulting hash.
+	 */
+	constexpr uint32_t crc32_view(std::string_view str)
+	{
+		uint32_t crc = 0xFFFFFFFF;
+		for (size_t i = 0; i < str.size(); i++)
+		{
+			crc = (crc >> 8) ^ compile_crc_table[(crc ^ static_cast<uint8_t>(str[i])) & 0x000000FF];
+		}
+		return crc ^ 0xFFFFFFFF;
+	}
+
 	static_assert(crc32("") == 0, "crc32 unit test (empty string) failed!");
 	static_assert(crc32("A") == static_cast<uint32_t>(0xD3D99E8B), "crc32 unit test ('A') failed!");
 	static_assert(crc32("Hello world") == static_cast<uint32_t>(0x8BD69E52),
 		      "crc32 unit test ('Hello world') failed!");
+	static_assert(crc32_view("Hello world") == crc32("Hello world"), "crc32_view unit test ('Hello world') failed!");
 
 	inline uint32_t crc32(std::string str)
 	{
@@ -124,27 +147,58 @@ namespace rv
 		return crc32(strBuff, strSize);
 	}
 
-	inline std::vector<std::string> splitStr(std::string str, std::string delim)
+	/**
+	 * @brief Split a string into owning tokens. Prefer rv::tokenize when the tokens don't need to outlive the
+	 * source string, it performs no allocations.
+	 *
+	 * @param str String to be split.
+	 * @param delim Delimiter between tokens.
+	 * @return std::vector<std::string> Resulting tokens.
+	 */
+	inline std::vector<std::string> splitStr(std::string_view str, std::string_view delim)
 	{
-		// TODO: FIX THIS SHIT
 		std::vector<std::string> tokens;
-		size_t pos = 0;
-		size_t oldPos = 0;
-		while ((pos = str.find(delim.c_str(), oldPos)) != std::string::npos)
+		for (std::string_view token : tokenize(str, delim))
 		{
-			std::string subStr = str.substr(oldPos, pos - oldPos);
-			tokens.push_back(subStr);
-			oldPos = pos + delim.size();
-		}
-		// Final token without delimiter
-		if (oldPos < str.size())
-		{
-			std::string subStr = str.substr(oldPos, str.size() - oldPos);
-			tokens.push_back(subStr);
+			tokens.emplace_back(token);
 		}
 		return tokens;
 	}
 
+	/**
+	 * @brief Given a File full path, return it's folder path (directory) and it's file name, as views into fullPath.
+	 *
+	 * @param fullPath File's full path.
+	 * @param fileName Returning file name.
+	 * @return std::string_view Returning folder path (directory).
+	 */
+	inline std::string_view splitFilename(std::string_view fullPath, std::string_view& fileName)
+	{
+		const size_t found = findLastSeparator(fullPath);
+		const size_t nameStart = found == std::string_view::npos ? 0 : found + 1;
+		fileName = fullPath.substr(nameStart);
+		return fullPath.substr(0, nameStart);
+	}
+
+	/**
+	 * @brief Given a File full path, return it's folder path (directory), it's file name and it's file extension,
+	 * as views into fullPath. The extension keeps its leading dot and is empty when the file has none.
+	 *
+	 * @param fullPath File's full path.
+	 * @param fileName Returning file name.
+	 * @param fileExt Returning file extension.
+	 * @return std::string_view Returning folder path (directory).
+	 */
+	inline std::string_view splitFilename(std::string_view fullPath, std::string_view& fileName,
+					      std::string_view& fileExt)
+	{
+		const std::string_view folder = splitFilename(fullPath, fileName);
+		const size_t extPos = fileName.find_last_of('.');
+		fileExt = extPos == std::string_view::npos ? std::string_view() : fileName.substr(extPos);
+		fileName = fileName.substr(0, extPos);
+		return folder;
+	}
+
 	/**
 	 * @brief Given a File full path, return it's folder path (directory) and it's file name.
 	 *
@@ -154,10 +208,10 @@ namespace rv
 	 */
 	inline std::string splitFilename(const std::string& fullPath, std::string& fileName)
 	{
-		size_t found;
-		found = fullPath.find_last_of("/\\");
-		fileName = fullPath.substr(found + 1);
-		return fullPath.substr(0, found + 1);
+		std::string_view nameView;
+		const std::string_view folder = splitFilename(std::string_view(fullPath), nameView);
+		fileName = nameView;
+		return std::string(folder);
 	}
 
 	/**
@@ -171,12 +225,23 @@ namespace rv
 	inline std::string splitFilename(const std::string& fullPath, std::string& fileName,
 					   std::string& fileExt)
 	{
-		size_t dirPos, extPos;
-		dirPos = fullPath.find_last_of("/\\");
-		extPos = fullPath.find_last_of(".");
-		fileExt = fullPath.substr(extPos);
-		fileName = fullPath.substr(dirPos + 1, extPos - dirPos - 1);
-		return fullPath.substr(0, dirPos + 1);
+		std::string_view nameView, extView;
+		const std::string_view folder = splitFilename(std::string_view(fullPath), nameView, extView);
+		fileName = nameView;
+		fileExt = extView;
+		return std::string(folder);
+	}
+
+	/**
+	 * @brief Given a File full path, return it's folder path (directory) as a view into fullPath.
+	 *
+	 * @param fullPath File's full path.
+	 * @return std::string_view Returning folder path (directory).
+	 */
+	inline std::string_view getFileFolderPath(std::string_view fullPath)
+	{
+		const size_t found = findLastSeparator(fullPath);
+		return fullPath.substr(0, found == std::string_view::npos ? 0 : found + 1);
 	}
 
 	/**
@@ -187,24 +252,19 @@ namespace rv
 	 */
 	inline std::string getFileFolderPath(const std::string& fullPath)
 	{
-		size_t found;
-		found = fullPath.find_last_of("/\\");
-		return fullPath.substr(0, found + 1);
+		return std::string(getFileFolderPath(std::string_view(fullPath)));
 	}
 
-	inline bool fileExists(const std::string& path)
+	// Literals would be ambiguous between the two above, they keep getting a string as they always did
+	inline std::string getFileFolderPath(const char* fullPath)
 	{
-		std::ifstream f(path.c_str());
-		return f.good();
+		return std::string(getFileFolderPath(std::string_view(fullPath)));
 	}
 
-	// copy in binary mode
-	inline bool copyFile(const std::string& srcPath, const std::string& destPath)
+	inline bool fileExists(const std::string& path)
 	{
-		std::ifstream src(srcPath.c_str(), std::ios::binary);
-		std::ofstream dest(destPath.c_str(), std::ios::binary);
-		dest << src.rdbuf();
-		return src && dest;
+		struct stat st;
+		return stat(path.c_str(), &st) == 0;
 	}
 
 	template <typename T>
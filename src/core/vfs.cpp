@@ -0,0 +1,280 @@
+// StdLib Includes
+#include <algorithm>
+#include <mutex>
+
+// Platform Includes
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Application Specific Includes
+#include <core/vfs.h>
+#include <core/utils.h>
+
+namespace gefx
+{
+#if !defined(_WIN32)
+	static int ToMadvise(AccessHint hint)
+	{
+		switch (hint)
+		{
+		case AccessHint::Sequential:
+			return MADV_SEQUENTIAL;
+		case AccessHint::Random:
+			return MADV_RANDOM;
+		case AccessHint::WillNeed:
+			return MADV_WILLNEED;
+		default:
+			return MADV_NORMAL;
+		}
+	}
+#endif
+
+	std::shared_ptr<MappedFile> MappedFile::Open(const std::string& path, AccessHint hint)
+	{
+		std::shared_ptr<MappedFile> file(new MappedFile());
+#if defined(_WIN32)
+		DWORD flags = FILE_ATTRIBUTE_NORMAL;
+		if (hint == AccessHint::Sequential) flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+		if (hint == AccessHint::Random) flags |= FILE_FLAG_RANDOM_ACCESS;
+
+		HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+		if (handle == INVALID_HANDLE_VALUE) return nullptr;
+		file->_fileHandle = handle;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(handle, &size)) return nullptr;
+		file->_size = static_cast<size_t>(size.QuadPart);
+		if (file->_size == 0) return file;
+
+		file->_mappingHandle = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!file->_mappingHandle) return nullptr;
+
+		file->_data = static_cast<const uint8_t*>(MapViewOfFile(file->_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+		if (!file->_data) return nullptr;
+#else
+		const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0) return nullptr;
+
+		struct stat st;
+		if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+		{
+			close(fd);
+			return nullptr;
+		}
+
+		file->_size = static_cast<size_t>(st.st_size);
+		if (file->_size == 0)
+		{
+			close(fd);
+			return file;
+		}
+
+		void* data = mmap(nullptr, file->_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		// The mapping keeps its own reference to the file
+		close(fd);
+		if (data == MAP_FAILED) return nullptr;
+
+		file->_data = static_cast<const uint8_t*>(data);
+		if (hint != AccessHint::Normal) madvise(data, file->_size, ToMadvise(hint));
+#endif
+		return file;
+	}
+
+	MappedFile::~MappedFile()
+	{
+#if defined(_WIN32)
+		if (_data) UnmapViewOfFile(_data);
+		if (_mappingHandle) CloseHandle(_mappingHandle);
+		if (_fileHandle) CloseHandle(_fileHandle);
+#else
+		if (_data) munmap(const_cast<uint8_t*>(_data), _size);
+#endif
+	}
+
+	void MappedFile::Advise(size_t offset, size_t size, AccessHint hint) const
+	{
+		if (!_data || offset >= _size) return;
+		size = std::min(size, _size - offset);
+#if defined(_WIN32)
+		if (hint == AccessHint::WillNeed)
+		{
+			WIN32_MEMORY_RANGE_ENTRY range{const_cast<uint8_t*>(_data) + offset, size};
+			PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+		}
+#else
+		// madvise needs a page aligned start address
+		const uintptr_t pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+		const uintptr_t start = reinterpret_cast<uintptr_t>(_data + offset);
+		const uintptr_t alignedStart = start & ~(pageSize - 1);
+		madvise(reinterpret_cast<void*>(alignedStart), size + (start - alignedStart), ToMadvise(hint));
+#endif
+	}
+
+	DirectoryMount::DirectoryMount(std::string_view rootPath) : _root(rootPath)
+	{
+		if (!_root.empty() && _root.back() != '/' && _root.back() != '\\') _root.push_back('/');
+	}
+
+	std::string DirectoryMount::MakePath(std::string_view relPath) const
+	{
+		std::string path;
+		path.reserve(_root.size() + relPath.size());
+		path.append(_root);
+		path.append(relPath);
+		return path;
+	}
+
+	bool DirectoryMount::Stat(std::string_view relPath, FileStat& outStat)
+	{
+		const std::string path = MakePath(relPath);
+#if defined(_WIN32)
+		struct _stat64 st;
+		if (_stat64(path.c_str(), &st) != 0)
+		{
+			outStat = FileStat();
+			return false;
+		}
+		outStat.isDirectory = (st.st_mode & _S_IFDIR) != 0;
+#else
+		struct stat st;
+		if (stat(path.c_str(), &st) != 0)
+		{
+			outStat = FileStat();
+			return false;
+		}
+		outStat.isDirectory = S_ISDIR(st.st_mode);
+#endif
+		outStat.exists = true;
+		outStat.size = static_cast<uint64_t>(st.st_size);
+		outStat.modifiedTime = static_cast<int64_t>(st.st_mtime);
+		return true;
+	}
+
+	FileView DirectoryMount::Open(std::string_view relPath, AccessHint hint)
+	{
+		std::shared_ptr<MappedFile> file = MappedFile::Open(MakePath(relPath), hint);
+		if (!file) return FileView();
+		if (file->Size() == 0) return FileView::Empty();
+
+		rv::Span<const uint8_t> data(file->Data(), file->Size());
+		return FileView(std::move(file), data);
+	}
+
+	std::string_view VirtualFileSystem::NormalizePrefix(std::string_view prefix)
+	{
+		while (!prefix.empty() && (prefix.back() == '/' || prefix.back() == '\\'))
+		{
+			prefix.remove_suffix(1);
+		}
+		return prefix;
+	}
+
+	void VirtualFileSystem::Mount(std::string_view prefix, std::unique_ptr<IMountPoint> mountPoint)
+	{
+		// The cache is cleared under the mount lock too, no Resolve can be halfway through meanwhile
+		std::unique_lock<std::shared_mutex> lock(_mountMutex);
+		_mounts.push_back({std::string(NormalizePrefix(prefix)), std::move(mountPoint)});
+		InvalidateCache();
+	}
+
+	void VirtualFileSystem::Unmount(std::string_view prefix)
+	{
+		prefix = NormalizePrefix(prefix);
+		std::unique_lock<std::shared_mutex> lock(_mountMutex);
+		_mounts.erase(std::remove_if(_mounts.begin(), _mounts.end(),
+					     [prefix](const MountEntry& entry) { return entry.prefix == prefix; }),
+			      _mounts.end());
+		InvalidateCache();
+	}
+
+	void VirtualFileSystem::InvalidateCache()
+	{
+		std::unique_lock<std::shared_mutex> lock(_cacheMutex);
+		_statCache.clear();
+	}
+
+	IMountPoint* VirtualFileSystem::Resolve(std::string_view path, std::string_view& outRelPath, FileStat& outStat)
+	{
+		const rv::StringId key(path);
+		{
+			std::shared_lock<std::shared_mutex> lock(_cacheMutex);
+			auto it = _statCache.find(key);
+			if (it != _statCache.end() && it->second.path == path)
+			{
+				outStat = it->second.stat;
+				outRelPath = path.substr(it->second.relOffset);
+				return it->second.owner;
+			}
+		}
+
+		IMountPoint* owner = nullptr;
+		FileStat stat;
+		size_t relOffset = 0;
+		size_t bestPrefix = 0;
+		// Reverse order so later mounts overlay earlier ones with the same prefix
+		for (auto it = _mounts.rbegin(); it != _mounts.rend(); ++it)
+		{
+			const std::string& prefix = it->prefix;
+			if (owner && prefix.size() <= bestPrefix) continue;
+
+			std::string_view relPath = path;
+			if (!prefix.empty())
+			{
+				if (path.size() <= prefix.size() || path.compare(0, prefix.size(), prefix) != 0) continue;
+				if (path[prefix.size()] != '/' && path[prefix.size()] != '\\') continue;
+				relPath = path.substr(prefix.size() + 1);
+			}
+
+			FileStat candidate;
+			if (it->mountPoint->Stat(relPath, candidate))
+			{
+				owner = it->mountPoint.get();
+				bestPrefix = prefix.size();
+				relOffset = path.size() - relPath.size();
+				stat = candidate;
+			}
+		}
+
+		{
+			std::unique_lock<std::shared_mutex> lock(_cacheMutex);
+			_statCache[key] = CacheEntry{std::string(path), stat, owner, relOffset};
+		}
+
+		outStat = stat;
+		outRelPath = path.substr(relOffset);
+		return owner;
+	}
+
+	bool VirtualFileSystem::Exists(std::string_view path)
+	{
+		FileStat stat;
+		return Stat(path, stat);
+	}
+
+	bool VirtualFileSystem::Stat(std::string_view path, FileStat& outStat)
+	{
+		std::shared_lock<std::shared_mutex> lock(_mountMutex);
+		std::string_view relPath;
+		return Resolve(path, relPath, outStat) != nullptr;
+	}
+
+	FileView VirtualFileSystem::Open(std::string_view path, AccessHint hint)
+	{
+		// Held through the mount's Open as well, so it can't be unmounted underneath
+		std::shared_lock<std::shared_mutex> lock(_mountMutex);
+		std::string_view relPath;
+		FileStat stat;
+		IMountPoint* owner = Resolve(path, relPath, stat);
+		if (!owner || stat.isDirectory) return FileView();
+		return owner->Open(relPath, hint);
+	}
+
+} // namespace gefx
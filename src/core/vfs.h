@@ -0,0 +1,185 @@
+#ifndef __VFS__H__
+#define __VFS__H__
+
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <core/span.h>
+#include <core/stringid.h>
+
+namespace gefx
+{
+	/**
+	 * @brief Access pattern hint forwarded to the OS when mapping a file (madvise / FILE_FLAG_*).
+	 */
+	enum class AccessHint
+	{
+		Normal,
+		Sequential,
+		Random,
+		WillNeed
+	};
+
+	struct FileStat
+	{
+		bool exists{false};
+		bool isDirectory{false};
+		uint64_t size{0};
+		int64_t modifiedTime{0};
+	};
+
+	/**
+	 * @brief Read-only memory mapping of a whole file. Unmapped on destruction.
+	 */
+	class MappedFile
+	{
+	  public:
+		static std::shared_ptr<MappedFile> Open(const std::string& path, AccessHint hint = AccessHint::Normal);
+		~MappedFile();
+
+		const uint8_t* Data() const { return _data; };
+		size_t Size() const { return _size; };
+
+		/**
+		 * @brief Re-issue an access hint for a byte range of the mapping (e.g. WillNeed before a block read).
+		 */
+		void Advise(size_t offset, size_t size, AccessHint hint) const;
+
+		MappedFile(MappedFile&&) = delete;
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(MappedFile&&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+	  private:
+		MappedFile() = default;
+
+		const uint8_t* _data{nullptr};
+		size_t _size{0};
+#if defined(_WIN32)
+		void* _fileHandle{nullptr};
+		void* _mappingHandle{nullptr};
+#endif
+	};
+
+	/**
+	 * @brief Zero-copy view over file contents. Keeps its backing storage (a mapping, a decompressed block, ...)
+	 * alive for as long as the view exists.
+	 */
+	class FileView
+	{
+	  public:
+		FileView() = default;
+		FileView(std::shared_ptr<const void> owner, rv::Span<const uint8_t> data)
+			: _owner(std::move(owner)), _data(data), _valid(true){};
+
+		static FileView Empty()
+		{
+			FileView view;
+			view._valid = true;
+			return view;
+		};
+
+		bool IsValid() const { return _valid; };
+		const uint8_t* Data() const { return _data.data(); };
+		size_t Size() const { return _data.size(); };
+		rv::Span<const uint8_t> AsSpan() const { return _data; };
+		std::string_view AsString() const
+		{
+			return std::string_view(reinterpret_cast<const char*>(_data.data()), _data.size());
+		};
+
+	  private:
+		std::shared_ptr<const void> _owner;
+		rv::Span<const uint8_t> _data;
+		bool _valid{false};
+	};
+
+	/**
+	 * @brief Source of files mounted under a virtual path prefix. Paths received are relative to the mount.
+	 */
+	class IMountPoint
+	{
+	  public:
+		virtual ~IMountPoint() = default;
+
+		virtual bool Stat(std::string_view relPath, FileStat& outStat) = 0;
+		virtual FileView Open(std::string_view relPath, AccessHint hint) = 0;
+	};
+
+	/**
+	 * @brief Mount point backed by a directory on disk, files are served as memory mappings.
+	 */
+	class DirectoryMount : public IMountPoint
+	{
+	  public:
+		explicit DirectoryMount(std::string_view rootPath);
+
+		bool Stat(std::string_view relPath, FileStat& outStat) override;
+		FileView Open(std::string_view relPath, AccessHint hint) override;
+
+	  private:
+		std::string MakePath(std::string_view relPath) const;
+
+		std::string _root;
+	};
+
+	/**
+	 * @brief Virtual file system resolving virtual paths ("shaders/vert_col.vs") through mount points.
+	 * Later mounts overlay earlier ones and the longest matching prefix wins. Stat results (including misses)
+	 * are cached until InvalidateCache is called, so repeated existence checks don't hit the file system.
+	 */
+	class VirtualFileSystem
+	{
+	  public:
+		VirtualFileSystem() = default;
+		VirtualFileSystem(VirtualFileSystem&&) = delete;
+		VirtualFileSystem(const VirtualFileSystem&) = delete;
+		VirtualFileSystem& operator=(VirtualFileSystem&&) = delete;
+		VirtualFileSystem& operator=(const VirtualFileSystem&) = delete;
+
+		void Mount(std::string_view prefix, std::unique_ptr<IMountPoint> mountPoint);
+		void Unmount(std::string_view prefix);
+
+		bool Exists(std::string_view path);
+		bool Stat(std::string_view path, FileStat& outStat);
+		FileView Open(std::string_view path, AccessHint hint = AccessHint::Sequential);
+
+		void InvalidateCache();
+
+	  private:
+		struct MountEntry
+		{
+			std::string prefix;
+			std::unique_ptr<IMountPoint> mountPoint;
+		};
+
+		struct CacheEntry
+		{
+			std::string path;
+			FileStat stat;
+			IMountPoint* owner;
+			size_t relOffset;
+		};
+
+		// Resolve the mount owning path, filling the stat cache on the way. Callers hold _mountMutex, Mount and
+		// Unmount clear the cache under it, so an entry never outlives its mount
+		IMountPoint* Resolve(std::string_view path, std::string_view& outRelPath, FileStat& outStat);
+		static std::string_view NormalizePrefix(std::string_view prefix);
+
+		std::shared_mutex _mountMutex;
+		std::vector<MountEntry> _mounts;
+
+		// Taken after _mountMutex when both are needed
+		std::shared_mutex _cacheMutex;
+		// Keyed by the virtual path's id, negative results are cached as well
+		std::unordered_map<rv::StringId, CacheEntry> _statCache;
+	};
+
+} // namespace gefx
+
+#endif //!__VFS__H__
@@ -3,14 +3,38 @@
 //#pragma comment(linker, "/SUBSYSTEM:windows /ENTRY:mainCRTStartup")
 
 #include <app/app.h>
+#include <core/log.h>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
 
 int main(int argc, char** argv)
 {
 	setlocale(LC_ALL, "Portuguese");
 
-	GrefixsEndine app;
+	gefx::LoggerConfig logConfig;
+	logConfig.filePath = "grefixs.log";
+	gefx::Logger::Get().Start(logConfig);
+
+	// --vulkan picks the Vulkan device, GL otherwise. --render-thread renders on its own thread, at most
+	// --frames-ahead N frames (1 by default) behind the simulation
+	gefx::DeviceBackend backend = gefx::DeviceBackend::OpenGL;
+	bool renderThread = false;
+	uint32_t framesAhead = 1;
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--vulkan") == 0) backend = gefx::DeviceBackend::Vulkan;
+		if (std::strcmp(argv[i], "--render-thread") == 0) renderThread = true;
+		if (std::strcmp(argv[i], "--frames-ahead") == 0 && i + 1 < argc)
+		{
+			framesAhead = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+	}
+
+	GrefixsEndine app(backend, renderThread, framesAhead);
 	app.Run();
 
+	gefx::Logger::Get().Stop();
+
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,62 @@
+// StdLib Includes
+#include <algorithm>
+#include <chrono>
+
+// Application Specific Includes
+#include <rendering/culling.h>
+
+namespace gefx
+{
+	template <typename F>
+	rv::Span<const uint32_t> FrustumCuller::Run(JobSystem& jobs, size_t count, const F& cullRange)
+	{
+		const auto start = std::chrono::steady_clock::now();
+
+		if (_visible.size() < count) _visible.resize(count);
+		const uint32_t chunks = static_cast<uint32_t>((count + ChunkSize - 1) / ChunkSize);
+		_chunkCounts.resize(chunks);
+
+		jobs.ParallelFor(chunks, 1, [&](uint32_t begin, uint32_t end) {
+			for (uint32_t chunk = begin; chunk < end; chunk++)
+			{
+				const size_t first = size_t(chunk) * ChunkSize;
+				const size_t last = std::min(first + ChunkSize, count);
+				_chunkCounts[chunk] = static_cast<uint32_t>(cullRange(first, last, _visible.data() + first));
+			}
+		});
+
+		// Slide every chunk's indices down next to the previous ones, never overlapping forward
+		_visibleCount = 0;
+		for (uint32_t chunk = 0; chunk < chunks; chunk++)
+		{
+			const uint32_t* first = _visible.data() + size_t(chunk) * ChunkSize;
+			std::copy(first, first + _chunkCounts[chunk], _visible.data() + _visibleCount);
+			_visibleCount += _chunkCounts[chunk];
+		}
+
+		_stats.tested = static_cast<uint32_t>(count);
+		_stats.visible = static_cast<uint32_t>(_visibleCount);
+		_stats.culled = _stats.tested - _stats.visible;
+		_stats.chunks = chunks;
+		_stats.milliseconds =
+			std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		return GetVisible();
+	}
+
+	rv::Span<const uint32_t> FrustumCuller::Cull(JobSystem& jobs, const rv::Frustum& frustum,
+												 const rv::SphereSoA& spheres)
+	{
+		return Run(jobs, spheres.Size(), [&](size_t begin, size_t end, uint32_t* out) {
+			return rv::cullSpheres(frustum, spheres, begin, end, out);
+		});
+	}
+
+	rv::Span<const uint32_t> FrustumCuller::Cull(JobSystem& jobs, const rv::Frustum& frustum,
+												 const rv::BoundsSoA& bounds)
+	{
+		return Run(jobs, bounds.Size(), [&](size_t begin, size_t end, uint32_t* out) {
+			return rv::cullBounds(frustum, bounds, begin, end, out);
+		});
+	}
+
+} // namespace gefx
@@ -0,0 +1,65 @@
+#ifndef __CULLING__H__
+#define __CULLING__H__
+
+#include <cstdint>
+#include <vector>
+
+#include <core/jobs.h>
+#include <core/math/frustum.h>
+#include <core/span.h>
+
+namespace gefx
+{
+	struct CullingStats
+	{
+		uint32_t tested{0};
+		uint32_t visible{0};
+		uint32_t culled{0};
+		uint32_t chunks{0};
+		double milliseconds{0.0};
+	};
+
+	/**
+	 * @brief Frustum culls instance bounds on the job system. The instances are split in fixed size chunks, each
+	 * job culls one chunk with the SIMD kernels into its own slice of the output, and the slices are then packed
+	 * into one ascending list of visible indices.
+	 */
+	class FrustumCuller
+	{
+	  public:
+		static constexpr uint32_t ChunkSize = 1024;
+
+		FrustumCuller() = default;
+		~FrustumCuller() = default;
+
+		FrustumCuller(FrustumCuller&&) = delete;
+		FrustumCuller(const FrustumCuller&) = delete;
+		FrustumCuller& operator=(FrustumCuller&&) = delete;
+		FrustumCuller& operator=(const FrustumCuller&) = delete;
+
+		/**
+		 * @brief Visible spheres, the view stays valid until the next Cull.
+		 */
+		rv::Span<const uint32_t> Cull(JobSystem& jobs, const rv::Frustum& frustum, const rv::SphereSoA& spheres);
+		rv::Span<const uint32_t> Cull(JobSystem& jobs, const rv::Frustum& frustum, const rv::BoundsSoA& bounds);
+
+		rv::Span<const uint32_t> GetVisible() const
+		{
+			return rv::Span<const uint32_t>(_visible.data(), _visibleCount);
+		};
+		const CullingStats& GetStats() const { return _stats; };
+
+	  private:
+		template <typename F>
+		rv::Span<const uint32_t> Run(JobSystem& jobs, size_t count, const F& cullRange);
+
+		// Sized to the instance count, each chunk writes its visible indices at its own offset first
+		std::vector<uint32_t> _visible;
+		size_t _visibleCount{0};
+		std::vector<uint32_t> _chunkCounts;
+		CullingStats _stats;
+	};
+
+} // namespace gefx
+
+#endif //!__CULLING__H__
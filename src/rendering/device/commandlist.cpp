@@ -0,0 +1,348 @@
+// StdLib Includes
+#include <cstring>
+
+// Third Party Includes
+#include <fmt/format.h>
+
+// Application Specific Includes
+#include <rendering/device/commandlist.h>
+
+namespace gefx
+{
+	namespace
+	{
+		// Payload size every command needs at least, the variable ones carry their data after it
+		uint32_t payloadSize(CommandType type)
+		{
+			switch (type)
+			{
+			case CommandType::BeginRenderPass:
+				return sizeof(cmd::BeginRenderPass);
+			case CommandType::EndRenderPass:
+				return 0;
+			case CommandType::SetViewport:
+				return sizeof(cmd::SetViewport);
+			case CommandType::SetScissor:
+				return sizeof(cmd::SetScissor);
+			case CommandType::BindPipeline:
+				return sizeof(cmd::BindPipeline);
+			case CommandType::BindVertexBuffer:
+				return sizeof(cmd::BindVertexBuffer);
+			case CommandType::BindIndexBuffer:
+				return sizeof(cmd::BindIndexBuffer);
+			case CommandType::BindUniformBuffer:
+				return sizeof(cmd::BindUniformBuffer);
+			case CommandType::BindTexture:
+				return sizeof(cmd::BindTexture);
+			case CommandType::PushConstants:
+				return sizeof(cmd::PushConstants);
+			case CommandType::Draw:
+				return sizeof(cmd::Draw);
+			case CommandType::DrawIndexed:
+				return sizeof(cmd::DrawIndexed);
+			case CommandType::UpdateBuffer:
+				return sizeof(cmd::UpdateBuffer);
+			default:
+				return 0;
+			}
+		}
+
+		template <typename T>
+		const T& as(const void* payload)
+		{
+			return *static_cast<const T*>(payload);
+		}
+	} // namespace
+
+	const char* getCommandName(CommandType type)
+	{
+		switch (type)
+		{
+		case CommandType::BeginRenderPass:
+			return "BeginRenderPass";
+		case CommandType::EndRenderPass:
+			return "EndRenderPass";
+		case CommandType::SetViewport:
+			return "SetViewport";
+		case CommandType::SetScissor:
+			return "SetScissor";
+		case CommandType::BindPipeline:
+			return "BindPipeline";
+		case CommandType::BindVertexBuffer:
+			return "BindVertexBuffer";
+		case CommandType::BindIndexBuffer:
+			return "BindIndexBuffer";
+		case CommandType::BindUniformBuffer:
+			return "BindUniformBuffer";
+		case CommandType::BindTexture:
+			return "BindTexture";
+		case CommandType::PushConstants:
+			return "PushConstants";
+		case CommandType::Draw:
+			return "Draw";
+		case CommandType::DrawIndexed:
+			return "DrawIndexed";
+		case CommandType::UpdateBuffer:
+			return "UpdateBuffer";
+		default:
+			return "Unknown";
+		}
+	}
+
+	uint8_t* CommandList::Append(CommandType type, uint32_t payloadBytes)
+	{
+		const uint32_t unpadded = static_cast<uint32_t>(sizeof(CommandHeader)) + payloadBytes;
+		const uint32_t size = (unpadded + Alignment - 1) & ~(Alignment - 1);
+		const size_t offset = _data.size();
+		_data.resize(offset + size);
+
+		CommandHeader* header = reinterpret_cast<CommandHeader*>(_data.data() + offset);
+		header->type = type;
+		header->size = size;
+		return _data.data() + offset + sizeof(CommandHeader);
+	}
+
+	template <typename T>
+	void CommandList::Record(CommandType type, const T& payload, const void* extra, uint32_t extraBytes)
+	{
+		uint8_t* out = Append(type, static_cast<uint32_t>(sizeof(T)) + extraBytes);
+		std::memcpy(out, &payload, sizeof(T));
+		if (extraBytes > 0) std::memcpy(out + sizeof(T), extra, extraBytes);
+		Count(type, out);
+	}
+
+	void CommandList::BeginRenderPass(const RenderPassDesc& desc)
+	{
+		Record(CommandType::BeginRenderPass, cmd::BeginRenderPass{desc});
+	}
+
+	void CommandList::EndRenderPass()
+	{
+		Count(CommandType::EndRenderPass, Append(CommandType::EndRenderPass, 0));
+	}
+
+	void CommandList::SetViewport(float x, float y, float width, float height)
+	{
+		Record(CommandType::SetViewport, cmd::SetViewport{x, y, width, height});
+	}
+
+	void CommandList::SetScissor(int32_t x, int32_t y, uint32_t width, uint32_t height)
+	{
+		Record(CommandType::SetScissor, cmd::SetScissor{x, y, width, height});
+	}
+
+	void CommandList::BindPipeline(PipelineHandle pipeline)
+	{
+		Record(CommandType::BindPipeline, cmd::BindPipeline{pipeline});
+	}
+
+	void CommandList::BindVertexBuffer(BufferHandle buffer, uint64_t offset)
+	{
+		Record(CommandType::BindVertexBuffer, cmd::BindVertexBuffer{buffer, offset});
+	}
+
+	void CommandList::BindIndexBuffer(BufferHandle buffer, IndexType type, uint64_t offset)
+	{
+		Record(CommandType::BindIndexBuffer, cmd::BindIndexBuffer{buffer, type, offset});
+	}
+
+	void CommandList::BindUniformBuffer(uint32_t slot, BufferHandle buffer, uint64_t offset, uint64_t size)
+	{
+		Record(CommandType::BindUniformBuffer, cmd::BindUniformBuffer{slot, buffer, offset, size});
+	}
+
+	void CommandList::BindTexture(uint32_t slot, TextureHandle texture)
+	{
+		Record(CommandType::BindTexture, cmd::BindTexture{slot, texture});
+	}
+
+	void CommandList::PushConstants(const void* data, uint32_t size, uint32_t offset)
+	{
+		Record(CommandType::PushConstants, cmd::PushConstants{offset, size}, data, size);
+	}
+
+	void CommandList::Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
+	{
+		Record(CommandType::Draw, cmd::Draw{vertexCount, instanceCount, firstVertex, firstInstance});
+	}
+
+	void CommandList::DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex,
+								  int32_t vertexOffset, uint32_t firstInstance)
+	{
+		Record(CommandType::DrawIndexed,
+			   cmd::DrawIndexed{indexCount, instanceCount, firstIndex, vertexOffset, firstInstance});
+	}
+
+	void CommandList::UpdateBuffer(BufferHandle buffer, uint64_t offset, const void* data, uint32_t size)
+	{
+		Record(CommandType::UpdateBuffer, cmd::UpdateBuffer{buffer, size, offset}, data, size);
+	}
+
+	void CommandList::Reset()
+	{
+		_data.clear();
+		_stats = CommandListStats{};
+	}
+
+	void CommandList::Count(CommandType type, const void* payload)
+	{
+		_stats.commands++;
+		switch (type)
+		{
+		case CommandType::BeginRenderPass:
+			_stats.renderPasses++;
+			break;
+		case CommandType::BindPipeline:
+			_stats.pipelineBinds++;
+			break;
+		case CommandType::PushConstants:
+			_stats.pushConstantBytes += as<cmd::PushConstants>(payload).size;
+			break;
+		case CommandType::Draw:
+			_stats.draws++;
+			_stats.vertices += uint64_t(as<cmd::Draw>(payload).vertexCount) * as<cmd::Draw>(payload).instanceCount;
+			break;
+		case CommandType::DrawIndexed:
+			_stats.draws++;
+			_stats.vertices +=
+				uint64_t(as<cmd::DrawIndexed>(payload).indexCount) * as<cmd::DrawIndexed>(payload).instanceCount;
+			break;
+		case CommandType::UpdateBuffer:
+			_stats.uploadBytes += as<cmd::UpdateBuffer>(payload).size;
+			break;
+		default:
+			break;
+		}
+	}
+
+	bool CommandList::Load(rv::Span<const uint8_t> data)
+	{
+		Reset();
+		_data.assign(data.begin(), data.end());
+
+		size_t offset = 0;
+		while (offset < _data.size())
+		{
+			if (_data.size() - offset < sizeof(CommandHeader))
+			{
+				Reset();
+				return false;
+			}
+
+			const CommandHeader* header = reinterpret_cast<const CommandHeader*>(_data.data() + offset);
+			const void* payload = _data.data() + offset + sizeof(CommandHeader);
+			uint64_t needed = sizeof(CommandHeader) + payloadSize(header->type);
+			if (header->type == CommandType::PushConstants && header->size >= needed)
+			{
+				needed += as<cmd::PushConstants>(payload).size;
+			}
+			else if (header->type == CommandType::UpdateBuffer && header->size >= needed)
+			{
+				needed += as<cmd::UpdateBuffer>(payload).size;
+			}
+			if (header->type >= CommandType::Count || header->size % Alignment != 0 || header->size < needed ||
+				header->size > _data.size() - offset)
+			{
+				Reset();
+				return false;
+			}
+
+			Count(header->type, payload);
+			offset += header->size;
+		}
+		return true;
+	}
+
+	void CommandList::Describe(std::string& out) const
+	{
+		ForEach([&out](const CommandHeader& header, const void* payload) {
+			out += getCommandName(header.type);
+			switch (header.type)
+			{
+			case CommandType::BeginRenderPass:
+			{
+				const RenderPassDesc& desc = as<cmd::BeginRenderPass>(payload).desc;
+				out += fmt::format(" color={:#x} depth={:#x} {}x{}", desc.color.GetRaw(), desc.depth.GetRaw(),
+								   desc.width, desc.height);
+				if (desc.clearColor)
+				{
+					out += fmt::format(" clearColor=({},{},{},{})", desc.clearColorValue.r, desc.clearColorValue.g,
+									   desc.clearColorValue.b, desc.clearColorValue.a);
+				}
+				if (desc.clearDepth) out += fmt::format(" clearDepth={}", desc.clearDepthValue);
+				break;
+			}
+			case CommandType::SetViewport:
+			{
+				const cmd::SetViewport& c = as<cmd::SetViewport>(payload);
+				out += fmt::format(" {} {} {} {}", c.x, c.y, c.width, c.height);
+				break;
+			}
+			case CommandType::SetScissor:
+			{
+				const cmd::SetScissor& c = as<cmd::SetScissor>(payload);
+				out += fmt::format(" {} {} {} {}", c.x, c.y, c.width, c.height);
+				break;
+			}
+			case CommandType::BindPipeline:
+				out += fmt::format(" {:#x}", as<cmd::BindPipeline>(payload).pipeline.GetRaw());
+				break;
+			case CommandType::BindVertexBuffer:
+			{
+				const cmd::BindVertexBuffer& c = as<cmd::BindVertexBuffer>(payload);
+				out += fmt::format(" {:#x} offset={}", c.buffer.GetRaw(), c.offset);
+				break;
+			}
+			case CommandType::BindIndexBuffer:
+			{
+				const cmd::BindIndexBuffer& c = as<cmd::BindIndexBuffer>(payload);
+				out += fmt::format(" {:#x} {} offset={}", c.buffer.GetRaw(),
+								   c.type == IndexType::UInt16 ? "u16" : "u32", c.offset);
+				break;
+			}
+			case CommandType::BindUniformBuffer:
+			{
+				const cmd::BindUniformBuffer& c = as<cmd::BindUniformBuffer>(payload);
+				out += fmt::format(" slot={} {:#x} offset={} size={}", c.slot, c.buffer.GetRaw(), c.offset, c.size);
+				break;
+			}
+			case CommandType::BindTexture:
+			{
+				const cmd::BindTexture& c = as<cmd::BindTexture>(payload);
+				out += fmt::format(" slot={} {:#x}", c.slot, c.texture.GetRaw());
+				break;
+			}
+			case CommandType::PushConstants:
+			{
+				const cmd::PushConstants& c = as<cmd::PushConstants>(payload);
+				out += fmt::format(" offset={} size={}", c.offset, c.size);
+				break;
+			}
+			case CommandType::Draw:
+			{
+				const cmd::Draw& c = as<cmd::Draw>(payload);
+				out += fmt::format(" vertices={} instances={} first={} firstInstance={}", c.vertexCount,
+								   c.instanceCount, c.firstVertex, c.firstInstance);
+				break;
+			}
+			case CommandType::DrawIndexed:
+			{
+				const cmd::DrawIndexed& c = as<cmd::DrawIndexed>(payload);
+				out += fmt::format(" indices={} instances={} first={} vertexOffset={} firstInstance={}", c.indexCount,
+								   c.instanceCount, c.firstIndex, c.vertexOffset, c.firstInstance);
+				break;
+			}
+			case CommandType::UpdateBuffer:
+			{
+				const cmd::UpdateBuffer& c = as<cmd::UpdateBuffer>(payload);
+				out += fmt::format(" {:#x} offset={} size={}", c.buffer.GetRaw(), c.offset, c.size);
+				break;
+			}
+			default:
+				break;
+			}
+			out += '\n';
+		});
+	}
+
+} // namespace gefx
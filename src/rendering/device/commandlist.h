@@ -0,0 +1,239 @@
+#ifndef __COMMANDLIST__H__
+#define __COMMANDLIST__H__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <core/span.h>
+#include <rendering/device/device.h>
+
+namespace gefx
+{
+	enum class CommandType : uint8_t
+	{
+		BeginRenderPass,
+		EndRenderPass,
+		SetViewport,
+		SetScissor,
+		BindPipeline,
+		BindVertexBuffer,
+		BindIndexBuffer,
+		BindUniformBuffer,
+		BindTexture,
+		PushConstants,
+		Draw,
+		DrawIndexed,
+		UpdateBuffer,
+		Count
+	};
+
+	const char* getCommandName(CommandType type);
+
+	// Command payloads as stored in the stream, right after their CommandHeader
+	namespace cmd
+	{
+		struct BeginRenderPass
+		{
+			RenderPassDesc desc;
+		};
+
+		struct SetViewport
+		{
+			float x, y, width, height;
+		};
+
+		struct SetScissor
+		{
+			int32_t x, y;
+			uint32_t width, height;
+		};
+
+		struct BindPipeline
+		{
+			PipelineHandle pipeline;
+		};
+
+		struct BindVertexBuffer
+		{
+			BufferHandle buffer;
+			uint64_t offset;
+		};
+
+		struct BindIndexBuffer
+		{
+			BufferHandle buffer;
+			IndexType type;
+			uint64_t offset;
+		};
+
+		struct BindUniformBuffer
+		{
+			uint32_t slot;
+			BufferHandle buffer;
+			uint64_t offset;
+			uint64_t size;
+		};
+
+		struct BindTexture
+		{
+			uint32_t slot;
+			TextureHandle texture;
+		};
+
+		// Followed by size bytes
+		struct PushConstants
+		{
+			uint32_t offset;
+			uint32_t size;
+		};
+
+		struct Draw
+		{
+			uint32_t vertexCount, instanceCount, firstVertex, firstInstance;
+		};
+
+		struct DrawIndexed
+		{
+			uint32_t indexCount, instanceCount, firstIndex;
+			int32_t vertexOffset;
+			uint32_t firstInstance;
+		};
+
+		// Followed by size bytes
+		struct UpdateBuffer
+		{
+			BufferHandle buffer;
+			uint32_t size;
+			uint64_t offset;
+		};
+	} // namespace cmd
+
+	struct CommandHeader
+	{
+		CommandType type;
+		// Bytes from this header to the next one
+		uint32_t size;
+	};
+
+	struct CommandListStats
+	{
+		uint32_t commands{0};
+		uint32_t renderPasses{0};
+		uint32_t pipelineBinds{0};
+		uint32_t draws{0};
+		uint64_t vertices{0};
+		uint64_t pushConstantBytes{0};
+		uint64_t uploadBytes{0};
+	};
+
+	/**
+	 * @brief Backend independent recording of GPU commands, replayed by IDevice::Submit.
+	 *
+	 * Commands are packed in a single growing byte stream, a header followed by a fixed payload from the cmd
+	 * namespace and, for push constants and buffer updates, their data. Recording only copies bytes, so lists
+	 * are cheap to build from jobs, one list per thread. Handles are stored as is and validated by the device
+	 * when the list is submitted. Recording state persists across commands like in Vulkan: pipeline, buffers
+	 * and push constants stay bound until replaced, but nothing is inherited from previously submitted lists.
+	 */
+	class CommandList
+	{
+	  public:
+		CommandList() = default;
+		~CommandList() = default;
+
+		CommandList(CommandList&&) = default;
+		CommandList(const CommandList&) = delete;
+		CommandList& operator=(CommandList&&) = default;
+		CommandList& operator=(const CommandList&) = delete;
+
+		void BeginRenderPass(const RenderPassDesc& desc);
+		void EndRenderPass();
+		void SetViewport(float x, float y, float width, float height);
+		void SetScissor(int32_t x, int32_t y, uint32_t width, uint32_t height);
+
+		void BindPipeline(PipelineHandle pipeline);
+		void BindVertexBuffer(BufferHandle buffer, uint64_t offset = 0);
+		void BindIndexBuffer(BufferHandle buffer, IndexType type, uint64_t offset = 0);
+		void BindUniformBuffer(uint32_t slot, BufferHandle buffer, uint64_t offset, uint64_t size);
+		void BindTexture(uint32_t slot, TextureHandle texture);
+
+		/**
+		 * @brief Update size bytes at offset of the bound pipeline's push constant block.
+		 */
+		void PushConstants(const void* data, uint32_t size, uint32_t offset = 0);
+		template <typename T>
+		void PushConstants(const T& value)
+		{
+			PushConstants(&value, static_cast<uint32_t>(sizeof(T)));
+		};
+
+		void Draw(uint32_t vertexCount, uint32_t instanceCount = 1, uint32_t firstVertex = 0,
+				  uint32_t firstInstance = 0);
+		void DrawIndexed(uint32_t indexCount, uint32_t instanceCount = 1, uint32_t firstIndex = 0,
+						 int32_t vertexOffset = 0, uint32_t firstInstance = 0);
+
+		/**
+		 * @brief Copy data into a buffer, ordered with the surrounding draws. Outside render passes only, at
+		 * most MaxInlineUpdateBytes and a multiple of 4 bytes.
+		 */
+		void UpdateBuffer(BufferHandle buffer, uint64_t offset, const void* data, uint32_t size);
+
+		/**
+		 * @brief Drop every command, keeping the memory.
+		 */
+		void Reset();
+
+		bool Empty() const { return _stats.commands == 0; };
+		const CommandListStats& GetStats() const { return _stats; };
+
+		/**
+		 * @brief The raw stream, for serialization. Handles are only meaningful to the device they came from.
+		 */
+		rv::Span<const uint8_t> GetData() const { return rv::Span<const uint8_t>(_data.data(), _data.size()); };
+
+		/**
+		 * @brief Replace the content with a stream from GetData, checking every header.
+		 *
+		 * @return false if the stream is malformed, the list is then left empty.
+		 */
+		bool Load(rv::Span<const uint8_t> data);
+
+		/**
+		 * @brief Call fn(const CommandHeader&, const void* payload) for every command in recording order.
+		 */
+		template <typename F>
+		void ForEach(F&& fn) const
+		{
+			size_t offset = 0;
+			while (offset < _data.size())
+			{
+				const CommandHeader* header = reinterpret_cast<const CommandHeader*>(_data.data() + offset);
+				fn(*header, _data.data() + offset + sizeof(CommandHeader));
+				offset += header->size;
+			}
+		};
+
+		/**
+		 * @brief Append one line per command, for logs and diffable regression captures.
+		 */
+		void Describe(std::string& out) const;
+
+	  private:
+		// Every command starts 8 bytes aligned so payloads can be read in place
+		static constexpr uint32_t Alignment = 8;
+
+		// Header plus payloadBytes, returns where the payload goes
+		uint8_t* Append(CommandType type, uint32_t payloadBytes);
+		// Append a command with its payload and extra bytes of data after it
+		template <typename T>
+		void Record(CommandType type, const T& payload, const void* extra = nullptr, uint32_t extraBytes = 0);
+		void Count(CommandType type, const void* payload);
+
+		std::vector<uint8_t> _data;
+		CommandListStats _stats;
+	};
+
+} // namespace gefx
+
+#endif //!__COMMANDLIST__H__
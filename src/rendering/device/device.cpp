@@ -0,0 +1,99 @@
+// StdLib Includes
+#include <algorithm>
+#include <type_traits>
+
+// Application Specific Includes
+#include <rendering/device/commandlist.h>
+#include <rendering/device/device.h>
+
+namespace gefx
+{
+	namespace
+	{
+		constexpr uint64_t FnvOffset = 0xcbf29ce484222325ull;
+		constexpr uint64_t FnvPrime = 0x100000001b3ull;
+
+		uint64_t fnv1a(uint64_t hash, const void* data, size_t bytes)
+		{
+			const uint8_t* p = static_cast<const uint8_t*>(data);
+			for (size_t i = 0; i < bytes; i++) hash = (hash ^ p[i]) * FnvPrime;
+			return hash;
+		}
+
+		// Fields one at a time, struct padding never reaches the hash
+		template <typename T>
+		uint64_t fnv1a(uint64_t hash, const T& value)
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			return fnv1a(hash, &value, sizeof(T));
+		}
+	} // namespace
+
+	uint64_t hashSpirv(rv::Span<const uint32_t> code)
+	{
+		return fnv1a(FnvOffset, code.data(), code.size_bytes());
+	}
+
+	uint64_t hashPipelineDesc(const PipelineDesc& desc)
+	{
+		uint64_t hash = fnv1a(FnvOffset, hashSpirv(desc.vertexSpirv));
+		hash = fnv1a(hash, hashSpirv(desc.fragmentSpirv));
+		hash = fnv1a(hash, desc.attributeCount);
+		for (uint32_t i = 0; i < desc.attributeCount && i < MaxVertexAttributes; i++)
+		{
+			hash = fnv1a(hash, desc.attributes[i].location);
+			hash = fnv1a(hash, desc.attributes[i].format);
+			hash = fnv1a(hash, desc.attributes[i].offset);
+		}
+		hash = fnv1a(hash, desc.vertexStride);
+		hash = fnv1a(hash, desc.topology);
+		hash = fnv1a(hash, desc.cullMode);
+		hash = fnv1a(hash, desc.depthTest);
+		hash = fnv1a(hash, desc.depthWrite);
+		hash = fnv1a(hash, desc.blend);
+		hash = fnv1a(hash, desc.pushConstantBytes);
+		hash = fnv1a(hash, desc.colorFormat);
+		hash = fnv1a(hash, desc.depthFormat);
+		return hash;
+	}
+
+	bool equalPipelineDesc(const PipelineDesc& a, const PipelineDesc& b)
+	{
+		auto equalSpirv = [](rv::Span<const uint32_t> x, rv::Span<const uint32_t> y) {
+			return x.size() == y.size() && std::equal(x.begin(), x.end(), y.begin());
+		};
+		if (!equalSpirv(a.vertexSpirv, b.vertexSpirv) || !equalSpirv(a.fragmentSpirv, b.fragmentSpirv)) return false;
+		if (a.attributeCount != b.attributeCount) return false;
+		for (uint32_t i = 0; i < a.attributeCount && i < MaxVertexAttributes; i++)
+		{
+			const VertexAttribute& x = a.attributes[i];
+			const VertexAttribute& y = b.attributes[i];
+			if (x.location != y.location || x.format != y.format || x.offset != y.offset) return false;
+		}
+		return a.vertexStride == b.vertexStride && a.topology == b.topology && a.cullMode == b.cullMode &&
+			   a.depthTest == b.depthTest && a.depthWrite == b.depthWrite && a.blend == b.blend &&
+			   a.pushConstantBytes == b.pushConstantBytes && a.colorFormat == b.colorFormat &&
+			   a.depthFormat == b.depthFormat;
+	}
+
+	void IDevice::CountSubmitted(const CommandList& list)
+	{
+		const CommandListStats& stats = list.GetStats();
+		_stats.commandLists++;
+		_stats.commands += stats.commands;
+		_stats.renderPasses += stats.renderPasses;
+		_stats.pipelineBinds += stats.pipelineBinds;
+		_stats.draws += stats.draws;
+		_stats.vertices += stats.vertices;
+		_stats.streamBytes += list.GetData().size();
+		_stats.pushConstantBytes += stats.pushConstantBytes;
+		_stats.uploadBytes += stats.uploadBytes;
+	}
+
+	void IDevice::RollFrameStats()
+	{
+		_frameStats = _stats;
+		_stats = DeviceStats{};
+	}
+
+} // namespace gefx
@@ -0,0 +1,356 @@
+#ifndef __DEVICE__H__
+#define __DEVICE__H__
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include <core/containers/handlepool.h>
+#include <core/span.h>
+
+namespace gefx
+{
+	class CommandList;
+
+	// Handles are shared by every backend, the tags only keep the types apart
+	struct BufferTag;
+	struct TextureTag;
+	struct PipelineTag;
+	using BufferHandle = rv::Handle<BufferTag>;
+	using TextureHandle = rv::Handle<TextureTag>;
+	using PipelineHandle = rv::Handle<PipelineTag>;
+
+	constexpr uint32_t MaxVertexAttributes = 8;
+	constexpr uint32_t MaxUniformBufferSlots = 8;
+	constexpr uint32_t MaxTextureSlots = 8;
+	// Vulkan guarantees 128 bytes of push constants, the GL backend emulates them with a uniform block
+	constexpr uint32_t MaxPushConstantBytes = 128;
+	// UpdateBuffer limit, mirrors vkCmdUpdateBuffer
+	constexpr uint32_t MaxInlineUpdateBytes = 65536;
+
+	enum class DeviceBackend : uint8_t
+	{
+		Null,
+		OpenGL,
+		Vulkan,
+	};
+
+	enum class Format : uint8_t
+	{
+		Undefined,
+		R8Unorm,
+		RG8Unorm,
+		RGBA8Unorm,
+		RGBA8Srgb,
+		BGRA8Unorm,
+		R16Float,
+		RGBA16Float,
+		R32Float,
+		RG32Float,
+		RGB32Float,
+		RGBA32Float,
+		Depth32Float,
+		Depth24Stencil8,
+	};
+
+	inline uint32_t getFormatSize(Format format)
+	{
+		switch (format)
+		{
+		case Format::R8Unorm:
+			return 1;
+		case Format::RG8Unorm:
+		case Format::R16Float:
+			return 2;
+		case Format::RGBA8Unorm:
+		case Format::RGBA8Srgb:
+		case Format::BGRA8Unorm:
+		case Format::R32Float:
+		case Format::Depth32Float:
+		case Format::Depth24Stencil8:
+			return 4;
+		case Format::RGBA16Float:
+		case Format::RG32Float:
+			return 8;
+		case Format::RGB32Float:
+			return 12;
+		case Format::RGBA32Float:
+			return 16;
+		default:
+			return 0;
+		}
+	}
+
+	inline bool isDepthFormat(Format format)
+	{
+		return format == Format::Depth32Float || format == Format::Depth24Stencil8;
+	}
+
+	enum class BufferUsage : uint8_t
+	{
+		Vertex,
+		Index,
+		Uniform,
+		Storage,
+	};
+
+	struct BufferDesc
+	{
+		uint64_t bytes{0};
+		BufferUsage usage{BufferUsage::Vertex};
+		// Updated from the CPU every frame or so, backends place it in host visible memory when they can
+		bool dynamic{false};
+	};
+
+	enum class TextureUsage : uint8_t
+	{
+		Sampled,
+		RenderTarget,
+		DepthStencil,
+	};
+
+	struct TextureDesc
+	{
+		uint32_t width{1};
+		uint32_t height{1};
+		uint32_t levels{1};
+		Format format{Format::RGBA8Unorm};
+		TextureUsage usage{TextureUsage::Sampled};
+	};
+
+	enum class PrimitiveTopology : uint8_t
+	{
+		Triangles,
+		TriangleStrip,
+		Lines,
+		Points,
+	};
+
+	enum class IndexType : uint8_t
+	{
+		UInt16,
+		UInt32,
+	};
+
+	enum class CullMode : uint8_t
+	{
+		None,
+		Back,
+		Front,
+	};
+
+	/**
+	 * @brief Color blending of the single color attachment, source is the fragment shader output.
+	 */
+	enum class BlendMode : uint8_t
+	{
+		None,
+		// src * srcAlpha + dst * (1 - srcAlpha)
+		Alpha,
+		// src + dst
+		Additive,
+		// src + dst * (1 - srcAlpha), colors already multiplied by their alpha
+		Premultiplied,
+	};
+
+	struct VertexAttribute
+	{
+		uint32_t location{0};
+		Format format{Format::Undefined};
+		uint32_t offset{0};
+	};
+
+	/**
+	 * @brief Everything a draw needs besides resources: shaders, vertex layout and fixed function state.
+	 * Shaders are SPIR-V, declaring their push constants with the PUSH_CONSTANT layout qualifier that
+	 * ShaderUtils::GLSLtoSPV defines per backend. Front faces are counter clockwise and depth tests are less.
+	 */
+	struct PipelineDesc
+	{
+		rv::Span<const uint32_t> vertexSpirv;
+		rv::Span<const uint32_t> fragmentSpirv;
+
+		VertexAttribute attributes[MaxVertexAttributes];
+		uint32_t attributeCount{0};
+		// Single interleaved vertex stream
+		uint32_t vertexStride{0};
+
+		PrimitiveTopology topology{PrimitiveTopology::Triangles};
+		CullMode cullMode{CullMode::None};
+		bool depthTest{false};
+		bool depthWrite{false};
+		BlendMode blend{BlendMode::None};
+		uint32_t pushConstantBytes{0};
+
+		// Attachments the pipeline renders to, Undefined for none
+		Format colorFormat{Format::RGBA8Unorm};
+		Format depthFormat{Format::Undefined};
+	};
+
+	/**
+	 * @brief Identity of a pipeline: a hash of every field of the description, SPIR-V words included, so equal
+	 * descriptions hash the same wherever their shader code lives.
+	 */
+	uint64_t hashPipelineDesc(const PipelineDesc& desc);
+
+	/**
+	 * @brief Field by field comparison, SPIR-V by content. Settles pipelines whose hashes collide.
+	 */
+	bool equalPipelineDesc(const PipelineDesc& a, const PipelineDesc& b);
+
+	/**
+	 * @brief 64-bit FNV-1a of SPIR-V words.
+	 */
+	uint64_t hashSpirv(rv::Span<const uint32_t> code);
+
+	/**
+	 * @brief Render target and clears of a pass. A null color texture renders to the window's back buffer.
+	 */
+	struct RenderPassDesc
+	{
+		TextureHandle color;
+		TextureHandle depth;
+		uint32_t width{0};
+		uint32_t height{0};
+		bool clearColor{false};
+		bool clearDepth{false};
+		glm::vec4 clearColorValue{0.0f};
+		float clearDepthValue{1.0f};
+	};
+
+	struct DeviceStats
+	{
+		uint32_t submits{0};
+		uint32_t commandLists{0};
+		uint32_t commands{0};
+		uint32_t renderPasses{0};
+		uint32_t pipelineBinds{0};
+		uint32_t draws{0};
+		// Vertices or indices times instances
+		uint64_t vertices{0};
+		uint64_t streamBytes{0};
+		uint64_t pushConstantBytes{0};
+		uint64_t uploadBytes{0};
+		// Uploads that found the staging ring full and waited for the GPU to free some of it
+		uint32_t uploadStalls{0};
+		// CPU time spent translating and submitting command lists
+		double submitMs{0.0};
+	};
+
+	/**
+	 * @brief Completion of an asynchronous upload. Uploads complete in order, so a ticket also stands for
+	 * every upload made before it.
+	 */
+	struct UploadTicket
+	{
+		uint64_t value{0};
+	};
+
+	/**
+	 * @brief Graphics device, creates resources and executes command lists.
+	 *
+	 * Command lists are backend independent recordings, so they can be built on any thread and replayed on
+	 * any device; resource creation, Submit and EndFrame belong to the thread owning the device. Destroyed
+	 * resources stay alive until the GPU is done with the frames that may use them.
+	 */
+	class IDevice
+	{
+	  public:
+		IDevice() = default;
+		virtual ~IDevice() = default;
+
+		IDevice(IDevice&&) = delete;
+		IDevice(const IDevice&) = delete;
+		IDevice& operator=(IDevice&&) = delete;
+		IDevice& operator=(const IDevice&) = delete;
+
+		virtual DeviceBackend GetBackend() const = 0;
+
+		/**
+		 * @brief Format of the back buffer, pipelines rendering to it use it as their color format.
+		 */
+		virtual Format GetBackBufferFormat() const { return Format::RGBA8Unorm; };
+
+		/**
+		 * @brief Create a buffer and upload data into it (data may be null). Null handle on failure.
+		 */
+		virtual BufferHandle CreateBuffer(const BufferDesc& desc, const void* data = nullptr) = 0;
+		virtual TextureHandle CreateTexture(const TextureDesc& desc) = 0;
+		virtual PipelineHandle CreatePipeline(const PipelineDesc& desc) = 0;
+
+		/**
+		 * @brief Invalidate the handle and release the object once the GPU no longer uses it. Null or stale
+		 * handles are ignored.
+		 */
+		virtual void Destroy(BufferHandle handle) = 0;
+		virtual void Destroy(TextureHandle handle) = 0;
+		virtual void Destroy(PipelineHandle handle) = 0;
+
+		/**
+		 * @brief Copy data into a buffer without waiting for the GPU. The data is staged before returning, the
+		 * copies run in the background in batches, and commands must not use the buffer until the ticket is
+		 * complete. False when the range is out of the buffer.
+		 */
+		virtual bool UploadBuffer(BufferHandle buffer, uint64_t offset, const void* data, uint64_t bytes,
+								  UploadTicket& outTicket) = 0;
+
+		/**
+		 * @brief Same for a whole level of a sampled texture, rows tightly packed from texel row 0.
+		 */
+		virtual bool UploadTexture(TextureHandle texture, uint32_t level, const void* data,
+								   UploadTicket& outTicket) = 0;
+
+		/**
+		 * @brief Whether the GPU is done with an upload, never waits.
+		 */
+		virtual bool IsUploadComplete(UploadTicket ticket) = 0;
+
+		/**
+		 * @brief Start the copies batched so far. EndFrame does it, this gets them going sooner.
+		 */
+		virtual void FlushUploads() = 0;
+
+		/**
+		 * @brief Execute command lists in order. They can be reset or destroyed as soon as this returns.
+		 *
+		 * A render pass may begin in one list and end in a later one of the same call, so a pass can be
+		 * recorded by several threads; a list continuing a pass binds its own state and starts with the full
+		 * render area as viewport. Every pass must end before the call does.
+		 */
+		virtual void Submit(rv::Span<const CommandList* const> lists) = 0;
+		void Submit(const CommandList& list)
+		{
+			const CommandList* lists[] = {&list};
+			Submit(rv::Span<const CommandList* const>(lists));
+		};
+
+		/**
+		 * @brief Close the frame: recycle per frame memory and release what the GPU is done with.
+		 */
+		virtual void EndFrame() = 0;
+
+		/**
+		 * @brief Totals of the last frame closed by EndFrame.
+		 */
+		const DeviceStats& GetFrameStats() const { return _frameStats; };
+
+	  protected:
+		/**
+		 * @brief Add a submitted list to the current frame's stats.
+		 */
+		void CountSubmitted(const CommandList& list);
+
+		/**
+		 * @brief Publish the current frame's stats and start a new frame.
+		 */
+		void RollFrameStats();
+
+		DeviceStats _stats;
+
+	  private:
+		DeviceStats _frameStats;
+	};
+
+} // namespace gefx
+
+#endif //!__DEVICE__H__
@@ -0,0 +1,728 @@
+// StdLib Includes
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+// Application Specific Includes
+#include <core/log.h>
+#include <rendering/device/commandlist.h>
+#include <rendering/device/gldevice.h>
+#include <rendering/utils.h>
+
+namespace gefx
+{
+	namespace
+	{
+		template <typename T>
+		const T& as(const void* payload)
+		{
+			return *static_cast<const T*>(payload);
+		}
+
+		GLenum getInternalFormat(Format format)
+		{
+			switch (format)
+			{
+			case Format::R8Unorm:
+				return GL_R8;
+			case Format::RG8Unorm:
+				return GL_RG8;
+			case Format::RGBA8Unorm:
+			case Format::BGRA8Unorm:
+				// GL has no BGRA storage, the swizzle only matters to transfers
+				return GL_RGBA8;
+			case Format::RGBA8Srgb:
+				return GL_SRGB8_ALPHA8;
+			case Format::R16Float:
+				return GL_R16F;
+			case Format::RGBA16Float:
+				return GL_RGBA16F;
+			case Format::R32Float:
+				return GL_R32F;
+			case Format::RG32Float:
+				return GL_RG32F;
+			case Format::RGB32Float:
+				return GL_RGB32F;
+			case Format::RGBA32Float:
+				return GL_RGBA32F;
+			case Format::Depth32Float:
+				return GL_DEPTH_COMPONENT32F;
+			case Format::Depth24Stencil8:
+				return GL_DEPTH24_STENCIL8;
+			default:
+				return GL_NONE;
+			}
+		}
+
+		// Components, component type and normalization of a vertex attribute format
+		bool getAttributeFormat(Format format, GLint& outComponents, GLenum& outType, GLboolean& outNormalized)
+		{
+			outNormalized = GL_FALSE;
+			switch (format)
+			{
+			case Format::R8Unorm:
+			case Format::RG8Unorm:
+			case Format::RGBA8Unorm:
+			case Format::RGBA8Srgb:
+				outComponents = format == Format::R8Unorm ? 1 : format == Format::RG8Unorm ? 2 : 4;
+				outType = GL_UNSIGNED_BYTE;
+				outNormalized = GL_TRUE;
+				return true;
+			case Format::R16Float:
+			case Format::RGBA16Float:
+				outComponents = format == Format::R16Float ? 1 : 4;
+				outType = GL_HALF_FLOAT;
+				return true;
+			case Format::R32Float:
+			case Format::RG32Float:
+			case Format::RGB32Float:
+			case Format::RGBA32Float:
+				outComponents = static_cast<GLint>(getFormatSize(format) / 4);
+				outType = GL_FLOAT;
+				return true;
+			default:
+				return false;
+			}
+		}
+
+		// Client format and type of texel data for an internal format, returns the texel size, 0 for formats
+		// uploads can't write
+		uint32_t getPixelFormat(GLenum internalFormat, GLenum& outFormat, GLenum& outType)
+		{
+			switch (internalFormat)
+			{
+			case GL_R8:
+				outFormat = GL_RED;
+				outType = GL_UNSIGNED_BYTE;
+				return 1;
+			case GL_RG8:
+				outFormat = GL_RG;
+				outType = GL_UNSIGNED_BYTE;
+				return 2;
+			case GL_RGBA8:
+			case GL_SRGB8_ALPHA8:
+				outFormat = GL_RGBA;
+				outType = GL_UNSIGNED_BYTE;
+				return 4;
+			case GL_R16F:
+				outFormat = GL_RED;
+				outType = GL_HALF_FLOAT;
+				return 2;
+			case GL_RGBA16F:
+				outFormat = GL_RGBA;
+				outType = GL_HALF_FLOAT;
+				return 8;
+			case GL_R32F:
+				outFormat = GL_RED;
+				outType = GL_FLOAT;
+				return 4;
+			case GL_RG32F:
+				outFormat = GL_RG;
+				outType = GL_FLOAT;
+				return 8;
+			case GL_RGB32F:
+				outFormat = GL_RGB;
+				outType = GL_FLOAT;
+				return 12;
+			case GL_RGBA32F:
+				outFormat = GL_RGBA;
+				outType = GL_FLOAT;
+				return 16;
+			default:
+				return 0;
+			}
+		}
+
+		GLenum getTopology(PrimitiveTopology topology)
+		{
+			switch (topology)
+			{
+			case PrimitiveTopology::TriangleStrip:
+				return GL_TRIANGLE_STRIP;
+			case PrimitiveTopology::Lines:
+				return GL_LINES;
+			case PrimitiveTopology::Points:
+				return GL_POINTS;
+			default:
+				return GL_TRIANGLES;
+			}
+		}
+	} // namespace
+
+	bool GLDevice::Initialize()
+	{
+		// Direct state access and persistently mapped buffers are core from 4.5
+		if (!GLAD_GL_VERSION_4_5)
+		{
+			GEFX_LOG_ERROR("[OpenGL] 4.5 is required, the context is {}.{}", GLVersion.major, GLVersion.minor);
+			return false;
+		}
+		// SPIR-V shaders are core from 4.6, ARB_gl_spirv brings the same entry point to 4.5 drivers
+		_specializeShader = glSpecializeShader ? glSpecializeShader : glSpecializeShaderARB;
+
+		GLint alignment = 0;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+		_pushAlignment = static_cast<uint32_t>(std::max(alignment, 4));
+
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		const GLsizeiptr ringBytes = GLsizeiptr(PushConstantRegionBytes) * FramesInFlight;
+		glCreateBuffers(1, &_pushRing);
+		glNamedBufferStorage(_pushRing, ringBytes, nullptr, flags);
+		_pushRingData = static_cast<uint8_t*>(glMapNamedBufferRange(_pushRing, 0, ringBytes, flags));
+		if (!_pushRingData)
+		{
+			GEFX_LOG_ERROR("[OpenGL] Failed to map the push constant ring");
+			return false;
+		}
+
+		const GLsizeiptr uploadBytes = UploadRingBytes;
+		glCreateBuffers(1, &_uploadBuffer);
+		glNamedBufferStorage(_uploadBuffer, uploadBytes, nullptr, flags);
+		_uploadData = static_cast<uint8_t*>(glMapNamedBufferRange(_uploadBuffer, 0, uploadBytes, flags));
+		if (!_uploadData)
+		{
+			GEFX_LOG_ERROR("[OpenGL] Failed to map the upload ring");
+			return false;
+		}
+		_uploadRing = UploadRing(UploadRingBytes);
+
+		glCreateSamplers(1, &_sampler);
+		glSamplerParameteri(_sampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glSamplerParameteri(_sampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glSamplerParameteri(_sampler, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glSamplerParameteri(_sampler, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		return true;
+	}
+
+	void GLDevice::Shutdown()
+	{
+		for (const Pipeline& pipeline : _pipelines)
+		{
+			_resources.Destroy(pipeline.program);
+			_resources.Destroy(pipeline.vertexArray);
+		}
+		_pipelines.Clear();
+		_resources.DestroyAll();
+
+		for (const Framebuffer& framebuffer : _framebuffers)
+		{
+			glDeleteFramebuffers(1, &framebuffer.id);
+		}
+		_framebuffers.clear();
+		for (GLsync& fence : _pushFences)
+		{
+			if (fence) glDeleteSync(fence);
+			fence = nullptr;
+		}
+		_uploadCopies.clear();
+		PollUploads(_uploadsFlushed);
+		if (_uploadBuffer) glDeleteBuffers(1, &_uploadBuffer);
+		_uploadBuffer = 0;
+		_uploadData = nullptr;
+		_bgraTextures.clear();
+		if (_pushRing) glDeleteBuffers(1, &_pushRing);
+		if (_sampler) glDeleteSamplers(1, &_sampler);
+		_pushRing = 0;
+		_pushRingData = nullptr;
+		_sampler = 0;
+	}
+
+	BufferHandle GLDevice::CreateBuffer(const BufferDesc& desc, const void* data)
+	{
+		if (desc.bytes == 0) return BufferHandle();
+		return _resources.CreateBuffer(desc.bytes, data, desc.dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+	}
+
+	TextureHandle GLDevice::CreateTexture(const TextureDesc& desc)
+	{
+		const GLenum internalFormat = getInternalFormat(desc.format);
+		if (internalFormat == GL_NONE || desc.width == 0 || desc.height == 0 || desc.levels == 0) return {};
+		const TextureHandle handle = _resources.CreateTexture2D(desc.width, desc.height, desc.levels, internalFormat);
+		if (desc.format == Format::BGRA8Unorm) _bgraTextures.insert(handle.GetRaw());
+		return handle;
+	}
+
+	PipelineHandle GLDevice::CreatePipeline(const PipelineDesc& desc)
+	{
+		if (desc.attributeCount > MaxVertexAttributes || desc.pushConstantBytes > MaxPushConstantBytes) return {};
+		if (!_specializeShader)
+		{
+			GEFX_LOG_ERROR("[OpenGL] SPIR-V shaders need 4.6 or ARB_gl_spirv");
+			return {};
+		}
+
+		const ProgramHandle program = _resources.AdoptProgram(
+			ShaderUtils::CompileShaderProgramSpirV(desc.vertexSpirv, desc.fragmentSpirv, _specializeShader));
+		if (program.IsNull()) return {};
+
+		// The vertex format lives in the vertex array, the buffer is attached at draw time
+		const VertexArrayHandle vertexArray = _resources.CreateVertexArray();
+		const GLuint vao = _resources.GetGL(vertexArray);
+		for (uint32_t i = 0; i < desc.attributeCount; i++)
+		{
+			const VertexAttribute& attribute = desc.attributes[i];
+			GLint components;
+			GLenum type;
+			GLboolean normalized;
+			if (!getAttributeFormat(attribute.format, components, type, normalized))
+			{
+				GEFX_LOG_ERROR("[OpenGL] Vertex attribute {} has no vertex format", attribute.location);
+				_resources.Destroy(program);
+				_resources.Destroy(vertexArray);
+				return {};
+			}
+			glEnableVertexArrayAttrib(vao, attribute.location);
+			glVertexArrayAttribFormat(vao, attribute.location, components, type, normalized, attribute.offset);
+			glVertexArrayAttribBinding(vao, attribute.location, 0);
+		}
+
+		return _pipelines.Create(Pipeline{program, vertexArray, getTopology(desc.topology), desc.vertexStride,
+										  desc.pushConstantBytes, desc.cullMode, desc.depthTest, desc.depthWrite,
+										  desc.blend});
+	}
+
+	void GLDevice::Destroy(BufferHandle handle)
+	{
+		_resources.Destroy(handle);
+	}
+
+	void GLDevice::Destroy(TextureHandle handle)
+	{
+		// Framebuffers only reference the texture, they can go right away
+		auto stale = std::remove_if(_framebuffers.begin(), _framebuffers.end(), [&](const Framebuffer& framebuffer) {
+			if (framebuffer.color != handle && framebuffer.depth != handle) return false;
+			glDeleteFramebuffers(1, &framebuffer.id);
+			return true;
+		});
+		_framebuffers.erase(stale, _framebuffers.end());
+		_bgraTextures.erase(handle.GetRaw());
+		_resources.Destroy(handle);
+	}
+
+	void GLDevice::Destroy(PipelineHandle handle)
+	{
+		Pipeline pipeline;
+		if (!_pipelines.Release(handle, pipeline)) return;
+		_resources.Destroy(pipeline.program);
+		_resources.Destroy(pipeline.vertexArray);
+	}
+
+	void GLDevice::Submit(rv::Span<const CommandList* const> lists)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		_stats.submits++;
+		for (const CommandList* list : lists)
+		{
+			Execute(*list);
+			CountSubmitted(*list);
+		}
+		// Passes don't outlive the Submit they began in
+		_inPass = false;
+		_stats.submitMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	bool GLDevice::UploadBuffer(BufferHandle buffer, uint64_t offset, const void* data, uint64_t bytes,
+								UploadTicket& outTicket)
+	{
+		const GpuBuffer* target = _resources.Get(buffer);
+		if (!_uploadData || !target || !data || bytes == 0) return false;
+		if (offset > target->bytes || bytes > target->bytes - offset) return false;
+
+		// Chunks of a quarter ring, a big upload waits for a part of the ring at a time instead of all of it
+		const uint64_t chunkBytes = _uploadRing.GetSize() / 4;
+		const uint8_t* source = static_cast<const uint8_t*>(data);
+		for (uint64_t done = 0; done < bytes;)
+		{
+			const uint64_t size = std::min(bytes - done, chunkBytes);
+			uint64_t staging;
+			if (!StageUpload(source + done, size, staging)) return false;
+			_uploadCopies.push_back(UploadCopy{buffer, {}, staging, offset + done, size, 0, 0, 0});
+			done += size;
+		}
+		_stats.uploadBytes += bytes;
+		outTicket = UploadTicket{_uploadsFlushed + 1};
+		return true;
+	}
+
+	bool GLDevice::UploadTexture(TextureHandle texture, uint32_t level, const void* data, UploadTicket& outTicket)
+	{
+		const GpuTexture* target = _resources.Get(texture);
+		GLenum format, type;
+		const uint32_t texelBytes = target ? getPixelFormat(target->format, format, type) : 0;
+		if (!_uploadData || texelBytes == 0 || !data || level >= target->levels) return false;
+
+		// Whole rows per chunk
+		const uint32_t width = std::max(target->width >> level, 1u);
+		const uint32_t height = std::max(target->height >> level, 1u);
+		const uint64_t rowBytes = uint64_t(width) * texelBytes;
+		const uint64_t chunkBytes = _uploadRing.GetSize() / 4;
+		if (rowBytes > chunkBytes) return false;
+		const uint32_t chunkRows = static_cast<uint32_t>(std::min<uint64_t>(height, chunkBytes / rowBytes));
+		const uint8_t* source = static_cast<const uint8_t*>(data);
+		for (uint32_t row = 0; row < height; row += chunkRows)
+		{
+			const uint32_t rows = std::min(chunkRows, height - row);
+			uint64_t staging;
+			if (!StageUpload(source + row * rowBytes, rows * rowBytes, staging)) return false;
+			_uploadCopies.push_back(UploadCopy{{}, texture, staging, 0, rows * rowBytes, level, row, rows});
+		}
+		_stats.uploadBytes += rowBytes * height;
+		outTicket = UploadTicket{_uploadsFlushed + 1};
+		return true;
+	}
+
+	bool GLDevice::IsUploadComplete(UploadTicket ticket)
+	{
+		if (ticket.value > _uploadsCompleted) PollUploads();
+		return ticket.value <= _uploadsCompleted;
+	}
+
+	void GLDevice::FlushUploads()
+	{
+		if (_uploadCopies.empty()) return;
+
+		// Texture updates read the ring as pixel unpack buffer, offsets in place of pointers
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _uploadBuffer);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		for (const UploadCopy& copy : _uploadCopies)
+		{
+			// Targets destroyed since are skipped
+			if (!copy.buffer.IsNull())
+			{
+				const GLuint buffer = _resources.GetGL(copy.buffer);
+				if (buffer) glCopyNamedBufferSubData(_uploadBuffer, buffer, copy.staging, copy.offset, copy.bytes);
+				continue;
+			}
+			const GpuTexture* texture = _resources.Get(copy.texture);
+			if (!texture) continue;
+			GLenum format, type;
+			getPixelFormat(texture->format, format, type);
+			if (_bgraTextures.contains(copy.texture.GetRaw())) format = GL_BGRA;
+			const GLsizei width = static_cast<GLsizei>(std::max(texture->width >> copy.level, 1u));
+			glTextureSubImage2D(texture->id, static_cast<GLint>(copy.level), 0, static_cast<GLint>(copy.row), width,
+								static_cast<GLsizei>(copy.rows), format, type,
+								reinterpret_cast<const void*>(static_cast<uintptr_t>(copy.staging)));
+		}
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		_uploadCopies.clear();
+
+		_uploadRing.Close(++_uploadsFlushed);
+		_uploadFences.push_back(UploadFence{_uploadsFlushed, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0)});
+	}
+
+	bool GLDevice::StageUpload(const void* data, uint64_t bytes, uint64_t& outOffset)
+	{
+		while (!_uploadRing.Allocate(bytes, 16, outOffset))
+		{
+			// Full of batches in flight: send the open one off and wait for the oldest
+			FlushUploads();
+			const uint64_t oldest = _uploadRing.GetOldestPending();
+			if (oldest == 0) return false;
+			_stats.uploadStalls++;
+			PollUploads(oldest);
+		}
+		std::memcpy(_uploadData + outOffset, data, bytes);
+		return true;
+	}
+
+	void GLDevice::PollUploads(uint64_t wait)
+	{
+		while (!_uploadFences.empty())
+		{
+			const UploadFence& batch = _uploadFences.front();
+			GLenum status = glClientWaitSync(batch.fence, 0, 0);
+			while (batch.value <= wait && status == GL_TIMEOUT_EXPIRED)
+			{
+				status = glClientWaitSync(batch.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+			}
+			if (status == GL_TIMEOUT_EXPIRED) break;
+			glDeleteSync(batch.fence);
+			_uploadsCompleted = batch.value;
+			_uploadFences.pop_front();
+		}
+		_uploadRing.Release(_uploadsCompleted);
+	}
+
+	void GLDevice::EndFrame()
+	{
+		FlushUploads();
+		PollUploads();
+		_resources.EndFrame();
+
+		if (_pushRing)
+		{
+			_pushFences[_pushRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			_pushRegion = (_pushRegion + 1) % FramesInFlight;
+			_pushOffset = 0;
+
+			// The region about to be reused was written FramesInFlight frames ago
+			if (GLsync fence = _pushFences[_pushRegion])
+			{
+				while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED)
+				{
+				}
+				glDeleteSync(fence);
+				_pushFences[_pushRegion] = nullptr;
+			}
+		}
+
+		RollFrameStats();
+	}
+
+	GLuint GLDevice::GetFramebuffer(TextureHandle color, TextureHandle depth)
+	{
+		if (color.IsNull() && depth.IsNull()) return 0;
+		for (const Framebuffer& framebuffer : _framebuffers)
+		{
+			if (framebuffer.color == color && framebuffer.depth == depth) return framebuffer.id;
+		}
+
+		Framebuffer framebuffer{color, depth, 0};
+		glCreateFramebuffers(1, &framebuffer.id);
+		if (!color.IsNull())
+		{
+			glNamedFramebufferTexture(framebuffer.id, GL_COLOR_ATTACHMENT0, _resources.GetGL(color), 0);
+		}
+		else
+		{
+			glNamedFramebufferDrawBuffer(framebuffer.id, GL_NONE);
+		}
+		if (!depth.IsNull())
+		{
+			const GpuTexture* texture = _resources.Get(depth);
+			const GLenum attachment = texture && texture->format == GL_DEPTH24_STENCIL8 ? GL_DEPTH_STENCIL_ATTACHMENT
+																						 : GL_DEPTH_ATTACHMENT;
+			glNamedFramebufferTexture(framebuffer.id, attachment, _resources.GetGL(depth), 0);
+		}
+		if (glCheckNamedFramebufferStatus(framebuffer.id, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		{
+			GEFX_LOG_ERROR("[OpenGL] Incomplete framebuffer");
+		}
+		_framebuffers.push_back(framebuffer);
+		return framebuffer.id;
+	}
+
+	bool GLDevice::FlushPushConstants(const uint8_t* data, uint32_t bytes)
+	{
+		if (!_pushRingData) return false;
+
+		uint32_t offset = (_pushOffset + _pushAlignment - 1) & ~(_pushAlignment - 1);
+		if (offset + bytes > PushConstantRegionBytes)
+		{
+			// More draws than the region holds, wait for the ones already recorded and start over
+			GEFX_LOG_WARNING("[OpenGL] Push constant region full, stalling");
+			glFinish();
+			offset = 0;
+		}
+
+		const uint32_t ringOffset = _pushRegion * PushConstantRegionBytes + offset;
+		std::memcpy(_pushRingData + ringOffset, data, bytes);
+		glBindBufferRange(GL_UNIFORM_BUFFER, PushConstantBinding, _pushRing, ringOffset, bytes);
+		_pushOffset = offset + bytes;
+		return true;
+	}
+
+	void GLDevice::Execute(const CommandList& list)
+	{
+		// Bindings are per list, the vertex and index buffers go to the pipeline's vertex array at draw time
+		const Pipeline* pipeline = nullptr;
+		GLuint vertexBuffer = 0;
+		GLintptr vertexOffset = 0;
+		GLuint indexBuffer = 0;
+		uint64_t indexOffset = 0;
+		IndexType indexType = IndexType::UInt32;
+		bool vertexDirty = false;
+		bool pushDirty = false;
+		alignas(16) uint8_t pushConstants[MaxPushConstantBytes] = {};
+
+		auto flushDraw = [&]() {
+			const GLuint vao = _resources.GetGL(pipeline->vertexArray);
+			if (vertexDirty)
+			{
+				glVertexArrayVertexBuffer(vao, 0, vertexBuffer, vertexOffset,
+										  static_cast<GLsizei>(pipeline->vertexStride));
+				glVertexArrayElementBuffer(vao, indexBuffer);
+				vertexDirty = false;
+			}
+			if (pushDirty && pipeline->pushConstantBytes > 0)
+			{
+				FlushPushConstants(pushConstants, pipeline->pushConstantBytes);
+				pushDirty = false;
+			}
+		};
+
+		// A list continuing the previous list's pass starts over with the full render area, like a Vulkan
+		// secondary command buffer would
+		if (_inPass)
+		{
+			glViewport(0, 0, static_cast<GLsizei>(_passWidth), static_cast<GLsizei>(_passHeight));
+			glDisable(GL_SCISSOR_TEST);
+		}
+
+		list.ForEach([&](const CommandHeader& header, const void* payload) {
+			switch (header.type)
+			{
+			case CommandType::BeginRenderPass:
+			{
+				const RenderPassDesc& desc = as<cmd::BeginRenderPass>(payload).desc;
+				const GLuint framebuffer = GetFramebuffer(desc.color, desc.depth);
+				glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+				glViewport(0, 0, static_cast<GLsizei>(desc.width), static_cast<GLsizei>(desc.height));
+				glDisable(GL_SCISSOR_TEST);
+				_passWidth = desc.width;
+				_passHeight = desc.height;
+				_inPass = true;
+
+				// Clears obey the write masks, pipelines set them again on bind
+				if (desc.clearColor)
+				{
+					glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+					glClearNamedFramebufferfv(framebuffer, GL_COLOR, 0, &desc.clearColorValue[0]);
+				}
+				if (desc.clearDepth && (!desc.depth.IsNull() || framebuffer == 0))
+				{
+					glDepthMask(GL_TRUE);
+					glClearNamedFramebufferfv(framebuffer, GL_DEPTH, 0, &desc.clearDepthValue);
+				}
+				break;
+			}
+			case CommandType::EndRenderPass:
+				_inPass = false;
+				break;
+			case CommandType::SetViewport:
+			{
+				// Origin is the top left corner like in Vulkan, GL counts from the bottom
+				const cmd::SetViewport& c = as<cmd::SetViewport>(payload);
+				glViewportIndexedf(0, c.x, float(_passHeight) - c.y - c.height, c.width, c.height);
+				break;
+			}
+			case CommandType::SetScissor:
+			{
+				const cmd::SetScissor& c = as<cmd::SetScissor>(payload);
+				glEnable(GL_SCISSOR_TEST);
+				glScissor(c.x, static_cast<GLint>(_passHeight) - c.y - static_cast<GLint>(c.height),
+						  static_cast<GLsizei>(c.width), static_cast<GLsizei>(c.height));
+				break;
+			}
+			case CommandType::BindPipeline:
+			{
+				pipeline = _pipelines.Get(as<cmd::BindPipeline>(payload).pipeline);
+				assert(pipeline && "stale pipeline handle");
+				if (!pipeline) break;
+
+				glUseProgram(_resources.GetGL(pipeline->program));
+				glBindVertexArray(_resources.GetGL(pipeline->vertexArray));
+				if (pipeline->cullMode == CullMode::None)
+				{
+					glDisable(GL_CULL_FACE);
+				}
+				else
+				{
+					glEnable(GL_CULL_FACE);
+					glCullFace(pipeline->cullMode == CullMode::Back ? GL_BACK : GL_FRONT);
+				}
+				if (pipeline->depthTest)
+				{
+					glEnable(GL_DEPTH_TEST);
+					glDepthFunc(GL_LESS);
+				}
+				else
+				{
+					glDisable(GL_DEPTH_TEST);
+				}
+				glDepthMask(pipeline->depthWrite ? GL_TRUE : GL_FALSE);
+				if (pipeline->blend == BlendMode::None)
+				{
+					glDisable(GL_BLEND);
+				}
+				else
+				{
+					// Alpha accumulates the same way in every mode, as the Vulkan device blends it
+					const GLenum source = pipeline->blend == BlendMode::Alpha ? GL_SRC_ALPHA : GL_ONE;
+					const GLenum destination = pipeline->blend == BlendMode::Additive ? GL_ONE : GL_ONE_MINUS_SRC_ALPHA;
+					glEnable(GL_BLEND);
+					glBlendEquation(GL_FUNC_ADD);
+					glBlendFuncSeparate(source, destination, GL_ONE, destination);
+				}
+				vertexDirty = true;
+				pushDirty = true;
+				break;
+			}
+			case CommandType::BindVertexBuffer:
+			{
+				const cmd::BindVertexBuffer& c = as<cmd::BindVertexBuffer>(payload);
+				vertexBuffer = _resources.GetGL(c.buffer);
+				vertexOffset = static_cast<GLintptr>(c.offset);
+				vertexDirty = true;
+				break;
+			}
+			case CommandType::BindIndexBuffer:
+			{
+				const cmd::BindIndexBuffer& c = as<cmd::BindIndexBuffer>(payload);
+				indexBuffer = _resources.GetGL(c.buffer);
+				indexOffset = c.offset;
+				indexType = c.type;
+				vertexDirty = true;
+				break;
+			}
+			case CommandType::BindUniformBuffer:
+			{
+				const cmd::BindUniformBuffer& c = as<cmd::BindUniformBuffer>(payload);
+				glBindBufferRange(GL_UNIFORM_BUFFER, c.slot, _resources.GetGL(c.buffer),
+								  static_cast<GLintptr>(c.offset), static_cast<GLsizeiptr>(c.size));
+				break;
+			}
+			case CommandType::BindTexture:
+			{
+				const cmd::BindTexture& c = as<cmd::BindTexture>(payload);
+				glBindTextureUnit(c.slot, _resources.GetGL(c.texture));
+				glBindSampler(c.slot, _sampler);
+				break;
+			}
+			case CommandType::PushConstants:
+			{
+				const cmd::PushConstants& c = as<cmd::PushConstants>(payload);
+				if (c.offset > MaxPushConstantBytes || c.size > MaxPushConstantBytes - c.offset) break;
+				std::memcpy(pushConstants + c.offset, static_cast<const uint8_t*>(payload) + sizeof(c), c.size);
+				pushDirty = true;
+				break;
+			}
+			case CommandType::Draw:
+			{
+				if (!pipeline) break;
+				const cmd::Draw& c = as<cmd::Draw>(payload);
+				flushDraw();
+				glDrawArraysInstancedBaseInstance(pipeline->topology, static_cast<GLint>(c.firstVertex),
+												  static_cast<GLsizei>(c.vertexCount),
+												  static_cast<GLsizei>(c.instanceCount), c.firstInstance);
+				break;
+			}
+			case CommandType::DrawIndexed:
+			{
+				if (!pipeline) break;
+				const cmd::DrawIndexed& c = as<cmd::DrawIndexed>(payload);
+				flushDraw();
+				const uint64_t indexSize = indexType == IndexType::UInt16 ? 2 : 4;
+				const uintptr_t first = static_cast<uintptr_t>(indexOffset + c.firstIndex * indexSize);
+				glDrawElementsInstancedBaseVertexBaseInstance(
+					pipeline->topology, static_cast<GLsizei>(c.indexCount),
+					indexType == IndexType::UInt16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT,
+					reinterpret_cast<const void*>(first), static_cast<GLsizei>(c.instanceCount), c.vertexOffset,
+					c.firstInstance);
+				break;
+			}
+			case CommandType::UpdateBuffer:
+			{
+				const cmd::UpdateBuffer& c = as<cmd::UpdateBuffer>(payload);
+				glNamedBufferSubData(_resources.GetGL(c.buffer), static_cast<GLintptr>(c.offset),
+									 static_cast<GLsizeiptr>(c.size), static_cast<const uint8_t*>(payload) + sizeof(c));
+				break;
+			}
+			default:
+				break;
+			}
+		});
+	}
+
+} // namespace gefx
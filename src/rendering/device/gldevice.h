@@ -0,0 +1,163 @@
+#ifndef __GLDEVICE__H__
+#define __GLDEVICE__H__
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include <core/containers/flathashmap.h>
+#include <core/containers/handlepool.h>
+#include <rendering/device/device.h>
+#include <rendering/device/uploadring.h>
+#include <rendering/gpuresources.h>
+
+namespace gefx
+{
+	/**
+	 * @brief OpenGL 4.5 core device, replays command lists with direct state access calls on the context
+	 * thread. Pipelines take SPIR-V, which needs 4.6 or ARB_gl_spirv.
+	 *
+	 * Push constants are emulated with a uniform block at PushConstantBinding: the bound pipeline's block is
+	 * copied into a persistently mapped ring right before each draw that follows a change. The ring is split
+	 * in one region per frame in flight, each fenced at EndFrame, so writing never waits on the GPU unless it
+	 * is FramesInFlight frames behind. Buffers and textures are GpuResources objects, destroying them is
+	 * deferred the same way.
+	 *
+	 * Uploads are staged in another persistently mapped ring and batched: FlushUploads issues the batch's
+	 * buffer copies and pixel unpack buffer texture updates, then fences the batch, and the ticket is
+	 * complete once that fence is.
+	 */
+	class GLDevice final : public IDevice
+	{
+	  public:
+		static constexpr uint32_t FramesInFlight = 3;
+		// Right after the uniform buffer slots, ShaderUtils::GLSLtoSPV points PUSH_CONSTANT at it
+		static constexpr uint32_t PushConstantBinding = MaxUniformBufferSlots;
+		static constexpr uint32_t PushConstantRegionBytes = 4 << 20;
+		static constexpr uint32_t UploadRingBytes = 32 << 20;
+
+		GLDevice() = default;
+		~GLDevice() override = default;
+
+		GLDevice(GLDevice&&) = delete;
+		GLDevice(const GLDevice&) = delete;
+		GLDevice& operator=(GLDevice&&) = delete;
+		GLDevice& operator=(const GLDevice&) = delete;
+
+		/**
+		 * @brief Create the device's own objects. The context must be current and stay current. False when it
+		 * is older than 4.5.
+		 */
+		bool Initialize();
+
+		/**
+		 * @brief Wait for the GPU and release everything. Call before the context goes away.
+		 */
+		void Shutdown();
+
+		DeviceBackend GetBackend() const override { return DeviceBackend::OpenGL; };
+
+		BufferHandle CreateBuffer(const BufferDesc& desc, const void* data = nullptr) override;
+		TextureHandle CreateTexture(const TextureDesc& desc) override;
+		PipelineHandle CreatePipeline(const PipelineDesc& desc) override;
+
+		void Destroy(BufferHandle handle) override;
+		void Destroy(TextureHandle handle) override;
+		void Destroy(PipelineHandle handle) override;
+
+		bool UploadBuffer(BufferHandle buffer, uint64_t offset, const void* data, uint64_t bytes,
+						  UploadTicket& outTicket) override;
+		bool UploadTexture(TextureHandle texture, uint32_t level, const void* data, UploadTicket& outTicket) override;
+		bool IsUploadComplete(UploadTicket ticket) override;
+		void FlushUploads() override;
+
+		using IDevice::Submit;
+		void Submit(rv::Span<const CommandList* const> lists) override;
+		void EndFrame() override;
+
+		const GpuResources& GetResources() const { return _resources; };
+
+	  private:
+		struct Pipeline
+		{
+			ProgramHandle program;
+			VertexArrayHandle vertexArray;
+			GLenum topology;
+			uint32_t vertexStride;
+			uint32_t pushConstantBytes;
+			CullMode cullMode;
+			bool depthTest;
+			bool depthWrite;
+			BlendMode blend;
+		};
+
+		struct Framebuffer
+		{
+			TextureHandle color;
+			TextureHandle depth;
+			GLuint id;
+		};
+
+		// Copy out of the upload ring, issued when the batch is flushed: bytes to a buffer at offset, or rows
+		// of a texture level starting at row
+		struct UploadCopy
+		{
+			BufferHandle buffer;
+			TextureHandle texture;
+			uint64_t staging;
+			uint64_t offset;
+			uint64_t bytes;
+			uint32_t level;
+			uint32_t row;
+			uint32_t rows;
+		};
+
+		struct UploadFence
+		{
+			uint64_t value;
+			GLsync fence;
+		};
+
+		void Execute(const CommandList& list);
+		GLuint GetFramebuffer(TextureHandle color, TextureHandle depth);
+		// Copy the push constant block into the ring and bind it, returns false when the ring can't be used
+		bool FlushPushConstants(const uint8_t* data, uint32_t bytes);
+		// Copy data into the upload ring, waiting for the oldest batches while it is full
+		bool StageUpload(const void* data, uint64_t bytes, uint64_t& outOffset);
+		// Retire the batches whose fence signaled, wait for the one of value first when it is not zero
+		void PollUploads(uint64_t wait = 0);
+
+		GpuResources _resources;
+		rv::HandlePool<PipelineTag, Pipeline> _pipelines;
+		std::vector<Framebuffer> _framebuffers;
+		GLuint _sampler{0};
+		// glSpecializeShader, or its ARB_gl_spirv twin on 4.5 drivers, null when neither is there
+		PFNGLSPECIALIZESHADERPROC _specializeShader{nullptr};
+		// Open render pass, it may continue in the next list of the same Submit
+		uint32_t _passWidth{0};
+		uint32_t _passHeight{0};
+		bool _inPass{false};
+
+		GLuint _pushRing{0};
+		uint8_t* _pushRingData{nullptr};
+		uint32_t _pushAlignment{256};
+		uint32_t _pushRegion{0};
+		uint32_t _pushOffset{0};
+		GLsync _pushFences[FramesInFlight]{};
+
+		GLuint _uploadBuffer{0};
+		uint8_t* _uploadData{nullptr};
+		UploadRing _uploadRing;
+		std::vector<UploadCopy> _uploadCopies;
+		std::deque<UploadFence> _uploadFences;
+		uint64_t _uploadsFlushed{0};
+		uint64_t _uploadsCompleted{0};
+		// Stored as RGBA8 like every RGBA8 texture, their uploads come in blue first
+		rv::FlatHashSet<uint64_t> _bgraTextures;
+	};
+
+} // namespace gefx
+
+#endif //!__GLDEVICE__H__
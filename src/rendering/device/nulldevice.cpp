@@ -0,0 +1,489 @@
+// StdLib Includes
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+
+// Third Party Includes
+#include <fmt/format.h>
+
+// Application Specific Includes
+#include <rendering/device/nulldevice.h>
+
+namespace gefx
+{
+	namespace
+	{
+		constexpr uint32_t SpirvMagic = 0x07230203;
+
+		struct CaptureHeader
+		{
+			// "GCAP"
+			static constexpr uint32_t Magic = 0x50414347;
+			static constexpr uint32_t Version = 1;
+
+			uint32_t magic;
+			uint32_t version;
+		};
+
+		// Every captured list is a record followed by its stream
+		struct CaptureRecord
+		{
+			uint32_t frame;
+			uint32_t bytes;
+		};
+
+		template <typename T>
+		const T& as(const void* payload)
+		{
+			return *static_cast<const T*>(payload);
+		}
+
+		bool isValidSpirv(rv::Span<const uint32_t> code)
+		{
+			return code.size() >= 5 && code[0] == SpirvMagic;
+		}
+
+		uint32_t getIndexSize(IndexType type)
+		{
+			return type == IndexType::UInt16 ? 2 : 4;
+		}
+	} // namespace
+
+	NullDevice::NullDevice(uint64_t uploadRingBytes) : _uploadRing(uploadRingBytes)
+	{
+		ClearCapture();
+	}
+
+	BufferHandle NullDevice::CreateBuffer(const BufferDesc& desc, const void* data)
+	{
+		(void)data;
+		if (desc.bytes == 0)
+		{
+			Error("CreateBuffer: empty buffer");
+			return BufferHandle();
+		}
+		return _buffers.Create(desc);
+	}
+
+	TextureHandle NullDevice::CreateTexture(const TextureDesc& desc)
+	{
+		if (desc.width == 0 || desc.height == 0 || desc.format == Format::Undefined)
+		{
+			Error(fmt::format("CreateTexture: invalid {}x{} texture", desc.width, desc.height));
+			return TextureHandle();
+		}
+
+		uint32_t maxLevels = 1;
+		while ((std::max(desc.width, desc.height) >> maxLevels) > 0) maxLevels++;
+		if (desc.levels == 0 || desc.levels > maxLevels)
+		{
+			Error(fmt::format("CreateTexture: {} levels, a {}x{} texture has at most {}", desc.levels, desc.width,
+							  desc.height, maxLevels));
+			return TextureHandle();
+		}
+		if ((desc.usage == TextureUsage::DepthStencil) != isDepthFormat(desc.format))
+		{
+			Error("CreateTexture: depth formats go with DepthStencil usage and only with it");
+			return TextureHandle();
+		}
+		return _textures.Create(desc);
+	}
+
+	PipelineHandle NullDevice::CreatePipeline(const PipelineDesc& desc)
+	{
+		if (!isValidSpirv(desc.vertexSpirv) || !isValidSpirv(desc.fragmentSpirv))
+		{
+			Error("CreatePipeline: shaders are not SPIR-V");
+			return PipelineHandle();
+		}
+		if (desc.attributeCount > MaxVertexAttributes)
+		{
+			Error(fmt::format("CreatePipeline: {} vertex attributes, at most {}", desc.attributeCount,
+							  MaxVertexAttributes));
+			return PipelineHandle();
+		}
+		for (uint32_t i = 0; i < desc.attributeCount; i++)
+		{
+			const VertexAttribute& attribute = desc.attributes[i];
+			const uint32_t size = getFormatSize(attribute.format);
+			if (size == 0 || isDepthFormat(attribute.format) || attribute.offset > desc.vertexStride ||
+				size > desc.vertexStride - attribute.offset)
+			{
+				Error(fmt::format("CreatePipeline: attribute {} doesn't fit a {} bytes vertex", attribute.location,
+								  desc.vertexStride));
+				return PipelineHandle();
+			}
+		}
+		if (desc.pushConstantBytes > MaxPushConstantBytes || desc.pushConstantBytes % 4 != 0)
+		{
+			Error(fmt::format("CreatePipeline: {} push constant bytes, at most {} and a multiple of 4",
+							  desc.pushConstantBytes, MaxPushConstantBytes));
+			return PipelineHandle();
+		}
+		if (isDepthFormat(desc.colorFormat) ||
+			(desc.depthFormat != Format::Undefined && !isDepthFormat(desc.depthFormat)))
+		{
+			Error("CreatePipeline: attachment formats don't match their attachments");
+			return PipelineHandle();
+		}
+
+		return _pipelines.Create(Pipeline{desc.attributeCount, desc.vertexStride, desc.pushConstantBytes,
+										  desc.colorFormat, desc.depthFormat});
+	}
+
+	void NullDevice::Destroy(BufferHandle handle)
+	{
+		if (!handle.IsNull() && !_buffers.Destroy(handle)) Error("Destroy: stale buffer handle");
+	}
+
+	void NullDevice::Destroy(TextureHandle handle)
+	{
+		if (!handle.IsNull() && !_textures.Destroy(handle)) Error("Destroy: stale texture handle");
+	}
+
+	void NullDevice::Destroy(PipelineHandle handle)
+	{
+		if (!handle.IsNull() && !_pipelines.Destroy(handle)) Error("Destroy: stale pipeline handle");
+	}
+
+	bool NullDevice::UploadBuffer(BufferHandle buffer, uint64_t offset, const void* data, uint64_t bytes,
+								  UploadTicket& outTicket)
+	{
+		const BufferDesc* desc = _buffers.Get(buffer);
+		if (!desc || !data)
+		{
+			Error("UploadBuffer: stale buffer handle or no data");
+			return false;
+		}
+		if (bytes == 0 || offset > desc->bytes || bytes > desc->bytes - offset)
+		{
+			Error(fmt::format("UploadBuffer: {} bytes at {} don't fit a {} bytes buffer", bytes, offset, desc->bytes));
+			return false;
+		}
+		const uint64_t chunkBytes = std::max<uint64_t>(_uploadRing.GetSize() / 4, 1);
+		for (uint64_t done = 0; done < bytes; done += chunkBytes)
+		{
+			if (!StageUpload(std::min(bytes - done, chunkBytes))) return false;
+		}
+		_stats.uploadBytes += bytes;
+		outTicket = UploadTicket{_uploadsFlushed + 1};
+		return true;
+	}
+
+	bool NullDevice::UploadTexture(TextureHandle texture, uint32_t level, const void* data, UploadTicket& outTicket)
+	{
+		const TextureDesc* desc = _textures.Get(texture);
+		if (!desc || !data)
+		{
+			Error("UploadTexture: stale texture handle or no data");
+			return false;
+		}
+		if (desc->usage != TextureUsage::Sampled || level >= desc->levels)
+		{
+			Error(fmt::format("UploadTexture: level {} of a texture with {} levels, only sampled textures", level,
+							  desc->levels));
+			return false;
+		}
+		// Whole rows per part
+		const uint64_t width = std::max(desc->width >> level, 1u);
+		const uint64_t height = std::max(desc->height >> level, 1u);
+		const uint64_t rowBytes = width * getFormatSize(desc->format);
+		const uint64_t chunkBytes = _uploadRing.GetSize() / 4;
+		if (rowBytes > chunkBytes)
+		{
+			Error(fmt::format("UploadTexture: rows of {} bytes don't fit a quarter of the upload ring", rowBytes));
+			return false;
+		}
+		const uint64_t chunkRows = std::min(height, chunkBytes / rowBytes);
+		for (uint64_t row = 0; row < height; row += chunkRows)
+		{
+			if (!StageUpload(std::min(chunkRows, height - row) * rowBytes)) return false;
+		}
+		_stats.uploadBytes += rowBytes * height;
+		outTicket = UploadTicket{_uploadsFlushed + 1};
+		return true;
+	}
+
+	void NullDevice::FlushUploads()
+	{
+		if (_uploadsOpen) _uploadRing.Close(++_uploadsFlushed);
+		_uploadsOpen = false;
+	}
+
+	bool NullDevice::StageUpload(uint64_t bytes)
+	{
+		uint64_t offset;
+		while (!_uploadRing.Allocate(bytes, 16, offset))
+		{
+			// Full of batches in flight: send the open one off and let the GPU finish the oldest
+			FlushUploads();
+			const uint64_t oldest = _uploadRing.GetOldestPending();
+			if (oldest == 0) return false;
+			_stats.uploadStalls++;
+			_uploadsCompleted = std::max(_uploadsCompleted, oldest);
+			_uploadRing.Release(_uploadsCompleted);
+		}
+		_uploadsOpen = true;
+		return true;
+	}
+
+	void NullDevice::Submit(rv::Span<const CommandList* const> lists)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		_stats.submits++;
+		bool inPass = false;
+		for (const CommandList* list : lists)
+		{
+			Validate(*list, _listsThisFrame++, inPass);
+			CountSubmitted(*list);
+
+			if (_capturing)
+			{
+				const rv::Span<const uint8_t> data = list->GetData();
+				const CaptureRecord record{_frame, static_cast<uint32_t>(data.size())};
+				const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&record);
+				_capture.insert(_capture.end(), bytes, bytes + sizeof(record));
+				_capture.insert(_capture.end(), data.begin(), data.end());
+			}
+		}
+		if (inPass)
+		{
+			Error(fmt::format("frame {} list {}: submit ends inside a render pass", _frame, _listsThisFrame - 1));
+		}
+		_stats.submitMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	void NullDevice::EndFrame()
+	{
+		// Flushed uploads take a frame of GPU time
+		_uploadsCompleted = _uploadsFlushed;
+		_uploadRing.Release(_uploadsCompleted);
+		FlushUploads();
+		_frame++;
+		_listsThisFrame = 0;
+		RollFrameStats();
+	}
+
+	void NullDevice::Validate(const CommandList& list, uint32_t listIndex, bool& inPass)
+	{
+		// Only the state a real backend would trip over. Nothing but the open render pass is inherited from
+		// previous lists, a list continuing a pass binds its own pipeline and buffers.
+		const Pipeline* pipeline = nullptr;
+		const BufferDesc* vertexBuffer = nullptr;
+		uint64_t vertexOffset = 0;
+		const BufferDesc* indexBuffer = nullptr;
+		uint64_t indexOffset = 0;
+		IndexType indexType = IndexType::UInt32;
+		uint32_t commandIndex = 0;
+
+		list.ForEach([&](const CommandHeader& header, const void* payload) {
+			auto fail = [&](const std::string& message) {
+				Error(fmt::format("frame {} list {} command {} {}: {}", _frame, listIndex, commandIndex,
+								  getCommandName(header.type), message));
+			};
+
+			switch (header.type)
+			{
+			case CommandType::BeginRenderPass:
+			{
+				const RenderPassDesc& desc = as<cmd::BeginRenderPass>(payload).desc;
+				if (inPass) fail("render passes can't nest");
+				inPass = true;
+				if (desc.width == 0 || desc.height == 0) fail("empty render area");
+
+				const TextureDesc* color = _textures.Get(desc.color);
+				if (!desc.color.IsNull() && !color) fail("stale color target");
+				if (color && (color->usage != TextureUsage::RenderTarget || color->width < desc.width ||
+							  color->height < desc.height))
+				{
+					fail("color target isn't a render target covering the render area");
+				}
+				const TextureDesc* depth = _textures.Get(desc.depth);
+				if (!desc.depth.IsNull() && !depth) fail("stale depth target");
+				if (depth && (depth->usage != TextureUsage::DepthStencil || depth->width < desc.width ||
+							  depth->height < desc.height))
+				{
+					fail("depth target isn't a depth stencil texture covering the render area");
+				}
+				break;
+			}
+			case CommandType::EndRenderPass:
+				if (!inPass) fail("no render pass to end");
+				inPass = false;
+				break;
+			case CommandType::SetViewport:
+				if (as<cmd::SetViewport>(payload).width <= 0.0f) fail("empty viewport");
+				break;
+			case CommandType::BindPipeline:
+				pipeline = _pipelines.Get(as<cmd::BindPipeline>(payload).pipeline);
+				if (!pipeline) fail("stale or null pipeline");
+				break;
+			case CommandType::BindVertexBuffer:
+			{
+				const cmd::BindVertexBuffer& c = as<cmd::BindVertexBuffer>(payload);
+				vertexBuffer = _buffers.Get(c.buffer);
+				vertexOffset = c.offset;
+				if (!vertexBuffer) fail("stale or null buffer");
+				else if (vertexBuffer->usage != BufferUsage::Vertex) fail("buffer isn't a vertex buffer");
+				break;
+			}
+			case CommandType::BindIndexBuffer:
+			{
+				const cmd::BindIndexBuffer& c = as<cmd::BindIndexBuffer>(payload);
+				indexBuffer = _buffers.Get(c.buffer);
+				indexOffset = c.offset;
+				indexType = c.type;
+				if (!indexBuffer) fail("stale or null buffer");
+				else if (indexBuffer->usage != BufferUsage::Index) fail("buffer isn't an index buffer");
+				if (c.offset % getIndexSize(c.type) != 0) fail("offset isn't aligned to the index size");
+				break;
+			}
+			case CommandType::BindUniformBuffer:
+			{
+				const cmd::BindUniformBuffer& c = as<cmd::BindUniformBuffer>(payload);
+				const BufferDesc* buffer = _buffers.Get(c.buffer);
+				if (c.slot >= MaxUniformBufferSlots) fail(fmt::format("slot {} out of range", c.slot));
+				if (!buffer) fail("stale or null buffer");
+				else if (buffer->usage != BufferUsage::Uniform) fail("buffer isn't a uniform buffer");
+				else if (c.size == 0 || c.offset > buffer->bytes || c.size > buffer->bytes - c.offset)
+				{
+					fail("range outside the buffer");
+				}
+				break;
+			}
+			case CommandType::BindTexture:
+			{
+				const cmd::BindTexture& c = as<cmd::BindTexture>(payload);
+				if (c.slot >= MaxTextureSlots) fail(fmt::format("slot {} out of range", c.slot));
+				if (!_textures.IsValid(c.texture)) fail("stale or null texture");
+				break;
+			}
+			case CommandType::PushConstants:
+			{
+				const cmd::PushConstants& c = as<cmd::PushConstants>(payload);
+				const uint32_t limit = pipeline ? pipeline->pushConstantBytes : MaxPushConstantBytes;
+				if (c.offset % 4 != 0 || c.size % 4 != 0) fail("offset and size must be multiples of 4");
+				if (c.offset > limit || c.size > limit - c.offset)
+				{
+					fail(fmt::format("{} bytes past the {} bytes block", uint64_t(c.offset) + c.size - limit, limit));
+				}
+				break;
+			}
+			case CommandType::Draw:
+			{
+				const cmd::Draw& c = as<cmd::Draw>(payload);
+				if (!inPass) fail("draw outside a render pass");
+				if (!pipeline)
+				{
+					fail("no pipeline bound");
+					break;
+				}
+				if (pipeline->attributeCount > 0 && !vertexBuffer)
+				{
+					fail("no vertex buffer bound");
+				}
+				else if (vertexBuffer &&
+						 (vertexOffset > vertexBuffer->bytes ||
+						  (uint64_t(c.firstVertex) + c.vertexCount) * pipeline->vertexStride >
+							  vertexBuffer->bytes - vertexOffset))
+				{
+					fail("vertices past the end of the vertex buffer");
+				}
+				break;
+			}
+			case CommandType::DrawIndexed:
+			{
+				const cmd::DrawIndexed& c = as<cmd::DrawIndexed>(payload);
+				if (!inPass) fail("draw outside a render pass");
+				if (!pipeline) fail("no pipeline bound");
+				else if (pipeline->attributeCount > 0 && !vertexBuffer) fail("no vertex buffer bound");
+				if (!indexBuffer) fail("no index buffer bound");
+				else if (indexOffset > indexBuffer->bytes ||
+						 (uint64_t(c.firstIndex) + c.indexCount) * getIndexSize(indexType) >
+							 indexBuffer->bytes - indexOffset)
+				{
+					fail("indices past the end of the index buffer");
+				}
+				break;
+			}
+			case CommandType::UpdateBuffer:
+			{
+				const cmd::UpdateBuffer& c = as<cmd::UpdateBuffer>(payload);
+				const BufferDesc* buffer = _buffers.Get(c.buffer);
+				if (inPass) fail("buffer updates can't be inside a render pass");
+				if (c.offset % 4 != 0 || c.size % 4 != 0) fail("offset and size must be multiples of 4");
+				if (c.size > MaxInlineUpdateBytes)
+				{
+					fail(fmt::format("{} bytes, at most {}", c.size, MaxInlineUpdateBytes));
+				}
+				if (!buffer) fail("stale or null buffer");
+				else if (c.offset > buffer->bytes || c.size > buffer->bytes - c.offset)
+				{
+					fail("range outside the buffer");
+				}
+				break;
+			}
+			default:
+				break;
+			}
+			commandIndex++;
+		});
+	}
+
+	void NullDevice::Error(std::string message)
+	{
+		if (_errors.size() < MaxErrors) _errors.push_back(std::move(message));
+		_errorCount++;
+	}
+
+	void NullDevice::ClearErrors()
+	{
+		_errors.clear();
+		_errorCount = 0;
+	}
+
+	rv::Span<const uint8_t> NullDevice::GetCapture() const
+	{
+		return rv::Span<const uint8_t>(_capture.data(), _capture.size());
+	}
+
+	void NullDevice::ClearCapture()
+	{
+		const CaptureHeader header{CaptureHeader::Magic, CaptureHeader::Version};
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&header);
+		_capture.assign(bytes, bytes + sizeof(header));
+	}
+
+	bool NullDevice::WriteCapture(const char* path) const
+	{
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+		out.write(reinterpret_cast<const char*>(_capture.data()), _capture.size());
+		return static_cast<bool>(out);
+	}
+
+	bool NullDevice::LoadCapture(rv::Span<const uint8_t> capture, std::vector<CapturedList>& outLists)
+	{
+		CaptureHeader header;
+		if (capture.size() < sizeof(header)) return false;
+		std::memcpy(&header, capture.data(), sizeof(header));
+		if (header.magic != CaptureHeader::Magic || header.version != CaptureHeader::Version) return false;
+
+		size_t offset = sizeof(header);
+		while (offset < capture.size())
+		{
+			CaptureRecord record;
+			if (capture.size() - offset < sizeof(record)) return false;
+			std::memcpy(&record, capture.data() + offset, sizeof(record));
+			offset += sizeof(record);
+			if (capture.size() - offset < record.bytes) return false;
+
+			CapturedList captured{record.frame, CommandList()};
+			if (!captured.list.Load(capture.subspan(offset, record.bytes))) return false;
+			outLists.push_back(std::move(captured));
+			offset += record.bytes;
+		}
+		return true;
+	}
+
+} // namespace gefx
@@ -0,0 +1,133 @@
+#ifndef __NULLDEVICE__H__
+#define __NULLDEVICE__H__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <core/containers/handlepool.h>
+#include <core/span.h>
+#include <rendering/device/commandlist.h>
+#include <rendering/device/device.h>
+#include <rendering/device/uploadring.h>
+
+namespace gefx
+{
+	struct CapturedList
+	{
+		uint32_t frame;
+		CommandList list;
+	};
+
+	/**
+	 * @brief Device without a GPU behind it. Resources only exist as their descriptions, submitted lists are
+	 * validated against them the way a real backend would need them to be, counted, and optionally captured.
+	 *
+	 * Meant for benchmarking the CPU side of the render path and for regression tests without a GL context:
+	 * validation failures are collected as messages instead of crashing, and the capture holds every
+	 * submitted stream, tagged with its frame, ready to be written to disk and loaded back into command lists.
+	 * Uploads are checked and counted, and complete at the EndFrame after they were flushed. They take space
+	 * in an UploadRing the way the GPU backends stage them, in parts of a quarter ring, and an upload finding
+	 * it full completes the oldest batch early, as waiting for its fence would.
+	 */
+	class NullDevice final : public IDevice
+	{
+	  public:
+		// Messages kept past this are only counted
+		static constexpr uint32_t MaxErrors = 256;
+		static constexpr uint64_t UploadRingBytes = 32ull << 20;
+
+		explicit NullDevice(uint64_t uploadRingBytes = UploadRingBytes);
+		~NullDevice() override = default;
+
+		NullDevice(NullDevice&&) = delete;
+		NullDevice(const NullDevice&) = delete;
+		NullDevice& operator=(NullDevice&&) = delete;
+		NullDevice& operator=(const NullDevice&) = delete;
+
+		DeviceBackend GetBackend() const override { return DeviceBackend::Null; };
+
+		BufferHandle CreateBuffer(const BufferDesc& desc, const void* data = nullptr) override;
+		TextureHandle CreateTexture(const TextureDesc& desc) override;
+		PipelineHandle CreatePipeline(const PipelineDesc& desc) override;
+
+		void Destroy(BufferHandle handle) override;
+		void Destroy(TextureHandle handle) override;
+		void Destroy(PipelineHandle handle) override;
+
+		bool UploadBuffer(BufferHandle buffer, uint64_t offset, const void* data, uint64_t bytes,
+						  UploadTicket& outTicket) override;
+		bool UploadTexture(TextureHandle texture, uint32_t level, const void* data, UploadTicket& outTicket) override;
+		bool IsUploadComplete(UploadTicket ticket) override { return ticket.value <= _uploadsCompleted; };
+		void FlushUploads() override;
+
+		using IDevice::Submit;
+		void Submit(rv::Span<const CommandList* const> lists) override;
+		void EndFrame() override;
+
+		const BufferDesc* Get(BufferHandle handle) const { return _buffers.Get(handle); };
+		const TextureDesc* Get(TextureHandle handle) const { return _textures.Get(handle); };
+		uint32_t GetFrameIndex() const { return _frame; };
+		const UploadRing& GetUploadRing() const { return _uploadRing; };
+
+		/**
+		 * @brief Validation messages in the order they were found, the first MaxErrors of GetErrorCount.
+		 */
+		const std::vector<std::string>& GetErrors() const { return _errors; };
+		uint32_t GetErrorCount() const { return _errorCount; };
+		void ClearErrors();
+
+		/**
+		 * @brief Record every list submitted from now on. Resource creation isn't part of the capture.
+		 */
+		void SetCapture(bool enabled) { _capturing = enabled; };
+		bool IsCapturing() const { return _capturing; };
+		rv::Span<const uint8_t> GetCapture() const;
+		void ClearCapture();
+		bool WriteCapture(const char* path) const;
+
+		/**
+		 * @brief Parse a capture from GetCapture or a file written by WriteCapture.
+		 *
+		 * @return false if it is malformed, outLists then holds the lists read before the error.
+		 */
+		static bool LoadCapture(rv::Span<const uint8_t> capture, std::vector<CapturedList>& outLists);
+
+	  private:
+		struct Pipeline
+		{
+			uint32_t attributeCount;
+			uint32_t vertexStride;
+			uint32_t pushConstantBytes;
+			Format colorFormat;
+			Format depthFormat;
+		};
+
+		// inPass carries an open render pass over to the next list of the same Submit
+		void Validate(const CommandList& list, uint32_t listIndex, bool& inPass);
+		void Error(std::string message);
+		// Space for bytes in the ring, false when it can never fit
+		bool StageUpload(uint64_t bytes);
+
+		rv::HandlePool<BufferTag, BufferDesc> _buffers;
+		rv::HandlePool<TextureTag, TextureDesc> _textures;
+		rv::HandlePool<PipelineTag, Pipeline> _pipelines;
+
+		std::vector<std::string> _errors;
+		uint32_t _errorCount{0};
+		uint32_t _frame{0};
+		uint32_t _listsThisFrame{0};
+
+		// Upload batches: the open one gets _uploadsFlushed + 1
+		bool _uploadsOpen{false};
+		uint64_t _uploadsFlushed{0};
+		uint64_t _uploadsCompleted{0};
+		UploadRing _uploadRing;
+
+		bool _capturing{false};
+		std::vector<uint8_t> _capture;
+	};
+
+} // namespace gefx
+
+#endif //!__NULLDEVICE__H__
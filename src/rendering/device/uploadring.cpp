@@ -0,0 +1,52 @@
+// Application Specific Includes
+#include <core/bits.h>
+#include <rendering/device/uploadring.h>
+
+namespace gefx
+{
+	bool UploadRing::Allocate(uint64_t bytes, uint64_t alignment, uint64_t& outOffset)
+	{
+		if (bytes == 0 || bytes > _size) return false;
+		if (_used == 0) _head = _tail = 0;
+
+		// Live space is [tail, head) until head wraps around, then [tail, size) and [0, head)
+		const bool wrapped = _head < _tail || (_head == _tail && _used > 0);
+		uint64_t offset = rv::alignUp(_head, alignment);
+		uint64_t skipped = offset - _head;
+		if (wrapped)
+		{
+			if (offset + bytes > _tail) return false;
+		}
+		else if (offset + bytes > _size)
+		{
+			// The end of the ring can't hold it, skip it and start over at the front
+			if (bytes > _tail) return false;
+			skipped = _size - _head;
+			offset = 0;
+		}
+
+		_used += skipped + bytes;
+		_openBytes += skipped + bytes;
+		_head = offset + bytes;
+		outOffset = offset;
+		return true;
+	}
+
+	void UploadRing::Close(uint64_t value)
+	{
+		_batches.push_back(Batch{value, _head, _openBytes});
+		_openBytes = 0;
+	}
+
+	void UploadRing::Release(uint64_t completed)
+	{
+		while (!_batches.empty() && _batches.front().value <= completed)
+		{
+			// An empty batch may predate the ring starting over at the front
+			if (_batches.front().bytes > 0) _tail = _batches.front().end;
+			_used -= _batches.front().bytes;
+			_batches.pop_front();
+		}
+	}
+
+} // namespace gefx
@@ -0,0 +1,67 @@
+#ifndef __UPLOADRING__H__
+#define __UPLOADRING__H__
+
+#include <cstdint>
+#include <deque>
+
+namespace gefx
+{
+	/**
+	 * @brief Staging space of asynchronous uploads, handed out front to back and wrapping around. Offsets
+	 * only, the backend owns the memory.
+	 *
+	 * Space belongs to the batch open when it was allocated. Close tags the open batch with the value the GPU
+	 * reaches once the batch's copies are done (a timeline value, a fence count), and Release frees the
+	 * batches up to a completed value, oldest first.
+	 */
+	class UploadRing
+	{
+	  public:
+		UploadRing() = default;
+		explicit UploadRing(uint64_t size) : _size(size){};
+
+		/**
+		 * @brief Place bytes at an alignment (power of two). False when the ring is full of batches the GPU
+		 * hasn't finished, or bytes don't fit in it at all.
+		 */
+		bool Allocate(uint64_t bytes, uint64_t alignment, uint64_t& outOffset);
+
+		/**
+		 * @brief Close the open batch as value, values increase from one batch to the next.
+		 */
+		void Close(uint64_t value);
+
+		/**
+		 * @brief Free the closed batches whose value is at most completed.
+		 */
+		void Release(uint64_t completed);
+
+		/**
+		 * @brief Value of the oldest closed batch still holding space, 0 when there is none.
+		 */
+		uint64_t GetOldestPending() const { return _batches.empty() ? 0 : _batches.front().value; };
+
+		uint64_t GetSize() const { return _size; };
+		// Alignment and the tail skipped when wrapping included
+		uint64_t GetUsed() const { return _used; };
+
+	  private:
+		struct Batch
+		{
+			uint64_t value;
+			// Where the batch's space ends, the oldest live byte once the batches before it are released
+			uint64_t end;
+			uint64_t bytes;
+		};
+
+		std::deque<Batch> _batches;
+		uint64_t _size{0};
+		uint64_t _head{0};
+		uint64_t _tail{0};
+		uint64_t _used{0};
+		uint64_t _openBytes{0};
+	};
+
+} // namespace gefx
+
+#endif //!__UPLOADRING__H__
@@ -0,0 +1,364 @@
+// StdLib Includes
+#include <cassert>
+#include <cstring>
+
+// Application Specific Includes
+#include <core/containers/hash.h>
+#include <core/log.h>
+#include <rendering/device/vkdescriptors.h>
+
+namespace gefx
+{
+	namespace
+	{
+		bool check(VkResult result, const char* what)
+		{
+			if (result == VK_SUCCESS) return true;
+			GEFX_LOG_ERROR("[Vulkan] {} failed: {}", what, static_cast<int>(result));
+			return false;
+		}
+
+		// Non-dispatchable handles are pointers or uint64_t depending on the platform
+		template <typename T>
+		uint64_t toBits(T handle)
+		{
+			uint64_t bits = 0;
+			std::memcpy(&bits, &handle, sizeof(handle));
+			return bits;
+		}
+
+		uint64_t combine(uint64_t hash, uint64_t value)
+		{
+			return rv::mixHash(hash ^ (value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2)));
+		}
+
+		bool sameBinding(const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b)
+		{
+			return a.binding == b.binding && a.descriptorType == b.descriptorType &&
+				   a.descriptorCount == b.descriptorCount && a.stageFlags == b.stageFlags &&
+				   a.pImmutableSamplers == b.pImmutableSamplers;
+		}
+	} // namespace
+
+	void DescriptorLayoutCache::Initialize(const VulkanFunctions* vk, VkDevice device)
+	{
+		_vk = vk;
+		_device = device;
+	}
+
+	void DescriptorLayoutCache::Shutdown()
+	{
+		for (const auto& [key, layout] : _layouts)
+		{
+			_vk->vkDestroyDescriptorSetLayout(_device, layout, nullptr);
+		}
+		_layouts.clear();
+	}
+
+	bool DescriptorLayoutCache::LayoutKey::operator==(const LayoutKey& other) const
+	{
+		if (flags != other.flags || bindings.size() != other.bindings.size()) return false;
+		if (bindingFlags != other.bindingFlags) return false;
+		for (size_t i = 0; i < bindings.size(); i++)
+		{
+			if (!sameBinding(bindings[i], other.bindings[i])) return false;
+		}
+		return true;
+	}
+
+	uint64_t DescriptorLayoutCache::LayoutKeyHash::operator()(const LayoutKey& key) const
+	{
+		uint64_t hash = combine(key.flags, key.bindings.size());
+		for (size_t i = 0; i < key.bindings.size(); i++)
+		{
+			const VkDescriptorSetLayoutBinding& binding = key.bindings[i];
+			hash = combine(hash, (uint64_t(binding.binding) << 32) | binding.descriptorType);
+			hash = combine(hash, (uint64_t(binding.descriptorCount) << 32) | binding.stageFlags);
+			hash = combine(hash, toBits(binding.pImmutableSamplers));
+			hash = combine(hash, key.bindingFlags.empty() ? 0 : key.bindingFlags[i]);
+		}
+		return hash;
+	}
+
+	VkDescriptorSetLayout DescriptorLayoutCache::Get(rv::Span<const VkDescriptorSetLayoutBinding> bindings,
+													 const VkDescriptorBindingFlags* bindingFlags,
+													 VkDescriptorSetLayoutCreateFlags flags)
+	{
+		LayoutKey key;
+		key.bindings.assign(bindings.data(), bindings.data() + bindings.size());
+		if (bindingFlags) key.bindingFlags.assign(bindingFlags, bindingFlags + bindings.size());
+		key.flags = flags;
+		const auto found = _layouts.find(key);
+		if (found != _layouts.end()) return found->second;
+
+		VkDescriptorSetLayoutBindingFlagsCreateInfo flagsInfo{};
+		flagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+		flagsInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+		flagsInfo.pBindingFlags = bindingFlags;
+		VkDescriptorSetLayoutCreateInfo layoutInfo{};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.pNext = bindingFlags ? &flagsInfo : nullptr;
+		layoutInfo.flags = flags;
+		layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+		layoutInfo.pBindings = bindings.data();
+		VkDescriptorSetLayout layout;
+		if (!check(_vk->vkCreateDescriptorSetLayout(_device, &layoutInfo, nullptr, &layout),
+				   "vkCreateDescriptorSetLayout"))
+		{
+			return VK_NULL_HANDLE;
+		}
+		_layouts.try_emplace(std::move(key), layout);
+		return layout;
+	}
+
+	bool DescriptorAllocator::SetKey::operator==(const SetKey& other) const
+	{
+		return layout == other.layout && count == other.count &&
+			   std::memcmp(entries, other.entries, count * sizeof(entries[0])) == 0;
+	}
+
+	uint64_t DescriptorAllocator::SetKeyHash::operator()(const SetKey& key) const
+	{
+		uint64_t hash = combine(toBits(key.layout), key.count);
+		for (uint32_t i = 0; i < key.count; i++)
+		{
+			hash = combine(hash, key.entries[i][0]);
+			hash = combine(hash, key.entries[i][1]);
+			hash = combine(hash, key.entries[i][2]);
+		}
+		return hash;
+	}
+
+	void DescriptorAllocator::Initialize(const VulkanFunctions* vk, VkDevice device,
+										 rv::Span<const VkDescriptorPoolSize> setSizes)
+	{
+		_vk = vk;
+		_device = device;
+		_poolSizes.clear();
+		for (const VkDescriptorPoolSize& size : setSizes)
+		{
+			_poolSizes.push_back({size.type, size.descriptorCount * SetsPerPool});
+		}
+	}
+
+	void DescriptorAllocator::Shutdown()
+	{
+		for (VkDescriptorPool pool : _pools)
+		{
+			_vk->vkDestroyDescriptorPool(_device, pool, nullptr);
+		}
+		_pools.clear();
+		_pool = 0;
+		_sets.clear();
+		_stats = {};
+	}
+
+	void DescriptorAllocator::Reset()
+	{
+		for (uint32_t i = 0; i < _pools.size() && i <= _pool; i++)
+		{
+			_vk->vkResetDescriptorPool(_device, _pools[i], 0);
+		}
+		_pool = 0;
+		_sets.clear();
+		_stats = {};
+		_stats.pools = static_cast<uint32_t>(_pools.size());
+	}
+
+	VkDescriptorSet DescriptorAllocator::GetSet(VkDescriptorSetLayout layout, VkDescriptorType type,
+												const VkDescriptorBufferInfo* infos, uint32_t count)
+	{
+		assert(count <= MaxBindings);
+		SetKey key{layout, count, {}};
+		VkWriteDescriptorSet writes[MaxBindings];
+		for (uint32_t i = 0; i < count; i++)
+		{
+			key.entries[i][0] = toBits(infos[i].buffer);
+			key.entries[i][1] = infos[i].offset;
+			key.entries[i][2] = infos[i].range;
+			writes[i] = {};
+			writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[i].dstBinding = i;
+			writes[i].descriptorCount = 1;
+			writes[i].descriptorType = type;
+			writes[i].pBufferInfo = &infos[i];
+		}
+		return GetSet(key, writes);
+	}
+
+	VkDescriptorSet DescriptorAllocator::GetSet(VkDescriptorSetLayout layout, VkDescriptorType type,
+												const VkDescriptorImageInfo* infos, uint32_t count)
+	{
+		assert(count <= MaxBindings);
+		SetKey key{layout, count, {}};
+		VkWriteDescriptorSet writes[MaxBindings];
+		for (uint32_t i = 0; i < count; i++)
+		{
+			key.entries[i][0] = toBits(infos[i].sampler);
+			key.entries[i][1] = toBits(infos[i].imageView);
+			key.entries[i][2] = infos[i].imageLayout;
+			writes[i] = {};
+			writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[i].dstBinding = i;
+			writes[i].descriptorCount = 1;
+			writes[i].descriptorType = type;
+			writes[i].pImageInfo = &infos[i];
+		}
+		return GetSet(key, writes);
+	}
+
+	VkDescriptorSet DescriptorAllocator::GetSet(const SetKey& key, VkWriteDescriptorSet* writes)
+	{
+		// Resources destroyed this frame are retired, not released, so no handle in a key is reused before
+		// the Reset clearing the cache
+		const auto found = _sets.find(key);
+		if (found != _sets.end())
+		{
+			_stats.reused++;
+			return found->second;
+		}
+
+		const VkDescriptorSet set = Allocate(key.layout);
+		if (!set) return VK_NULL_HANDLE;
+		for (uint32_t i = 0; i < key.count; i++)
+		{
+			writes[i].dstSet = set;
+		}
+		_vk->vkUpdateDescriptorSets(_device, key.count, writes, 0, nullptr);
+		_sets.try_emplace(key, set);
+		_stats.allocated++;
+		return set;
+	}
+
+	VkDescriptorSet DescriptorAllocator::Allocate(VkDescriptorSetLayout layout)
+	{
+		while (true)
+		{
+			if (_pool == _pools.size())
+			{
+				VkDescriptorPoolCreateInfo poolInfo{};
+				poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+				poolInfo.maxSets = SetsPerPool;
+				poolInfo.poolSizeCount = static_cast<uint32_t>(_poolSizes.size());
+				poolInfo.pPoolSizes = _poolSizes.data();
+				VkDescriptorPool pool = VK_NULL_HANDLE;
+				if (!check(_vk->vkCreateDescriptorPool(_device, &poolInfo, nullptr, &pool), "vkCreateDescriptorPool"))
+				{
+					return VK_NULL_HANDLE;
+				}
+				_pools.push_back(pool);
+				_stats.poolsCreated++;
+				_stats.pools++;
+			}
+
+			VkDescriptorSetAllocateInfo allocateInfo{};
+			allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+			allocateInfo.descriptorPool = _pools[_pool];
+			allocateInfo.descriptorSetCount = 1;
+			allocateInfo.pSetLayouts = &layout;
+			VkDescriptorSet set = VK_NULL_HANDLE;
+			const VkResult result = _vk->vkAllocateDescriptorSets(_device, &allocateInfo, &set);
+			if (result == VK_SUCCESS) return set;
+			if (result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL)
+			{
+				check(result, "vkAllocateDescriptorSets");
+				return VK_NULL_HANDLE;
+			}
+			// Pool full, move on to the next one
+			_pool++;
+		}
+	}
+
+	bool BindlessTextureTable::Initialize(const VulkanFunctions* vk, VkDevice device, DescriptorLayoutCache& layouts,
+										  uint32_t capacity)
+	{
+		_vk = vk;
+		_device = device;
+
+		const VkDescriptorSetLayoutBinding binding{0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, capacity,
+												   VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, nullptr};
+		const VkDescriptorBindingFlags bindingFlags =
+			VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT;
+		_layout = layouts.Get(rv::Span<const VkDescriptorSetLayoutBinding>(&binding, 1), &bindingFlags,
+							  VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT);
+		if (!_layout) return false;
+
+		const VkDescriptorPoolSize size{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, capacity};
+		VkDescriptorPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+		poolInfo.maxSets = 1;
+		poolInfo.poolSizeCount = 1;
+		poolInfo.pPoolSizes = &size;
+		if (!check(_vk->vkCreateDescriptorPool(_device, &poolInfo, nullptr, &_pool), "vkCreateDescriptorPool"))
+		{
+			return false;
+		}
+
+		VkDescriptorSetAllocateInfo allocateInfo{};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocateInfo.descriptorPool = _pool;
+		allocateInfo.descriptorSetCount = 1;
+		allocateInfo.pSetLayouts = &_layout;
+		if (!check(_vk->vkAllocateDescriptorSets(_device, &allocateInfo, &_set), "vkAllocateDescriptorSets"))
+		{
+			Shutdown();
+			return false;
+		}
+		_capacity = capacity;
+		return true;
+	}
+
+	void BindlessTextureTable::Shutdown()
+	{
+		if (_pool) _vk->vkDestroyDescriptorPool(_device, _pool, nullptr);
+		_pool = VK_NULL_HANDLE;
+		_layout = VK_NULL_HANDLE;
+		_set = VK_NULL_HANDLE;
+		_free.clear();
+		_next = 0;
+		_capacity = 0;
+		_count = 0;
+	}
+
+	uint32_t BindlessTextureTable::Add(VkSampler sampler, VkImageView view)
+	{
+		uint32_t index;
+		if (!_free.empty())
+		{
+			index = _free.back();
+			_free.pop_back();
+		}
+		else if (_next < _capacity)
+		{
+			index = _next++;
+		}
+		else
+		{
+			return InvalidIndex;
+		}
+
+		const VkDescriptorImageInfo info{sampler, view, VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL};
+		VkWriteDescriptorSet write{};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = _set;
+		write.dstBinding = 0;
+		write.dstArrayElement = index;
+		write.descriptorCount = 1;
+		write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		write.pImageInfo = &info;
+		_vk->vkUpdateDescriptorSets(_device, 1, &write, 0, nullptr);
+		_count++;
+		return index;
+	}
+
+	void BindlessTextureTable::Remove(uint32_t index)
+	{
+		if (index >= _next) return;
+		// The slot keeps pointing at the destroyed view until reused, partially bound allows it as long as
+		// no shader reads it
+		_free.push_back(index);
+		_count--;
+	}
+
+} // namespace gefx
@@ -0,0 +1,203 @@
+#ifndef __VKDESCRIPTORS__H__
+#define __VKDESCRIPTORS__H__
+
+#include <cstdint>
+#include <vector>
+
+#include <vulkan/vulkan_core.h>
+
+#include <core/containers/flathashmap.h>
+#include <core/span.h>
+#include <rendering/device/vkfunctions.h>
+
+namespace gefx
+{
+	struct DescriptorStats
+	{
+		// Sets allocated and written
+		uint32_t allocated{0};
+		// Sets asked for again with the same resources, answered by the set cache
+		uint32_t reused{0};
+		uint32_t poolsCreated{0};
+		// Pools held, reset together with their frame slot
+		uint32_t pools{0};
+		// Textures with a slot in the bindless set
+		uint32_t bindlessTextures{0};
+	};
+
+	/**
+	 * @brief Descriptor set layouts by binding description: equal descriptions share one layout, destroyed
+	 * on Shutdown. Not thread safe, layouts are made up front.
+	 */
+	class DescriptorLayoutCache
+	{
+	  public:
+		DescriptorLayoutCache() = default;
+		~DescriptorLayoutCache() = default;
+
+		DescriptorLayoutCache(DescriptorLayoutCache&&) = delete;
+		DescriptorLayoutCache(const DescriptorLayoutCache&) = delete;
+		DescriptorLayoutCache& operator=(DescriptorLayoutCache&&) = delete;
+		DescriptorLayoutCache& operator=(const DescriptorLayoutCache&) = delete;
+
+		void Initialize(const VulkanFunctions* vk, VkDevice device);
+		void Shutdown();
+
+		/**
+		 * @brief Layout of the bindings, created on first request. bindingFlags is null or holds one
+		 * VkDescriptorBindingFlags per binding. Null when creation fails.
+		 */
+		VkDescriptorSetLayout Get(rv::Span<const VkDescriptorSetLayoutBinding> bindings,
+								  const VkDescriptorBindingFlags* bindingFlags = nullptr,
+								  VkDescriptorSetLayoutCreateFlags flags = 0);
+
+		uint32_t GetCount() const { return static_cast<uint32_t>(_layouts.size()); };
+
+	  private:
+		// The whole description, bindingFlags empty when none were given
+		struct LayoutKey
+		{
+			std::vector<VkDescriptorSetLayoutBinding> bindings;
+			std::vector<VkDescriptorBindingFlags> bindingFlags;
+			VkDescriptorSetLayoutCreateFlags flags;
+
+			bool operator==(const LayoutKey& other) const;
+		};
+
+		struct LayoutKeyHash
+		{
+			uint64_t operator()(const LayoutKey& key) const;
+		};
+
+		const VulkanFunctions* _vk{nullptr};
+		VkDevice _device{VK_NULL_HANDLE};
+		rv::FlatHashMap<LayoutKey, VkDescriptorSetLayout, LayoutKeyHash> _layouts;
+	};
+
+	/**
+	 * @brief Descriptor sets of one recording thread in one frame slot.
+	 *
+	 * Sets come from pools grown on demand and reset all at once when the frame slot comes around again, no
+	 * set is ever freed on its own. Sets are cached by layout and the resources they point at, so asking for
+	 * the same resources again within the frame returns the set already written. One per thread, not thread
+	 * safe.
+	 */
+	class DescriptorAllocator
+	{
+	  public:
+		static constexpr uint32_t SetsPerPool = 256;
+		static constexpr uint32_t MaxBindings = 8;
+
+		/**
+		 * @brief setSizes are the descriptors of each type a set may need, pools hold SetsPerPool times them.
+		 */
+		void Initialize(const VulkanFunctions* vk, VkDevice device, rv::Span<const VkDescriptorPoolSize> setSizes);
+		void Shutdown();
+
+		/**
+		 * @brief Free every set at once, the GPU must be done with them.
+		 */
+		void Reset();
+
+		/**
+		 * @brief Set of layout with binding i pointing at infos[i], one descriptor of type each. Null when
+		 * allocation fails.
+		 */
+		VkDescriptorSet GetSet(VkDescriptorSetLayout layout, VkDescriptorType type,
+							   const VkDescriptorBufferInfo* infos, uint32_t count);
+		VkDescriptorSet GetSet(VkDescriptorSetLayout layout, VkDescriptorType type, const VkDescriptorImageInfo* infos,
+							   uint32_t count);
+
+		/**
+		 * @brief Totals since the last Reset.
+		 */
+		const DescriptorStats& GetStats() const { return _stats; };
+
+	  private:
+		// Binding i is entries[i]: buffer, offset and range, or sampler, view and layout
+		struct SetKey
+		{
+			VkDescriptorSetLayout layout;
+			uint32_t count;
+			uint64_t entries[MaxBindings][3];
+
+			bool operator==(const SetKey& other) const;
+		};
+
+		struct SetKeyHash
+		{
+			uint64_t operator()(const SetKey& key) const;
+		};
+
+		// Cached set of key, or a new one written by writes (dstSet filled in here)
+		VkDescriptorSet GetSet(const SetKey& key, VkWriteDescriptorSet* writes);
+		VkDescriptorSet Allocate(VkDescriptorSetLayout layout);
+
+		const VulkanFunctions* _vk{nullptr};
+		VkDevice _device{VK_NULL_HANDLE};
+		std::vector<VkDescriptorPoolSize> _poolSizes;
+		std::vector<VkDescriptorPool> _pools;
+		// Pool allocations come from, the ones before it are full
+		uint32_t _pool{0};
+		rv::FlatHashMap<SetKey, VkDescriptorSet, SetKeyHash> _sets;
+		DescriptorStats _stats;
+	};
+
+	/**
+	 * @brief One descriptor set holding an array of combined image samplers, a slot per texture, for shaders
+	 * indexing textures by number (descriptor indexing). The set is update after bind and partially bound:
+	 * slots are written as textures are created while command buffers using the set are pending, and slots
+	 * nothing reads need not be valid. Not thread safe.
+	 */
+	class BindlessTextureTable
+	{
+	  public:
+		static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+		BindlessTextureTable() = default;
+		~BindlessTextureTable() = default;
+
+		BindlessTextureTable(BindlessTextureTable&&) = delete;
+		BindlessTextureTable(const BindlessTextureTable&) = delete;
+		BindlessTextureTable& operator=(BindlessTextureTable&&) = delete;
+		BindlessTextureTable& operator=(const BindlessTextureTable&) = delete;
+
+		/**
+		 * @brief Needs descriptorBindingPartiallyBound and descriptorBindingSampledImageUpdateAfterBind. The
+		 * layout comes from, and belongs to, layouts.
+		 */
+		bool Initialize(const VulkanFunctions* vk, VkDevice device, DescriptorLayoutCache& layouts, uint32_t capacity);
+		void Shutdown();
+
+		/**
+		 * @brief Write a texture to a free slot and return it, InvalidIndex when the table is full.
+		 */
+		uint32_t Add(VkSampler sampler, VkImageView view);
+
+		/**
+		 * @brief Give a slot back, once the GPU is done with every command that may read it.
+		 */
+		void Remove(uint32_t index);
+
+		bool IsEnabled() const { return _set != VK_NULL_HANDLE; };
+		VkDescriptorSetLayout GetLayout() const { return _layout; };
+		VkDescriptorSet GetSet() const { return _set; };
+		uint32_t GetCount() const { return _count; };
+		uint32_t GetCapacity() const { return _capacity; };
+
+	  private:
+		const VulkanFunctions* _vk{nullptr};
+		VkDevice _device{VK_NULL_HANDLE};
+		VkDescriptorPool _pool{VK_NULL_HANDLE};
+		VkDescriptorSetLayout _layout{VK_NULL_HANDLE};
+		VkDescriptorSet _set{VK_NULL_HANDLE};
+		std::vector<uint32_t> _free;
+		// Slots below it have been handed out at least once
+		uint32_t _next{0};
+		uint32_t _capacity{0};
+		uint32_t _count{0};
+	};
+
+} // namespace gefx
+
+#endif //!__VKDESCRIPTORS__H__
@@ -0,0 +1,2402 @@
+// StdLib Includes
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+// Application Specific Includes
+#include <core/jobs.h>
+#include <core/log.h>
+#include <rendering/device/commandlist.h>
+#include <rendering/device/vkdevice.h>
+
+namespace gefx
+{
+	namespace
+	{
+		template <typename T>
+		const T& as(const void* payload)
+		{
+			return *static_cast<const T*>(payload);
+		}
+
+		// Visit the commands stored between two byte offsets of a list
+		template <typename F>
+		void forEachCommand(const CommandList& list, uint32_t begin, uint32_t end, F&& fn)
+		{
+			const uint8_t* data = list.GetData().data();
+			while (begin < end)
+			{
+				const CommandHeader& header = *reinterpret_cast<const CommandHeader*>(data + begin);
+				fn(header, data + begin + sizeof(CommandHeader));
+				begin += header.size;
+			}
+		}
+
+		bool check(VkResult result, const char* what)
+		{
+			if (result == VK_SUCCESS) return true;
+			GEFX_LOG_ERROR("[Vulkan] {} failed: {}", what, static_cast<int>(result));
+			return false;
+		}
+
+		VkFormat getVkFormat(Format format, VkFormat depthStencil)
+		{
+			switch (format)
+			{
+			case Format::R8Unorm:
+				return VK_FORMAT_R8_UNORM;
+			case Format::RG8Unorm:
+				return VK_FORMAT_R8G8_UNORM;
+			case Format::RGBA8Unorm:
+				return VK_FORMAT_R8G8B8A8_UNORM;
+			case Format::RGBA8Srgb:
+				return VK_FORMAT_R8G8B8A8_SRGB;
+			case Format::BGRA8Unorm:
+				return VK_FORMAT_B8G8R8A8_UNORM;
+			case Format::R16Float:
+				return VK_FORMAT_R16_SFLOAT;
+			case Format::RGBA16Float:
+				return VK_FORMAT_R16G16B16A16_SFLOAT;
+			case Format::R32Float:
+				return VK_FORMAT_R32_SFLOAT;
+			case Format::RG32Float:
+				return VK_FORMAT_R32G32_SFLOAT;
+			case Format::RGB32Float:
+				return VK_FORMAT_R32G32B32_SFLOAT;
+			case Format::RGBA32Float:
+				return VK_FORMAT_R32G32B32A32_SFLOAT;
+			case Format::Depth32Float:
+				return VK_FORMAT_D32_SFLOAT;
+			case Format::Depth24Stencil8:
+				// D24S8 is optional, the device falls back to D32S8
+				return depthStencil;
+			default:
+				return VK_FORMAT_UNDEFINED;
+			}
+		}
+
+		VkPrimitiveTopology getTopology(PrimitiveTopology topology)
+		{
+			switch (topology)
+			{
+			case PrimitiveTopology::TriangleStrip:
+				return VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+			case PrimitiveTopology::Lines:
+				return VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+			case PrimitiveTopology::Points:
+				return VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+			default:
+				return VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+			}
+		}
+
+		VkCullModeFlags getCullMode(CullMode mode)
+		{
+			switch (mode)
+			{
+			case CullMode::Back:
+				return VK_CULL_MODE_BACK_BIT;
+			case CullMode::Front:
+				return VK_CULL_MODE_FRONT_BIT;
+			default:
+				return VK_CULL_MODE_NONE;
+			}
+		}
+
+		bool hasExtension(const std::vector<VkExtensionProperties>& extensions, const char* name)
+		{
+			return std::any_of(extensions.begin(), extensions.end(), [&](const VkExtensionProperties& extension) {
+				return std::strcmp(extension.extensionName, name) == 0;
+			});
+		}
+
+		// Shared by the graphics and transfer families when they differ, instead of transferring ownership
+		template <typename CreateInfo>
+		void setSharing(CreateInfo& info, const uint32_t (&families)[2])
+		{
+			info.sharingMode = families[0] != families[1] ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
+			info.queueFamilyIndexCount = families[0] != families[1] ? 2 : 0;
+			info.pQueueFamilyIndices = families;
+		}
+
+		VKAPI_ATTR VkBool32 VKAPI_CALL debugMessage(VkDebugUtilsMessageSeverityFlagBitsEXT severity,
+													VkDebugUtilsMessageTypeFlagsEXT /*types*/,
+													const VkDebugUtilsMessengerCallbackDataEXT* data,
+													void* /*userData*/)
+		{
+			if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT)
+			{
+				GEFX_LOG_ERROR("[Vulkan] {}", data->pMessage);
+			}
+			else if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT)
+			{
+				GEFX_LOG_WARNING("[Vulkan] {}", data->pMessage);
+			}
+			else
+			{
+				GEFX_LOG_INFO("[Vulkan] {}", data->pMessage);
+			}
+			return VK_FALSE;
+		}
+
+		constexpr VkAccessFlags2 WriteAccess = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT |
+											   VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+											   VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_SHADER_WRITE_BIT |
+											   VK_ACCESS_2_MEMORY_WRITE_BIT;
+		constexpr VkPipelineStageFlags2 ShaderStages =
+			VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+		constexpr VkPipelineStageFlags2 DepthStages =
+			VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
+		// Everything a draw reads from buffers, what buffer writes have to be visible to
+		constexpr VkPipelineStageFlags2 BufferReadStages =
+			VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT | ShaderStages | VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT;
+		constexpr VkAccessFlags2 BufferReadAccess = VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT |
+													VK_ACCESS_2_INDEX_READ_BIT | VK_ACCESS_2_UNIFORM_READ_BIT |
+													VK_ACCESS_2_TRANSFER_READ_BIT;
+	} // namespace
+
+	bool VulkanDevice::Initialize(const VulkanDeviceConfig& config)
+	{
+		auto fail = [this]() {
+			Shutdown();
+			return false;
+		};
+
+		_jobs = config.jobs;
+		_bindless = config.bindless;
+		_vsync = config.vsync;
+		_backBufferWidth = config.backBufferWidth;
+		_backBufferHeight = config.backBufferHeight;
+		if (!_vk.Load())
+		{
+			GEFX_LOG_ERROR("[Vulkan] No Vulkan loader found");
+			return false;
+		}
+		if (!CreateInstance(config)) return fail();
+		if (config.createSurface)
+		{
+			_surface = config.createSurface(_instance, _vk.vkGetInstanceProcAddr);
+			if (!_surface)
+			{
+				GEFX_LOG_ERROR("[Vulkan] Failed to create the window surface");
+				return fail();
+			}
+		}
+		if (!CreateDevice()) return fail();
+
+		VkSemaphoreTypeCreateInfo timelineInfo{};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		timelineInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		VkSemaphoreCreateInfo semaphoreInfo{};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		semaphoreInfo.pNext = &timelineInfo;
+		if (!check(_vk.vkCreateSemaphore(_device, &semaphoreInfo, nullptr, &_timeline), "vkCreateSemaphore") ||
+			!check(_vk.vkCreateSemaphore(_device, &semaphoreInfo, nullptr, &_uploadTimeline), "vkCreateSemaphore"))
+		{
+			return fail();
+		}
+
+		// Upload command buffers are recycled one by one as their batches complete
+		VkCommandPoolCreateInfo transferPoolInfo{};
+		transferPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		transferPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		transferPoolInfo.queueFamilyIndex = _transferFamily;
+		if (!check(_vk.vkCreateCommandPool(_device, &transferPoolInfo, nullptr, &_transferPool),
+				   "vkCreateCommandPool") ||
+			!CreateRawBuffer(config.uploadRingBytes, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, MemoryUsage::Upload,
+							 _uploadStaging))
+		{
+			return fail();
+		}
+		_uploadRing = UploadRing(config.uploadRingBytes);
+
+		// Secondaries are recorded by whichever thread runs a list's job: the workers, the thread calling Submit
+		// and any other thread helping with jobs meanwhile, each in the slot of its job system thread index
+		const uint32_t threadCount = _jobs ? _jobs->GetThreadCount() : 1;
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		poolInfo.queueFamilyIndex = _queueFamily;
+		VkSemaphoreCreateInfo binaryInfo{};
+		binaryInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		const VkDescriptorPoolSize setSizes[] = {
+			{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, MaxUniformBufferSlots},
+			{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MaxTextureSlots},
+		};
+		for (Frame& frame : _frames)
+		{
+			if (!check(_vk.vkCreateCommandPool(_device, &poolInfo, nullptr, &frame.commandPool), "vkCreateCommandPool"))
+			{
+				return fail();
+			}
+			frame.threads.resize(threadCount);
+			for (ThreadContext& thread : frame.threads)
+			{
+				if (!check(_vk.vkCreateCommandPool(_device, &poolInfo, nullptr, &thread.commandPool),
+						   "vkCreateCommandPool"))
+				{
+					return fail();
+				}
+				thread.descriptors.Initialize(&_vk, _device, setSizes);
+			}
+			if (_surface && !check(_vk.vkCreateSemaphore(_device, &binaryInfo, nullptr, &frame.imageAcquired),
+								   "vkCreateSemaphore"))
+			{
+				return fail();
+			}
+			if (!CreateRawBuffer(StagingBytes, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, MemoryUsage::Upload, frame.staging))
+			{
+				return fail();
+			}
+			frame.stagingAllocator = LinearAllocator(StagingBytes);
+		}
+
+		// Set 0 holds the uniform buffer slots, set 1 the texture slots and set 2 the bindless textures when
+		// there are some, push constants are shared by stages
+		_descriptorLayouts.Initialize(&_vk, _device);
+		VkDescriptorSetLayoutBinding bindings[MaxUniformBufferSlots > MaxTextureSlots ? MaxUniformBufferSlots
+																						 : MaxTextureSlots];
+		const VkShaderStageFlags stages = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+		for (uint32_t i = 0; i < MaxUniformBufferSlots; i++)
+		{
+			bindings[i] = VkDescriptorSetLayoutBinding{i, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, stages, nullptr};
+		}
+		_uniformLayout =
+			_descriptorLayouts.Get(rv::Span<const VkDescriptorSetLayoutBinding>(bindings, MaxUniformBufferSlots));
+		for (uint32_t i = 0; i < MaxTextureSlots; i++)
+		{
+			bindings[i] =
+				VkDescriptorSetLayoutBinding{i, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, stages, nullptr};
+		}
+		_textureLayout =
+			_descriptorLayouts.Get(rv::Span<const VkDescriptorSetLayoutBinding>(bindings, MaxTextureSlots));
+		if (!_uniformLayout || !_textureLayout) return fail();
+		if (_bindless && !_bindlessTextures.Initialize(&_vk, _device, _descriptorLayouts, BindlessTextureCapacity))
+		{
+			GEFX_LOG_WARNING("[Vulkan] Bindless textures unavailable, continuing without them");
+			_bindless = false;
+		}
+
+		const VkDescriptorSetLayout setLayouts[] = {_uniformLayout, _textureLayout, _bindlessTextures.GetLayout()};
+		const VkPushConstantRange pushRange{VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0,
+											MaxPushConstantBytes};
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = _bindless ? 3 : 2;
+		pipelineLayoutInfo.pSetLayouts = setLayouts;
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushRange;
+		if (!check(_vk.vkCreatePipelineLayout(_device, &pipelineLayoutInfo, nullptr, &_pipelineLayout),
+				   "vkCreatePipelineLayout"))
+		{
+			return fail();
+		}
+
+		// Seeded with last session's cache when the same driver wrote it, then its pipelines compile in the
+		// background ahead of CreatePipeline asking for them
+		_pipelineCachePath = config.pipelineCachePath;
+		if (!_pipelineCachePath.empty())
+		{
+			VkPhysicalDeviceProperties properties;
+			_vk.vkGetPhysicalDeviceProperties(_physicalDevice, &properties);
+			_precompileFile.Read(_pipelineCachePath, properties);
+		}
+		VkPipelineCacheCreateInfo cacheInfo{};
+		cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		cacheInfo.initialDataSize = _precompileFile.GetData().size();
+		cacheInfo.pInitialData = _precompileFile.GetData().data();
+		if (!check(_vk.vkCreatePipelineCache(_device, &cacheInfo, nullptr, &_pipelineCache), "vkCreatePipelineCache"))
+		{
+			return fail();
+		}
+		PrecompilePipelines();
+
+		// Same sampling as the GL backend's
+		VkSamplerCreateInfo samplerInfo{};
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter = VK_FILTER_LINEAR;
+		samplerInfo.minFilter = VK_FILTER_LINEAR;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+		if (!check(_vk.vkCreateSampler(_device, &samplerInfo, nullptr, &_sampler), "vkCreateSampler")) return fail();
+
+		_dummyBuffer = CreateBuffer(BufferDesc{256, BufferUsage::Uniform, true});
+		_dummyTexture = CreateTexture(TextureDesc{1, 1, 1, Format::RGBA8Unorm, TextureUsage::Sampled});
+		Texture* dummy = _textures.Get(_dummyTexture);
+		if (_dummyBuffer.IsNull() || !dummy) return fail();
+		if (dummy->layout != VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL)
+		{
+			Transition(*dummy, VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL, ShaderStages, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+					   true, _barriers);
+			FlushBarriers(GetUploadCommands(), _barriers);
+		}
+
+		if (!(_surface ? CreateSwapchain() : CreateOffscreenBackBuffer())) return fail();
+		return true;
+	}
+
+	bool VulkanDevice::CreateInstance(const VulkanDeviceConfig& config)
+	{
+		uint32_t version = VK_API_VERSION_1_0;
+		if (_vk.vkEnumerateInstanceVersion) _vk.vkEnumerateInstanceVersion(&version);
+		if (version < VK_API_VERSION_1_3)
+		{
+			GEFX_LOG_ERROR("[Vulkan] The loader only supports Vulkan {}.{}", VK_API_VERSION_MAJOR(version),
+						   VK_API_VERSION_MINOR(version));
+			return false;
+		}
+
+		std::vector<const char*> extensions = config.instanceExtensions;
+		std::vector<const char*> layers;
+		bool debugUtils = false;
+		if (config.validation)
+		{
+			uint32_t count = 0;
+			_vk.vkEnumerateInstanceLayerProperties(&count, nullptr);
+			std::vector<VkLayerProperties> available(count);
+			_vk.vkEnumerateInstanceLayerProperties(&count, available.data());
+			const char* validationLayer = "VK_LAYER_KHRONOS_validation";
+			if (std::any_of(available.begin(), available.end(), [&](const VkLayerProperties& layer) {
+					return std::strcmp(layer.layerName, validationLayer) == 0;
+				}))
+			{
+				layers.push_back(validationLayer);
+			}
+			else
+			{
+				GEFX_LOG_WARNING("[Vulkan] Validation requested but {} isn't installed", validationLayer);
+			}
+
+			_vk.vkEnumerateInstanceExtensionProperties(nullptr, &count, nullptr);
+			std::vector<VkExtensionProperties> instanceExtensions(count);
+			_vk.vkEnumerateInstanceExtensionProperties(nullptr, &count, instanceExtensions.data());
+			debugUtils = hasExtension(instanceExtensions, VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+			if (debugUtils) extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+		}
+
+		VkApplicationInfo appInfo{};
+		appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+		appInfo.pApplicationName = "GrefixsEngine";
+		appInfo.pEngineName = "GrefixsEngine";
+		appInfo.apiVersion = VK_API_VERSION_1_3;
+		VkInstanceCreateInfo instanceInfo{};
+		instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+		instanceInfo.pApplicationInfo = &appInfo;
+		instanceInfo.enabledLayerCount = static_cast<uint32_t>(layers.size());
+		instanceInfo.ppEnabledLayerNames = layers.data();
+		instanceInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+		instanceInfo.ppEnabledExtensionNames = extensions.data();
+		if (!check(_vk.vkCreateInstance(&instanceInfo, nullptr, &_instance), "vkCreateInstance")) return false;
+		_vk.LoadInstance(_instance);
+
+		if (debugUtils && _vk.vkCreateDebugUtilsMessengerEXT)
+		{
+			VkDebugUtilsMessengerCreateInfoEXT messengerInfo{};
+			messengerInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
+			messengerInfo.messageSeverity =
+				VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+			messengerInfo.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT |
+										VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT |
+										VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
+			messengerInfo.pfnUserCallback = debugMessage;
+			_vk.vkCreateDebugUtilsMessengerEXT(_instance, &messengerInfo, nullptr, &_messenger);
+		}
+		return true;
+	}
+
+	bool VulkanDevice::CreateDevice()
+	{
+		uint32_t count = 0;
+		_vk.vkEnumeratePhysicalDevices(_instance, &count, nullptr);
+		std::vector<VkPhysicalDevice> physicalDevices(count);
+		_vk.vkEnumeratePhysicalDevices(_instance, &count, physicalDevices.data());
+
+		// First discrete GPU with everything we need, then integrated, then anything else
+		int bestScore = -1;
+		for (VkPhysicalDevice physicalDevice : physicalDevices)
+		{
+			VkPhysicalDeviceProperties properties;
+			_vk.vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+			if (properties.apiVersion < VK_API_VERSION_1_3) continue;
+
+			VkPhysicalDeviceVulkan13Features features13{};
+			features13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+			VkPhysicalDeviceVulkan12Features features12{};
+			features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+			features12.pNext = &features13;
+			VkPhysicalDeviceFeatures2 features{};
+			features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			features.pNext = &features12;
+			_vk.vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+			if (!features12.timelineSemaphore || !features13.dynamicRendering || !features13.synchronization2) continue;
+
+			if (_surface)
+			{
+				_vk.vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &count, nullptr);
+				std::vector<VkExtensionProperties> extensions(count);
+				_vk.vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &count, extensions.data());
+				if (!hasExtension(extensions, VK_KHR_SWAPCHAIN_EXTENSION_NAME)) continue;
+			}
+
+			_vk.vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &count, nullptr);
+			std::vector<VkQueueFamilyProperties> families(count);
+			_vk.vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &count, families.data());
+			uint32_t family = count;
+			for (uint32_t i = 0; i < count && family == count; i++)
+			{
+				VkBool32 present = VK_TRUE;
+				if (_surface) _vk.vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, _surface, &present);
+				if ((families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) && present) family = i;
+			}
+			if (family == count) continue;
+
+			const int score = properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU	  ? 2
+							  : properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU ? 1
+																								: 0;
+			if (score > bestScore)
+			{
+				bestScore = score;
+				_physicalDevice = physicalDevice;
+				_queueFamily = family;
+			}
+		}
+		if (!_physicalDevice)
+		{
+			GEFX_LOG_ERROR("[Vulkan] No device supports Vulkan 1.3 with dynamic rendering and synchronization2");
+			return false;
+		}
+
+		VkPhysicalDeviceProperties properties;
+		_vk.vkGetPhysicalDeviceProperties(_physicalDevice, &properties);
+		_vk.vkGetPhysicalDeviceMemoryProperties(_physicalDevice, &_memoryProperties);
+		GEFX_LOG_INFO("[Vulkan] Using {}", properties.deviceName);
+
+		VkFormatProperties formatProperties;
+		_vk.vkGetPhysicalDeviceFormatProperties(_physicalDevice, VK_FORMAT_D24_UNORM_S8_UINT, &formatProperties);
+		_depthStencilFormat =
+			(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT)
+				? VK_FORMAT_D24_UNORM_S8_UINT
+				: VK_FORMAT_D32_SFLOAT_S8_UINT;
+
+		// Uploads take a transfer only family (the copy engines of discrete GPUs) whose copies have no
+		// granularity restrictions, else a second queue of the graphics family, else the graphics queue
+		_vk.vkGetPhysicalDeviceQueueFamilyProperties(_physicalDevice, &count, nullptr);
+		std::vector<VkQueueFamilyProperties> families(count);
+		_vk.vkGetPhysicalDeviceQueueFamilyProperties(_physicalDevice, &count, families.data());
+		_transferFamily = _queueFamily;
+		uint32_t transferIndex = families[_queueFamily].queueCount > 1 ? 1 : 0;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const VkExtent3D& granularity = families[i].minImageTransferGranularity;
+			if ((families[i].queueFlags & VK_QUEUE_TRANSFER_BIT) &&
+				!(families[i].queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) &&
+				granularity.width == 1 && granularity.height == 1 && granularity.depth == 1)
+			{
+				_transferFamily = i;
+				transferIndex = 0;
+				break;
+			}
+		}
+		_queueFamilies[0] = _queueFamily;
+		_queueFamilies[1] = _transferFamily;
+
+		const float priorities[2] = {1.0f, 1.0f};
+		VkDeviceQueueCreateInfo queueInfos[2]{};
+		queueInfos[0].sType = queueInfos[1].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+		queueInfos[0].queueFamilyIndex = _queueFamily;
+		queueInfos[0].queueCount = _transferFamily == _queueFamily ? transferIndex + 1 : 1;
+		queueInfos[0].pQueuePriorities = priorities;
+		queueInfos[1].queueFamilyIndex = _transferFamily;
+		queueInfos[1].queueCount = 1;
+		queueInfos[1].pQueuePriorities = priorities;
+
+		VkPhysicalDeviceVulkan13Features features13{};
+		features13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+		features13.dynamicRendering = VK_TRUE;
+		features13.synchronization2 = VK_TRUE;
+		VkPhysicalDeviceVulkan12Features features12{};
+		features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		features12.pNext = &features13;
+		features12.timelineSemaphore = VK_TRUE;
+
+		// Bindless textures: a partially bound, update after bind array indexed freely by shaders
+		VkPhysicalDeviceVulkan12Features supported12{};
+		supported12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		VkPhysicalDeviceFeatures2 supported{};
+		supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		supported.pNext = &supported12;
+		_vk.vkGetPhysicalDeviceFeatures2(_physicalDevice, &supported);
+		_bindless = _bindless && supported12.runtimeDescriptorArray && supported12.descriptorBindingPartiallyBound &&
+					supported12.descriptorBindingSampledImageUpdateAfterBind &&
+					supported12.shaderSampledImageArrayNonUniformIndexing;
+		if (_bindless)
+		{
+			features12.runtimeDescriptorArray = VK_TRUE;
+			features12.descriptorBindingPartiallyBound = VK_TRUE;
+			features12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+			features12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+		}
+
+		_vk.vkEnumerateDeviceExtensionProperties(_physicalDevice, nullptr, &count, nullptr);
+		std::vector<VkExtensionProperties> available(count);
+		_vk.vkEnumerateDeviceExtensionProperties(_physicalDevice, nullptr, &count, available.data());
+		std::vector<const char*> extensions;
+		if (_surface) extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+		_memoryBudget = hasExtension(available, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+		if (_memoryBudget) extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+		VkDeviceCreateInfo deviceInfo{};
+		deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+		deviceInfo.pNext = &features12;
+		deviceInfo.queueCreateInfoCount = _transferFamily == _queueFamily ? 1 : 2;
+		deviceInfo.pQueueCreateInfos = queueInfos;
+		deviceInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+		deviceInfo.ppEnabledExtensionNames = extensions.data();
+		if (!check(_vk.vkCreateDevice(_physicalDevice, &deviceInfo, nullptr, &_device), "vkCreateDevice")) return false;
+
+		_vk.LoadDevice(_device);
+		_vk.vkGetDeviceQueue(_device, _queueFamily, 0, &_queue);
+		_vk.vkGetDeviceQueue(_device, _transferFamily, transferIndex, &_transferQueue);
+		if (_transferFamily != _queueFamily)
+		{
+			GEFX_LOG_INFO("[Vulkan] Uploads on transfer queue family {}", _transferFamily);
+		}
+
+		_memory.Initialize(this, _memoryProperties, properties.limits.bufferImageGranularity);
+		UpdateMemoryBudget();
+		return true;
+	}
+
+	bool VulkanDevice::CreateSwapchain()
+	{
+		VkSurfaceCapabilitiesKHR capabilities;
+		_vk.vkGetPhysicalDeviceSurfaceCapabilitiesKHR(_physicalDevice, _surface, &capabilities);
+		VkExtent2D extent = capabilities.currentExtent;
+		if (extent.width == UINT32_MAX)
+		{
+			// The window system lets the swapchain decide, go with the size we were given
+			extent.width = std::clamp(_backBufferWidth, capabilities.minImageExtent.width,
+									  capabilities.maxImageExtent.width);
+			extent.height = std::clamp(_backBufferHeight, capabilities.minImageExtent.height,
+									   capabilities.maxImageExtent.height);
+		}
+		// Minimized, try again next frame
+		if (extent.width == 0 || extent.height == 0) return false;
+
+		uint32_t count = 0;
+		_vk.vkGetPhysicalDeviceSurfaceFormatsKHR(_physicalDevice, _surface, &count, nullptr);
+		std::vector<VkSurfaceFormatKHR> formats(count);
+		_vk.vkGetPhysicalDeviceSurfaceFormatsKHR(_physicalDevice, _surface, &count, formats.data());
+		// Shaders write display values like they do on GL's default framebuffer, so no sRGB encoding
+		const VkFormat preferred[] = {VK_FORMAT_B8G8R8A8_UNORM, VK_FORMAT_R8G8B8A8_UNORM};
+		VkSurfaceFormatKHR surfaceFormat{VK_FORMAT_UNDEFINED, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR};
+		for (VkFormat format : preferred)
+		{
+			for (const VkSurfaceFormatKHR& candidate : formats)
+			{
+				if (candidate.format != format || surfaceFormat.format != VK_FORMAT_UNDEFINED) continue;
+				surfaceFormat = candidate;
+			}
+		}
+		if (surfaceFormat.format == VK_FORMAT_UNDEFINED)
+		{
+			GEFX_LOG_ERROR("[Vulkan] The surface has no 8 bit unorm format");
+			return false;
+		}
+		_backBufferFormat =
+			surfaceFormat.format == VK_FORMAT_B8G8R8A8_UNORM ? Format::BGRA8Unorm : Format::RGBA8Unorm;
+
+		_vk.vkGetPhysicalDeviceSurfacePresentModesKHR(_physicalDevice, _surface, &count, nullptr);
+		std::vector<VkPresentModeKHR> presentModes(count);
+		_vk.vkGetPhysicalDeviceSurfacePresentModesKHR(_physicalDevice, _surface, &count, presentModes.data());
+		VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
+		if (!_vsync)
+		{
+			for (VkPresentModeKHR mode : {VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR})
+			{
+				if (std::find(presentModes.begin(), presentModes.end(), mode) != presentModes.end()) presentMode = mode;
+			}
+		}
+
+		uint32_t imageCount = capabilities.minImageCount + 1;
+		if (capabilities.maxImageCount > 0) imageCount = std::min(imageCount, capabilities.maxImageCount);
+
+		VkSwapchainCreateInfoKHR swapchainInfo{};
+		swapchainInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+		swapchainInfo.surface = _surface;
+		swapchainInfo.minImageCount = imageCount;
+		swapchainInfo.imageFormat = surfaceFormat.format;
+		swapchainInfo.imageColorSpace = surfaceFormat.colorSpace;
+		swapchainInfo.imageExtent = extent;
+		swapchainInfo.imageArrayLayers = 1;
+		swapchainInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+								   (capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+		swapchainInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		swapchainInfo.preTransform = capabilities.currentTransform;
+		swapchainInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+		swapchainInfo.presentMode = presentMode;
+		swapchainInfo.clipped = VK_TRUE;
+		swapchainInfo.oldSwapchain = _swapchain;
+		VkSwapchainKHR swapchain;
+		if (!check(_vk.vkCreateSwapchainKHR(_device, &swapchainInfo, nullptr, &swapchain), "vkCreateSwapchainKHR"))
+		{
+			return false;
+		}
+		DestroySwapchain();
+		_swapchain = swapchain;
+		_backBufferWidth = extent.width;
+		_backBufferHeight = extent.height;
+
+		_vk.vkGetSwapchainImagesKHR(_device, _swapchain, &count, nullptr);
+		std::vector<VkImage> images(count);
+		_vk.vkGetSwapchainImagesKHR(_device, _swapchain, &count, images.data());
+		VkSemaphoreCreateInfo semaphoreInfo{};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		for (VkImage image : images)
+		{
+			VkImageViewCreateInfo viewInfo{};
+			viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			viewInfo.image = image;
+			viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			viewInfo.format = surfaceFormat.format;
+			viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+			VkImageView view = VK_NULL_HANDLE;
+			check(_vk.vkCreateImageView(_device, &viewInfo, nullptr, &view), "vkCreateImageView");
+			_swapchainImages.push_back(_textures.Create(Texture{image, view, {}, surfaceFormat.format,
+																VK_IMAGE_ASPECT_COLOR_BIT, extent.width, extent.height,
+																4, false, VK_IMAGE_LAYOUT_UNDEFINED,
+																VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE}));
+		}
+		while (_renderFinished.size() < images.size())
+		{
+			VkSemaphore semaphore = VK_NULL_HANDLE;
+			check(_vk.vkCreateSemaphore(_device, &semaphoreInfo, nullptr, &semaphore), "vkCreateSemaphore");
+			_renderFinished.push_back(semaphore);
+		}
+		return true;
+	}
+
+	void VulkanDevice::DestroySwapchain()
+	{
+		// Only called with the device idle
+		for (TextureHandle handle : _swapchainImages)
+		{
+			Texture texture;
+			if (_textures.Release(handle, texture)) _vk.vkDestroyImageView(_device, texture.view, nullptr);
+		}
+		_swapchainImages.clear();
+		if (_swapchain) _vk.vkDestroySwapchainKHR(_device, _swapchain, nullptr);
+		_swapchain = VK_NULL_HANDLE;
+	}
+
+	bool VulkanDevice::CreateOffscreenBackBuffer()
+	{
+		_backBuffer = CreateTexture(
+			TextureDesc{_backBufferWidth, _backBufferHeight, 1, _backBufferFormat, TextureUsage::RenderTarget});
+		return !_backBuffer.IsNull();
+	}
+
+	TextureHandle VulkanDevice::AcquireBackBuffer()
+	{
+		if (!_surface) return _backBuffer;
+		if (_imageAcquired) return _swapchainImages[_imageIndex];
+
+		if (_swapchainDirty || !_swapchain)
+		{
+			_vk.vkDeviceWaitIdle(_device);
+			if (!CreateSwapchain()) return {};
+			_swapchainDirty = false;
+		}
+
+		Frame& frame = _frames[_frameIndex];
+		VkResult result = _vk.vkAcquireNextImageKHR(_device, _swapchain, UINT64_MAX, frame.imageAcquired,
+													VK_NULL_HANDLE, &_imageIndex);
+		if (result == VK_ERROR_OUT_OF_DATE_KHR)
+		{
+			_vk.vkDeviceWaitIdle(_device);
+			if (!CreateSwapchain()) return {};
+			result = _vk.vkAcquireNextImageKHR(_device, _swapchain, UINT64_MAX, frame.imageAcquired, VK_NULL_HANDLE,
+											   &_imageIndex);
+		}
+		if (result == VK_SUBOPTIMAL_KHR)
+		{
+			// Still presentable, recreate once this frame is out
+			_swapchainDirty = true;
+		}
+		else if (!check(result, "vkAcquireNextImageKHR"))
+		{
+			return {};
+		}
+
+		_imageAcquired = true;
+		frame.acquireWaitPending = true;
+		Texture* image = _textures.Get(_swapchainImages[_imageIndex]);
+		image->layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		image->stage = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+		image->access = VK_ACCESS_2_NONE;
+		return _swapchainImages[_imageIndex];
+	}
+
+	void VulkanDevice::Shutdown()
+	{
+		if (_device)
+		{
+			// Precompile jobs use the device, and what they made nobody asked for
+			if (_jobs) _jobs->Wait(_precompileCounter);
+			for (uint32_t i = 0; _precompiled && i < _precompileFile.GetPipelineCount(); i++)
+			{
+				if (_precompiled[i].state.load() == Precompiled::Ready && _precompiled[i].pipeline)
+				{
+					_vk.vkDestroyPipeline(_device, _precompiled[i].pipeline, nullptr);
+				}
+			}
+			SavePipelineCache();
+
+			_vk.vkDeviceWaitIdle(_device);
+			if (_uploadCommands) _vk.vkEndCommandBuffer(_uploadCommands);
+			_uploadCommands = VK_NULL_HANDLE;
+			if (_transferCommands) _vk.vkEndCommandBuffer(_transferCommands);
+			_transferCommands = VK_NULL_HANDLE;
+			DestroySwapchain();
+
+			// Memory goes with the allocator's blocks
+			for (const Texture& texture : _textures)
+			{
+				_vk.vkDestroyImageView(_device, texture.view, nullptr);
+				_vk.vkDestroyImage(_device, texture.image, nullptr);
+			}
+			for (const Buffer& buffer : _buffers)
+			{
+				_vk.vkDestroyBuffer(_device, buffer.buffer, nullptr);
+			}
+			for (const Pipeline& pipeline : _pipelines)
+			{
+				_vk.vkDestroyPipeline(_device, pipeline.pipeline, nullptr);
+			}
+
+			for (Frame& frame : _frames)
+			{
+				ReleaseRetired(frame);
+				for (ThreadContext& thread : frame.threads)
+				{
+					thread.descriptors.Shutdown();
+					_vk.vkDestroyCommandPool(_device, thread.commandPool, nullptr);
+				}
+				_vk.vkDestroyCommandPool(_device, frame.commandPool, nullptr);
+				_vk.vkDestroySemaphore(_device, frame.imageAcquired, nullptr);
+				_vk.vkDestroyBuffer(_device, frame.staging.buffer, nullptr);
+				frame = Frame{};
+			}
+			_vk.vkDestroyBuffer(_device, _uploadStaging.buffer, nullptr);
+			_memory.Shutdown();
+			for (VkSemaphore semaphore : _renderFinished)
+			{
+				_vk.vkDestroySemaphore(_device, semaphore, nullptr);
+			}
+			_vk.vkDestroySemaphore(_device, _timeline, nullptr);
+			_vk.vkDestroySemaphore(_device, _uploadTimeline, nullptr);
+			_vk.vkDestroyCommandPool(_device, _transferPool, nullptr);
+			_vk.vkDestroyPipelineCache(_device, _pipelineCache, nullptr);
+			_vk.vkDestroySampler(_device, _sampler, nullptr);
+			_vk.vkDestroyPipelineLayout(_device, _pipelineLayout, nullptr);
+			_bindlessTextures.Shutdown();
+			_descriptorLayouts.Shutdown();
+			_vk.vkDestroyDevice(_device, nullptr);
+		}
+		if (_surface) _vk.vkDestroySurfaceKHR(_instance, _surface, nullptr);
+		if (_messenger) _vk.vkDestroyDebugUtilsMessengerEXT(_instance, _messenger, nullptr);
+		if (_instance) _vk.vkDestroyInstance(_instance, nullptr);
+		_vk.Unload();
+
+		_textures.Clear();
+		_buffers.Clear();
+		_pipelines.Clear();
+		_pipelineLookup.clear();
+		_pipelineCache = VK_NULL_HANDLE;
+		_pipelineRecord.Clear();
+		_precompileFile.Clear();
+		_precompiled.reset();
+		_precompiledLookup.clear();
+		_pipelineCacheStats = PipelineCacheStats{};
+		_renderFinished.clear();
+		_device = VK_NULL_HANDLE;
+		_surface = VK_NULL_HANDLE;
+		_messenger = VK_NULL_HANDLE;
+		_instance = VK_NULL_HANDLE;
+		_physicalDevice = VK_NULL_HANDLE;
+		_timeline = VK_NULL_HANDLE;
+		_timelineValue = 0;
+		_uploadTimeline = VK_NULL_HANDLE;
+		_uploadValue = 0;
+		_uploadCompleted = 0;
+		_transferPool = VK_NULL_HANDLE;
+		_uploadBatches.clear();
+		_freeTransferCommands.clear();
+		_uploadStaging = Buffer{};
+		_uploadRing = UploadRing();
+		_frameIndex = 0;
+		_imageAcquired = false;
+		_backBuffer = {};
+	}
+
+	BufferHandle VulkanDevice::CreateBuffer(const BufferDesc& desc, const void* data)
+	{
+		if (desc.bytes == 0) return {};
+
+		VkBufferUsageFlags usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		switch (desc.usage)
+		{
+		case BufferUsage::Vertex:
+			usage |= VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+			break;
+		case BufferUsage::Index:
+			usage |= VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+			break;
+		case BufferUsage::Uniform:
+			usage |= VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+			break;
+		case BufferUsage::Storage:
+			usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+			break;
+		}
+
+		Buffer buffer;
+		const MemoryUsage memoryUsage = desc.dynamic ? MemoryUsage::Dynamic : MemoryUsage::GpuOnly;
+		if (!CreateRawBuffer(desc.bytes, usage, memoryUsage, buffer)) return {};
+		if (data && buffer.mapped)
+		{
+			std::memcpy(buffer.mapped, data, desc.bytes);
+		}
+		else if (data)
+		{
+			// Copied on the GPU ahead of the next submission
+			VkBuffer staging;
+			uint64_t stagingOffset;
+			if (!Stage(data, desc.bytes, staging, stagingOffset))
+			{
+				Retire(Retired{buffer.buffer, VK_NULL_HANDLE, VK_NULL_HANDLE, buffer.allocation, VK_NULL_HANDLE});
+				return {};
+			}
+			const VkBufferCopy copy{stagingOffset, 0, desc.bytes};
+			_vk.vkCmdCopyBuffer(GetUploadCommands(), staging, buffer.buffer, 1, &copy);
+		}
+
+		// Defragmentation finds the buffer it moves by its handle
+		const BufferHandle handle = _buffers.Create(buffer);
+		if (memoryUsage == MemoryUsage::GpuOnly) _memory.SetUserData(buffer.allocation, handle.GetRaw());
+		return handle;
+	}
+
+	TextureHandle VulkanDevice::CreateTexture(const TextureDesc& desc)
+	{
+		const VkFormat format = getVkFormat(desc.format, _depthStencilFormat);
+		if (format == VK_FORMAT_UNDEFINED || desc.width == 0 || desc.height == 0 || desc.levels == 0) return {};
+
+		VkImageUsageFlags usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+		switch (desc.usage)
+		{
+		case TextureUsage::Sampled:
+			usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+			break;
+		case TextureUsage::RenderTarget:
+			usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+			break;
+		case TextureUsage::DepthStencil:
+			usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+			aspect = desc.format == Format::Depth24Stencil8 ? VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT
+															: VK_IMAGE_ASPECT_DEPTH_BIT;
+			break;
+		}
+
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.format = format;
+		imageInfo.extent = {desc.width, desc.height, 1};
+		imageInfo.mipLevels = desc.levels;
+		imageInfo.arrayLayers = 1;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.usage = usage;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		if (desc.usage == TextureUsage::Sampled) setSharing(imageInfo, _queueFamilies);
+		Texture texture{};
+		if (!check(_vk.vkCreateImage(_device, &imageInfo, nullptr, &texture.image), "vkCreateImage")) return {};
+
+		VkMemoryRequirements requirements;
+		_vk.vkGetImageMemoryRequirements(_device, texture.image, &requirements);
+		MemoryRequest request;
+		request.size = requirements.size;
+		request.alignment = requirements.alignment;
+		request.typeBits = requirements.memoryTypeBits;
+		request.kind = MemoryKind::Optimal;
+		if (!_memory.Allocate(request, texture.allocation))
+		{
+			_vk.vkDestroyImage(_device, texture.image, nullptr);
+			return {};
+		}
+		_vk.vkBindImageMemory(_device, texture.image, texture.allocation.memory, texture.allocation.offset);
+
+		// Attachments can only see one level
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = texture.image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = format;
+		viewInfo.subresourceRange = {aspect, 0, desc.usage == TextureUsage::Sampled ? desc.levels : 1, 0, 1};
+		if (!check(_vk.vkCreateImageView(_device, &viewInfo, nullptr, &texture.view), "vkCreateImageView"))
+		{
+			_vk.vkDestroyImage(_device, texture.image, nullptr);
+			_memory.Free(texture.allocation);
+			return {};
+		}
+
+		texture.format = format;
+		texture.aspect = aspect;
+		texture.width = desc.width;
+		texture.height = desc.height;
+		texture.texelBytes = getFormatSize(desc.format);
+		texture.owned = true;
+		texture.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		texture.stage = VK_PIPELINE_STAGE_2_NONE;
+		texture.access = VK_ACCESS_2_NONE;
+		texture.levels = desc.levels;
+		texture.uploadable = desc.usage == TextureUsage::Sampled;
+
+		// Nothing writes sampled textures after creation, so they wait in shader read layout for bindless
+		// reads no draw declares
+		if (_bindlessTextures.IsEnabled() && desc.usage == TextureUsage::Sampled)
+		{
+			texture.bindless = _bindlessTextures.Add(_sampler, texture.view);
+			Transition(texture, VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL, ShaderStages, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+					   true, _barriers);
+			FlushBarriers(GetUploadCommands(), _barriers);
+		}
+		return _textures.Create(texture);
+	}
+
+	PipelineHandle VulkanDevice::CreatePipeline(const PipelineDesc& desc)
+	{
+		if (desc.attributeCount > MaxVertexAttributes || desc.pushConstantBytes > MaxPushConstantBytes) return {};
+		if (desc.vertexSpirv.empty() || desc.fragmentSpirv.empty()) return {};
+
+		// Equal descriptions share one pipeline. The record holds the description of every hash in the lookup,
+		// a colliding one gets a pipeline of its own
+		const uint64_t hash = hashPipelineDesc(desc);
+		const auto found = _pipelineLookup.find(hash);
+		uint32_t recorded;
+		if (found != _pipelineLookup.end() && _pipelineRecord.FindPipeline(hash, recorded) &&
+			equalPipelineDesc(desc, _pipelineRecord.GetPipeline(recorded)))
+		{
+			_pipelines.Get(found->second)->references++;
+			_pipelineCacheStats.shared++;
+			return found->second;
+		}
+
+		VkPipeline pipeline = TakePrecompiled(desc, hash);
+		if (pipeline)
+		{
+			_pipelineCacheStats.precompiled++;
+		}
+		else
+		{
+			pipeline = CompilePipeline(desc);
+			if (!pipeline) return {};
+			_pipelineCacheStats.compiled++;
+		}
+		_pipelineRecord.AddPipeline(desc, hash);
+		const PipelineHandle handle = _pipelines.Create(Pipeline{pipeline, desc.pushConstantBytes, hash, 1});
+		_pipelineLookup.try_emplace(hash, handle);
+		return handle;
+	}
+
+	VkPipeline VulkanDevice::CompilePipeline(const PipelineDesc& desc)
+	{
+		VkShaderModule modules[2] = {VK_NULL_HANDLE, VK_NULL_HANDLE};
+		const rv::Span<const uint32_t> code[2] = {desc.vertexSpirv, desc.fragmentSpirv};
+		for (uint32_t i = 0; i < 2; i++)
+		{
+			VkShaderModuleCreateInfo moduleInfo{};
+			moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+			moduleInfo.codeSize = code[i].size_bytes();
+			moduleInfo.pCode = code[i].data();
+			check(_vk.vkCreateShaderModule(_device, &moduleInfo, nullptr, &modules[i]), "vkCreateShaderModule");
+		}
+		auto destroyModules = [&]() {
+			for (VkShaderModule module : modules)
+			{
+				if (module) _vk.vkDestroyShaderModule(_device, module, nullptr);
+			}
+		};
+		if (!modules[0] || !modules[1])
+		{
+			destroyModules();
+			return {};
+		}
+
+		VkPipelineShaderStageCreateInfo stages[2] = {
+			{VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO, nullptr, 0, VK_SHADER_STAGE_VERTEX_BIT, modules[0],
+			 "main", nullptr},
+			{VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO, nullptr, 0, VK_SHADER_STAGE_FRAGMENT_BIT, modules[1],
+			 "main", nullptr},
+		};
+
+		VkVertexInputAttributeDescription attributes[MaxVertexAttributes];
+		for (uint32_t i = 0; i < desc.attributeCount; i++)
+		{
+			const VertexAttribute& attribute = desc.attributes[i];
+			attributes[i] = {attribute.location, 0, getVkFormat(attribute.format, VK_FORMAT_UNDEFINED),
+							 attribute.offset};
+			if (isDepthFormat(attribute.format) || attributes[i].format == VK_FORMAT_UNDEFINED)
+			{
+				GEFX_LOG_ERROR("[Vulkan] Vertex attribute {} has no vertex format", attribute.location);
+				destroyModules();
+				return {};
+			}
+		}
+		const VkVertexInputBindingDescription binding{0, desc.vertexStride, VK_VERTEX_INPUT_RATE_VERTEX};
+		VkPipelineVertexInputStateCreateInfo vertexInput{};
+		vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+		vertexInput.vertexBindingDescriptionCount = desc.attributeCount > 0 ? 1 : 0;
+		vertexInput.pVertexBindingDescriptions = &binding;
+		vertexInput.vertexAttributeDescriptionCount = desc.attributeCount;
+		vertexInput.pVertexAttributeDescriptions = attributes;
+
+		VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+		inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+		inputAssembly.topology = getTopology(desc.topology);
+
+		VkPipelineViewportStateCreateInfo viewport{};
+		viewport.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+		viewport.viewportCount = 1;
+		viewport.scissorCount = 1;
+
+		// GLSLtoSPV flips y in the vertex shader, which keeps GL's counter clockwise winding on screen
+		VkPipelineRasterizationStateCreateInfo rasterization{};
+		rasterization.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+		rasterization.polygonMode = VK_POLYGON_MODE_FILL;
+		rasterization.cullMode = getCullMode(desc.cullMode);
+		rasterization.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+		rasterization.lineWidth = 1.0f;
+
+		VkPipelineMultisampleStateCreateInfo multisample{};
+		multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+		multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+		VkPipelineDepthStencilStateCreateInfo depthStencil{};
+		depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+		depthStencil.depthTestEnable = desc.depthTest ? VK_TRUE : VK_FALSE;
+		depthStencil.depthWriteEnable = desc.depthWrite ? VK_TRUE : VK_FALSE;
+		depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+
+		VkPipelineColorBlendAttachmentState blendAttachment{};
+		if (desc.blend != BlendMode::None)
+		{
+			blendAttachment.blendEnable = VK_TRUE;
+			blendAttachment.srcColorBlendFactor =
+				desc.blend == BlendMode::Alpha ? VK_BLEND_FACTOR_SRC_ALPHA : VK_BLEND_FACTOR_ONE;
+			blendAttachment.dstColorBlendFactor =
+				desc.blend == BlendMode::Additive ? VK_BLEND_FACTOR_ONE : VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+			blendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+			blendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+			blendAttachment.dstAlphaBlendFactor = blendAttachment.dstColorBlendFactor;
+			blendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+		}
+		blendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+										 VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+		const VkFormat colorFormat = getVkFormat(desc.colorFormat, VK_FORMAT_UNDEFINED);
+		VkPipelineColorBlendStateCreateInfo blend{};
+		blend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+		blend.attachmentCount = colorFormat != VK_FORMAT_UNDEFINED ? 1 : 0;
+		blend.pAttachments = &blendAttachment;
+
+		const VkDynamicState dynamicStates[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+		VkPipelineDynamicStateCreateInfo dynamic{};
+		dynamic.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+		dynamic.dynamicStateCount = 2;
+		dynamic.pDynamicStates = dynamicStates;
+
+		const VkFormat depthFormat = getVkFormat(desc.depthFormat, _depthStencilFormat);
+		VkPipelineRenderingCreateInfo rendering{};
+		rendering.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+		rendering.colorAttachmentCount = blend.attachmentCount;
+		rendering.pColorAttachmentFormats = &colorFormat;
+		rendering.depthAttachmentFormat = depthFormat;
+		rendering.stencilAttachmentFormat =
+			desc.depthFormat == Format::Depth24Stencil8 ? depthFormat : VK_FORMAT_UNDEFINED;
+
+		VkGraphicsPipelineCreateInfo pipelineInfo{};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+		pipelineInfo.pNext = &rendering;
+		pipelineInfo.stageCount = 2;
+		pipelineInfo.pStages = stages;
+		pipelineInfo.pVertexInputState = &vertexInput;
+		pipelineInfo.pInputAssemblyState = &inputAssembly;
+		pipelineInfo.pViewportState = &viewport;
+		pipelineInfo.pRasterizationState = &rasterization;
+		pipelineInfo.pMultisampleState = &multisample;
+		pipelineInfo.pDepthStencilState = &depthStencil;
+		pipelineInfo.pColorBlendState = &blend;
+		pipelineInfo.pDynamicState = &dynamic;
+		pipelineInfo.layout = _pipelineLayout;
+
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		const VkResult result =
+			_vk.vkCreateGraphicsPipelines(_device, _pipelineCache, 1, &pipelineInfo, nullptr, &pipeline);
+		destroyModules();
+		return check(result, "vkCreateGraphicsPipelines") ? pipeline : VK_NULL_HANDLE;
+	}
+
+	void VulkanDevice::PrecompilePipelines()
+	{
+		const uint32_t count = _precompileFile.GetPipelineCount();
+		if (!_jobs || count == 0) return;
+
+		GEFX_LOG_INFO("[Vulkan] Precompiling {} pipelines of the last session", count);
+		_precompiled.reset(new Precompiled[count]);
+		_precompiledLookup.reserve(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			_precompiledLookup.try_emplace(_precompileFile.GetPipelineHash(i), i);
+			_jobs->Schedule(
+				[this, i]() {
+					// CreatePipeline may have claimed it first
+					Precompiled& slot = _precompiled[i];
+					uint32_t state = Precompiled::Queued;
+					if (!slot.state.compare_exchange_strong(state, Precompiled::Compiling)) return;
+					slot.pipeline = CompilePipeline(_precompileFile.GetPipeline(i));
+					slot.state.store(Precompiled::Ready, std::memory_order_release);
+				},
+				&_precompileCounter);
+		}
+	}
+
+	VkPipeline VulkanDevice::TakePrecompiled(const PipelineDesc& desc, uint64_t hash)
+	{
+		const auto found = _precompiledLookup.find(hash);
+		if (found == _precompiledLookup.end()) return VK_NULL_HANDLE;
+		if (!equalPipelineDesc(desc, _precompileFile.GetPipeline(found->second))) return VK_NULL_HANDLE;
+
+		// Still queued: take it away from its job and compile here. Compiling: help the job system until done.
+		Precompiled& slot = _precompiled[found->second];
+		uint32_t state = Precompiled::Queued;
+		if (slot.state.compare_exchange_strong(state, Precompiled::Taken)) return VK_NULL_HANDLE;
+		while (state == Precompiled::Compiling)
+		{
+			if (!_jobs->TryRunOne()) std::this_thread::yield();
+			state = slot.state.load(std::memory_order_acquire);
+		}
+		if (state != Precompiled::Ready) return VK_NULL_HANDLE;
+		slot.state.store(Precompiled::Taken, std::memory_order_relaxed);
+		return slot.pipeline;
+	}
+
+	void VulkanDevice::SavePipelineCache()
+	{
+		if (_pipelineCachePath.empty() || !_pipelineCache) return;
+
+		size_t size = 0;
+		if (!check(_vk.vkGetPipelineCacheData(_device, _pipelineCache, &size, nullptr), "vkGetPipelineCacheData"))
+		{
+			return;
+		}
+		std::vector<uint8_t> data(size);
+		if (!check(_vk.vkGetPipelineCacheData(_device, _pipelineCache, &size, data.data()), "vkGetPipelineCacheData"))
+		{
+			return;
+		}
+		data.resize(size);
+		_pipelineRecord.SetData(std::move(data));
+
+		VkPhysicalDeviceProperties properties;
+		_vk.vkGetPhysicalDeviceProperties(_physicalDevice, &properties);
+		if (_pipelineRecord.Write(_pipelineCachePath, properties))
+		{
+			GEFX_LOG_INFO("[Vulkan] Saved {} pipelines and {} bytes of driver cache to {}",
+						  _pipelineRecord.GetPipelineCount(), size, _pipelineCachePath);
+		}
+	}
+
+	void VulkanDevice::Destroy(BufferHandle handle)
+	{
+		Buffer buffer;
+		if (!_buffers.Release(handle, buffer)) return;
+		Retire(Retired{buffer.buffer, VK_NULL_HANDLE, VK_NULL_HANDLE, buffer.allocation, VK_NULL_HANDLE});
+	}
+
+	void VulkanDevice::Destroy(TextureHandle handle)
+	{
+		const Texture* owned = _textures.Get(handle);
+		if (!owned || !owned->owned) return;
+
+		Texture texture;
+		_textures.Release(handle, texture);
+		Retire(Retired{VK_NULL_HANDLE, texture.image, texture.view, texture.allocation, VK_NULL_HANDLE,
+					   texture.bindless});
+	}
+
+	uint32_t VulkanDevice::GetBindlessIndex(TextureHandle handle) const
+	{
+		const Texture* texture = _textures.Get(handle);
+		return texture ? texture->bindless : BindlessTextureTable::InvalidIndex;
+	}
+
+	void VulkanDevice::Destroy(PipelineHandle handle)
+	{
+		Pipeline* shared = _pipelines.Get(handle);
+		if (!shared || --shared->references > 0) return;
+
+		Pipeline pipeline;
+		_pipelines.Release(handle, pipeline);
+		// Unless a colliding description owns the lookup entry
+		const auto found = _pipelineLookup.find(pipeline.hash);
+		if (found != _pipelineLookup.end() && found->second == handle) _pipelineLookup.erase(pipeline.hash);
+		Retire(Retired{VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE, {}, pipeline.pipeline});
+	}
+
+	void VulkanDevice::Resize(uint32_t width, uint32_t height)
+	{
+		if (width == _backBufferWidth && height == _backBufferHeight) return;
+		_backBufferWidth = width;
+		_backBufferHeight = height;
+		if (_surface)
+		{
+			_swapchainDirty = true;
+		}
+		else if (width > 0 && height > 0)
+		{
+			Destroy(_backBuffer);
+			CreateOffscreenBackBuffer();
+		}
+	}
+
+	TextureHandle VulkanDevice::GetBackBuffer() const
+	{
+		if (!_surface) return _backBuffer;
+		return _imageAcquired ? _swapchainImages[_imageIndex] : TextureHandle();
+	}
+
+	bool VulkanDevice::AllocateBlock(uint32_t memoryType, uint64_t size, VkDeviceMemory& outMemory,
+									 uint8_t*& outMapped)
+	{
+		// Failures are expected here, the allocator falls back to smaller blocks and other memory types
+		VkMemoryAllocateInfo allocateInfo{};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocateInfo.allocationSize = size;
+		allocateInfo.memoryTypeIndex = memoryType;
+		if (_vk.vkAllocateMemory(_device, &allocateInfo, nullptr, &outMemory) != VK_SUCCESS) return false;
+
+		outMapped = nullptr;
+		const VkMemoryPropertyFlags flags = _memoryProperties.memoryTypes[memoryType].propertyFlags;
+		if (!(flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)) return true;
+		void* mapped = nullptr;
+		if (!check(_vk.vkMapMemory(_device, outMemory, 0, VK_WHOLE_SIZE, 0, &mapped), "vkMapMemory"))
+		{
+			_vk.vkFreeMemory(_device, outMemory, nullptr);
+			return false;
+		}
+		outMapped = static_cast<uint8_t*>(mapped);
+		return true;
+	}
+
+	void VulkanDevice::FreeBlock(uint32_t /*memoryType*/, VkDeviceMemory memory)
+	{
+		// Freeing unmaps it
+		_vk.vkFreeMemory(_device, memory, nullptr);
+	}
+
+	void VulkanDevice::UpdateMemoryBudget()
+	{
+		if (!_memoryBudget) return;
+
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT budget{};
+		budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+		VkPhysicalDeviceMemoryProperties2 properties{};
+		properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+		properties.pNext = &budget;
+		_vk.vkGetPhysicalDeviceMemoryProperties2(_physicalDevice, &properties);
+		for (uint32_t i = 0; i < _memory.GetHeapCount(); i++)
+		{
+			const uint64_t ours = _memory.GetHeapStats(i).blockBytes;
+			const uint64_t others = budget.heapUsage[i] > ours ? budget.heapUsage[i] - ours : 0;
+			_memory.SetHeapBudget(i, budget.heapBudget[i] > others ? budget.heapBudget[i] - others : 0);
+		}
+	}
+
+	bool VulkanDevice::CreateRawBuffer(uint64_t bytes, VkBufferUsageFlags usage, MemoryUsage memoryUsage,
+									   Buffer& outBuffer)
+	{
+		outBuffer = Buffer{VK_NULL_HANDLE, {}, nullptr, bytes, usage};
+		VkBufferCreateInfo bufferInfo{};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = bytes;
+		bufferInfo.usage = usage;
+		setSharing(bufferInfo, _queueFamilies);
+		if (!check(_vk.vkCreateBuffer(_device, &bufferInfo, nullptr, &outBuffer.buffer), "vkCreateBuffer"))
+		{
+			return false;
+		}
+
+		// Only device local buffers can move, the CPU may be writing to the others any time
+		VkMemoryRequirements requirements;
+		_vk.vkGetBufferMemoryRequirements(_device, outBuffer.buffer, &requirements);
+		MemoryRequest request;
+		request.size = requirements.size;
+		request.alignment = requirements.alignment;
+		request.typeBits = requirements.memoryTypeBits;
+		request.usage = memoryUsage;
+		request.movable = memoryUsage == MemoryUsage::GpuOnly;
+		if (!_memory.Allocate(request, outBuffer.allocation))
+		{
+			_vk.vkDestroyBuffer(_device, outBuffer.buffer, nullptr);
+			outBuffer.buffer = VK_NULL_HANDLE;
+			return false;
+		}
+		_vk.vkBindBufferMemory(_device, outBuffer.buffer, outBuffer.allocation.memory, outBuffer.allocation.offset);
+		outBuffer.mapped = outBuffer.allocation.mapped;
+		return true;
+	}
+
+	bool VulkanDevice::Stage(const void* data, uint64_t bytes, VkBuffer& outBuffer, uint64_t& outOffset)
+	{
+		// Buffer copies want 4 byte offsets, texel block copies up to 16
+		Frame& frame = _frames[_frameIndex];
+		if (frame.staging.buffer && frame.stagingAllocator.Allocate(bytes, 16, outOffset))
+		{
+			std::memcpy(frame.staging.mapped + outOffset, data, bytes);
+			outBuffer = frame.staging.buffer;
+			return true;
+		}
+
+		// Doesn't fit what is left of the frame's staging buffer, take one of its own released with the frame
+		Buffer staging;
+		if (!CreateRawBuffer(bytes, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, MemoryUsage::Upload, staging)) return false;
+		std::memcpy(staging.mapped, data, bytes);
+		Retire(Retired{staging.buffer, VK_NULL_HANDLE, VK_NULL_HANDLE, staging.allocation, VK_NULL_HANDLE});
+		outBuffer = staging.buffer;
+		outOffset = 0;
+		return true;
+	}
+
+	void VulkanDevice::Retire(const Retired& retired)
+	{
+		_frames[_frameIndex].retired.push_back(retired);
+	}
+
+	void VulkanDevice::ReleaseRetired(Frame& frame)
+	{
+		for (const Retired& retired : frame.retired)
+		{
+			// Memory last, freeing its block unmaps it
+			if (retired.pipeline) _vk.vkDestroyPipeline(_device, retired.pipeline, nullptr);
+			if (retired.view) _vk.vkDestroyImageView(_device, retired.view, nullptr);
+			if (retired.image) _vk.vkDestroyImage(_device, retired.image, nullptr);
+			if (retired.buffer) _vk.vkDestroyBuffer(_device, retired.buffer, nullptr);
+			if (retired.bindless != BindlessTextureTable::InvalidIndex) _bindlessTextures.Remove(retired.bindless);
+			_memory.Free(retired.allocation);
+		}
+		frame.retired.clear();
+	}
+
+	VkCommandBuffer VulkanDevice::BeginPrimary()
+	{
+		Frame& frame = _frames[_frameIndex];
+		if (frame.commandBuffersUsed == frame.commandBuffers.size())
+		{
+			VkCommandBufferAllocateInfo allocateInfo{};
+			allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocateInfo.commandPool = frame.commandPool;
+			allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocateInfo.commandBufferCount = 1;
+			VkCommandBuffer commands = VK_NULL_HANDLE;
+			check(_vk.vkAllocateCommandBuffers(_device, &allocateInfo, &commands), "vkAllocateCommandBuffers");
+			frame.commandBuffers.push_back(commands);
+		}
+
+		VkCommandBuffer commands = frame.commandBuffers[frame.commandBuffersUsed++];
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		_vk.vkBeginCommandBuffer(commands, &beginInfo);
+		return commands;
+	}
+
+	VkCommandBuffer VulkanDevice::GetUploadCommands()
+	{
+		if (!_uploadCommands) _uploadCommands = BeginPrimary();
+		return _uploadCommands;
+	}
+
+	uint64_t VulkanDevice::QueueSubmit(VkCommandBuffer commands, VkSemaphore wait, VkSemaphore signal)
+	{
+		VkCommandBufferSubmitInfo commandInfos[2];
+		uint32_t commandCount = 0;
+		if (_uploadCommands)
+		{
+			GlobalBarrier(_uploadCommands, VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+						  BufferReadStages, BufferReadAccess);
+			_vk.vkEndCommandBuffer(_uploadCommands);
+			commandInfos[commandCount++] = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO, nullptr, _uploadCommands, 0};
+			_uploadCommands = VK_NULL_HANDLE;
+		}
+		if (commands)
+		{
+			commandInfos[commandCount++] = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO, nullptr, commands, 0};
+		}
+
+		VkSemaphoreSubmitInfo waitInfos[2]{};
+		waitInfos[0].sType = waitInfos[1].sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+		uint32_t waitCount = 0;
+		if (wait)
+		{
+			waitInfos[waitCount].semaphore = wait;
+			waitInfos[waitCount++].stageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+		}
+		// Already reached, the wait makes the upload writes visible to this submission
+		if (_uploadCompleted > 0)
+		{
+			waitInfos[waitCount].semaphore = _uploadTimeline;
+			waitInfos[waitCount].value = _uploadCompleted;
+			waitInfos[waitCount++].stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+		}
+		VkSemaphoreSubmitInfo signalInfos[2]{};
+		signalInfos[0].sType = signalInfos[1].sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+		signalInfos[0].semaphore = _timeline;
+		signalInfos[0].value = ++_timelineValue;
+		signalInfos[0].stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+		signalInfos[1].semaphore = signal;
+		signalInfos[1].stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+
+		VkSubmitInfo2 submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
+		submitInfo.waitSemaphoreInfoCount = waitCount;
+		submitInfo.pWaitSemaphoreInfos = waitInfos;
+		submitInfo.commandBufferInfoCount = commandCount;
+		submitInfo.pCommandBufferInfos = commandInfos;
+		submitInfo.signalSemaphoreInfoCount = signal ? 2 : 1;
+		submitInfo.pSignalSemaphoreInfos = signalInfos;
+		check(_vk.vkQueueSubmit2(_queue, 1, &submitInfo, VK_NULL_HANDLE), "vkQueueSubmit2");
+		return _timelineValue;
+	}
+
+	void VulkanDevice::WaitTimeline(uint64_t value)
+	{
+		if (value == 0) return;
+		VkSemaphoreWaitInfo waitInfo{};
+		waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		waitInfo.semaphoreCount = 1;
+		waitInfo.pSemaphores = &_timeline;
+		waitInfo.pValues = &value;
+		check(_vk.vkWaitSemaphores(_device, &waitInfo, UINT64_MAX), "vkWaitSemaphores");
+	}
+
+	void VulkanDevice::Transition(Texture& texture, VkImageLayout layout, VkPipelineStageFlags2 stage,
+								  VkAccessFlags2 access, bool discard, std::vector<VkImageMemoryBarrier2>& barriers)
+	{
+		// Reads after reads in the same layout need no barrier, they only widen what the next write waits for
+		if (texture.layout == layout && !discard && !(texture.access & WriteAccess) && !(access & WriteAccess))
+		{
+			texture.stage |= stage;
+			texture.access |= access;
+			return;
+		}
+
+		VkImageMemoryBarrier2 barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+		barrier.srcStageMask = texture.stage;
+		barrier.srcAccessMask = texture.access;
+		barrier.dstStageMask = stage;
+		barrier.dstAccessMask = access;
+		barrier.oldLayout = discard ? VK_IMAGE_LAYOUT_UNDEFINED : texture.layout;
+		barrier.newLayout = layout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = texture.image;
+		barrier.subresourceRange = {texture.aspect, 0, VK_REMAINING_MIP_LEVELS, 0, 1};
+		barriers.push_back(barrier);
+
+		texture.layout = layout;
+		texture.stage = stage;
+		texture.access = access;
+	}
+
+	void VulkanDevice::FlushBarriers(VkCommandBuffer commands, std::vector<VkImageMemoryBarrier2>& barriers)
+	{
+		if (barriers.empty()) return;
+		VkDependencyInfo dependency{};
+		dependency.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+		dependency.imageMemoryBarrierCount = static_cast<uint32_t>(barriers.size());
+		dependency.pImageMemoryBarriers = barriers.data();
+		_vk.vkCmdPipelineBarrier2(commands, &dependency);
+		barriers.clear();
+	}
+
+	void VulkanDevice::GlobalBarrier(VkCommandBuffer commands, VkPipelineStageFlags2 srcStage, VkAccessFlags2 srcAccess,
+									 VkPipelineStageFlags2 dstStage, VkAccessFlags2 dstAccess)
+	{
+		VkMemoryBarrier2 barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+		barrier.srcStageMask = srcStage;
+		barrier.srcAccessMask = srcAccess;
+		barrier.dstStageMask = dstStage;
+		barrier.dstAccessMask = dstAccess;
+		VkDependencyInfo dependency{};
+		dependency.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+		dependency.memoryBarrierCount = 1;
+		dependency.pMemoryBarriers = &barrier;
+		_vk.vkCmdPipelineBarrier2(commands, &dependency);
+	}
+
+	void VulkanDevice::Submit(rv::Span<const CommandList* const> lists)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		_stats.submits++;
+		if (lists.empty()) return;
+		assert((!_jobs || JobSystem::GetThreadIndex() == 0 || JobSystem::GetThreadIndex() > _jobs->GetWorkerCount()) &&
+			   "Submit from a job system worker");
+
+		Prescan(lists);
+
+		// Every list records its own secondaries, on whichever thread picks it up
+		const uint32_t listCount = static_cast<uint32_t>(lists.size());
+		auto record = [&](uint32_t begin, uint32_t end) {
+			for (uint32_t i = begin; i < end; i++)
+			{
+				Record(*lists[i], _segments.data() + _listSegments[i], _listSegments[i + 1] - _listSegments[i]);
+			}
+		};
+		if (_jobs)
+		{
+			_jobs->ParallelFor(listCount, 1, record);
+		}
+		else
+		{
+			record(0, listCount);
+		}
+
+		// Stitch the segments together in submission order
+		VkCommandBuffer commands = BeginPrimary();
+		bool rendering = false;
+		for (const Segment& segment : _segments)
+		{
+			Pass* pass = segment.pass >= 0 ? &_passes[segment.pass] : nullptr;
+			if (pass && segment.beginsPass && !pass->skip)
+			{
+				const RenderPassDesc& desc = pass->desc;
+				for (TextureHandle handle : pass->sampled)
+				{
+					if (Texture* texture = _textures.Get(handle))
+					{
+						Transition(*texture, VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL, ShaderStages,
+								   VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, false, _barriers);
+					}
+				}
+
+				VkRenderingAttachmentInfo colorAttachment{};
+				colorAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+				VkRenderingAttachmentInfo depthAttachment{};
+				depthAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+				Texture* color = _textures.Get(pass->color);
+				Texture* depth = _textures.Get(desc.depth);
+				if (color)
+				{
+					Transition(*color, VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL,
+							   VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+							   VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+							   desc.clearColor, _barriers);
+					colorAttachment.imageView = color->view;
+					colorAttachment.imageLayout = VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL;
+					colorAttachment.loadOp = desc.clearColor ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+					colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+					std::memcpy(colorAttachment.clearValue.color.float32, &desc.clearColorValue[0], sizeof(float) * 4);
+				}
+				if (depth)
+				{
+					Transition(*depth, VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL, DepthStages,
+							   VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+								   VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+							   desc.clearDepth, _barriers);
+					depthAttachment.imageView = depth->view;
+					depthAttachment.imageLayout = VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL;
+					depthAttachment.loadOp = desc.clearDepth ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+					depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+					depthAttachment.clearValue.depthStencil = {desc.clearDepthValue, 0};
+				}
+				FlushBarriers(commands, _barriers);
+
+				VkRenderingInfo renderingInfo{};
+				renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+				renderingInfo.flags = VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT;
+				renderingInfo.renderArea = {{0, 0}, pass->extent};
+				renderingInfo.layerCount = 1;
+				renderingInfo.colorAttachmentCount = color ? 1 : 0;
+				renderingInfo.pColorAttachments = &colorAttachment;
+				renderingInfo.pDepthAttachment = depth ? &depthAttachment : nullptr;
+				renderingInfo.pStencilAttachment = pass->stencilFormat ? &depthAttachment : nullptr;
+				_vk.vkCmdBeginRendering(commands, &renderingInfo);
+				rendering = true;
+			}
+
+			if (segment.commands)
+			{
+				// Updates wait for the draws before them and the ones after wait for the updates
+				if (segment.updates)
+				{
+					GlobalBarrier(commands, BufferReadStages, VK_ACCESS_2_NONE, VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+								  VK_ACCESS_2_TRANSFER_WRITE_BIT);
+				}
+				_vk.vkCmdExecuteCommands(commands, 1, &segment.commands);
+				if (segment.updates)
+				{
+					GlobalBarrier(commands, VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+								  BufferReadStages, BufferReadAccess);
+				}
+			}
+
+			if (pass && segment.endsPass && rendering)
+			{
+				_vk.vkCmdEndRendering(commands);
+				rendering = false;
+			}
+		}
+		assert(!rendering && "submit ends inside a render pass");
+		if (rendering) _vk.vkCmdEndRendering(commands);
+		_vk.vkEndCommandBuffer(commands);
+
+		// The first submission rendering to the acquired image waits for it
+		Frame& frame = _frames[_frameIndex];
+		QueueSubmit(commands, frame.acquireWaitPending ? frame.imageAcquired : VK_NULL_HANDLE, VK_NULL_HANDLE);
+		frame.acquireWaitPending = false;
+
+		for (const CommandList* list : lists)
+		{
+			CountSubmitted(*list);
+		}
+		_stats.submitMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	void VulkanDevice::Prescan(rv::Span<const CommandList* const> lists)
+	{
+		_passes.clear();
+		_segments.clear();
+		_listSegments.clear();
+
+		int32_t pass = -1;
+		for (uint32_t i = 0; i < lists.size(); i++)
+		{
+			_listSegments.push_back(static_cast<uint32_t>(_segments.size()));
+			const rv::Span<const uint8_t> data = lists[i]->GetData();
+			Segment segment{i, 0, 0, pass, false, false, false, false, VK_NULL_HANDLE};
+
+			uint32_t offset = 0;
+			while (offset < data.size())
+			{
+				const CommandHeader& header = *reinterpret_cast<const CommandHeader*>(data.data() + offset);
+				const void* payload = data.data() + offset + sizeof(CommandHeader);
+				const uint32_t next = offset + header.size;
+				switch (header.type)
+				{
+				case CommandType::BeginRenderPass:
+				{
+					segment.end = offset;
+					_segments.push_back(segment);
+
+					Pass info{};
+					info.desc = as<cmd::BeginRenderPass>(payload).desc;
+					info.color = info.desc.color.IsNull() ? AcquireBackBuffer() : info.desc.color;
+					const Texture* color = _textures.Get(info.color);
+					const Texture* depth = _textures.Get(info.desc.depth);
+					// Without a back buffer (minimized window) the pass is dropped
+					info.skip = !color && !depth;
+					info.extent = {info.desc.width, info.desc.height};
+					for (const Texture* target : {color, depth})
+					{
+						if (!target) continue;
+						info.extent.width = std::min(info.extent.width, target->width);
+						info.extent.height = std::min(info.extent.height, target->height);
+					}
+					info.colorFormat = color ? color->format : VK_FORMAT_UNDEFINED;
+					info.depthFormat = depth ? depth->format : VK_FORMAT_UNDEFINED;
+					info.stencilFormat =
+						depth && (depth->aspect & VK_IMAGE_ASPECT_STENCIL_BIT) ? depth->format : VK_FORMAT_UNDEFINED;
+
+					pass = static_cast<int32_t>(_passes.size());
+					_passes.push_back(std::move(info));
+					segment = Segment{i, next, next, pass, true, false, false, false, VK_NULL_HANDLE};
+					break;
+				}
+				case CommandType::EndRenderPass:
+					segment.end = offset;
+					segment.endsPass = true;
+					_segments.push_back(segment);
+					pass = -1;
+					segment = Segment{i, next, next, pass, false, false, false, false, VK_NULL_HANDLE};
+					break;
+				case CommandType::Draw:
+				case CommandType::DrawIndexed:
+					segment.hasWork = true;
+					break;
+				case CommandType::UpdateBuffer:
+					segment.hasWork = true;
+					segment.updates = true;
+					break;
+				case CommandType::BindTexture:
+				{
+					const TextureHandle texture = as<cmd::BindTexture>(payload).texture;
+					if (pass < 0) break;
+					std::vector<TextureHandle>& sampled = _passes[pass].sampled;
+					if (std::find(sampled.begin(), sampled.end(), texture) == sampled.end()) sampled.push_back(texture);
+					break;
+				}
+				default:
+					break;
+				}
+				offset = next;
+			}
+			segment.end = offset;
+			_segments.push_back(segment);
+		}
+		_listSegments.push_back(static_cast<uint32_t>(_segments.size()));
+	}
+
+	void VulkanDevice::Record(const CommandList& list, Segment* segments, uint32_t count)
+	{
+		Frame& frame = _frames[_frameIndex];
+		// Without a job system only the submitting thread records
+		const uint32_t threadIndex = _jobs ? JobSystem::GetThreadIndex() : 0;
+		assert(threadIndex < frame.threads.size() && "recording on a thread of another job system");
+		ThreadContext& thread = frame.threads[threadIndex];
+
+		// Bindings are per list like on every backend, each secondary starts from scratch and gets them again
+		const Pipeline* pipeline = nullptr;
+		VkBuffer vertexBuffer = VK_NULL_HANDLE;
+		VkDeviceSize vertexOffset = 0;
+		VkBuffer indexBuffer = VK_NULL_HANDLE;
+		VkDeviceSize indexOffset = 0;
+		VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+		VkDescriptorBufferInfo uniforms[MaxUniformBufferSlots] = {};
+		VkImageView textures[MaxTextureSlots] = {};
+		VkDescriptorSet uniformSet = VK_NULL_HANDLE;
+		VkDescriptorSet textureSet = VK_NULL_HANDLE;
+		bool uniformsChanged = false;
+		bool texturesChanged = false;
+		VkViewport viewport{};
+		VkRect2D scissor{};
+		alignas(16) uint8_t pushConstants[MaxPushConstantBytes] = {};
+
+		bool pipelineDirty = false;
+		bool vertexDirty = false;
+		bool indexDirty = false;
+		bool setsDirty = false;
+		bool viewportDirty = false;
+		bool pushDirty = false;
+
+		VkCommandBuffer commands = VK_NULL_HANDLE;
+		bool updated = false;
+
+		auto flushDraw = [&]() {
+			if (pipelineDirty)
+			{
+				_vk.vkCmdBindPipeline(commands, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->pipeline);
+				pipelineDirty = false;
+			}
+			if (viewportDirty)
+			{
+				_vk.vkCmdSetViewport(commands, 0, 1, &viewport);
+				_vk.vkCmdSetScissor(commands, 0, 1, &scissor);
+				viewportDirty = false;
+			}
+			if (vertexDirty && vertexBuffer)
+			{
+				_vk.vkCmdBindVertexBuffers(commands, 0, 1, &vertexBuffer, &vertexOffset);
+				vertexDirty = false;
+			}
+			if (indexDirty && indexBuffer)
+			{
+				_vk.vkCmdBindIndexBuffer(commands, indexBuffer, indexOffset, indexType);
+				indexDirty = false;
+			}
+
+			// Sets of the same bindings come back from the thread's set cache, empty slots point at the dummies.
+			// Getting the bound set again needs no rebind.
+			if (uniformsChanged)
+			{
+				const Buffer* dummy = _buffers.Get(_dummyBuffer);
+				VkDescriptorBufferInfo infos[MaxUniformBufferSlots];
+				for (uint32_t slot = 0; slot < MaxUniformBufferSlots; slot++)
+				{
+					infos[slot] = uniforms[slot].buffer ? uniforms[slot]
+														: VkDescriptorBufferInfo{dummy->buffer, 0, VK_WHOLE_SIZE};
+				}
+				const VkDescriptorSet set = thread.descriptors.GetSet(_uniformLayout, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+																	  infos, MaxUniformBufferSlots);
+				setsDirty = setsDirty || set != uniformSet;
+				uniformSet = set;
+				uniformsChanged = false;
+			}
+			if (texturesChanged)
+			{
+				const Texture* dummy = _textures.Get(_dummyTexture);
+				VkDescriptorImageInfo infos[MaxTextureSlots];
+				for (uint32_t slot = 0; slot < MaxTextureSlots; slot++)
+				{
+					infos[slot] = {_sampler, textures[slot] ? textures[slot] : dummy->view,
+								   VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL};
+				}
+				const VkDescriptorSet set = thread.descriptors.GetSet(
+					_textureLayout, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, infos, MaxTextureSlots);
+				setsDirty = setsDirty || set != textureSet;
+				textureSet = set;
+				texturesChanged = false;
+			}
+			if (setsDirty)
+			{
+				if (uniformSet)
+				{
+					_vk.vkCmdBindDescriptorSets(commands, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipelineLayout, 0, 1,
+												&uniformSet, 0, nullptr);
+				}
+				if (textureSet)
+				{
+					_vk.vkCmdBindDescriptorSets(commands, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipelineLayout, 1, 1,
+												&textureSet, 0, nullptr);
+				}
+				if (_bindlessTextures.IsEnabled())
+				{
+					const VkDescriptorSet bindlessSet = _bindlessTextures.GetSet();
+					_vk.vkCmdBindDescriptorSets(commands, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipelineLayout, 2, 1,
+												&bindlessSet, 0, nullptr);
+				}
+				setsDirty = false;
+			}
+
+			if (pushDirty && pipeline->pushConstantBytes > 0)
+			{
+				_vk.vkCmdPushConstants(commands, _pipelineLayout,
+									   VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0,
+									   pipeline->pushConstantBytes, pushConstants);
+				pushDirty = false;
+			}
+		};
+
+		for (uint32_t s = 0; s < count; s++)
+		{
+			Segment& segment = segments[s];
+			const Pass* pass = segment.pass >= 0 ? &_passes[segment.pass] : nullptr;
+			if (pass)
+			{
+				// Each list starts a pass, or its share of one, with the full render area
+				viewport = {0.0f, 0.0f, float(pass->extent.width), float(pass->extent.height), 0.0f, 1.0f};
+				scissor = {{0, 0}, pass->extent};
+			}
+
+			commands = VK_NULL_HANDLE;
+			if (segment.hasWork && !(pass && pass->skip))
+			{
+				commands = AcquireSecondary(thread);
+				VkCommandBufferInheritanceRenderingInfo renderingInheritance{};
+				renderingInheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+				VkCommandBufferInheritanceInfo inheritance{};
+				inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+				VkCommandBufferBeginInfo beginInfo{};
+				beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+				beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+				beginInfo.pInheritanceInfo = &inheritance;
+				if (pass)
+				{
+					renderingInheritance.colorAttachmentCount = pass->colorFormat ? 1 : 0;
+					renderingInheritance.pColorAttachmentFormats = &pass->colorFormat;
+					renderingInheritance.depthAttachmentFormat = pass->depthFormat;
+					renderingInheritance.stencilAttachmentFormat = pass->stencilFormat;
+					renderingInheritance.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+					inheritance.pNext = &renderingInheritance;
+					beginInfo.flags |= VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+				}
+				_vk.vkBeginCommandBuffer(commands, &beginInfo);
+
+				pipelineDirty = pipeline != nullptr;
+				vertexDirty = true;
+				indexDirty = true;
+				setsDirty = true;
+				viewportDirty = true;
+				pushDirty = true;
+				updated = false;
+			}
+
+			forEachCommand(list, segment.begin, segment.end, [&](const CommandHeader& header, const void* payload) {
+				switch (header.type)
+				{
+				case CommandType::SetViewport:
+				{
+					const cmd::SetViewport& c = as<cmd::SetViewport>(payload);
+					viewport = {c.x, c.y, c.width, c.height, 0.0f, 1.0f};
+					viewportDirty = true;
+					break;
+				}
+				case CommandType::SetScissor:
+				{
+					// Vulkan rejects negative offsets, clip them instead
+					const cmd::SetScissor& c = as<cmd::SetScissor>(payload);
+					const uint32_t clipX = c.x < 0 ? static_cast<uint32_t>(-c.x) : 0;
+					const uint32_t clipY = c.y < 0 ? static_cast<uint32_t>(-c.y) : 0;
+					scissor = {{std::max(c.x, 0), std::max(c.y, 0)},
+							   {c.width > clipX ? c.width - clipX : 0, c.height > clipY ? c.height - clipY : 0}};
+					viewportDirty = true;
+					break;
+				}
+				case CommandType::BindPipeline:
+					pipeline = _pipelines.Get(as<cmd::BindPipeline>(payload).pipeline);
+					assert(pipeline && "stale pipeline handle");
+					pipelineDirty = pipeline != nullptr;
+					break;
+				case CommandType::BindVertexBuffer:
+				{
+					const cmd::BindVertexBuffer& c = as<cmd::BindVertexBuffer>(payload);
+					const Buffer* buffer = _buffers.Get(c.buffer);
+					vertexBuffer = buffer ? buffer->buffer : VK_NULL_HANDLE;
+					vertexOffset = c.offset;
+					vertexDirty = true;
+					break;
+				}
+				case CommandType::BindIndexBuffer:
+				{
+					const cmd::BindIndexBuffer& c = as<cmd::BindIndexBuffer>(payload);
+					const Buffer* buffer = _buffers.Get(c.buffer);
+					indexBuffer = buffer ? buffer->buffer : VK_NULL_HANDLE;
+					indexOffset = c.offset;
+					indexType = c.type == IndexType::UInt16 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+					indexDirty = true;
+					break;
+				}
+				case CommandType::BindUniformBuffer:
+				{
+					const cmd::BindUniformBuffer& c = as<cmd::BindUniformBuffer>(payload);
+					const Buffer* buffer = _buffers.Get(c.buffer);
+					if (c.slot >= MaxUniformBufferSlots) break;
+					uniforms[c.slot] = {buffer ? buffer->buffer : VK_NULL_HANDLE, c.offset, c.size};
+					uniformsChanged = true;
+					break;
+				}
+				case CommandType::BindTexture:
+				{
+					const cmd::BindTexture& c = as<cmd::BindTexture>(payload);
+					const Texture* texture = _textures.Get(c.texture);
+					if (c.slot >= MaxTextureSlots) break;
+					textures[c.slot] = texture ? texture->view : VK_NULL_HANDLE;
+					texturesChanged = true;
+					break;
+				}
+				case CommandType::PushConstants:
+				{
+					const cmd::PushConstants& c = as<cmd::PushConstants>(payload);
+					if (c.offset > MaxPushConstantBytes || c.size > MaxPushConstantBytes - c.offset) break;
+					std::memcpy(pushConstants + c.offset, static_cast<const uint8_t*>(payload) + sizeof(c), c.size);
+					pushDirty = true;
+					break;
+				}
+				case CommandType::Draw:
+				{
+					if (!commands || !pipeline) break;
+					const cmd::Draw& c = as<cmd::Draw>(payload);
+					flushDraw();
+					_vk.vkCmdDraw(commands, c.vertexCount, c.instanceCount, c.firstVertex, c.firstInstance);
+					break;
+				}
+				case CommandType::DrawIndexed:
+				{
+					if (!commands || !pipeline) break;
+					const cmd::DrawIndexed& c = as<cmd::DrawIndexed>(payload);
+					flushDraw();
+					_vk.vkCmdDrawIndexed(commands, c.indexCount, c.instanceCount, c.firstIndex, c.vertexOffset,
+										 c.firstInstance);
+					break;
+				}
+				case CommandType::UpdateBuffer:
+				{
+					const cmd::UpdateBuffer& c = as<cmd::UpdateBuffer>(payload);
+					const Buffer* buffer = _buffers.Get(c.buffer);
+					if (!commands || !buffer) break;
+					// Back to back updates may overlap, keep them in order
+					if (updated)
+					{
+						GlobalBarrier(commands, VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+									  VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT);
+					}
+					_vk.vkCmdUpdateBuffer(commands, buffer->buffer, c.offset, c.size,
+										  static_cast<const uint8_t*>(payload) + sizeof(c));
+					updated = true;
+					break;
+				}
+				default:
+					break;
+				}
+			});
+
+			if (commands) _vk.vkEndCommandBuffer(commands);
+			segment.commands = commands;
+		}
+	}
+
+	VkCommandBuffer VulkanDevice::AcquireSecondary(ThreadContext& thread)
+	{
+		if (thread.commandBuffersUsed == thread.commandBuffers.size())
+		{
+			VkCommandBufferAllocateInfo allocateInfo{};
+			allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocateInfo.commandPool = thread.commandPool;
+			allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocateInfo.commandBufferCount = 1;
+			VkCommandBuffer commands = VK_NULL_HANDLE;
+			check(_vk.vkAllocateCommandBuffers(_device, &allocateInfo, &commands), "vkAllocateCommandBuffers");
+			thread.commandBuffers.push_back(commands);
+		}
+		return thread.commandBuffers[thread.commandBuffersUsed++];
+	}
+
+	void VulkanDevice::EndFrame()
+	{
+		FlushUploads();
+		Frame& frame = _frames[_frameIndex];
+		if (_imageAcquired)
+		{
+			VkCommandBuffer commands = BeginPrimary();
+			Texture* image = _textures.Get(_swapchainImages[_imageIndex]);
+			Transition(*image, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, false,
+					   _barriers);
+			FlushBarriers(commands, _barriers);
+			_vk.vkEndCommandBuffer(commands);
+			QueueSubmit(commands, frame.acquireWaitPending ? frame.imageAcquired : VK_NULL_HANDLE,
+						_renderFinished[_imageIndex]);
+			frame.acquireWaitPending = false;
+
+			VkPresentInfoKHR presentInfo{};
+			presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+			presentInfo.waitSemaphoreCount = 1;
+			presentInfo.pWaitSemaphores = &_renderFinished[_imageIndex];
+			presentInfo.swapchainCount = 1;
+			presentInfo.pSwapchains = &_swapchain;
+			presentInfo.pImageIndices = &_imageIndex;
+			const VkResult result = _vk.vkQueuePresentKHR(_queue, &presentInfo);
+			if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
+			{
+				_swapchainDirty = true;
+			}
+			else
+			{
+				check(result, "vkQueuePresentKHR");
+			}
+			_imageAcquired = false;
+		}
+		else if (_uploadCommands)
+		{
+			QueueSubmit(VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE);
+		}
+		frame.timelineValue = _timelineValue;
+		frame.uploadValue = _uploadValue;
+
+		_descriptorStats = {};
+		for (const ThreadContext& thread : frame.threads)
+		{
+			const DescriptorStats& stats = thread.descriptors.GetStats();
+			_descriptorStats.allocated += stats.allocated;
+			_descriptorStats.reused += stats.reused;
+			_descriptorStats.poolsCreated += stats.poolsCreated;
+			_descriptorStats.pools += stats.pools;
+		}
+		_descriptorStats.bindlessTextures = _bindlessTextures.GetCount();
+
+		// The slot about to be reused was submitted FramesInFlight frames ago
+		_frameIndex = (_frameIndex + 1) % FramesInFlight;
+		Frame& next = _frames[_frameIndex];
+		WaitTimeline(next.timelineValue);
+		PollUploads(next.uploadValue);
+		_vk.vkResetCommandPool(_device, next.commandPool, 0);
+		next.commandBuffersUsed = 0;
+		for (ThreadContext& thread : next.threads)
+		{
+			_vk.vkResetCommandPool(_device, thread.commandPool, 0);
+			thread.commandBuffersUsed = 0;
+			thread.descriptors.Reset();
+		}
+		next.stagingAllocator.Reset();
+		ReleaseRetired(next);
+		UpdateMemoryBudget();
+
+		RollFrameStats();
+	}
+
+	bool VulkanDevice::ReadTexture(TextureHandle handle, std::vector<uint8_t>& outPixels)
+	{
+		Texture* texture = _textures.Get(handle);
+		if (!texture) return false;
+
+		const uint64_t bytes = uint64_t(texture->width) * texture->height * texture->texelBytes;
+		Buffer readback;
+		if (!CreateRawBuffer(bytes, VK_BUFFER_USAGE_TRANSFER_DST_BIT, MemoryUsage::Readback, readback)) return false;
+
+		VkCommandBuffer commands = BeginPrimary();
+		Transition(*texture, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+				   VK_ACCESS_2_TRANSFER_READ_BIT, false, _barriers);
+		FlushBarriers(commands, _barriers);
+		// Depth only, the stencil of combined formats would need its own copy
+		VkImageAspectFlags aspect = texture->aspect;
+		if (aspect & VK_IMAGE_ASPECT_DEPTH_BIT) aspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+		VkBufferImageCopy copy{};
+		copy.imageSubresource = {aspect, 0, 0, 1};
+		copy.imageExtent = {texture->width, texture->height, 1};
+		_vk.vkCmdCopyImageToBuffer(commands, texture->image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback.buffer, 1,
+								   &copy);
+		_vk.vkEndCommandBuffer(commands);
+		WaitTimeline(QueueSubmit(commands, VK_NULL_HANDLE, VK_NULL_HANDLE));
+
+		outPixels.assign(readback.mapped, readback.mapped + bytes);
+		_vk.vkDestroyBuffer(_device, readback.buffer, nullptr);
+		_memory.Free(readback.allocation);
+		return true;
+	}
+
+	bool VulkanDevice::UploadBuffer(BufferHandle buffer, uint64_t offset, const void* data, uint64_t bytes,
+									UploadTicket& outTicket)
+	{
+		const Buffer* target = _buffers.Get(buffer);
+		if (!_uploadStaging.buffer || !target || !data || bytes == 0) return false;
+		if (offset > target->bytes || bytes > target->bytes - offset) return false;
+
+		// Chunks of a quarter ring, a big upload waits for a part of the ring at a time instead of all of it
+		const uint64_t chunkBytes = _uploadRing.GetSize() / 4;
+		const uint8_t* source = static_cast<const uint8_t*>(data);
+		for (uint64_t done = 0; done < bytes;)
+		{
+			const uint64_t size = std::min(bytes - done, chunkBytes);
+			uint64_t staging;
+			if (!StageUpload(source + done, size, staging)) return false;
+			const VkBufferCopy copy{staging, offset + done, size};
+			_vk.vkCmdCopyBuffer(GetTransferCommands(), _uploadStaging.buffer, target->buffer, 1, &copy);
+			done += size;
+		}
+		_stats.uploadBytes += bytes;
+		outTicket = UploadTicket{_uploadValue + 1};
+		return true;
+	}
+
+	bool VulkanDevice::UploadTexture(TextureHandle texture, uint32_t level, const void* data, UploadTicket& outTicket)
+	{
+		// Copies start at texel multiples and the ring only aligns to powers of two
+		Texture* target = _textures.Get(texture);
+		if (!_uploadStaging.buffer || !target || !target->uploadable || !data || level >= target->levels) return false;
+		if (target->texelBytes & (target->texelBytes - 1)) return false;
+
+		// Whole rows per chunk
+		const uint32_t width = std::max(target->width >> level, 1u);
+		const uint32_t height = std::max(target->height >> level, 1u);
+		const uint64_t rowBytes = uint64_t(width) * target->texelBytes;
+		const uint64_t chunkBytes = _uploadRing.GetSize() / 4;
+		if (rowBytes > chunkBytes) return false;
+
+		// Barriers on the upload queue, after the graphics work its batch waits for. The texture stays in
+		// transfer layout across batches until the last row is in.
+		VkImageMemoryBarrier2 barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+		barrier.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+		barrier.dstStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+		barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+		barrier.oldLayout = target->layout;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = target->image;
+		barrier.subresourceRange = {target->aspect, 0, VK_REMAINING_MIP_LEVELS, 0, 1};
+		VkDependencyInfo dependency{};
+		dependency.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+		dependency.imageMemoryBarrierCount = 1;
+		dependency.pImageMemoryBarriers = &barrier;
+		_vk.vkCmdPipelineBarrier2(GetTransferCommands(), &dependency);
+
+		bool staged = true;
+		const uint32_t chunkRows = static_cast<uint32_t>(std::min<uint64_t>(height, chunkBytes / rowBytes));
+		const uint8_t* source = static_cast<const uint8_t*>(data);
+		for (uint32_t row = 0; row < height && staged; row += chunkRows)
+		{
+			const uint32_t rows = std::min(chunkRows, height - row);
+			uint64_t staging;
+			staged = StageUpload(source + row * rowBytes, rows * rowBytes, staging);
+			if (!staged) break;
+			VkBufferImageCopy copy{};
+			copy.bufferOffset = staging;
+			copy.imageSubresource = {target->aspect, level, 0, 1};
+			copy.imageOffset = {0, static_cast<int32_t>(row), 0};
+			copy.imageExtent = {width, rows, 1};
+			_vk.vkCmdCopyBufferToImage(GetTransferCommands(), _uploadStaging.buffer, target->image,
+									   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy);
+		}
+
+		// Completion, and the semaphore wait of later submissions, is what orders draws after it
+		barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+		barrier.dstStageMask = VK_PIPELINE_STAGE_2_NONE;
+		barrier.dstAccessMask = VK_ACCESS_2_NONE;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
+		_vk.vkCmdPipelineBarrier2(GetTransferCommands(), &dependency);
+		target->layout = VK_IMAGE_LAYOUT_READ_ONLY_OPTIMAL;
+		target->stage = VK_PIPELINE_STAGE_2_NONE;
+		target->access = VK_ACCESS_2_NONE;
+		if (!staged) return false;
+
+		_stats.uploadBytes += rowBytes * height;
+		outTicket = UploadTicket{_uploadValue + 1};
+		return true;
+	}
+
+	bool VulkanDevice::IsUploadComplete(UploadTicket ticket)
+	{
+		if (ticket.value > _uploadCompleted) PollUploads();
+		return ticket.value <= _uploadCompleted;
+	}
+
+	void VulkanDevice::FlushUploads()
+	{
+		if (!_transferCommands) return;
+
+		// The batch waits for all graphics work so far, the pending upload commands included: draws reading
+		// what it overwrites, and layouts set by texture creation
+		if (_uploadCommands) QueueSubmit(VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE);
+		_vk.vkEndCommandBuffer(_transferCommands);
+
+		const VkCommandBufferSubmitInfo commandInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO, nullptr,
+													_transferCommands, 0};
+		VkSemaphoreSubmitInfo waitInfo{};
+		waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+		waitInfo.semaphore = _timeline;
+		waitInfo.value = _timelineValue;
+		waitInfo.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+		VkSemaphoreSubmitInfo signalInfo{};
+		signalInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+		signalInfo.semaphore = _uploadTimeline;
+		signalInfo.value = ++_uploadValue;
+		signalInfo.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+		VkSubmitInfo2 submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
+		submitInfo.waitSemaphoreInfoCount = _timelineValue > 0 ? 1 : 0;
+		submitInfo.pWaitSemaphoreInfos = &waitInfo;
+		submitInfo.commandBufferInfoCount = 1;
+		submitInfo.pCommandBufferInfos = &commandInfo;
+		submitInfo.signalSemaphoreInfoCount = 1;
+		submitInfo.pSignalSemaphoreInfos = &signalInfo;
+		check(_vk.vkQueueSubmit2(_transferQueue, 1, &submitInfo, VK_NULL_HANDLE), "vkQueueSubmit2");
+
+		_uploadBatches.push_back(UploadBatch{_transferCommands, _uploadValue});
+		_transferCommands = VK_NULL_HANDLE;
+		_uploadRing.Close(_uploadValue);
+	}
+
+	VkCommandBuffer VulkanDevice::GetTransferCommands()
+	{
+		if (_transferCommands) return _transferCommands;
+		if (_freeTransferCommands.empty())
+		{
+			VkCommandBufferAllocateInfo allocateInfo{};
+			allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocateInfo.commandPool = _transferPool;
+			allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocateInfo.commandBufferCount = 1;
+			VkCommandBuffer commands = VK_NULL_HANDLE;
+			check(_vk.vkAllocateCommandBuffers(_device, &allocateInfo, &commands), "vkAllocateCommandBuffers");
+			_freeTransferCommands.push_back(commands);
+		}
+
+		// Beginning resets it, the pool allows that
+		_transferCommands = _freeTransferCommands.back();
+		_freeTransferCommands.pop_back();
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		_vk.vkBeginCommandBuffer(_transferCommands, &beginInfo);
+		return _transferCommands;
+	}
+
+	bool VulkanDevice::StageUpload(const void* data, uint64_t bytes, uint64_t& outOffset)
+	{
+		// Buffer copies want 4 byte offsets, texel copies the texel size
+		while (!_uploadRing.Allocate(bytes, 16, outOffset))
+		{
+			// Full of batches in flight: send the open one off and wait for the oldest
+			FlushUploads();
+			const uint64_t oldest = _uploadRing.GetOldestPending();
+			if (oldest == 0) return false;
+			_stats.uploadStalls++;
+			PollUploads(oldest);
+		}
+		std::memcpy(_uploadStaging.mapped + outOffset, data, bytes);
+		return true;
+	}
+
+	void VulkanDevice::PollUploads(uint64_t wait)
+	{
+		if (wait > _uploadCompleted)
+		{
+			VkSemaphoreWaitInfo waitInfo{};
+			waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+			waitInfo.semaphoreCount = 1;
+			waitInfo.pSemaphores = &_uploadTimeline;
+			waitInfo.pValues = &wait;
+			check(_vk.vkWaitSemaphores(_device, &waitInfo, UINT64_MAX), "vkWaitSemaphores");
+		}
+		_vk.vkGetSemaphoreCounterValue(_device, _uploadTimeline, &_uploadCompleted);
+		while (!_uploadBatches.empty() && _uploadBatches.front().value <= _uploadCompleted)
+		{
+			_freeTransferCommands.push_back(_uploadBatches.front().commands);
+			_uploadBatches.pop_front();
+		}
+		_uploadRing.Release(_uploadCompleted);
+	}
+
+	uint32_t VulkanDevice::Defragment(uint32_t maxMoves)
+	{
+		_memory.PlanDefragmentation(maxMoves, _moves);
+		if (_moves.empty()) return 0;
+
+		// Pending uploads copy into the buffers about to move
+		FlushUploads();
+		PollUploads(_uploadValue);
+
+		// Submitted work may still write the buffers about to be copied
+		VkCommandBuffer commands = GetUploadCommands();
+		GlobalBarrier(commands, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_ACCESS_2_MEMORY_WRITE_BIT,
+					  VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT);
+
+		uint32_t moved = 0;
+		for (const MemoryMove& move : _moves)
+		{
+			// Destroyed buffers keep their memory until released, there is nothing left to move then
+			Buffer* buffer = _buffers.Get(BufferHandle::FromRaw(static_cast<uint32_t>(move.userData)));
+			VkBuffer target = VK_NULL_HANDLE;
+			VkBufferCreateInfo bufferInfo{};
+			bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			bufferInfo.size = buffer ? buffer->bytes : 0;
+			bufferInfo.usage = buffer ? buffer->usage : 0;
+			setSharing(bufferInfo, _queueFamilies);
+			if (!buffer || !check(_vk.vkCreateBuffer(_device, &bufferInfo, nullptr, &target), "vkCreateBuffer"))
+			{
+				_memory.Free(move.to);
+				continue;
+			}
+			_vk.vkBindBufferMemory(_device, target, move.to.memory, move.to.offset);
+			const VkBufferCopy copy{0, 0, buffer->bytes};
+			_vk.vkCmdCopyBuffer(commands, buffer->buffer, target, 1, &copy);
+
+			// Lists resolve handles when submitted, later draws see the new buffer
+			Retire(Retired{buffer->buffer, VK_NULL_HANDLE, VK_NULL_HANDLE, move.from, VK_NULL_HANDLE});
+			buffer->buffer = target;
+			buffer->allocation = move.to;
+			buffer->mapped = move.to.mapped;
+			moved++;
+		}
+		return moved;
+	}
+
+} // namespace gefx
@@ -0,0 +1,457 @@
+#ifndef __VKDEVICE__H__
+#define __VKDEVICE__H__
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan_core.h>
+
+#include <core/containers/flathashmap.h>
+#include <core/containers/handlepool.h>
+#include <core/jobs.h>
+#include <rendering/device/device.h>
+#include <rendering/device/uploadring.h>
+#include <rendering/device/vkdescriptors.h>
+#include <rendering/device/vkfunctions.h>
+#include <rendering/device/vkmemory.h>
+#include <rendering/device/vkpipelinecache.h>
+
+namespace gefx
+{
+	struct VulkanDeviceConfig
+	{
+		// Records the lists of a Submit in parallel, one job per list. Null records them on the calling thread.
+		// Submitting from a thread other than the one driving the job system needs JobSystem::AttachThread.
+		JobSystem* jobs{nullptr};
+		// Khronos validation layer and debug messages, when installed
+		bool validation{false};
+
+		// Window system integration: the instance extensions the surface needs and a callback creating it.
+		// Without createSurface back buffer passes render to an offscreen texture, see GetBackBuffer.
+		std::vector<const char*> instanceExtensions;
+		std::function<VkSurfaceKHR(VkInstance, PFN_vkGetInstanceProcAddr)> createSurface;
+		uint32_t backBufferWidth{1280};
+		uint32_t backBufferHeight{720};
+		bool vsync{true};
+
+		// Pipeline cache file, loaded here and written on Shutdown. Empty keeps the cache in memory only.
+		std::string pipelineCachePath;
+		// Bindless texture set when the device supports descriptor indexing, see GetBindlessIndex
+		bool bindless{true};
+		// Staging ring of UploadBuffer and UploadTexture, uploads bigger than a quarter of it go in parts
+		uint64_t uploadRingBytes{32ull << 20};
+	};
+
+	struct PipelineCacheStats
+	{
+		// Compiled when CreatePipeline asked for them
+		uint32_t compiled{0};
+		// CreatePipeline calls answered with an existing pipeline
+		uint32_t shared{0};
+		// Compiled in the background from the pipeline cache file before being asked for
+		uint32_t precompiled{0};
+	};
+
+	/**
+	 * @brief Vulkan 1.3 device using dynamic rendering and synchronization2, loaded at runtime.
+	 *
+	 * Submit splits the lists into segments at render pass boundaries, then records every list into secondary
+	 * command buffers in its own job, from the command pool of the thread running it (JobSystem thread index);
+	 * a render pass continued across lists is therefore recorded by several threads at once. The calling
+	 * thread then only stitches the segments together in one primary command buffer: image layout barriers
+	 * from the prescan, render pass begin and end, and barriers around buffer updates.
+	 *
+	 * One timeline semaphore orders everything: each queue submission signals the next value and a frame
+	 * slot remembers the last one, so reusing the slot's pools FramesInFlight frames later waits for exactly
+	 * that value. Destroyed objects are released the same way.
+	 *
+	 * Uniform buffers and textures live in descriptor sets 0 and 1, with layouts from DescriptorLayoutCache.
+	 * Sets are written while recording by the recording thread's DescriptorAllocator of the frame slot, which
+	 * hands out the same set again for the same resources and resets its pools with the slot. With descriptor
+	 * indexing, sampled textures also get a slot in the bindless set 2, see GetBindlessIndex.
+	 *
+	 * Resources are suballocated from large device memory blocks by DeviceMemoryAllocator, within the heap
+	 * budgets VK_EXT_memory_budget reports. Upload data goes through a per frame staging buffer.
+	 *
+	 * Asynchronous uploads run on a queue of their own (a transfer only family when the device has one) out
+	 * of an UploadRing staging buffer, with their own timeline semaphore: a batch waits for the graphics work
+	 * submitted before it and signals the next upload value, and graphics submissions wait for the uploads
+	 * seen complete so their writes are visible. Resources the upload queue writes are shared by both queue
+	 * families rather than changing owner.
+	 *
+	 * Pipelines are identified by hashPipelineDesc: creating an existing one returns the same handle with one
+	 * more reference, and Destroy drops one. A hash match only counts once the descriptions compare equal. They
+	 * compile through a VkPipelineCache persisted to VulkanDeviceConfig::pipelineCachePath, together with the
+	 * descriptions created in the session, which the next session precompiles on the job system.
+	 */
+	class VulkanDevice final : public IDevice, private IMemoryBackend
+	{
+	  public:
+		static constexpr uint32_t FramesInFlight = 2;
+		static constexpr uint32_t BindlessTextureCapacity = 4096;
+		// Staging buffer of each frame slot, bigger uploads get a staging buffer of their own
+		static constexpr uint64_t StagingBytes = 4ull << 20;
+
+		VulkanDevice() = default;
+		~VulkanDevice() override = default;
+
+		VulkanDevice(VulkanDevice&&) = delete;
+		VulkanDevice(const VulkanDevice&) = delete;
+		VulkanDevice& operator=(VulkanDevice&&) = delete;
+		VulkanDevice& operator=(const VulkanDevice&) = delete;
+
+		/**
+		 * @brief Load Vulkan, create the instance, device and the device's own objects. False when there is no
+		 * Vulkan 1.3 capable device, the device can't be used then.
+		 */
+		bool Initialize(const VulkanDeviceConfig& config);
+
+		/**
+		 * @brief Wait for the GPU and release everything.
+		 */
+		void Shutdown();
+
+		DeviceBackend GetBackend() const override { return DeviceBackend::Vulkan; };
+		Format GetBackBufferFormat() const override { return _backBufferFormat; };
+
+		BufferHandle CreateBuffer(const BufferDesc& desc, const void* data = nullptr) override;
+		TextureHandle CreateTexture(const TextureDesc& desc) override;
+		PipelineHandle CreatePipeline(const PipelineDesc& desc) override;
+
+		void Destroy(BufferHandle handle) override;
+		void Destroy(TextureHandle handle) override;
+		void Destroy(PipelineHandle handle) override;
+
+		using IDevice::Submit;
+		void Submit(rv::Span<const CommandList* const> lists) override;
+		void EndFrame() override;
+
+		/**
+		 * @brief Size of the back buffer, the swapchain is recreated before its next use.
+		 */
+		void Resize(uint32_t width, uint32_t height);
+
+		/**
+		 * @brief Texture back buffer passes render to: the offscreen one, or the swapchain image acquired for
+		 * the current frame (null before the frame's first back buffer pass).
+		 */
+		TextureHandle GetBackBuffer() const;
+
+		/**
+		 * @brief Copy the first level of a texture to the CPU, rows from the top. Waits for the GPU, for tests
+		 * and tools only.
+		 */
+		bool ReadTexture(TextureHandle handle, std::vector<uint8_t>& outPixels);
+
+		bool UploadBuffer(BufferHandle buffer, uint64_t offset, const void* data, uint64_t bytes,
+						  UploadTicket& outTicket) override;
+		bool UploadTexture(TextureHandle texture, uint32_t level, const void* data, UploadTicket& outTicket) override;
+		bool IsUploadComplete(UploadTicket ticket) override;
+		void FlushUploads() override;
+
+		/**
+		 * @brief Whether uploads have a queue family of their own, otherwise they share the graphics family.
+		 */
+		bool HasTransferFamily() const { return _transferFamily != _queueFamily; };
+
+		/**
+		 * @brief Move up to maxMoves device local buffers out of the least used memory blocks, so the blocks
+		 * can be released. The copies run ahead of the next submission and the old memory is freed with this
+		 * frame. Returns the number of buffers moved.
+		 */
+		uint32_t Defragment(uint32_t maxMoves);
+
+		const DeviceMemoryAllocator& GetMemory() const { return _memory; };
+		const PipelineCacheStats& GetPipelineCacheStats() const { return _pipelineCacheStats; };
+
+		/**
+		 * @brief Descriptor totals of the last frame closed by EndFrame, all threads together.
+		 */
+		const DescriptorStats& GetDescriptorStats() const { return _descriptorStats; };
+
+		/**
+		 * @brief Whether pipelines see the bindless texture set: set 2, binding 0, an array of
+		 * BindlessTextureCapacity combined image samplers indexed with GetBindlessIndex.
+		 */
+		bool HasBindless() const { return _bindlessTextures.IsEnabled(); };
+
+		/**
+		 * @brief Slot of a sampled texture in the bindless set, BindlessTextureTable::InvalidIndex without one.
+		 * Handed to shaders through uniforms or push constants.
+		 */
+		uint32_t GetBindlessIndex(TextureHandle handle) const;
+
+	  private:
+		struct Buffer
+		{
+			VkBuffer buffer;
+			MemoryAllocation allocation;
+			uint8_t* mapped;
+			uint64_t bytes;
+			// Defragmentation recreates the buffer with them
+			VkBufferUsageFlags usage;
+		};
+
+		struct Texture
+		{
+			VkImage image;
+			VkImageView view;
+			MemoryAllocation allocation;
+			VkFormat format;
+			VkImageAspectFlags aspect;
+			uint32_t width;
+			uint32_t height;
+			uint32_t texelBytes;
+			// Swapchain images belong to the swapchain
+			bool owned;
+
+			// Last use, the next one barriers against it
+			VkImageLayout layout;
+			VkPipelineStageFlags2 stage;
+			VkAccessFlags2 access;
+
+			uint32_t bindless{BindlessTextureTable::InvalidIndex};
+			uint32_t levels{1};
+			// Sampled textures, the only ones uploads write
+			bool uploadable{false};
+		};
+
+		struct Pipeline
+		{
+			VkPipeline pipeline;
+			uint32_t pushConstantBytes;
+			uint64_t hash;
+			uint32_t references;
+		};
+
+		// A pipeline of the cache file, compiled by a job unless CreatePipeline takes it first
+		struct Precompiled
+		{
+			enum State : uint32_t
+			{
+				Queued,
+				Compiling,
+				Ready,
+				Taken,
+			};
+
+			std::atomic<uint32_t> state{Queued};
+			VkPipeline pipeline{VK_NULL_HANDLE};
+		};
+
+		// Objects released once the frame slot they were destroyed in comes around again
+		struct Retired
+		{
+			VkBuffer buffer;
+			VkImage image;
+			VkImageView view;
+			MemoryAllocation allocation;
+			VkPipeline pipeline;
+			uint32_t bindless{BindlessTextureTable::InvalidIndex};
+		};
+
+		struct ThreadContext
+		{
+			VkCommandPool commandPool;
+			std::vector<VkCommandBuffer> commandBuffers;
+			uint32_t commandBuffersUsed;
+			DescriptorAllocator descriptors;
+		};
+
+		// Upload commands submitted on the transfer queue, recycled once the upload timeline reaches value
+		struct UploadBatch
+		{
+			VkCommandBuffer commands;
+			uint64_t value;
+		};
+
+		struct Frame
+		{
+			uint64_t timelineValue;
+			// Uploads flushed by the frame, they may copy into objects the frame destroyed
+			uint64_t uploadValue;
+			VkCommandPool commandPool;
+			std::vector<VkCommandBuffer> commandBuffers;
+			uint32_t commandBuffersUsed;
+			std::vector<ThreadContext> threads;
+			std::vector<Retired> retired;
+			Buffer staging;
+			LinearAllocator stagingAllocator;
+			VkSemaphore imageAcquired;
+			bool acquireWaitPending;
+		};
+
+		// Render pass of the Submit being translated
+		struct Pass
+		{
+			RenderPassDesc desc;
+			TextureHandle color;
+			VkExtent2D extent;
+			VkFormat colorFormat;
+			VkFormat depthFormat;
+			VkFormat stencilFormat;
+			// Textures bound by draws of the pass, moved to shader read before it begins
+			std::vector<TextureHandle> sampled;
+			bool skip;
+		};
+
+		// Commands of one list between render pass boundaries, recorded into one secondary command buffer
+		struct Segment
+		{
+			uint32_t list;
+			uint32_t begin;
+			uint32_t end;
+			int32_t pass;
+			bool beginsPass;
+			bool endsPass;
+			bool hasWork;
+			bool updates;
+			VkCommandBuffer commands;
+		};
+
+		bool CreateInstance(const VulkanDeviceConfig& config);
+		bool CreateDevice();
+		bool CreateSwapchain();
+		void DestroySwapchain();
+		bool CreateOffscreenBackBuffer();
+		// Swapchain image for this frame, acquired on first use
+		TextureHandle AcquireBackBuffer();
+
+		bool AllocateBlock(uint32_t memoryType, uint64_t size, VkDeviceMemory& outMemory,
+						   uint8_t*& outMapped) override;
+		void FreeBlock(uint32_t memoryType, VkDeviceMemory memory) override;
+		// Budgets left to the allocator: the heap's budget minus what the rest of the process and system use
+		void UpdateMemoryBudget();
+
+		bool CreateRawBuffer(uint64_t bytes, VkBufferUsageFlags usage, MemoryUsage memoryUsage, Buffer& outBuffer);
+		// Copy data to staging memory alive until this frame slot comes around again
+		bool Stage(const void* data, uint64_t bytes, VkBuffer& outBuffer, uint64_t& outOffset);
+		void Retire(const Retired& retired);
+		void ReleaseRetired(Frame& frame);
+
+		// Thread safe, precompile jobs run it
+		VkPipeline CompilePipeline(const PipelineDesc& desc);
+		void PrecompilePipelines();
+		// The precompiled pipeline for desc, null when there is none and the caller has to compile it
+		VkPipeline TakePrecompiled(const PipelineDesc& desc, uint64_t hash);
+		void SavePipelineCache();
+
+		VkCommandBuffer BeginPrimary();
+		// Upload commands recorded by resource creation, run before the next submission
+		VkCommandBuffer GetUploadCommands();
+		// Submit primaries, signal the next timeline value and return it
+		uint64_t QueueSubmit(VkCommandBuffer commands, VkSemaphore wait, VkSemaphore signal);
+		void WaitTimeline(uint64_t value);
+
+		// Open command buffer of the upload batch
+		VkCommandBuffer GetTransferCommands();
+		// Copy data into the upload ring, waiting for the oldest batches while it is full
+		bool StageUpload(const void* data, uint64_t bytes, uint64_t& outOffset);
+		// Recycle the batches the upload timeline reached, wait for value first when it is not zero
+		void PollUploads(uint64_t wait = 0);
+
+		// Barrier moving a texture to a new use, appended to barriers. Discard drops the current content.
+		void Transition(Texture& texture, VkImageLayout layout, VkPipelineStageFlags2 stage, VkAccessFlags2 access,
+						bool discard, std::vector<VkImageMemoryBarrier2>& barriers);
+		void FlushBarriers(VkCommandBuffer commands, std::vector<VkImageMemoryBarrier2>& barriers);
+		void GlobalBarrier(VkCommandBuffer commands, VkPipelineStageFlags2 srcStage, VkAccessFlags2 srcAccess,
+						   VkPipelineStageFlags2 dstStage, VkAccessFlags2 dstAccess);
+
+		void Prescan(rv::Span<const CommandList* const> lists);
+		void Record(const CommandList& list, Segment* segments, uint32_t count);
+		VkCommandBuffer AcquireSecondary(ThreadContext& thread);
+
+		VulkanFunctions _vk;
+		JobSystem* _jobs{nullptr};
+		VkInstance _instance{VK_NULL_HANDLE};
+		VkDebugUtilsMessengerEXT _messenger{VK_NULL_HANDLE};
+		VkSurfaceKHR _surface{VK_NULL_HANDLE};
+		VkPhysicalDevice _physicalDevice{VK_NULL_HANDLE};
+		VkPhysicalDeviceMemoryProperties _memoryProperties{};
+		bool _memoryBudget{false};
+		VkDevice _device{VK_NULL_HANDLE};
+		VkQueue _queue{VK_NULL_HANDLE};
+		uint32_t _queueFamily{0};
+		// May be _queue itself
+		VkQueue _transferQueue{VK_NULL_HANDLE};
+		uint32_t _transferFamily{0};
+		// Graphics and transfer family, what shared resources list
+		uint32_t _queueFamilies[2]{};
+		VkFormat _depthStencilFormat{VK_FORMAT_D32_SFLOAT_S8_UINT};
+
+		VkSemaphore _timeline{VK_NULL_HANDLE};
+		uint64_t _timelineValue{0};
+		Frame _frames[FramesInFlight]{};
+		uint32_t _frameIndex{0};
+		VkCommandBuffer _uploadCommands{VK_NULL_HANDLE};
+
+		VkSemaphore _uploadTimeline{VK_NULL_HANDLE};
+		// Last upload value submitted, and the last one the CPU saw the GPU reach
+		uint64_t _uploadValue{0};
+		uint64_t _uploadCompleted{0};
+		VkCommandPool _transferPool{VK_NULL_HANDLE};
+		VkCommandBuffer _transferCommands{VK_NULL_HANDLE};
+		std::deque<UploadBatch> _uploadBatches;
+		std::vector<VkCommandBuffer> _freeTransferCommands;
+		Buffer _uploadStaging{};
+		UploadRing _uploadRing;
+
+		DescriptorLayoutCache _descriptorLayouts;
+		BindlessTextureTable _bindlessTextures;
+		// Asked for by the config and supported by the device
+		bool _bindless{false};
+		DescriptorStats _descriptorStats;
+		VkDescriptorSetLayout _uniformLayout{VK_NULL_HANDLE};
+		VkDescriptorSetLayout _textureLayout{VK_NULL_HANDLE};
+		VkPipelineLayout _pipelineLayout{VK_NULL_HANDLE};
+		VkSampler _sampler{VK_NULL_HANDLE};
+		// Bound to the slots a draw leaves empty
+		BufferHandle _dummyBuffer;
+		TextureHandle _dummyTexture;
+
+		rv::HandlePool<BufferTag, Buffer> _buffers;
+		rv::HandlePool<TextureTag, Texture> _textures;
+		rv::HandlePool<PipelineTag, Pipeline> _pipelines;
+
+		DeviceMemoryAllocator _memory;
+		std::vector<MemoryMove> _moves;
+
+		VkPipelineCache _pipelineCache{VK_NULL_HANDLE};
+		std::string _pipelineCachePath;
+		rv::FlatHashMap<uint64_t, PipelineHandle> _pipelineLookup;
+		// Pipelines created this session, saved for the next one
+		PipelineCacheFile _pipelineRecord;
+		// Last session's pipelines, owns the SPIR-V the precompile jobs read
+		PipelineCacheFile _precompileFile;
+		std::unique_ptr<Precompiled[]> _precompiled;
+		rv::FlatHashMap<uint64_t, uint32_t> _precompiledLookup;
+		JobCounter _precompileCounter;
+		PipelineCacheStats _pipelineCacheStats;
+
+		VkSwapchainKHR _swapchain{VK_NULL_HANDLE};
+		std::vector<TextureHandle> _swapchainImages;
+		std::vector<VkSemaphore> _renderFinished;
+		uint32_t _imageIndex{0};
+		bool _imageAcquired{false};
+		bool _swapchainDirty{false};
+		bool _vsync{true};
+		TextureHandle _backBuffer;
+		Format _backBufferFormat{Format::RGBA8Unorm};
+		uint32_t _backBufferWidth{0};
+		uint32_t _backBufferHeight{0};
+
+		// Scratch of the Submit being translated
+		std::vector<Pass> _passes;
+		std::vector<Segment> _segments;
+		std::vector<uint32_t> _listSegments;
+		std::vector<VkImageMemoryBarrier2> _barriers;
+	};
+
+} // namespace gefx
+
+#endif //!__VKDEVICE__H__
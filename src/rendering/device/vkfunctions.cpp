@@ -0,0 +1,74 @@
+// Platform Includes
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+// Application Specific Includes
+#include <rendering/device/vkfunctions.h>
+
+namespace gefx
+{
+	bool VulkanFunctions::Load()
+	{
+#if defined(_WIN32)
+		HMODULE module = LoadLibraryA("vulkan-1.dll");
+		library = module;
+		if (module)
+		{
+			vkGetInstanceProcAddr =
+				reinterpret_cast<PFN_vkGetInstanceProcAddr>(GetProcAddress(module, "vkGetInstanceProcAddr"));
+		}
+#else
+		library = dlopen("libvulkan.so.1", RTLD_NOW | RTLD_LOCAL);
+		if (!library) library = dlopen("libvulkan.so", RTLD_NOW | RTLD_LOCAL);
+		if (library)
+		{
+			vkGetInstanceProcAddr =
+				reinterpret_cast<PFN_vkGetInstanceProcAddr>(dlsym(library, "vkGetInstanceProcAddr"));
+		}
+#endif
+		if (!vkGetInstanceProcAddr)
+		{
+			Unload();
+			return false;
+		}
+
+#define GEFX_VK_LOAD_FUNCTION(name) name = reinterpret_cast<PFN_##name>(vkGetInstanceProcAddr(nullptr, #name));
+		GEFX_VK_GLOBAL_FUNCTIONS(GEFX_VK_LOAD_FUNCTION)
+#undef GEFX_VK_LOAD_FUNCTION
+		return vkCreateInstance != nullptr;
+	}
+
+	void VulkanFunctions::LoadInstance(VkInstance instance)
+	{
+#define GEFX_VK_LOAD_FUNCTION(name) name = reinterpret_cast<PFN_##name>(vkGetInstanceProcAddr(instance, #name));
+		GEFX_VK_INSTANCE_FUNCTIONS(GEFX_VK_LOAD_FUNCTION)
+#undef GEFX_VK_LOAD_FUNCTION
+	}
+
+	void VulkanFunctions::LoadDevice(VkDevice device)
+	{
+		// Straight from the driver, skipping the loader's dispatch
+#define GEFX_VK_LOAD_FUNCTION(name) name = reinterpret_cast<PFN_##name>(vkGetDeviceProcAddr(device, #name));
+		GEFX_VK_DEVICE_FUNCTIONS(GEFX_VK_LOAD_FUNCTION)
+#undef GEFX_VK_LOAD_FUNCTION
+	}
+
+	void VulkanFunctions::Unload()
+	{
+		if (library)
+		{
+#if defined(_WIN32)
+			FreeLibrary(static_cast<HMODULE>(library));
+#else
+			dlclose(library);
+#endif
+		}
+		*this = VulkanFunctions{};
+	}
+
+} // namespace gefx
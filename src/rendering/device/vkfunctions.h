@@ -0,0 +1,131 @@
+#ifndef __VKFUNCTIONS__H__
+#define __VKFUNCTIONS__H__
+
+#include <vulkan/vulkan_core.h>
+
+// Entry points by the object they are loaded from. Extension functions stay null when the extension is missing.
+#define GEFX_VK_GLOBAL_FUNCTIONS(X)                                                                                    \
+	X(vkCreateInstance)                                                                                                \
+	X(vkEnumerateInstanceExtensionProperties)                                                                          \
+	X(vkEnumerateInstanceLayerProperties)                                                                              \
+	X(vkEnumerateInstanceVersion)
+
+#define GEFX_VK_INSTANCE_FUNCTIONS(X)                                                                                  \
+	X(vkDestroyInstance)                                                                                               \
+	X(vkEnumeratePhysicalDevices)                                                                                      \
+	X(vkEnumerateDeviceExtensionProperties)                                                                            \
+	X(vkGetPhysicalDeviceProperties)                                                                                   \
+	X(vkGetPhysicalDeviceFeatures2)                                                                                    \
+	X(vkGetPhysicalDeviceQueueFamilyProperties)                                                                        \
+	X(vkGetPhysicalDeviceMemoryProperties)                                                                             \
+	X(vkGetPhysicalDeviceMemoryProperties2)                                                                            \
+	X(vkGetPhysicalDeviceFormatProperties)                                                                             \
+	X(vkCreateDevice)                                                                                                  \
+	X(vkGetDeviceProcAddr)                                                                                             \
+	X(vkDestroySurfaceKHR)                                                                                             \
+	X(vkGetPhysicalDeviceSurfaceSupportKHR)                                                                            \
+	X(vkGetPhysicalDeviceSurfaceCapabilitiesKHR)                                                                       \
+	X(vkGetPhysicalDeviceSurfaceFormatsKHR)                                                                            \
+	X(vkGetPhysicalDeviceSurfacePresentModesKHR)                                                                       \
+	X(vkCreateDebugUtilsMessengerEXT)                                                                                  \
+	X(vkDestroyDebugUtilsMessengerEXT)
+
+#define GEFX_VK_DEVICE_FUNCTIONS(X)                                                                                    \
+	X(vkDestroyDevice)                                                                                                 \
+	X(vkGetDeviceQueue)                                                                                                \
+	X(vkDeviceWaitIdle)                                                                                                \
+	X(vkQueueSubmit2)                                                                                                  \
+	X(vkCreateSemaphore)                                                                                               \
+	X(vkDestroySemaphore)                                                                                              \
+	X(vkWaitSemaphores)                                                                                                \
+	X(vkGetSemaphoreCounterValue)                                                                                      \
+	X(vkCreateCommandPool)                                                                                             \
+	X(vkDestroyCommandPool)                                                                                            \
+	X(vkResetCommandPool)                                                                                              \
+	X(vkAllocateCommandBuffers)                                                                                        \
+	X(vkBeginCommandBuffer)                                                                                            \
+	X(vkEndCommandBuffer)                                                                                              \
+	X(vkCreateBuffer)                                                                                                  \
+	X(vkDestroyBuffer)                                                                                                 \
+	X(vkGetBufferMemoryRequirements)                                                                                   \
+	X(vkBindBufferMemory)                                                                                              \
+	X(vkCreateImage)                                                                                                   \
+	X(vkDestroyImage)                                                                                                  \
+	X(vkGetImageMemoryRequirements)                                                                                    \
+	X(vkBindImageMemory)                                                                                               \
+	X(vkCreateImageView)                                                                                               \
+	X(vkDestroyImageView)                                                                                              \
+	X(vkAllocateMemory)                                                                                                \
+	X(vkFreeMemory)                                                                                                    \
+	X(vkMapMemory)                                                                                                     \
+	X(vkUnmapMemory)                                                                                                   \
+	X(vkCreateSampler)                                                                                                 \
+	X(vkDestroySampler)                                                                                                \
+	X(vkCreateShaderModule)                                                                                            \
+	X(vkDestroyShaderModule)                                                                                           \
+	X(vkCreatePipelineLayout)                                                                                          \
+	X(vkDestroyPipelineLayout)                                                                                         \
+	X(vkCreateGraphicsPipelines)                                                                                       \
+	X(vkCreatePipelineCache)                                                                                           \
+	X(vkDestroyPipelineCache)                                                                                          \
+	X(vkGetPipelineCacheData)                                                                                          \
+	X(vkDestroyPipeline)                                                                                               \
+	X(vkCreateDescriptorSetLayout)                                                                                     \
+	X(vkDestroyDescriptorSetLayout)                                                                                    \
+	X(vkCreateDescriptorPool)                                                                                          \
+	X(vkDestroyDescriptorPool)                                                                                         \
+	X(vkResetDescriptorPool)                                                                                           \
+	X(vkAllocateDescriptorSets)                                                                                        \
+	X(vkUpdateDescriptorSets)                                                                                          \
+	X(vkCmdBeginRendering)                                                                                             \
+	X(vkCmdEndRendering)                                                                                               \
+	X(vkCmdExecuteCommands)                                                                                            \
+	X(vkCmdPipelineBarrier2)                                                                                           \
+	X(vkCmdBindPipeline)                                                                                               \
+	X(vkCmdBindVertexBuffers)                                                                                          \
+	X(vkCmdBindIndexBuffer)                                                                                            \
+	X(vkCmdBindDescriptorSets)                                                                                         \
+	X(vkCmdPushConstants)                                                                                              \
+	X(vkCmdSetViewport)                                                                                                \
+	X(vkCmdSetScissor)                                                                                                 \
+	X(vkCmdDraw)                                                                                                       \
+	X(vkCmdDrawIndexed)                                                                                                \
+	X(vkCmdUpdateBuffer)                                                                                               \
+	X(vkCmdCopyBuffer)                                                                                                 \
+	X(vkCmdCopyBufferToImage)                                                                                          \
+	X(vkCmdCopyImageToBuffer)                                                                                          \
+	X(vkCreateSwapchainKHR)                                                                                            \
+	X(vkDestroySwapchainKHR)                                                                                           \
+	X(vkGetSwapchainImagesKHR)                                                                                         \
+	X(vkAcquireNextImageKHR)                                                                                           \
+	X(vkQueuePresentKHR)
+
+namespace gefx
+{
+	/**
+	 * @brief Vulkan entry points, resolved at runtime from the system loader so the engine still starts on
+	 * machines without Vulkan. Members are named after the functions they point to: vk.vkCmdDraw(...).
+	 */
+	struct VulkanFunctions
+	{
+#define GEFX_VK_DECLARE_FUNCTION(name) PFN_##name name{nullptr};
+		GEFX_VK_GLOBAL_FUNCTIONS(GEFX_VK_DECLARE_FUNCTION)
+		GEFX_VK_INSTANCE_FUNCTIONS(GEFX_VK_DECLARE_FUNCTION)
+		GEFX_VK_DEVICE_FUNCTIONS(GEFX_VK_DECLARE_FUNCTION)
+#undef GEFX_VK_DECLARE_FUNCTION
+		PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr{nullptr};
+
+		/**
+		 * @brief Open the loader library and resolve the global functions, false if there is no Vulkan.
+		 */
+		bool Load();
+		void LoadInstance(VkInstance instance);
+		void LoadDevice(VkDevice device);
+		void Unload();
+
+		void* library{nullptr};
+	};
+
+} // namespace gefx
+
+#endif //!__VKFUNCTIONS__H__
@@ -0,0 +1,603 @@
+// StdLib Includes
+#include <algorithm>
+#include <cassert>
+
+// Application Specific Includes
+#include <core/bits.h>
+#include <core/log.h>
+#include <rendering/device/vkmemory.h>
+
+namespace gefx
+{
+	namespace
+	{
+		// Whether two allocations of these kinds may share a bufferImageGranularity page
+		bool conflicts(MemoryKind a, MemoryKind b)
+		{
+			return a != MemoryKind::Free && b != MemoryKind::Free && a != b;
+		}
+
+		bool samePage(uint64_t a, uint64_t b, uint64_t granularity)
+		{
+			return (a & ~(granularity - 1)) == (b & ~(granularity - 1));
+		}
+
+		// Blocks of the large heaps, small heaps (integrated GPUs, the 256MiB BAR) get an eighth of their size
+		constexpr uint64_t LargeHeapBlockSize = 64ull << 20;
+		constexpr uint64_t SmallHeapSize = 1ull << 30;
+	} // namespace
+
+	void TlsfAllocator::Reset(uint64_t size)
+	{
+		_nodes.clear();
+		_recycled.clear();
+		_first = InvalidNode;
+		_firstLevelMap = 0;
+		std::fill(std::begin(_secondLevelMap), std::end(_secondLevelMap), 0u);
+		for (auto& heads : _freeHeads) std::fill(std::begin(heads), std::end(heads), InvalidNode);
+		_size = size;
+		_used = 0;
+		_allocations = 0;
+
+		if (size == 0) return;
+		_first = NewNode(0, size);
+		InsertFree(_first);
+	}
+
+	void TlsfAllocator::Mapping(uint64_t size, uint32_t& outFirst, uint32_t& outSecond)
+	{
+		// Sizes under SecondLevelCount are all in the first class, one list per size
+		if (size < SecondLevelCount)
+		{
+			outFirst = 0;
+			outSecond = static_cast<uint32_t>(size);
+			return;
+		}
+		const uint32_t msb = 63 - rv::countLeadingZeros(size);
+		outFirst = msb - SecondLevelLog2 + 1;
+		outSecond = static_cast<uint32_t>(size >> (msb - SecondLevelLog2)) ^ SecondLevelCount;
+	}
+
+	uint64_t TlsfAllocator::GetSizeFor(uint64_t size, uint64_t alignment)
+	{
+		// Allocate pads for alignment and FindFree rounds that up to the next list, less than 1/32 more
+		const uint64_t request = size + alignment - 1;
+		return request + (request >> SecondLevelLog2);
+	}
+
+	uint32_t TlsfAllocator::FindFree(uint64_t size) const
+	{
+		// Round up to the next list so any range found there fits without walking the list
+		if (size >= SecondLevelCount)
+		{
+			const uint32_t msb = 63 - rv::countLeadingZeros(size);
+			size += (1ull << (msb - SecondLevelLog2)) - 1;
+		}
+
+		uint32_t first, second;
+		Mapping(size, first, second);
+		if (first >= FirstLevelCount) return InvalidNode;
+
+		uint32_t secondMap = _secondLevelMap[first] & (~0u << second);
+		if (secondMap == 0)
+		{
+			const uint64_t firstMap = first + 1 < 64 ? _firstLevelMap & (~0ull << (first + 1)) : 0;
+			if (firstMap == 0) return InvalidNode;
+			first = rv::countTrailingZeros(firstMap);
+			secondMap = _secondLevelMap[first];
+		}
+		return _freeHeads[first][rv::countTrailingZeros(secondMap)];
+	}
+
+	uint32_t TlsfAllocator::NewNode(uint64_t offset, uint64_t size)
+	{
+		uint32_t node;
+		if (!_recycled.empty())
+		{
+			node = _recycled.back();
+			_recycled.pop_back();
+		}
+		else
+		{
+			node = static_cast<uint32_t>(_nodes.size());
+			_nodes.emplace_back();
+		}
+		_nodes[node] = Node{offset, size, InvalidNode, InvalidNode, InvalidNode, InvalidNode, 1, 0,
+							MemoryKind::Free, false};
+		return node;
+	}
+
+	void TlsfAllocator::InsertFree(uint32_t node)
+	{
+		Node& n = _nodes[node];
+		uint32_t first, second;
+		Mapping(n.size, first, second);
+
+		n.prevFree = InvalidNode;
+		n.nextFree = _freeHeads[first][second];
+		if (n.nextFree != InvalidNode) _nodes[n.nextFree].prevFree = node;
+		_freeHeads[first][second] = node;
+		_firstLevelMap |= 1ull << first;
+		_secondLevelMap[first] |= 1u << second;
+	}
+
+	void TlsfAllocator::RemoveFree(uint32_t node)
+	{
+		Node& n = _nodes[node];
+		if (n.nextFree != InvalidNode) _nodes[n.nextFree].prevFree = n.prevFree;
+		if (n.prevFree != InvalidNode)
+		{
+			_nodes[n.prevFree].nextFree = n.nextFree;
+		}
+		else
+		{
+			uint32_t first, second;
+			Mapping(n.size, first, second);
+			_freeHeads[first][second] = n.nextFree;
+			if (n.nextFree == InvalidNode)
+			{
+				_secondLevelMap[first] &= ~(1u << second);
+				if (_secondLevelMap[first] == 0) _firstLevelMap &= ~(1ull << first);
+			}
+		}
+		n.prevFree = InvalidNode;
+		n.nextFree = InvalidNode;
+	}
+
+	uint32_t TlsfAllocator::Split(uint32_t node, uint64_t offset)
+	{
+		const uint64_t end = _nodes[node].offset + _nodes[node].size;
+		const uint32_t next = NewNode(offset, end - offset);
+
+		Node& n = _nodes[node];
+		n.size = offset - n.offset;
+		_nodes[next].prevPhysical = node;
+		_nodes[next].nextPhysical = n.nextPhysical;
+		if (n.nextPhysical != InvalidNode) _nodes[n.nextPhysical].prevPhysical = next;
+		n.nextPhysical = next;
+		return next;
+	}
+
+	void TlsfAllocator::Merge(uint32_t node, uint32_t next)
+	{
+		Node& n = _nodes[node];
+		const Node& m = _nodes[next];
+		n.size += m.size;
+		n.nextPhysical = m.nextPhysical;
+		if (m.nextPhysical != InvalidNode) _nodes[m.nextPhysical].prevPhysical = node;
+		_recycled.push_back(next);
+	}
+
+	uint32_t TlsfAllocator::Allocate(uint64_t size, uint64_t alignment, MemoryKind kind, uint64_t granularity,
+									 uint64_t& outOffset)
+	{
+		assert(kind != MemoryKind::Free && "allocations need a kind");
+		assert(rv::isPowerOfTwo(alignment) && rv::isPowerOfTwo(granularity));
+		if (size == 0) return InvalidNode;
+
+		// Worst case alignment padding first, a granularity page on both sides when that is not enough
+		uint64_t request = size + alignment - 1;
+		for (int attempt = 0; attempt < 2; attempt++)
+		{
+			const uint32_t node = FindFree(request);
+			if (node == InvalidNode) return InvalidNode;
+
+			// Free ranges never touch each other, their neighbours are allocations
+			const Node& n = _nodes[node];
+			uint64_t offset = rv::alignUp(n.offset, alignment);
+			if (granularity > 1 && n.prevPhysical != InvalidNode)
+			{
+				const Node& prev = _nodes[n.prevPhysical];
+				if (conflicts(prev.kind, kind) && samePage(prev.offset + prev.size - 1, offset, granularity))
+				{
+					offset = rv::alignUp(offset, granularity);
+				}
+			}
+			uint64_t end = offset + size;
+			if (granularity > 1 && n.nextPhysical != InvalidNode)
+			{
+				const Node& next = _nodes[n.nextPhysical];
+				if (conflicts(next.kind, kind) && samePage(end - 1, next.offset, granularity))
+				{
+					end = rv::alignUp(end, granularity);
+				}
+			}
+
+			if (end > n.offset + n.size)
+			{
+				request = size + alignment - 1 + 2 * granularity;
+				continue;
+			}
+
+			RemoveFree(node);
+			uint32_t allocated = node;
+			if (offset > _nodes[node].offset)
+			{
+				allocated = Split(node, offset);
+				InsertFree(node);
+			}
+			if (end < _nodes[allocated].offset + _nodes[allocated].size) InsertFree(Split(allocated, end));
+
+			Node& a = _nodes[allocated];
+			a.kind = kind;
+			a.alignment = alignment;
+			a.userData = 0;
+			a.movable = false;
+			_used += a.size;
+			_allocations++;
+			outOffset = a.offset;
+			return allocated;
+		}
+		return InvalidNode;
+	}
+
+	void TlsfAllocator::Free(uint32_t node)
+	{
+		assert(node < _nodes.size() && _nodes[node].kind != MemoryKind::Free && "freeing a free range");
+		Node& n = _nodes[node];
+		_used -= n.size;
+		_allocations--;
+		n.kind = MemoryKind::Free;
+
+		const uint32_t next = n.nextPhysical;
+		if (next != InvalidNode && _nodes[next].kind == MemoryKind::Free)
+		{
+			RemoveFree(next);
+			Merge(node, next);
+		}
+		const uint32_t prev = _nodes[node].prevPhysical;
+		if (prev != InvalidNode && _nodes[prev].kind == MemoryKind::Free)
+		{
+			RemoveFree(prev);
+			Merge(prev, node);
+			node = prev;
+		}
+		InsertFree(node);
+	}
+
+	void TlsfAllocator::SetUserData(uint32_t node, uint64_t userData, bool movable)
+	{
+		assert(node < _nodes.size() && _nodes[node].kind != MemoryKind::Free);
+		_nodes[node].userData = userData;
+		_nodes[node].movable = movable;
+	}
+
+	uint64_t TlsfAllocator::GetLargestFree() const
+	{
+		if (_firstLevelMap == 0) return 0;
+
+		// The biggest class holds the biggest range, though not necessarily at the head of its list
+		const uint32_t first = 63 - rv::countLeadingZeros(_firstLevelMap);
+		const uint32_t second = 63 - rv::countLeadingZeros(static_cast<uint64_t>(_secondLevelMap[first]));
+		uint64_t largest = 0;
+		for (uint32_t node = _freeHeads[first][second]; node != InvalidNode; node = _nodes[node].nextFree)
+		{
+			largest = std::max(largest, _nodes[node].size);
+		}
+		return largest;
+	}
+
+	bool LinearAllocator::Allocate(uint64_t size, uint64_t alignment, uint64_t& outOffset)
+	{
+		const uint64_t offset = rv::alignUp(_head, alignment);
+		if (offset + size > _size) return false;
+		_head = offset + size;
+		outOffset = offset;
+		return true;
+	}
+
+	uint32_t getMemoryTypeCandidates(const VkPhysicalDeviceMemoryProperties& properties, uint32_t typeBits,
+									 MemoryUsage usage, uint32_t outTypes[VK_MAX_MEMORY_TYPES])
+	{
+		const VkMemoryPropertyFlags hostCoherent =
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		VkMemoryPropertyFlags required = 0, preferred = 0, avoided = 0;
+		switch (usage)
+		{
+		case MemoryUsage::GpuOnly:
+			preferred = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+			avoided = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+			break;
+		case MemoryUsage::Upload:
+			required = hostCoherent;
+			avoided = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+			break;
+		case MemoryUsage::Readback:
+			required = hostCoherent;
+			preferred = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+			avoided = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+			break;
+		case MemoryUsage::Dynamic:
+			required = hostCoherent;
+			preferred = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+			avoided = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+			break;
+		}
+		// Types we never want to suballocate from
+		const VkMemoryPropertyFlags excluded = VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT |
+											   VK_MEMORY_PROPERTY_PROTECTED_BIT |
+											   VK_MEMORY_PROPERTY_DEVICE_COHERENT_BIT_AMD;
+
+		uint32_t costs[VK_MAX_MEMORY_TYPES];
+		uint32_t count = 0;
+		for (uint32_t i = 0; i < properties.memoryTypeCount; i++)
+		{
+			const VkMemoryPropertyFlags flags = properties.memoryTypes[i].propertyFlags;
+			if (!(typeBits & (1u << i)) || (flags & required) != required || (flags & excluded)) continue;
+
+			// A missing preferred property weighs more than an unwanted one
+			costs[i] = 2 * rv::popCount(preferred & ~flags) + rv::popCount(avoided & flags);
+			outTypes[count++] = i;
+		}
+		std::stable_sort(outTypes, outTypes + count, [&](uint32_t a, uint32_t b) { return costs[a] < costs[b]; });
+		return count;
+	}
+
+	void DeviceMemoryAllocator::Initialize(IMemoryBackend* backend, const VkPhysicalDeviceMemoryProperties& properties,
+										   uint64_t bufferImageGranularity, uint64_t preferredBlockSize)
+	{
+		_backend = backend;
+		_properties = properties;
+		_granularity = std::max<uint64_t>(bufferImageGranularity, 1);
+		_preferredBlockSize = preferredBlockSize;
+		for (uint32_t i = 0; i < VK_MAX_MEMORY_HEAPS; i++)
+		{
+			_heaps[i] = HeapStats{};
+			if (i < properties.memoryHeapCount) _heaps[i].budget = properties.memoryHeaps[i].size / 10 * 8;
+		}
+	}
+
+	void DeviceMemoryAllocator::Shutdown()
+	{
+		for (uint32_t type = 0; type < VK_MAX_MEMORY_TYPES; type++)
+		{
+			for (uint32_t block = 0; block < _blocks[type].size(); block++)
+			{
+				if (_blocks[type][block]) DestroyBlock(type, block);
+			}
+			_blocks[type].clear();
+		}
+		_backend = nullptr;
+	}
+
+	uint64_t DeviceMemoryAllocator::GetBlockSize(uint32_t type) const
+	{
+		if (_preferredBlockSize != 0) return _preferredBlockSize;
+		const uint64_t heapSize = _properties.memoryHeaps[_properties.memoryTypes[type].heapIndex].size;
+		return heapSize <= SmallHeapSize ? rv::alignUp(heapSize / 8, 32) : LargeHeapBlockSize;
+	}
+
+	uint32_t DeviceMemoryAllocator::CreateBlock(uint32_t type, uint64_t size, bool dedicated)
+	{
+		HeapStats& heap = _heaps[_properties.memoryTypes[type].heapIndex];
+		if (heap.blockBytes + size > heap.budget) return UINT32_MAX;
+
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		uint8_t* mapped = nullptr;
+		if (!_backend->AllocateBlock(type, size, memory, mapped)) return UINT32_MAX;
+
+		auto& blocks = _blocks[type];
+		uint32_t index = 0;
+		while (index < blocks.size() && blocks[index]) index++;
+		if (index == blocks.size()) blocks.emplace_back();
+		blocks[index].reset(new Block{memory, mapped, TlsfAllocator(size), dedicated, false});
+
+		heap.blockBytes += size;
+		heap.blocks++;
+		return index;
+	}
+
+	void DeviceMemoryAllocator::DestroyBlock(uint32_t type, uint32_t block)
+	{
+		std::unique_ptr<Block>& b = _blocks[type][block];
+		HeapStats& heap = _heaps[_properties.memoryTypes[type].heapIndex];
+		heap.blockBytes -= b->tlsf.GetSize();
+		heap.allocatedBytes -= b->tlsf.GetUsed();
+		heap.allocations -= b->tlsf.GetAllocationCount();
+		heap.blocks--;
+
+		_backend->FreeBlock(type, b->memory);
+		b.reset();
+	}
+
+	bool DeviceMemoryAllocator::AllocateFromBlock(uint32_t type, uint32_t block, const MemoryRequest& request,
+												  MemoryAllocation& outAllocation)
+	{
+		Block& b = *_blocks[type][block];
+		const uint64_t used = b.tlsf.GetUsed();
+		uint64_t offset;
+		const uint32_t node = b.tlsf.Allocate(request.size, request.alignment, request.kind, _granularity, offset);
+		if (node == TlsfAllocator::InvalidNode) return false;
+		b.tlsf.SetUserData(node, request.userData, request.movable);
+
+		HeapStats& heap = _heaps[_properties.memoryTypes[type].heapIndex];
+		heap.allocatedBytes += b.tlsf.GetUsed() - used;
+		heap.allocations++;
+
+		outAllocation.memory = b.memory;
+		outAllocation.offset = offset;
+		outAllocation.size = request.size;
+		outAllocation.mapped = b.mapped ? b.mapped + offset : nullptr;
+		outAllocation.memoryType = type;
+		outAllocation.block = block;
+		outAllocation.node = node;
+		return true;
+	}
+
+	bool DeviceMemoryAllocator::AllocateFromType(uint32_t type, const MemoryRequest& request,
+												 MemoryAllocation& outAllocation)
+	{
+		// Requests a new block couldn't hold twice get a block of their own
+		const uint64_t blockSize = GetBlockSize(type);
+		const uint64_t needed = request.size + request.alignment + 2 * _granularity;
+		if (2 * needed > blockSize)
+		{
+			const uint32_t block = CreateBlock(type, TlsfAllocator::GetSizeFor(request.size, request.alignment), true);
+			return block != UINT32_MAX && AllocateFromBlock(type, block, request, outAllocation);
+		}
+
+		auto& blocks = _blocks[type];
+		for (uint32_t block = 0; block < blocks.size(); block++)
+		{
+			if (!blocks[block] || blocks[block]->dedicated || blocks[block]->evacuating) continue;
+			if (AllocateFromBlock(type, block, request, outAllocation)) return true;
+		}
+
+		// Halve the new block while the backend or the budget refuses, as long as the request still fits twice
+		for (uint64_t size = blockSize; size >= 2 * needed; size /= 2)
+		{
+			const uint32_t block = CreateBlock(type, size, false);
+			if (block != UINT32_MAX) return AllocateFromBlock(type, block, request, outAllocation);
+		}
+		return false;
+	}
+
+	bool DeviceMemoryAllocator::Allocate(const MemoryRequest& request, MemoryAllocation& outAllocation)
+	{
+		assert(_backend && "allocator not initialized");
+		uint32_t types[VK_MAX_MEMORY_TYPES];
+		const uint32_t count = getMemoryTypeCandidates(_properties, request.typeBits, request.usage, types);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			if (AllocateFromType(types[i], request, outAllocation))
+			{
+				if (i > 0)
+				{
+					GEFX_LOG_WARNING("[Vulkan] {} bytes fell back to memory type {}, preferred type {} is full",
+									 request.size, types[i], types[0]);
+				}
+				return true;
+			}
+		}
+		GEFX_LOG_ERROR("[Vulkan] Out of device memory for {} bytes ({} memory types tried)", request.size, count);
+		return false;
+	}
+
+	void DeviceMemoryAllocator::Free(const MemoryAllocation& allocation)
+	{
+		if (allocation.IsNull()) return;
+		const uint32_t type = allocation.memoryType;
+		assert(allocation.block < _blocks[type].size() && _blocks[type][allocation.block] && "stale allocation");
+
+		Block& b = *_blocks[type][allocation.block];
+		HeapStats& heap = _heaps[_properties.memoryTypes[type].heapIndex];
+		const uint64_t used = b.tlsf.GetUsed();
+		b.tlsf.Free(allocation.node);
+		heap.allocatedBytes -= used - b.tlsf.GetUsed();
+		heap.allocations--;
+		if (!b.tlsf.IsEmpty()) return;
+
+		// Keep one empty block per type around so a type hovering at a block boundary does not thrash
+		bool keep = !b.dedicated && !b.evacuating;
+		for (uint32_t i = 0; keep && i < _blocks[type].size(); i++)
+		{
+			const auto& other = _blocks[type][i];
+			if (i != allocation.block && other && !other->dedicated && other->tlsf.IsEmpty()) keep = false;
+		}
+		if (!keep) DestroyBlock(type, allocation.block);
+	}
+
+	void DeviceMemoryAllocator::SetUserData(const MemoryAllocation& allocation, uint64_t userData)
+	{
+		Block& b = *_blocks[allocation.memoryType][allocation.block];
+		b.tlsf.SetUserData(allocation.node, userData, b.tlsf.GetAllocation(allocation.node).movable);
+	}
+
+	void DeviceMemoryAllocator::SetHeapBudget(uint32_t heap, uint64_t budget)
+	{
+		assert(heap < _properties.memoryHeapCount);
+		_heaps[heap].budget = budget;
+	}
+
+	void DeviceMemoryAllocator::PlanDefragmentation(uint32_t maxMoves, std::vector<MemoryMove>& outMoves)
+	{
+		outMoves.clear();
+		std::vector<uint32_t> order;
+		std::vector<bool> received;
+		std::vector<std::pair<uint32_t, TlsfAllocator::Allocation>> sourceAllocations;
+
+		for (uint32_t type = 0; type < _properties.memoryTypeCount && outMoves.size() < maxMoves; type++)
+		{
+			auto& blocks = _blocks[type];
+			order.clear();
+			for (uint32_t block = 0; block < blocks.size(); block++)
+			{
+				if (!blocks[block] || blocks[block]->dedicated) continue;
+				// A source of the last plan still waiting on its frees may take allocations again
+				blocks[block]->evacuating = false;
+				if (!blocks[block]->tlsf.IsEmpty()) order.push_back(block);
+			}
+			if (order.size() < 2) continue;
+			received.assign(blocks.size(), false);
+
+			// Empty the least used blocks into the fullest ones
+			std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+				return blocks[a]->tlsf.GetUsed() < blocks[b]->tlsf.GetUsed();
+			});
+
+			for (uint32_t i = 0; i + 1 < order.size(); i++)
+			{
+				// Whatever was planned into a block has not been copied yet, it can't move again
+				if (received[order[i]]) continue;
+				Block& source = *blocks[order[i]];
+
+				bool movable = true;
+				sourceAllocations.clear();
+				source.tlsf.ForEachAllocation([&](uint32_t node, const TlsfAllocator::Allocation& allocation) {
+					movable = movable && allocation.movable;
+					sourceAllocations.emplace_back(node, allocation);
+				});
+				if (!movable || outMoves.size() + sourceAllocations.size() > maxMoves) continue;
+
+				uint64_t room = 0;
+				for (uint32_t j = i + 1; j < order.size(); j++)
+				{
+					const Block& destination = *blocks[order[j]];
+					if (!destination.evacuating) room += destination.tlsf.GetSize() - destination.tlsf.GetUsed();
+				}
+				if (room < source.tlsf.GetUsed()) break;
+
+				source.evacuating = true;
+				const size_t planned = outMoves.size();
+				bool placed = true;
+				for (const auto& [node, allocation] : sourceAllocations)
+				{
+					MemoryRequest request;
+					request.size = allocation.size;
+					request.alignment = allocation.alignment;
+					request.kind = allocation.kind;
+					request.movable = true;
+					request.userData = allocation.userData;
+
+					MemoryMove move;
+					move.from.memory = source.memory;
+					move.from.offset = allocation.offset;
+					move.from.size = allocation.size;
+					move.from.mapped = source.mapped ? source.mapped + allocation.offset : nullptr;
+					move.from.memoryType = type;
+					move.from.block = order[i];
+					move.from.node = node;
+					move.userData = allocation.userData;
+
+					placed = false;
+					for (uint32_t j = i + 1; j < order.size() && !placed; j++)
+					{
+						if (!blocks[order[j]]->evacuating) placed = AllocateFromBlock(type, order[j], request, move.to);
+					}
+					if (!placed) break;
+					received[move.to.block] = true;
+					outMoves.push_back(move);
+				}
+
+				// Too fragmented to take all of it, a half emptied block gains nothing
+				if (!placed)
+				{
+					for (size_t m = planned; m < outMoves.size(); m++) Free(outMoves[m].to);
+					outMoves.resize(planned);
+					source.evacuating = false;
+				}
+			}
+		}
+	}
+
+} // namespace gefx
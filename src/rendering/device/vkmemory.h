@@ -0,0 +1,317 @@
+#ifndef __VKMEMORY__H__
+#define __VKMEMORY__H__
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <vulkan/vulkan_core.h>
+
+namespace gefx
+{
+	// What a suballocation holds, for bufferImageGranularity: linear and optimal resources may not share a page
+	enum class MemoryKind : uint8_t
+	{
+		Free,
+		Linear,
+		Optimal,
+	};
+
+	/**
+	 * @brief Two level segregated fit allocator over the offsets of one memory block, no memory of its own.
+	 *
+	 * Free ranges are binned by size class (power of two, split in SecondLevelCount linear steps), so finding a
+	 * range at least as big as a request and merging neighbours on free are both constant time. Ranges are
+	 * nodes of a physically ordered list, addressed by index so the allocator can be moved.
+	 */
+	class TlsfAllocator
+	{
+	  public:
+		static constexpr uint32_t InvalidNode = UINT32_MAX;
+
+		TlsfAllocator() = default;
+		explicit TlsfAllocator(uint64_t size) { Reset(size); };
+
+		/**
+		 * @brief Drop every allocation and manage [0, size).
+		 */
+		void Reset(uint64_t size);
+
+		/**
+		 * @brief Place size bytes at an alignment (power of two). Granularity is bufferImageGranularity: the
+		 * allocation is padded so it shares no granularity page with a neighbour of the other kind.
+		 *
+		 * @return the allocation's node, InvalidNode when no free range fits.
+		 */
+		uint32_t Allocate(uint64_t size, uint64_t alignment, MemoryKind kind, uint64_t granularity,
+						  uint64_t& outOffset);
+		void Free(uint32_t node);
+
+		/**
+		 * @brief Smallest size an empty allocator needs for Allocate of size at alignment to succeed.
+		 */
+		static uint64_t GetSizeFor(uint64_t size, uint64_t alignment);
+
+		/**
+		 * @brief Tag an allocation for the owner, ForEachAllocation gives it back.
+		 */
+		void SetUserData(uint32_t node, uint64_t userData, bool movable);
+
+		struct Allocation
+		{
+			uint64_t offset;
+			// Includes the padding granularity may have added
+			uint64_t size;
+			uint64_t alignment;
+			uint64_t userData;
+			MemoryKind kind;
+			bool movable;
+		};
+
+		Allocation GetAllocation(uint32_t node) const
+		{
+			const Node& n = _nodes[node];
+			return Allocation{n.offset, n.size, n.alignment, n.userData, n.kind, n.movable};
+		};
+
+		/**
+		 * @brief Call fn(node, const Allocation&) for every allocation in address order.
+		 */
+		template <typename F>
+		void ForEachAllocation(F&& fn) const
+		{
+			for (uint32_t node = _first; node != InvalidNode; node = _nodes[node].nextPhysical)
+			{
+				if (_nodes[node].kind != MemoryKind::Free) fn(node, GetAllocation(node));
+			}
+		};
+
+		uint64_t GetSize() const { return _size; };
+		uint64_t GetUsed() const { return _used; };
+		uint32_t GetAllocationCount() const { return _allocations; };
+		bool IsEmpty() const { return _allocations == 0; };
+		uint64_t GetLargestFree() const;
+
+	  private:
+		static constexpr uint32_t SecondLevelLog2 = 5;
+		static constexpr uint32_t SecondLevelCount = 1u << SecondLevelLog2;
+		static constexpr uint32_t FirstLevelCount = 64 - SecondLevelLog2 + 1;
+
+		struct Node
+		{
+			uint64_t offset;
+			uint64_t size;
+			uint32_t prevPhysical;
+			uint32_t nextPhysical;
+			// Free list links while free, unused otherwise
+			uint32_t prevFree;
+			uint32_t nextFree;
+			uint64_t alignment;
+			uint64_t userData;
+			MemoryKind kind;
+			bool movable;
+		};
+
+		static void Mapping(uint64_t size, uint32_t& outFirst, uint32_t& outSecond);
+		uint32_t FindFree(uint64_t size) const;
+		uint32_t NewNode(uint64_t offset, uint64_t size);
+		void InsertFree(uint32_t node);
+		void RemoveFree(uint32_t node);
+		// Split a free range at offset, returns the node of the part from offset on
+		uint32_t Split(uint32_t node, uint64_t offset);
+		void Merge(uint32_t node, uint32_t next);
+
+		std::vector<Node> _nodes;
+		std::vector<uint32_t> _recycled;
+		uint32_t _first{InvalidNode};
+		uint64_t _firstLevelMap{0};
+		uint32_t _secondLevelMap[FirstLevelCount]{};
+		uint32_t _freeHeads[FirstLevelCount][SecondLevelCount]{};
+		uint64_t _size{0};
+		uint64_t _used{0};
+		uint32_t _allocations{0};
+	};
+
+	/**
+	 * @brief Bump allocator for transient data, Reset once the GPU is done with everything it handed out.
+	 */
+	class LinearAllocator
+	{
+	  public:
+		LinearAllocator() = default;
+		explicit LinearAllocator(uint64_t size) : _size(size){};
+
+		bool Allocate(uint64_t size, uint64_t alignment, uint64_t& outOffset);
+		void Reset() { _head = 0; };
+
+		uint64_t GetSize() const { return _size; };
+		uint64_t GetUsed() const { return _head; };
+
+	  private:
+		uint64_t _size{0};
+		uint64_t _head{0};
+	};
+
+	enum class MemoryUsage : uint8_t
+	{
+		// Device local, never mapped
+		GpuOnly,
+		// Written once by the CPU and copied from, staging
+		Upload,
+		// Written by the GPU and read by the CPU
+		Readback,
+		// Written by the CPU and read by the GPU every frame, device local when the host can see it
+		Dynamic,
+	};
+
+	/**
+	 * @brief Memory types able to hold typeBits for a usage, best first. Host visible usages only get
+	 * coherent types. Returns the count written to outTypes.
+	 */
+	uint32_t getMemoryTypeCandidates(const VkPhysicalDeviceMemoryProperties& properties, uint32_t typeBits,
+									 MemoryUsage usage, uint32_t outTypes[VK_MAX_MEMORY_TYPES]);
+
+	/**
+	 * @brief Where device memory blocks come from: vkAllocateMemory on a device, anything for tests. Host
+	 * visible blocks come back persistently mapped.
+	 */
+	class IMemoryBackend
+	{
+	  public:
+		IMemoryBackend() = default;
+		virtual ~IMemoryBackend() = default;
+
+		IMemoryBackend(IMemoryBackend&&) = delete;
+		IMemoryBackend(const IMemoryBackend&) = delete;
+		IMemoryBackend& operator=(IMemoryBackend&&) = delete;
+		IMemoryBackend& operator=(const IMemoryBackend&) = delete;
+
+		virtual bool AllocateBlock(uint32_t memoryType, uint64_t size, VkDeviceMemory& outMemory,
+								   uint8_t*& outMapped) = 0;
+		virtual void FreeBlock(uint32_t memoryType, VkDeviceMemory memory) = 0;
+	};
+
+	struct MemoryRequest
+	{
+		uint64_t size{0};
+		uint64_t alignment{1};
+		// VkMemoryRequirements::memoryTypeBits
+		uint32_t typeBits{UINT32_MAX};
+		MemoryUsage usage{MemoryUsage::GpuOnly};
+		MemoryKind kind{MemoryKind::Linear};
+		// Defragmentation may move it, userData tells the owner which resource moved
+		bool movable{false};
+		uint64_t userData{0};
+	};
+
+	struct MemoryAllocation
+	{
+		VkDeviceMemory memory{VK_NULL_HANDLE};
+		uint64_t offset{0};
+		uint64_t size{0};
+		// Null unless host visible
+		uint8_t* mapped{nullptr};
+		uint32_t memoryType{0};
+		uint32_t block{0};
+		uint32_t node{TlsfAllocator::InvalidNode};
+
+		bool IsNull() const { return memory == VK_NULL_HANDLE; };
+	};
+
+	// Defragmentation step: copy the resource from one allocation to the other, then free the old one
+	struct MemoryMove
+	{
+		MemoryAllocation from;
+		MemoryAllocation to;
+		uint64_t userData;
+	};
+
+	struct HeapStats
+	{
+		// Bytes of blocks the heap may still grow to, from VK_EXT_memory_budget when available
+		uint64_t budget{0};
+		uint64_t blockBytes{0};
+		uint64_t allocatedBytes{0};
+		uint32_t blocks{0};
+		uint32_t allocations{0};
+	};
+
+	/**
+	 * @brief Suballocates device memory: blocks of preferred size per memory type, carved with TLSF, and a
+	 * block of its own for anything bigger than half a block. New blocks stay within each heap's budget,
+	 * falling back to the next best memory type. Talks to the device only through IMemoryBackend.
+	 */
+	class DeviceMemoryAllocator
+	{
+	  public:
+		DeviceMemoryAllocator() = default;
+		~DeviceMemoryAllocator() = default;
+
+		DeviceMemoryAllocator(DeviceMemoryAllocator&&) = delete;
+		DeviceMemoryAllocator(const DeviceMemoryAllocator&) = delete;
+		DeviceMemoryAllocator& operator=(DeviceMemoryAllocator&&) = delete;
+		DeviceMemoryAllocator& operator=(const DeviceMemoryAllocator&) = delete;
+
+		/**
+		 * @brief Budgets start at 80% of each heap. A zero block size picks one from the heap sizes.
+		 */
+		void Initialize(IMemoryBackend* backend, const VkPhysicalDeviceMemoryProperties& properties,
+						uint64_t bufferImageGranularity, uint64_t preferredBlockSize = 0);
+
+		/**
+		 * @brief Free every block, outstanding allocations included.
+		 */
+		void Shutdown();
+
+		bool Allocate(const MemoryRequest& request, MemoryAllocation& outAllocation);
+		void Free(const MemoryAllocation& allocation);
+
+		/**
+		 * @brief Tag an allocation with its owner once the owner exists, handed back by MemoryMove::userData.
+		 */
+		void SetUserData(const MemoryAllocation& allocation, uint64_t userData);
+
+		void SetHeapBudget(uint32_t heap, uint64_t budget);
+		uint32_t GetHeapCount() const { return _properties.memoryHeapCount; };
+		const HeapStats& GetHeapStats(uint32_t heap) const { return _heaps[heap]; };
+		const VkPhysicalDeviceMemoryProperties& GetProperties() const { return _properties; };
+
+		/**
+		 * @brief Plan up to maxMoves moves emptying the least used blocks of each memory type into the others.
+		 * Destinations are allocated already; the owner copies each resource, points it at move.to and frees
+		 * move.from once the GPU no longer reads it. The emptied blocks are released by that last free.
+		 */
+		void PlanDefragmentation(uint32_t maxMoves, std::vector<MemoryMove>& outMoves);
+
+	  private:
+		struct Block
+		{
+			VkDeviceMemory memory;
+			uint8_t* mapped;
+			TlsfAllocator tlsf;
+			// Holds one allocation too big to share a block
+			bool dedicated;
+			// Being emptied by defragmentation, no new allocations
+			bool evacuating;
+		};
+
+		bool AllocateFromType(uint32_t type, const MemoryRequest& request, MemoryAllocation& outAllocation);
+		bool AllocateFromBlock(uint32_t type, uint32_t block, const MemoryRequest& request,
+							   MemoryAllocation& outAllocation);
+		// Index of the new block, UINT32_MAX when the backend or the budget says no
+		uint32_t CreateBlock(uint32_t type, uint64_t size, bool dedicated);
+		void DestroyBlock(uint32_t type, uint32_t block);
+		uint64_t GetBlockSize(uint32_t type) const;
+
+		IMemoryBackend* _backend{nullptr};
+		VkPhysicalDeviceMemoryProperties _properties{};
+		uint64_t _granularity{1};
+		uint64_t _preferredBlockSize{0};
+		// Block slots per memory type, null slots are reused
+		std::vector<std::unique_ptr<Block>> _blocks[VK_MAX_MEMORY_TYPES];
+		HeapStats _heaps[VK_MAX_MEMORY_HEAPS];
+	};
+
+} // namespace gefx
+
+#endif //!__VKMEMORY__H__
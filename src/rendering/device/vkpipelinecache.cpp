@@ -0,0 +1,239 @@
+// StdLib Includes
+#include <cstring>
+#include <fstream>
+
+// Application Specific Includes
+#include <core/fileops.h>
+#include <core/log.h>
+#include <core/utils.h>
+#include <rendering/device/vkpipelinecache.h>
+
+namespace gefx
+{
+	namespace
+	{
+		bool matchesDevice(const PipelineCacheHeader& header, const VkPhysicalDeviceProperties& properties)
+		{
+			return header.vendorID == properties.vendorID && header.deviceID == properties.deviceID &&
+				   header.driverVersion == properties.driverVersion &&
+				   std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+		}
+
+		template <typename T>
+		void append(std::vector<uint8_t>& out, const T* values, size_t count)
+		{
+			const uint8_t* bytes = reinterpret_cast<const uint8_t*>(values);
+			out.insert(out.end(), bytes, bytes + count * sizeof(T));
+		}
+
+		// Bounds checked reads over the file contents
+		class Reader
+		{
+		  public:
+			Reader(const uint8_t* data, size_t size) : _data(data), _size(size){};
+
+			template <typename T>
+			bool Read(T* out, size_t count)
+			{
+				if (count > (_size - _offset) / sizeof(T)) return false;
+				std::memcpy(out, _data + _offset, count * sizeof(T));
+				_offset += count * sizeof(T);
+				return true;
+			};
+
+			bool IsDone() const { return _offset == _size; };
+
+		  private:
+			const uint8_t* _data;
+			size_t _size;
+			size_t _offset{0};
+		};
+	} // namespace
+
+	bool PipelineCacheFile::Read(const std::string& path, const VkPhysicalDeviceProperties& properties)
+	{
+		Clear();
+		std::ifstream in(path.c_str(), std::ios::binary | std::ios::ate);
+		if (!in) return false;
+		std::vector<uint8_t> file(static_cast<size_t>(in.tellg()));
+		in.seekg(0);
+		in.read(reinterpret_cast<char*>(file.data()), file.size());
+
+		PipelineCacheHeader header;
+		if (!in || file.size() < sizeof(header))
+		{
+			GEFX_LOG_WARNING("[Vulkan] Pipeline cache {} is truncated, ignoring it", path);
+			return false;
+		}
+		std::memcpy(&header, file.data(), sizeof(header));
+		if (header.magic != PipelineCacheHeader::Magic || header.version != PipelineCacheHeader::Version)
+		{
+			GEFX_LOG_WARNING("[Vulkan] {} is not a pipeline cache of this version, ignoring it", path);
+			return false;
+		}
+		if (!matchesDevice(header, properties))
+		{
+			GEFX_LOG_INFO("[Vulkan] Pipeline cache {} was written by another device or driver, starting over", path);
+			return false;
+		}
+		const uint8_t* body = file.data() + sizeof(header);
+		const size_t bodySize = file.size() - sizeof(header);
+		if (rv::crc32(body, bodySize) != header.checksum)
+		{
+			GEFX_LOG_WARNING("[Vulkan] Pipeline cache {} is damaged, ignoring it", path);
+			return false;
+		}
+
+		auto fail = [&]() {
+			GEFX_LOG_WARNING("[Vulkan] Pipeline cache {} is malformed, ignoring it", path);
+			Clear();
+			return false;
+		};
+		Reader reader(body, bodySize);
+		if (header.dataSize > bodySize) return fail();
+		_data.resize(static_cast<size_t>(header.dataSize));
+		if (!reader.Read(_data.data(), _data.size())) return fail();
+
+		for (uint32_t i = 0; i < header.shaderCount; i++)
+		{
+			uint64_t hash;
+			uint32_t wordCount;
+			if (!reader.Read(&hash, 1) || !reader.Read(&wordCount, 1) || wordCount > bodySize / 4) return fail();
+			std::vector<uint32_t> words(wordCount);
+			if (!reader.Read(words.data(), wordCount) || hashSpirv(words) != hash) return fail();
+			_shaders.insert_or_assign(hash, std::move(words));
+		}
+
+		if (header.pipelineCount > bodySize / sizeof(PipelineRecord)) return fail();
+		_pipelines.resize(header.pipelineCount);
+		if (!reader.Read(_pipelines.data(), _pipelines.size()) || !reader.IsDone()) return fail();
+		for (const PipelineRecord& record : _pipelines)
+		{
+			if (!_shaders.contains(record.vertexShader) || !_shaders.contains(record.fragmentShader)) return fail();
+			if (record.attributeCount > MaxVertexAttributes) return fail();
+			if (record.blend > static_cast<uint32_t>(BlendMode::Premultiplied)) return fail();
+		}
+		for (uint32_t i = 0; i < _pipelines.size(); i++)
+		{
+			_hashes.push_back(hashPipelineDesc(GetPipeline(i)));
+			_recorded.try_emplace(_hashes.back(), i);
+		}
+		return true;
+	}
+
+	bool PipelineCacheFile::Write(const std::string& path, const VkPhysicalDeviceProperties& properties) const
+	{
+		std::vector<uint8_t> body;
+		append(body, _data.data(), _data.size());
+		for (const auto& [hash, words] : _shaders)
+		{
+			const uint32_t wordCount = static_cast<uint32_t>(words.size());
+			append(body, &hash, 1);
+			append(body, &wordCount, 1);
+			append(body, words.data(), words.size());
+		}
+		append(body, _pipelines.data(), _pipelines.size());
+
+		PipelineCacheHeader header{};
+		header.magic = PipelineCacheHeader::Magic;
+		header.version = PipelineCacheHeader::Version;
+		header.vendorID = properties.vendorID;
+		header.deviceID = properties.deviceID;
+		header.driverVersion = properties.driverVersion;
+		header.shaderCount = static_cast<uint32_t>(_shaders.size());
+		std::memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+		header.pipelineCount = static_cast<uint32_t>(_pipelines.size());
+		header.checksum = rv::crc32(body.data(), body.size());
+		header.dataSize = _data.size();
+
+		const std::string temporary = path + ".tmp";
+		{
+			std::ofstream out(temporary.c_str(), std::ios::binary | std::ios::trunc);
+			out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			out.write(reinterpret_cast<const char*>(body.data()), body.size());
+			if (!out)
+			{
+				GEFX_LOG_ERROR("[Vulkan] Failed to write the pipeline cache to {}", temporary);
+				return false;
+			}
+		}
+		if (!rv::moveFile(temporary, path))
+		{
+			GEFX_LOG_ERROR("[Vulkan] Failed to replace the pipeline cache {}", path);
+			return false;
+		}
+		return true;
+	}
+
+	void PipelineCacheFile::Clear()
+	{
+		_data.clear();
+		_shaders.clear();
+		_pipelines.clear();
+		_hashes.clear();
+		_recorded.clear();
+	}
+
+	void PipelineCacheFile::AddPipeline(const PipelineDesc& desc, uint64_t hash)
+	{
+		if (!_recorded.try_emplace(hash, static_cast<uint32_t>(_pipelines.size())).second) return;
+
+		PipelineRecord record{};
+		record.vertexShader = hashSpirv(desc.vertexSpirv);
+		record.fragmentShader = hashSpirv(desc.fragmentSpirv);
+		_shaders.try_emplace(record.vertexShader, desc.vertexSpirv.begin(), desc.vertexSpirv.end());
+		_shaders.try_emplace(record.fragmentShader, desc.fragmentSpirv.begin(), desc.fragmentSpirv.end());
+		for (uint32_t i = 0; i < desc.attributeCount; i++)
+		{
+			record.attributes[i][0] = desc.attributes[i].location;
+			record.attributes[i][1] = static_cast<uint32_t>(desc.attributes[i].format);
+			record.attributes[i][2] = desc.attributes[i].offset;
+		}
+		record.attributeCount = desc.attributeCount;
+		record.vertexStride = desc.vertexStride;
+		record.topology = static_cast<uint32_t>(desc.topology);
+		record.cullMode = static_cast<uint32_t>(desc.cullMode);
+		record.depthTest = desc.depthTest;
+		record.depthWrite = desc.depthWrite;
+		record.pushConstantBytes = desc.pushConstantBytes;
+		record.colorFormat = static_cast<uint32_t>(desc.colorFormat);
+		record.depthFormat = static_cast<uint32_t>(desc.depthFormat);
+		record.blend = static_cast<uint32_t>(desc.blend);
+		_pipelines.push_back(record);
+		_hashes.push_back(hash);
+	}
+
+	PipelineDesc PipelineCacheFile::GetPipeline(uint32_t index) const
+	{
+		const PipelineRecord& record = _pipelines[index];
+		PipelineDesc desc;
+		desc.vertexSpirv = _shaders.at(record.vertexShader);
+		desc.fragmentSpirv = _shaders.at(record.fragmentShader);
+		for (uint32_t i = 0; i < record.attributeCount; i++)
+		{
+			desc.attributes[i].location = record.attributes[i][0];
+			desc.attributes[i].format = static_cast<Format>(record.attributes[i][1]);
+			desc.attributes[i].offset = record.attributes[i][2];
+		}
+		desc.attributeCount = record.attributeCount;
+		desc.vertexStride = record.vertexStride;
+		desc.topology = static_cast<PrimitiveTopology>(record.topology);
+		desc.cullMode = static_cast<CullMode>(record.cullMode);
+		desc.depthTest = record.depthTest != 0;
+		desc.depthWrite = record.depthWrite != 0;
+		desc.pushConstantBytes = record.pushConstantBytes;
+		desc.colorFormat = static_cast<Format>(record.colorFormat);
+		desc.depthFormat = static_cast<Format>(record.depthFormat);
+		desc.blend = static_cast<BlendMode>(record.blend);
+		return desc;
+	}
+
+	bool PipelineCacheFile::FindPipeline(uint64_t hash, uint32_t& outIndex) const
+	{
+		const auto found = _recorded.find(hash);
+		if (found == _recorded.end()) return false;
+		outIndex = found->second;
+		return true;
+	}
+
+} // namespace gefx
@@ -0,0 +1,116 @@
+#ifndef __VKPIPELINECACHE__H__
+#define __VKPIPELINECACHE__H__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan_core.h>
+
+#include <core/containers/flathashmap.h>
+#include <rendering/device/device.h>
+
+namespace gefx
+{
+	/**
+	 * Pipeline cache file layout (little endian):
+	 *  PipelineCacheHeader
+	 *  uint8_t data[dataSize]          vkGetPipelineCacheData, only handed back to the driver that wrote it
+	 *  shaders[shaderCount]            uint64_t hashSpirv, uint32_t wordCount, uint32_t words[wordCount]
+	 *  PipelineRecord[pipelineCount]   pipelines created by the session that wrote the file
+	 *
+	 * The header pins the file to one driver: another vendor, device, driver version or pipelineCacheUUID
+	 * throws the whole file away, and so does a checksum mismatch. Drivers are not required to survive a
+	 * cache blob that isn't theirs.
+	 */
+	struct PipelineCacheHeader
+	{
+		static constexpr uint32_t Magic = 0x43505047; // "GPPC"
+		static constexpr uint32_t Version = 2;
+
+		uint32_t magic;
+		uint32_t version;
+		uint32_t vendorID;
+		uint32_t deviceID;
+		uint32_t driverVersion;
+		uint32_t shaderCount;
+		uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+		uint32_t pipelineCount;
+		// rv::crc32 of everything after the header
+		uint32_t checksum;
+		uint64_t dataSize;
+	};
+
+	struct PipelineRecord
+	{
+		uint64_t vertexShader;
+		uint64_t fragmentShader;
+		// location, format, offset
+		uint32_t attributes[MaxVertexAttributes][3];
+		uint32_t attributeCount;
+		uint32_t vertexStride;
+		uint32_t topology;
+		uint32_t cullMode;
+		uint32_t depthTest;
+		uint32_t depthWrite;
+		uint32_t pushConstantBytes;
+		uint32_t colorFormat;
+		uint32_t depthFormat;
+		uint32_t blend;
+	};
+
+	static_assert(sizeof(PipelineCacheHeader) == 56, "PipelineCacheHeader layout changed");
+	static_assert(sizeof(PipelineRecord) == 152, "PipelineRecord layout changed");
+
+	/**
+	 * @brief Contents of a pipeline cache file: the driver's cache blob, and the pipeline descriptions worth
+	 * compiling ahead of time next session along with their SPIR-V.
+	 */
+	class PipelineCacheFile
+	{
+	  public:
+		/**
+		 * @brief Load a file written for this device and driver. False when it is missing, damaged or stale,
+		 * the contents are left empty then.
+		 */
+		bool Read(const std::string& path, const VkPhysicalDeviceProperties& properties);
+
+		/**
+		 * @brief Write to a temporary file renamed over path, a crash mid write leaves the old file.
+		 */
+		bool Write(const std::string& path, const VkPhysicalDeviceProperties& properties) const;
+		void Clear();
+
+		/**
+		 * @brief Record a pipeline once per hash (hashPipelineDesc), copying its shader code.
+		 */
+		void AddPipeline(const PipelineDesc& desc, uint64_t hash);
+
+		uint32_t GetPipelineCount() const { return static_cast<uint32_t>(_pipelines.size()); };
+		uint64_t GetPipelineHash(uint32_t index) const { return _hashes[index]; };
+
+		/**
+		 * @brief Index of the pipeline recorded for hash, false when there is none.
+		 */
+		bool FindPipeline(uint64_t hash, uint32_t& outIndex) const;
+
+		/**
+		 * @brief Description of a recorded pipeline, its SPIR-V points into this object.
+		 */
+		PipelineDesc GetPipeline(uint32_t index) const;
+
+		const std::vector<uint8_t>& GetData() const { return _data; };
+		void SetData(std::vector<uint8_t> data) { _data = std::move(data); };
+
+	  private:
+		std::vector<uint8_t> _data;
+		rv::FlatHashMap<uint64_t, std::vector<uint32_t>> _shaders;
+		std::vector<PipelineRecord> _pipelines;
+		std::vector<uint64_t> _hashes;
+		// Hash to index in _pipelines
+		rv::FlatHashMap<uint64_t, uint32_t> _recorded;
+	};
+
+} // namespace gefx
+
+#endif //!__VKPIPELINECACHE__H__
@@ -0,0 +1,213 @@
+// StdLib Includes
+#include <cassert>
+
+// Application Specific Includes
+#include <rendering/gpuresources.h>
+
+namespace gefx
+{
+	namespace
+	{
+		uint32_t BytesPerTexel(GLenum internalFormat)
+		{
+			switch (internalFormat)
+			{
+			case GL_R8:
+				return 1;
+			case GL_RG8:
+			case GL_R16F:
+			case GL_DEPTH_COMPONENT16:
+				return 2;
+			case GL_RGB8:
+			case GL_SRGB8:
+			case GL_DEPTH_COMPONENT24:
+				return 3;
+			case GL_RGBA16F:
+			case GL_RG32F:
+				return 8;
+			case GL_RGBA32F:
+				return 16;
+			default:
+				// RGBA8, SRGB8_ALPHA8, R32F, RG16F, DEPTH24_STENCIL8, DEPTH_COMPONENT32F, ...
+				return 4;
+			}
+		}
+	} // namespace
+
+	GpuResources::~GpuResources()
+	{
+		assert(_inFlight.empty() && _retiredThisFrame.empty() && _buffers.empty() && _vertexArrays.empty() &&
+			   _programs.empty() && _textures.empty() && "GpuResources::DestroyAll must run before the context dies");
+	}
+
+	BufferHandle GpuResources::CreateBuffer(uint64_t bytes, const void* data, GLenum usage)
+	{
+		GpuBuffer buffer;
+		buffer.bytes = bytes;
+		glCreateBuffers(1, &buffer.id);
+		glNamedBufferData(buffer.id, static_cast<GLsizeiptr>(bytes), data, usage);
+
+		GpuResourceStats& stats = Stats(GpuResourceType::Buffer);
+		stats.live++;
+		stats.liveBytes += bytes;
+		return _buffers.Create(buffer);
+	}
+
+	VertexArrayHandle GpuResources::CreateVertexArray()
+	{
+		GpuVertexArray vertexArray;
+		glCreateVertexArrays(1, &vertexArray.id);
+
+		Stats(GpuResourceType::VertexArray).live++;
+		return _vertexArrays.Create(vertexArray);
+	}
+
+	TextureHandle GpuResources::CreateTexture2D(uint32_t width, uint32_t height, uint32_t levels, GLenum internalFormat)
+	{
+		GpuTexture texture;
+		texture.target = GL_TEXTURE_2D;
+		texture.format = internalFormat;
+		texture.width = width;
+		texture.height = height;
+		texture.levels = levels;
+		glCreateTextures(GL_TEXTURE_2D, 1, &texture.id);
+		glTextureStorage2D(texture.id, static_cast<GLsizei>(levels), internalFormat, static_cast<GLsizei>(width),
+						   static_cast<GLsizei>(height));
+
+		const uint32_t texelBytes = BytesPerTexel(internalFormat);
+		for (uint32_t level = 0; level < levels; level++)
+		{
+			const uint64_t levelWidth = width >> level ? width >> level : 1;
+			const uint64_t levelHeight = height >> level ? height >> level : 1;
+			texture.bytes += levelWidth * levelHeight * texelBytes;
+		}
+
+		GpuResourceStats& stats = Stats(GpuResourceType::Texture);
+		stats.live++;
+		stats.liveBytes += texture.bytes;
+		return _textures.Create(texture);
+	}
+
+	ProgramHandle GpuResources::AdoptProgram(GLuint program)
+	{
+		if (program == 0) return {};
+
+		Stats(GpuResourceType::Program).live++;
+		return _programs.Create(GpuProgram{program});
+	}
+
+	void GpuResources::Destroy(BufferHandle handle)
+	{
+		GpuBuffer buffer;
+		if (_buffers.Release(handle, buffer)) Retire(GpuResourceType::Buffer, buffer.id, buffer.bytes);
+	}
+
+	void GpuResources::Destroy(VertexArrayHandle handle)
+	{
+		GpuVertexArray vertexArray;
+		if (_vertexArrays.Release(handle, vertexArray)) Retire(GpuResourceType::VertexArray, vertexArray.id, 0);
+	}
+
+	void GpuResources::Destroy(ProgramHandle handle)
+	{
+		GpuProgram program;
+		if (_programs.Release(handle, program)) Retire(GpuResourceType::Program, program.id, 0);
+	}
+
+	void GpuResources::Destroy(TextureHandle handle)
+	{
+		GpuTexture texture;
+		if (_textures.Release(handle, texture)) Retire(GpuResourceType::Texture, texture.id, texture.bytes);
+	}
+
+	void GpuResources::Retire(GpuResourceType type, GLuint id, uint64_t bytes)
+	{
+		GpuResourceStats& stats = Stats(type);
+		stats.live--;
+		stats.liveBytes -= bytes;
+		stats.pendingDestroy++;
+		stats.pendingBytes += bytes;
+		_retiredThisFrame.push_back(Retired{id, type, bytes});
+	}
+
+	void GpuResources::EndFrame()
+	{
+		if (!_retiredThisFrame.empty())
+		{
+			_inFlight.push_back(Retirement{glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), std::move(_retiredThisFrame)});
+			_retiredThisFrame.clear();
+		}
+
+		// Fences signal in submission order, stop at the first one still pending
+		while (!_inFlight.empty())
+		{
+			Retirement& retirement = _inFlight.front();
+			const GLenum status = glClientWaitSync(retirement.fence, 0, 0);
+			if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+
+			glDeleteSync(retirement.fence);
+			Delete(retirement.objects);
+			_inFlight.pop_front();
+		}
+	}
+
+	void GpuResources::DestroyAll()
+	{
+		for (const GpuBuffer& buffer : _buffers)
+		{
+			Retire(GpuResourceType::Buffer, buffer.id, buffer.bytes);
+		}
+		for (const GpuVertexArray& vertexArray : _vertexArrays)
+		{
+			Retire(GpuResourceType::VertexArray, vertexArray.id, 0);
+		}
+		for (const GpuProgram& program : _programs)
+		{
+			Retire(GpuResourceType::Program, program.id, 0);
+		}
+		for (const GpuTexture& texture : _textures)
+		{
+			Retire(GpuResourceType::Texture, texture.id, texture.bytes);
+		}
+		_buffers.Clear();
+		_vertexArrays.Clear();
+		_programs.Clear();
+		_textures.Clear();
+
+		glFinish();
+		for (Retirement& retirement : _inFlight)
+		{
+			glDeleteSync(retirement.fence);
+			Delete(retirement.objects);
+		}
+		_inFlight.clear();
+		Delete(_retiredThisFrame);
+		_retiredThisFrame.clear();
+	}
+
+	void GpuResources::Delete(const std::vector<Retired>& objects)
+	{
+		// Batch names per type so each kind costs a single delete call
+		std::vector<GLuint> names[static_cast<size_t>(GpuResourceType::Count)];
+		for (const Retired& object : objects)
+		{
+			names[static_cast<size_t>(object.type)].push_back(object.id);
+
+			GpuResourceStats& stats = Stats(object.type);
+			stats.pendingDestroy--;
+			stats.pendingBytes -= object.bytes;
+		}
+
+		const std::vector<GLuint>& buffers = names[static_cast<size_t>(GpuResourceType::Buffer)];
+		const std::vector<GLuint>& vertexArrays = names[static_cast<size_t>(GpuResourceType::VertexArray)];
+		const std::vector<GLuint>& textures = names[static_cast<size_t>(GpuResourceType::Texture)];
+		if (!buffers.empty()) glDeleteBuffers(static_cast<GLsizei>(buffers.size()), buffers.data());
+		if (!vertexArrays.empty()) glDeleteVertexArrays(static_cast<GLsizei>(vertexArrays.size()), vertexArrays.data());
+		if (!textures.empty()) glDeleteTextures(static_cast<GLsizei>(textures.size()), textures.data());
+		for (const GLuint program : names[static_cast<size_t>(GpuResourceType::Program)])
+		{
+			glDeleteProgram(program);
+		}
+	}
+
+} // namespace gefx
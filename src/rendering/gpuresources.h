@@ -0,0 +1,180 @@
+#ifndef __GPURESOURCES__H__
+#define __GPURESOURCES__H__
+
+// StdLib Includes
+#include <cassert>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// Third Party Includes
+#include <glad/glad.h>
+
+// Application Specific Includes
+#include <core/containers/handlepool.h>
+#include <rendering/device/device.h>
+
+namespace gefx
+{
+	struct GpuBuffer
+	{
+		GLuint id{0};
+		uint64_t bytes{0};
+	};
+
+	struct GpuVertexArray
+	{
+		GLuint id{0};
+	};
+
+	struct GpuProgram
+	{
+		GLuint id{0};
+	};
+
+	struct GpuTexture
+	{
+		GLuint id{0};
+		GLenum target{GL_TEXTURE_2D};
+		GLenum format{GL_RGBA8};
+		uint32_t width{0};
+		uint32_t height{0};
+		uint32_t levels{1};
+		uint64_t bytes{0};
+	};
+
+	// Buffers and textures use the device handles, so GLDevice hands these out as is
+	using VertexArrayHandle = rv::Handle<GpuVertexArray>;
+	using ProgramHandle = rv::Handle<GpuProgram>;
+
+	enum class GpuResourceType : uint8_t
+	{
+		Buffer,
+		VertexArray,
+		Program,
+		Texture,
+		Count
+	};
+
+	struct GpuResourceStats
+	{
+		uint32_t live{0};
+		uint32_t pendingDestroy{0};
+		uint64_t liveBytes{0};
+		uint64_t pendingBytes{0};
+	};
+
+	/**
+	 * @brief Owner of every GL object the engine creates. Objects are referenced through generational handles,
+	 * so a handle kept past Destroy resolves to nothing instead of aliasing whatever reuses the GL name.
+	 * Destroy only retires the object: the GL name is deleted once a fence inserted at the end of the frame
+	 * that retired it signals, since commands already submitted may still read from it.
+	 * Must be used from the thread owning the GL context, objects are created with direct state access
+	 * (glCreateBuffers and friends) which needs a 4.5 context.
+	 */
+	class GpuResources
+	{
+	  public:
+		GpuResources() = default;
+		~GpuResources();
+
+		GpuResources(GpuResources&&) = delete;
+		GpuResources(const GpuResources&) = delete;
+		GpuResources& operator=(GpuResources&&) = delete;
+		GpuResources& operator=(const GpuResources&) = delete;
+
+		/**
+		 * @brief Create a buffer of the given size and upload data into it (data may be null).
+		 *
+		 * @param usage glBufferData usage hint, like GL_STATIC_DRAW.
+		 */
+		BufferHandle CreateBuffer(uint64_t bytes, const void* data, GLenum usage);
+		VertexArrayHandle CreateVertexArray();
+		TextureHandle CreateTexture2D(uint32_t width, uint32_t height, uint32_t levels, GLenum internalFormat);
+
+		/**
+		 * @brief Take ownership of an already linked program, returns a null handle for a 0 program.
+		 */
+		ProgramHandle AdoptProgram(GLuint program);
+
+		/**
+		 * @brief GL name behind a handle. Null handles resolve to 0, stale ones assert and resolve to 0.
+		 */
+		GLuint GetGL(BufferHandle handle) const { return Resolve(_buffers, handle); };
+		GLuint GetGL(VertexArrayHandle handle) const { return Resolve(_vertexArrays, handle); };
+		GLuint GetGL(ProgramHandle handle) const { return Resolve(_programs, handle); };
+		GLuint GetGL(TextureHandle handle) const { return Resolve(_textures, handle); };
+
+		const GpuBuffer* Get(BufferHandle handle) const { return _buffers.Get(handle); };
+		const GpuTexture* Get(TextureHandle handle) const { return _textures.Get(handle); };
+
+		bool IsValid(BufferHandle handle) const { return _buffers.IsValid(handle); };
+		bool IsValid(VertexArrayHandle handle) const { return _vertexArrays.IsValid(handle); };
+		bool IsValid(ProgramHandle handle) const { return _programs.IsValid(handle); };
+		bool IsValid(TextureHandle handle) const { return _textures.IsValid(handle); };
+
+		/**
+		 * @brief Invalidate the handle and queue the GL object for deletion. Null or stale handles are ignored.
+		 */
+		void Destroy(BufferHandle handle);
+		void Destroy(VertexArrayHandle handle);
+		void Destroy(ProgramHandle handle);
+		void Destroy(TextureHandle handle);
+
+		/**
+		 * @brief Fence the objects retired this frame and delete the ones whose fence already signaled.
+		 * Call once per frame, after the frame's draw calls were submitted.
+		 */
+		void EndFrame();
+
+		/**
+		 * @brief Wait for the GPU and delete every live and retired object. Call before the context goes away.
+		 */
+		void DestroyAll();
+
+		GpuResourceStats GetStats(GpuResourceType type) const { return _stats[static_cast<size_t>(type)]; };
+
+		// Dense views for cache friendly iteration over the live objects
+		const rv::HandlePool<BufferTag, GpuBuffer>& GetBuffers() const { return _buffers; };
+		const rv::HandlePool<TextureTag, GpuTexture>& GetTextures() const { return _textures; };
+
+	  private:
+		struct Retired
+		{
+			GLuint id;
+			GpuResourceType type;
+			uint64_t bytes;
+		};
+
+		struct Retirement
+		{
+			GLsync fence;
+			std::vector<Retired> objects;
+		};
+
+		template <typename Tag, typename T>
+		static GLuint Resolve(const rv::HandlePool<Tag, T>& pool, rv::Handle<Tag> handle)
+		{
+			if (handle.IsNull()) return 0;
+			const T* object = pool.Get(handle);
+			assert(object && "stale GPU resource handle");
+			return object ? object->id : 0;
+		};
+
+		void Retire(GpuResourceType type, GLuint id, uint64_t bytes);
+		void Delete(const std::vector<Retired>& objects);
+		GpuResourceStats& Stats(GpuResourceType type) { return _stats[static_cast<size_t>(type)]; };
+
+		rv::HandlePool<BufferTag, GpuBuffer> _buffers;
+		rv::HandlePool<GpuVertexArray> _vertexArrays;
+		rv::HandlePool<GpuProgram> _programs;
+		rv::HandlePool<TextureTag, GpuTexture> _textures;
+
+		std::vector<Retired> _retiredThisFrame;
+		std::deque<Retirement> _inFlight;
+		GpuResourceStats _stats[static_cast<size_t>(GpuResourceType::Count)];
+	};
+
+} // namespace gefx
+
+#endif //!__GPURESOURCES__H__
@@ -0,0 +1,393 @@
+// StdLib Includes
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// Application Specific Includes
+#include <core/math/simd.h>
+#include <rendering/occlusion.h>
+
+namespace gefx
+{
+	namespace
+	{
+		constexpr uint32_t FullCoverage = ~0u;
+		constexpr uint32_t TrianglesPerJob = 256;
+		constexpr uint32_t TileRowsPerBand = 2;
+		// Occludees this close to an occluder count as in front of it, the two depths come from differently
+		// rounded transforms and an object must never hide itself when it is also an occluder
+		constexpr float DepthEpsilon = 1e-5f;
+
+		// Pixel centers of one tile row, relative to the tile's left edge
+		constexpr float LaneOffsets[OcclusionCuller::TileWidth] = {0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f};
+
+		template <typename F>
+		void parallelRange(JobSystem* jobs, uint32_t count, uint32_t batchSize, const F& fn)
+		{
+			if (jobs)
+			{
+				jobs->ParallelFor(count, batchSize, fn);
+			}
+			else if (count > 0)
+			{
+				fn(0u, count);
+			}
+		}
+
+		// Bits [begin, end) of a tile row
+		uint32_t spanBits(uint32_t begin, uint32_t end)
+		{
+			return ((1u << end) - 1u) & ~((1u << begin) - 1u);
+		}
+	} // namespace
+
+	OcclusionCuller::OcclusionCuller(uint32_t width, uint32_t height)
+	{
+		SetResolution(width, height);
+		_occluderFirst.assign(1, 0);
+	}
+
+	void OcclusionCuller::SetResolution(uint32_t width, uint32_t height)
+	{
+		_tilesX = std::max(1u, (width + TileWidth - 1) / TileWidth);
+		_tilesY = std::max(1u, (height + TileHeight - 1) / TileHeight);
+		_width = _tilesX * TileWidth;
+		_height = _tilesY * TileHeight;
+		_depth0.assign(size_t(_tilesX) * _tilesY, 1.0f);
+		_mask1.assign(size_t(_tilesX) * _tilesY, 0);
+		_depth1.assign(size_t(_tilesX) * _tilesY, 0.0f);
+	}
+
+	void OcclusionCuller::Begin(const glm::mat4& viewProj)
+	{
+		_viewProj = viewProj;
+		std::fill(_depth0.begin(), _depth0.end(), 1.0f);
+		std::fill(_mask1.begin(), _mask1.end(), 0);
+		std::fill(_depth1.begin(), _depth1.end(), 0.0f);
+		_occluders.clear();
+		_occluderFirst.assign(1, 0);
+		_stats = OcclusionStats{};
+	}
+
+	void OcclusionCuller::AddOccluder(const glm::vec3* vertices, const uint32_t* indices, uint32_t indexCount,
+									  const glm::mat4& model)
+	{
+		const uint32_t triangleCount = indexCount / 3;
+		if (triangleCount == 0) return;
+		_occluders.push_back(Occluder{vertices, indices, triangleCount, _viewProj * model});
+		_occluderFirst.push_back(_occluderFirst.back() + triangleCount);
+	}
+
+	uint32_t OcclusionCuller::SetupTriangle(const glm::vec4 (&clip)[3], ScreenTriangle* out) const
+	{
+		// Sutherland-Hodgman against the near plane z + w >= 0, the other planes are handled by the tile bounds
+		glm::vec4 polygon[4];
+		uint32_t vertexCount = 0;
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			const glm::vec4& a = clip[i];
+			const glm::vec4& b = clip[(i + 1) % 3];
+			const float da = a.z + a.w;
+			const float db = b.z + b.w;
+			if (da >= 0.0f) polygon[vertexCount++] = a;
+			if ((da >= 0.0f) != (db >= 0.0f)) polygon[vertexCount++] = a + (b - a) * (da / (da - db));
+		}
+		if (vertexCount < 3) return 0;
+
+		glm::vec3 screen[4];
+		for (uint32_t i = 0; i < vertexCount; i++)
+		{
+			if (polygon[i].w <= 0.0f) return 0;
+			const glm::vec3 ndc = glm::vec3(polygon[i]) / polygon[i].w;
+			screen[i] = glm::vec3((ndc.x * 0.5f + 0.5f) * _width, (ndc.y * 0.5f + 0.5f) * _height,
+								  ndc.z * 0.5f + 0.5f);
+		}
+
+		// Fan the clipped polygon
+		uint32_t count = 0;
+		for (uint32_t i = 1; i + 1 < vertexCount; i++)
+		{
+			const glm::vec3 v[3] = {screen[0], screen[i], screen[i + 1]};
+			const float area = (v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[2].x - v[0].x) * (v[1].y - v[0].y);
+			if (!(area > 0.0f)) continue;
+
+			const float minX = std::min({v[0].x, v[1].x, v[2].x});
+			const float maxX = std::max({v[0].x, v[1].x, v[2].x});
+			const float minY = std::min({v[0].y, v[1].y, v[2].y});
+			const float maxY = std::max({v[0].y, v[1].y, v[2].y});
+			const float minZ = std::min({v[0].z, v[1].z, v[2].z});
+			if (maxX <= 0.0f || maxY <= 0.0f || minX >= _width || minY >= _height || minZ >= 1.0f) continue;
+
+			ScreenTriangle& triangle = out[count++];
+			triangle.tileMinX = static_cast<uint32_t>(std::max(minX, 0.0f)) / TileWidth;
+			triangle.tileMinY = static_cast<uint32_t>(std::max(minY, 0.0f)) / TileHeight;
+			triangle.tileMaxX = (static_cast<uint32_t>(std::ceil(std::min(maxX, float(_width)))) - 1) / TileWidth;
+			triangle.tileMaxY = (static_cast<uint32_t>(std::ceil(std::min(maxY, float(_height)))) - 1) / TileHeight;
+
+			// Counter clockwise, a pixel is inside where all three edge functions are >= 0
+			for (uint32_t e = 0; e < 3; e++)
+			{
+				const glm::vec3& a = v[e];
+				const glm::vec3& b = v[(e + 1) % 3];
+				triangle.edgeA[e] = a.y - b.y;
+				triangle.edgeB[e] = b.x - a.x;
+				triangle.edgeC[e] = -(triangle.edgeA[e] * a.x + triangle.edgeB[e] * a.y);
+			}
+
+			// z = depthA * x + depthB * y + depthC
+			const glm::vec3 d1 = v[1] - v[0];
+			const glm::vec3 d2 = v[2] - v[0];
+			triangle.depthA = (d1.z * d2.y - d2.z * d1.y) / area;
+			triangle.depthB = (d1.x * d2.z - d2.x * d1.z) / area;
+			triangle.depthC = v[0].z - triangle.depthA * v[0].x - triangle.depthB * v[0].y;
+			triangle.depthMax = std::max({v[0].z, v[1].z, v[2].z});
+		}
+		return count;
+	}
+
+	void OcclusionCuller::UpdateTile(uint32_t tile, uint32_t coverage, float depth)
+	{
+		const float depth0 = _depth0[tile];
+		if (depth >= depth0) return;
+
+		uint32_t mask = _mask1[tile];
+		float depth1 = _depth1[tile];
+		// Closer to the reference than to the working layer, merging would push the working depth back a lot:
+		// drop the working layer and start a new one from this triangle
+		if (mask != 0 && depth - depth1 > depth0 - depth)
+		{
+			mask = 0;
+			depth1 = 0.0f;
+		}
+
+		mask |= coverage;
+		depth1 = std::max(depth1, depth);
+		if (mask == FullCoverage)
+		{
+			// Every pixel is now at most depth1 away, which becomes the reference
+			_depth0[tile] = depth1;
+			mask = 0;
+			depth1 = 0.0f;
+		}
+		_mask1[tile] = mask;
+		_depth1[tile] = depth1;
+	}
+
+	template <typename V>
+	void OcclusionCuller::RasterizeBand(uint32_t tileRowBegin, uint32_t tileRowEnd)
+	{
+		constexpr uint32_t Groups = TileWidth / V::Width;
+		const V zero = V::Set(0.0f);
+		V lanes[Groups];
+		for (uint32_t g = 0; g < Groups; g++)
+		{
+			lanes[g] = V::Load(LaneOffsets + g * V::Width);
+		}
+
+		for (const ScreenTriangle& triangle : _triangles)
+		{
+			const uint32_t rowBegin = std::max(triangle.tileMinY, tileRowBegin);
+			const uint32_t rowEnd = std::min(triangle.tileMaxY + 1, tileRowEnd);
+			if (rowBegin >= rowEnd) continue;
+
+			const V edgeA[3] = {V::Set(triangle.edgeA[0]), V::Set(triangle.edgeA[1]), V::Set(triangle.edgeA[2])};
+			for (uint32_t ty = rowBegin; ty < rowEnd; ty++)
+			{
+				// Edge functions without the x term, per pixel row of the tile row
+				float rowC[TileHeight][3];
+				for (uint32_t r = 0; r < TileHeight; r++)
+				{
+					const float y = float(ty * TileHeight + r) + 0.5f;
+					for (uint32_t e = 0; e < 3; e++)
+					{
+						rowC[r][e] = triangle.edgeB[e] * y + triangle.edgeC[e];
+					}
+				}
+
+				for (uint32_t tx = triangle.tileMinX; tx <= triangle.tileMaxX; tx++)
+				{
+					const float x0 = float(tx * TileWidth);
+					V x[Groups];
+					for (uint32_t g = 0; g < Groups; g++)
+					{
+						x[g] = lanes[g] + V::Set(x0);
+					}
+
+					uint32_t coverage = 0;
+					for (uint32_t r = 0; r < TileHeight; r++)
+					{
+						const V c0 = V::Set(rowC[r][0]), c1 = V::Set(rowC[r][1]), c2 = V::Set(rowC[r][2]);
+						for (uint32_t g = 0; g < Groups; g++)
+						{
+							const V inside = Min(MulAdd(edgeA[0], x[g], c0),
+												 Min(MulAdd(edgeA[1], x[g], c1), MulAdd(edgeA[2], x[g], c2)));
+							coverage |= GreaterEqualMask(inside, zero) << (r * TileWidth + g * V::Width);
+						}
+					}
+					if (coverage == 0) continue;
+
+					// Farthest point of the depth plane over the tile, never past the farthest vertex
+					const float cornerX = triangle.depthA >= 0.0f ? x0 + TileWidth : x0;
+					const float cornerY = float(ty * TileHeight) + (triangle.depthB >= 0.0f ? TileHeight : 0.0f);
+					const float depth =
+						std::min(triangle.depthMax,
+								 triangle.depthA * cornerX + triangle.depthB * cornerY + triangle.depthC);
+					UpdateTile(ty * _tilesX + tx, coverage, depth);
+				}
+			}
+		}
+	}
+
+	void OcclusionCuller::Rasterize(JobSystem* jobs)
+	{
+		const auto start = std::chrono::steady_clock::now();
+
+		const uint32_t triangleCount = _occluderFirst.back();
+		_setup.resize(size_t(triangleCount) * 2);
+		_setupCounts.resize(triangleCount);
+		parallelRange(jobs, triangleCount, TrianglesPerJob, [this](uint32_t begin, uint32_t end) {
+			uint32_t occluder = static_cast<uint32_t>(
+				std::upper_bound(_occluderFirst.begin(), _occluderFirst.end(), begin) - _occluderFirst.begin() - 1);
+			for (uint32_t t = begin; t < end; t++)
+			{
+				while (t >= _occluderFirst[occluder + 1])
+				{
+					occluder++;
+				}
+				const Occluder& mesh = _occluders[occluder];
+				const uint32_t* indices = mesh.indices + size_t(t - _occluderFirst[occluder]) * 3;
+				const glm::vec4 clip[3] = {mesh.modelViewProj * glm::vec4(mesh.vertices[indices[0]], 1.0f),
+										   mesh.modelViewProj * glm::vec4(mesh.vertices[indices[1]], 1.0f),
+										   mesh.modelViewProj * glm::vec4(mesh.vertices[indices[2]], 1.0f)};
+				_setupCounts[t] = static_cast<uint8_t>(SetupTriangle(clip, &_setup[size_t(t) * 2]));
+			}
+		});
+
+		// Keep submission order, the bands rely on it to stay deterministic
+		_triangles.clear();
+		for (uint32_t t = 0; t < triangleCount; t++)
+		{
+			_triangles.insert(_triangles.end(), _setup.begin() + size_t(t) * 2,
+							  _setup.begin() + size_t(t) * 2 + _setupCounts[t]);
+		}
+
+		const uint32_t bands = (_tilesY + TileRowsPerBand - 1) / TileRowsPerBand;
+		parallelRange(jobs, bands, 1, [this](uint32_t begin, uint32_t end) {
+			for (uint32_t band = begin; band < end; band++)
+			{
+				RasterizeBand<rv::FloatV>(band * TileRowsPerBand, std::min(_tilesY, (band + 1) * TileRowsPerBand));
+			}
+		});
+
+		_stats.occluderTriangles += triangleCount;
+		_stats.rasterizedTriangles += static_cast<uint32_t>(_triangles.size());
+		_stats.rasterMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	bool OcclusionCuller::IsVisible(const rv::AABB& box) const
+	{
+		float minX = float(_width), minY = float(_height), minDepth = 1.0f;
+		float maxX = 0.0f, maxY = 0.0f;
+		for (uint32_t corner = 0; corner < 8; corner++)
+		{
+			const glm::vec4 clip = _viewProj * glm::vec4(corner & 1 ? box.max.x : box.min.x,
+														 corner & 2 ? box.max.y : box.min.y,
+														 corner & 4 ? box.max.z : box.min.z, 1.0f);
+			// Crossing the near plane, the projected rectangle would be meaningless
+			if (clip.z + clip.w <= 0.0f || clip.w <= 0.0f) return true;
+
+			const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+			const float x = (ndc.x * 0.5f + 0.5f) * _width;
+			const float y = (ndc.y * 0.5f + 0.5f) * _height;
+			minX = std::min(minX, x);
+			maxX = std::max(maxX, x);
+			minY = std::min(minY, y);
+			maxY = std::max(maxY, y);
+			minDepth = std::min(minDepth, ndc.z * 0.5f + 0.5f);
+		}
+		minDepth -= DepthEpsilon;
+
+		// Every pixel the rectangle touches, off screen boxes touch none
+		const uint32_t x0 = static_cast<uint32_t>(std::max(minX, 0.0f));
+		const uint32_t y0 = static_cast<uint32_t>(std::max(minY, 0.0f));
+		const uint32_t x1 = static_cast<uint32_t>(std::ceil(std::min(maxX, float(_width))));
+		const uint32_t y1 = static_cast<uint32_t>(std::ceil(std::min(maxY, float(_height))));
+		if (x0 >= x1 || y0 >= y1) return false;
+
+		for (uint32_t ty = y0 / TileHeight; ty <= (y1 - 1) / TileHeight; ty++)
+		{
+			const uint32_t rowBegin = std::max(y0, ty * TileHeight) - ty * TileHeight;
+			const uint32_t rowEnd = std::min(y1, (ty + 1) * TileHeight) - ty * TileHeight;
+			for (uint32_t tx = x0 / TileWidth; tx <= (x1 - 1) / TileWidth; tx++)
+			{
+				const uint32_t tile = ty * _tilesX + tx;
+				if (minDepth > _depth0[tile]) continue;
+
+				const uint32_t columns = spanBits(std::max(x0, tx * TileWidth) - tx * TileWidth,
+												  std::min(x1, (tx + 1) * TileWidth) - tx * TileWidth);
+				uint32_t coverage = 0;
+				for (uint32_t r = rowBegin; r < rowEnd; r++)
+				{
+					coverage |= columns << (r * TileWidth);
+				}
+				// Some pixel only behind the reference layer, or the box is in front of the working layer too
+				if ((coverage & ~_mask1[tile]) != 0 || minDepth <= _depth1[tile]) return true;
+			}
+		}
+		return false;
+	}
+
+	rv::Span<const uint32_t> OcclusionCuller::Cull(JobSystem& jobs, rv::Span<const uint32_t> candidates,
+												   const rv::BoundsSoA& bounds)
+	{
+		const auto start = std::chrono::steady_clock::now();
+
+		const size_t count = candidates.size();
+		if (_visible.size() < count) _visible.resize(count);
+		const uint32_t chunks = static_cast<uint32_t>((count + ChunkSize - 1) / ChunkSize);
+		_chunkCounts.resize(chunks);
+
+		jobs.ParallelFor(chunks, 1, [&](uint32_t begin, uint32_t end) {
+			for (uint32_t chunk = begin; chunk < end; chunk++)
+			{
+				const size_t first = size_t(chunk) * ChunkSize;
+				const size_t last = std::min(first + ChunkSize, count);
+				uint32_t visible = 0;
+				for (size_t i = first; i < last; i++)
+				{
+					if (IsVisible(bounds.Get(candidates[i]))) _visible[first + visible++] = candidates[i];
+				}
+				_chunkCounts[chunk] = visible;
+			}
+		});
+
+		_visibleCount = 0;
+		for (uint32_t chunk = 0; chunk < chunks; chunk++)
+		{
+			const uint32_t* first = _visible.data() + size_t(chunk) * ChunkSize;
+			std::copy(first, first + _chunkCounts[chunk], _visible.data() + _visibleCount);
+			_visibleCount += _chunkCounts[chunk];
+		}
+
+		_stats.tested = static_cast<uint32_t>(count);
+		_stats.visible = static_cast<uint32_t>(_visibleCount);
+		_stats.occluded = _stats.tested - _stats.visible;
+		_stats.testMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		return GetVisible();
+	}
+
+	void OcclusionCuller::ResolveDepth(std::vector<float>& outDepth) const
+	{
+		outDepth.resize(size_t(_width) * _height);
+		for (uint32_t y = 0; y < _height; y++)
+		{
+			for (uint32_t x = 0; x < _width; x++)
+			{
+				const uint32_t tile = (y / TileHeight) * _tilesX + x / TileWidth;
+				const uint32_t bit = 1u << ((y % TileHeight) * TileWidth + x % TileWidth);
+				outDepth[size_t(y) * _width + x] = (_mask1[tile] & bit) ? _depth1[tile] : _depth0[tile];
+			}
+		}
+	}
+
+} // namespace gefx
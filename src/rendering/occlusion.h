@@ -0,0 +1,161 @@
+#ifndef __OCCLUSION__H__
+#define __OCCLUSION__H__
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <core/jobs.h>
+#include <core/math/transform.h>
+#include <core/span.h>
+
+namespace gefx
+{
+	struct OcclusionStats
+	{
+		uint32_t occluderTriangles{0};
+		// After near plane clipping, back face and off screen rejection
+		uint32_t rasterizedTriangles{0};
+		uint32_t tested{0};
+		uint32_t visible{0};
+		uint32_t occluded{0};
+		double rasterMs{0.0};
+		double testMs{0.0};
+	};
+
+	/**
+	 * @brief Masked software occlusion culling on the CPU.
+	 *
+	 * Occluders are rasterized into a low resolution depth buffer made of 8x4 pixel tiles. A tile doesn't store
+	 * per pixel depths but two conservative layers: a reference far depth valid for the whole tile, and a working
+	 * layer with a 32 bit coverage mask and the farthest depth of the pixels it covers. Triangles add their
+	 * coverage to the working layer, and once it covers the whole tile it becomes the new reference. Coverage
+	 * masks are computed a row of pixels per SIMD instruction.
+	 *
+	 * Rasterization runs on the job system in two passes: triangles are transformed, near clipped and set up in
+	 * parallel, then every band of tile rows is filled by its own job, walking the triangles in submission order.
+	 * Results only depend on the inputs, never on thread timing.
+	 *
+	 * Occludees are tested with the screen rectangle and nearest depth of their bounding box, which never hides
+	 * something visible as long as the occluders are inside the real geometry.
+	 *
+	 * Depth is GL style: NDC z in [-1, 1] mapped to [0, 1], smaller is closer. Occluder triangles are counter
+	 * clockwise when front facing, back faces are skipped.
+	 */
+	class OcclusionCuller
+	{
+	  public:
+		static constexpr uint32_t TileWidth = 8;
+		static constexpr uint32_t TileHeight = 4;
+		static constexpr uint32_t ChunkSize = 1024;
+
+		explicit OcclusionCuller(uint32_t width = 320, uint32_t height = 192);
+		~OcclusionCuller() = default;
+
+		OcclusionCuller(OcclusionCuller&&) = delete;
+		OcclusionCuller(const OcclusionCuller&) = delete;
+		OcclusionCuller& operator=(OcclusionCuller&&) = delete;
+		OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+		/**
+		 * @brief Resize and clear the depth buffer, rounded up to whole tiles.
+		 */
+		void SetResolution(uint32_t width, uint32_t height);
+		uint32_t GetWidth() const { return _width; };
+		uint32_t GetHeight() const { return _height; };
+
+		/**
+		 * @brief Clear the depth buffer and the queued occluders for a new view.
+		 */
+		void Begin(const glm::mat4& viewProj);
+
+		/**
+		 * @brief Queue an indexed triangle mesh as occluder. vertices and indices are referenced, not copied, and
+		 * must stay alive until Rasterize returns.
+		 */
+		void AddOccluder(const glm::vec3* vertices, const uint32_t* indices, uint32_t indexCount,
+						 const glm::mat4& model);
+
+		/**
+		 * @brief Rasterize every queued occluder.
+		 *
+		 * @param jobs Job system to spread the work on, nullptr rasterizes on the calling thread.
+		 */
+		void Rasterize(JobSystem* jobs = nullptr);
+
+		/**
+		 * @brief Whether any part of a world space box may be visible over the rasterized occluders. Boxes
+		 * crossing the near plane are always visible. Safe to call from several threads once Rasterize returned.
+		 */
+		bool IsVisible(const rv::AABB& box) const;
+
+		/**
+		 * @brief Keep the candidates (indices into bounds, typically FrustumCuller's output) that IsVisible, in
+		 * order. The view stays valid until the next Cull.
+		 */
+		rv::Span<const uint32_t> Cull(JobSystem& jobs, rv::Span<const uint32_t> candidates,
+									  const rv::BoundsSoA& bounds);
+
+		rv::Span<const uint32_t> GetVisible() const
+		{
+			return rv::Span<const uint32_t>(_visible.data(), _visibleCount);
+		};
+		const OcclusionStats& GetStats() const { return _stats; };
+
+		/**
+		 * @brief Conservative depth of every pixel, row major from the bottom row, for debugging and comparisons.
+		 */
+		void ResolveDepth(std::vector<float>& outDepth) const;
+
+	  private:
+		struct Occluder
+		{
+			const glm::vec3* vertices;
+			const uint32_t* indices;
+			uint32_t triangleCount;
+			glm::mat4 modelViewProj;
+		};
+
+		// Edge functions and depth plane of a triangle in pixel space
+		struct ScreenTriangle
+		{
+			float edgeA[3], edgeB[3], edgeC[3];
+			float depthA, depthB, depthC;
+			float depthMax;
+			uint32_t tileMinX, tileMaxX, tileMinY, tileMaxY;
+		};
+
+		uint32_t SetupTriangle(const glm::vec4 (&clip)[3], ScreenTriangle* out) const;
+		template <typename V>
+		void RasterizeBand(uint32_t tileRowBegin, uint32_t tileRowEnd);
+		void UpdateTile(uint32_t tile, uint32_t coverage, float depth);
+
+		uint32_t _width{0};
+		uint32_t _height{0};
+		uint32_t _tilesX{0};
+		uint32_t _tilesY{0};
+		glm::mat4 _viewProj{1.0f};
+
+		// Per tile: reference layer depth, working layer coverage and depth
+		std::vector<float> _depth0;
+		std::vector<uint32_t> _mask1;
+		std::vector<float> _depth1;
+
+		std::vector<Occluder> _occluders;
+		// First triangle of every occluder in the flattened triangle numbering, plus the total
+		std::vector<uint32_t> _occluderFirst;
+		// Two slots per input triangle, since near clipping can split it
+		std::vector<ScreenTriangle> _setup;
+		std::vector<uint8_t> _setupCounts;
+		std::vector<ScreenTriangle> _triangles;
+
+		std::vector<uint32_t> _visible;
+		size_t _visibleCount{0};
+		std::vector<uint32_t> _chunkCounts;
+		OcclusionStats _stats;
+	};
+
+} // namespace gefx
+
+#endif //!__OCCLUSION__H__
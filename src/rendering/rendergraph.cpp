@@ -0,0 +1,480 @@
+// StdLib Includes
+#include <algorithm>
+#include <cassert>
+
+// Third Party Includes
+#include <fmt/format.h>
+
+// Application Specific Includes
+#include <core/jobs.h>
+#include <rendering/rendergraph.h>
+
+namespace gefx
+{
+	namespace
+	{
+		bool sameDesc(const TextureDesc& a, const TextureDesc& b)
+		{
+			return a.width == b.width && a.height == b.height && a.levels == b.levels && a.format == b.format &&
+				   a.usage == b.usage;
+		}
+
+		uint64_t getTextureBytes(const TextureDesc& desc)
+		{
+			uint64_t bytes = 0;
+			for (uint32_t level = 0; level < desc.levels; level++)
+			{
+				bytes += uint64_t(std::max(desc.width >> level, 1u)) * std::max(desc.height >> level, 1u) *
+						 getFormatSize(desc.format);
+			}
+			return bytes;
+		}
+
+		const char* getStateName(TextureState state)
+		{
+			switch (state)
+			{
+			case TextureState::ColorAttachment:
+				return "ColorAttachment";
+			case TextureState::DepthAttachment:
+				return "DepthAttachment";
+			case TextureState::ShaderRead:
+				return "ShaderRead";
+			case TextureState::Present:
+				return "Present";
+			default:
+				return "Undefined";
+			}
+		}
+	} // namespace
+
+	RenderGraphTexture RenderGraphBuilder::CreateTexture(const char* name, const TextureDesc& desc)
+	{
+		_graph._textures.push_back(RenderGraph::Texture{name, desc, {}, false, TextureState::Undefined,
+														TextureState::Undefined, 0, 0, RenderGraphTexture::Invalid});
+		return RenderGraphTexture{static_cast<uint32_t>(_graph._textures.size() - 1)};
+	}
+
+	void RenderGraphBuilder::Read(RenderGraphTexture texture)
+	{
+		assert(texture.index < _graph._textures.size() && "texture of another graph");
+		_graph._passes[_pass].uses.push_back(RenderGraph::TextureUse{texture.index, RenderGraph::Access::Read, false});
+	}
+
+	void RenderGraphBuilder::WriteColor(RenderGraphTexture texture, bool clear, glm::vec4 clearValue)
+	{
+		assert(texture.index < _graph._textures.size() && "texture of another graph");
+		RenderGraph::Pass& pass = _graph._passes[_pass];
+		pass.uses.push_back(RenderGraph::TextureUse{texture.index, RenderGraph::Access::Color, clear});
+		pass.clearColor = clearValue;
+	}
+
+	void RenderGraphBuilder::WriteDepth(RenderGraphTexture texture, bool clear, float clearValue)
+	{
+		assert(texture.index < _graph._textures.size() && "texture of another graph");
+		RenderGraph::Pass& pass = _graph._passes[_pass];
+		pass.uses.push_back(RenderGraph::TextureUse{texture.index, RenderGraph::Access::Depth, clear});
+		pass.clearDepth = clearValue;
+	}
+
+	void RenderGraphBuilder::SetSideEffects()
+	{
+		_graph._passes[_pass].sideEffects = true;
+	}
+
+	void RenderGraphBuilder::SetCommandLists(uint32_t count)
+	{
+		_graph._passes[_pass].listCount = std::max(count, 1u);
+	}
+
+	TextureHandle RenderPassContext::Get(RenderGraphTexture texture) const
+	{
+		return graph.GetTexture(texture);
+	}
+
+	void RenderGraph::Reset()
+	{
+		_passes.clear();
+		_textures.clear();
+		_order.clear();
+		_finalBarriers.clear();
+		_slots.clear();
+		_slotTextures.clear();
+		_stats = RenderGraphStats{};
+		_compiled = false;
+	}
+
+	void RenderGraph::Shutdown(IDevice& device)
+	{
+		for (const Physical& physical : _physical)
+		{
+			device.Destroy(physical.handle);
+		}
+		_physical.clear();
+		_lists.clear();
+		Reset();
+	}
+
+	RenderGraphTexture RenderGraph::ImportTexture(const char* name, TextureHandle handle, const TextureDesc& desc,
+												  TextureState before, TextureState after)
+	{
+		_textures.push_back(Texture{name, desc, handle, true, before, after, 0, 0, RenderGraphTexture::Invalid});
+		return RenderGraphTexture{static_cast<uint32_t>(_textures.size() - 1)};
+	}
+
+	RenderGraph::PassId RenderGraph::AddPass(const char* name, const SetupFn& setup, ExecuteFn execute)
+	{
+		const PassId id = static_cast<PassId>(_passes.size());
+		_passes.push_back(Pass{name, std::move(execute), {}, glm::vec4(0.0f), 1.0f, 1, false, false, {}, {}});
+		RenderGraphBuilder builder(*this, id);
+		if (setup) setup(builder);
+		_compiled = false;
+		return id;
+	}
+
+	bool RenderGraph::Compile(std::string& outError)
+	{
+		_compiled = false;
+		_order.clear();
+		_finalBarriers.clear();
+		_stats = RenderGraphStats{};
+		for (Texture& texture : _textures)
+		{
+			texture.firstUse = RenderGraphTexture::Invalid;
+			texture.lastUse = RenderGraphTexture::Invalid;
+			texture.physical = RenderGraphTexture::Invalid;
+		}
+
+		Cull();
+		if (!PlanBarriers(outError)) return false;
+		Alias();
+
+		_stats.passes = static_cast<uint32_t>(_order.size());
+		_stats.culledPasses = static_cast<uint32_t>(_passes.size() - _order.size());
+		_stats.barriers = static_cast<uint32_t>(_finalBarriers.size());
+		for (const PassId id : _order)
+		{
+			_stats.barriers += static_cast<uint32_t>(_passes[id].barriers.size());
+		}
+		_compiled = true;
+		return true;
+	}
+
+	void RenderGraph::Cull()
+	{
+		// Back to front: a pass lives when it has side effects or writes something a live pass after it, or
+		// the caller, still needs. A clearing write makes what was there before unneeded.
+		std::vector<bool> needed(_textures.size());
+		for (size_t i = 0; i < _textures.size(); i++)
+		{
+			needed[i] = _textures[i].imported;
+		}
+		for (size_t i = _passes.size(); i-- > 0;)
+		{
+			Pass& pass = _passes[i];
+			const bool used = std::any_of(pass.uses.begin(), pass.uses.end(), [&](const TextureUse& use) {
+				return use.access != Access::Read && needed[use.texture];
+			});
+			pass.culled = !pass.sideEffects && !used;
+			if (pass.culled) continue;
+
+			for (const TextureUse& use : pass.uses)
+			{
+				if (use.access != Access::Read && use.clear) needed[use.texture] = false;
+			}
+			for (const TextureUse& use : pass.uses)
+			{
+				if (use.access == Access::Read || !use.clear) needed[use.texture] = true;
+			}
+		}
+
+		for (PassId id = 0; id < _passes.size(); id++)
+		{
+			if (!_passes[id].culled) _order.push_back(id);
+		}
+	}
+
+	bool RenderGraph::PlanBarriers(std::string& outError)
+	{
+		std::vector<TextureState> states(_textures.size());
+		std::vector<PassId> writers(_textures.size(), RenderGraphTexture::Invalid);
+		for (size_t i = 0; i < _textures.size(); i++)
+		{
+			states[i] = _textures[i].before;
+		}
+
+		for (uint32_t position = 0; position < _order.size(); position++)
+		{
+			Pass& pass = _passes[_order[position]];
+			pass.dependencies.clear();
+			pass.barriers.clear();
+			uint32_t colors = 0, depths = 0, width = 0, height = 0;
+			for (size_t u = 0; u < pass.uses.size(); u++)
+			{
+				const TextureUse& use = pass.uses[u];
+				Texture& texture = _textures[use.texture];
+				const bool write = use.access != Access::Read;
+
+				// Reading twice is fine, anything else on the same texture is a feedback loop
+				bool repeated = false;
+				for (size_t v = 0; v < u; v++)
+				{
+					if (pass.uses[v].texture != use.texture) continue;
+					if (write || pass.uses[v].access != Access::Read)
+					{
+						outError = fmt::format("Pass {} uses {} more than once with writes", pass.name, texture.name);
+						return false;
+					}
+					repeated = true;
+				}
+				if (repeated) continue;
+
+				if (!write && !texture.imported && writers[use.texture] == RenderGraphTexture::Invalid)
+				{
+					outError = fmt::format("Pass {} reads {} before any pass writes it", pass.name, texture.name);
+					return false;
+				}
+				if (write)
+				{
+					colors += use.access == Access::Color ? 1 : 0;
+					depths += use.access == Access::Depth ? 1 : 0;
+					if (width != 0 && (texture.desc.width != width || texture.desc.height != height))
+					{
+						outError = fmt::format("Pass {} has attachments of different sizes", pass.name);
+						return false;
+					}
+					width = texture.desc.width;
+					height = texture.desc.height;
+				}
+
+				const PassId writer = writers[use.texture];
+				if ((!write || !use.clear) && writer != RenderGraphTexture::Invalid &&
+					std::find(pass.dependencies.begin(), pass.dependencies.end(), writer) == pass.dependencies.end())
+				{
+					pass.dependencies.push_back(writer);
+				}
+
+				// Writes after writes get one too, the second pass waits for the first
+				const TextureState state = use.access == Access::Read	 ? TextureState::ShaderRead
+										   : use.access == Access::Color ? TextureState::ColorAttachment
+																		 : TextureState::DepthAttachment;
+				if (states[use.texture] != state || write)
+				{
+					const TextureState before = write && use.clear ? TextureState::Undefined : states[use.texture];
+					pass.barriers.push_back(RenderGraphBarrier{RenderGraphTexture{use.texture}, before, state});
+				}
+				states[use.texture] = state;
+				if (write) writers[use.texture] = _order[position];
+
+				if (texture.firstUse == RenderGraphTexture::Invalid) texture.firstUse = position;
+				texture.lastUse = position;
+			}
+
+			// The device API renders depth along with a color target, a null one being the back buffer
+			if (colors > 1 || depths > 1 || (depths > 0 && colors == 0))
+			{
+				outError = fmt::format("Pass {} needs one color attachment and at most one depth", pass.name);
+				return false;
+			}
+		}
+
+		for (uint32_t i = 0; i < _textures.size(); i++)
+		{
+			const Texture& texture = _textures[i];
+			if (texture.imported && texture.firstUse != RenderGraphTexture::Invalid && states[i] != texture.after)
+			{
+				_finalBarriers.push_back(RenderGraphBarrier{RenderGraphTexture{i}, states[i], texture.after});
+			}
+		}
+		return true;
+	}
+
+	void RenderGraph::Alias()
+	{
+		// Transient textures by first use, each into the first slot alike that is free by then
+		std::vector<uint32_t> transients;
+		for (uint32_t i = 0; i < _textures.size(); i++)
+		{
+			if (!_textures[i].imported && _textures[i].firstUse != RenderGraphTexture::Invalid) transients.push_back(i);
+		}
+		std::stable_sort(transients.begin(), transients.end(),
+						 [&](uint32_t a, uint32_t b) { return _textures[a].firstUse < _textures[b].firstUse; });
+
+		_slots.clear();
+		std::vector<uint32_t> slotEnds;
+		for (const uint32_t index : transients)
+		{
+			Texture& texture = _textures[index];
+			uint32_t slot = 0;
+			while (slot < _slots.size() && !(sameDesc(_slots[slot], texture.desc) && slotEnds[slot] < texture.firstUse))
+			{
+				slot++;
+			}
+			if (slot == _slots.size())
+			{
+				_slots.push_back(texture.desc);
+				slotEnds.push_back(0);
+				_stats.physicalBytes += getTextureBytes(texture.desc);
+			}
+			slotEnds[slot] = texture.lastUse;
+			texture.physical = slot;
+			_stats.transientTextures++;
+			_stats.transientBytes += getTextureBytes(texture.desc);
+		}
+		_stats.physicalTextures = static_cast<uint32_t>(_slots.size());
+	}
+
+	void RenderGraph::AcquireTextures(IDevice& device)
+	{
+		for (Physical& physical : _physical)
+		{
+			physical.unusedFrames++;
+		}
+
+		_slotTextures.assign(_slots.size(), TextureHandle());
+		for (size_t slot = 0; slot < _slots.size(); slot++)
+		{
+			auto found = std::find_if(_physical.begin(), _physical.end(), [&](const Physical& physical) {
+				return physical.unusedFrames > 0 && sameDesc(physical.desc, _slots[slot]);
+			});
+			if (found == _physical.end())
+			{
+				_physical.push_back(Physical{_slots[slot], device.CreateTexture(_slots[slot]), 0});
+				found = _physical.end() - 1;
+			}
+			found->unusedFrames = 0;
+			_slotTextures[slot] = found->handle;
+		}
+
+		// Graphs come and go with settings, keep their textures around for a while
+		_physical.erase(std::remove_if(_physical.begin(), _physical.end(),
+									   [&](const Physical& physical) {
+										   if (physical.unusedFrames < UnusedTextureFrames) return false;
+										   device.Destroy(physical.handle);
+										   return true;
+									   }),
+						_physical.end());
+	}
+
+	void RenderGraph::Execute(IDevice& device, JobSystem* jobs)
+	{
+		assert(_compiled && "Compile the graph before executing it");
+		if (!_compiled) return;
+		AcquireTextures(device);
+
+		uint32_t listCount = 0;
+		for (const PassId id : _order)
+		{
+			listCount += _passes[id].listCount;
+		}
+		if (_lists.size() < listCount) _lists.resize(listCount);
+
+		uint32_t first = 0;
+		for (const PassId id : _order)
+		{
+			const Pass& pass = _passes[id];
+			CommandList* lists = _lists.data() + first;
+			for (uint32_t i = 0; i < pass.listCount; i++)
+			{
+				lists[i].Reset();
+			}
+
+			RenderPassDesc desc;
+			bool attachments = false;
+			for (const TextureUse& use : pass.uses)
+			{
+				if (use.access == Access::Read) continue;
+				const Texture& texture = _textures[use.texture];
+				if (use.access == Access::Color)
+				{
+					desc.color = GetTexture(RenderGraphTexture{use.texture});
+					desc.clearColor = use.clear;
+					desc.clearColorValue = pass.clearColor;
+				}
+				else
+				{
+					desc.depth = GetTexture(RenderGraphTexture{use.texture});
+					desc.clearDepth = use.clear;
+					desc.clearDepthValue = pass.clearDepth;
+				}
+				desc.width = texture.desc.width;
+				desc.height = texture.desc.height;
+				attachments = true;
+			}
+
+			// The pass begins in its first list and ends in its last, the lists between continue it
+			if (attachments) lists[0].BeginRenderPass(desc);
+			if (pass.execute)
+			{
+				const RenderPassContext context{*this, desc.width, desc.height, pass.listCount};
+				auto record = [&](uint32_t begin, uint32_t end) {
+					for (uint32_t list = begin; list < end; list++)
+					{
+						pass.execute(context, lists[list], list);
+					}
+				};
+				if (jobs && pass.listCount > 1)
+				{
+					jobs->ParallelFor(pass.listCount, 1, record);
+				}
+				else
+				{
+					record(0, pass.listCount);
+				}
+			}
+			if (attachments) lists[pass.listCount - 1].EndRenderPass();
+			first += pass.listCount;
+		}
+
+		std::vector<const CommandList*> submitted(listCount);
+		for (uint32_t i = 0; i < listCount; i++)
+		{
+			submitted[i] = &_lists[i];
+		}
+		if (listCount > 0) device.Submit(rv::Span<const CommandList* const>(submitted.data(), submitted.size()));
+	}
+
+	TextureHandle RenderGraph::GetTexture(RenderGraphTexture texture) const
+	{
+		const Texture& graphTexture = _textures[texture.index];
+		if (graphTexture.imported) return graphTexture.handle;
+		return graphTexture.physical < _slotTextures.size() ? _slotTextures[graphTexture.physical] : TextureHandle();
+	}
+
+	void RenderGraph::Describe(std::string& out) const
+	{
+		for (const PassId id : _order)
+		{
+			const Pass& pass = _passes[id];
+			out += fmt::format("{} ({} lists)", pass.name, pass.listCount);
+			for (size_t i = 0; i < pass.dependencies.size(); i++)
+			{
+				out += fmt::format("{}{}", i == 0 ? " after " : ", ", _passes[pass.dependencies[i]].name);
+			}
+			out += "\n";
+			for (const RenderGraphBarrier& barrier : pass.barriers)
+			{
+				out += fmt::format("  {} {} -> {}\n", _textures[barrier.texture.index].name,
+								   getStateName(barrier.before), getStateName(barrier.after));
+			}
+		}
+		for (const RenderGraphBarrier& barrier : _finalBarriers)
+		{
+			out += fmt::format("final {} {} -> {}\n", _textures[barrier.texture.index].name,
+							   getStateName(barrier.before), getStateName(barrier.after));
+		}
+		for (const Pass& pass : _passes)
+		{
+			if (pass.culled) out += fmt::format("culled {}\n", pass.name);
+		}
+		for (const Texture& texture : _textures)
+		{
+			if (texture.imported || texture.physical == RenderGraphTexture::Invalid) continue;
+			out += fmt::format("{} {}x{} in slot {}, passes {}..{}\n", texture.name, texture.desc.width,
+							   texture.desc.height, texture.physical, texture.firstUse, texture.lastUse);
+		}
+		out += fmt::format("{} transient textures in {} slots, {} of {} bytes saved\n", _stats.transientTextures,
+						   _stats.physicalTextures, _stats.GetSavedBytes(), _stats.transientBytes);
+	}
+
+} // namespace gefx
@@ -0,0 +1,298 @@
+#ifndef __RENDERGRAPH__H__
+#define __RENDERGRAPH__H__
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <rendering/device/commandlist.h>
+#include <rendering/device/device.h>
+
+namespace gefx
+{
+	class JobSystem;
+	class RenderGraph;
+
+	/**
+	 * @brief Texture of a render graph, valid until the graph is reset.
+	 */
+	struct RenderGraphTexture
+	{
+		static constexpr uint32_t Invalid = UINT32_MAX;
+
+		uint32_t index{Invalid};
+
+		bool IsValid() const { return index != Invalid; };
+	};
+
+	enum class TextureState : uint8_t
+	{
+		// Content undefined, transitions from it discard
+		Undefined,
+		ColorAttachment,
+		DepthAttachment,
+		ShaderRead,
+		Present,
+	};
+
+	/**
+	 * @brief State change of a texture ahead of a pass, or at the end of the graph for imported textures.
+	 */
+	struct RenderGraphBarrier
+	{
+		RenderGraphTexture texture;
+		TextureState before;
+		TextureState after;
+	};
+
+	struct RenderGraphStats
+	{
+		uint32_t passes{0};
+		uint32_t culledPasses{0};
+		uint32_t barriers{0};
+		// Transient textures used by passes that survived culling, and the device textures they share
+		uint32_t transientTextures{0};
+		uint32_t physicalTextures{0};
+		// Memory the transient textures would take each on its own, and what they take aliased
+		uint64_t transientBytes{0};
+		uint64_t physicalBytes{0};
+
+		uint64_t GetSavedBytes() const { return transientBytes - physicalBytes; };
+	};
+
+	/**
+	 * @brief Declares what a pass reads and writes, handed to the pass's setup function.
+	 */
+	class RenderGraphBuilder
+	{
+	  public:
+		/**
+		 * @brief Texture created by the graph for this frame, its device texture may be shared with other
+		 * transient textures whose lifetimes don't overlap. The first pass using it must write it.
+		 */
+		RenderGraphTexture CreateTexture(const char* name, const TextureDesc& desc);
+
+		/**
+		 * @brief Sample the texture in the pass's shaders.
+		 */
+		void Read(RenderGraphTexture texture);
+
+		/**
+		 * @brief Render to the texture. Without a clear the pass keeps what earlier passes wrote.
+		 */
+		void WriteColor(RenderGraphTexture texture, bool clear = false, glm::vec4 clearValue = glm::vec4(0.0f));
+		void WriteDepth(RenderGraphTexture texture, bool clear = false, float clearValue = 1.0f);
+
+		/**
+		 * @brief Keep the pass even when nothing uses what it writes.
+		 */
+		void SetSideEffects();
+
+		/**
+		 * @brief Record the pass into count command lists, in parallel when the graph runs with a job system.
+		 */
+		void SetCommandLists(uint32_t count);
+
+	  private:
+		friend class RenderGraph;
+
+		RenderGraphBuilder(RenderGraph& graph, uint32_t pass) : _graph(graph), _pass(pass){};
+
+		RenderGraph& _graph;
+		uint32_t _pass;
+	};
+
+	struct RenderPassContext
+	{
+		const RenderGraph& graph;
+		// Render area, the size of the pass's attachments
+		uint32_t width;
+		uint32_t height;
+		uint32_t listCount;
+
+		/**
+		 * @brief Device texture behind a graph texture, null for the back buffer.
+		 */
+		TextureHandle Get(RenderGraphTexture texture) const;
+	};
+
+	/**
+	 * @brief Frame graph: passes declare the textures they read and write, and the graph works out the rest.
+	 *
+	 * Passes run in the order they were added. Compile culls the passes nothing needs, working back from the
+	 * imported textures and the passes with side effects; a write that clears ends what the texture held, so
+	 * the passes before it only live if something else needs them. It then plans every texture's state
+	 * changes and places the transient textures into device textures: transient textures with the same
+	 * description share one device texture when the live passes using them don't overlap.
+	 *
+	 * Execute creates the device textures (kept across frames for graphs alike), records every live pass
+	 * between the render pass begin and end its writes describe, and submits them together. Backends derive
+	 * the barriers from the recorded passes themselves (the Vulkan device's prescan, none on GL), the planned
+	 * ones are there to inspect and check against.
+	 *
+	 * Building and compiling use no device and can happen on any thread; Execute belongs to the device's
+	 * thread. The graph is meant to be reset and built again every frame.
+	 */
+	class RenderGraph
+	{
+	  public:
+		using PassId = uint32_t;
+		using SetupFn = std::function<void(RenderGraphBuilder&)>;
+		// Records list of the pass's lists, which may run in parallel with the other lists of the pass
+		using ExecuteFn = std::function<void(const RenderPassContext&, CommandList&, uint32_t list)>;
+
+		// Device textures no graph used for this many executes are destroyed
+		static constexpr uint32_t UnusedTextureFrames = 8;
+
+		RenderGraph() = default;
+		~RenderGraph() = default;
+
+		RenderGraph(RenderGraph&&) = delete;
+		RenderGraph(const RenderGraph&) = delete;
+		RenderGraph& operator=(RenderGraph&&) = delete;
+		RenderGraph& operator=(const RenderGraph&) = delete;
+
+		/**
+		 * @brief Drop the passes and textures, the device textures stay for the next graph.
+		 */
+		void Reset();
+
+		/**
+		 * @brief Destroy the device textures, before the device goes away.
+		 */
+		void Shutdown(IDevice& device);
+
+		/**
+		 * @brief Texture the graph doesn't own: in state before ahead of the graph, left in state after. A null
+		 * handle is the back buffer. The last writes to imported textures are kept, earlier ones a clear
+		 * overwrites are culled.
+		 */
+		RenderGraphTexture ImportTexture(const char* name, TextureHandle handle, const TextureDesc& desc,
+										 TextureState before = TextureState::Undefined,
+										 TextureState after = TextureState::ShaderRead);
+
+		/**
+		 * @brief Add a pass, setup runs right away to declare its reads and writes.
+		 */
+		PassId AddPass(const char* name, const SetupFn& setup, ExecuteFn execute);
+
+		/**
+		 * @brief Cull, plan barriers and alias transient textures.
+		 *
+		 * @return false if a pass reads a texture nothing wrote before it, uses a texture it writes twice, or
+		 * has attachments the device can't render (sizes differ, depth without color), outError says which.
+		 */
+		bool Compile(std::string& outError);
+
+		/**
+		 * @brief Record the live passes and submit them in one go. jobs records the lists in parallel, null
+		 * records them on the calling thread.
+		 */
+		void Execute(IDevice& device, JobSystem* jobs = nullptr);
+
+		size_t GetPassCount() const { return _passes.size(); };
+		const char* GetName(PassId pass) const { return _passes[pass].name.c_str(); };
+		const char* GetName(RenderGraphTexture texture) const { return _textures[texture.index].name.c_str(); };
+		bool IsCulled(PassId pass) const { return _passes[pass].culled; };
+
+		// Compile results
+		const std::vector<PassId>& GetExecutionOrder() const { return _order; };
+		// Passes whose writes the pass reads or keeps, live ones only
+		const std::vector<PassId>& GetDependencies(PassId pass) const { return _passes[pass].dependencies; };
+		const std::vector<RenderGraphBarrier>& GetBarriers(PassId pass) const { return _passes[pass].barriers; };
+		const std::vector<RenderGraphBarrier>& GetFinalBarriers() const { return _finalBarriers; };
+		// Device texture slot of a transient texture, shared by aliased textures, Invalid when unused
+		uint32_t GetPhysicalIndex(RenderGraphTexture texture) const { return _textures[texture.index].physical; };
+		const RenderGraphStats& GetStats() const { return _stats; };
+
+		/**
+		 * @brief Device texture behind a graph texture once Execute has placed it, null for the back buffer.
+		 */
+		TextureHandle GetTexture(RenderGraphTexture texture) const;
+
+		/**
+		 * @brief Append the compiled graph in text: passes in order with their barriers, culled passes, the
+		 * texture placement and the memory aliasing saved.
+		 */
+		void Describe(std::string& out) const;
+
+	  private:
+		friend class RenderGraphBuilder;
+
+		enum class Access : uint8_t
+		{
+			Read,
+			Color,
+			Depth,
+		};
+
+		struct TextureUse
+		{
+			uint32_t texture;
+			Access access;
+			bool clear;
+		};
+
+		struct Pass
+		{
+			std::string name;
+			ExecuteFn execute;
+			std::vector<TextureUse> uses;
+			glm::vec4 clearColor;
+			float clearDepth;
+			uint32_t listCount;
+			bool sideEffects;
+
+			bool culled;
+			std::vector<PassId> dependencies;
+			std::vector<RenderGraphBarrier> barriers;
+		};
+
+		struct Texture
+		{
+			std::string name;
+			TextureDesc desc;
+			TextureHandle handle;
+			bool imported;
+			TextureState before;
+			TextureState after;
+
+			// Positions in _order of the first and last live pass using it
+			uint32_t firstUse;
+			uint32_t lastUse;
+			uint32_t physical;
+		};
+
+		// Device texture transient textures are placed in
+		struct Physical
+		{
+			TextureDesc desc;
+			TextureHandle handle;
+			uint32_t unusedFrames;
+		};
+
+		void Cull();
+		bool PlanBarriers(std::string& outError);
+		void Alias();
+		// Device textures of the slots, created or taken from the ones kept across frames
+		void AcquireTextures(IDevice& device);
+
+		std::vector<Pass> _passes;
+		std::vector<Texture> _textures;
+		std::vector<PassId> _order;
+		std::vector<RenderGraphBarrier> _finalBarriers;
+		// Descriptions of the aliasing slots and their device textures this frame
+		std::vector<TextureDesc> _slots;
+		std::vector<TextureHandle> _slotTextures;
+		std::vector<Physical> _physical;
+		std::vector<CommandList> _lists;
+		RenderGraphStats _stats;
+		bool _compiled{false};
+	};
+
+} // namespace gefx
+
+#endif //!__RENDERGRAPH__H__
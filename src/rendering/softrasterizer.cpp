@@ -0,0 +1,517 @@
+// StdLib Includes
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+// Application Specific Includes
+#include <core/bits.h>
+#include <core/math/simd.h>
+#include <rendering/softrasterizer.h>
+
+namespace gefx
+{
+	namespace
+	{
+		constexpr uint32_t VerticesPerJob = 1024;
+		// Clip planes as dot(plane, position) >= 0: near, far, then the guard band. Triangles are only clipped
+		// against the guard band so pixel space coordinates stay small enough for the edge functions, the
+		// screen edges are handled by the pixel bounds
+		constexpr float GuardBand = 4.0f;
+		constexpr uint32_t ClipPlaneCount = 6;
+		const glm::vec4 ClipPlanes[ClipPlaneCount] = {
+			{0.0f, 0.0f, 1.0f, 1.0f},		{0.0f, 0.0f, -1.0f, 1.0f}, {1.0f, 0.0f, 0.0f, GuardBand},
+			{-1.0f, 0.0f, 0.0f, GuardBand}, {0.0f, 1.0f, 0.0f, GuardBand}, {0.0f, -1.0f, 0.0f, GuardBand},
+		};
+		// Triangle plus one vertex per clip plane
+		constexpr uint32_t MaxClipVertices = 3 + ClipPlaneCount;
+		// Vertices snap to 1/16th of a pixel like GPUs do
+		constexpr float SubpixelSteps = 16.0f;
+
+		// Pixel centers of one SIMD row, relative to its first pixel
+		constexpr float LaneOffsets[8] = {0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f};
+
+		template <typename F>
+		void parallelRange(JobSystem* jobs, uint32_t count, uint32_t batchSize, const F& fn)
+		{
+			if (jobs)
+			{
+				jobs->ParallelFor(count, batchSize, fn);
+			}
+			else if (count > 0)
+			{
+				fn(0u, count);
+			}
+		}
+
+		// Bits [begin, end) of a SIMD row
+		uint32_t spanBits(uint32_t begin, uint32_t end)
+		{
+			return ((1u << end) - 1u) & ~((1u << begin) - 1u);
+		}
+
+		// Draw whose range of the flattened numbering holds index
+		uint32_t findDraw(const std::vector<uint32_t>& drawFirst, uint32_t index)
+		{
+			return static_cast<uint32_t>(std::upper_bound(drawFirst.begin(), drawFirst.end(), index) -
+										 drawFirst.begin() - 1);
+		}
+
+		uint32_t packColor(const glm::vec4& color)
+		{
+			const glm::vec4 c = glm::clamp(color, 0.0f, 1.0f) * 255.0f + 0.5f;
+			return uint32_t(c.r) | uint32_t(c.g) << 8 | uint32_t(c.b) << 16 | uint32_t(c.a) << 24;
+		}
+
+		// Coefficients of f = a * x + b * y + c through the three screen vertices, area is twice the signed area
+		void planeThrough(const glm::vec2 (&p)[3], float area, float f0, float f1, float f2, float* out)
+		{
+			const glm::vec2 d1 = p[1] - p[0];
+			const glm::vec2 d2 = p[2] - p[0];
+			const float df1 = f1 - f0;
+			const float df2 = f2 - f0;
+			out[0] = (df1 * d2.y - df2 * d1.y) / area;
+			out[1] = (d1.x * df2 - d2.x * df1) / area;
+			out[2] = f0 - out[0] * p[0].x - out[1] * p[0].y;
+		}
+
+		// Pixels where an edge function is >= 0 for top left edges, > 0 otherwise
+		template <typename V>
+		uint32_t insideMask(V edge, V zero, bool topLeft)
+		{
+			constexpr uint32_t allLanes = (1u << V::Width) - 1u;
+			return topLeft ? GreaterEqualMask(edge, zero) : ~GreaterEqualMask(zero, edge) & allLanes;
+		}
+	} // namespace
+
+	SoftwareRasterizer::SoftwareRasterizer(uint32_t width, uint32_t height)
+	{
+		SetResolution(width, height);
+		_drawFirstVertex.assign(1, 0);
+		_drawFirstTriangle.assign(1, 0);
+	}
+
+	void SoftwareRasterizer::SetResolution(uint32_t width, uint32_t height)
+	{
+		_width = std::max(1u, width);
+		_height = std::max(1u, height);
+		_tilesX = (_width + TileSize - 1) / TileSize;
+		_tilesY = (_height + TileSize - 1) / TileSize;
+		_color.assign(size_t(_tilesX) * _tilesY * TileSize * TileSize, 0);
+		_depth.assign(size_t(_tilesX) * _tilesY * TileSize * TileSize, 1.0f);
+		_tileFragments.assign(size_t(_tilesX) * _tilesY, 0);
+	}
+
+	void SoftwareRasterizer::Clear(const glm::vec4& color, float depth)
+	{
+		// Draws queued so far would be cleared away with the tiles
+		_draws.clear();
+		_uniforms.clear();
+		_drawFirstVertex.assign(1, 0);
+		_drawFirstTriangle.assign(1, 0);
+
+		_clearPending = true;
+		_clearColor = packColor(color);
+		_clearDepth = depth;
+	}
+
+	void SoftwareRasterizer::Draw(const SoftwarePipeline& pipeline, const void* uniforms, size_t uniformSize,
+								  const void* vertices, uint32_t vertexStride, uint32_t vertexCount,
+								  const uint32_t* indices, uint32_t indexCount)
+	{
+		assert(pipeline.vertex && pipeline.fragment && pipeline.varyingCount <= MaxVaryings);
+		const uint32_t triangleCount = (indices ? indexCount : vertexCount) / 3;
+		if (triangleCount == 0) return;
+
+		// Keep every uniform block 16 bytes aligned, the storage itself comes from operator new
+		const size_t uniformOffset = (_uniforms.size() + 15) & ~size_t(15);
+		_uniforms.resize(uniformOffset + uniformSize);
+		if (uniformSize > 0) std::memcpy(_uniforms.data() + uniformOffset, uniforms, uniformSize);
+
+		_draws.push_back(
+			DrawCall{&pipeline, uniformOffset, static_cast<const uint8_t*>(vertices), vertexStride, indices});
+		_drawFirstVertex.push_back(_drawFirstVertex.back() + vertexCount);
+		_drawFirstTriangle.push_back(_drawFirstTriangle.back() + triangleCount);
+	}
+
+	void SoftwareRasterizer::SetupTriangle(uint32_t draw, const ClipVertex (&vertices)[3], Chunk& chunk) const
+	{
+		const uint32_t varyingCount = _draws[draw].pipeline->varyingCount;
+
+		uint32_t outside[3] = {0, 0, 0};
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			for (uint32_t p = 0; p < ClipPlaneCount; p++)
+			{
+				if (glm::dot(ClipPlanes[p], vertices[i].position) < 0.0f) outside[i] |= 1u << p;
+			}
+		}
+		if (outside[0] & outside[1] & outside[2]) return;
+		if ((outside[0] | outside[1] | outside[2]) == 0)
+		{
+			EmitTriangle(draw, vertices[0], vertices[1], vertices[2], chunk);
+			return;
+		}
+
+		// Sutherland-Hodgman against every plane some vertex is outside of
+		ClipVertex buffers[2][MaxClipVertices];
+		std::copy(vertices, vertices + 3, buffers[0]);
+		uint32_t count = 3;
+		uint32_t current = 0;
+		const uint32_t planes = outside[0] | outside[1] | outside[2];
+		for (uint32_t p = 0; p < ClipPlaneCount && count >= 3; p++)
+		{
+			if ((planes & (1u << p)) == 0) continue;
+
+			const ClipVertex* in = buffers[current];
+			ClipVertex* out = buffers[current ^ 1];
+			uint32_t outCount = 0;
+			for (uint32_t i = 0; i < count; i++)
+			{
+				const ClipVertex& a = in[i];
+				const ClipVertex& b = in[(i + 1) % count];
+				const float da = glm::dot(ClipPlanes[p], a.position);
+				const float db = glm::dot(ClipPlanes[p], b.position);
+				if (da >= 0.0f) out[outCount++] = a;
+				if ((da >= 0.0f) != (db >= 0.0f))
+				{
+					const float t = da / (da - db);
+					ClipVertex& v = out[outCount++];
+					v.position = a.position + (b.position - a.position) * t;
+					for (uint32_t k = 0; k < varyingCount; k++)
+					{
+						v.varyings[k] = a.varyings[k] + (b.varyings[k] - a.varyings[k]) * t;
+					}
+				}
+			}
+			count = outCount;
+			current ^= 1;
+		}
+
+		// Fan the clipped polygon
+		const ClipVertex* polygon = buffers[current];
+		for (uint32_t i = 1; i + 1 < count; i++)
+		{
+			EmitTriangle(draw, polygon[0], polygon[i], polygon[i + 1], chunk);
+		}
+	}
+
+	void SoftwareRasterizer::EmitTriangle(uint32_t draw, const ClipVertex& v0, const ClipVertex& v1,
+										  const ClipVertex& v2, Chunk& chunk) const
+	{
+		const SoftwarePipeline& pipeline = *_draws[draw].pipeline;
+		const ClipVertex* v[3] = {&v0, &v1, &v2};
+		glm::vec2 p[3];
+		float z[3], invW[3];
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			const glm::vec4& position = v[i]->position;
+			if (!(position.w > 0.0f)) return;
+
+			invW[i] = 1.0f / position.w;
+			const glm::vec3 ndc = glm::vec3(position) * invW[i];
+			p[i] = glm::vec2(std::round((ndc.x * 0.5f + 0.5f) * _width * SubpixelSteps) / SubpixelSteps,
+							 std::round((ndc.y * 0.5f + 0.5f) * _height * SubpixelSteps) / SubpixelSteps);
+			z[i] = ndc.z * 0.5f + 0.5f;
+		}
+
+		float area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[2].x - p[0].x) * (p[1].y - p[0].y);
+		if (!(area != 0.0f)) return;
+		if (pipeline.cullMode == (area < 0.0f ? CullMode::Back : CullMode::Front)) return;
+		if (area < 0.0f)
+		{
+			// Back face drawn anyway, make it counter clockwise so inside is where every edge is positive
+			std::swap(p[1], p[2]);
+			std::swap(z[1], z[2]);
+			std::swap(invW[1], invW[2]);
+			std::swap(v[1], v[2]);
+			area = -area;
+		}
+
+		// Pixels whose center is inside the bounds, clamped to the framebuffer
+		const float minX = std::max(std::ceil(std::min({p[0].x, p[1].x, p[2].x}) - 0.5f), 0.0f);
+		const float maxX = std::min(std::floor(std::max({p[0].x, p[1].x, p[2].x}) - 0.5f), float(_width - 1));
+		const float minY = std::max(std::ceil(std::min({p[0].y, p[1].y, p[2].y}) - 0.5f), 0.0f);
+		const float maxY = std::min(std::floor(std::max({p[0].y, p[1].y, p[2].y}) - 0.5f), float(_height - 1));
+		if (minX > maxX || minY > maxY) return;
+
+		const uint32_t index = static_cast<uint32_t>(chunk.triangles.size());
+		chunk.triangles.emplace_back();
+		ScreenTriangle& triangle = chunk.triangles.back();
+		triangle.draw = draw;
+		triangle.minX = static_cast<uint16_t>(minX);
+		triangle.maxX = static_cast<uint16_t>(maxX);
+		triangle.minY = static_cast<uint16_t>(minY);
+		triangle.maxY = static_cast<uint16_t>(maxY);
+		triangle.topLeft = 0;
+
+		for (uint32_t e = 0; e < 3; e++)
+		{
+			// Edges are always computed from the same endpoint, whichever triangle they belong to, so the
+			// two triangles sharing an edge get exactly opposite functions and every pixel is drawn once
+			const glm::vec2& a = p[e];
+			const glm::vec2& b = p[(e + 1) % 3];
+			const bool flip = b.x < a.x || (b.x == a.x && b.y < a.y);
+			const glm::vec2& from = flip ? b : a;
+			const glm::vec2& to = flip ? a : b;
+			float edgeA = from.y - to.y;
+			float edgeB = to.x - from.x;
+			float edgeC = -(edgeA * from.x + edgeB * from.y);
+			if (flip)
+			{
+				edgeA = -edgeA;
+				edgeB = -edgeB;
+				edgeC = -edgeC;
+			}
+			triangle.edgeA[e] = edgeA;
+			triangle.edgeB[e] = edgeB;
+			triangle.edgeC[e] = edgeC;
+			if (edgeA > 0.0f || (edgeA == 0.0f && edgeB < 0.0f)) triangle.topLeft |= 1u << e;
+		}
+
+		// Depth is affine in screen space, varyings are once divided by w
+		planeThrough(p, area, z[0], z[1], z[2], triangle.depth);
+		planeThrough(p, area, invW[0], invW[1], invW[2], triangle.invW);
+		for (uint32_t k = 0; k < pipeline.varyingCount; k++)
+		{
+			planeThrough(p, area, v[0]->varyings[k] * invW[0], v[1]->varyings[k] * invW[1],
+						 v[2]->varyings[k] * invW[2], triangle.varyings[k]);
+		}
+
+		// Bin to the tiles of the bounds that aren't entirely outside one of the edges
+		for (uint32_t ty = triangle.minY / TileSize; ty <= triangle.maxY / TileSize; ty++)
+		{
+			for (uint32_t tx = triangle.minX / TileSize; tx <= triangle.maxX / TileSize; tx++)
+			{
+				bool touched = true;
+				for (uint32_t e = 0; e < 3 && touched; e++)
+				{
+					// Tile corner where the edge function is the largest
+					const float x = float(tx * TileSize) + (triangle.edgeA[e] >= 0.0f ? TileSize : 0.0f);
+					const float y = float(ty * TileSize) + (triangle.edgeB[e] >= 0.0f ? TileSize : 0.0f);
+					touched = triangle.edgeA[e] * x + triangle.edgeB[e] * y + triangle.edgeC[e] >= 0.0f;
+				}
+				if (!touched) continue;
+
+				chunk.bins[ty * _tilesX + tx].push_back(index);
+				chunk.binned++;
+			}
+		}
+	}
+
+	template <typename V>
+	uint64_t SoftwareRasterizer::RasterizeTile(uint32_t tile)
+	{
+		static_assert(V::Width <= 8 && TileSize % V::Width == 0, "SIMD rows must tile the tiles");
+		const uint32_t pitch = GetPitch();
+		const uint32_t tileX = (tile % _tilesX) * TileSize;
+		const uint32_t tileY = (tile / _tilesX) * TileSize;
+
+		if (_clearPending)
+		{
+			for (uint32_t y = tileY; y < tileY + TileSize; y++)
+			{
+				std::fill_n(&_color[size_t(y) * pitch + tileX], TileSize, _clearColor);
+				std::fill_n(&_depth[size_t(y) * pitch + tileX], TileSize, _clearDepth);
+			}
+		}
+
+		const V zero = V::Set(0.0f);
+		const V one = V::Set(1.0f);
+		const V lanes = V::Load(LaneOffsets);
+		alignas(32) float laneDepth[V::Width];
+		alignas(32) float laneVaryings[MaxVaryings][V::Width];
+		float varyings[MaxVaryings];
+		uint64_t fragments = 0;
+
+		for (uint32_t c = 0; c < _chunkCount; c++)
+		{
+			const Chunk& chunk = _chunks[c];
+			for (const uint32_t index : chunk.bins[tile])
+			{
+				const ScreenTriangle& triangle = chunk.triangles[index];
+				const DrawCall& draw = _draws[triangle.draw];
+				const SoftwarePipeline& pipeline = *draw.pipeline;
+				const void* uniforms = _uniforms.data() + draw.uniformOffset;
+				const uint32_t varyingCount = pipeline.varyingCount;
+
+				const uint32_t xBegin = std::max<uint32_t>(triangle.minX, tileX);
+				const uint32_t xEnd = std::min<uint32_t>(triangle.maxX + 1u, tileX + TileSize);
+				const uint32_t yBegin = std::max<uint32_t>(triangle.minY, tileY);
+				const uint32_t yEnd = std::min<uint32_t>(triangle.maxY + 1u, tileY + TileSize);
+				const bool topLeft[3] = {(triangle.topLeft & 1u) != 0, (triangle.topLeft & 2u) != 0,
+										 (triangle.topLeft & 4u) != 0};
+				const V edgeA[3] = {V::Set(triangle.edgeA[0]), V::Set(triangle.edgeA[1]), V::Set(triangle.edgeA[2])};
+				const V depthA = V::Set(triangle.depth[0]);
+				const V invWA = V::Set(triangle.invW[0]);
+
+				for (uint32_t y = yBegin; y < yEnd; y++)
+				{
+					// Plane values at x = 0 of this pixel row
+					const float yc = float(y) + 0.5f;
+					const V rowEdge[3] = {V::Set(triangle.edgeB[0] * yc + triangle.edgeC[0]),
+										  V::Set(triangle.edgeB[1] * yc + triangle.edgeC[1]),
+										  V::Set(triangle.edgeB[2] * yc + triangle.edgeC[2])};
+					const V rowDepth = V::Set(triangle.depth[1] * yc + triangle.depth[2]);
+					const V rowInvW = V::Set(triangle.invW[1] * yc + triangle.invW[2]);
+					uint32_t* colorRow = &_color[size_t(y) * pitch];
+					float* depthRow = &_depth[size_t(y) * pitch];
+
+					for (uint32_t gx = xBegin & ~uint32_t(V::Width - 1); gx < xEnd; gx += V::Width)
+					{
+						const V x = lanes + V::Set(float(gx));
+						uint32_t mask = spanBits(std::max(xBegin, gx) - gx, std::min<uint32_t>(xEnd - gx, V::Width));
+						mask &= insideMask(MulAdd(edgeA[0], x, rowEdge[0]), zero, topLeft[0]);
+						mask &= insideMask(MulAdd(edgeA[1], x, rowEdge[1]), zero, topLeft[1]);
+						mask &= insideMask(MulAdd(edgeA[2], x, rowEdge[2]), zero, topLeft[2]);
+						if (mask == 0) continue;
+
+						const V depth = MulAdd(depthA, x, rowDepth);
+						// Less: keep the lanes where the stored depth isn't already <= the new one
+						if (pipeline.depthTest) mask &= ~GreaterEqualMask(depth, V::Load(depthRow + gx));
+						if (mask == 0) continue;
+
+						depth.Store(laneDepth);
+						const V w = one / MulAdd(invWA, x, rowInvW);
+						for (uint32_t k = 0; k < varyingCount; k++)
+						{
+							const float* plane = triangle.varyings[k];
+							(MulAdd(V::Set(plane[0]), x, V::Set(plane[1] * yc + plane[2])) * w)
+								.Store(laneVaryings[k]);
+						}
+
+						for (; mask; mask &= mask - 1)
+						{
+							const uint32_t lane = rv::countTrailingZeros(mask);
+							for (uint32_t k = 0; k < varyingCount; k++)
+							{
+								varyings[k] = laneVaryings[k][lane];
+							}
+							colorRow[gx + lane] = packColor(pipeline.fragment(uniforms, varyings));
+							if (pipeline.depthWrite) depthRow[gx + lane] = laneDepth[lane];
+							fragments++;
+						}
+					}
+				}
+			}
+		}
+		return fragments;
+	}
+
+	void SoftwareRasterizer::Flush(JobSystem* jobs)
+	{
+		_stats = SoftwareRasterStats{};
+		if (_draws.empty() && !_clearPending) return;
+
+		auto start = std::chrono::steady_clock::now();
+		const auto lap = [&start]() {
+			const auto now = std::chrono::steady_clock::now();
+			const double ms = std::chrono::duration<double, std::milli>(now - start).count();
+			start = now;
+			return ms;
+		};
+
+		// Vertex pass
+		const uint32_t vertexCount = _drawFirstVertex.back();
+		_clip.resize(vertexCount);
+		_varyings.resize(size_t(vertexCount) * MaxVaryings);
+		parallelRange(jobs, vertexCount, VerticesPerJob, [this](uint32_t begin, uint32_t end) {
+			uint32_t draw = findDraw(_drawFirstVertex, begin);
+			for (uint32_t i = begin; i < end; i++)
+			{
+				while (i >= _drawFirstVertex[draw + 1])
+				{
+					draw++;
+				}
+				const DrawCall& call = _draws[draw];
+				const uint8_t* vertex = call.vertices + size_t(i - _drawFirstVertex[draw]) * call.vertexStride;
+				_clip[i] = call.pipeline->vertex(_uniforms.data() + call.uniformOffset, vertex,
+												 &_varyings[size_t(i) * MaxVaryings]);
+			}
+		});
+		_stats.vertexMs = lap();
+
+		// Setup and binning pass, each chunk of triangles fills its own bins
+		const uint32_t triangleCount = _drawFirstTriangle.back();
+		const uint32_t tileCount = _tilesX * _tilesY;
+		_chunkCount = (triangleCount + ChunkSize - 1) / ChunkSize;
+		if (_chunks.size() < _chunkCount) _chunks.resize(_chunkCount);
+		parallelRange(jobs, _chunkCount, 1, [this, tileCount, triangleCount](uint32_t begin, uint32_t end) {
+			for (uint32_t c = begin; c < end; c++)
+			{
+				Chunk& chunk = _chunks[c];
+				chunk.triangles.clear();
+				chunk.bins.resize(tileCount);
+				for (std::vector<uint32_t>& bin : chunk.bins)
+				{
+					bin.clear();
+				}
+				chunk.binned = 0;
+
+				const uint32_t first = c * ChunkSize;
+				const uint32_t last = std::min(first + ChunkSize, triangleCount);
+				uint32_t draw = findDraw(_drawFirstTriangle, first);
+				for (uint32_t t = first; t < last; t++)
+				{
+					while (t >= _drawFirstTriangle[draw + 1])
+					{
+						draw++;
+					}
+					const DrawCall& call = _draws[draw];
+					const uint32_t varyingCount = call.pipeline->varyingCount;
+					const uint32_t local = (t - _drawFirstTriangle[draw]) * 3;
+					ClipVertex vertices[3];
+					for (uint32_t k = 0; k < 3; k++)
+					{
+						const uint32_t vertex =
+							_drawFirstVertex[draw] + (call.indices ? call.indices[local + k] : local + k);
+						assert(vertex < _drawFirstVertex[draw + 1] && "index out of the draw's vertices");
+						vertices[k].position = _clip[vertex];
+						std::copy_n(&_varyings[size_t(vertex) * MaxVaryings], varyingCount, vertices[k].varyings);
+					}
+					SetupTriangle(draw, vertices, chunk);
+				}
+			}
+		});
+		_stats.setupMs = lap();
+
+		// Raster pass, one job per tile
+		parallelRange(jobs, tileCount, 1, [this](uint32_t begin, uint32_t end) {
+			for (uint32_t tile = begin; tile < end; tile++)
+			{
+				_tileFragments[tile] = RasterizeTile<rv::FloatV>(tile);
+			}
+		});
+		_stats.rasterMs = lap();
+
+		_stats.draws = static_cast<uint32_t>(_draws.size());
+		_stats.vertices = vertexCount;
+		_stats.triangles = triangleCount;
+		for (uint32_t c = 0; c < _chunkCount; c++)
+		{
+			_stats.rasterizedTriangles += static_cast<uint32_t>(_chunks[c].triangles.size());
+			_stats.binnedTriangles += _chunks[c].binned;
+		}
+		for (const uint64_t fragments : _tileFragments)
+		{
+			_stats.fragments += fragments;
+		}
+
+		_draws.clear();
+		_uniforms.clear();
+		_drawFirstVertex.assign(1, 0);
+		_drawFirstTriangle.assign(1, 0);
+		_clearPending = false;
+	}
+
+	void SoftwareRasterizer::ResolveColor(std::vector<uint32_t>& outPixels) const
+	{
+		outPixels.resize(size_t(_width) * _height);
+		for (uint32_t y = 0; y < _height; y++)
+		{
+			std::copy_n(&_color[size_t(y) * GetPitch()], _width, &outPixels[size_t(y) * _width]);
+		}
+	}
+
+} // namespace gefx
@@ -0,0 +1,196 @@
+#ifndef __SOFTRASTERIZER__H__
+#define __SOFTRASTERIZER__H__
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <core/jobs.h>
+#include <rendering/device/device.h>
+
+namespace gefx
+{
+	/**
+	 * @brief Shaders and fixed function state of a software draw, the CPU side counterpart of a GPU pipeline.
+	 */
+	struct SoftwarePipeline
+	{
+		/**
+		 * @brief Transform one vertex, write its varyingCount varyings and return its clip space position.
+		 */
+		using VertexShader = glm::vec4 (*)(const void* uniforms, const void* vertex, float* outVaryings);
+		/**
+		 * @brief Color of one fragment from its perspective correct varyings.
+		 */
+		using FragmentShader = glm::vec4 (*)(const void* uniforms, const float* varyings);
+
+		VertexShader vertex{nullptr};
+		FragmentShader fragment{nullptr};
+		uint32_t varyingCount{0};
+		CullMode cullMode{CullMode::Back};
+		bool depthTest{true};
+		bool depthWrite{true};
+	};
+
+	struct SoftwareRasterStats
+	{
+		uint32_t draws{0};
+		uint32_t vertices{0};
+		uint32_t triangles{0};
+		// After clipping, back face and off screen rejection
+		uint32_t rasterizedTriangles{0};
+		// Triangle references across every tile bin
+		uint32_t binnedTriangles{0};
+		// Fragments that passed the depth test and ran the fragment shader
+		uint64_t fragments{0};
+		double vertexMs{0.0};
+		double setupMs{0.0};
+		double rasterMs{0.0};
+	};
+
+	/**
+	 * @brief Tile based software rasterizer, a GPU independent reference renderer.
+	 *
+	 * Draws are queued and executed by Flush in three passes on the job system: vertices are shaded, then
+	 * triangles are clipped, set up and binned to the screen tiles they touch by chunks of submission order,
+	 * and finally every tile is rasterized by its own job walking its bins in order. Tiles own their pixels so
+	 * the last pass needs no synchronization, and the image only depends on the inputs, never on thread timing.
+	 *
+	 * Coverage, depth and the interpolation planes are evaluated a SIMD row of pixels at a time with the top
+	 * left fill rule, shared edges are computed identically from both sides so meshes are watertight. Depth is
+	 * GL style NDC z mapped to [0, 1] with a less test, varyings are interpolated perspective correct. The
+	 * framebuffer is RGBA8 color plus float depth, row major from the bottom row, triangles are counter
+	 * clockwise when front facing.
+	 */
+	class SoftwareRasterizer
+	{
+	  public:
+		static constexpr uint32_t TileSize = 64;
+		static constexpr uint32_t MaxVaryings = 8;
+		static constexpr uint32_t ChunkSize = 512;
+
+		explicit SoftwareRasterizer(uint32_t width = 640, uint32_t height = 480);
+		~SoftwareRasterizer() = default;
+
+		SoftwareRasterizer(SoftwareRasterizer&&) = delete;
+		SoftwareRasterizer(const SoftwareRasterizer&) = delete;
+		SoftwareRasterizer& operator=(SoftwareRasterizer&&) = delete;
+		SoftwareRasterizer& operator=(const SoftwareRasterizer&) = delete;
+
+		/**
+		 * @brief Resize the framebuffer, its content is undefined until the next Clear.
+		 */
+		void SetResolution(uint32_t width, uint32_t height);
+		uint32_t GetWidth() const { return _width; };
+		uint32_t GetHeight() const { return _height; };
+
+		/**
+		 * @brief Clear color and depth before the next queued draw. Applied by Flush, tile by tile.
+		 */
+		void Clear(const glm::vec4& color, float depth = 1.0f);
+
+		/**
+		 * @brief Queue a triangle list. uniforms are copied, vertices and indices are referenced and must stay
+		 * alive until Flush returns. Without indices every three consecutive vertices make a triangle.
+		 *
+		 * @param pipeline Must outlive Flush as well.
+		 * @param vertexStride Bytes between two vertices, passed to the vertex shader one at a time.
+		 */
+		void Draw(const SoftwarePipeline& pipeline, const void* uniforms, size_t uniformSize, const void* vertices,
+				  uint32_t vertexStride, uint32_t vertexCount, const uint32_t* indices = nullptr,
+				  uint32_t indexCount = 0);
+
+		/**
+		 * @brief Execute the queued clear and draws into the framebuffer.
+		 *
+		 * @param jobs Job system to spread the work on, nullptr renders on the calling thread.
+		 */
+		void Flush(JobSystem* jobs = nullptr);
+
+		/**
+		 * @brief Rows are GetPitch pixels apart, the framebuffer is padded to whole tiles.
+		 */
+		const uint32_t* GetColor() const { return _color.data(); };
+		const float* GetDepth() const { return _depth.data(); };
+		uint32_t GetPitch() const { return _tilesX * TileSize; };
+		const SoftwareRasterStats& GetStats() const { return _stats; };
+
+		/**
+		 * @brief Tightly packed RGBA8 pixels, row major from the bottom row.
+		 */
+		void ResolveColor(std::vector<uint32_t>& outPixels) const;
+
+	  private:
+		struct DrawCall
+		{
+			const SoftwarePipeline* pipeline;
+			size_t uniformOffset;
+			const uint8_t* vertices;
+			uint32_t vertexStride;
+			const uint32_t* indices;
+		};
+
+		// Planes a * x + b * y + c over pixel space of the edge functions, depth, 1 / w and varyings / w
+		struct ScreenTriangle
+		{
+			float edgeA[3], edgeB[3], edgeC[3];
+			float depth[3];
+			float invW[3];
+			float varyings[MaxVaryings][3];
+			uint32_t draw;
+			// Inclusive pixel bounds, clamped to the framebuffer
+			uint16_t minX, maxX, minY, maxY;
+			// Bit e set when edge e is a top or left edge and owns the pixel centers it crosses
+			uint8_t topLeft;
+		};
+
+		struct Chunk
+		{
+			std::vector<ScreenTriangle> triangles;
+			// Per tile, indices into triangles in submission order
+			std::vector<std::vector<uint32_t>> bins;
+			uint32_t binned{0};
+		};
+
+		struct ClipVertex
+		{
+			glm::vec4 position;
+			float varyings[MaxVaryings];
+		};
+
+		void SetupTriangle(uint32_t draw, const ClipVertex (&vertices)[3], Chunk& chunk) const;
+		void EmitTriangle(uint32_t draw, const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2,
+						  Chunk& chunk) const;
+		template <typename V>
+		uint64_t RasterizeTile(uint32_t tile);
+
+		uint32_t _width{0};
+		uint32_t _height{0};
+		uint32_t _tilesX{0};
+		uint32_t _tilesY{0};
+		std::vector<uint32_t> _color;
+		std::vector<float> _depth;
+
+		bool _clearPending{false};
+		uint32_t _clearColor{0};
+		float _clearDepth{1.0f};
+
+		std::vector<DrawCall> _draws;
+		std::vector<uint8_t> _uniforms;
+		// First vertex and triangle of every draw in the flattened numbering, plus the totals
+		std::vector<uint32_t> _drawFirstVertex;
+		std::vector<uint32_t> _drawFirstTriangle;
+		// Shaded vertices, MaxVaryings floats each
+		std::vector<glm::vec4> _clip;
+		std::vector<float> _varyings;
+
+		std::vector<Chunk> _chunks;
+		uint32_t _chunkCount{0};
+		std::vector<uint64_t> _tileFragments;
+		SoftwareRasterStats _stats;
+	};
+
+} // namespace gefx
+
+#endif //!__SOFTRASTERIZER__H__
@@ -3,17 +3,21 @@
 #include <iostream>
 
 // Third Party Dependencies
-#include <fmt/core.h>
 #include <glad/glad.h>
 #include <vulkan/vulkan.hpp>
 #include <glslang/SPIRV/GlslangToSpv.h>
 #include <glslang/SPIRV/disassemble.h>
 
+// Application Specific Includes
+#include <core/log.h>
+#include <core/span.h>
+#include <core/vfs.h>
+#include <rendering/device/device.h>
+
 // Using directives
 using std::string;
 template <typename T>
 using vector = std::vector<T>;
-using std::istreambuf_iterator;
 
 // TODO: Move this to proper Graphics API abstraction
 namespace ShaderUtils
@@ -203,8 +207,14 @@ namespace ShaderUtils
 		}
 	}
 
-	inline bool GLSLtoSPV(const vk::ShaderStageFlagBits shaderType, const char* shaderStr,
-						  std::vector<unsigned int>& spirv)
+	/**
+	 * @brief Compile GLSL for the given device backend. Shaders declare their resources with the PUSH_CONSTANT,
+	 * UNIFORM_SLOT(n) and TEXTURE_SLOT(n) layout qualifiers defined here, and use GL clip space: for Vulkan the
+	 * vertex stage's main is wrapped to flip y and move depth from [-1, 1] to [0, 1].
+	 */
+	inline bool GLSLtoSPV(const vk::ShaderStageFlagBits shaderType, std::string_view shaderStr,
+						  std::vector<unsigned int>& spirv,
+						  gefx::DeviceBackend backend = gefx::DeviceBackend::OpenGL)
 	{
 		EShLanguage stage = FindLanguage(shaderType);
 		glslang::TShader shader(stage);
@@ -212,18 +222,59 @@ namespace ShaderUtils
 		TBuiltInResource resources = {};
 		InitResources(resources);
 
-		// Enable SPIR-V and Vulkan rules when parsing GLSL
-		// TODO: re-add flag for vulkan requirements when compiling GLSL for Vulkan Backend
-		EShMessages messages = (EShMessages)(EShMsgSpvRules /*| EShMsgVulkanRules*/);
+		const bool vulkan = backend == gefx::DeviceBackend::Vulkan;
+		EShMessages messages = (EShMessages)(vulkan ? EShMsgSpvRules | EShMsgVulkanRules : EShMsgSpvRules);
+		if (vulkan)
+		{
+			shader.setEnvInput(glslang::EShSourceGlsl, stage, glslang::EShClientVulkan, 100);
+			shader.setEnvClient(glslang::EShClientVulkan, glslang::EShTargetVulkan_1_2);
+			shader.setEnvTarget(glslang::EShTargetSpv, glslang::EShTargetSpv_1_5);
+		}
 
-		const char* c_str;
-		shader.setStrings(&(c_str = shaderStr), 1);
+		// Source comes straight from the file mapping, which isn't null terminated
+		const char* strings[2] = {shaderStr.data(), nullptr};
+		int lengths[2] = {static_cast<int>(shaderStr.size()), 0};
+		int stringCount = 1;
+		const bool wrapMain = vulkan && stage == EShLangVertex;
+		if (wrapMain)
+		{
+			static const char clipSpace[] = "\n#undef main\n"
+											"void main()\n"
+											"{\n"
+											"\tgefx_main();\n"
+											"\tgl_Position.y = -gl_Position.y;\n"
+											"\tgl_Position.z = (gl_Position.z + gl_Position.w) * 0.5;\n"
+											"}\n";
+			strings[1] = clipSpace;
+			lengths[1] = static_cast<int>(sizeof(clipSpace) - 1);
+			stringCount = 2;
+		}
+		shader.setStringsWithLengths(strings, lengths, stringCount);
+
+		// GL has no push constants, it emulates them with the uniform block bound right after the uniform
+		// buffer slots (GLDevice::PushConstantBinding). Vulkan keeps uniforms and textures in descriptor sets
+		// 0 and 1, and push constants use std140 too so the CPU side layout is the same on both.
+		if (vulkan)
+		{
+			shader.setPreamble(wrapMain ? "#define PUSH_CONSTANT push_constant, std140\n"
+										  "#define UNIFORM_SLOT(n) std140, set = 0, binding = n\n"
+										  "#define TEXTURE_SLOT(n) set = 1, binding = n\n"
+										  "#define main gefx_main\n"
+										: "#define PUSH_CONSTANT push_constant, std140\n"
+										  "#define UNIFORM_SLOT(n) std140, set = 0, binding = n\n"
+										  "#define TEXTURE_SLOT(n) set = 1, binding = n\n");
+		}
+		else
+		{
+			shader.setPreamble("#define PUSH_CONSTANT std140, binding = 8\n"
+							   "#define UNIFORM_SLOT(n) std140, binding = n\n"
+							   "#define TEXTURE_SLOT(n) binding = n\n");
+		}
 
 		if (!shader.parse(&resources, 100, false, messages))
 		{
-			fmt::print(shader.getInfoLog());
-			fmt::print(shader.getInfoDebugLog());
-			fflush(stdout);
+			GEFX_LOG_ERROR("GLSL parsing failed! Stage: {}\n{}\n{}", VkShaderTypeToStr(shaderType), shader.getInfoLog(),
+						   shader.getInfoDebugLog());
 			return false; // something didn't work
 		}
 
@@ -235,38 +286,30 @@ namespace ShaderUtils
 
 		if (!program.link(messages))
 		{
-			fmt::print(shader.getInfoLog());
-			fmt::print(shader.getInfoDebugLog());
-			fflush(stdout);
+			GEFX_LOG_ERROR("GLSL program linking failed! Stage: {}\n{}\n{}", VkShaderTypeToStr(shaderType),
+						   program.getInfoLog(), program.getInfoDebugLog());
 			return false;
 		}
 
 		glslang::SpvOptions options = {};
 		options.validate = true;
 		glslang::GlslangToSpv(*program.getIntermediate(stage), spirv, &options);
-		fmt::print("GLSL to SPIR-V compilation succeded! Stage: {0}\n", VkShaderTypeToStr(shaderType));
+		GEFX_LOG_INFO("GLSL to SPIR-V compilation succeded! Stage: {0}", VkShaderTypeToStr(shaderType));
 
 		// Dump Disassemble:
 		// spv::Disassemble(std::cout, spirv);
 
-		fflush(stdout);
 		return true;
 	}
 
-	inline bool TryLoadShaderFile(string shaderPath, string& outShaderData)
+	inline bool TryLoadShaderFile(gefx::VirtualFileSystem& vfs, std::string_view shaderPath,
+								  gefx::FileView& outShaderData)
 	{
-		std::ifstream in;
-		in.open(shaderPath.c_str(), std::ios::in);
-		if (!in)
-		{
-			return false;
-		}
-		outShaderData.assign((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
-		in.close();
-		return true;
+		outShaderData = vfs.Open(shaderPath, gefx::AccessHint::Sequential);
+		return outShaderData.IsValid();
 	}
 
-	inline GLuint CompileShaderProgramTxt(string vertTxtData, string fragTxtData)
+	inline GLuint CompileShaderProgramTxt(std::string_view vertTxtData, std::string_view fragTxtData)
 	{
 		char logStr[1024];
 		int resultCode = 0;
@@ -274,49 +317,51 @@ namespace ShaderUtils
 
 		// compile
 		const char* c_str;
+		int c_len;
 		uint32_t vid;
 		if (valid)
 		{
 			vid = glCreateShader(GL_VERTEX_SHADER);
-			glShaderSource(vid, 1, &(c_str = vertTxtData.c_str()), NULL);
+			c_str = vertTxtData.data();
+			c_len = static_cast<int>(vertTxtData.size());
+			glShaderSource(vid, 1, &c_str, &c_len);
 			glCompileShader(vid);
 
 			glGetShaderiv(vid, GL_COMPILE_STATUS, &resultCode);
 			if (resultCode == GL_FALSE)
 			{
 				glGetShaderInfoLog(vid, 1024, NULL, logStr);
-				fmt::print("[OpenGL] Vertex Shader - Compile Error:\n{0}\n", logStr);
+				GEFX_LOG_ERROR("[OpenGL] Vertex Shader - Compile Error:\n{0}", logStr);
 				glDeleteShader(vid);
-				fflush(stdout);
 				return 0;
 			}
 			else
 			{
-				fmt::print("[OpenGL] Vertex Shader - Compiled Successfully!\n");
+				GEFX_LOG_INFO("[OpenGL] Vertex Shader - Compiled Successfully!");
 			}
-			fflush(stdout);
 		}
 
 		uint32_t fid;
 		if (valid)
 		{
 			fid = glCreateShader(GL_FRAGMENT_SHADER);
-			glShaderSource(fid, 1, &(c_str = fragTxtData.c_str()), NULL);
+			c_str = fragTxtData.data();
+			c_len = static_cast<int>(fragTxtData.size());
+			glShaderSource(fid, 1, &c_str, &c_len);
 			glCompileShader(fid);
 
 			glGetShaderiv(fid, GL_COMPILE_STATUS, &resultCode);
 			if (resultCode == GL_FALSE)
 			{
 				glGetShaderInfoLog(fid, 1024, NULL, logStr);
-				fmt::print("[OpenGL] Fragment Shader - Compile Error:\n{0}\n", logStr);
+				GEFX_LOG_ERROR("[OpenGL] Fragment Shader - Compile Error:\n{0}", logStr);
 				glDeleteShader(vid);
 				glDeleteShader(fid);
-				fflush(stdout);
 				return 0;
 			}
 			else
 			{
-				fmt::print("[OpenGL] Fragment Shader - Compiled Successfully!\n");
+				GEFX_LOG_INFO("[OpenGL] Fragment Shader - Compiled Successfully!");
 			}
 		}
 
@@ -333,16 +378,15 @@ namespace ShaderUtils
 		if (resultCode == GL_FALSE)
 		{
 			glGetProgramInfoLog(pid, 1024, NULL, logStr);
-			fmt::print("[OpenGL] Shader Program - Link Error:\n{0}\n", logStr);
+			GEFX_LOG_ERROR("[OpenGL] Shader Program - Link Error:\n{0}", logStr);
 			glDeleteShader(vid);
 			glDeleteShader(fid);
 			glDeleteProgram(pid);
-			fflush(stdout);
 			return 0;
 		}
 		else
 		{
-			fmt::print("[OpenGL] Shader Program - Linked Successfully!\n");
+			GEFX_LOG_INFO("[OpenGL] Shader Program - Linked Successfully!");
 		}
 
 		// clean
@@ -352,13 +396,16 @@ namespace ShaderUtils
 		if (valid) glDeleteShader(vid);
 		if (valid) glDeleteShader(fid);
 
-		fflush(stdout);
 		return pid;
 	}
 
-	inline GLuint CompileShaderProgramSpirV(const vector<unsigned int>& vertSpirVData,
-											const vector<unsigned int>& fragSpirVData)
+	// specializeShader defaults to the 4.6 core entry point, 4.5 drivers may only have the ARB_gl_spirv one
+	inline GLuint CompileShaderProgramSpirV(rv::Span<const uint32_t> vertSpirVData,
+											rv::Span<const uint32_t> fragSpirVData,
+											PFNGLSPECIALIZESHADERPROC specializeShader = nullptr)
 	{
+		if (!specializeShader) specializeShader = glSpecializeShader;
+
 		char logStr[1024];
 		int resultCode = 0;
 		bool valid = !vertSpirVData.empty() && !fragSpirVData.empty();
@@ -368,22 +415,21 @@ namespace ShaderUtils
 		if (valid)
 		{
 			vid = glCreateShader(GL_VERTEX_SHADER);
-			const int vertDataBytesSize = static_cast<int>(vertSpirVData.size() * sizeof(unsigned int));
+			const int vertDataBytesSize = static_cast<int>(vertSpirVData.size_bytes());
 			glShaderBinary(1, &vid, GL_SHADER_BINARY_FORMAT_SPIR_V_ARB, vertSpirVData.data(), vertDataBytesSize);
-			glSpecializeShader(vid, "main", 0, nullptr, nullptr);
+			specializeShader(vid, "main", 0, nullptr, nullptr);
 
 			glGetShaderiv(vid, GL_COMPILE_STATUS, &resultCode);
 			if (resultCode == GL_FALSE)
 			{
 				glGetShaderInfoLog(vid, 1024, NULL, logStr);
-				fmt::print("[Spir-V] Vertex Shader - Compile Error:\n{0}\n", logStr);
+				GEFX_LOG_ERROR("[Spir-V] Vertex Shader - Compile Error:\n{0}", logStr);
 				glDeleteShader(vid);
-				fflush(stdout);
 				return 0;
 			}
 			else
 			{
-				fmt::print("[Spir-V] Vertex Shader - Compiled Successfully!\n");
+				GEFX_LOG_INFO("[Spir-V] Vertex Shader - Compiled Successfully!");
 			}
 		}
 
@@ -391,23 +437,22 @@ namespace ShaderUtils
 		if (valid)
 		{
 			fid = glCreateShader(GL_FRAGMENT_SHADER);
-			const int fragDataBytesSize = static_cast<int>(fragSpirVData.size() * sizeof(unsigned int));
+			const int fragDataBytesSize = static_cast<int>(fragSpirVData.size_bytes());
 			glShaderBinary(1, &fid, GL_SHADER_BINARY_FORMAT_SPIR_V_ARB, fragSpirVData.data(), fragDataBytesSize);
-			glSpecializeShader(fid, "main", 0, nullptr, nullptr);
+			specializeShader(fid, "main", 0, nullptr, nullptr);
 
 			glGetShaderiv(fid, GL_COMPILE_STATUS, &resultCode);
 			if (resultCode == GL_FALSE)
 			{
 				glGetShaderInfoLog(fid, 1024, NULL, logStr);
-				fmt::print("[Spir-V] Fragment Shader - Compile Error:\n{0}\n", logStr);
+				GEFX_LOG_ERROR("[Spir-V] Fragment Shader - Compile Error:\n{0}", logStr);
 				glDeleteShader(vid);
 				glDeleteShader(fid);
-				fflush(stdout);
 				return 0;
 			}
 			else
 			{
-				fmt::print("[Spir-V] Fragment Shader - Compiled Successfully!\n");
+				GEFX_LOG_INFO("[Spir-V] Fragment Shader - Compiled Successfully!");
 			}
 		}
 
@@ -421,16 +466,15 @@ namespace ShaderUtils
 		if (resultCode == GL_FALSE)
 		{
 			glGetProgramInfoLog(pid, 1024, NULL, logStr);
-			fmt::print("[Spir-V] Shader Program - Link Error:\n{0}\n", logStr);
+			GEFX_LOG_ERROR("[Spir-V] Shader Program - Link Error:\n{0}", logStr);
 			glDeleteShader(vid);
 			glDeleteShader(fid);
 			glDeleteProgram(pid);
-			fflush(stdout);
 			return 0;
 		}
 		else
 		{
-			fmt::print("[Spir-V] Shader Program - Linked Successfully!\n");
+			GEFX_LOG_INFO("[Spir-V] Shader Program - Linked Successfully!");
 		}
 
 		// clean
@@ -440,7 +484,6 @@ namespace ShaderUtils
 		if (valid) glDeleteShader(vid);
 		if (valid) glDeleteShader(fid);
 
-		fflush(stdout);
 		return pid;
 	}
 } // namespace ShaderUtils
\ No newline at end of file
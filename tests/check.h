@@ -0,0 +1,32 @@
+#ifndef __CHECK__H__
+#define __CHECK__H__
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+// Unit tests are plain executables: a failed check prints where and exits with 1, ctest reports it
+
+#define CHECK(condition)                                                                                      \
+	do                                                                                                         \
+	{                                                                                                          \
+		if (!(condition))                                                                                      \
+		{                                                                                                      \
+			std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition);                 \
+			std::exit(1);                                                                                      \
+		}                                                                                                      \
+	} while (false)
+
+#define CHECK_NEAR(a, b, tolerance)                                                                           \
+	do                                                                                                         \
+	{                                                                                                          \
+		const double checkA = (a), checkB = (b);                                                               \
+		if (!(std::fabs(checkA - checkB) <= (tolerance)))                                                      \
+		{                                                                                                      \
+			std::fprintf(stderr, "%s:%d: CHECK_NEAR(%s, %s) failed: %g vs %g\n", __FILE__, __LINE__, #a, #b,   \
+						 checkA, checkB);                                                                      \
+			std::exit(1);                                                                                      \
+		}                                                                                                      \
+	} while (false)
+
+#endif //!__CHECK__H__
@@ -0,0 +1,258 @@
+// Lock-free queues, the blocking adaptor and EventCount under contention. Also built with ThreadSanitizer where
+// the compiler supports it, a lost wakeup shows up as a hang that the ctest timeout reports
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include <core/concurrency/blockingqueue.h>
+#include <core/concurrency/futex.h>
+#include <core/concurrency/mpmcqueue.h>
+#include <core/concurrency/spscqueue.h>
+
+#include "check.h"
+
+static void testSPSCKeepsOrder()
+{
+	constexpr uint64_t Count = 200000;
+	rv::SPSCQueue<uint64_t> queue(64);
+	std::thread consumer([&]() {
+		uint64_t value;
+		for (uint64_t expected = 0; expected < Count; expected++)
+		{
+			while (!queue.TryPop(value))
+			{
+				std::this_thread::yield();
+			}
+			CHECK(value == expected);
+		}
+	});
+	for (uint64_t i = 0; i < Count; i++)
+	{
+		while (!queue.TryPush(i))
+		{
+			std::this_thread::yield();
+		}
+	}
+	consumer.join();
+	CHECK(queue.SizeApprox() == 0);
+
+	rv::BlockingQueue<rv::SPSCQueue<uint64_t>> blocking(16);
+	std::thread blockingConsumer([&]() {
+		uint64_t value;
+		uint64_t expected = 0;
+		while (blocking.Pop(value))
+		{
+			CHECK(value == expected++);
+		}
+		CHECK(expected == Count);
+	});
+	for (uint64_t i = 0; i < Count; i++)
+	{
+		CHECK(blocking.Push(i));
+	}
+	blocking.Close();
+	blockingConsumer.join();
+}
+
+template <typename Queue, typename PushFn, typename PopFn, typename FinishFn>
+static void runMPMC(Queue& queue, PushFn push, PopFn pop, FinishFn finish)
+{
+	constexpr uint32_t Producers = 4;
+	constexpr uint32_t Consumers = 4;
+	constexpr uint32_t PerProducer = 50000;
+
+	std::vector<std::atomic<uint8_t>> seen(Producers * PerProducer);
+	std::atomic<uint32_t> popped{0};
+	std::vector<std::thread> threads;
+	for (uint32_t c = 0; c < Consumers; c++)
+	{
+		threads.emplace_back([&]() {
+			uint32_t value;
+			while (pop(queue, value, popped))
+			{
+				CHECK(value < seen.size());
+				CHECK(seen[value].fetch_add(1, std::memory_order_relaxed) == 0);
+				popped.fetch_add(1, std::memory_order_relaxed);
+			}
+		});
+	}
+	std::vector<std::thread> producers;
+	for (uint32_t p = 0; p < Producers; p++)
+	{
+		producers.emplace_back([&, p]() {
+			for (uint32_t i = 0; i < PerProducer; i++)
+			{
+				push(queue, p * PerProducer + i);
+			}
+		});
+	}
+	for (std::thread& producer : producers)
+	{
+		producer.join();
+	}
+	finish(queue);
+	for (std::thread& consumer : threads)
+	{
+		consumer.join();
+	}
+
+	CHECK(popped.load() == seen.size());
+	for (const std::atomic<uint8_t>& count : seen)
+	{
+		CHECK(count.load() == 1);
+	}
+}
+
+static void testMPMCDeliversEachItemOnce()
+{
+	constexpr uint32_t Total = 4 * 50000;
+
+	rv::MPMCQueue<uint32_t> queue(128);
+	runMPMC(
+		queue,
+		[](rv::MPMCQueue<uint32_t>& q, uint32_t value) {
+			while (!q.TryPush(value))
+			{
+				std::this_thread::yield();
+			}
+		},
+		[](rv::MPMCQueue<uint32_t>& q, uint32_t& value, std::atomic<uint32_t>& popped) {
+			while (!q.TryPop(value))
+			{
+				if (popped.load(std::memory_order_relaxed) == Total) return false;
+				std::this_thread::yield();
+			}
+			return true;
+		},
+		[](rv::MPMCQueue<uint32_t>&) {});
+
+	using Blocking = rv::BlockingQueue<rv::MPMCQueue<uint32_t>>;
+	Blocking blocking(16);
+	runMPMC(
+		blocking, [](Blocking& q, uint32_t value) { CHECK(q.Push(value)); },
+		[](Blocking& q, uint32_t& value, std::atomic<uint32_t>&) { return q.Pop(value); },
+		[](Blocking& q) { q.Close(); });
+}
+
+static void testEventCountPingPong()
+{
+	// Each side sleeps until the turn is its own, a lost wakeup leaves both asleep
+	constexpr uint32_t Rounds = 20000;
+	std::atomic<uint32_t> turn{0};
+	rv::EventCount changed;
+
+	auto player = [&](uint32_t side) {
+		for (uint32_t round = 0; round < Rounds; round++)
+		{
+			while (turn.load(std::memory_order_acquire) % 2 != side)
+			{
+				const uint32_t ticket = changed.PrepareWait();
+				if (turn.load(std::memory_order_acquire) % 2 == side)
+				{
+					changed.CancelWait();
+					break;
+				}
+				changed.Wait(ticket);
+			}
+			turn.fetch_add(1, std::memory_order_release);
+			changed.NotifyAll();
+		}
+	};
+	std::thread other(player, 1u);
+	player(0);
+	other.join();
+	CHECK(turn.load() == 2 * Rounds);
+}
+
+// Fails the first push it sees and runs beforeRetry ahead of the next one, which puts a Close between Push
+// finding the queue full and its re-check after taking a wait ticket
+struct RetryHookQueue
+{
+	static std::function<void()> beforeRetry;
+
+	explicit RetryHookQueue(size_t capacity) : queue(capacity){};
+
+	bool TryPush(uint32_t value)
+	{
+		if (attempts++ == 0) return false;
+		if (beforeRetry) beforeRetry();
+		return queue.TryPush(value);
+	};
+	bool TryPop(uint32_t& outValue) { return queue.TryPop(outValue); };
+	size_t SizeApprox() const { return queue.SizeApprox(); };
+	size_t Capacity() const { return queue.Capacity(); };
+
+	rv::MPMCQueue<uint32_t> queue;
+	uint32_t attempts = 0;
+};
+std::function<void()> RetryHookQueue::beforeRetry;
+
+static void testPushRacingClose()
+{
+	// Enqueued on the re-check while Close lands, the item counts as pushed and Pop still hands it out
+	rv::BlockingQueue<RetryHookQueue> hooked(4);
+	RetryHookQueue::beforeRetry = [&]() { hooked.Close(); };
+	CHECK(hooked.Push(7u));
+	RetryHookQueue::beforeRetry = nullptr;
+	uint32_t drained;
+	CHECK(hooked.Pop(drained) && drained == 7);
+	CHECK(!hooked.Pop(drained));
+
+	// Under contention Push reports true exactly for the items that made it into the queue. Consumers stop once
+	// the queue is closed and drained, whatever a racing producer enqueued after that is still in the queue
+	for (uint32_t iteration = 0; iteration < 200; iteration++)
+	{
+		rv::BlockingQueue<rv::MPMCQueue<uint32_t>> queue(4);
+		std::atomic<uint32_t> pushed{0};
+		std::atomic<uint32_t> popped{0};
+
+		std::vector<std::thread> threads;
+		for (uint32_t p = 0; p < 4; p++)
+		{
+			threads.emplace_back([&]() {
+				for (uint32_t value = 0; queue.Push(value); value++)
+				{
+					pushed.fetch_add(1, std::memory_order_relaxed);
+				}
+			});
+		}
+		threads.emplace_back([&]() {
+			uint32_t value;
+			while (queue.Pop(value))
+			{
+				popped.fetch_add(1, std::memory_order_relaxed);
+			}
+		});
+
+		while (popped.load(std::memory_order_relaxed) < iteration % 16)
+		{
+			std::this_thread::yield();
+		}
+		queue.Close();
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+
+		uint32_t value;
+		uint32_t left = 0;
+		while (queue.TryPop(value))
+		{
+			left++;
+		}
+		CHECK(pushed.load() == popped.load() + left);
+		CHECK(!queue.Push(value));
+	}
+}
+
+int main()
+{
+	testSPSCKeepsOrder();
+	testMPMCDeliversEachItemOnce();
+	testEventCountPingPong();
+	testPushRacingClose();
+	return 0;
+}
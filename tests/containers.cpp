@@ -0,0 +1,225 @@
+// Flat hash map/set, small vector, fixed vector and handle pool against the std containers
+
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <core/containers/fixedvector.h>
+#include <core/containers/flathashmap.h>
+#include <core/containers/handlepool.h>
+#include <core/containers/smallvector.h>
+
+#include "check.h"
+
+static void testFlatHashMapMatchesStd()
+{
+	std::mt19937 rng(1);
+	rv::FlatHashMap<uint32_t, std::string> map;
+	std::unordered_map<uint32_t, std::string> reference;
+	for (int i = 0; i < 200000; i++)
+	{
+		const uint32_t key = rng() % 5000;
+		switch (rng() % 4)
+		{
+		case 0:
+		case 1:
+			map[key] = std::to_string(i);
+			reference[key] = std::to_string(i);
+			break;
+		case 2:
+			CHECK(map.erase(key) == reference.erase(key));
+			break;
+		default:
+			auto found = map.find(key);
+			auto expected = reference.find(key);
+			CHECK((found == map.end()) == (expected == reference.end()));
+			if (found != map.end()) CHECK(found->second == expected->second);
+		}
+	}
+
+	CHECK(map.size() == reference.size());
+	size_t visited = 0;
+	for (const auto& pair : map)
+	{
+		CHECK(reference.at(pair.first) == pair.second);
+		visited++;
+	}
+	CHECK(visited == reference.size());
+}
+
+static void testFlatHashSetHeterogeneousLookup()
+{
+	rv::FlatHashSet<std::string> set;
+	set.insert(std::string("vert_col.vs"));
+	CHECK(set.contains(std::string_view("vert_col.vs")));
+	CHECK(!set.contains(std::string_view("vert_col.fs")));
+}
+
+static void testSmallVectorGrowth()
+{
+	rv::SmallVector<std::string, 2> vector;
+	for (int i = 0; i < 100; i++)
+	{
+		vector.emplace_back(std::to_string(i) + " long enough to live on the heap");
+	}
+	CHECK(!vector.is_inline());
+	CHECK(vector[99] == "99 long enough to live on the heap");
+
+	rv::SmallVector<std::string, 2> moved(std::move(vector));
+	CHECK(moved.size() == 100 && vector.empty() && vector.is_inline());
+}
+
+// An argument pointing into the vector must survive the growth it triggers
+static void testSmallVectorSelfReference()
+{
+	rv::SmallVector<std::string, 2> vector{"first element, too long for small strings", "second"};
+	CHECK(vector.size() == vector.capacity());
+	vector.push_back(vector[0]);
+	CHECK(vector.size() == 3 && vector[2] == vector[0]);
+
+	for (int i = 0; i < 5; i++)
+	{
+		while (vector.size() < vector.capacity())
+		{
+			vector.push_back("filler");
+		}
+		vector.push_back(vector.front());
+		CHECK(vector.back() == "first element, too long for small strings");
+	}
+}
+
+static void testFixedVector()
+{
+	rv::FixedVector<std::string, 8> vector{"x", "y", "z"};
+	vector.erase_unordered(0);
+	CHECK(vector.size() == 2 && vector[0] == "z" && vector[1] == "y");
+}
+
+namespace
+{
+	struct PoolTag
+	{
+	};
+	using TestPool = rv::HandlePool<PoolTag, std::string>;
+	using TestHandle = TestPool::HandleType;
+} // namespace
+
+static void testHandlePoolMatchesStd()
+{
+	std::mt19937 rng(4);
+	TestPool pool;
+	std::unordered_map<uint32_t, std::string> reference;
+	std::vector<TestHandle> live, dead;
+	// Grows while churning, so no slot is reused often enough to wrap its generation
+	for (int i = 0; i < 30000; i++)
+	{
+		if (live.empty() || rng() % 3 != 0)
+		{
+			const TestHandle handle = pool.Create(std::to_string(i));
+			CHECK(handle && reference.emplace(handle.GetRaw(), std::to_string(i)).second);
+			live.push_back(handle);
+		}
+		else
+		{
+			const size_t pick = rng() % live.size();
+			const TestHandle handle = live[pick];
+			live[pick] = live.back();
+			live.pop_back();
+			std::string value;
+			CHECK(pool.Release(handle, value) && value == reference[handle.GetRaw()]);
+			reference.erase(handle.GetRaw());
+			dead.push_back(handle);
+		}
+	}
+
+	CHECK(pool.size() == reference.size());
+	for (size_t i = 0; i < pool.size(); i++)
+	{
+		CHECK(pool.data()[i] == reference.at(pool.handles()[i].GetRaw()));
+		CHECK(pool.Get(pool.handles()[i]) == &pool.data()[i]);
+	}
+	// Freed and then reused slots never resolve through the old handle
+	for (const TestHandle handle : dead)
+	{
+		CHECK(!pool.IsValid(handle) && !pool.Get(handle) && !pool.Destroy(handle));
+	}
+	CHECK(!pool.IsValid(TestHandle()) && !pool.Get(TestHandle()));
+}
+
+static void testHandlePoolStaleAfterReuse()
+{
+	TestPool pool;
+	const TestHandle a = pool.Create("a");
+	const TestHandle b = pool.Create("b");
+	const TestHandle c = pool.Create("c");
+	CHECK(pool.Destroy(b));
+	CHECK(!pool.Get(b) && !pool.Destroy(b));
+	CHECK(*pool.Get(a) == "a" && *pool.Get(c) == "c");
+
+	// Same slot, next generation: the old handle stays dead
+	const TestHandle d = pool.Create("d");
+	CHECK(d.GetIndex() == b.GetIndex() && d.GetGeneration() == b.GetGeneration() + 1);
+	CHECK(d != b && !pool.Get(b) && *pool.Get(d) == "d");
+
+	pool.Clear();
+	CHECK(pool.empty());
+	for (const TestHandle handle : {a, c, d})
+	{
+		CHECK(!pool.IsValid(handle));
+	}
+	CHECK(*pool.Get(pool.Create("e")) == "e");
+}
+
+static void testHandlePoolFreeListOrder()
+{
+	TestPool pool;
+	std::vector<TestHandle> handles;
+	for (int i = 0; i < 5; i++)
+	{
+		handles.push_back(pool.Create(std::to_string(i)));
+		CHECK(handles.back().GetIndex() == uint32_t(i));
+	}
+	// Most recently freed slot first, fresh slots only once the free list is empty
+	pool.Destroy(handles[1]);
+	pool.Destroy(handles[4]);
+	pool.Destroy(handles[2]);
+	for (uint32_t expected : {2u, 4u, 1u, 5u})
+	{
+		CHECK(pool.Create("x").GetIndex() == expected);
+	}
+}
+
+static void testHandlePoolGenerationWrap()
+{
+	TestPool pool;
+	TestHandle handle = pool.Create("first");
+	CHECK(handle.GetIndex() == 0 && handle.GetGeneration() == 1);
+	const TestHandle first = handle;
+	for (uint32_t generation = 2; generation <= TestHandle::GenerationMask; generation++)
+	{
+		CHECK(pool.Destroy(handle));
+		handle = pool.Create("next");
+		CHECK(handle.GetIndex() == 0 && handle.GetGeneration() == generation && !pool.IsValid(first));
+	}
+
+	// Generation 0 is skipped so slot 0 never produces the null handle
+	CHECK(pool.Destroy(handle));
+	handle = pool.Create("wrapped");
+	CHECK(handle.GetGeneration() == 1 && !handle.IsNull() && !pool.IsValid(TestHandle()));
+	CHECK(!pool.IsValid(TestHandle(0, TestHandle::GenerationMask)));
+}
+
+int main()
+{
+	testFlatHashMapMatchesStd();
+	testFlatHashSetHeterogeneousLookup();
+	testSmallVectorGrowth();
+	testSmallVectorSelfReference();
+	testFixedVector();
+	testHandlePoolMatchesStd();
+	testHandlePoolStaleAfterReuse();
+	testHandlePoolFreeListOrder();
+	testHandlePoolGenerationWrap();
+	return 0;
+}
@@ -0,0 +1,206 @@
+// Sphere and box frustum culling against a scalar reference. Built once with the default SSE path and once with
+// AVX2 and FMA, every lane mask goes through the compaction and the counts are not multiples of the lane width
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <core/jobs.h>
+#include <core/math/frustum.h>
+#include <core/math/simd.h>
+#include <rendering/culling.h>
+
+#include "check.h"
+
+namespace
+{
+	// Closer than this to a plane, the SIMD and scalar sums may round to different sides
+	constexpr float Margin = 1e-3f;
+
+	rv::Frustum makeFrustum()
+	{
+		const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.5f, 100.0f);
+		const glm::mat4 view = glm::lookAt(glm::vec3(3.0f, 2.0f, 10.0f), glm::vec3(0.0f), glm::vec3(0, 1, 0));
+		return rv::Frustum::FromMatrix(projection * view);
+	}
+
+	// Smallest signed distance over the planes, grown by the radius (sphere) or the projected extent (box)
+	float sphereDistance(const rv::Frustum& frustum, const glm::vec3& center, float radius)
+	{
+		float distance = INFINITY;
+		for (const glm::vec4& plane : frustum.planes)
+		{
+			distance = std::fmin(distance, plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w +
+											   radius);
+		}
+		return distance;
+	}
+
+	float boxDistance(const rv::Frustum& frustum, const glm::vec3& center, const glm::vec3& extent)
+	{
+		float distance = INFINITY;
+		for (const glm::vec4& plane : frustum.planes)
+		{
+			const float radius = std::fabs(plane.x) * extent.x + std::fabs(plane.y) * extent.y +
+								 std::fabs(plane.z) * extent.z;
+			distance = std::fmin(distance, plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w +
+											   radius);
+		}
+		return distance;
+	}
+
+	struct Scene
+	{
+		rv::SphereSoA spheres;
+		rv::BoundsSoA bounds;
+		std::vector<bool> sphereVisible;
+		std::vector<bool> boxVisible;
+	};
+
+	// Random instances around the frustum, about half of them visible, none within Margin of a plane
+	Scene makeRandomScene(const rv::Frustum& frustum, size_t count, uint32_t seed)
+	{
+		Scene scene;
+		scene.spheres.Resize(count);
+		scene.bounds.Resize(count);
+		std::mt19937 rng(seed);
+		std::uniform_real_distribution<float> position(-40.0f, 40.0f);
+		std::uniform_real_distribution<float> size(0.1f, 4.0f);
+		for (size_t i = 0; i < count; i++)
+		{
+			glm::vec3 center, extent;
+			float radius, sphere, box;
+			do
+			{
+				center = glm::vec3(position(rng), position(rng), position(rng) - 20.0f);
+				extent = glm::vec3(size(rng), size(rng), size(rng));
+				radius = size(rng);
+				sphere = sphereDistance(frustum, center, radius);
+				box = boxDistance(frustum, center, extent);
+			} while (std::fabs(sphere) < Margin || std::fabs(box) < Margin);
+
+			scene.spheres.Set(i, center, radius);
+			scene.bounds.Set(i, rv::AABB{center - extent, center + extent});
+			scene.sphereVisible.push_back(sphere >= 0.0f);
+			scene.boxVisible.push_back(box >= 0.0f);
+			CHECK(frustum.TestSphere(center, radius) == (sphere >= 0.0f));
+			CHECK(frustum.TestBounds(center, extent) == (box >= 0.0f));
+		}
+		return scene;
+	}
+
+	// Instance i is visible when bit i % 8 of i / 8 is set, so 2048 instances walk all 256 masks of an 8 wide
+	// group (and all 16 of a 4 wide one)
+	Scene makeMaskScene()
+	{
+		constexpr size_t Count = 256 * 8;
+		Scene scene;
+		scene.spheres.Resize(Count);
+		scene.bounds.Resize(Count);
+		for (size_t i = 0; i < Count; i++)
+		{
+			const bool visible = ((i / 8) >> (i % 8)) & 1;
+			// In front of the camera or behind it
+			const glm::vec3 center = visible ? glm::vec3(0.0f) : glm::vec3(6.0f, 4.0f, 20.0f);
+			scene.spheres.Set(i, center, 0.5f);
+			scene.bounds.Set(i, rv::AABB{center - glm::vec3(0.5f), center + glm::vec3(0.5f)});
+			scene.sphereVisible.push_back(visible);
+			scene.boxVisible.push_back(visible);
+		}
+		return scene;
+	}
+
+	void checkVisible(const std::vector<bool>& expected, size_t begin, size_t end, const uint32_t* visible,
+					  size_t count)
+	{
+		size_t next = 0;
+		for (size_t i = begin; i < end; i++)
+		{
+			if (!expected[i]) continue;
+			CHECK(next < count && visible[next] == i);
+			next++;
+		}
+		CHECK(next == count);
+	}
+
+	// The kernels over [begin, end), with a guard past the room they are given
+	void checkRange(const rv::Frustum& frustum, const Scene& scene, size_t begin, size_t end)
+	{
+		constexpr uint32_t Guard = 0xDEADBEEF;
+		std::vector<uint32_t> out(end - begin + 1, Guard);
+
+		size_t count = rv::cullSpheres(frustum, scene.spheres, begin, end, out.data());
+		checkVisible(scene.sphereVisible, begin, end, out.data(), count);
+		CHECK(out.back() == Guard);
+
+		std::fill(out.begin(), out.end(), Guard);
+		count = rv::cullBounds(frustum, scene.bounds, begin, end, out.data());
+		checkVisible(scene.boxVisible, begin, end, out.data(), count);
+		CHECK(out.back() == Guard);
+	}
+} // namespace
+
+static void testEveryMask(const rv::Frustum& frustum)
+{
+	const Scene scene = makeMaskScene();
+	checkRange(frustum, scene, 0, scene.spheres.Size());
+	// Groups straddling the mask pattern, and a scalar tail
+	checkRange(frustum, scene, 3, scene.spheres.Size() - 2);
+}
+
+static void testRandomCounts(const rv::Frustum& frustum)
+{
+	const Scene scene = makeRandomScene(frustum, 4099, 11);
+	size_t visible = 0;
+	for (bool v : scene.sphereVisible) visible += v;
+	CHECK(visible > 4099 / 8 && visible < 4099 - 4099 / 8);
+
+	for (size_t count : {0, 1, 3, 4, 7, 8, 9, 15, 16, 17, 31, 100, 1001, 4099})
+	{
+		checkRange(frustum, scene, 0, count);
+	}
+	for (size_t begin : {1, 5, 8, 13})
+	{
+		checkRange(frustum, scene, begin, begin + 61);
+	}
+}
+
+// The culler splits into chunks on the job system and packs their results back into one list
+static void testFrustumCuller(const rv::Frustum& frustum)
+{
+	gefx::JobSystem jobs(3);
+	gefx::FrustumCuller culler;
+	for (size_t count : {5u, 1024u, 1031u, 5003u, 2049u, 0u})
+	{
+		const Scene scene = makeRandomScene(frustum, count, static_cast<uint32_t>(count));
+		rv::Span<const uint32_t> visible = culler.Cull(jobs, frustum, scene.spheres);
+		checkVisible(scene.sphereVisible, 0, count, visible.data(), visible.size());
+		CHECK(culler.GetStats().tested == count && culler.GetStats().visible == visible.size());
+		const size_t chunkSize = gefx::FrustumCuller::ChunkSize;
+		CHECK(culler.GetStats().chunks == (count + chunkSize - 1) / chunkSize);
+
+		visible = culler.Cull(jobs, frustum, scene.bounds);
+		checkVisible(scene.boxVisible, 0, count, visible.data(), visible.size());
+		CHECK(culler.GetStats().culled + culler.GetStats().visible == count);
+	}
+}
+
+int main()
+{
+#if RV_SIMD_AVX2 && defined(__GNUC__)
+	if (!__builtin_cpu_supports("avx2") || !__builtin_cpu_supports("fma"))
+	{
+		std::printf("AVX2/FMA not supported here, skipped\n");
+		return 77;
+	}
+#endif
+	const rv::Frustum frustum = makeFrustum();
+	testEveryMask(frustum);
+	testRandomCounts(frustum);
+	testFrustumCuller(frustum);
+	return 0;
+}
@@ -0,0 +1,349 @@
+// Descriptor layouts, per-frame descriptor sets and the bindless texture table over fake Vulkan entry points, no
+// Vulkan device needed: layout sharing by description, the set cache and its reset, pool growth and reuse, and
+// bindless slot allocation and release
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <vector>
+
+#include <rendering/device/vkdescriptors.h>
+
+#include "check.h"
+
+using namespace gefx;
+
+namespace
+{
+	template <typename T>
+	T toHandle(uint64_t id)
+	{
+		return reinterpret_cast<T>(id);
+	}
+
+	template <typename T>
+	uint64_t toId(T handle)
+	{
+		return reinterpret_cast<uint64_t>(handle);
+	}
+
+	struct Write
+	{
+		uint64_t set;
+		uint32_t binding;
+		uint32_t element;
+		VkDescriptorType type;
+	};
+
+	// What the fake driver was asked to do. Pools hold maxSets sets of any layout
+	struct FakeDriver
+	{
+		uint64_t nextId{1};
+		bool failLayouts{false};
+		std::set<uint64_t> layouts;
+		uint32_t layoutsCreated{0};
+		VkDescriptorSetLayoutCreateFlags lastLayoutFlags{0};
+		bool lastLayoutHadBindingFlags{false};
+		std::map<uint64_t, uint32_t> poolCapacity;
+		std::map<uint64_t, uint32_t> poolUsed;
+		std::map<uint64_t, uint32_t> poolResets;
+		VkDescriptorPoolCreateFlags lastPoolFlags{0};
+		std::map<uint64_t, uint64_t> setPool;
+		std::vector<Write> writes;
+	};
+
+	FakeDriver driver;
+
+	VKAPI_ATTR VkResult VKAPI_CALL createLayout(VkDevice, const VkDescriptorSetLayoutCreateInfo* info,
+											   const VkAllocationCallbacks*, VkDescriptorSetLayout* out)
+	{
+		if (driver.failLayouts) return VK_ERROR_OUT_OF_HOST_MEMORY;
+		const uint64_t id = driver.nextId++;
+		driver.layouts.insert(id);
+		driver.layoutsCreated++;
+		driver.lastLayoutFlags = info->flags;
+		driver.lastLayoutHadBindingFlags = info->pNext != nullptr;
+		*out = toHandle<VkDescriptorSetLayout>(id);
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL destroyLayout(VkDevice, VkDescriptorSetLayout layout, const VkAllocationCallbacks*)
+	{
+		CHECK(driver.layouts.erase(toId(layout)) == 1);
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL createPool(VkDevice, const VkDescriptorPoolCreateInfo* info,
+											 const VkAllocationCallbacks*, VkDescriptorPool* out)
+	{
+		const uint64_t id = driver.nextId++;
+		driver.poolCapacity[id] = info->maxSets;
+		driver.poolUsed[id] = 0;
+		driver.lastPoolFlags = info->flags;
+		*out = toHandle<VkDescriptorPool>(id);
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL destroyPool(VkDevice, VkDescriptorPool pool, const VkAllocationCallbacks*)
+	{
+		CHECK(driver.poolCapacity.erase(toId(pool)) == 1);
+		driver.poolUsed.erase(toId(pool));
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL resetPool(VkDevice, VkDescriptorPool pool, VkDescriptorPoolResetFlags)
+	{
+		CHECK(driver.poolCapacity.count(toId(pool)) == 1);
+		driver.poolUsed[toId(pool)] = 0;
+		driver.poolResets[toId(pool)]++;
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL allocateSets(VkDevice, const VkDescriptorSetAllocateInfo* info,
+												VkDescriptorSet* out)
+	{
+		const uint64_t pool = toId(info->descriptorPool);
+		CHECK(info->descriptorSetCount == 1 && driver.layouts.count(toId(info->pSetLayouts[0])) == 1);
+		if (driver.poolUsed[pool] == driver.poolCapacity[pool]) return VK_ERROR_OUT_OF_POOL_MEMORY;
+		driver.poolUsed[pool]++;
+		const uint64_t id = driver.nextId++;
+		driver.setPool[id] = pool;
+		*out = toHandle<VkDescriptorSet>(id);
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL updateSets(VkDevice, uint32_t count, const VkWriteDescriptorSet* writes, uint32_t,
+										  const VkCopyDescriptorSet*)
+	{
+		for (uint32_t i = 0; i < count; i++)
+		{
+			CHECK(writes[i].descriptorCount == 1 && (writes[i].pBufferInfo || writes[i].pImageInfo));
+			driver.writes.push_back(
+				{toId(writes[i].dstSet), writes[i].dstBinding, writes[i].dstArrayElement, writes[i].descriptorType});
+		}
+	}
+
+	VulkanFunctions makeFunctions()
+	{
+		driver = FakeDriver{};
+		VulkanFunctions vk;
+		vk.vkCreateDescriptorSetLayout = createLayout;
+		vk.vkDestroyDescriptorSetLayout = destroyLayout;
+		vk.vkCreateDescriptorPool = createPool;
+		vk.vkDestroyDescriptorPool = destroyPool;
+		vk.vkResetDescriptorPool = resetPool;
+		vk.vkAllocateDescriptorSets = allocateSets;
+		vk.vkUpdateDescriptorSets = updateSets;
+		return vk;
+	}
+
+	const VkDevice Device = toHandle<VkDevice>(0x1000);
+
+	VkDescriptorSetLayoutBinding uniformBinding(uint32_t binding)
+	{
+		return {binding, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT, nullptr};
+	}
+} // namespace
+
+static void testLayoutKeys()
+{
+	const VulkanFunctions vk = makeFunctions();
+	DescriptorLayoutCache layouts;
+	layouts.Initialize(&vk, Device);
+
+	const std::vector<VkDescriptorSetLayoutBinding> bindings = {uniformBinding(0), uniformBinding(1)};
+	const VkDescriptorSetLayout layout = layouts.Get(bindings);
+	CHECK(layout && layouts.GetCount() == 1);
+
+	// Equal descriptions stored elsewhere share the layout
+	const VkDescriptorSetLayoutBinding copy[2] = {uniformBinding(0), uniformBinding(1)};
+	CHECK(layouts.Get(rv::Span<const VkDescriptorSetLayoutBinding>(copy, 2)) == layout);
+	CHECK(driver.layoutsCreated == 1);
+
+	// Any field of any binding, the binding count, binding flags and create flags tell layouts apart
+	std::vector<std::vector<VkDescriptorSetLayoutBinding>> variants(6, bindings);
+	variants[0][1].binding = 2;
+	variants[1][1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	variants[2][1].descriptorCount = 2;
+	variants[3][1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	const VkSampler sampler = toHandle<VkSampler>(0x77);
+	variants[4][1].pImmutableSamplers = &sampler;
+	variants[5].pop_back();
+	std::set<VkDescriptorSetLayout> distinct = {layout};
+	for (const std::vector<VkDescriptorSetLayoutBinding>& variant : variants)
+	{
+		distinct.insert(layouts.Get(variant));
+	}
+	const VkDescriptorBindingFlags partiallyBound[2] = {0, VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT};
+	const VkDescriptorBindingFlags none[2] = {0, 0};
+	distinct.insert(layouts.Get(bindings, partiallyBound));
+	CHECK(driver.lastLayoutHadBindingFlags);
+	distinct.insert(layouts.Get(bindings, none));
+	distinct.insert(layouts.Get(bindings, nullptr, VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT));
+	CHECK(driver.lastLayoutFlags == VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT);
+	CHECK(distinct.size() == 10 && layouts.GetCount() == 10 && driver.layoutsCreated == 10);
+
+	// ... and each of them is found again
+	for (const std::vector<VkDescriptorSetLayoutBinding>& variant : variants)
+	{
+		CHECK(distinct.count(layouts.Get(variant)) == 1);
+	}
+	CHECK(distinct.count(layouts.Get(bindings, partiallyBound)) == 1);
+	CHECK(driver.layoutsCreated == 10);
+
+	// A failed creation is not cached
+	driver.failLayouts = true;
+	const VkDescriptorSetLayoutBinding sampled = {0, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1,
+												  VK_SHADER_STAGE_FRAGMENT_BIT, nullptr};
+	CHECK(!layouts.Get(rv::Span<const VkDescriptorSetLayoutBinding>(&sampled, 1)));
+	driver.failLayouts = false;
+	CHECK(layouts.Get(rv::Span<const VkDescriptorSetLayoutBinding>(&sampled, 1)) && layouts.GetCount() == 11);
+
+	layouts.Shutdown();
+	CHECK(driver.layouts.empty() && layouts.GetCount() == 0);
+}
+
+static void testSetCache()
+{
+	const VulkanFunctions vk = makeFunctions();
+	DescriptorLayoutCache layouts;
+	layouts.Initialize(&vk, Device);
+	const VkDescriptorSetLayoutBinding bindings[2] = {uniformBinding(0), uniformBinding(1)};
+	const VkDescriptorSetLayout layout = layouts.Get(rv::Span<const VkDescriptorSetLayoutBinding>(bindings, 2));
+
+	DescriptorAllocator allocator;
+	const VkDescriptorPoolSize sizes[] = {{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2}};
+	allocator.Initialize(&vk, Device, sizes);
+
+	const VkBuffer buffer = toHandle<VkBuffer>(0x500);
+	const VkDescriptorBufferInfo infos[2] = {{buffer, 0, 256}, {buffer, 256, 64}};
+	const VkDescriptorSet set = allocator.GetSet(layout, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, infos, 2);
+	CHECK(set && driver.writes.size() == 2);
+	CHECK(driver.writes[1].set == toId(set) && driver.writes[1].binding == 1);
+
+	// The same resources again are answered by the cache without writing
+	const VkDescriptorBufferInfo again[2] = {{buffer, 0, 256}, {buffer, 256, 64}};
+	CHECK(allocator.GetSet(layout, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, again, 2) == set);
+	CHECK(driver.writes.size() == 2);
+	CHECK(allocator.GetStats().allocated == 1 && allocator.GetStats().reused == 1);
+
+	// Another range, or the same infos under a shorter count, are other sets
+	const VkDescriptorBufferInfo moved[2] = {{buffer, 0, 256}, {buffer, 320, 64}};
+	CHECK(allocator.GetSet(layout, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, moved, 2) != set);
+	CHECK(allocator.GetSet(layout, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, infos, 1) != set);
+
+	// Fill the first pool, the next set comes from a second one
+	const uint32_t total = DescriptorAllocator::SetsPerPool + 10;
+	std::set<VkDescriptorSet> sets;
+	for (uint32_t i = 0; i < total; i++)
+	{
+		const VkDescriptorBufferInfo unique = {buffer, 1024 + i * 64u, 64};
+		sets.insert(allocator.GetSet(layout, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, &unique, 1));
+	}
+	CHECK(sets.size() == total && sets.count(VK_NULL_HANDLE) == 0);
+	CHECK(allocator.GetStats().poolsCreated == 2 && allocator.GetStats().pools == 2);
+	CHECK(allocator.GetStats().allocated == total + 3);
+	for (const auto& [pool, capacity] : driver.poolCapacity)
+	{
+		CHECK(capacity == DescriptorAllocator::SetsPerPool);
+	}
+
+	// Reset gives every pool back and forgets every set: the same resources are written into a new set, out of
+	// the first pool again, and no pool is created until both are full
+	allocator.Reset();
+	CHECK(allocator.GetStats().allocated == 0 && allocator.GetStats().reused == 0);
+	CHECK(allocator.GetStats().pools == 2 && allocator.GetStats().poolsCreated == 0);
+	CHECK(driver.poolResets.size() == 2);
+	const size_t writesBefore = driver.writes.size();
+	const VkDescriptorSet fresh = allocator.GetSet(layout, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, infos, 2);
+	CHECK(fresh && fresh != set && driver.writes.size() == writesBefore + 2);
+	CHECK(driver.setPool[toId(fresh)] == driver.setPool[toId(set)]);
+	for (uint32_t i = 1; i < 2 * DescriptorAllocator::SetsPerPool; i++)
+	{
+		const VkDescriptorBufferInfo unique = {buffer, i * 64u, 64};
+		CHECK(allocator.GetSet(layout, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, &unique, 1));
+	}
+	CHECK(allocator.GetStats().poolsCreated == 0 && driver.poolCapacity.size() == 2);
+
+	// Only the pools in use are reset
+	allocator.Reset();
+	allocator.GetSet(layout, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, infos, 2);
+	allocator.Reset();
+	uint32_t resets = 0;
+	for (const auto& [pool, count] : driver.poolResets) resets += count;
+	CHECK(resets == 2 + 2 + 1);
+
+	// Image sets are keyed by sampler, view and layout
+	const VkDescriptorImageInfo image = {toHandle<VkSampler>(0x600), toHandle<VkImageView>(0x601),
+										 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+	VkDescriptorImageInfo general = image;
+	general.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+	const VkDescriptorSet sampled = allocator.GetSet(layout, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, &image, 1);
+	CHECK(allocator.GetSet(layout, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, &image, 1) == sampled);
+	CHECK(allocator.GetSet(layout, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, &general, 1) != sampled);
+	CHECK(driver.writes.back().type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+
+	allocator.Shutdown();
+	CHECK(driver.poolCapacity.empty());
+	layouts.Shutdown();
+}
+
+static void testBindless()
+{
+	const VulkanFunctions vk = makeFunctions();
+	DescriptorLayoutCache layouts;
+	layouts.Initialize(&vk, Device);
+
+	BindlessTextureTable table;
+	CHECK(!table.IsEnabled());
+	CHECK(table.Initialize(&vk, Device, layouts, 4));
+	CHECK(table.IsEnabled() && table.GetCapacity() == 4 && table.GetCount() == 0);
+	CHECK(driver.lastLayoutHadBindingFlags);
+	CHECK(driver.lastLayoutFlags == VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT);
+	CHECK(driver.lastPoolFlags == VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT);
+	CHECK(layouts.GetCount() == 1);
+
+	const VkSampler sampler = toHandle<VkSampler>(0x700);
+	auto add = [&](uint64_t view) { return table.Add(sampler, toHandle<VkImageView>(view)); };
+
+	// Slots are handed out in order and each one is written at its array element
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		CHECK(add(0x800 + i) == i);
+		CHECK(driver.writes.back().set == toId(table.GetSet()) && driver.writes.back().element == i);
+	}
+	CHECK(table.GetCount() == 4);
+	CHECK(add(0x900) == BindlessTextureTable::InvalidIndex && table.GetCount() == 4);
+
+	// Freed slots are reused, most recent first
+	table.Remove(1);
+	table.Remove(3);
+	CHECK(table.GetCount() == 2);
+	CHECK(add(0x901) == 3 && add(0x902) == 1);
+	CHECK(driver.writes.back().element == 1 && table.GetCount() == 4);
+	CHECK(add(0x903) == BindlessTextureTable::InvalidIndex);
+
+	// Slots never handed out are ignored
+	table.Remove(BindlessTextureTable::InvalidIndex);
+	table.Remove(4);
+	CHECK(table.GetCount() == 4);
+
+	// The pool goes with the table, the layout with the cache
+	table.Shutdown();
+	CHECK(!table.IsEnabled() && table.GetCount() == 0 && driver.poolCapacity.empty());
+	CHECK(driver.layouts.size() == 1);
+	layouts.Shutdown();
+	CHECK(driver.layouts.empty());
+
+	// A table initialized again starts from slot 0
+	CHECK(table.Initialize(&vk, Device, layouts, 2));
+	CHECK(add(0xA00) == 0 && add(0xA01) == 1 && add(0xA02) == BindlessTextureTable::InvalidIndex);
+	table.Shutdown();
+	layouts.Shutdown();
+}
+
+int main()
+{
+	testLayoutKeys();
+	testSetCache();
+	testBindless();
+	return 0;
+}
@@ -0,0 +1,329 @@
+// TLSF suballocation and the device memory allocator over a fake backend, no Vulkan device needed: placement
+// (no overlap, alignment, bufferImageGranularity), coalescing, block lifetime and defragmentation planning
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <rendering/device/vkmemory.h>
+
+#include "check.h"
+
+using namespace gefx;
+
+namespace
+{
+	struct Placed
+	{
+		uint64_t offset;
+		uint64_t size;
+		MemoryKind kind;
+	};
+
+	// Placed ranges sorted by offset must not overlap, and neighbours of different kinds must not share a page
+	void checkPlacement(std::vector<Placed> placed, uint64_t granularity)
+	{
+		std::sort(placed.begin(), placed.end(), [](const Placed& a, const Placed& b) { return a.offset < b.offset; });
+		for (size_t i = 1; i < placed.size(); i++)
+		{
+			const Placed& previous = placed[i - 1];
+			CHECK(placed[i].offset >= previous.offset + previous.size);
+			if (placed[i].kind != previous.kind)
+			{
+				CHECK((previous.offset + previous.size - 1) / granularity < placed[i].offset / granularity);
+			}
+		}
+	}
+
+	// Blocks are host memory, handles count up from 1
+	class FakeBackend final : public IMemoryBackend
+	{
+	  public:
+		bool AllocateBlock(uint32_t memoryType, uint64_t size, VkDeviceMemory& outMemory,
+						   uint8_t*& outMapped) override
+		{
+			const uint64_t id = ++_nextId;
+			Block& block = _blocks[id];
+			block.bytes.reset(new uint8_t[size]);
+			block.size = size;
+			outMemory = reinterpret_cast<VkDeviceMemory>(id);
+			outMapped = memoryType == HostType ? block.bytes.get() : nullptr;
+			return true;
+		};
+
+		void FreeBlock(uint32_t, VkDeviceMemory memory) override
+		{
+			CHECK(_blocks.erase(reinterpret_cast<uint64_t>(memory)) == 1);
+		};
+
+		size_t GetBlockCount() const { return _blocks.size(); };
+		uint64_t GetBlockSize(VkDeviceMemory memory) const
+		{
+			return _blocks.at(reinterpret_cast<uint64_t>(memory)).size;
+		};
+
+		static constexpr uint32_t DeviceType = 0;
+		static constexpr uint32_t HostType = 1;
+
+	  private:
+		struct Block
+		{
+			std::unique_ptr<uint8_t[]> bytes;
+			uint64_t size;
+		};
+		std::map<uint64_t, Block> _blocks;
+		uint64_t _nextId{0};
+	};
+
+	// A discrete GPU: device local heap, and host visible coherent memory in system RAM
+	VkPhysicalDeviceMemoryProperties makeProperties()
+	{
+		VkPhysicalDeviceMemoryProperties properties{};
+		properties.memoryHeapCount = 2;
+		properties.memoryHeaps[0].size = 1ull << 30;
+		properties.memoryHeaps[0].flags = VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+		properties.memoryHeaps[1].size = 1ull << 30;
+		properties.memoryTypeCount = 2;
+		properties.memoryTypes[FakeBackend::DeviceType].propertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		properties.memoryTypes[FakeBackend::DeviceType].heapIndex = 0;
+		properties.memoryTypes[FakeBackend::HostType].propertyFlags =
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		properties.memoryTypes[FakeBackend::HostType].heapIndex = 1;
+		return properties;
+	}
+
+	constexpr uint64_t BlockSize = 1ull << 20;
+	constexpr uint64_t Granularity = 1024;
+} // namespace
+
+static void testTlsfRandomPlacement()
+{
+	std::mt19937_64 rng(3);
+	for (int round = 0; round < 100; round++)
+	{
+		const uint64_t total = rng() % (1u << 24) + 4096;
+		const uint64_t granularity = 1ull << (rng() % 13);
+		TlsfAllocator tlsf(total);
+		std::map<uint32_t, Placed> live;
+
+		for (int op = 0; op < 2000; op++)
+		{
+			if (live.empty() || rng() % 3)
+			{
+				const uint64_t size = 1 + rng() % (rng() % 4 == 0 ? total / 4 : 4096);
+				const uint64_t alignment = 1ull << (rng() % 12);
+				const MemoryKind kind = (rng() & 1) ? MemoryKind::Linear : MemoryKind::Optimal;
+				uint64_t offset;
+				const uint32_t node = tlsf.Allocate(size, alignment, kind, granularity, offset);
+				if (node == TlsfAllocator::InvalidNode) continue;
+
+				CHECK(offset % alignment == 0 && offset + size <= total);
+				const TlsfAllocator::Allocation allocation = tlsf.GetAllocation(node);
+				CHECK(allocation.offset <= offset && allocation.offset + allocation.size >= offset + size);
+				live[node] = Placed{allocation.offset, allocation.size, kind};
+			}
+			else
+			{
+				auto it = live.begin();
+				std::advance(it, rng() % live.size());
+				tlsf.Free(it->first);
+				live.erase(it);
+			}
+		}
+
+		std::vector<Placed> placed;
+		uint64_t used = 0;
+		for (const auto& entry : live)
+		{
+			placed.push_back(entry.second);
+			used += entry.second.size;
+		}
+		checkPlacement(placed, granularity);
+		CHECK(used == tlsf.GetUsed() && live.size() == tlsf.GetAllocationCount());
+
+		// Everything freed merges back into one range
+		for (const auto& entry : live)
+		{
+			tlsf.Free(entry.first);
+		}
+		CHECK(tlsf.IsEmpty() && tlsf.GetUsed() == 0 && tlsf.GetLargestFree() == total);
+	}
+}
+
+static void testTlsfCoalescing()
+{
+	TlsfAllocator tlsf(4096);
+	uint64_t offsets[4];
+	uint32_t nodes[4];
+	for (int i = 0; i < 4; i++)
+	{
+		nodes[i] = tlsf.Allocate(1024, 1, MemoryKind::Linear, 1, offsets[i]);
+		CHECK(nodes[i] != TlsfAllocator::InvalidNode);
+	}
+	CHECK(tlsf.GetLargestFree() == 0);
+
+	// Freed out of order: the gaps merge with whichever neighbours are already free
+	tlsf.Free(nodes[0]);
+	tlsf.Free(nodes[2]);
+	CHECK(tlsf.GetLargestFree() == 1024);
+	tlsf.Free(nodes[1]);
+	CHECK(tlsf.GetLargestFree() == 3072);
+	uint64_t offset;
+	CHECK(tlsf.Allocate(3072, 1, MemoryKind::Linear, 1, offset) != TlsfAllocator::InvalidNode && offset == 0);
+}
+
+static void testAllocatorPlacementAndBlocks()
+{
+	FakeBackend backend;
+	DeviceMemoryAllocator allocator;
+	allocator.Initialize(&backend, makeProperties(), Granularity, BlockSize);
+
+	std::mt19937 rng(5);
+	std::vector<MemoryAllocation> allocations;
+	std::map<VkDeviceMemory, std::vector<Placed>> perBlock;
+	for (int i = 0; i < 400; i++)
+	{
+		MemoryRequest request;
+		request.size = 256 + rng() % 16384;
+		request.alignment = 1ull << (rng() % 9);
+		request.kind = (rng() & 1) ? MemoryKind::Linear : MemoryKind::Optimal;
+		request.usage = (i % 4 == 0) ? MemoryUsage::Upload : MemoryUsage::GpuOnly;
+
+		MemoryAllocation allocation;
+		CHECK(allocator.Allocate(request, allocation));
+		CHECK(allocation.offset % request.alignment == 0 && allocation.size >= request.size);
+		CHECK(allocation.offset + allocation.size <= backend.GetBlockSize(allocation.memory));
+		if (request.usage == MemoryUsage::Upload)
+		{
+			CHECK(allocation.memoryType == FakeBackend::HostType && allocation.mapped != nullptr);
+		}
+		else
+		{
+			CHECK(allocation.memoryType == FakeBackend::DeviceType && allocation.mapped == nullptr);
+		}
+		perBlock[allocation.memory].push_back(Placed{allocation.offset, allocation.size, request.kind});
+		allocations.push_back(allocation);
+	}
+	for (const auto& block : perBlock)
+	{
+		checkPlacement(block.second, Granularity);
+	}
+
+	// Bigger than half a block gets a block of its own, released with it
+	MemoryRequest large;
+	large.size = BlockSize;
+	MemoryAllocation dedicated;
+	const size_t blocksBefore = backend.GetBlockCount();
+	CHECK(allocator.Allocate(large, dedicated));
+	CHECK(backend.GetBlockCount() == blocksBefore + 1 && dedicated.offset == 0);
+	allocator.Free(dedicated);
+	CHECK(backend.GetBlockCount() == blocksBefore);
+
+	// Emptied blocks go back to the backend, but one per type is kept for reuse
+	for (const MemoryAllocation& allocation : allocations)
+	{
+		allocator.Free(allocation);
+	}
+	CHECK(backend.GetBlockCount() == 2);
+	CHECK(allocator.GetHeapStats(0).allocatedBytes == 0 && allocator.GetHeapStats(0).allocations == 0);
+	CHECK(allocator.GetHeapStats(0).blocks == 1 && allocator.GetHeapStats(1).blocks == 1);
+
+	// Past the budget nothing new is created, the kept block still serves
+	allocator.SetHeapBudget(0, BlockSize);
+	MemoryRequest request;
+	request.size = BlockSize / 4;
+	MemoryAllocation first, second, refused;
+	CHECK(allocator.Allocate(request, first) && allocator.Allocate(request, second));
+	large.size = BlockSize / 2 + 1;
+	large.typeBits = 1u << FakeBackend::DeviceType;
+	CHECK(!allocator.Allocate(large, refused));
+	allocator.Free(first);
+	allocator.Free(second);
+	allocator.Shutdown();
+	CHECK(backend.GetBlockCount() == 0);
+}
+
+static void testDefragmentationPlan()
+{
+	FakeBackend backend;
+	DeviceMemoryAllocator allocator;
+	allocator.Initialize(&backend, makeProperties(), Granularity, BlockSize);
+
+	// Four blocks full of movable 64KB allocations, then most of them freed
+	std::vector<MemoryAllocation> allocations;
+	for (uint32_t i = 0; i < 4 * 15; i++)
+	{
+		MemoryRequest request;
+		request.size = 64 * 1024;
+		request.movable = true;
+		request.userData = i;
+		MemoryAllocation allocation;
+		CHECK(allocator.Allocate(request, allocation));
+		allocations.push_back(allocation);
+	}
+	CHECK(backend.GetBlockCount() == 4);
+
+	std::map<uint64_t, MemoryAllocation> live;
+	for (uint32_t i = 0; i < allocations.size(); i++)
+	{
+		if (i % 5 == 0)
+		{
+			live[i] = allocations[i];
+		}
+		else
+		{
+			allocator.Free(allocations[i]);
+		}
+	}
+	CHECK(backend.GetBlockCount() == 4);
+
+	std::vector<MemoryMove> moves;
+	allocator.PlanDefragmentation(64, moves);
+	CHECK(!moves.empty());
+
+	std::map<VkDeviceMemory, std::vector<Placed>> perBlock;
+	for (const auto& entry : live)
+	{
+		perBlock[entry.second.memory].push_back(Placed{entry.second.offset, entry.second.size, MemoryKind::Linear});
+	}
+	for (const MemoryMove& move : moves)
+	{
+		const MemoryAllocation& current = live.at(move.userData);
+		CHECK(move.from.memory == current.memory && move.from.offset == current.offset);
+		CHECK(move.to.memory != move.from.memory && move.to.size >= current.size);
+		perBlock[move.to.memory].push_back(Placed{move.to.offset, move.to.size, MemoryKind::Linear});
+	}
+	// Destinations sit next to what stays, overlapping nothing
+	for (const auto& block : perBlock)
+	{
+		checkPlacement(block.second, Granularity);
+	}
+
+	// What the owner does once the copies are done: emptied sources go away with their last free
+	for (const MemoryMove& move : moves)
+	{
+		allocator.Free(move.from);
+		live[move.userData] = move.to;
+	}
+	CHECK(backend.GetBlockCount() < 4);
+
+	for (const auto& entry : live)
+	{
+		allocator.Free(entry.second);
+	}
+	CHECK(backend.GetBlockCount() == 1);
+	allocator.Shutdown();
+	CHECK(backend.GetBlockCount() == 0);
+}
+
+int main()
+{
+	testTlsfRandomPlacement();
+	testTlsfCoalescing();
+	testAllocatorPlacementAndBlocks();
+	testDefragmentationPlan();
+	return 0;
+}
@@ -0,0 +1,253 @@
+// ECS storage: archetype moves keep component values, queries walk the chunks of every matching archetype, and
+// command buffers apply deferred creates, destroys and adds with the entity generations that go with them
+
+#include <atomic>
+#include <vector>
+
+#include <core/ecs/commandbuffer.h>
+#include <core/ecs/world.h>
+#include <core/jobs.h>
+
+#include "check.h"
+
+using namespace gefx;
+
+namespace
+{
+	struct Position
+	{
+		float x, y, z;
+	};
+
+	struct Velocity
+	{
+		float x;
+	};
+
+	struct Health
+	{
+		int value;
+	};
+
+	// Counts live instances, so a component moved without its source being destroyed (or destroyed twice) shows
+	struct Tracked
+	{
+		static inline int live = 0;
+
+		explicit Tracked(int v) : value(v) { live++; };
+		Tracked(Tracked&& other) noexcept : value(other.value) { live++; };
+		Tracked(const Tracked& other) : value(other.value) { live++; };
+		Tracked& operator=(const Tracked&) = default;
+		~Tracked() { live--; };
+
+		int value;
+	};
+
+	Position positionOf(int i)
+	{
+		return Position{float(i), float(i) * 2.0f, -float(i)};
+	}
+
+	bool hasPosition(World& world, Entity entity, int i)
+	{
+		const Position* position = world.Get<Position>(entity);
+		return position && position->x == float(i) && position->y == float(i) * 2.0f && position->z == -float(i);
+	}
+} // namespace
+
+static void testArchetypeMoves()
+{
+	{
+		World world;
+		// Enough entities for several chunks per archetype, so moves also swap rows across chunks
+		constexpr int Count = 5000;
+		std::vector<Entity> entities;
+		for (int i = 0; i < Count; i++)
+		{
+			entities.push_back(world.Create(positionOf(i), Velocity{float(i)}, Tracked(i)));
+		}
+		for (int i = 0; i < Count; i += 3)
+		{
+			world.Add(entities[i], Health{i});
+		}
+		for (int i = 0; i < Count; i += 5)
+		{
+			world.Remove<Velocity>(entities[i]);
+		}
+		// Overwriting keeps the entity where it is
+		world.Add(entities[1], Velocity{-1.0f});
+
+		CHECK(world.GetEntityCount() == Count && Tracked::live == Count);
+		for (int i = 0; i < Count; i++)
+		{
+			const Entity entity = entities[i];
+			CHECK(hasPosition(world, entity, i) && world.Get<Tracked>(entity)->value == i);
+			CHECK(world.Has<Health>(entity) == (i % 3 == 0));
+			CHECK(i % 3 != 0 || world.Get<Health>(entity)->value == i);
+			CHECK(world.Has<Velocity>(entity) == (i % 5 != 0));
+			CHECK(i % 5 == 0 || world.Get<Velocity>(entity)->x == (i == 1 ? -1.0f : float(i)));
+		}
+
+		// Back to the original component set: same archetype as the untouched entities
+		world.Remove<Health>(entities[0]);
+		world.Add(entities[0], Velocity{7.0f});
+		CHECK(world.Get<Velocity>(entities[0])->x == 7.0f && hasPosition(world, entities[0], 0));
+
+		for (int i = 0; i < Count; i += 2)
+		{
+			world.Destroy(entities[i]);
+		}
+		CHECK(world.GetEntityCount() == Count / 2 && Tracked::live == Count / 2);
+		for (int i = 1; i < Count; i += 2)
+		{
+			CHECK(hasPosition(world, entities[i], i) && world.Get<Tracked>(entities[i])->value == i);
+		}
+	}
+	// The world destroys what its archetypes still hold
+	CHECK(Tracked::live == 0);
+}
+
+static void testChunkIteration(JobSystem& jobs)
+{
+	World world;
+	constexpr int Count = 4000;
+	std::vector<Entity> entities;
+	int withVelocity = 0;
+	int withVelocityNoHealth = 0;
+	for (int i = 0; i < Count; i++)
+	{
+		// Four archetypes: P, PV, PH, PVH
+		const Entity entity = world.Create(positionOf(i));
+		if (i & 1) world.Add(entity, Velocity{1.0f});
+		if (i & 2) world.Add(entity, Health{i});
+		withVelocity += i & 1;
+		withVelocityNoHealth += (i & 1) && !(i & 2);
+		entities.push_back(entity);
+	}
+
+	Query& all = world.GetQuery<const Position>();
+	CHECK(all.Count() == Count);
+	std::vector<int> seen(Count, 0);
+	uint32_t chunks = 0;
+	all.ForEachChunk([&](const ChunkView& chunk) {
+		chunks++;
+		const Entity* chunkEntities = chunk.Entities();
+		const Position* positions = chunk.Column<const Position>();
+		for (uint32_t row = 0; row < chunk.Count(); row++)
+		{
+			const int i = static_cast<int>(positions[row].x);
+			CHECK(chunkEntities[row] == entities[i] && world.Get<Position>(entities[i]) == &positions[row]);
+			seen[i]++;
+		}
+	});
+	CHECK(chunks > 4);
+	for (int count : seen)
+	{
+		CHECK(count == 1);
+	}
+
+	Query& moving = world.GetQuery<Position, const Velocity>();
+	CHECK(moving.Count() == size_t(withVelocity));
+	moving.Each<Position, const Velocity>(
+		[](Position& position, const Velocity& velocity) { position.x += velocity.x; });
+	for (int i = 0; i < Count; i++)
+	{
+		CHECK(world.Get<Position>(entities[i])->x == float(i) + ((i & 1) ? 1.0f : 0.0f));
+	}
+
+	Query& healthy = world.GetQuery<const Velocity>(componentMask<Health>());
+	CHECK(healthy.Count() == size_t(withVelocityNoHealth));
+
+	// An archetype created after the query was last used is picked up
+	for (int i = 0; i < 100; i++)
+	{
+		world.Create(Velocity{2.0f}, Tracked(i));
+	}
+	CHECK(healthy.Count() == size_t(withVelocityNoHealth + 100));
+
+	std::atomic<int> visited{0};
+	std::atomic<int> total{0};
+	healthy.ParallelEach<const Velocity>(jobs, [&](const Velocity& velocity) {
+		visited++;
+		total += static_cast<int>(velocity.x);
+	});
+	CHECK(visited.load() == withVelocityNoHealth + 100 && total.load() == withVelocityNoHealth + 200);
+}
+
+static void testCommandBuffer()
+{
+	{
+		World world;
+		const Entity kept = world.Create(positionOf(1), Velocity{1.0f});
+		const Entity doomed = world.Create(positionOf(2));
+		const Entity stale = world.Create(positionOf(3));
+		world.Destroy(stale);
+
+		CommandBuffer commands;
+		commands.Destroy(doomed);
+		// Lands in the slot doomed frees, one generation later
+		commands.Create(positionOf(4), Tracked(4));
+		commands.Add(kept, Health{10});
+		commands.Add(kept, Tracked(11));
+		commands.Remove<Velocity>(kept);
+		// Both target dead entities and are dropped, their payloads still destroyed
+		commands.Add(doomed, Tracked(12));
+		commands.Add(stale, Tracked(13));
+		CHECK(commands.GetCommandCount() == 7 && Tracked::live == 4);
+		CHECK(world.IsAlive(doomed) && world.GetEntityCount() == 2);
+
+		commands.Playback(world);
+		CHECK(commands.Empty() && world.GetEntityCount() == 2 && Tracked::live == 2);
+		CHECK(!world.IsAlive(doomed) && !world.IsAlive(stale) && world.IsAlive(kept));
+		CHECK(world.Get<Health>(kept)->value == 10 && world.Get<Tracked>(kept)->value == 11);
+		CHECK(!world.Has<Velocity>(kept) && hasPosition(world, kept, 1));
+
+		Entity created;
+		world.GetQuery<const Tracked>().ForEachChunk([&](const ChunkView& chunk) {
+			for (uint32_t row = 0; row < chunk.Count(); row++)
+			{
+				if (chunk.Entities()[row] != kept) created = chunk.Entities()[row];
+			}
+		});
+		CHECK(world.IsAlive(created) && hasPosition(world, created, 4) && world.Get<Tracked>(created)->value == 4);
+		CHECK(created.GetIndex() == doomed.GetIndex() && created.GetGeneration() == doomed.GetGeneration() + 1);
+		CHECK(created != doomed);
+
+		// Recorded while iterating, applied after
+		for (int i = 0; i < 50; i++)
+		{
+			world.Create(positionOf(i), Health{i});
+		}
+		world.Each<const Health>([&](const Health& health) {
+			if (health.value % 2) commands.Create(Velocity{float(health.value)});
+		});
+		world.GetQuery<const Health>().ForEachChunk([&](const ChunkView& chunk) {
+			for (uint32_t row = 0; row < chunk.Count(); row++)
+			{
+				if (chunk.Column<const Health>()[row].value % 2 == 0) commands.Destroy(chunk.Entities()[row]);
+			}
+		});
+		commands.Playback(world);
+		// kept has Health 10 and goes too
+		CHECK(world.GetQuery<const Health>().Count() == 25);
+		CHECK(!world.IsAlive(kept) && Tracked::live == 1);
+		CHECK(world.GetQuery<const Velocity>().Count() == 25);
+
+		// Cleared commands never run but release what they hold
+		commands.Create(Tracked(20));
+		commands.Add(created, Tracked(21));
+		CHECK(Tracked::live == 3);
+		commands.Clear();
+		CHECK(commands.Empty() && Tracked::live == 1 && world.Get<Tracked>(created)->value == 4);
+	}
+	CHECK(Tracked::live == 0);
+}
+
+int main()
+{
+	JobSystem jobs(2);
+	testArchetypeMoves();
+	testChunkIteration(jobs);
+	testCommandBuffer();
+	return 0;
+}
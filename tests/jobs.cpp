@@ -0,0 +1,105 @@
+// Job system thread indices: workers and attached threads each get a slot of their own, so per-thread data is
+// never used by two threads at once, also while a second thread runs jobs next to the one scheduling them
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <core/jobs.h>
+
+#include "check.h"
+
+static void testIndicesStayInRange(gefx::JobSystem& jobs)
+{
+	std::vector<std::atomic<uint32_t>> seen(jobs.GetThreadCount());
+	jobs.ParallelFor(10000, 1, [&](uint32_t, uint32_t) {
+		const uint32_t index = gefx::JobSystem::GetThreadIndex();
+		CHECK(index <= jobs.GetWorkerCount());
+		seen[index]++;
+	});
+	uint32_t total = 0;
+	for (const auto& count : seen) total += count.load();
+	CHECK(total == 10000);
+}
+
+static void testAttachSlots(gefx::JobSystem& jobs)
+{
+	CHECK(gefx::JobSystem::GetThreadIndex() == 0);
+
+	// Every slot once, then none left until one is given back
+	std::vector<uint32_t> indices(gefx::JobSystem::MaxAttachedThreads + 1);
+	std::vector<bool> attached(indices.size());
+	std::vector<std::thread> threads;
+	std::atomic<uint32_t> done{0};
+	std::atomic<bool> release{false};
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		threads.emplace_back([&, i]() {
+			attached[i] = jobs.AttachThread();
+			indices[i] = gefx::JobSystem::GetThreadIndex();
+			done++;
+			while (!release.load()) std::this_thread::yield();
+			if (attached[i]) jobs.DetachThread();
+		});
+		while (done.load() != i + 1) std::this_thread::yield();
+	}
+	release = true;
+	for (std::thread& thread : threads) thread.join();
+
+	for (uint32_t i = 0; i < gefx::JobSystem::MaxAttachedThreads; i++)
+	{
+		CHECK(attached[i] && indices[i] == jobs.GetWorkerCount() + 1 + i);
+	}
+	CHECK(!attached.back() && indices.back() == 0);
+
+	std::thread again([&]() {
+		CHECK(jobs.AttachThread());
+		CHECK(gefx::JobSystem::GetThreadIndex() == jobs.GetWorkerCount() + 1);
+		jobs.DetachThread();
+		CHECK(gefx::JobSystem::GetThreadIndex() == 0);
+	});
+	again.join();
+}
+
+// The render thread splits work over the job system while the main thread helps with queued jobs, like
+// VulkanDevice::Submit recording lists during SystemScheduler::Run. A slot held by two threads at once is a race
+static void testSlotsAreExclusive(gefx::JobSystem& jobs)
+{
+	std::unique_ptr<std::atomic<bool>[]> inUse(new std::atomic<bool>[jobs.GetThreadCount()]);
+	for (uint32_t i = 0; i < jobs.GetThreadCount(); i++) inUse[i] = false;
+	std::atomic<bool> shared{false};
+
+	auto job = [&](uint32_t, uint32_t) {
+		std::atomic<bool>& slot = inUse[gefx::JobSystem::GetThreadIndex()];
+		if (slot.exchange(true)) shared = true;
+		std::this_thread::yield();
+		slot = false;
+	};
+
+	std::atomic<bool> rendering{true};
+	std::thread renderer([&]() {
+		CHECK(jobs.AttachThread());
+		for (int frame = 0; frame < 2000; frame++)
+		{
+			jobs.ParallelFor(16, 1, job);
+		}
+		jobs.DetachThread();
+		rendering = false;
+	});
+	while (rendering.load())
+	{
+		if (!jobs.TryRunOne()) std::this_thread::yield();
+	}
+	renderer.join();
+	CHECK(!shared.load());
+}
+
+int main()
+{
+	gefx::JobSystem jobs(3);
+	testIndicesStayInRange(jobs);
+	testAttachSlots(jobs);
+	testSlotsAreExclusive(jobs);
+	return 0;
+}
@@ -0,0 +1,154 @@
+// Logger: every message of every thread reaches the sink once and in the order its thread wrote it, through ring
+// wrap-around and full rings, and a crash signal flushes what is still staged in the same line format
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <csignal>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include <core/log.h>
+
+#include "check.h"
+
+namespace
+{
+	struct Line
+	{
+		double seconds;
+		unsigned thread;
+		std::string level;
+		unsigned producer;
+		unsigned sequence;
+	};
+
+	std::string tempPath(const char* name)
+	{
+		return (std::filesystem::temp_directory_path() / name).string();
+	}
+
+	// "[{:12.6f}] [T{:02}] [{}] producer P message N", column positions included
+	std::vector<Line> readLines(const std::string& path)
+	{
+		std::vector<Line> lines;
+		std::ifstream in(path.c_str());
+		std::string text;
+		while (std::getline(in, text))
+		{
+			CHECK(text.size() > 28 && text[0] == '[' && text[6] == '.' && text.compare(13, 4, "] [T") == 0);
+			CHECK(text.compare(19, 3, "] [") == 0 && text.compare(27, 2, "] ") == 0);
+			Line line;
+			char level[6] = {};
+			CHECK(std::sscanf(text.c_str(), "[%lf] [T%u] [%5c] producer %u message %u", &line.seconds, &line.thread,
+							  level, &line.producer, &line.sequence) == 5);
+			line.level = level;
+			lines.push_back(line);
+		}
+		return lines;
+	}
+} // namespace
+
+#if defined(__unix__) || defined(__APPLE__)
+// The handler runs in a child so the test survives it: whatever the writer had not drained yet is written by
+// FlushFromSignal, and the file must read the same as one written by the writer thread
+static void testCrashFlush()
+{
+	const std::string path = tempPath("grefixs_log_crash.txt");
+	const pid_t child = fork();
+	CHECK(child >= 0);
+	if (child == 0)
+	{
+		gefx::LoggerConfig config;
+		config.filePath = path.c_str();
+		config.console = false;
+		gefx::Logger::Get().Start(config);
+		for (unsigned i = 0; i < 200; i++)
+		{
+			GEFX_LOG_ERROR("producer {} message {}", 0, i);
+		}
+		std::raise(SIGSEGV);
+		_exit(0);
+	}
+	int status = 0;
+	CHECK(waitpid(child, &status, 0) == child);
+	CHECK(WIFSIGNALED(status) && WTERMSIG(status) == SIGSEGV);
+
+	const std::vector<Line> lines = readLines(path);
+	CHECK(lines.size() == 200);
+	for (unsigned i = 0; i < lines.size(); i++)
+	{
+		CHECK(lines[i].sequence == i && lines[i].level == "ERROR");
+		CHECK(i == 0 || lines[i].seconds >= lines[i - 1].seconds);
+	}
+	std::remove(path.c_str());
+}
+#endif
+
+// The smallest ring holds about a hundred messages, so producers wrap it many times and wait on the writer
+static void testThreadsDrainInOrder()
+{
+	const std::string path = tempPath("grefixs_log_threads.txt");
+	gefx::LoggerConfig config;
+	config.filePath = path.c_str();
+	config.console = false;
+	config.threadBufferSize = 4096;
+	config.installCrashHandlers = false;
+	gefx::Logger::Get().Start(config);
+
+	constexpr unsigned Producers = 4;
+	constexpr unsigned Messages = 5000;
+	std::vector<std::thread> threads;
+	for (unsigned producer = 0; producer < Producers; producer++)
+	{
+		threads.emplace_back([producer]() {
+			for (unsigned i = 0; i < Messages; i++)
+			{
+				GEFX_LOG_INFO("producer {} message {}", producer, i);
+			}
+		});
+	}
+	for (std::thread& thread : threads) thread.join();
+
+	// Flush covers everything staged before it, exited threads included
+	gefx::Logger::Get().Flush();
+	CHECK(readLines(path).size() == Producers * Messages);
+	gefx::Logger::Get().Stop();
+
+	const std::vector<Line> lines = readLines(path);
+	CHECK(lines.size() == Producers * Messages);
+	std::map<unsigned, unsigned> next;
+	std::map<unsigned, unsigned> threadOf;
+	for (const Line& line : lines)
+	{
+		CHECK(line.producer < Producers && line.level == "INFO ");
+		CHECK(line.sequence == next[line.producer]++);
+		// One ring per thread, so one thread index per producer
+		CHECK(threadOf.emplace(line.producer, line.thread).first->second == line.thread);
+	}
+	CHECK(threadOf.size() == Producers);
+	for (const auto& a : threadOf)
+	{
+		for (const auto& b : threadOf)
+		{
+			CHECK(a.first == b.first || a.second != b.second);
+		}
+	}
+	std::remove(path.c_str());
+}
+
+int main()
+{
+#if defined(__unix__) || defined(__APPLE__)
+	testCrashFlush();
+#endif
+	testThreadsDrainInOrder();
+	return 0;
+}
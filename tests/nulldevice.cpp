@@ -0,0 +1,165 @@
+// NullDevice validation of ranges whose end doesn't fit the type of its operands: each must be reported instead
+// of wrapping around to a small value that passes
+
+#include <cstdint>
+#include <string>
+
+#include <rendering/device/commandlist.h>
+#include <rendering/device/nulldevice.h>
+
+#include "check.h"
+
+using namespace gefx;
+
+namespace
+{
+	// Smallest module NullDevice accepts: the magic number and a header
+	const uint32_t Spirv[] = {0x07230203u, 0x00010000u, 0u, 1u, 0u};
+
+	struct Scene
+	{
+		TextureHandle target;
+		PipelineHandle pipeline;
+		BufferHandle vertices;
+		BufferHandle indices;
+		BufferHandle uniforms;
+	};
+
+	Scene makeScene(NullDevice& device)
+	{
+		Scene scene;
+		TextureDesc target;
+		target.width = 64;
+		target.height = 64;
+		target.format = Format::RGBA8Unorm;
+		target.usage = TextureUsage::RenderTarget;
+		scene.target = device.CreateTexture(target);
+
+		PipelineDesc pipeline;
+		pipeline.vertexSpirv = Spirv;
+		pipeline.fragmentSpirv = Spirv;
+		pipeline.attributes[0] = VertexAttribute{0, Format::RGB32Float, 0};
+		pipeline.attributeCount = 1;
+		pipeline.vertexStride = 12;
+		pipeline.pushConstantBytes = 64;
+		scene.pipeline = device.CreatePipeline(pipeline);
+
+		scene.vertices = device.CreateBuffer(BufferDesc{12 * 3, BufferUsage::Vertex});
+		scene.indices = device.CreateBuffer(BufferDesc{4 * 3, BufferUsage::Index});
+		scene.uniforms = device.CreateBuffer(BufferDesc{256, BufferUsage::Uniform});
+		CHECK(device.GetErrorCount() == 0);
+		return scene;
+	}
+
+	void beginPass(const Scene& scene, CommandList& list)
+	{
+		RenderPassDesc pass;
+		pass.color = scene.target;
+		pass.width = 64;
+		pass.height = 64;
+		list.BeginRenderPass(pass);
+		list.BindPipeline(scene.pipeline);
+		list.BindVertexBuffer(scene.vertices);
+		list.BindIndexBuffer(scene.indices, IndexType::UInt32);
+	}
+
+	// Submits list and expects exactly one error, mentioning what
+	void expectError(NullDevice& device, CommandList& list, const char* what)
+	{
+		device.ClearErrors();
+		device.Submit(list);
+		CHECK(device.GetErrorCount() == 1);
+		CHECK(device.GetErrors()[0].find(what) != std::string::npos);
+	}
+} // namespace
+
+static void testValidListPasses(NullDevice& device, const Scene& scene)
+{
+	CommandList list;
+	const uint32_t data[4] = {};
+	list.UpdateBuffer(scene.uniforms, 240, data, sizeof(data));
+	beginPass(scene, list);
+	list.BindUniformBuffer(0, scene.uniforms, 128, 128);
+	list.PushConstants(data, sizeof(data), 48);
+	list.Draw(3);
+	list.DrawIndexed(3);
+	list.EndRenderPass();
+
+	device.ClearErrors();
+	device.Submit(list);
+	CHECK(device.GetErrorCount() == 0);
+}
+
+static void testDrawRangesDontWrap(NullDevice& device, const Scene& scene)
+{
+	// firstVertex + vertexCount is 2 in 32 bits
+	CommandList draw;
+	beginPass(scene, draw);
+	draw.Draw(3, 1, UINT32_MAX);
+	draw.EndRenderPass();
+	expectError(device, draw, "vertices past the end");
+
+	CommandList drawIndexed;
+	beginPass(scene, drawIndexed);
+	drawIndexed.DrawIndexed(3, 1, UINT32_MAX);
+	drawIndexed.EndRenderPass();
+	expectError(device, drawIndexed, "indices past the end");
+
+	// An offset that wraps the buffer end around to 0
+	CommandList offset;
+	beginPass(scene, offset);
+	offset.BindVertexBuffer(scene.vertices, UINT64_MAX - 11);
+	offset.Draw(1);
+	offset.EndRenderPass();
+	expectError(device, offset, "vertices past the end");
+}
+
+static void testBufferRangesDontWrap(NullDevice& device, const Scene& scene)
+{
+	CommandList uniform;
+	beginPass(scene, uniform);
+	uniform.BindUniformBuffer(0, scene.uniforms, UINT64_MAX - 15, 32);
+	uniform.EndRenderPass();
+	expectError(device, uniform, "range outside the buffer");
+
+	const uint32_t data[4] = {};
+	CommandList update;
+	update.UpdateBuffer(scene.uniforms, UINT64_MAX - 7, data, sizeof(data));
+	expectError(device, update, "range outside the buffer");
+}
+
+static void testPushConstantRangeDoesntWrap(NullDevice& device, const Scene& scene)
+{
+	const uint32_t data[4] = {};
+	CommandList list;
+	beginPass(scene, list);
+	list.PushConstants(data, sizeof(data), UINT32_MAX - 3);
+	list.EndRenderPass();
+	expectError(device, list, "bytes past the 64 bytes block");
+}
+
+static void testAttributeOffsetDoesntWrap(NullDevice& device)
+{
+	PipelineDesc pipeline;
+	pipeline.vertexSpirv = Spirv;
+	pipeline.fragmentSpirv = Spirv;
+	pipeline.attributes[0] = VertexAttribute{0, Format::RGB32Float, UINT32_MAX - 3};
+	pipeline.attributeCount = 1;
+	pipeline.vertexStride = 12;
+
+	device.ClearErrors();
+	CHECK(device.CreatePipeline(pipeline).IsNull());
+	CHECK(device.GetErrorCount() == 1);
+}
+
+int main()
+{
+	NullDevice device;
+	const Scene scene = makeScene(device);
+	testValidListPasses(device, scene);
+	testDrawRangesDontWrap(device, scene);
+	testBufferRangesDontWrap(device, scene);
+	testPushConstantRangeDoesntWrap(device, scene);
+	testAttributeOffsetDoesntWrap(device);
+	return 0;
+}
@@ -0,0 +1,170 @@
+// Masked occlusion culling: a quad occluder hides the box behind it but not boxes in front of it, beside it, past
+// its edge or across the near plane, with the same depth buffer on one thread and on the job system
+
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <core/jobs.h>
+#include <core/math/transform.h>
+#include <rendering/occlusion.h>
+
+#include "check.h"
+
+namespace
+{
+	constexpr uint32_t Width = 320;
+	constexpr uint32_t Height = 192;
+
+	// Camera at the origin looking down -z
+	glm::mat4 makeViewProj()
+	{
+		const glm::mat4 projection =
+			glm::perspective(glm::radians(60.0f), float(Width) / float(Height), 0.5f, 100.0f);
+		return projection * glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	}
+
+	// Unit square in the xy plane, counter clockwise seen from +z
+	const glm::vec3 QuadVertices[4] = {
+		{-1.0f, -1.0f, 0.0f}, {1.0f, -1.0f, 0.0f}, {1.0f, 1.0f, 0.0f}, {-1.0f, 1.0f, 0.0f}};
+	const uint32_t QuadIndices[6] = {0, 1, 2, 0, 2, 3};
+	const uint32_t BackQuadIndices[6] = {0, 2, 1, 0, 3, 2};
+
+	glm::mat4 quadModel(const glm::vec3& center, float halfSize)
+	{
+		return glm::scale(glm::translate(glm::mat4(1.0f), center), glm::vec3(halfSize, halfSize, 1.0f));
+	}
+
+	rv::AABB box(const glm::vec3& center, float halfSize)
+	{
+		return rv::AABB{center - glm::vec3(halfSize), center + glm::vec3(halfSize)};
+	}
+
+	struct Case
+	{
+		rv::AABB bounds;
+		bool visible;
+	};
+
+	// The occluder spans x and y in [-3, 3] at z = -10, so at z = -20 it covers [-6, 6]
+	const Case Cases[] = {
+		{box({0.0f, 0.0f, -20.0f}, 1.0f), false},	// behind it
+		{box({-3.0f, 2.5f, -30.0f}, 1.5f), false},	// behind it, off center and farther
+		{box({0.0f, 0.0f, -5.0f}, 0.5f), true},		// in front of it
+		{box({0.0f, 0.0f, -10.5f}, 1.0f), true},	// through it
+		{box({10.0f, 0.0f, -20.0f}, 1.0f), true},	// beside it
+		{box({0.0f, -12.0f, -20.0f}, 1.0f), true},	// below it
+		{box({6.0f, 0.0f, -20.0f}, 1.0f), true},	// behind its edge, half of it sticking out
+		{box({0.0f, 0.0f, 0.0f}, 1.0f), true},		// across the near plane
+	};
+} // namespace
+
+static void testQuadOccluder(gefx::JobSystem* jobs)
+{
+	gefx::OcclusionCuller culler(Width, Height);
+	culler.Begin(makeViewProj());
+	culler.AddOccluder(QuadVertices, QuadIndices, 6, quadModel({0.0f, 0.0f, -10.0f}, 3.0f));
+	culler.Rasterize(jobs);
+	CHECK(culler.GetStats().occluderTriangles == 2 && culler.GetStats().rasterizedTriangles == 2);
+
+	for (const Case& c : Cases)
+	{
+		CHECK(culler.IsVisible(c.bounds) == c.visible);
+	}
+
+	// The depth buffer holds the quad in the middle and the far plane in the corners
+	std::vector<float> depth;
+	culler.ResolveDepth(depth);
+	CHECK(depth.size() == size_t(Width) * Height);
+	CHECK(depth[(Height / 2) * Width + Width / 2] < 1.0f && depth[0] == 1.0f && depth.back() == 1.0f);
+
+	// Cull keeps the visible candidates in their order, whatever chunk they land in
+	rv::BoundsSoA bounds;
+	const uint32_t count = 3000;
+	const uint32_t caseCount = sizeof(Cases) / sizeof(Cases[0]);
+	bounds.Resize(count);
+	std::vector<uint32_t> candidates;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		bounds.Set(i, Cases[i % caseCount].bounds);
+		if (i % 3 != 1) candidates.push_back(i);
+	}
+	gefx::JobSystem localJobs(2);
+	const rv::Span<const uint32_t> visible = culler.Cull(jobs ? *jobs : localJobs, candidates, bounds);
+	size_t next = 0;
+	for (uint32_t i : candidates)
+	{
+		if (!Cases[i % caseCount].visible) continue;
+		CHECK(next < visible.size() && visible[next] == i);
+		next++;
+	}
+	CHECK(next == visible.size() && culler.GetStats().tested == candidates.size());
+	CHECK(culler.GetStats().occluded == candidates.size() - visible.size());
+}
+
+// Back faces are skipped, a quad facing away hides nothing
+static void testBackFacingOccluder()
+{
+	gefx::OcclusionCuller culler(Width, Height);
+	culler.Begin(makeViewProj());
+	culler.AddOccluder(QuadVertices, BackQuadIndices, 6, quadModel({0.0f, 0.0f, -10.0f}, 3.0f));
+	culler.Rasterize();
+	CHECK(culler.GetStats().rasterizedTriangles == 0);
+	CHECK(culler.IsVisible(Cases[0].bounds));
+}
+
+// Two quads meeting under the box only hide it together, once their coverage merges into a full tile
+static void testMergedOccluders(gefx::JobSystem* jobs)
+{
+	gefx::OcclusionCuller culler(Width, Height);
+	culler.Begin(makeViewProj());
+	culler.AddOccluder(QuadVertices, QuadIndices, 6,
+					   glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(-1.5f, 0.0f, -10.0f)),
+								  glm::vec3(1.5f, 3.0f, 1.0f)));
+	culler.Rasterize(jobs);
+	const rv::AABB behindSeam = box({0.0f, 0.0f, -20.0f}, 1.0f);
+	CHECK(culler.IsVisible(behindSeam));
+
+	culler.Begin(makeViewProj());
+	culler.AddOccluder(QuadVertices, QuadIndices, 6,
+					   glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(-1.5f, 0.0f, -10.0f)),
+								  glm::vec3(1.5f, 3.0f, 1.0f)));
+	culler.AddOccluder(QuadVertices, QuadIndices, 6,
+					   glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(1.5f, 0.0f, -10.0f)),
+								  glm::vec3(1.5f, 3.0f, 1.0f)));
+	culler.Rasterize(jobs);
+	CHECK(!culler.IsVisible(behindSeam));
+}
+
+// Bands of tile rows are filled by separate jobs, the result must not depend on it
+static void testSameDepthWithJobs(gefx::JobSystem& jobs)
+{
+	gefx::OcclusionCuller single(Width, Height);
+	gefx::OcclusionCuller parallel(Width, Height);
+	for (gefx::OcclusionCuller* culler : {&single, &parallel})
+	{
+		culler->Begin(makeViewProj());
+		for (int i = 0; i < 40; i++)
+		{
+			const glm::vec3 center(float(i % 8) * 3.0f - 10.5f, float(i / 8) * 2.5f - 5.0f, -8.0f - float(i % 5));
+			culler->AddOccluder(QuadVertices, QuadIndices, 6, quadModel(center, 1.0f + 0.1f * float(i % 4)));
+		}
+		culler->Rasterize(culler == &parallel ? &jobs : nullptr);
+	}
+	std::vector<float> a, b;
+	single.ResolveDepth(a);
+	parallel.ResolveDepth(b);
+	CHECK(a == b);
+}
+
+int main()
+{
+	gefx::JobSystem jobs(3);
+	testQuadOccluder(nullptr);
+	testQuadOccluder(&jobs);
+	testBackFacingOccluder();
+	testMergedOccluders(nullptr);
+	testMergedOccluders(&jobs);
+	testSameDepthWithJobs(jobs);
+	return 0;
+}
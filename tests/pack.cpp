@@ -0,0 +1,213 @@
+// Pack archives: a written archive reads back byte for byte, with and without jobs, through raw and compressed
+// blocks, and archives with corrupt headers, block tables or entry ranges are refused by Open
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <core/jobs.h>
+#include <core/pack.h>
+
+#include "check.h"
+
+using namespace gefx;
+
+namespace
+{
+	struct TestFile
+	{
+		std::string path;
+		std::vector<uint8_t> data;
+	};
+
+	std::string tempPath(const char* name)
+	{
+		return (std::filesystem::temp_directory_path() / name).string();
+	}
+
+	std::vector<uint8_t> readAll(const std::string& path)
+	{
+		std::ifstream in(path.c_str(), std::ios::binary);
+		return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	}
+
+	void writeAll(const std::string& path, const std::vector<uint8_t>& bytes)
+	{
+		std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+		out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+	}
+
+	// Noise first so block 0 is stored raw and serves zero-copy reads, text compresses, files span blocks
+	std::vector<TestFile> makeFiles()
+	{
+		std::mt19937 rng(11);
+		std::vector<TestFile> files;
+		files.push_back({"big/noise.bin", std::vector<uint8_t>(PackBlockSize + 4000)});
+		for (uint8_t& byte : files.back().data) byte = static_cast<uint8_t>(rng());
+		files.push_back({"small/a.txt", std::vector<uint8_t>(100, 'a')});
+		files.push_back({"empty", {}});
+		files.push_back({"big/text.txt", {}});
+		const char* words[] = {"vertex ", "fragment ", "compute ", "mesh "};
+		while (files.back().data.size() < 3 * PackBlockSize)
+		{
+			const char* word = words[rng() % 4];
+			files.back().data.insert(files.back().data.end(), word, word + strlen(word));
+		}
+		files.push_back({"small/b.txt", std::vector<uint8_t>(3000)});
+		for (size_t i = 0; i < files.back().data.size(); i++) files.back().data[i] = static_cast<uint8_t>(i * 7);
+		return files;
+	}
+
+	std::vector<uint8_t> buildArchive(const std::vector<TestFile>& files)
+	{
+		PackBuilder builder;
+		for (const TestFile& file : files) builder.AddData(file.path, file.data);
+		const std::string path = tempPath("grefixs_pack_test.gpak");
+		std::string error;
+		CHECK(builder.Write(path, nullptr, error));
+		std::vector<uint8_t> bytes = readAll(path);
+		std::remove(path.c_str());
+		return bytes;
+	}
+
+	bool opens(const std::vector<uint8_t>& bytes)
+	{
+		const std::string path = tempPath("grefixs_pack_corrupt.gpak");
+		writeAll(path, bytes);
+		const bool opened = PackArchive::Open(path) != nullptr;
+		std::remove(path.c_str());
+		return opened;
+	}
+
+	template <typename T> T& at(std::vector<uint8_t>& bytes, size_t offset)
+	{
+		return *reinterpret_cast<T*>(bytes.data() + offset);
+	}
+
+	template <typename T> const T& at(const std::vector<uint8_t>& bytes, size_t offset)
+	{
+		return *reinterpret_cast<const T*>(bytes.data() + offset);
+	}
+} // namespace
+
+static void testRoundTrip()
+{
+	const std::vector<TestFile> files = makeFiles();
+	const std::string path = tempPath("grefixs_pack_roundtrip.gpak");
+	writeAll(path, buildArchive(files));
+
+	std::shared_ptr<PackArchive> archive = PackArchive::Open(path);
+	CHECK(archive && archive->GetFileCount() == files.size());
+	JobSystem jobs(2);
+	for (const TestFile& file : files)
+	{
+		const PackEntry* entry = archive->Find(file.path);
+		CHECK(entry && archive->GetName(*entry) == file.path && entry->size == file.data.size());
+		for (JobSystem* pool : {static_cast<JobSystem*>(nullptr), &jobs})
+		{
+			const FileView view = archive->Read(*entry, pool, AccessHint::Sequential);
+			CHECK(view.IsValid() && view.Size() == file.data.size());
+			CHECK(file.data.empty() || std::memcmp(view.Data(), file.data.data(), file.data.size()) == 0);
+		}
+	}
+	CHECK(!archive->Find("small/c.txt") && !archive->Find("small"));
+
+	PackMount mount(archive, &jobs);
+	FileStat stat;
+	CHECK(mount.Stat("big/text.txt", stat) && stat.exists && stat.size == files[3].data.size());
+	CHECK(!mount.Stat("missing", stat) && !stat.exists);
+	CHECK(mount.Open("small/a.txt", AccessHint::Normal).AsString() == std::string(100, 'a'));
+	archive.reset();
+	std::remove(path.c_str());
+}
+
+static void testCorruptArchives()
+{
+	const std::vector<uint8_t> good = buildArchive(makeFiles());
+	CHECK(opens(good));
+
+	const PackHeader header = at<PackHeader>(good, 0);
+	CHECK(header.blockCount >= 4);
+	const size_t entries = sizeof(PackHeader);
+	const size_t blocks = entries + header.fileCount * sizeof(PackEntry);
+	const size_t lastBlock = blocks + (header.blockCount - 1) * sizeof(PackBlock);
+	constexpr uint64_t Huge = std::numeric_limits<uint64_t>::max() - 8;
+	uint64_t streamSize = 0;
+	for (uint32_t i = 0; i < header.blockCount; i++)
+	{
+		streamSize += at<PackBlock>(good, blocks + i * sizeof(PackBlock)).rawSize;
+	}
+
+	std::vector<uint8_t> bytes = good;
+	at<PackHeader>(bytes, 0).magic ^= 1;
+	CHECK(!opens(bytes));
+
+	// Read divides by the block size
+	bytes = good;
+	at<PackHeader>(bytes, 0).blockSize = 0;
+	CHECK(!opens(bytes));
+
+	// Would wrap the table size back under dataOffset
+	bytes = good;
+	at<PackHeader>(bytes, 0).namesSize = Huge;
+	CHECK(!opens(bytes));
+
+	bytes = good;
+	at<PackHeader>(bytes, 0).dataOffset = bytes.size() + 1;
+	CHECK(!opens(bytes));
+
+	// Cut inside the last block
+	bytes = good;
+	bytes.pop_back();
+	CHECK(!opens(bytes));
+
+	// A short interior block shifts every later stream offset
+	bytes = good;
+	at<PackBlock>(bytes, blocks).rawSize = header.blockSize - 1;
+	CHECK(!opens(bytes));
+
+	bytes = good;
+	at<PackBlock>(bytes, lastBlock).rawSize = header.blockSize + 1;
+	CHECK(!opens(bytes));
+
+	bytes = good;
+	at<PackBlock>(bytes, lastBlock).rawSize = 0;
+	CHECK(!opens(bytes));
+
+	// offset + storedSize wraps
+	bytes = good;
+	at<PackBlock>(bytes, lastBlock).offset = Huge;
+	CHECK(!opens(bytes));
+
+	// Overlapping blocks
+	bytes = good;
+	at<PackBlock>(bytes, blocks + sizeof(PackBlock)).offset = 0;
+	CHECK(!opens(bytes));
+
+	// offset + size wraps
+	bytes = good;
+	at<PackEntry>(bytes, entries).offset = 16;
+	at<PackEntry>(bytes, entries).size = Huge;
+	CHECK(!opens(bytes));
+
+	// One byte past the end of the content stream, inside the last block's slot but past its raw bytes
+	bytes = good;
+	at<PackEntry>(bytes, entries).offset = streamSize - 10;
+	at<PackEntry>(bytes, entries).size = 11;
+	CHECK(!opens(bytes));
+	at<PackEntry>(bytes, entries).size = 10;
+	CHECK(opens(bytes));
+}
+
+int main()
+{
+	testRoundTrip();
+	testCorruptArchives();
+	return 0;
+}
@@ -0,0 +1,226 @@
+// Vulkan pipeline cache files: recorded pipelines and the driver blob read back as written, and files of another
+// device or driver, damaged, truncated or of another version are refused. No Vulkan driver needed
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <rendering/device/vkpipelinecache.h>
+
+#include "check.h"
+
+using namespace gefx;
+
+namespace
+{
+	// Any words do, the file never hands them to a driver
+	const uint32_t VertexSpirv[] = {0x07230203, 0x00010000, 0x00000000, 0x00000011, 0x00000000, 0x00020011};
+	const uint32_t FragmentSpirv[] = {0x07230203, 0x00010000, 0x00000000, 0x00000013, 0x00000000};
+	const uint32_t OtherFragmentSpirv[] = {0x07230203, 0x00010000, 0x00000000, 0x00000013, 0x00000001};
+
+	std::string tempPath(const char* name)
+	{
+		return (std::filesystem::temp_directory_path() / name).string();
+	}
+
+	std::vector<uint8_t> readAll(const std::string& path)
+	{
+		std::ifstream in(path.c_str(), std::ios::binary);
+		return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	}
+
+	void writeAll(const std::string& path, const std::vector<uint8_t>& bytes)
+	{
+		std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+		out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+	}
+
+	VkPhysicalDeviceProperties makeProperties()
+	{
+		VkPhysicalDeviceProperties properties{};
+		properties.vendorID = 0x10DE;
+		properties.deviceID = 0x2204;
+		properties.driverVersion = 0x00150001;
+		for (uint32_t i = 0; i < VK_UUID_SIZE; i++) properties.pipelineCacheUUID[i] = static_cast<uint8_t>(i * 7);
+		return properties;
+	}
+
+	PipelineDesc makeDesc()
+	{
+		PipelineDesc desc;
+		desc.vertexSpirv = VertexSpirv;
+		desc.fragmentSpirv = FragmentSpirv;
+		desc.attributes[0] = VertexAttribute{0, Format::RGB32Float, 0};
+		desc.attributes[1] = VertexAttribute{2, Format::RG32Float, 12};
+		desc.attributeCount = 2;
+		desc.vertexStride = 20;
+		desc.cullMode = CullMode::Back;
+		desc.depthTest = true;
+		desc.depthWrite = true;
+		desc.pushConstantBytes = 64;
+		desc.depthFormat = Format::Depth32Float;
+		return desc;
+	}
+
+	// Three pipelines sharing shaders, one of them added twice
+	PipelineCacheFile makeFile(std::vector<PipelineDesc>& descs)
+	{
+		descs.clear();
+		descs.push_back(makeDesc());
+		descs.push_back(makeDesc());
+		descs.back().blend = BlendMode::Premultiplied;
+		descs.back().depthWrite = false;
+		descs.push_back(makeDesc());
+		descs.back().fragmentSpirv = OtherFragmentSpirv;
+		descs.back().topology = PrimitiveTopology::Lines;
+
+		PipelineCacheFile file;
+		for (const PipelineDesc& desc : descs) file.AddPipeline(desc, hashPipelineDesc(desc));
+		file.AddPipeline(descs[0], hashPipelineDesc(descs[0]));
+		file.SetData(std::vector<uint8_t>{1, 2, 3, 4, 5, 6, 7});
+		return file;
+	}
+} // namespace
+
+static void testDescIdentity()
+{
+	const PipelineDesc a = makeDesc();
+
+	// The same words somewhere else are the same pipeline
+	const std::vector<uint32_t> vertexCopy(std::begin(VertexSpirv), std::end(VertexSpirv));
+	PipelineDesc b = makeDesc();
+	b.vertexSpirv = vertexCopy;
+	CHECK(equalPipelineDesc(a, b) && hashPipelineDesc(a) == hashPipelineDesc(b));
+
+	// Attributes past the count don't matter
+	b.attributes[3] = VertexAttribute{5, Format::RGBA8Unorm, 4};
+	CHECK(equalPipelineDesc(a, b) && hashPipelineDesc(a) == hashPipelineDesc(b));
+
+	b.blend = BlendMode::Alpha;
+	CHECK(!equalPipelineDesc(a, b) && hashPipelineDesc(a) != hashPipelineDesc(b));
+	PipelineDesc c = makeDesc();
+	c.blend = BlendMode::Additive;
+	CHECK(!equalPipelineDesc(b, c) && hashPipelineDesc(b) != hashPipelineDesc(c));
+
+	c = makeDesc();
+	c.fragmentSpirv = OtherFragmentSpirv;
+	CHECK(!equalPipelineDesc(a, c) && hashPipelineDesc(a) != hashPipelineDesc(c));
+	c = makeDesc();
+	c.attributes[1].offset = 16;
+	CHECK(!equalPipelineDesc(a, c) && hashPipelineDesc(a) != hashPipelineDesc(c));
+}
+
+static void testRoundTrip()
+{
+	const std::string path = tempPath("grefixs_pipelinecache_roundtrip.bin");
+	const VkPhysicalDeviceProperties properties = makeProperties();
+	std::vector<PipelineDesc> descs;
+	const PipelineCacheFile written = makeFile(descs);
+	CHECK(written.GetPipelineCount() == 3);
+	CHECK(written.Write(path, properties));
+	CHECK(!std::filesystem::exists(path + ".tmp"));
+
+	PipelineCacheFile read;
+	CHECK(read.Read(path, properties));
+	CHECK(read.GetData() == written.GetData());
+	CHECK(read.GetPipelineCount() == 3);
+	for (uint32_t i = 0; i < read.GetPipelineCount(); i++)
+	{
+		// Hashes are recomputed from the read descriptions
+		CHECK(read.GetPipelineHash(i) == hashPipelineDesc(descs[i]));
+		CHECK(equalPipelineDesc(read.GetPipeline(i), descs[i]));
+		uint32_t index = ~0u;
+		CHECK(read.FindPipeline(hashPipelineDesc(descs[i]), index) && index == i);
+	}
+	CHECK(read.GetPipeline(1).blend == BlendMode::Premultiplied);
+	uint32_t index;
+	CHECK(!read.FindPipeline(hashPipelineDesc(PipelineDesc{}), index));
+
+	// Writing what was read gives the same file
+	const std::string again = tempPath("grefixs_pipelinecache_again.bin");
+	CHECK(read.Write(again, properties));
+	CHECK(readAll(again) == readAll(path));
+
+	// An empty file is valid too
+	PipelineCacheFile empty;
+	CHECK(empty.Write(again, properties));
+	CHECK(read.Read(again, properties) && read.GetPipelineCount() == 0 && read.GetData().empty());
+
+	std::filesystem::remove(path);
+	std::filesystem::remove(again);
+}
+
+static void testRejected()
+{
+	const std::string path = tempPath("grefixs_pipelinecache_rejected.bin");
+	const VkPhysicalDeviceProperties properties = makeProperties();
+	std::vector<PipelineDesc> descs;
+	CHECK(makeFile(descs).Write(path, properties));
+	const std::vector<uint8_t> good = readAll(path);
+
+	// Every failure leaves the contents empty, even after a good read
+	auto refused = [&](const VkPhysicalDeviceProperties& reader) {
+		PipelineCacheFile file;
+		CHECK(file.Read(path, properties));
+		const bool ok = file.Read(path, reader);
+		return !ok && file.GetPipelineCount() == 0 && file.GetData().empty();
+	};
+
+	// Another device or driver
+	VkPhysicalDeviceProperties other = properties;
+	other.pipelineCacheUUID[VK_UUID_SIZE - 1] ^= 1;
+	CHECK(refused(other));
+	other = properties;
+	other.vendorID = 0x1002;
+	CHECK(refused(other));
+	other = properties;
+	other.deviceID++;
+	CHECK(refused(other));
+	other = properties;
+	other.driverVersion++;
+	CHECK(refused(other));
+
+	// Damage to the driver blob, a shader or a pipeline record fails the checksum
+	const size_t offsets[] = {sizeof(PipelineCacheHeader) + 3, sizeof(PipelineCacheHeader) + 7 + 16,
+							  good.size() - sizeof(PipelineRecord) + 20};
+	for (size_t offset : offsets)
+	{
+		std::vector<uint8_t> damaged = good;
+		damaged[offset] ^= 0x40;
+		writeAll(path, damaged);
+		PipelineCacheFile file;
+		CHECK(!file.Read(path, properties) && file.GetPipelineCount() == 0);
+	}
+
+	// Truncated anywhere, the header included
+	for (size_t size : {size_t(0), sizeof(PipelineCacheHeader) - 1, sizeof(PipelineCacheHeader), good.size() - 1})
+	{
+		writeAll(path, std::vector<uint8_t>(good.begin(), good.begin() + size));
+		PipelineCacheFile file;
+		CHECK(!file.Read(path, properties));
+	}
+
+	// A file of the previous version, without blend state
+	std::vector<uint8_t> old = good;
+	const uint32_t oldVersion = PipelineCacheHeader::Version - 1;
+	std::memcpy(old.data() + offsetof(PipelineCacheHeader, version), &oldVersion, sizeof(oldVersion));
+	writeAll(path, old);
+	PipelineCacheFile file;
+	CHECK(!file.Read(path, properties));
+
+	// Missing
+	std::filesystem::remove(path);
+	CHECK(!file.Read(path, properties));
+}
+
+int main()
+{
+	testDescIdentity();
+	testRoundTrip();
+	testRejected();
+	return 0;
+}
@@ -0,0 +1,417 @@
+// Render graph on NullDevice: culling of passes nothing needs or a clear overwrites, execution order and
+// dependencies, planned and final barriers, transient textures aliased into shared device textures, and the
+// graphs Compile refuses
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include <core/jobs.h>
+#include <rendering/device/nulldevice.h>
+#include <rendering/rendergraph.h>
+
+#include "check.h"
+
+using namespace gefx;
+
+namespace
+{
+	constexpr uint32_t Size = 64;
+
+	const TextureDesc ColorDesc{Size, Size, 1, Format::RGBA8Unorm, TextureUsage::RenderTarget};
+	const TextureDesc HdrDesc{Size, Size, 1, Format::RGBA16Float, TextureUsage::RenderTarget};
+	const TextureDesc DepthDesc{Size, Size, 1, Format::Depth32Float, TextureUsage::DepthStencil};
+
+	RenderGraphTexture importBackBuffer(RenderGraph& graph)
+	{
+		return graph.ImportTexture("backbuffer", TextureHandle(), ColorDesc, TextureState::Undefined,
+								   TextureState::Present);
+	}
+
+	bool hasBarrier(const std::vector<RenderGraphBarrier>& barriers, RenderGraphTexture texture, TextureState before,
+					TextureState after)
+	{
+		for (const RenderGraphBarrier& barrier : barriers)
+		{
+			if (barrier.texture.index == texture.index && barrier.before == before && barrier.after == after)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Lit scene: a G-buffer and a shadow map feed lighting, post processing writes the back buffer and the UI
+	// draws over it. A debug view of the lighting output nobody reads is culled
+	struct LitScene
+	{
+		RenderGraphTexture backBuffer, history, albedo, depth, shadowMap, hdr, debug;
+		RenderGraph::PassId gbuffer, shadow, lighting, debugView, post, ui;
+	};
+
+	LitScene buildLitScene(RenderGraph& graph, std::atomic<uint32_t>* recorded = nullptr)
+	{
+		LitScene s;
+		s.backBuffer = importBackBuffer(graph);
+		s.history = graph.ImportTexture("history", TextureHandle(), ColorDesc, TextureState::ShaderRead,
+										TextureState::ShaderRead);
+		auto count = [recorded](const RenderPassContext&, CommandList&, uint32_t) {
+			if (recorded) (*recorded)++;
+		};
+
+		s.gbuffer = graph.AddPass(
+			"gbuffer",
+			[&](RenderGraphBuilder& builder) {
+				s.albedo = builder.CreateTexture("albedo", ColorDesc);
+				s.depth = builder.CreateTexture("depth", DepthDesc);
+				builder.WriteColor(s.albedo, true);
+				builder.WriteDepth(s.depth, true);
+			},
+			count);
+		s.shadow = graph.AddPass(
+			"shadow",
+			[&](RenderGraphBuilder& builder) {
+				s.shadowMap = builder.CreateTexture("shadowmap", ColorDesc);
+				builder.WriteColor(s.shadowMap, true);
+			},
+			count);
+		s.lighting = graph.AddPass(
+			"lighting",
+			[&](RenderGraphBuilder& builder) {
+				builder.Read(s.albedo);
+				builder.Read(s.shadowMap);
+				builder.Read(s.history);
+				s.hdr = builder.CreateTexture("hdr", HdrDesc);
+				builder.WriteColor(s.hdr, true);
+				builder.SetCommandLists(3);
+			},
+			count);
+		s.debugView = graph.AddPass(
+			"debug",
+			[&](RenderGraphBuilder& builder) {
+				builder.Read(s.hdr);
+				s.debug = builder.CreateTexture("debug", ColorDesc);
+				builder.WriteColor(s.debug, true);
+			},
+			count);
+		s.post = graph.AddPass(
+			"post",
+			[&](RenderGraphBuilder& builder) {
+				builder.Read(s.hdr);
+				builder.WriteColor(s.backBuffer, true);
+			},
+			count);
+		s.ui = graph.AddPass(
+			"ui", [&](RenderGraphBuilder& builder) { builder.WriteColor(s.backBuffer); }, count);
+		return s;
+	}
+} // namespace
+
+// Passes nothing reads are culled, and so are writes a later clear overwrites along with what only they needed
+static void testCulling()
+{
+	RenderGraph graph;
+	const RenderGraphTexture backBuffer = importBackBuffer(graph);
+	RenderGraphTexture feed;
+	const RenderGraph::PassId producer = graph.AddPass(
+		"producer",
+		[&](RenderGraphBuilder& builder) {
+			feed = builder.CreateTexture("feed", ColorDesc);
+			builder.WriteColor(feed, true);
+		},
+		nullptr);
+	const RenderGraph::PassId overwritten = graph.AddPass(
+		"overwritten",
+		[&](RenderGraphBuilder& builder) {
+			builder.Read(feed);
+			builder.WriteColor(backBuffer, true);
+		},
+		nullptr);
+	const RenderGraph::PassId orphan = graph.AddPass(
+		"orphan",
+		[&](RenderGraphBuilder& builder) { builder.WriteColor(builder.CreateTexture("orphan", ColorDesc), true); },
+		nullptr);
+	const RenderGraph::PassId readback = graph.AddPass(
+		"readback",
+		[&](RenderGraphBuilder& builder) {
+			builder.WriteColor(builder.CreateTexture("readback", ColorDesc), true);
+			builder.SetSideEffects();
+		},
+		nullptr);
+	const RenderGraph::PassId scene = graph.AddPass(
+		"scene", [&](RenderGraphBuilder& builder) { builder.WriteColor(backBuffer, true); }, nullptr);
+	const RenderGraph::PassId overlay = graph.AddPass(
+		"overlay", [&](RenderGraphBuilder& builder) { builder.WriteColor(backBuffer); }, nullptr);
+
+	std::string error;
+	CHECK(graph.Compile(error));
+	CHECK(graph.IsCulled(producer) && graph.IsCulled(overwritten) && graph.IsCulled(orphan));
+	// Side effects keep a pass, and a write that doesn't clear keeps the one before it
+	CHECK(!graph.IsCulled(readback) && !graph.IsCulled(scene) && !graph.IsCulled(overlay));
+	CHECK(graph.GetStats().passes == 3 && graph.GetStats().culledPasses == 3);
+	CHECK(graph.GetPhysicalIndex(feed) == RenderGraphTexture::Invalid);
+	CHECK(graph.GetExecutionOrder() == std::vector<RenderGraph::PassId>({readback, scene, overlay}));
+
+	// Clearing in the last pass instead leaves nothing for the one before it
+	graph.Reset();
+	const RenderGraphTexture target = importBackBuffer(graph);
+	const RenderGraph::PassId first =
+		graph.AddPass("first", [&](RenderGraphBuilder& builder) { builder.WriteColor(target); }, nullptr);
+	const RenderGraph::PassId last =
+		graph.AddPass("last", [&](RenderGraphBuilder& builder) { builder.WriteColor(target, true); }, nullptr);
+	CHECK(graph.Compile(error));
+	CHECK(graph.IsCulled(first) && !graph.IsCulled(last));
+}
+
+static void testOrderAndDependencies()
+{
+	RenderGraph graph;
+	const LitScene s = buildLitScene(graph);
+	std::string error;
+	CHECK(graph.Compile(error));
+
+	CHECK(graph.IsCulled(s.debugView));
+	CHECK(graph.GetExecutionOrder() ==
+		  std::vector<RenderGraph::PassId>({s.gbuffer, s.shadow, s.lighting, s.post, s.ui}));
+	CHECK(graph.GetDependencies(s.gbuffer).empty() && graph.GetDependencies(s.shadow).empty());
+	CHECK(graph.GetDependencies(s.lighting) == std::vector<RenderGraph::PassId>({s.gbuffer, s.shadow}));
+	// The clear of the back buffer depends on nothing before it, the UI drawing over it on post
+	CHECK(graph.GetDependencies(s.post) == std::vector<RenderGraph::PassId>({s.lighting}));
+	CHECK(graph.GetDependencies(s.ui) == std::vector<RenderGraph::PassId>({s.post}));
+
+	// Describe lists the live passes in order with what they wait for, then the culled ones
+	std::string text;
+	graph.Describe(text);
+	CHECK(text.find("lighting (3 lists) after gbuffer, shadow\n") != std::string::npos);
+	CHECK(text.find("culled debug\n") != std::string::npos);
+	CHECK(text.find("gbuffer") < text.find("shadow") && text.find("post") < text.find("ui"));
+}
+
+static void testBarriers()
+{
+	RenderGraph graph;
+	const LitScene s = buildLitScene(graph);
+	std::string error;
+	CHECK(graph.Compile(error));
+
+	using S = TextureState;
+	// Cleared targets discard what they held
+	CHECK(graph.GetBarriers(s.gbuffer).size() == 2);
+	CHECK(hasBarrier(graph.GetBarriers(s.gbuffer), s.albedo, S::Undefined, S::ColorAttachment));
+	CHECK(hasBarrier(graph.GetBarriers(s.gbuffer), s.depth, S::Undefined, S::DepthAttachment));
+	CHECK(graph.GetBarriers(s.shadow).size() == 1);
+	CHECK(hasBarrier(graph.GetBarriers(s.shadow), s.shadowMap, S::Undefined, S::ColorAttachment));
+	// Reads after writes; the imported history is already readable and needs none
+	const std::vector<RenderGraphBarrier>& lighting = graph.GetBarriers(s.lighting);
+	CHECK(lighting.size() == 3);
+	CHECK(hasBarrier(lighting, s.albedo, S::ColorAttachment, S::ShaderRead));
+	CHECK(hasBarrier(lighting, s.shadowMap, S::ColorAttachment, S::ShaderRead));
+	CHECK(hasBarrier(lighting, s.hdr, S::Undefined, S::ColorAttachment));
+	CHECK(graph.GetBarriers(s.post).size() == 2);
+	CHECK(hasBarrier(graph.GetBarriers(s.post), s.hdr, S::ColorAttachment, S::ShaderRead));
+	CHECK(hasBarrier(graph.GetBarriers(s.post), s.backBuffer, S::Undefined, S::ColorAttachment));
+	// A write after a write waits for it in the same state
+	CHECK(graph.GetBarriers(s.ui).size() == 1);
+	CHECK(hasBarrier(graph.GetBarriers(s.ui), s.backBuffer, S::ColorAttachment, S::ColorAttachment));
+
+	// Imported textures end in the state asked for, and only the ones whose state changed get a barrier
+	CHECK(graph.GetFinalBarriers().size() == 1);
+	CHECK(hasBarrier(graph.GetFinalBarriers(), s.backBuffer, S::ColorAttachment, S::Present));
+	CHECK(graph.GetStats().barriers == 2 + 1 + 3 + 2 + 1 + 1);
+}
+
+// Three transient textures alike, each live for two passes, fit in two device textures
+static void testAliasing(JobSystem* jobs)
+{
+	NullDevice device;
+	RenderGraph graph;
+	TextureHandle first[3];
+	for (int frame = 0; frame < 3; frame++)
+	{
+		graph.Reset();
+		const RenderGraphTexture backBuffer = importBackBuffer(graph);
+		RenderGraphTexture a, b, c, other;
+		graph.AddPass(
+			"a",
+			[&](RenderGraphBuilder& builder) {
+				a = builder.CreateTexture("a", ColorDesc);
+				builder.WriteColor(a, true);
+			},
+			nullptr);
+		graph.AddPass(
+			"b",
+			[&](RenderGraphBuilder& builder) {
+				builder.Read(a);
+				b = builder.CreateTexture("b", ColorDesc);
+				builder.WriteColor(b, true);
+			},
+			nullptr);
+		graph.AddPass(
+			"c",
+			[&](RenderGraphBuilder& builder) {
+				builder.Read(b);
+				c = builder.CreateTexture("c", ColorDesc);
+				builder.WriteColor(c, true);
+			},
+			nullptr);
+		// Free by then too, but of another format
+		graph.AddPass(
+			"other",
+			[&](RenderGraphBuilder& builder) {
+				builder.Read(c);
+				other = builder.CreateTexture("other", HdrDesc);
+				builder.WriteColor(other, true);
+			},
+			nullptr);
+		graph.AddPass(
+			"present",
+			[&](RenderGraphBuilder& builder) {
+				builder.Read(other);
+				builder.WriteColor(backBuffer, true);
+			},
+			nullptr);
+
+		std::string error;
+		CHECK(graph.Compile(error));
+		CHECK(graph.GetPhysicalIndex(a) == graph.GetPhysicalIndex(c));
+		CHECK(graph.GetPhysicalIndex(a) != graph.GetPhysicalIndex(b));
+		CHECK(graph.GetPhysicalIndex(other) != graph.GetPhysicalIndex(a));
+		CHECK(graph.GetPhysicalIndex(other) != graph.GetPhysicalIndex(b));
+		const RenderGraphStats& stats = graph.GetStats();
+		const uint64_t colorBytes = Size * Size * 4;
+		CHECK(stats.transientTextures == 4 && stats.physicalTextures == 3);
+		CHECK(stats.transientBytes == 3 * colorBytes + 2 * colorBytes);
+		CHECK(stats.physicalBytes == 2 * colorBytes + 2 * colorBytes);
+		CHECK(stats.GetSavedBytes() == colorBytes);
+
+		// The same device textures every frame
+		graph.Execute(device, jobs);
+		CHECK(graph.GetTexture(a) && graph.GetTexture(a) == graph.GetTexture(c));
+		CHECK(graph.GetTexture(b) && graph.GetTexture(b) != graph.GetTexture(a));
+		CHECK(graph.GetTexture(other) && !graph.GetTexture(backBuffer));
+		const TextureHandle handles[3] = {graph.GetTexture(a), graph.GetTexture(b), graph.GetTexture(other)};
+		for (int i = 0; i < 3; i++)
+		{
+			if (frame == 0) first[i] = handles[i];
+			CHECK(handles[i] == first[i]);
+		}
+		device.EndFrame();
+		CHECK(device.GetFrameStats().renderPasses == 5);
+	}
+	CHECK(device.GetErrorCount() == 0);
+	graph.Shutdown(device);
+	CHECK(!device.Get(first[0]) && !device.Get(first[1]) && !device.Get(first[2]));
+}
+
+// Only live passes are recorded, a pass's lists in parallel with jobs, and NullDevice accepts the result
+static void testExecute(JobSystem* jobs)
+{
+	NullDevice device;
+	RenderGraph graph;
+	std::atomic<uint32_t> recorded{0};
+	buildLitScene(graph, &recorded);
+	std::string error;
+	CHECK(graph.Compile(error));
+	graph.Execute(device, jobs);
+	CHECK(recorded == 1 + 1 + 3 + 1 + 1);
+	device.EndFrame();
+	CHECK(device.GetErrorCount() == 0);
+	CHECK(device.GetFrameStats().renderPasses == 5 && device.GetFrameStats().commandLists == 7);
+	graph.Shutdown(device);
+}
+
+static void testCompileErrors()
+{
+	RenderGraph graph;
+	std::string error;
+	RenderGraphTexture backBuffer = importBackBuffer(graph);
+
+	// Reading a transient texture nothing wrote
+	graph.AddPass(
+		"reader",
+		[&](RenderGraphBuilder& builder) {
+			builder.Read(builder.CreateTexture("unwritten", ColorDesc));
+			builder.WriteColor(backBuffer, true);
+		},
+		nullptr);
+	CHECK(!graph.Compile(error) && error.find("reader reads unwritten") != std::string::npos);
+
+	// Writing a texture the pass also reads
+	graph.Reset();
+	error.clear();
+	backBuffer = importBackBuffer(graph);
+	RenderGraphTexture feedback;
+	graph.AddPass(
+		"producer",
+		[&](RenderGraphBuilder& builder) {
+			feedback = builder.CreateTexture("feedback", ColorDesc);
+			builder.WriteColor(feedback, true);
+		},
+		nullptr);
+	graph.AddPass(
+		"loop",
+		[&](RenderGraphBuilder& builder) {
+			builder.Read(feedback);
+			builder.WriteColor(feedback);
+			builder.SetSideEffects();
+		},
+		nullptr);
+	CHECK(!graph.Compile(error) && error.find("loop uses feedback more than once") != std::string::npos);
+
+	// Attachments of different sizes, and depth without color
+	graph.Reset();
+	error.clear();
+	backBuffer = importBackBuffer(graph);
+	graph.AddPass(
+		"mismatch",
+		[&](RenderGraphBuilder& builder) {
+			builder.WriteColor(backBuffer, true);
+			builder.WriteDepth(builder.CreateTexture("small depth", TextureDesc{Size / 2, Size / 2, 1,
+																				 Format::Depth32Float,
+																				 TextureUsage::DepthStencil}),
+							   true);
+		},
+		nullptr);
+	CHECK(!graph.Compile(error) && error.find("mismatch has attachments of different sizes") != std::string::npos);
+
+	graph.Reset();
+	error.clear();
+	graph.AddPass(
+		"depth only",
+		[&](RenderGraphBuilder& builder) {
+			builder.WriteDepth(builder.CreateTexture("depth", DepthDesc), true);
+			builder.SetSideEffects();
+		},
+		nullptr);
+	CHECK(!graph.Compile(error) && error.find("depth only needs one color attachment") != std::string::npos);
+
+	// Culled passes aren't checked
+	graph.Reset();
+	error.clear();
+	backBuffer = importBackBuffer(graph);
+	graph.AddPass(
+		"unused reader",
+		[&](RenderGraphBuilder& builder) {
+			builder.Read(builder.CreateTexture("unwritten", ColorDesc));
+			builder.WriteColor(builder.CreateTexture("unused", ColorDesc), true);
+		},
+		nullptr);
+	graph.AddPass(
+		"present", [&](RenderGraphBuilder& builder) { builder.WriteColor(backBuffer, true); }, nullptr);
+	CHECK(graph.Compile(error) && error.empty());
+}
+
+int main()
+{
+	testCulling();
+	testOrderAndDependencies();
+	testBarriers();
+	testAliasing(nullptr);
+	testExecute(nullptr);
+	testCompileErrors();
+
+	JobSystem jobs(3);
+	testAliasing(&jobs);
+	testExecute(&jobs);
+	return 0;
+}
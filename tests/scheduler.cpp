@@ -0,0 +1,157 @@
+// System graph ordering, main thread systems woken from workers, Run sleeping instead of spinning while workers
+// are busy, and invalid graphs (cycles, unknown systems) refusing to run
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <time.h>
+#endif
+
+#include <core/ecs/scheduler.h>
+#include <core/jobs.h>
+
+#include "check.h"
+
+struct Position
+{
+	float x;
+};
+
+struct Velocity
+{
+	float x;
+};
+
+static void testConflictsKeepRegistrationOrder(gefx::JobSystem& jobs)
+{
+	gefx::SystemScheduler scheduler;
+	std::vector<int> ran;
+	scheduler.AddSystem("Integrate", gefx::SystemAccess{}.Read<Velocity>().Write<Position>(),
+						[&](const gefx::SystemContext&) { ran.push_back(0); });
+	scheduler.AddSystem("Render", gefx::SystemAccess{}.Read<Position>(),
+						[&](const gefx::SystemContext&) { ran.push_back(1); });
+	scheduler.AddSystem("Input", gefx::SystemAccess{}.Write<Velocity>(),
+						[&](const gefx::SystemContext&) { ran.push_back(2); });
+
+	std::string error;
+	CHECK(scheduler.Build(error));
+	CHECK(scheduler.GetConflicts().size() == 2);
+	for (int frame = 0; frame < 100; frame++)
+	{
+		ran.clear();
+		scheduler.Run(jobs, 0.016);
+		CHECK(ran.size() == 3);
+		// Integrate writes what Render reads and reads what Input writes, both after it
+		CHECK(ran[0] == 0);
+	}
+}
+
+static void testCycleDoesNotRun(gefx::JobSystem& jobs)
+{
+	gefx::SystemScheduler scheduler;
+	std::atomic<int> ran{0};
+	const auto a = scheduler.AddSystem("A", {}, [&](const gefx::SystemContext&) { ran++; });
+	const auto b = scheduler.AddSystem("B", {}, [&](const gefx::SystemContext&) { ran++; });
+	scheduler.AddDependency(a, b);
+	scheduler.AddDependency(b, a);
+
+	std::string error;
+	CHECK(!scheduler.Build(error));
+	CHECK(error.find("'A'") != std::string::npos && error.find("'B'") != std::string::npos);
+	scheduler.Run(jobs, 0.016);
+	scheduler.RunSerial(jobs, 0.016);
+	CHECK(ran.load() == 0);
+}
+
+// Worker and main thread systems alternate down a chain, each hand-off to the main thread has to wake Run
+static void testMainThreadHandOff(gefx::JobSystem& jobs)
+{
+	gefx::SystemScheduler scheduler;
+	std::vector<int> ran;
+	std::mutex ranMutex;
+	const std::thread::id mainThread = std::this_thread::get_id();
+	gefx::SystemScheduler::SystemId previous = ~0u;
+	for (int i = 0; i < 6; i++)
+	{
+		const bool onMain = i % 2 == 1;
+		const gefx::SystemScheduler::SystemId id = scheduler.AddSystem(
+			"Step", {},
+			[&, i, onMain](const gefx::SystemContext&) {
+				CHECK(!onMain || std::this_thread::get_id() == mainThread);
+				std::lock_guard<std::mutex> lock(ranMutex);
+				ran.push_back(i);
+			},
+			onMain);
+		if (previous != ~0u) scheduler.AddDependency(previous, id);
+		previous = id;
+	}
+
+	for (int frame = 0; frame < 500; frame++)
+	{
+		ran.clear();
+		scheduler.Run(jobs, 0.016);
+		CHECK((ran == std::vector<int>{0, 1, 2, 3, 4, 5}));
+	}
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+static double threadCpuMs()
+{
+	timespec time;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+	return time.tv_sec * 1e3 + time.tv_nsec / 1e6;
+}
+
+// While a worker system sleeps the calling thread has nothing to do and must not burn its time slice
+static void testRunSleepsWhileWaiting(gefx::JobSystem& jobs)
+{
+	gefx::SystemScheduler scheduler;
+	scheduler.AddSystem("Slow", {}, [](const gefx::SystemContext&) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	});
+
+	const double before = threadCpuMs();
+	for (int frame = 0; frame < 4; frame++)
+	{
+		scheduler.Run(jobs, 0.016);
+	}
+	CHECK(threadCpuMs() - before < 40.0);
+}
+#endif
+
+#ifdef NDEBUG
+// Debug builds assert on the bad dependency right away
+static void testUnknownDependencyDoesNotRun(gefx::JobSystem& jobs)
+{
+	gefx::SystemScheduler scheduler;
+	std::atomic<int> ran{0};
+	const auto a = scheduler.AddSystem("A", {}, [&](const gefx::SystemContext&) { ran++; });
+	scheduler.AddDependency(a, a + 5);
+
+	scheduler.Run(jobs, 0.016);
+	CHECK(ran.load() == 0);
+	std::string error;
+	CHECK(!scheduler.Build(error));
+	CHECK(error.find("0 -> 5") != std::string::npos);
+}
+#endif
+
+int main()
+{
+	gefx::JobSystem jobs(2);
+	testConflictsKeepRegistrationOrder(jobs);
+	testCycleDoesNotRun(jobs);
+	testMainThreadHandOff(jobs);
+#if defined(__unix__) || defined(__APPLE__)
+	testRunSleepsWhileWaiting(jobs);
+#endif
+#ifdef NDEBUG
+	testUnknownDependencyDoesNotRun(jobs);
+#endif
+	return 0;
+}
@@ -0,0 +1,241 @@
+// Software rasterizer fill rule: triangles sharing edges cover every pixel of their union exactly once, pixel
+// centers on an edge belonging to its top or left side, across 64 pixel tiles and with or without the job system
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include <core/jobs.h>
+#include <rendering/softrasterizer.h>
+
+#include "check.h"
+
+namespace
+{
+	constexpr uint32_t Size = 256;
+	// Vertices sit on the 1/16 pixel snapping grid, so edge functions are exact in integers of it
+	constexpr int64_t Steps = 16;
+
+	struct Triangle
+	{
+		glm::vec2 p[3];
+	};
+
+	struct Uniforms
+	{
+		uint32_t id;
+	};
+
+	glm::vec4 vertexShader(const void*, const void* vertex, float*)
+	{
+		const glm::vec2 p = *static_cast<const glm::vec2*>(vertex);
+		return glm::vec4(p / float(Size) * 2.0f - 1.0f, 0.0f, 1.0f);
+	}
+
+	// The triangle id in red and green, it packs back to the same 8 bit values
+	glm::vec4 fragmentShader(const void* uniforms, const float*)
+	{
+		const uint32_t id = static_cast<const Uniforms*>(uniforms)->id;
+		return glm::vec4(float(id & 0xFF) / 255.0f, float(id >> 8) / 255.0f, 0.0f, 1.0f);
+	}
+
+	uint32_t idOf(uint32_t color)
+	{
+		return (color & 0xFF) | ((color >> 8) & 0xFF) << 8;
+	}
+
+	glm::vec2 snap(const glm::vec2& p)
+	{
+		return glm::round(p * float(Steps)) / float(Steps);
+	}
+
+	// Scalar reference: a pixel center on an edge belongs to the triangle when the edge is a left edge (inward
+	// normal towards +x) or a top one (horizontal, inward normal towards -y, rows go up)
+	bool covers(const Triangle& triangle, uint32_t x, uint32_t y)
+	{
+		int64_t v[3][2];
+		for (int i = 0; i < 3; i++)
+		{
+			v[i][0] = static_cast<int64_t>(std::lround(triangle.p[i].x * Steps));
+			v[i][1] = static_cast<int64_t>(std::lround(triangle.p[i].y * Steps));
+		}
+		const int64_t area = (v[1][0] - v[0][0]) * (v[2][1] - v[0][1]) - (v[2][0] - v[0][0]) * (v[1][1] - v[0][1]);
+		const int64_t orientation = area > 0 ? 1 : -1;
+		const int64_t px = int64_t(x) * Steps + Steps / 2;
+		const int64_t py = int64_t(y) * Steps + Steps / 2;
+		for (int e = 0; e < 3; e++)
+		{
+			const int64_t* a = v[e];
+			const int64_t* b = v[(e + 1) % 3];
+			// Positive inside
+			const int64_t nx = (a[1] - b[1]) * orientation;
+			const int64_t ny = (b[0] - a[0]) * orientation;
+			const int64_t f = nx * (px - a[0]) + ny * (py - a[1]);
+			const bool owned = nx > 0 || (nx == 0 && ny < 0);
+			if (f < 0 || (f == 0 && !owned)) return false;
+		}
+		return true;
+	}
+
+	// Fan around a point off the tile corners, half of the rim vertices on pixel centers
+	std::vector<Triangle> makeFan()
+	{
+		const glm::vec2 center(128.5f, 124.5f);
+		std::vector<glm::vec2> rim;
+		for (int i = 0; i < 24; i++)
+		{
+			const float angle = float(i) * 6.2831853f / 24.0f;
+			const float radius = i % 3 == 0 ? 100.0f : 70.0f + float(i);
+			glm::vec2 p = center + radius * glm::vec2(std::cos(angle), std::sin(angle));
+			if (i % 2 == 0) p = glm::floor(p) + 0.5f;
+			rim.push_back(snap(p));
+		}
+		std::vector<Triangle> triangles;
+		for (size_t i = 0; i < rim.size(); i++)
+		{
+			// Alternate the winding, culling is off
+			const glm::vec2& a = rim[i];
+			const glm::vec2& b = rim[(i + 1) % rim.size()];
+			triangles.push_back(i % 2 ? Triangle{{center, a, b}} : Triangle{{center, b, a}});
+		}
+		return triangles;
+	}
+
+	// 10x10 cells of 24 pixels between pixel centers, crossing every tile border, split along alternating
+	// diagonals. The union is exactly 240x240 pixels
+	std::vector<Triangle> makeGrid()
+	{
+		std::vector<Triangle> triangles;
+		for (int cy = 0; cy < 10; cy++)
+		{
+			for (int cx = 0; cx < 10; cx++)
+			{
+				const glm::vec2 p00(10.5f + 24.0f * cx, 7.5f + 24.0f * cy);
+				const glm::vec2 p10 = p00 + glm::vec2(24.0f, 0.0f);
+				const glm::vec2 p01 = p00 + glm::vec2(0.0f, 24.0f);
+				const glm::vec2 p11 = p00 + glm::vec2(24.0f, 24.0f);
+				if ((cx + cy) % 2)
+				{
+					triangles.push_back(Triangle{{p00, p10, p11}});
+					triangles.push_back(Triangle{{p00, p01, p11}});
+				}
+				else
+				{
+					triangles.push_back(Triangle{{p10, p00, p01}});
+					triangles.push_back(Triangle{{p10, p11, p01}});
+				}
+			}
+		}
+		return triangles;
+	}
+
+	const gefx::SoftwarePipeline& pipeline()
+	{
+		static gefx::SoftwarePipeline pipeline = [] {
+			gefx::SoftwarePipeline p;
+			p.vertex = vertexShader;
+			p.fragment = fragmentShader;
+			p.cullMode = gefx::CullMode::None;
+			p.depthTest = false;
+			p.depthWrite = false;
+			return p;
+		}();
+		return pipeline;
+	}
+
+	// Every triangle alone must match the reference, and together they may not overlap
+	std::vector<uint32_t> checkTriangles(const std::vector<Triangle>& triangles, gefx::JobSystem* jobs)
+	{
+		gefx::SoftwareRasterizer rasterizer(Size, Size);
+		std::vector<uint32_t> owner(Size * Size, 0);
+		std::vector<uint32_t> pixels;
+		for (uint32_t t = 0; t < triangles.size(); t++)
+		{
+			const Uniforms uniforms{t + 1};
+			rasterizer.Clear(glm::vec4(0.0f));
+			rasterizer.Draw(pipeline(), &uniforms, sizeof(uniforms), triangles[t].p, sizeof(glm::vec2), 3);
+			rasterizer.Flush(jobs);
+			rasterizer.ResolveColor(pixels);
+
+			uint64_t expected = 0;
+			for (uint32_t y = 0; y < Size; y++)
+			{
+				for (uint32_t x = 0; x < Size; x++)
+				{
+					const bool written = idOf(pixels[y * Size + x]) == t + 1;
+					CHECK(written == covers(triangles[t], x, y));
+					if (!written) continue;
+					// Drawn by two triangles
+					CHECK(owner[y * Size + x] == 0);
+					owner[y * Size + x] = t + 1;
+					expected++;
+				}
+			}
+			CHECK(rasterizer.GetStats().fragments == expected);
+		}
+
+		// All at once, one draw per triangle: same pixels, each one shaded once
+		rasterizer.Clear(glm::vec4(0.0f));
+		std::vector<Uniforms> uniforms(triangles.size());
+		uint64_t covered = 0;
+		for (uint32_t t = 0; t < triangles.size(); t++)
+		{
+			uniforms[t].id = t + 1;
+			rasterizer.Draw(pipeline(), &uniforms[t], sizeof(Uniforms), triangles[t].p, sizeof(glm::vec2), 3);
+		}
+		rasterizer.Flush(jobs);
+		rasterizer.ResolveColor(pixels);
+		for (uint32_t i = 0; i < Size * Size; i++)
+		{
+			CHECK(idOf(pixels[i]) == owner[i]);
+			covered += owner[i] != 0;
+		}
+		CHECK(rasterizer.GetStats().fragments == covered);
+		return owner;
+	}
+} // namespace
+
+static void testFan(gefx::JobSystem* jobs)
+{
+	const std::vector<Triangle> fan = makeFan();
+	const std::vector<uint32_t> owner = checkTriangles(fan, jobs);
+
+	// No holes: every pixel inside the rim polygon is owned by some triangle
+	const glm::vec2 center(128.5f, 124.5f);
+	for (uint32_t y = 0; y < Size; y++)
+	{
+		for (uint32_t x = 0; x < Size; x++)
+		{
+			const glm::vec2 p(float(x) + 0.5f, float(y) + 0.5f);
+			if (glm::length(p - center) < 60.0f) CHECK(owner[y * Size + x] != 0);
+		}
+	}
+}
+
+static void testGrid(gefx::JobSystem* jobs)
+{
+	const std::vector<uint32_t> owner = checkTriangles(makeGrid(), jobs);
+
+	// Pixel centers on the left and top sides of the outline are in, on the right and bottom ones out
+	uint32_t covered = 0;
+	for (uint32_t y = 0; y < Size; y++)
+	{
+		for (uint32_t x = 0; x < Size; x++)
+		{
+			const bool inside = x >= 10 && x < 250 && y > 7 && y <= 247;
+			CHECK((owner[y * Size + x] != 0) == inside);
+			covered += owner[y * Size + x] != 0;
+		}
+	}
+	CHECK(covered == 240 * 240);
+}
+
+int main()
+{
+	testFan(nullptr);
+	testGrid(nullptr);
+	gefx::JobSystem jobs(3);
+	testFan(&jobs);
+	testGrid(&jobs);
+	return 0;
+}
@@ -0,0 +1,114 @@
+// StringId hashing and reverse lookup of literal and runtime strings, char buffers holding a NUL, and the
+// collision assert of debug builds
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <csignal>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include <core/stringid.h>
+
+#include "check.h"
+
+using namespace rv::literals;
+
+static void testLiteralAndRuntimeMatch()
+{
+	const std::string runtime = std::string("Trans") + "form";
+	const rv::StringId fromLiteral("Transform");
+	const rv::StringId fromRuntime{std::string_view(runtime)};
+	CHECK(fromLiteral == fromRuntime);
+	CHECK(fromLiteral == "Transform"_sid);
+	CHECK(fromLiteral != rv::StringId("Transforms"));
+	CHECK(rv::StringId().IsEmpty() && rv::StringId("").IsEmpty());
+}
+
+static void testReverseLookup()
+{
+#if RV_STRINGID_DEBUG
+	CHECK(std::strcmp(rv::StringId{std::string_view("RuntimeOnly")}.c_str(), "RuntimeOnly") == 0);
+#if RV_STRINGID_INTERN_LITERALS
+	// Never seen as a runtime string, the literal constructor interns it
+	CHECK(std::strcmp(rv::StringId("LiteralOnly").c_str(), "LiteralOnly") == 0);
+	CHECK(std::strcmp("SuffixOnly"_sid.c_str(), "SuffixOnly") == 0);
+#endif
+	// Built in a constant expression, nothing could intern it
+	constexpr rv::StringId compileTimeOnly("CompileTimeOnly");
+	CHECK(std::strcmp(compileTimeOnly.c_str(), "<unknown>") == 0);
+#else
+	CHECK(std::strcmp(rv::StringId("Release").c_str(), "<unknown>") == 0);
+#endif
+}
+
+static void testCharArrayStopsAtNul()
+{
+	char buffer[32] = {};
+	std::strcpy(buffer, "Mesh");
+	const rv::StringId fromBuffer(buffer);
+	CHECK(fromBuffer == rv::StringId("Mesh"));
+	CHECK(fromBuffer.GetHash() == rv::crc32_view("Mesh"));
+
+	const char embedded[] = "Mesh\0Renderer";
+	CHECK(rv::StringId(embedded) == rv::StringId("Mesh"));
+#if RV_STRINGID_INTERN_LITERALS
+	CHECK(std::strcmp(rv::StringId(embedded).c_str(), "Mesh") == 0);
+#endif
+}
+
+#if RV_STRINGID_DEBUG && !defined(NDEBUG) && (defined(__unix__) || defined(__APPLE__))
+// Birthday search for two strings with the same crc32, then the second must assert in a child process. CRC is
+// linear, strings differing in 32 bits or less never collide: the names differ in 64 pseudo-random bits
+static void testCollisionAsserts()
+{
+	auto name = [](uint64_t i) {
+		char text[32];
+		std::snprintf(text, sizeof(text), "collision%016llx",
+					  static_cast<unsigned long long>(i * 0x9e3779b97f4a7c15ull));
+		return std::string(text);
+	};
+	std::unordered_map<uint32_t, uint64_t> seen;
+	std::string first, second;
+	for (uint64_t i = 0; i < 1000000 && first.empty(); i++)
+	{
+		const std::string candidate = name(i);
+		const auto [it, inserted] = seen.try_emplace(rv::crc32_view(candidate), i);
+		if (!inserted)
+		{
+			first = name(it->second);
+			second = candidate;
+		}
+	}
+	CHECK(!first.empty());
+	CHECK(rv::crc32_view(first) == rv::crc32_view(second));
+
+	const pid_t child = fork();
+	CHECK(child >= 0);
+	if (child == 0)
+	{
+		std::freopen("/dev/null", "w", stderr);
+		rv::StringId{std::string_view(first)};
+		rv::StringId{std::string_view(second)};
+		_exit(0);
+	}
+	int status = 0;
+	CHECK(waitpid(child, &status, 0) == child);
+	CHECK(WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT);
+}
+#endif
+
+int main()
+{
+	testLiteralAndRuntimeMatch();
+	testReverseLookup();
+	testCharArrayStopsAtNul();
+#if RV_STRINGID_DEBUG && !defined(NDEBUG) && (defined(__unix__) || defined(__APPLE__))
+	testCollisionAsserts();
+#endif
+	return 0;
+}
@@ -0,0 +1,126 @@
+// Tokenizer and path helpers: empty tokens, leading and trailing separators, SIMD scans across chunk boundaries,
+// both path separator styles and every getFileFolderPath overload, literals included
+
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <core/tokenizer.h>
+#include <core/utils.h>
+
+#include "check.h"
+
+namespace
+{
+	std::vector<std::string_view> tokens(std::string_view str, std::string_view delim, bool skipEmpty = false)
+	{
+		std::vector<std::string_view> out;
+		for (std::string_view token : rv::tokenize(str, delim, skipEmpty))
+		{
+			out.push_back(token);
+		}
+		return out;
+	}
+
+	bool same(const std::vector<std::string_view>& a, std::initializer_list<std::string_view> b)
+	{
+		return a == std::vector<std::string_view>(b);
+	}
+} // namespace
+
+static void testFind()
+{
+	// Every position of a 40 byte string, so matches land in the SIMD chunks and in the scalar tail
+	std::string text(40, '.');
+	for (size_t i = 0; i < text.size(); i++)
+	{
+		text[i] = 'x';
+		CHECK(rv::findChar(text, 'x') == i);
+		CHECK(rv::findChar(text, 'x', i + 1) == std::string_view::npos);
+		text[i] = '.';
+	}
+	CHECK(rv::findChar("", 'x') == std::string_view::npos);
+
+	CHECK(rv::findDelim("a::b", "::") == 1);
+	CHECK(rv::findDelim("a:b::c", "::") == 3);
+	// Only the first character of the delimiter fits at the end
+	CHECK(rv::findDelim("abc:", "::") == std::string_view::npos);
+}
+
+static void testEmptyTokens()
+{
+	CHECK(same(tokens("a,,b", ","), {"a", "", "b"}));
+	CHECK(same(tokens(",a", ","), {"", "a"}));
+	CHECK(same(tokens(",,", ","), {"", ""}));
+	CHECK(same(tokens("a,,b", ",", true), {"a", "b"}));
+	CHECK(same(tokens(",,", ",", true), {}));
+	CHECK(same(tokens("", ","), {}));
+	// No delimiter to split on
+	CHECK(same(tokens("abc", ""), {}));
+}
+
+static void testTrailingSeparators()
+{
+	// A trailing delimiter ends the last token, it doesn't start an empty one
+	CHECK(same(tokens("a,b,", ","), {"a", "b"}));
+	CHECK(same(tokens("a::b::", "::"), {"a", "b"}));
+	CHECK(same(tokens("a,b,,", ","), {"a", "b", ""}));
+	CHECK(rv::tokenize("a,b,", ",").Count() == 2);
+
+	std::string_view collected[2];
+	CHECK(rv::tokenize("x y z", " ").Collect(collected, 2) == 2);
+	CHECK(collected[0] == "x" && collected[1] == "y");
+
+	const std::vector<std::string> split = rv::splitStr("one two  three ", " ");
+	CHECK((split == std::vector<std::string>{"one", "two", "", "three"}));
+}
+
+static void testPathSeparators()
+{
+	for (const char* path : {"assets/models/ship.obj", "assets\\models\\ship.obj", "assets/models\\ship.obj"})
+	{
+		std::string_view name, ext;
+		const std::string_view folder = rv::splitFilename(std::string_view(path), name, ext);
+		CHECK(folder.size() == 14 && folder.substr(0, 13) == std::string_view(path).substr(0, 13));
+		CHECK(name == "ship" && ext == ".obj");
+		CHECK(rv::getFileFolderPath(std::string_view(path)) == folder);
+	}
+
+	std::string_view name, ext;
+	CHECK(rv::splitFilename(std::string_view("ship.tar.gz"), name, ext).empty());
+	CHECK(name == "ship.tar" && ext == ".gz");
+	CHECK(rv::splitFilename(std::string_view("models/README"), name, ext) == "models/");
+	CHECK(name == "README" && ext.empty());
+	// A trailing separator names a folder, the file name is empty
+	CHECK(rv::splitFilename(std::string_view("models\\"), name) == "models\\" && name.empty());
+	CHECK(rv::getFileFolderPath(std::string_view("ship.obj")).empty());
+
+	std::string owningName, owningExt;
+	CHECK(rv::splitFilename(std::string("a\\b/c.txt"), owningName, owningExt) == "a\\b/");
+	CHECK(owningName == "c" && owningExt == ".txt");
+}
+
+static void testFolderPathOverloads()
+{
+	// Literals and std::string get an owning string back, views get a view
+	static_assert(std::is_same_v<decltype(rv::getFileFolderPath("a/b.txt")), std::string>);
+	static_assert(std::is_same_v<decltype(rv::getFileFolderPath(std::string())), std::string>);
+	static_assert(std::is_same_v<decltype(rv::getFileFolderPath(std::string_view())), std::string_view>);
+
+	CHECK(rv::getFileFolderPath("a/b.txt") == "a/");
+	CHECK(rv::getFileFolderPath("a\\b\\") == "a\\b\\");
+	CHECK(rv::getFileFolderPath(std::string("dir/sub/file")) == "dir/sub/");
+	const char* pointer = "x/y";
+	CHECK(rv::getFileFolderPath(pointer) == "x/");
+}
+
+int main()
+{
+	testFind();
+	testEmptyTokens();
+	testTrailingSeparators();
+	testPathSeparators();
+	testFolderPathOverloads();
+	return 0;
+}
@@ -0,0 +1,160 @@
+// Batch transform kernels against plain glm. Built once with the default SSE path and once with AVX2 and FMA,
+// counts are picked so every kernel also runs its scalar tail
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <core/math/simd.h>
+#include <core/math/transform.h>
+
+#include "check.h"
+
+namespace
+{
+	constexpr size_t Count = 1003;
+	constexpr float Tolerance = 1e-4f;
+
+	struct Scene
+	{
+		rv::TransformSoA transforms;
+		std::vector<glm::mat4> reference;
+		// The single transform overload, which the batch kernels must agree with too
+		std::vector<glm::mat4> single;
+	};
+
+	Scene makeScene()
+	{
+		Scene scene;
+		std::mt19937 rng(3);
+		std::uniform_real_distribution<float> range(-3.0f, 3.0f);
+		scene.transforms.Resize(Count);
+		for (size_t i = 0; i < Count; i++)
+		{
+			const glm::vec3 position(range(rng), range(rng), range(rng));
+			const glm::quat rotation = glm::normalize(glm::quat(range(rng), range(rng), range(rng), range(rng)));
+			const glm::vec3 scale(range(rng), range(rng), range(rng));
+			scene.transforms.Set(i, position, rotation, scale);
+			scene.reference.push_back(glm::translate(glm::mat4(1.0f), position) * glm::mat4_cast(rotation) *
+									  glm::scale(glm::mat4(1.0f), scale));
+			scene.single.push_back(rv::composeTRS(position, rotation, scale));
+		}
+		return scene;
+	}
+
+	float maxDifference(const glm::mat4& a, const glm::mat4& b)
+	{
+		float difference = 0.0f;
+		for (int col = 0; col < 4; col++)
+		{
+			for (int row = 0; row < 4; row++)
+			{
+				difference = std::max(difference, std::fabs(a[col][row] - b[col][row]));
+			}
+		}
+		return difference;
+	}
+
+	glm::mat4 viewProjection()
+	{
+		return glm::perspective(1.0f, 1.3f, 0.1f, 100.0f) *
+			   glm::lookAt(glm::vec3(0.0f, 0.0f, 5.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	}
+} // namespace
+
+static void testComposeTRS(const Scene& scene)
+{
+	std::vector<glm::mat4> matrices(Count, glm::mat4(0.0f));
+	rv::composeTRS(scene.transforms, 0, Count, matrices.data());
+	for (size_t i = 0; i < Count; i++)
+	{
+		CHECK(maxDifference(matrices[i], scene.reference[i]) < Tolerance);
+		CHECK(maxDifference(matrices[i], scene.single[i]) < Tolerance);
+	}
+
+	// A range starting off the vector width leaves everything outside it alone
+	const glm::mat4 untouched(7.0f);
+	std::fill(matrices.begin(), matrices.end(), untouched);
+	rv::composeTRS(scene.transforms, 3, Count - 2, matrices.data());
+	for (size_t i = 0; i < Count; i++)
+	{
+		const bool inRange = i >= 3 && i < Count - 2;
+		CHECK(maxDifference(matrices[i], inRange ? scene.reference[i] : untouched) < Tolerance);
+	}
+}
+
+static void testMultiplyMatrices(const Scene& scene)
+{
+	const glm::mat4 lhs = viewProjection();
+	std::vector<glm::mat4> products(Count);
+	rv::multiplyMatrices(lhs, scene.reference.data(), Count, products.data());
+	for (size_t i = 0; i < Count; i++)
+	{
+		CHECK(maxDifference(products[i], lhs * scene.reference[i]) < Tolerance);
+	}
+
+	// In place, every rhs is read before its result is stored over it
+	std::vector<glm::mat4> inPlace = scene.reference;
+	rv::multiplyMatrices(lhs, inPlace.data(), Count, inPlace.data());
+	for (size_t i = 0; i < Count; i++)
+	{
+		CHECK(maxDifference(inPlace[i], products[i]) < Tolerance);
+	}
+}
+
+static void testWorldBounds(const Scene& scene)
+{
+	const rv::AABB box{{-1.0f, -2.0f, -0.5f}, {2.0f, 1.0f, 0.5f}};
+	rv::BoundsSoA world;
+	world.Resize(Count);
+	rv::computeWorldBounds(scene.transforms, box, 0, Count, world);
+
+	rv::BoundsSoA local;
+	local.Resize(Count);
+	for (size_t i = 0; i < Count; i++)
+	{
+		local.Set(i, box);
+	}
+	rv::BoundsSoA transformed;
+	transformed.Resize(Count);
+
+	for (size_t i = 0; i < Count; i++)
+	{
+		// Reference: the box around the 8 transformed corners
+		glm::vec3 min(1e30f), max(-1e30f);
+		for (int corner = 0; corner < 8; corner++)
+		{
+			const glm::vec3 point((corner & 1) ? box.max.x : box.min.x, (corner & 2) ? box.max.y : box.min.y,
+								  (corner & 4) ? box.max.z : box.min.z);
+			const glm::vec3 moved = glm::vec3(scene.reference[i] * glm::vec4(point, 1.0f));
+			min = glm::min(min, moved);
+			max = glm::max(max, moved);
+		}
+
+		const rv::AABB computed = world.Get(i);
+		CHECK(glm::length(computed.min - min) < Tolerance && glm::length(computed.max - max) < Tolerance);
+
+		rv::transformBounds(scene.reference[i], local, i, i + 1, transformed);
+		const rv::AABB arvo = transformed.Get(i);
+		CHECK(glm::length(arvo.min - min) < Tolerance && glm::length(arvo.max - max) < Tolerance);
+	}
+}
+
+int main()
+{
+#if RV_SIMD_AVX2 && defined(__GNUC__)
+	if (!__builtin_cpu_supports("avx2") || !__builtin_cpu_supports("fma"))
+	{
+		std::printf("AVX2/FMA not supported here, skipped\n");
+		return 77;
+	}
+#endif
+	const Scene scene = makeScene();
+	testComposeTRS(scene);
+	testMultiplyMatrices(scene);
+	testWorldBounds(scene);
+	return 0;
+}
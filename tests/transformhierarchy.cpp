@@ -0,0 +1,227 @@
+// Transform hierarchy world matrices against a recursive glm reference after rounds of mixed local changes,
+// reparenting, creation and subtree destruction, updated on one thread and on the job system
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <core/jobs.h>
+#include <core/scene/transformhierarchy.h>
+
+#include "check.h"
+
+using namespace gefx;
+
+namespace
+{
+	struct MirrorNode
+	{
+		TransformNode handle;
+		int parent;
+		glm::vec3 position;
+		glm::quat rotation;
+		glm::vec3 scale;
+		bool alive;
+	};
+
+	class Mirror
+	{
+	  public:
+		explicit Mirror(uint32_t seed) : _rng(seed){};
+
+		int Create(TransformHierarchy& hierarchy, int parent)
+		{
+			MirrorNode node;
+			node.parent = parent;
+			node.position = RandomPosition();
+			node.rotation = RandomRotation();
+			node.scale = RandomScale();
+			node.alive = true;
+			node.handle = hierarchy.Create(parent < 0 ? TransformNode{} : nodes[parent].handle, node.position,
+										   node.rotation, node.scale);
+			nodes.push_back(node);
+			return static_cast<int>(nodes.size()) - 1;
+		};
+
+		int RandomAlive()
+		{
+			while (true)
+			{
+				const int i = static_cast<int>(_rng() % nodes.size());
+				if (nodes[i].alive) return i;
+			}
+		};
+
+		bool IsAncestor(int ancestor, int node) const
+		{
+			for (int i = node; i >= 0; i = nodes[i].parent)
+			{
+				if (i == ancestor) return true;
+			}
+			return false;
+		};
+
+		// Recursive reference, parent world times translate * rotate * scale
+		glm::mat4 World(int i) const
+		{
+			const MirrorNode& node = nodes[i];
+			const glm::mat4 local = glm::translate(glm::mat4(1.0f), node.position) * glm::mat4_cast(node.rotation) *
+									glm::scale(glm::mat4(1.0f), node.scale);
+			return node.parent < 0 ? local : World(node.parent) * local;
+		};
+
+		glm::vec3 RandomPosition()
+		{
+			return glm::vec3(Uniform(-5.0f, 5.0f), Uniform(-5.0f, 5.0f), Uniform(-5.0f, 5.0f));
+		};
+		glm::vec3 RandomScale() { return glm::vec3(Uniform(0.8f, 1.2f), Uniform(0.8f, 1.2f), Uniform(0.8f, 1.2f)); };
+		glm::quat RandomRotation()
+		{
+			return glm::normalize(glm::quat(Uniform(-1.0f, 1.0f), Uniform(-1.0f, 1.0f), Uniform(-1.0f, 1.0f),
+											Uniform(-1.0f, 1.0f)));
+		};
+		uint32_t Next() { return static_cast<uint32_t>(_rng()); };
+
+		std::vector<MirrorNode> nodes;
+
+	  private:
+		float Uniform(float min, float max) { return std::uniform_real_distribution<float>(min, max)(_rng); };
+
+		std::mt19937 _rng;
+	};
+
+	void checkAgainstReference(const TransformHierarchy& hierarchy, const Mirror& mirror)
+	{
+		size_t alive = 0;
+		for (size_t i = 0; i < mirror.nodes.size(); i++)
+		{
+			const MirrorNode& node = mirror.nodes[i];
+			CHECK(hierarchy.IsValid(node.handle) == node.alive);
+			if (!node.alive) continue;
+			alive++;
+
+			const TransformNode parent = node.parent < 0 ? TransformNode{} : mirror.nodes[node.parent].handle;
+			CHECK(hierarchy.GetParent(node.handle) == parent);
+			const glm::mat4 expected = mirror.World(static_cast<int>(i));
+			const glm::mat4& world = hierarchy.GetWorld(node.handle);
+			for (int c = 0; c < 4; c++)
+			{
+				for (int r = 0; r < 4; r++)
+				{
+					CHECK_NEAR(world[c][r], expected[c][r], 1e-3 * (1.0 + std::fabs(expected[c][r])));
+				}
+			}
+		}
+		CHECK(hierarchy.Size() == alive);
+	}
+} // namespace
+
+static void testMatchesReference(JobSystem* jobs, uint32_t seed)
+{
+	TransformHierarchy hierarchy;
+	Mirror mirror(seed);
+
+	// A few roots with random trees under them, ten levels deep at most
+	for (int i = 0; i < 3000; i++)
+	{
+		int parent = -1;
+		if (i >= 8)
+		{
+			parent = static_cast<int>(mirror.Next() % i);
+			int depth = 0;
+			for (int p = parent; p >= 0; p = mirror.nodes[p].parent) depth++;
+			if (depth >= 10) parent = -1;
+		}
+		mirror.Create(hierarchy, parent);
+	}
+	hierarchy.Update(jobs);
+	checkAgainstReference(hierarchy, mirror);
+
+	for (int round = 0; round < 40; round++)
+	{
+		const uint32_t changes = 1 + mirror.Next() % 200;
+		for (uint32_t c = 0; c < changes; c++)
+		{
+			const int i = mirror.RandomAlive();
+			MirrorNode& node = mirror.nodes[i];
+			switch (mirror.Next() % 8)
+			{
+			case 0:
+				node.position = mirror.RandomPosition();
+				hierarchy.SetPosition(node.handle, node.position);
+				break;
+			case 1:
+				node.rotation = mirror.RandomRotation();
+				hierarchy.SetRotation(node.handle, node.rotation);
+				break;
+			case 2:
+				node.scale = mirror.RandomScale();
+				hierarchy.SetScale(node.handle, node.scale);
+				break;
+			case 3:
+				node.position = mirror.RandomPosition();
+				node.rotation = mirror.RandomRotation();
+				hierarchy.SetLocal(node.handle, node.position, node.rotation, node.scale);
+				break;
+			case 4:
+			{
+				// Under any node outside its own subtree, or up to the roots
+				const int parent = mirror.Next() % 4 == 0 ? -1 : mirror.RandomAlive();
+				if (parent >= 0 && mirror.IsAncestor(i, parent)) break;
+				node.parent = parent;
+				hierarchy.SetParent(node.handle, parent < 0 ? TransformNode{} : mirror.nodes[parent].handle);
+				break;
+			}
+			case 5:
+				mirror.Create(hierarchy, i);
+				break;
+			case 6:
+			{
+				if (mirror.Next() % 4 != 0) break;
+				hierarchy.Destroy(node.handle);
+				for (size_t other = 0; other < mirror.nodes.size(); other++)
+				{
+					if (mirror.IsAncestor(i, static_cast<int>(other))) mirror.nodes[other].alive = false;
+				}
+				break;
+			}
+			default:
+				break;
+			}
+		}
+		hierarchy.Update(jobs);
+		checkAgainstReference(hierarchy, mirror);
+	}
+
+	// Nothing changed, nothing recomputed
+	hierarchy.Update(jobs);
+	CHECK(hierarchy.GetStats().updatedNodes == 0 && !hierarchy.GetStats().rebuilt);
+
+	// A leaf change costs that leaf only
+	std::vector<bool> hasChildren(mirror.nodes.size(), false);
+	for (const MirrorNode& node : mirror.nodes)
+	{
+		if (node.alive && node.parent >= 0) hasChildren[node.parent] = true;
+	}
+	for (size_t i = 0; i < mirror.nodes.size(); i++)
+	{
+		MirrorNode& node = mirror.nodes[i];
+		if (!node.alive || hasChildren[i]) continue;
+		node.position += glm::vec3(1.0f);
+		hierarchy.SetPosition(node.handle, node.position);
+		hierarchy.Update(jobs);
+		CHECK(hierarchy.GetStats().updatedNodes == 1);
+		break;
+	}
+	checkAgainstReference(hierarchy, mirror);
+}
+
+int main()
+{
+	testMatchesReference(nullptr, 1);
+	JobSystem jobs(3);
+	testMatchesReference(&jobs, 2);
+	return 0;
+}
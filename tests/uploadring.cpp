@@ -0,0 +1,235 @@
+// Upload staging: the ring hands out aligned space that never overlaps a batch still in flight, wrapping around
+// its end, and NullDevice uploads retire at the frame end after their flush or stall on a full ring
+
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include <rendering/device/nulldevice.h>
+#include <rendering/device/uploadring.h>
+
+#include "check.h"
+
+using namespace gefx;
+
+namespace
+{
+	struct Range
+	{
+		uint64_t offset;
+		uint64_t bytes;
+	};
+
+	struct LiveBatch
+	{
+		uint64_t value;
+		std::vector<Range> ranges;
+	};
+
+	bool overlaps(const Range& a, const Range& b)
+	{
+		return a.offset < b.offset + b.bytes && b.offset < a.offset + a.bytes;
+	}
+} // namespace
+
+static void testWrapAround()
+{
+	UploadRing ring(1024);
+	uint64_t offset;
+	CHECK(!ring.Allocate(0, 16, offset) && !ring.Allocate(1025, 16, offset));
+
+	CHECK(ring.Allocate(384, 16, offset) && offset == 0);
+	ring.Close(1);
+	CHECK(ring.Allocate(384, 16, offset) && offset == 384);
+	ring.Close(2);
+	CHECK(ring.GetOldestPending() == 1 && ring.GetUsed() == 768);
+
+	// The tail end can't hold it and the front is still in use
+	CHECK(!ring.Allocate(384, 16, offset));
+	ring.Release(1);
+	CHECK(ring.GetOldestPending() == 2 && ring.GetUsed() == 384);
+
+	// Now it wraps around, up to where batch 2 begins. The 256 bytes skipped at the end count as used until the
+	// batch is released
+	CHECK(!ring.Allocate(400, 16, offset));
+	CHECK(ring.Allocate(384, 16, offset) && offset == 0);
+	CHECK(ring.GetUsed() == 1024);
+	ring.Close(3);
+	CHECK(!ring.Allocate(16, 16, offset));
+
+	// Releasing batch 2 frees up to where batch 3 begins, but not past it
+	ring.Release(2);
+	CHECK(ring.GetUsed() == 640);
+	CHECK(ring.Allocate(16, 16, offset) && offset == 384);
+	CHECK(!ring.Allocate(384, 16, offset));
+	ring.Release(3);
+	CHECK(ring.GetUsed() == 16 && ring.GetOldestPending() == 0);
+
+	// Empty batches are released like the others
+	ring.Close(4);
+	ring.Close(5);
+	CHECK(ring.GetOldestPending() == 4);
+	ring.Release(5);
+	CHECK(ring.GetUsed() == 0 && ring.GetOldestPending() == 0);
+
+	// Alignment padding is part of the used space
+	CHECK(ring.Allocate(10, 16, offset) && offset == 0);
+	CHECK(ring.Allocate(10, 256, offset) && offset == 256);
+	CHECK(ring.GetUsed() == 266);
+}
+
+// Random sizes and batches retired a few values late, against a model of the ranges still in flight
+static void testNoOverlap()
+{
+	const uint64_t size = 64 << 10;
+	UploadRing ring(size);
+	std::mt19937 rng(7);
+	std::deque<LiveBatch> live;
+	LiveBatch open{1, {}};
+	uint64_t completed = 0;
+	uint32_t refused = 0;
+	uint32_t wrapped = 0;
+	uint64_t lastOffset = 0;
+	for (int i = 0; i < 20000; i++)
+	{
+		const uint64_t bytes = 1 + rng() % (size / 5);
+		const uint64_t alignment = uint64_t(1) << (rng() % 9);
+		uint64_t offset;
+		if (ring.Allocate(bytes, alignment, offset))
+		{
+			const Range range{offset, bytes};
+			CHECK(offset % alignment == 0 && offset + bytes <= size);
+			for (const LiveBatch& batch : live)
+			{
+				for (const Range& other : batch.ranges) CHECK(!overlaps(range, other));
+			}
+			for (const Range& other : open.ranges) CHECK(!overlaps(range, other));
+			wrapped += offset < lastOffset;
+			lastOffset = offset;
+			open.ranges.push_back(range);
+		}
+		else
+		{
+			// Refused only while something is in flight, the ring alone could hold any of these
+			CHECK(!live.empty() || !open.ranges.empty());
+			refused++;
+		}
+
+		if (rng() % 4 == 0)
+		{
+			ring.Close(open.value);
+			live.push_back(open);
+			open = LiveBatch{open.value + 1, {}};
+		}
+		if (rng() % 5 == 0 && completed + 1 < open.value)
+		{
+			completed += 1 + rng() % (open.value - completed - 1);
+			ring.Release(completed);
+			while (!live.empty() && live.front().value <= completed) live.pop_front();
+			CHECK(ring.GetOldestPending() == (live.empty() ? 0 : live.front().value));
+		}
+	}
+	CHECK(refused > 0 && wrapped > 100);
+}
+
+// Uploads complete at the EndFrame after the one that flushed them, and their space comes back then
+static void testTicketsRetire()
+{
+	NullDevice device(4096);
+	const BufferHandle buffer = device.CreateBuffer(BufferDesc{1024, BufferUsage::Vertex});
+	const std::vector<uint8_t> data(1024, 0x5A);
+
+	UploadTicket first;
+	CHECK(device.UploadBuffer(buffer, 0, data.data(), 512, first) && first.value == 1);
+	device.FlushUploads();
+	UploadTicket second;
+	CHECK(device.UploadBuffer(buffer, 512, data.data(), 512, second) && second.value == 2);
+	CHECK(!device.IsUploadComplete(first) && !device.IsUploadComplete(second));
+	CHECK(device.GetUploadRing().GetUsed() == 1024);
+
+	// The frame end completes what was flushed and flushes the rest
+	device.EndFrame();
+	CHECK(device.IsUploadComplete(first) && !device.IsUploadComplete(second));
+	CHECK(device.GetUploadRing().GetUsed() == 512 && device.GetUploadRing().GetOldestPending() == 2);
+	device.EndFrame();
+	CHECK(device.IsUploadComplete(second) && device.GetUploadRing().GetUsed() == 0);
+
+	// Nothing uploaded, nothing to flush
+	device.FlushUploads();
+	device.EndFrame();
+	UploadTicket third;
+	CHECK(device.UploadBuffer(buffer, 0, data.data(), 16, third) && third.value == 3);
+	CHECK(device.GetErrorCount() == 0);
+}
+
+// A frame's worth of uploads every frame walks around the ring without ever waiting
+static void testSteadyStreaming()
+{
+	NullDevice device(4096);
+	const BufferHandle buffer = device.CreateBuffer(BufferDesc{1000, BufferUsage::Vertex});
+	const std::vector<uint8_t> data(1000, 1);
+	UploadTicket previous;
+	for (int frame = 0; frame < 40; frame++)
+	{
+		UploadTicket ticket;
+		CHECK(device.UploadBuffer(buffer, 0, data.data(), 1000, ticket));
+		CHECK(ticket.value > previous.value);
+		device.EndFrame();
+		CHECK(device.IsUploadComplete(previous) && !device.IsUploadComplete(ticket));
+		CHECK(device.GetFrameStats().uploadStalls == 0 && device.GetFrameStats().uploadBytes == 1000);
+		previous = ticket;
+	}
+}
+
+// Uploads that don't fit next to the batches in flight wait for the oldest, which completes it early
+static void testFullRingStalls()
+{
+	NullDevice device(4096);
+	const BufferHandle buffer = device.CreateBuffer(BufferDesc{1 << 16, BufferUsage::Vertex});
+	const std::vector<uint8_t> data(1 << 16, 2);
+
+	// Four quarter ring uploads fill it exactly
+	UploadTicket tickets[5];
+	for (int i = 0; i < 4; i++)
+	{
+		CHECK(device.UploadBuffer(buffer, 1024 * i, data.data(), 1024, tickets[i]) && tickets[i].value == 1);
+	}
+	CHECK(device.GetUploadRing().GetUsed() == 4096 && !device.IsUploadComplete(tickets[0]));
+
+	// The fifth flushes the open batch and waits for it
+	CHECK(device.UploadBuffer(buffer, 4096, data.data(), 1024, tickets[4]) && tickets[4].value == 2);
+	CHECK(device.IsUploadComplete(tickets[3]) && !device.IsUploadComplete(tickets[4]));
+	CHECK(device.GetUploadRing().GetUsed() == 1024);
+
+	// Bigger than the ring: goes in 64 quarter ring parts, stalling each time the ring fills up again
+	UploadTicket big;
+	CHECK(device.UploadBuffer(buffer, 0, data.data(), data.size(), big));
+	CHECK(!device.IsUploadComplete(big));
+	device.EndFrame();
+	CHECK(!device.IsUploadComplete(big));
+	CHECK(device.GetFrameStats().uploadStalls == 1 + 16);
+	CHECK(device.GetFrameStats().uploadBytes == 5 * 1024 + data.size());
+	device.EndFrame();
+	CHECK(device.IsUploadComplete(big) && device.GetUploadRing().GetUsed() == 0);
+
+	// Textures go in whole rows, rows wider than a quarter ring are refused
+	const TextureHandle narrow = device.CreateTexture(TextureDesc{16, 80, 1, Format::RGBA8Unorm});
+	const TextureHandle wide = device.CreateTexture(TextureDesc{512, 4, 1, Format::RGBA8Unorm});
+	UploadTicket texture;
+	CHECK(device.UploadTexture(narrow, 0, data.data(), texture));
+	CHECK(device.GetErrorCount() == 0);
+	CHECK(!device.UploadTexture(wide, 0, data.data(), texture) && device.GetErrorCount() == 1);
+	device.EndFrame();
+	CHECK(device.GetFrameStats().uploadStalls == 1 && device.GetFrameStats().uploadBytes == 16 * 80 * 4);
+}
+
+int main()
+{
+	testWrapAround();
+	testNoOverlap();
+	testTicketsRetire();
+	testSteadyStreaming();
+	testFullRingStalls();
+	return 0;
+}
@@ -0,0 +1,199 @@
+// Vulkan device without a window: clear and draw into offscreen textures and read them back, recorded on the
+// calling thread and on the job system. Skipped (exit code 77) when no Vulkan 1.3 driver is installed
+
+#include <cstdio>
+#include <vector>
+
+#include <core/jobs.h>
+#include <rendering/device/commandlist.h>
+#include <rendering/device/vkdevice.h>
+
+#include "check.h"
+
+using namespace gefx;
+
+namespace
+{
+	constexpr uint32_t Size = 64;
+
+	// layout(location = 0) in vec2 position;
+	// void main() { gl_Position = vec4(position, 0.0, 1.0); }
+	const uint32_t VertexSpirv[] = {
+		0x07230203, 0x00010000, 0x00000000, 0x00000015, 0x00000000, 0x00020011, 0x00000001, 0x0003000e,
+		0x00000000, 0x00000001, 0x0007000f, 0x00000000, 0x00000010, 0x6e69616d, 0x00000000, 0x00000007,
+		0x0000000a, 0x00040047, 0x00000007, 0x0000001e, 0x00000000, 0x00050048, 0x00000008, 0x00000000,
+		0x0000000b, 0x00000000, 0x00030047, 0x00000008, 0x00000002, 0x00020013, 0x00000001, 0x00030021,
+		0x00000002, 0x00000001, 0x00030016, 0x00000003, 0x00000020, 0x00040017, 0x00000004, 0x00000003,
+		0x00000002, 0x00040017, 0x00000005, 0x00000003, 0x00000004, 0x00040015, 0x0000000e, 0x00000020,
+		0x00000001, 0x00040020, 0x00000006, 0x00000001, 0x00000004, 0x0004003b, 0x00000006, 0x00000007,
+		0x00000001, 0x0003001e, 0x00000008, 0x00000005, 0x00040020, 0x00000009, 0x00000003, 0x00000008,
+		0x0004003b, 0x00000009, 0x0000000a, 0x00000003, 0x00040020, 0x0000000b, 0x00000003, 0x00000005,
+		0x0004002b, 0x00000003, 0x0000000c, 0x00000000, 0x0004002b, 0x00000003, 0x0000000d, 0x3f800000,
+		0x0004002b, 0x0000000e, 0x0000000f, 0x00000000, 0x00050036, 0x00000001, 0x00000010, 0x00000000,
+		0x00000002, 0x000200f8, 0x00000011, 0x0004003d, 0x00000004, 0x00000012, 0x00000007, 0x00060050,
+		0x00000005, 0x00000013, 0x00000012, 0x0000000c, 0x0000000d, 0x00050041, 0x0000000b, 0x00000014,
+		0x0000000a, 0x0000000f, 0x0003003e, 0x00000014, 0x00000013, 0x000100fd, 0x00010038,
+	};
+
+	// layout(push_constant) uniform Constants { vec4 color; };
+	// layout(location = 0) out vec4 outColor;
+	// void main() { outColor = color; }
+	const uint32_t FragmentSpirv[] = {
+		0x07230203, 0x00010000, 0x00000000, 0x00000011, 0x00000000, 0x00020011, 0x00000001, 0x0003000e,
+		0x00000000, 0x00000001, 0x0006000f, 0x00000004, 0x0000000d, 0x6e69616d, 0x00000000, 0x00000009,
+		0x00030010, 0x0000000d, 0x00000007, 0x00050048, 0x00000005, 0x00000000, 0x00000023, 0x00000000,
+		0x00030047, 0x00000005, 0x00000002, 0x00040047, 0x00000009, 0x0000001e, 0x00000000, 0x00020013,
+		0x00000001, 0x00030021, 0x00000002, 0x00000001, 0x00030016, 0x00000003, 0x00000020, 0x00040017,
+		0x00000004, 0x00000003, 0x00000004, 0x00040015, 0x0000000b, 0x00000020, 0x00000001, 0x0003001e,
+		0x00000005, 0x00000004, 0x00040020, 0x00000006, 0x00000009, 0x00000005, 0x0004003b, 0x00000006,
+		0x00000007, 0x00000009, 0x00040020, 0x00000008, 0x00000003, 0x00000004, 0x0004003b, 0x00000008,
+		0x00000009, 0x00000003, 0x00040020, 0x0000000a, 0x00000009, 0x00000004, 0x0004002b, 0x0000000b,
+		0x0000000c, 0x00000000, 0x00050036, 0x00000001, 0x0000000d, 0x00000000, 0x00000002, 0x000200f8,
+		0x0000000e, 0x00050041, 0x0000000a, 0x0000000f, 0x00000007, 0x0000000c, 0x0004003d, 0x00000004,
+		0x00000010, 0x0000000f, 0x0003003e, 0x00000009, 0x00000010, 0x000100fd, 0x00010038,
+	};
+
+	// Two quads in NDC: the left half, then the top half (Vulkan's y points down)
+	const float Quads[] = {
+		-1.0f, -1.0f, 0.0f, -1.0f, 0.0f, 1.0f, -1.0f, -1.0f, 0.0f, 1.0f, -1.0f, 1.0f,
+		-1.0f, -1.0f, 1.0f, -1.0f, 1.0f, 0.0f, -1.0f, -1.0f, 1.0f, 0.0f, -1.0f, 0.0f,
+	};
+
+	const glm::vec4 ClearColor(0.0f, 0.0f, 1.0f, 1.0f);
+	const glm::vec4 LeftColor(1.0f, 0.0f, 0.0f, 1.0f);
+	const glm::vec4 TopColor(0.0f, 1.0f, 0.0f, 1.0f);
+
+	PipelineHandle createPipeline(IDevice& device, BlendMode blend = BlendMode::None)
+	{
+		PipelineDesc desc;
+		desc.blend = blend;
+		desc.vertexSpirv = VertexSpirv;
+		desc.fragmentSpirv = FragmentSpirv;
+		desc.attributes[0] = VertexAttribute{0, Format::RG32Float, 0};
+		desc.attributeCount = 1;
+		desc.vertexStride = 2 * sizeof(float);
+		desc.pushConstantBytes = sizeof(glm::vec4);
+		return device.CreatePipeline(desc);
+	}
+
+	void record(CommandList& list, TextureHandle target, PipelineHandle pipeline, BufferHandle quads)
+	{
+		RenderPassDesc pass;
+		pass.color = target;
+		pass.width = Size;
+		pass.height = Size;
+		pass.clearColor = true;
+		pass.clearColorValue = ClearColor;
+		list.BeginRenderPass(pass);
+		list.BindPipeline(pipeline);
+		list.BindVertexBuffer(quads);
+		list.PushConstants(LeftColor);
+		list.Draw(6);
+		list.PushConstants(TopColor);
+		list.Draw(6, 1, 6);
+		list.EndRenderPass();
+	}
+
+	// Red added over the whole image
+	void recordAdditive(CommandList& list, TextureHandle target, PipelineHandle pipeline, BufferHandle quads)
+	{
+		RenderPassDesc pass;
+		pass.color = target;
+		pass.width = Size;
+		pass.height = Size;
+		list.BeginRenderPass(pass);
+		list.BindPipeline(pipeline);
+		list.BindVertexBuffer(quads);
+		list.PushConstants(LeftColor);
+		list.Draw(6);
+		list.EndRenderPass();
+	}
+
+	// Rows from the top: the top half is the second quad, the bottom left the first, the rest the clear color.
+	// added is what an additive pass drew over the left half since
+	void checkImage(VulkanDevice& device, TextureHandle target, const glm::vec4& added = glm::vec4(0.0f))
+	{
+		std::vector<uint8_t> pixels;
+		CHECK(device.ReadTexture(target, pixels) && pixels.size() == Size * Size * 4);
+		for (uint32_t y = 0; y < Size; y++)
+		{
+			for (uint32_t x = 0; x < Size; x++)
+			{
+				glm::vec4 color = y < Size / 2 ? TopColor : x < Size / 2 ? LeftColor : ClearColor;
+				if (x < Size / 2) color = glm::min(color + added, glm::vec4(1.0f));
+				const uint8_t* pixel = &pixels[(y * Size + x) * 4];
+				for (int c = 0; c < 4; c++)
+				{
+					CHECK(pixel[c] == static_cast<uint8_t>(color[c] * 255.0f));
+				}
+			}
+		}
+	}
+} // namespace
+
+static bool testOffscreen(JobSystem* jobs)
+{
+	VulkanDevice device;
+	VulkanDeviceConfig config;
+	config.jobs = jobs;
+	config.backBufferWidth = Size;
+	config.backBufferHeight = Size;
+	if (!device.Initialize(config)) return false;
+
+	const TextureHandle target = device.CreateTexture(TextureDesc{Size, Size, 1, Format::RGBA8Unorm,
+																  TextureUsage::RenderTarget});
+	const PipelineHandle pipeline = createPipeline(device);
+	const BufferHandle quads = device.CreateBuffer(BufferDesc{sizeof(Quads), BufferUsage::Vertex}, Quads);
+	CHECK(target && pipeline && quads);
+
+	// Several frames, so the frame slots and their pools are reused
+	for (int frame = 0; frame < 4; frame++)
+	{
+		CommandList list;
+		record(list, target, pipeline, quads);
+		device.Submit(list);
+		checkImage(device, target);
+		device.EndFrame();
+	}
+
+	// Equal descriptions share a pipeline, the blend mode tells them apart
+	const PipelineHandle same = createPipeline(device);
+	CHECK(same == pipeline);
+	device.Destroy(same);
+	const PipelineHandle additive = createPipeline(device, BlendMode::Additive);
+	CHECK(additive && additive != pipeline);
+	{
+		CommandList list;
+		recordAdditive(list, target, additive, quads);
+		device.Submit(list);
+		checkImage(device, target, LeftColor);
+		device.EndFrame();
+	}
+	device.Destroy(additive);
+
+	// Without a surface, back buffer passes render to an offscreen texture that reads back the same way
+	CommandList list;
+	record(list, TextureHandle{}, pipeline, quads);
+	device.Submit(list);
+	CHECK(device.GetBackBuffer());
+	checkImage(device, device.GetBackBuffer());
+	device.EndFrame();
+
+	device.Destroy(quads);
+	device.Destroy(pipeline);
+	device.Destroy(target);
+	device.Shutdown();
+	return true;
+}
+
+int main()
+{
+	if (!testOffscreen(nullptr))
+	{
+		std::printf("No Vulkan 1.3 device, skipped\n");
+		return 77;
+	}
+	JobSystem jobs(2);
+	CHECK(testOffscreen(&jobs));
+	return 0;
+}
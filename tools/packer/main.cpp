@@ -0,0 +1,58 @@
+// Pack archive builder
+// Usage: grefixsPack <output.gpak> <input dir> [<input dir> ...]
+// Every file under each input dir is stored under "<dir name>/<relative path>", so packing "shaders"
+// yields "shaders/vert_col.vs", matching the virtual paths used by the engine.
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+#include <core/jobs.h>
+#include <core/pack.h>
+
+namespace fs = std::filesystem;
+
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		fprintf(stderr, "Usage: %s <output.gpak> <input dir> [<input dir> ...]\n", argv[0]);
+		return 1;
+	}
+
+	gefx::PackBuilder builder;
+	for (int i = 2; i < argc; i++)
+	{
+		const fs::path root = fs::path(argv[i]).lexically_normal();
+		std::error_code ec;
+		if (!fs::is_directory(root, ec))
+		{
+			fprintf(stderr, "'%s' is not a directory\n", argv[i]);
+			return 1;
+		}
+
+		const fs::path mountName = root.has_filename() ? root.filename() : root.parent_path().filename();
+		for (const fs::directory_entry& entry : fs::recursive_directory_iterator(root))
+		{
+			if (!entry.is_regular_file()) continue;
+
+			const std::string virtualPath = (mountName / fs::relative(entry.path(), root)).generic_string();
+			if (!builder.AddFile(virtualPath, entry.path().string()))
+			{
+				fprintf(stderr, "Failed to read '%s'\n", entry.path().string().c_str());
+				return 1;
+			}
+		}
+	}
+
+	gefx::JobSystem jobs;
+	std::string error;
+	if (!builder.Write(argv[1], &jobs, error))
+	{
+		fprintf(stderr, "Failed to write pack: %s\n", error.c_str());
+		return 1;
+	}
+
+	printf("Packed %zu files into '%s'\n", builder.GetFileCount(), argv[1]);
+	return 0;
+}
@@ -0,0 +1,151 @@
+// Software reference renderer
+// Usage: grefixsSoftRender <output.ppm> [width] [height] [frames]
+// Renders the engine's noise grid scene, same cells, camera and shading as the GL path, with the software
+// rasterizer. Every frame advances time by 1/60s like a 60Hz run of the app; the last one is written as a binary
+// PPM and the average timings are printed as a throughput benchmark.
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <PerlinNoise.hpp>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <core/jobs.h>
+#include <rendering/softrasterizer.h>
+
+namespace
+{
+	// Mirrors shaders/vert_col.vs and shaders/vert_col.fs
+	struct GridUniforms
+	{
+		glm::mat4 mvp;
+		float perlin;
+	};
+
+	glm::vec4 gridVertex(const void* uniforms, const void* vertex, float*)
+	{
+		return static_cast<const GridUniforms*>(uniforms)->mvp *
+			   glm::vec4(*static_cast<const glm::vec3*>(vertex), 1.0f);
+	}
+
+	glm::vec4 gridFragment(const void* uniforms, const float*)
+	{
+		const float perlin = static_cast<const GridUniforms*>(uniforms)->perlin;
+		return glm::vec4(glm::vec3(1.0f, 0.7f, 0.5f) * glm::clamp(perlin, 0.0f, 1.0f) * 0.8f + 0.2f, 1.0f);
+	}
+
+	bool writePPM(const char* path, const std::vector<uint32_t>& pixels, uint32_t width, uint32_t height)
+	{
+		FILE* file = fopen(path, "wb");
+		if (!file) return false;
+
+		fprintf(file, "P6\n%u %u\n255\n", width, height);
+		std::vector<uint8_t> row(size_t(width) * 3);
+		// Pixels start from the bottom row, PPM from the top one
+		for (uint32_t y = height; y-- > 0;)
+		{
+			for (uint32_t x = 0; x < width; x++)
+			{
+				const uint32_t pixel = pixels[size_t(y) * width + x];
+				row[x * 3 + 0] = static_cast<uint8_t>(pixel);
+				row[x * 3 + 1] = static_cast<uint8_t>(pixel >> 8);
+				row[x * 3 + 2] = static_cast<uint8_t>(pixel >> 16);
+			}
+			fwrite(row.data(), 1, row.size(), file);
+		}
+		return fclose(file) == 0;
+	}
+} // namespace
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		fprintf(stderr, "Usage: %s <output.ppm> [width] [height] [frames]\n", argv[0]);
+		return 1;
+	}
+	const uint32_t width = argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 1920;
+	const uint32_t height = argc > 3 ? static_cast<uint32_t>(atoi(argv[3])) : 1080;
+	const uint32_t frames = argc > 4 ? static_cast<uint32_t>(atoi(argv[4])) : 60;
+	if (width == 0 || height == 0 || width > 16384 || height > 16384 || frames == 0)
+	{
+		fprintf(stderr, "Invalid resolution or frame count\n");
+		return 1;
+	}
+
+	// Same unit quad, camera and noise as the app
+	const glm::vec3 quad[] = {
+		{-0.5f, -0.5f, 0.0f}, {+0.5f, -0.5f, 0.0f}, {-0.5f, +0.5f, 0.0f},
+		{-0.5f, +0.5f, 0.0f}, {+0.5f, -0.5f, 0.0f}, {+0.5f, +0.5f, 0.0f},
+	};
+	const glm::mat4 view = glm::lookAt(glm::vec3{0.0f, 0.0f, 5.0f}, glm::vec3{}, glm::vec3{0.0f, 1.0f, 0.0f});
+	const glm::mat4 proj = glm::perspective(60.0f, 4 / 3.0f, 0.01f, 1000.0f);
+	const glm::mat4 viewProj = proj * view;
+	const siv::PerlinNoise perlin{123456u};
+	constexpr int gridMin = -50;
+	constexpr int gridMax = 50;
+
+	gefx::SoftwarePipeline pipeline;
+	pipeline.vertex = gridVertex;
+	pipeline.fragment = gridFragment;
+	// The app draws without depth test or culling, the cells never overlap anyway
+	pipeline.cullMode = gefx::CullMode::None;
+	pipeline.depthTest = false;
+
+	gefx::JobSystem jobs;
+	gefx::SoftwareRasterizer rasterizer(width, height);
+	gefx::SoftwareRasterStats total;
+	double frameMs = 0.0;
+	float time = 0.0f;
+	for (uint32_t frame = 0; frame < frames; frame++)
+	{
+		time += 1.0f / 60.0f;
+		const glm::vec2 noiseOffset{cos(time), sin(time)};
+
+		rasterizer.Clear(glm::vec4(0.0f, 0.0f, 0.4f, 1.0f));
+		for (int x = gridMin; x < gridMax; x++)
+		{
+			for (int y = gridMin; y < gridMax; y++)
+			{
+				GridUniforms uniforms;
+				uniforms.perlin = (float)perlin.octave2D(x + noiseOffset.x, y + noiseOffset.y, 2);
+				const glm::quat rotation(cosf(uniforms.perlin * 0.5f), 0.0f, 0.0f, sinf(uniforms.perlin * 0.5f));
+				uniforms.mvp = viewProj * glm::translate(glm::mat4(1.0f), glm::vec3(x, y, 0.0f)) *
+							   glm::mat4_cast(rotation) * glm::scale(glm::mat4(1.0f), glm::vec3(0.5f));
+				rasterizer.Draw(pipeline, &uniforms, sizeof(uniforms), quad, sizeof(glm::vec3), 6);
+			}
+		}
+		rasterizer.Flush(&jobs);
+
+		const gefx::SoftwareRasterStats& stats = rasterizer.GetStats();
+		frameMs += stats.vertexMs + stats.setupMs + stats.rasterMs;
+		total.vertexMs += stats.vertexMs;
+		total.setupMs += stats.setupMs;
+		total.rasterMs += stats.rasterMs;
+		total.triangles += stats.triangles;
+		total.fragments += stats.fragments;
+	}
+
+	const gefx::SoftwareRasterStats& last = rasterizer.GetStats();
+	printf("%ux%u, %u frames on %u workers\n", width, height, frames, jobs.GetWorkerCount());
+	printf("Last frame: %u draws, %u triangles, %u rasterized, %u tile bin entries, %llu fragments\n", last.draws,
+		   last.triangles, last.rasterizedTriangles, last.binnedTriangles, (unsigned long long)last.fragments);
+	printf("Average frame: %.3fms (vertex %.3fms, setup %.3fms, raster %.3fms)\n", frameMs / frames,
+		   total.vertexMs / frames, total.setupMs / frames, total.rasterMs / frames);
+	printf("Throughput: %.2fM triangles/s, %.2fM fragments/s\n", total.triangles / (frameMs * 1e3),
+		   total.fragments / (frameMs * 1e3));
+
+	std::vector<uint32_t> pixels;
+	rasterizer.ResolveColor(pixels);
+	if (!writePPM(argv[1], pixels, width, height))
+	{
+		fprintf(stderr, "Failed to write '%s'\n", argv[1]);
+		return 1;
+	}
+	printf("Wrote '%s'\n", argv[1]);
+	return 0;
+}